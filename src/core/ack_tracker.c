@@ -47,9 +47,17 @@ QuicAckTrackerInitialize(
 {
     QUIC_STATUS Status;
 
+    Tracker->ReceivedECT0Count = 0;
+    Tracker->ReceivedECT1Count = 0;
+    Tracker->ReceivedCECount = 0;
     Tracker->AckElicitingPacketsToAcknowledge = 0;
     Tracker->LargestPacketNumberAcknowledged = 0;
     Tracker->LargestPacketNumberRecvTime = 0;
+    Tracker->BatchStartAckElicitingCount = 0;
+    Tracker->Batching = FALSE;
+    Tracker->BatchNewLargestPacketNumber = FALSE;
+    QuicZeroMemory(Tracker->DuplicateBitmap, sizeof(Tracker->DuplicateBitmap));
+    Tracker->DuplicateBitmapLargest = 0;
 
     Status =
         QuicRangeInitialize(
@@ -89,13 +97,46 @@ QuicAckTrackerReset(
     _Inout_ QUIC_ACK_TRACKER* Tracker
     )
 {
+    Tracker->ReceivedECT0Count = 0;
+    Tracker->ReceivedECT1Count = 0;
+    Tracker->ReceivedCECount = 0;
     Tracker->AckElicitingPacketsToAcknowledge = 0;
     Tracker->LargestPacketNumberAcknowledged = 0;
     Tracker->LargestPacketNumberRecvTime = 0;
+    Tracker->BatchStartAckElicitingCount = 0;
+    Tracker->Batching = FALSE;
+    Tracker->BatchNewLargestPacketNumber = FALSE;
+    QuicZeroMemory(Tracker->DuplicateBitmap, sizeof(Tracker->DuplicateBitmap));
+    Tracker->DuplicateBitmapLargest = 0;
     QuicRangeReset(&Tracker->PacketNumbersToAck);
     QuicRangeReset(&Tracker->PacketNumbersReceived);
 }
 
+//
+// Moves a run of packet numbers evicted from the duplicate bitmap into the
+// fallback range so receive history survives the window sliding past it.
+// Consecutive evictions coalesce into the range's existing subranges, so
+// under in-order delivery this stays one contiguous subrange. An allocation
+// failure just loses the entries, matching the range's own memory-limited
+// behavior for old packets.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+static
+void
+QuicAckTrackerFlushEvicted(
+    _Inout_ QUIC_ACK_TRACKER* Tracker,
+    _In_ uint64_t LowestPacketNumber,
+    _In_ uint64_t Count
+    )
+{
+    BOOLEAN RangeUpdated;
+    (void)QuicRangeAddRange(
+        &Tracker->PacketNumbersReceived,
+        LowestPacketNumber,
+        Count,
+        &RangeUpdated);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicAckTrackerAddPacketNumber(
@@ -103,6 +144,91 @@ QuicAckTrackerAddPacketNumber(
     _In_ uint64_t PacketNumber
     )
 {
+    const uint64_t Window = QUIC_DUPLICATE_PACKET_BITMAP_SIZE;
+
+    if (PacketNumber > Tracker->DuplicateBitmapLargest) {
+        //
+        // New largest packet number. Slide the window forward by clearing the
+        // slots of the packet numbers it newly covers, flushing the entries
+        // those slots used to hold into the fallback range so duplicate
+        // detection keeps full-connection history.
+        //
+        uint64_t EvictLow = 0;
+        uint64_t EvictCount = 0;
+        if (PacketNumber - Tracker->DuplicateBitmapLargest >= Window) {
+            //
+            // The whole window is skipped over; flush every recorded entry.
+            //
+            const uint64_t Largest = Tracker->DuplicateBitmapLargest;
+            const uint64_t Lowest = Largest >= Window ? Largest - Window + 1 : 0;
+            for (uint64_t i = Lowest; i <= Largest; i++) {
+                if (Tracker->DuplicateBitmap[(i & (Window - 1)) >> 6] &
+                    (1ull << (i & 63))) {
+                    if (EvictCount != 0 && EvictLow + EvictCount == i) {
+                        EvictCount++;
+                    } else {
+                        if (EvictCount != 0) {
+                            QuicAckTrackerFlushEvicted(
+                                Tracker, EvictLow, EvictCount);
+                        }
+                        EvictLow = i;
+                        EvictCount = 1;
+                    }
+                }
+            }
+            QuicZeroMemory(
+                Tracker->DuplicateBitmap, sizeof(Tracker->DuplicateBitmap));
+        } else {
+            for (uint64_t i = Tracker->DuplicateBitmapLargest + 1;
+                 i <= PacketNumber;
+                 i++) {
+                uint64_t* Slot =
+                    &Tracker->DuplicateBitmap[(i & (Window - 1)) >> 6];
+                const uint64_t Bit = 1ull << (i & 63);
+                if ((*Slot & Bit) && i >= Window) {
+                    const uint64_t Evicted = i - Window;
+                    if (EvictCount != 0 && EvictLow + EvictCount == Evicted) {
+                        EvictCount++;
+                    } else {
+                        if (EvictCount != 0) {
+                            QuicAckTrackerFlushEvicted(
+                                Tracker, EvictLow, EvictCount);
+                        }
+                        EvictLow = Evicted;
+                        EvictCount = 1;
+                    }
+                }
+                *Slot &= ~Bit;
+            }
+        }
+        if (EvictCount != 0) {
+            QuicAckTrackerFlushEvicted(Tracker, EvictLow, EvictCount);
+        }
+        Tracker->DuplicateBitmap[(PacketNumber & (Window - 1)) >> 6] |=
+            1ull << (PacketNumber & 63);
+        Tracker->DuplicateBitmapLargest = PacketNumber;
+        return FALSE;
+    }
+
+    if (Tracker->DuplicateBitmapLargest - PacketNumber < Window) {
+        //
+        // Within the window, duplicate detection is a single bit test and set.
+        //
+        uint64_t* Slot =
+            &Tracker->DuplicateBitmap[(PacketNumber & (Window - 1)) >> 6];
+        const uint64_t Bit = 1ull << (PacketNumber & 63);
+        if (*Slot & Bit) {
+            return TRUE;
+        }
+        *Slot |= Bit;
+        return FALSE;
+    }
+
+    //
+    // Straggler older than the bitmap window. Fall back to the range, which
+    // keeps detection for these best effort, just as the range's own memory
+    // limit already made it for old packets.
+    //
     BOOLEAN RangeUpdated;
     return
         QuicRangeAddRange(&Tracker->PacketNumbersReceived, PacketNumber, 1, &RangeUpdated) == NULL ||
@@ -114,6 +240,7 @@ void
 QuicAckTrackerAckPacket(
     _Inout_ QUIC_ACK_TRACKER* Tracker,
     _In_ uint64_t PacketNumber,
+    _In_ QUIC_ECN_TYPE EcnType,
     _In_ BOOLEAN AckElicitingPayload
     )
 {
@@ -122,6 +249,20 @@ QuicAckTrackerAckPacket(
 
     QUIC_DBG_ASSERT(PacketNumber <= QUIC_VAR_INT_MAX);
 
+    switch (EcnType) {
+    case QUIC_ECN_ECT_0:
+        Tracker->ReceivedECT0Count++;
+        break;
+    case QUIC_ECN_ECT_1:
+        Tracker->ReceivedECT1Count++;
+        break;
+    case QUIC_ECN_CE:
+        Tracker->ReceivedCECount++;
+        break;
+    default:
+        break;
+    }
+
     uint64_t CurLargestPacketNumber;
     if (QuicRangeGetMaxSafe(&Tracker->PacketNumbersToAck, &CurLargestPacketNumber) &&
         CurLargestPacketNumber + 1 != PacketNumber) {
@@ -148,6 +289,20 @@ QuicAckTrackerAckPacket(
 
     BOOLEAN NewLargestPacketNumber =
         PacketNumber == QuicRangeGetMax(&Tracker->PacketNumbersToAck);
+
+    if (Tracker->Batching) {
+        //
+        // A batch of received packets is being processed. Just record what
+        // happened; the timestamping and ACK scheduling decisions are made
+        // once for the whole batch in QuicAckTrackerBatchEnd.
+        //
+        Tracker->BatchNewLargestPacketNumber |= NewLargestPacketNumber;
+        if (AckElicitingPayload) {
+            Tracker->AckElicitingPacketsToAcknowledge++;
+        }
+        return;
+    }
+
     if (NewLargestPacketNumber) {
         Tracker->LargestPacketNumberRecvTime = QuicTimeUs64();
     }
@@ -165,7 +320,10 @@ QuicAckTrackerAckPacket(
     //
     // There are several conditions where we decide to send an ACK immediately:
     //
-    //   1. We have received QUIC_MIN_ACK_SEND_NUMBER ACK eliciting packets.
+    //   1. We have received the connection's packet tolerance worth of ACK
+    //      eliciting packets. The tolerance defaults to
+    //      QUIC_MIN_ACK_SEND_NUMBER and may be raised by the peer via an
+    //      ACK_FREQUENCY frame.
     //   2. We received an ACK eliciting packet that doesn't directly follow the
     //      previously received packet number. So we assume there might have
     //      been loss and should indicate this info to the peer.
@@ -175,7 +333,7 @@ QuicAckTrackerAckPacket(
     // packet received, we make sure the ACK delay timer is started.
     //
 
-    if (Tracker->AckElicitingPacketsToAcknowledge >= QUIC_MIN_ACK_SEND_NUMBER ||
+    if (Tracker->AckElicitingPacketsToAcknowledge >= Connection->PacketTolerance ||
         (NewLargestPacketNumber &&
          QuicRangeSize(&Tracker->PacketNumbersToAck) > 1 && // There are more than two ranges, i.e. a gap somewhere.
             QuicRangeGet(
@@ -202,6 +360,69 @@ Exit:
     QuicSendValidate(&Connection->Send);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicAckTrackerBatchBegin(
+    _Inout_ QUIC_ACK_TRACKER* Tracker
+    )
+{
+    QUIC_DBG_ASSERT(!Tracker->Batching);
+    Tracker->Batching = TRUE;
+    Tracker->BatchNewLargestPacketNumber = FALSE;
+    Tracker->BatchStartAckElicitingCount =
+        Tracker->AckElicitingPacketsToAcknowledge;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicAckTrackerBatchEnd(
+    _Inout_ QUIC_ACK_TRACKER* Tracker
+    )
+{
+    QUIC_CONNECTION* Connection = QuicAckTrackerGetPacketSpace(Tracker)->Connection;
+    _Analysis_assume_(Connection != NULL);
+
+    QUIC_DBG_ASSERT(Tracker->Batching);
+    Tracker->Batching = FALSE;
+
+    if (Tracker->BatchNewLargestPacketNumber) {
+        Tracker->LargestPacketNumberRecvTime = QuicTimeUs64();
+    }
+
+    if (Tracker->AckElicitingPacketsToAcknowledge ==
+            Tracker->BatchStartAckElicitingCount ||
+        (Connection->Send.SendFlags & QUIC_CONN_SEND_FLAG_ACK)) {
+        goto Exit; // No new ACK eliciting packets, or already queued.
+    }
+
+    //
+    // These are the same conditions the non-batched path evaluates per
+    // packet, evaluated once against the final state of the batch. The gap
+    // condition only sees the end of the batch, but a gap earlier in a large
+    // batch implies the packet tolerance worth of ACK eliciting packets are
+    // pending, which triggers an immediate ACK via the first condition.
+    //
+    if (Tracker->AckElicitingPacketsToAcknowledge >= Connection->PacketTolerance ||
+        (Tracker->BatchNewLargestPacketNumber &&
+         QuicRangeSize(&Tracker->PacketNumbersToAck) > 1 && // There are more than two ranges, i.e. a gap somewhere.
+            QuicRangeGet(
+            &Tracker->PacketNumbersToAck,
+         QuicRangeSize(&Tracker->PacketNumbersToAck) - 1)->Count == 1)) { // The gap is right before the last packet number.
+        QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_ACK);
+
+    } else if (Tracker->BatchStartAckElicitingCount == 0) {
+        //
+        // The batch added the first pending ACK eliciting payload, so make
+        // sure the delayed ACK timer is running.
+        //
+        QuicSendStartDelayedAckTimer(&Connection->Send);
+    }
+
+Exit:
+
+    QuicSendValidate(&Connection->Send);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicAckTrackerAckFrameEncode(
@@ -216,10 +437,26 @@ QuicAckTrackerAckFrameEncode(
 
     AckDelay >>= Builder->Connection->AckDelayExponent;
 
+    //
+    // Report the ECN counts to the peer if any marked packets have been
+    // received. The counts only ever grow, so once reported they are always
+    // reported.
+    //
+    QUIC_ACK_ECN_EX Ecn;
+    BOOLEAN SendEcn =
+        Tracker->ReceivedECT0Count != 0 ||
+        Tracker->ReceivedECT1Count != 0 ||
+        Tracker->ReceivedCECount != 0;
+    if (SendEcn) {
+        Ecn.ECT_0_Count = Tracker->ReceivedECT0Count;
+        Ecn.ECT_1_Count = Tracker->ReceivedECT1Count;
+        Ecn.CE_Count = Tracker->ReceivedCECount;
+    }
+
     if (!QuicAckFrameEncode(
             &Tracker->PacketNumbersToAck,
             AckDelay,
-            NULL, // No ECN right now.
+            SendEcn ? &Ecn : NULL,
             &Builder->DatagramLength,
             (uint16_t)Builder->Datagram->Length - Builder->EncryptionOverhead,
             Builder->Datagram->Buffer)) {
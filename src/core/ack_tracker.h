@@ -8,12 +8,23 @@
 typedef struct QUIC_ACK_TRACKER {
 
     //
-    // Range of packet numbers we have received. Used for duplicate packet
-    // detection. The range's growth is limited to QUIC_MAX_RANGE_DUPLICATE_PACKETS
+    // Range of packet numbers we have received, used for duplicate packet
+    // detection of stragglers older than the bitmap window below. The range's
+    // growth is limited to QUIC_MAX_RANGE_DUPLICATE_PACKETS
     // bytes. When this limit is hit, older packets are silently dropped.
     //
     QUIC_RANGE PacketNumbersReceived;
 
+    //
+    // Bitmap over the QUIC_DUPLICATE_PACKET_BITMAP_SIZE most recent packet
+    // numbers, indexed by packet number modulo the window size, so duplicate
+    // detection in the common case is a single bit test instead of a range
+    // search. The window covers packet numbers in
+    // (DuplicateBitmapLargest - window, DuplicateBitmapLargest].
+    //
+    uint64_t DuplicateBitmap[QUIC_DUPLICATE_PACKET_BITMAP_SIZE / 64];
+    uint64_t DuplicateBitmapLargest;
+
     //
     // Range of packet numbers we have received and should ACK. The range's
     // growth is limited to QUIC_MAX_RANGE_ACK_PACKETS bytes. When this limit is
@@ -31,11 +42,38 @@ typedef struct QUIC_ACK_TRACKER {
     //
     uint64_t LargestPacketNumberRecvTime;
 
+    //
+    // Running totals of received packets carrying each ECN codepoint, for
+    // reporting back to the peer in the ECN section of ACK frames.
+    //
+    uint64_t ReceivedECT0Count;
+    uint64_t ReceivedECT1Count;
+    uint64_t ReceivedCECount;
+
     //
     // The number of ACK eliciting packets that need to be acknowledged.
     //
     uint16_t AckElicitingPacketsToAcknowledge;
 
+    //
+    // The value of AckElicitingPacketsToAcknowledge when the current batch
+    // was started.
+    //
+    uint16_t BatchStartAckElicitingCount;
+
+    //
+    // TRUE while a batch of received packets is being processed. The
+    // per-packet ACK scheduling decisions are deferred until
+    // QuicAckTrackerBatchEnd, so the whole batch pays for them once.
+    //
+    BOOLEAN Batching;
+
+    //
+    // TRUE if a packet in the current batch became the new largest tracked
+    // packet number.
+    //
+    BOOLEAN BatchNewLargestPacketNumber;
+
 } QUIC_ACK_TRACKER;
 
 //
@@ -83,9 +121,29 @@ void
 QuicAckTrackerAckPacket(
     _Inout_ QUIC_ACK_TRACKER* Tracker,
     _In_ uint64_t PacketNumber,
+    _In_ QUIC_ECN_TYPE EcnType,
     _In_ BOOLEAN AckElicitingPayload
     );
 
+//
+// Starts deferring the per-packet ACK scheduling work for a batch of received
+// packets.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicAckTrackerBatchBegin(
+    _Inout_ QUIC_ACK_TRACKER* Tracker
+    );
+
+//
+// Performs the deferred ACK scheduling work for the batch.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicAckTrackerBatchEnd(
+    _Inout_ QUIC_ACK_TRACKER* Tracker
+    );
+
 //
 // Called by the send module to write the current ACK blocks. Returns FALSE if
 // there wasn't enough room to write to the packet.
@@ -11,6 +11,21 @@ Abstract:
 
 #include "precomp.h"
 
+#ifdef QUIC_TRUSTED_INTERIOR
+
+//
+// Trusted-interior builds assume the in-process caller passes handles of the
+// right type, so the per-call type discrimination (which touches the handle's
+// cache line before it is otherwise needed) reduces to a null check. This
+// only relaxes validation of locally supplied parameters; validation of
+// wire input is unaffected by the build profile.
+//
+#define IS_SESSION_HANDLE(Handle) ((Handle) != NULL)
+#define IS_CONN_HANDLE(Handle) ((Handle) != NULL)
+#define IS_STREAM_HANDLE(Handle) ((Handle) != NULL)
+
+#else
+
 #define IS_SESSION_HANDLE(Handle) \
 ( \
     (Handle) != NULL && (Handle)->Type == QUIC_HANDLE_TYPE_SESSION \
@@ -27,6 +42,8 @@ Abstract:
     (Handle) != NULL && (Handle)->Type == QUIC_HANDLE_TYPE_STREAM \
 )
 
+#endif
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QUIC_API
@@ -349,6 +366,223 @@ Error:
     return Status;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicConnectionBatchBegin(
+    _In_ _Pre_defensive_ HQUIC Handle
+    )
+{
+    QUIC_STATUS Status;
+    QUIC_CONNECTION* Connection;
+
+    QuicTraceEvent(
+        ApiEnter,
+        "[ api] Enter %u (%p).",
+        QUIC_TRACE_API_CONNECTION_BATCH_BEGIN,
+        Handle);
+
+    if (IS_CONN_HANDLE(Handle)) {
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+        Connection = (QUIC_CONNECTION*)Handle;
+    } else if (IS_STREAM_HANDLE(Handle)) {
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+        Connection = ((QUIC_STREAM*)Handle)->Connection;
+    } else {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Error;
+    }
+
+    QUIC_CONN_VERIFY(Connection, !Connection->State.Freed);
+    QUIC_CONN_VERIFY(Connection, !Connection->State.HandleClosed);
+
+    QuicWorkerApiBatchBegin(Connection->Worker, Connection);
+    Status = QUIC_STATUS_SUCCESS;
+
+Error:
+
+    QuicTraceEvent(
+        ApiExitStatus,
+        "[ api] Exit %u",
+        Status);
+
+    return Status;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicConnectionBatchCommit(
+    _In_ _Pre_defensive_ HQUIC Handle
+    )
+{
+    QUIC_STATUS Status;
+    QUIC_CONNECTION* Connection;
+
+    QuicTraceEvent(
+        ApiEnter,
+        "[ api] Enter %u (%p).",
+        QUIC_TRACE_API_CONNECTION_BATCH_COMMIT,
+        Handle);
+
+    if (IS_CONN_HANDLE(Handle)) {
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+        Connection = (QUIC_CONNECTION*)Handle;
+    } else if (IS_STREAM_HANDLE(Handle)) {
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+        Connection = ((QUIC_STREAM*)Handle)->Connection;
+    } else {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Error;
+    }
+
+    QUIC_CONN_VERIFY(Connection, !Connection->State.Freed);
+
+    if (!QuicWorkerApiBatchCommit(Connection->Worker, Connection)) {
+        //
+        // Commit without a matching begin.
+        //
+        Status = QUIC_STATUS_INVALID_STATE;
+        goto Error;
+    }
+
+    Status = QUIC_STATUS_SUCCESS;
+
+Error:
+
+    QuicTraceEvent(
+        ApiExitStatus,
+        "[ api] Exit %u",
+        Status);
+
+    return Status;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicConnectionPoolGet(
+    _In_ _Pre_defensive_ HQUIC SessionHandle,
+    _In_ _Pre_defensive_ QUIC_CONNECTION_CALLBACK_HANDLER Handler,
+    _In_opt_ void* Context,
+    _In_ QUIC_ADDRESS_FAMILY Family,
+    _In_reads_z_(QUIC_MAX_SNI_LENGTH)
+        const char* ServerName,
+    _In_ uint16_t ServerPort, // Host byte order
+    _Out_opt_ BOOLEAN* Reused,
+    _Outptr_ _Pre_defensive_ HQUIC* Connection
+    )
+{
+    QUIC_STATUS Status;
+    QUIC_SESSION* Session;
+    QUIC_CONNECTION* PooledConnection;
+    HQUIC NewHandle = NULL;
+
+    QUIC_PASSIVE_CODE();
+
+    QuicTraceEvent(
+        ApiEnter,
+        "[ api] Enter %u (%p).",
+        QUIC_TRACE_API_CONNECTION_POOL_GET,
+        SessionHandle);
+
+    if (!IS_SESSION_HANDLE(SessionHandle) ||
+        Connection == NULL ||
+        Handler == NULL ||
+        ServerName == NULL ||
+        ServerPort == 0) {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Error;
+    }
+
+    //
+    // Validate the server name length.
+    //
+    size_t ServerNameLength = strnlen(ServerName, QUIC_MAX_SNI_LENGTH + 1);
+    if (ServerNameLength == QUIC_MAX_SNI_LENGTH + 1) {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Error;
+    }
+
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+    Session = (QUIC_SESSION*)SessionHandle;
+
+    //
+    // First look for an established pooled connection to the same server.
+    // The session's ALPN applies to every connection in it, so within a
+    // session the pool key reduces to just (server name, server port).
+    //
+    PooledConnection =
+        QuicSessionPoolLookupConnection(
+            Session,
+            (uint16_t)ServerNameLength,
+            ServerName,
+            ServerPort);
+    if (PooledConnection != NULL) {
+        if (Reused != NULL) {
+            *Reused = TRUE;
+        }
+        *Connection = (HQUIC)PooledConnection;
+        Status = QUIC_STATUS_SUCCESS;
+        goto Error;
+    }
+
+    //
+    // No match. Open a new connection, stamp it with the pool key so later
+    // calls can find it, and start it.
+    //
+    Status = MsQuicConnectionOpen(SessionHandle, Handler, Context, &NewHandle);
+    if (QUIC_FAILED(Status)) {
+        goto Error;
+    }
+
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+    PooledConnection = (QUIC_CONNECTION*)NewHandle;
+
+    //
+    // The key is written before the connection is started, so it's published
+    // before the Connected state the pool lookup filters on.
+    //
+    PooledConnection->PoolServerName = QUIC_ALLOC_NONPAGED(ServerNameLength + 1);
+    if (PooledConnection->PoolServerName == NULL) {
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "Pool server name",
+            ServerNameLength + 1);
+        goto Error;
+    }
+    QuicCopyMemory(PooledConnection->PoolServerName, ServerName, ServerNameLength);
+    PooledConnection->PoolServerName[ServerNameLength] = 0;
+    PooledConnection->PoolServerNameLength = (uint16_t)ServerNameLength;
+    PooledConnection->PoolServerPort = ServerPort;
+
+    Status = MsQuicConnectionStart(NewHandle, Family, ServerName, ServerPort);
+    if (QUIC_FAILED(Status)) {
+        goto Error;
+    }
+
+    if (Reused != NULL) {
+        *Reused = FALSE;
+    }
+    *Connection = NewHandle;
+    NewHandle = NULL;
+
+Error:
+
+    if (NewHandle != NULL) {
+        MsQuicConnectionClose(NewHandle);
+    }
+
+    QuicTraceEvent(
+        ApiExitStatus,
+        "[ api] Exit %u",
+        Status);
+
+    return Status;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QUIC_API
@@ -825,30 +1059,62 @@ MsQuicStreamSend(
     }
 
     if (QueueOper) {
-        Oper = QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_API_CALL);
-        if (Oper == NULL) {
-            Status = QUIC_STATUS_OUT_OF_MEMORY;
-            QuicTraceEvent(
-                AllocFailure,
-                "Allocation of '%s' failed. (%llu bytes)",
-                "STRM_SEND operation",
-                0);
-            goto Exit;
-        }
-        Oper->API_CALL.Context->Type = QUIC_API_TYPE_STRM_SEND;
-        Oper->API_CALL.Context->STRM_SEND.Stream = Stream;
+        if (Connection->State.InlineApiSend &&
+            Connection->State.Connected &&
+            QuicWorkerTryClaimConnection(Connection->Worker, Connection)) {
+            //
+            // The connection is idle and uncontended, so the framing and send
+            // work runs directly on this thread instead of paying a
+            // cross-thread hop to the worker. Setting the worker thread ID
+            // makes reentrant API calls from callbacks execute inline, the
+            // same as on the worker thread. FlushOperationPending is set
+            // first so the stream flush doesn't queue a redundant FLUSH_SEND
+            // operation for the flush done right here.
+            //
+            Connection->WorkerThreadID = QuicCurThreadID();
+            QuicSessionAttachSilo(Connection->Session);
+
+            Connection->Send.FlushOperationPending = TRUE;
+            QuicStreamSendFlush(Stream);
+            Connection->Send.FlushOperationPending = FALSE;
+            if (!QuicSendFlush(&Connection->Send)) {
+                //
+                // Still more data to send. Hand the remainder off to the
+                // worker thread.
+                //
+                QuicSendQueueFlush(&Connection->Send, REASON_STREAM_FLAGS);
+            }
 
-        //
-        // Async stream operations need to hold a ref on the stream so that the
-        // stream isn't freed before the operation can be processed. The ref is
-        // released after the operation is processed.
-        //
-        QuicStreamAddRef(Stream, QUIC_STREAM_REF_OPERATION);
+            QuicSessionDetachSilo();
+            Connection->WorkerThreadID = 0;
+            QuicWorkerReleaseConnection(Connection->Worker, Connection);
+
+        } else {
+            Oper = QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_API_CALL);
+            if (Oper == NULL) {
+                Status = QUIC_STATUS_OUT_OF_MEMORY;
+                QuicTraceEvent(
+                    AllocFailure,
+                    "Allocation of '%s' failed. (%llu bytes)",
+                    "STRM_SEND operation",
+                    0);
+                goto Exit;
+            }
+            Oper->API_CALL.Context->Type = QUIC_API_TYPE_STRM_SEND;
+            Oper->API_CALL.Context->STRM_SEND.Stream = Stream;
 
-        //
-        // Queue the operation but don't wait for the completion.
-        //
-        QuicConnQueueOper(Connection, Oper);
+            //
+            // Async stream operations need to hold a ref on the stream so that
+            // the stream isn't freed before the operation can be processed.
+            // The ref is released after the operation is processed.
+            //
+            QuicStreamAddRef(Stream, QUIC_STREAM_REF_OPERATION);
+
+            //
+            // Queue the operation but don't wait for the completion.
+            //
+            QuicConnQueueOper(Connection, Oper);
+        }
     }
 
     Status = QUIC_STATUS_PENDING;
@@ -1017,6 +1283,94 @@ Exit:
     return Status;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicDatagramSend(
+    _In_ _Pre_defensive_ HQUIC Handle,
+    _In_reads_(BufferCount) _Pre_defensive_
+        const QUIC_BUFFER * const Buffers,
+    _In_ uint32_t BufferCount,
+    _In_ QUIC_SEND_FLAGS Flags,
+    _In_opt_ void* ClientSendContext
+    )
+{
+    QUIC_STATUS Status;
+    QUIC_CONNECTION* Connection;
+    uint64_t TotalLength;
+    QUIC_SEND_REQUEST* SendRequest;
+
+    QuicTraceEvent(
+        ApiEnter,
+        "[ api] Enter %u (%p).",
+        QUIC_TRACE_API_DATAGRAM_SEND,
+        Handle);
+
+    if (!IS_CONN_HANDLE(Handle) ||
+        Buffers == NULL ||
+        BufferCount == 0) {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+    Connection = (QUIC_CONNECTION*)Handle;
+
+    QUIC_CONN_VERIFY(Connection, !Connection->State.Freed);
+    QUIC_CONN_VERIFY(Connection,
+        (Connection->WorkerThreadID == QuicCurThreadID()) ||
+        !Connection->State.HandleClosed);
+
+    TotalLength = 0;
+    for (uint32_t i = 0; i < BufferCount; ++i) {
+        TotalLength += Buffers[i].Length;
+    }
+
+    if (TotalLength > UINT16_MAX) {
+        QuicTraceEvent(
+            ConnError,
+            "[conn][%p] ERROR, %s.",
+            Connection,
+            "Send request total length exceeds max");
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+#pragma prefast(suppress: __WARNING_6014, "Memory is correctly freed (datagram send request).")
+    SendRequest = QuicPoolAlloc(&Connection->Worker->SendRequestPool);
+    if (SendRequest == NULL) {
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "Datagram Send request",
+            0);
+        goto Exit;
+    }
+
+    SendRequest->Next = NULL;
+    SendRequest->Buffers = Buffers;
+    SendRequest->BufferCount = BufferCount;
+    SendRequest->Flags = Flags & ~QUIC_SEND_FLAGS_INTERNAL;
+    SendRequest->TotalLength = TotalLength;
+    SendRequest->ClientContext = ClientSendContext;
+
+    //
+    // Queuing the send always takes ownership of the request, freeing it as
+    // necessary on failure.
+    //
+    Status = QuicDatagramQueueSend(&Connection->Datagram, SendRequest);
+
+Exit:
+
+    QuicTraceEvent(
+        ApiExitStatus,
+        "[ api] Exit %u",
+        Status);
+
+    return Status;
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QUIC_API
@@ -72,6 +72,16 @@ MsQuicSessionShutdown(
     _In_ _Pre_defensive_ QUIC_UINT62 ErrorCode
     );
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicSessionDrain(
+    _In_ _Pre_defensive_ HQUIC Session,
+    _In_ QUIC_CONNECTION_SHUTDOWN_FLAGS Flags,
+    _In_ _Pre_defensive_ QUIC_UINT62 ErrorCode,
+    _In_ uint32_t RatePerSecond
+    );
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QUIC_API
@@ -145,6 +155,35 @@ MsQuicConnectionStart(
     _In_ uint16_t ServerPort // Host byte order
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicConnectionBatchBegin(
+    _In_ _Pre_defensive_ HQUIC Handle
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicConnectionBatchCommit(
+    _In_ _Pre_defensive_ HQUIC Handle
+    );
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicConnectionPoolGet(
+    _In_ _Pre_defensive_ HQUIC SessionHandle,
+    _In_ _Pre_defensive_ QUIC_CONNECTION_CALLBACK_HANDLER Handler,
+    _In_opt_ void* Context,
+    _In_ QUIC_ADDRESS_FAMILY Family,
+    _In_reads_z_(QUIC_MAX_SNI_LENGTH)
+        const char* ServerName,
+    _In_ uint16_t ServerPort, // Host byte order
+    _Out_opt_ BOOLEAN* Reused,
+    _Outptr_ _Pre_defensive_ HQUIC* Connection
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QUIC_API
@@ -210,6 +249,18 @@ MsQuicStreamReceiveSetEnabled(
     _In_ BOOLEAN IsEnabled
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicDatagramSend(
+    _In_ _Pre_defensive_ HQUIC Handle,
+    _In_reads_(BufferCount) _Pre_defensive_
+        const QUIC_BUFFER * const Buffers,
+    _In_ uint32_t BufferCount,
+    _In_ QUIC_SEND_FLAGS Flags,
+    _In_opt_ void* ClientSendContext
+    );
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QUIC_API
@@ -0,0 +1,572 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    The BBR congestion control algorithm (draft-cardwell-iccrg-bbr-congestion-control).
+
+    Instead of backing off only on loss, BBR builds an explicit model of the
+    path: the bottleneck bandwidth (the windowed max of delivery rate samples)
+    and the minimum round trip time. The congestion window and pacing rate are
+    derived from the model, cycling through gain phases to probe for more
+    bandwidth and periodically draining the queue to re-measure the RTT.
+
+    Delivery rate samples are taken per ACK event (bytes newly acknowledged
+    over the time since the previous ACK event), which is coarser than
+    per-packet delivery rate sampling but requires no extra state in the sent
+    packet metadata.
+
+Future work:
+
+    -Per-packet delivery rate sampling with app-limited tracking.
+
+--*/
+
+#include "precomp.h"
+
+//
+// Gain values. 100x multiples for integer arithmetic.
+//
+// The high gain is 2/ln(2), used for both pacing and window growth during
+// STARTUP, and the drain gain is its inverse.
+//
+#define HUNDRED_TIMES_BBR_HIGH_GAIN 289
+#define HUNDRED_TIMES_BBR_DRAIN_GAIN 35
+#define HUNDRED_TIMES_BBR_CWND_GAIN 200
+
+//
+// The pacing gain cycle used in PROBE_BW: one probing phase, one draining
+// phase and six cruising phases, each lasting roughly one MinRtt.
+//
+#define QUIC_BBR_GAIN_CYCLE_LEN 8
+static const uint32_t HundredTimesPacingGainCycle[QUIC_BBR_GAIN_CYCLE_LEN] =
+    { 125, 75, 100, 100, 100, 100, 100, 100 };
+
+//
+// The number of rounds the bandwidth estimate must fail to grow by at least
+// 25% before STARTUP is declared over.
+//
+#define QUIC_BBR_STARTUP_FULL_BW_ROUNDS 3
+
+//
+// The MinRtt estimate expires after this period, triggering PROBE_RTT.
+//
+#define QUIC_BBR_MIN_RTT_EXPIRY_MS 10000
+
+//
+// How long the connection stays in PROBE_RTT with a minimal window.
+//
+#define QUIC_BBR_PROBE_RTT_DURATION_MS 200
+
+//
+// The congestion window is never reduced below this many packets (except
+// under persistent congestion).
+//
+#define QUIC_BBR_MIN_WINDOW_PACKETS 4
+
+void
+QuicConnLogBbr(
+    _In_ const QUIC_CONNECTION* const Connection
+    )
+{
+    UNREFERENCED_PARAMETER(Connection);
+    QuicTraceEvent(
+        ConnBbr,
+        "[conn][%p] BBR: State=%u Bandwidth=%llu MinRtt=%llu CongestionWindow=%u",
+        Connection,
+        Connection->CongestionControl.Ctx.Bbr.State,
+        Connection->CongestionControl.Ctx.Bbr.FullBandwidth,
+        Connection->CongestionControl.Ctx.Bbr.MinRtt,
+        Connection->CongestionControl.CongestionWindow);
+}
+
+//
+// Returns the current bottleneck bandwidth estimate, in bytes per second.
+// Zero if no samples have been taken yet.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint64_t
+QuicBbrBandwidthEstimate(
+    _In_ const QUIC_CONGESTION_CONTROL_BBR* Bbr
+    )
+{
+    uint64_t Bandwidth = 0;
+    for (uint32_t i = 0; i < QUIC_BBR_BANDWIDTH_FILTER_LEN; ++i) {
+        if (Bbr->BandwidthFilter[i] > Bandwidth) {
+            Bandwidth = Bbr->BandwidthFilter[i];
+        }
+    }
+    return Bandwidth;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicBbrMinCongestionWindow(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    return
+        QuicCongestionControlGetConnection(Cc)->Paths[0].Mtu *
+        QUIC_BBR_MIN_WINDOW_PACKETS;
+}
+
+//
+// Returns the window implied by the current path model:
+// bandwidth-delay product times the given (100x) gain.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicBbrTargetCongestionWindow(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint32_t HundredTimesGain
+    )
+{
+    QUIC_CONGESTION_CONTROL_BBR* Bbr = &Cc->Ctx.Bbr;
+
+    uint64_t BandwidthDelayProduct =
+        QuicBbrBandwidthEstimate(Bbr) * Bbr->MinRtt / 1000000; // bytes
+
+    uint64_t TargetWindow = BandwidthDelayProduct * HundredTimesGain / 100;
+    if (TargetWindow > UINT32_MAX) {
+        TargetWindow = UINT32_MAX;
+    }
+    return max((uint32_t)TargetWindow, QuicBbrMinCongestionWindow(Cc));
+}
+
+//
+// Returns the (100x) pacing gain for the current state.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicBbrPacingGain(
+    _In_ const QUIC_CONGESTION_CONTROL_BBR* Bbr
+    )
+{
+    switch (Bbr->State) {
+    case QUIC_BBR_STATE_STARTUP:
+        return HUNDRED_TIMES_BBR_HIGH_GAIN;
+    case QUIC_BBR_STATE_DRAIN:
+        return HUNDRED_TIMES_BBR_DRAIN_GAIN;
+    case QUIC_BBR_STATE_PROBE_BW:
+        return HundredTimesPacingGainCycle[Bbr->PacingCyclePhase];
+    default:
+        return 100;
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBbrCongestionControlReset(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    QuicZeroMemory(&Cc->Ctx.Bbr, sizeof(Cc->Ctx.Bbr));
+    Cc->Ctx.Bbr.State = QUIC_BBR_STATE_STARTUP;
+    Cc->SlowStartThreshold = UINT32_MAX;
+    Cc->IsInRecovery = FALSE;
+    Cc->HasHadCongestionEvent = FALSE;
+    Cc->CongestionWindow = Connection->Paths[0].Mtu * Cc->InitialWindowPackets;
+    Cc->BytesInFlightMax = Cc->CongestionWindow / 2;
+    Cc->BytesInFlight = 0;
+    QuicConnLogOutFlowStats(Connection);
+    QuicConnLogBbr(Connection);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicBbrCongestionControlGetSendAllowance(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t TimeSinceLastSend, // microsec
+    _In_ BOOLEAN TimeSinceLastSendValid
+    )
+{
+    uint32_t SendAllowance;
+    QUIC_CONGESTION_CONTROL_BBR* Bbr = &Cc->Ctx.Bbr;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    uint64_t Bandwidth = QuicBbrBandwidthEstimate(Bbr);
+
+    if (Cc->BytesInFlight >= Cc->CongestionWindow) {
+        //
+        // We are CC blocked, so we can't send anything.
+        //
+        SendAllowance = 0;
+
+    } else if (
+        !Connection->State.UsePacing ||
+        !Connection->Paths[0].GotFirstRttSample ||
+        Bandwidth == 0) {
+        //
+        // Pacing is disabled or the path model isn't populated yet, so just
+        // send everything we can.
+        //
+        SendAllowance = Cc->CongestionWindow - Cc->BytesInFlight;
+
+    } else {
+        //
+        // Pace at the modeled bottleneck bandwidth times the gain for the
+        // current state, releasing the chunk of bytes covered by the time
+        // elapsed since the last send.
+        //
+        uint32_t MinChunkSize = QUIC_SEND_PACING_MIN_CHUNK * Connection->Paths[0].Mtu;
+        if (!TimeSinceLastSendValid || Cc->CongestionWindow < MinChunkSize) {
+            SendAllowance = Cc->CongestionWindow - Cc->BytesInFlight;
+
+        } else {
+            uint64_t PacingRate = Bandwidth * QuicBbrPacingGain(Bbr) / 100; // bytes/sec
+            SendAllowance = (uint32_t)(PacingRate * TimeSinceLastSend / 1000000);
+            if (SendAllowance < MinChunkSize) {
+                SendAllowance = MinChunkSize;
+            }
+            if (SendAllowance > (Cc->CongestionWindow - Cc->BytesInFlight)) {
+                SendAllowance = Cc->CongestionWindow - Cc->BytesInFlight;
+            }
+            uint32_t MaxBurstSize = QUIC_SEND_PACING_MAX_BURST * Connection->Paths[0].Mtu;
+            if (SendAllowance > MaxBurstSize) {
+                //
+                // Cap the chunk at what the datapath can serialize in one
+                // batch (see cubic.c).
+                //
+                SendAllowance = MaxBurstSize;
+            }
+        }
+    }
+    return SendAllowance;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicBbrCongestionControlOnDataAcknowledged(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t TimeNow, // millisec
+    _In_ uint64_t LargestPacketNumberAcked,
+    _In_ uint32_t NumRetransmittableBytes,
+    _In_ uint32_t SmoothedRtt
+    )
+{
+    QUIC_CONGESTION_CONTROL_BBR* Bbr = &Cc->Ctx.Bbr;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    BOOLEAN PreviousCanSendState = QuicCongestionControlCanSend(Cc);
+    BOOLEAN NewRound = FALSE;
+
+    UNREFERENCED_PARAMETER(SmoothedRtt);
+
+    QUIC_DBG_ASSERT(Cc->BytesInFlight >= NumRetransmittableBytes);
+    Cc->BytesInFlight -= NumRetransmittableBytes;
+
+    if (Cc->IsInRecovery &&
+        LargestPacketNumberAcked > Cc->RecoverySentPacketNumber) {
+        //
+        // Done recovering. Unlike loss-based algorithms, BBR keeps updating
+        // its model during recovery, so there is nothing else to restore.
+        //
+        QuicTraceEvent(
+            ConnRecoveryExit,
+            "[conn][%p] Recovery complete",
+            Connection);
+        Cc->IsInRecovery = FALSE;
+        Cc->IsInPersistentCongestion = FALSE;
+    }
+
+    //
+    // A round trip ends when a packet sent after the previous round started
+    // is acknowledged.
+    //
+    if (LargestPacketNumberAcked >= Bbr->EndOfRoundPacketNumber) {
+        Bbr->RoundCount++;
+        Bbr->EndOfRoundPacketNumber =
+            Connection->LossDetection.LargestSentPacketNumber;
+        Bbr->BandwidthFilter[Bbr->RoundCount % QUIC_BBR_BANDWIDTH_FILTER_LEN] = 0;
+        NewRound = TRUE;
+    }
+
+    //
+    // Take a delivery rate sample: bytes newly acknowledged over the time
+    // since the previous ACK event.
+    //
+    if (Bbr->TimeOfLastAckValid && NumRetransmittableBytes > 0) {
+        uint64_t ElapsedMs = QuicTimeDiff64(Bbr->TimeOfLastAck, TimeNow);
+        if (ElapsedMs > 0) {
+            uint64_t Bandwidth = (uint64_t)NumRetransmittableBytes * 1000 / ElapsedMs; // bytes/sec
+            uint64_t* Slot =
+                &Bbr->BandwidthFilter[Bbr->RoundCount % QUIC_BBR_BANDWIDTH_FILTER_LEN];
+            if (Bandwidth > *Slot) {
+                *Slot = Bandwidth;
+            }
+        }
+    }
+
+    //
+    // Update the MinRtt estimate from the latest RTT sample. An expired
+    // estimate is replaced outright; PROBE_RTT (below) makes sure there is a
+    // recent sample taken with the queue drained.
+    //
+    uint64_t RttSample = Connection->Paths[0].LatestRttSample; // microsec
+    if (RttSample != 0 &&
+        (!Bbr->MinRttValid ||
+         RttSample <= Bbr->MinRtt ||
+         QuicTimeDiff64(Bbr->MinRttTimestamp, TimeNow) > QUIC_BBR_MIN_RTT_EXPIRY_MS)) {
+        Bbr->MinRtt = RttSample;
+        Bbr->MinRttTimestamp = TimeNow;
+        Bbr->MinRttValid = TRUE;
+    }
+
+    uint64_t BandwidthEstimate = QuicBbrBandwidthEstimate(Bbr);
+
+    switch (Bbr->State) {
+
+    case QUIC_BBR_STATE_STARTUP:
+        //
+        // Exit STARTUP once the bandwidth estimate has stopped growing by at
+        // least 25% for several rounds in a row.
+        //
+        if (BandwidthEstimate >= Bbr->FullBandwidth + Bbr->FullBandwidth / 4) {
+            Bbr->FullBandwidth = BandwidthEstimate;
+            Bbr->FullBandwidthCount = 0;
+        } else if (NewRound && Bbr->FullBandwidth != 0) {
+            if (++Bbr->FullBandwidthCount >= QUIC_BBR_STARTUP_FULL_BW_ROUNDS) {
+                Bbr->BtlbwFound = TRUE;
+                Bbr->State = QUIC_BBR_STATE_DRAIN;
+            }
+        }
+        break;
+
+    case QUIC_BBR_STATE_DRAIN:
+        //
+        // Drain the queue built up during STARTUP, then start cycling.
+        //
+        if (Cc->BytesInFlight <= QuicBbrTargetCongestionWindow(Cc, 100)) {
+            Bbr->State = QUIC_BBR_STATE_PROBE_BW;
+            Bbr->PacingCyclePhase =
+                (uint8_t)(Bbr->RoundCount % QUIC_BBR_GAIN_CYCLE_LEN);
+            Bbr->CyclePhaseStartTime = TimeNow;
+        }
+        break;
+
+    case QUIC_BBR_STATE_PROBE_BW:
+        //
+        // Advance the gain cycle roughly once per MinRtt.
+        //
+        if (Bbr->MinRttValid &&
+            QuicTimeDiff64(Bbr->CyclePhaseStartTime, TimeNow) >=
+                max(1, US_TO_MS(Bbr->MinRtt))) {
+            Bbr->PacingCyclePhase =
+                (Bbr->PacingCyclePhase + 1) % QUIC_BBR_GAIN_CYCLE_LEN;
+            Bbr->CyclePhaseStartTime = TimeNow;
+        }
+        break;
+
+    case QUIC_BBR_STATE_PROBE_RTT:
+        if (QuicTimeAtOrBefore64(Bbr->ProbeRttEndTime, TimeNow)) {
+            Bbr->MinRttTimestamp = TimeNow;
+            if (Bbr->BtlbwFound) {
+                Bbr->State = QUIC_BBR_STATE_PROBE_BW;
+                Bbr->PacingCyclePhase =
+                    (uint8_t)(Bbr->RoundCount % QUIC_BBR_GAIN_CYCLE_LEN);
+                Bbr->CyclePhaseStartTime = TimeNow;
+            } else {
+                Bbr->State = QUIC_BBR_STATE_STARTUP;
+            }
+        }
+        break;
+    }
+
+    //
+    // Enter PROBE_RTT when the MinRtt estimate has gone stale, to drain the
+    // queue and re-measure the path's base RTT.
+    //
+    if (Bbr->State != QUIC_BBR_STATE_PROBE_RTT &&
+        Bbr->MinRttValid &&
+        QuicTimeDiff64(Bbr->MinRttTimestamp, TimeNow) > QUIC_BBR_MIN_RTT_EXPIRY_MS) {
+        Bbr->State = QUIC_BBR_STATE_PROBE_RTT;
+        Bbr->ProbeRttEndTime = TimeNow + QUIC_BBR_PROBE_RTT_DURATION_MS;
+    }
+
+    //
+    // Derive the congestion window from the model.
+    //
+    if (Bbr->State == QUIC_BBR_STATE_PROBE_RTT) {
+        Cc->CongestionWindow = QuicBbrMinCongestionWindow(Cc);
+
+    } else if (BandwidthEstimate == 0 || !Bbr->MinRttValid) {
+        //
+        // No model yet; grow the window on acknowledged bytes like slow
+        // start does.
+        //
+        Cc->CongestionWindow += NumRetransmittableBytes;
+
+    } else if (Bbr->State == QUIC_BBR_STATE_STARTUP) {
+        //
+        // In STARTUP the window grows on acknowledged bytes, never dropping
+        // below what the (growing) model justifies.
+        //
+        Cc->CongestionWindow =
+            max(
+                Cc->CongestionWindow + NumRetransmittableBytes,
+                QuicBbrTargetCongestionWindow(Cc, HUNDRED_TIMES_BBR_CWND_GAIN));
+
+    } else {
+        //
+        // Move the window toward the model's target, growing by at most the
+        // acknowledged bytes per ACK to avoid bursts.
+        //
+        uint32_t TargetWindow =
+            QuicBbrTargetCongestionWindow(Cc, HUNDRED_TIMES_BBR_CWND_GAIN);
+        if (Cc->CongestionWindow < TargetWindow) {
+            Cc->CongestionWindow =
+                min(Cc->CongestionWindow + NumRetransmittableBytes, TargetWindow);
+        } else {
+            Cc->CongestionWindow = TargetWindow;
+        }
+    }
+
+    //
+    // Limit the growth of the window based on the number of bytes we
+    // actually manage to put on the wire, to prevent the window from growing
+    // without feedback from the network (see cubic.c for details).
+    //
+    if (Cc->CongestionWindow > 2 * Cc->BytesInFlightMax) {
+        Cc->CongestionWindow = 2 * Cc->BytesInFlightMax;
+    }
+    if (Cc->CongestionWindow < QuicBbrMinCongestionWindow(Cc)) {
+        Cc->CongestionWindow = QuicBbrMinCongestionWindow(Cc);
+    }
+
+    Bbr->TimeOfLastAck = TimeNow;
+    Bbr->TimeOfLastAckValid = TRUE;
+    return QuicCongestionControlUpdateBlockedState(Cc, PreviousCanSendState);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBbrCongestionControlOnDataLost(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t LargestPacketNumberLost,
+    _In_ uint64_t LargestPacketNumberSent,
+    _In_ uint32_t NumRetransmittableBytes,
+    _In_ BOOLEAN PersistentCongestion
+    )
+{
+    QUIC_CONGESTION_CONTROL_BBR* Bbr = &Cc->Ctx.Bbr;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    BOOLEAN PreviousCanSendState = QuicCongestionControlCanSend(Cc);
+
+    QUIC_DBG_ASSERT(Cc->BytesInFlight >= NumRetransmittableBytes);
+    Cc->BytesInFlight -= NumRetransmittableBytes;
+
+    //
+    // If data is lost after the most recent congestion event (or if there
+    // hasn't been a congestion event yet) then treat this loss as a new
+    // congestion event.
+    //
+    if (!Cc->HasHadCongestionEvent ||
+        LargestPacketNumberLost > Cc->RecoverySentPacketNumber) {
+
+        Cc->RecoverySentPacketNumber = LargestPacketNumberSent;
+        QuicTraceEvent(
+            ConnCongestion,
+            "[conn][%p] Congestion event",
+            Connection);
+        Connection->Stats.Send.CongestionCount++;
+
+        Cc->IsInRecovery = TRUE;
+        Cc->HasHadCongestionEvent = TRUE;
+
+        //
+        // BBR does not back the window off multiplicatively on loss; the
+        // model bounds the in-flight data. Just cap the window at what is
+        // actually left in the network.
+        //
+        Cc->CongestionWindow =
+            max(Cc->BytesInFlight, QuicBbrMinCongestionWindow(Cc));
+
+        if (PersistentCongestion && !Cc->IsInPersistentCongestion) {
+            QuicTraceEvent(
+                ConnPersistentCongestion,
+                "[conn][%p] Persistent congestion event",
+                Connection);
+            Connection->Stats.Send.PersistentCongestionCount++;
+
+            Cc->IsInPersistentCongestion = TRUE;
+            Cc->CongestionWindow =
+                Connection->Paths[0].Mtu * QUIC_PERSISTENT_CONGESTION_WINDOW_PACKETS;
+
+            //
+            // The path has changed out from under the model. Rebuild it from
+            // scratch.
+            //
+            QuicZeroMemory(Bbr->BandwidthFilter, sizeof(Bbr->BandwidthFilter));
+            Bbr->FullBandwidth = 0;
+            Bbr->FullBandwidthCount = 0;
+            Bbr->BtlbwFound = FALSE;
+            Bbr->State = QUIC_BBR_STATE_STARTUP;
+        }
+    }
+
+    QuicCongestionControlUpdateBlockedState(Cc, PreviousCanSendState);
+    QuicConnLogBbr(Connection);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBbrCongestionControlOnEcnCongestionEvent(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t LargestPacketNumberAcked,
+    _In_ uint64_t LargestPacketNumberSent
+    )
+{
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    BOOLEAN PreviousCanSendState = QuicCongestionControlCanSend(Cc);
+
+    //
+    // A CE mark received after the most recent congestion event (or before
+    // any congestion event) starts a new recovery period, just like loss,
+    // except no bytes leave the network.
+    //
+    if (!Cc->HasHadCongestionEvent ||
+        LargestPacketNumberAcked > Cc->RecoverySentPacketNumber) {
+
+        Cc->RecoverySentPacketNumber = LargestPacketNumberSent;
+        QuicTraceEvent(
+            ConnCongestion,
+            "[conn][%p] Congestion event",
+            Connection);
+        Connection->Stats.Send.CongestionCount++;
+
+        Cc->IsInRecovery = TRUE;
+        Cc->HasHadCongestionEvent = TRUE;
+
+        Cc->CongestionWindow =
+            max(Cc->BytesInFlight, QuicBbrMinCongestionWindow(Cc));
+    }
+
+    QuicCongestionControlUpdateBlockedState(Cc, PreviousCanSendState);
+    QuicConnLogBbr(Connection);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBbrCongestionControlInitialize(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ const QUIC_SETTINGS* Settings
+    )
+{
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+
+    Cc->Reset = QuicBbrCongestionControlReset;
+    Cc->GetSendAllowance = QuicBbrCongestionControlGetSendAllowance;
+    Cc->OnDataAcknowledged = QuicBbrCongestionControlOnDataAcknowledged;
+    Cc->OnDataLost = QuicBbrCongestionControlOnDataLost;
+    Cc->OnEcnCongestionEvent = QuicBbrCongestionControlOnEcnCongestionEvent;
+
+    Cc->Ctx.Bbr.State = QUIC_BBR_STATE_STARTUP;
+    Cc->SlowStartThreshold = UINT32_MAX;
+    Cc->SendIdleTimeoutMs = Settings->SendIdleTimeoutMs;
+    Cc->InitialWindowPackets = Settings->InitialWindowPackets;
+    Cc->CongestionWindow = Connection->Paths[0].Mtu * Cc->InitialWindowPackets;
+    Cc->BytesInFlightMax = Cc->CongestionWindow / 2;
+    QuicConnLogOutFlowStats(Connection);
+    QuicConnLogBbr(Connection);
+}
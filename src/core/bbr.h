@@ -0,0 +1,100 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+--*/
+
+struct QUIC_CONGESTION_CONTROL;
+
+//
+// The number of rounds the bottleneck bandwidth estimate is remembered for.
+//
+#define QUIC_BBR_BANDWIDTH_FILTER_LEN 8
+
+typedef enum QUIC_BBR_STATE {
+    QUIC_BBR_STATE_STARTUP,
+    QUIC_BBR_STATE_DRAIN,
+    QUIC_BBR_STATE_PROBE_BW,
+    QUIC_BBR_STATE_PROBE_RTT
+} QUIC_BBR_STATE;
+
+//
+// Per-connection state for the BBR congestion control algorithm.
+//
+typedef struct QUIC_CONGESTION_CONTROL_BBR {
+
+    QUIC_BBR_STATE State;
+
+    //
+    // TRUE once the bottleneck bandwidth estimate has stopped growing,
+    // ending the STARTUP state.
+    //
+    BOOLEAN BtlbwFound : 1;
+
+    //
+    // TRUE if MinRtt (and MinRttTimestamp) are valid.
+    //
+    BOOLEAN MinRttValid : 1;
+
+    //
+    // TRUE if TimeOfLastAck is valid.
+    //
+    BOOLEAN TimeOfLastAckValid : 1;
+
+    //
+    // The number of rounds the bandwidth estimate has failed to grow by at
+    // least 25%, used to detect the bandwidth plateau that ends STARTUP.
+    //
+    uint8_t FullBandwidthCount;
+
+    //
+    // Index into the PROBE_BW pacing gain cycle.
+    //
+    uint8_t PacingCyclePhase;
+
+    //
+    // Windowed max filter of per-round delivery rate samples, in bytes per
+    // second, indexed by round count.
+    //
+    uint64_t BandwidthFilter[QUIC_BBR_BANDWIDTH_FILTER_LEN];
+
+    //
+    // The bandwidth estimate the last time STARTUP growth was evaluated.
+    //
+    uint64_t FullBandwidth; // bytes/sec
+
+    //
+    // A round trip ends when a packet sent after the previous round started
+    // is acknowledged.
+    //
+    uint64_t RoundCount;
+    uint64_t EndOfRoundPacketNumber;
+
+    uint64_t MinRtt; // microsec
+    uint64_t MinRttTimestamp; // millisec
+
+    //
+    // The time at which the current PROBE_RTT state ends.
+    //
+    uint64_t ProbeRttEndTime; // millisec
+
+    //
+    // The time at which the current PROBE_BW gain cycle phase started.
+    //
+    uint64_t CyclePhaseStartTime; // millisec
+
+    uint64_t TimeOfLastAck; // millisec
+
+} QUIC_CONGESTION_CONTROL_BBR;
+
+//
+// Initializes the BBR algorithm and binds it to the congestion control
+// context.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBbrCongestionControlInitialize(
+    _In_ struct QUIC_CONGESTION_CONTROL* Cc,
+    _In_ const QUIC_SETTINGS* Settings
+    );
@@ -26,10 +26,31 @@ Abstract:
     sizeof(uint32_t) + \
     sizeof(QuicSupportedVersionList) \
 )
+//
+// The number of receive datagram pointers flattened from the datapath's
+// linked chain into a stack array at a time, so the validation loop iterates
+// an array instead of chasing Next pointers. Sized to cover a full datapath
+// receive batch in one refill without much stack.
+//
+#define QUIC_RECEIVE_FLATTEN_BATCH_SIZE 40
+
 QUIC_STATIC_ASSERT(
     QUIC_DEFAULT_PATH_MTU - 48 >= MAX_VER_NEG_PACKET_LENGTH,
     "Too many supported version numbers! Requires too big of buffer for response!");
 
+//
+// Token bucket parameters for each stateless response class, indexed by
+// QUIC_STATELESS_CLASS.
+//
+static const struct {
+    uint32_t RatePerSecond;
+    uint32_t Burst;
+} QuicStatelessAdmitParams[QUIC_STATELESS_CLASS_COUNT] = {
+    { QUIC_STATELESS_ADMIT_RATE_VER_NEG, QUIC_STATELESS_ADMIT_BURST_VER_NEG },
+    { QUIC_STATELESS_ADMIT_RATE_RETRY,   QUIC_STATELESS_ADMIT_BURST_RETRY },
+    { QUIC_STATELESS_ADMIT_RATE_RESET,   QUIC_STATELESS_ADMIT_BURST_RESET },
+};
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicBindingInitialize(
@@ -62,14 +83,24 @@ QuicBindingInitialize(
     Binding->Exclusive = !ShareBinding;
     Binding->ServerOwned = ServerOwned;
     Binding->Connected = RemoteAddress == NULL ? FALSE : TRUE;
-    Binding->StatelessOperCount = 0;
     QuicDispatchRwLockInitialize(&Binding->RwLock);
     QuicDispatchLockInitialize(&Binding->ResetTokenLock);
-    QuicDispatchLockInitialize(&Binding->StatelessOperLock);
+    QuicZeroMemory(Binding->ResetTokenCache, sizeof(Binding->ResetTokenCache));
+    QuicDispatchLockInitialize(&Binding->StatelessAdmitLock);
+    uint64_t TimeNow = QuicTimeUs64();
+    for (uint32_t i = 0; i < QUIC_STATELESS_CLASS_COUNT; i++) {
+        Binding->StatelessAdmit[i].Tokens = QuicStatelessAdmitParams[i].Burst;
+        Binding->StatelessAdmit[i].LastRefillTimeUs = TimeNow;
+    }
     QuicListInitializeHead(&Binding->Listeners);
     QuicLookupInitialize(&Binding->Lookup);
-    QuicHashtableInitializeEx(&Binding->StatelessOperTable, QUIC_HASH_MIN_SIZE);
-    QuicListInitializeHead(&Binding->StatelessOperList);
+    for (uint32_t i = 0; i < QUIC_STATELESS_OPER_SHARD_COUNT; i++) {
+        QUIC_STATELESS_OPER_SHARD* Shard = &Binding->StatelessOperShards[i];
+        QuicDispatchLockInitialize(&Shard->Lock);
+        QuicHashtableInitializeEx(&Shard->Table, QUIC_HASH_MIN_SIZE);
+        QuicListInitializeHead(&Shard->List);
+        Shard->Count = 0;
+    }
 
     //
     // Random reserved version number for version negotation.
@@ -78,7 +109,21 @@ QuicBindingInitialize(
     Binding->RandomReservedVersion =
         (Binding->RandomReservedVersion & ~QUIC_VERSION_RESERVED_MASK) |
         QUIC_VERSION_RESERVED;
-    
+
+    //
+    // Preformat the version negotiation list so the datapath threads can copy
+    // it straight into outgoing packets.
+    //
+    Binding->VerNegVersions[0] = Binding->RandomReservedVersion;
+    QuicCopyMemory(
+        Binding->VerNegVersions + 1,
+        QuicSupportedVersionList,
+        sizeof(QuicSupportedVersionList));
+
+    Binding->StatelessResponseTokens = QUIC_STATELESS_RESPONSE_BUCKET_TOKENS;
+    Binding->StatelessResponseLastFillTimeMs = (long)QuicTimeMs32();
+
+
     QuicRandom(sizeof(HashSalt), HashSalt);
     Status =
         QuicHashCreate(
@@ -162,8 +207,11 @@ Error:
         if (Binding != NULL) {
             QuicHashFree(Binding->ResetTokenHash);
             QuicLookupUninitialize(&Binding->Lookup);
-            QuicHashtableUninitialize(&Binding->StatelessOperTable);
-            QuicDispatchLockUninitialize(&Binding->StatelessOperLock);
+            for (uint32_t i = 0; i < QUIC_STATELESS_OPER_SHARD_COUNT; i++) {
+                QuicHashtableUninitialize(&Binding->StatelessOperShards[i].Table);
+                QuicDispatchLockUninitialize(&Binding->StatelessOperShards[i].Lock);
+            }
+            QuicDispatchLockUninitialize(&Binding->StatelessAdmitLock);
             QuicDispatchLockUninitialize(&Binding->ResetTokenLock);
             QuicDispatchRwLockUninitialize(&Binding->RwLock);
             QUIC_FREE(Binding);
@@ -196,29 +244,35 @@ QuicBindingUninitialize(
     //
     // Clean up any leftover stateless operations being tracked.
     //
-    while (!QuicListIsEmpty(&Binding->StatelessOperList)) {
-        QUIC_STATELESS_CONTEXT* StatelessCtx =
-            QUIC_CONTAINING_RECORD(
-                QuicListRemoveHead(&Binding->StatelessOperList),
-                QUIC_STATELESS_CONTEXT,
-                ListEntry);
-        Binding->StatelessOperCount--;
-        QuicHashtableRemove(
-            &Binding->StatelessOperTable,
-            &StatelessCtx->TableEntry,
-            NULL);
-        QUIC_DBG_ASSERT(StatelessCtx->IsProcessed);
-        QuicPoolFree(
-            &StatelessCtx->Worker->StatelessContextPool,
-            StatelessCtx);
+    for (uint32_t i = 0; i < QUIC_STATELESS_OPER_SHARD_COUNT; i++) {
+        QUIC_STATELESS_OPER_SHARD* Shard = &Binding->StatelessOperShards[i];
+        while (!QuicListIsEmpty(&Shard->List)) {
+            QUIC_STATELESS_CONTEXT* StatelessCtx =
+                QUIC_CONTAINING_RECORD(
+                    QuicListRemoveHead(&Shard->List),
+                    QUIC_STATELESS_CONTEXT,
+                    ListEntry);
+            Shard->Count--;
+            QuicHashtableRemove(
+                &Shard->Table,
+                &StatelessCtx->TableEntry,
+                NULL);
+            QUIC_DBG_ASSERT(StatelessCtx->IsProcessed);
+            QuicPoolFree(
+                &StatelessCtx->Worker->StatelessContextPool,
+                StatelessCtx);
+        }
+        QUIC_DBG_ASSERT(Shard->Count == 0);
+        QUIC_DBG_ASSERT(Shard->Table.NumEntries == 0);
     }
-    QUIC_DBG_ASSERT(Binding->StatelessOperCount == 0);
-    QUIC_DBG_ASSERT(Binding->StatelessOperTable.NumEntries == 0);
 
     QuicHashFree(Binding->ResetTokenHash);
     QuicLookupUninitialize(&Binding->Lookup);
-    QuicDispatchLockUninitialize(&Binding->StatelessOperLock);
-    QuicHashtableUninitialize(&Binding->StatelessOperTable);
+    for (uint32_t i = 0; i < QUIC_STATELESS_OPER_SHARD_COUNT; i++) {
+        QuicDispatchLockUninitialize(&Binding->StatelessOperShards[i].Lock);
+        QuicHashtableUninitialize(&Binding->StatelessOperShards[i].Table);
+    }
+    QuicDispatchLockUninitialize(&Binding->StatelessAdmitLock);
     QuicDispatchLockUninitialize(&Binding->ResetTokenLock);
     QuicDispatchRwLockUninitialize(&Binding->RwLock);
 
@@ -325,6 +379,29 @@ QuicBindingRegisterListener(
             continue;
         }
 
+        //
+        // Within an address group, SNI-filtered listeners sort before
+        // unfiltered ones so that lookup finds the most specific match first
+        // and the unfiltered listener serves as the fallback. Listeners with
+        // different filters are separate tenants and can share an ALPN.
+        //
+        if (NewListener->ServerName != NULL &&
+            ExistingListener->ServerName == NULL) {
+            break; // Insert before the unfiltered listeners.
+        }
+        if (NewListener->ServerName == NULL &&
+            ExistingListener->ServerName != NULL) {
+            continue;
+        }
+        if (NewListener->ServerName != NULL &&
+            (NewListener->ServerNameLength != ExistingListener->ServerNameLength ||
+             _strnicmp(
+                NewListener->ServerName,
+                ExistingListener->ServerName,
+                NewListener->ServerNameLength) != 0)) {
+            continue;
+        }
+
         if (QuicSessionHasAlpnOverlap(NewListener->Session, ExistingListener->Session)) {
             QuicTraceLogWarning(
                 BindingListenerAlreadyRegistered,
@@ -397,6 +474,16 @@ QuicBindingGetListener(
             }
         }
 
+        if (ExistingListener->ServerName != NULL &&
+            (Info->ServerName == NULL ||
+             Info->ServerNameLength != ExistingListener->ServerNameLength ||
+             _strnicmp(
+                Info->ServerName,
+                ExistingListener->ServerName,
+                ExistingListener->ServerNameLength) != 0)) {
+            continue; // No SNI match.
+        }
+
         if (QuicSessionMatchesAlpn(ExistingListener->Session, Info)) {
             if (QuicRundownAcquire(&ExistingListener->Rundown)) {
                 Listener = ExistingListener;
@@ -434,6 +521,17 @@ QuicBindingAddSourceConnectionID(
     return QuicLookupAddLocalCid(&Binding->Lookup, SourceCid, NULL);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint8_t
+QuicBindingAddSourceConnectionIDs(
+    _In_ QUIC_BINDING* Binding,
+    _In_reads_(Count) QUIC_CID_HASH_ENTRY** SourceCids,
+    _In_ uint8_t Count
+    )
+{
+    return QuicLookupAddLocalCids(&Binding->Lookup, SourceCids, Count);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
 QuicBindingRemoveSourceConnectionID(
@@ -481,6 +579,22 @@ QuicBindingOnConnectionHandshakeConfirmed(
     }
 }
 
+//
+// Returns the stateless operation tracking shard responsible for the given
+// remote address hash.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATELESS_OPER_SHARD*
+QuicBindingGetStatelessOperShard(
+    _In_ QUIC_BINDING* Binding,
+    _In_ uint32_t Hash
+    )
+{
+    return
+        &Binding->StatelessOperShards[
+            Hash & (QUIC_STATELESS_OPER_SHARD_COUNT - 1)];
+}
+
 //
 // This attempts to add a new stateless operation (for a given remote endpoint)
 // to the tracking structures in the binding. It first ages out any old
@@ -498,17 +612,19 @@ QuicBindingCreateStatelessOperation(
     uint32_t TimeMs = QuicTimeMs32();
     const QUIC_ADDR* RemoteAddress = &Datagram->Tuple->RemoteAddress;
     uint32_t Hash = QuicAddrHash(RemoteAddress);
+    QUIC_STATELESS_OPER_SHARD* Shard =
+        QuicBindingGetStatelessOperShard(Binding, Hash);
     QUIC_STATELESS_CONTEXT* StatelessCtx = NULL;
 
-    QuicDispatchLockAcquire(&Binding->StatelessOperLock);
+    QuicDispatchLockAcquire(&Shard->Lock);
 
     //
     // Age out all expired operation contexts.
     //
-    while (!QuicListIsEmpty(&Binding->StatelessOperList)) {
+    while (!QuicListIsEmpty(&Shard->List)) {
         QUIC_STATELESS_CONTEXT* OldStatelessCtx =
             QUIC_CONTAINING_RECORD(
-                Binding->StatelessOperList.Flink,
+                Shard->List.Flink,
                 QUIC_STATELESS_CONTEXT,
                 ListEntry);
 
@@ -522,11 +638,11 @@ QuicBindingCreateStatelessOperation(
         //
         OldStatelessCtx->IsExpired = TRUE;
         QuicHashtableRemove(
-            &Binding->StatelessOperTable,
+            &Shard->Table,
             &OldStatelessCtx->TableEntry,
             NULL);
         QuicListEntryRemove(&OldStatelessCtx->ListEntry);
-        Binding->StatelessOperCount--;
+        Shard->Count--;
 
         //
         // If it's also processed, free it.
@@ -538,7 +654,8 @@ QuicBindingCreateStatelessOperation(
         }
     }
 
-    if (Binding->StatelessOperCount >= QUIC_MAX_BINDING_STATELESS_OPERATIONS) {
+    if (Shard->Count >=
+        QUIC_MAX_BINDING_STATELESS_OPERATIONS / QUIC_STATELESS_OPER_SHARD_COUNT) {
         QuicPacketLogDrop(Binding, QuicDataPathRecvDatagramToRecvPacket(Datagram),
             "Max binding operations reached");
         goto Exit;
@@ -550,7 +667,7 @@ QuicBindingCreateStatelessOperation(
 
     QUIC_HASHTABLE_LOOKUP_CONTEXT Context;
     QUIC_HASHTABLE_ENTRY* TableEntry =
-        QuicHashtableLookup(&Binding->StatelessOperTable, Hash, &Context);
+        QuicHashtableLookup(&Shard->Table, Hash, &Context);
 
     while (TableEntry != NULL) {
         const QUIC_STATELESS_CONTEXT* ExistingCtx =
@@ -563,7 +680,7 @@ QuicBindingCreateStatelessOperation(
         }
 
         TableEntry =
-            QuicHashtableLookupNext(&Binding->StatelessOperTable, &Context);
+            QuicHashtableLookupNext(&Shard->Table, &Context);
     }
 
     //
@@ -588,25 +705,65 @@ QuicBindingCreateStatelessOperation(
     QuicCopyMemory(&StatelessCtx->RemoteAddress, RemoteAddress, sizeof(QUIC_ADDR));
 
     QuicHashtableInsert(
-        &Binding->StatelessOperTable,
+        &Shard->Table,
         &StatelessCtx->TableEntry,
         Hash,
         NULL); // TODO - Context?
 
     QuicListInsertTail(
-        &Binding->StatelessOperList,
+        &Shard->List,
         &StatelessCtx->ListEntry
         );
 
-    Binding->StatelessOperCount++;
+    Shard->Count++;
 
 Exit:
 
-    QuicDispatchLockRelease(&Binding->StatelessOperLock);
+    QuicDispatchLockRelease(&Shard->Lock);
 
     return StatelessCtx;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicBindingAdmitStatelessResponse(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_STATELESS_CLASS Class
+    )
+{
+    QUIC_DBG_ASSERT(Class < QUIC_STATELESS_CLASS_COUNT);
+
+    uint64_t TimeNow = QuicTimeUs64();
+    BOOLEAN Admit = FALSE;
+
+    QuicDispatchLockAcquire(&Binding->StatelessAdmitLock);
+
+    //
+    // The refill timestamp only advances when at least one whole token has
+    // accrued, so fractional progress is never rounded away.
+    //
+    uint64_t NewTokens =
+        QuicTimeDiff64(
+            Binding->StatelessAdmit[Class].LastRefillTimeUs, TimeNow) *
+        QuicStatelessAdmitParams[Class].RatePerSecond / 1000000;
+    if (NewTokens != 0) {
+        Binding->StatelessAdmit[Class].Tokens =
+            (uint32_t)min(
+                Binding->StatelessAdmit[Class].Tokens + NewTokens,
+                QuicStatelessAdmitParams[Class].Burst);
+        Binding->StatelessAdmit[Class].LastRefillTimeUs = TimeNow;
+    }
+
+    if (Binding->StatelessAdmit[Class].Tokens != 0) {
+        Binding->StatelessAdmit[Class].Tokens--;
+        Admit = TRUE;
+    }
+
+    QuicDispatchLockRelease(&Binding->StatelessAdmitLock);
+
+    return Admit;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicBindingQueueStatelessOperation(
@@ -664,10 +821,6 @@ QuicBindingProcessStatelessOperation(
 {
     QUIC_BINDING* Binding = StatelessCtx->Binding;
     QUIC_RECV_DATAGRAM* RecvDatagram = StatelessCtx->Datagram;
-    QUIC_RECV_PACKET* RecvPacket =
-        QuicDataPathRecvDatagramToRecvPacket(RecvDatagram);
-
-    QUIC_DBG_ASSERT(RecvPacket->ValidatedHeaderInv);
 
     QuicTraceEvent(
         BindingExecOper,
@@ -675,241 +828,263 @@ QuicBindingProcessStatelessOperation(
         Binding,
         OperationType);
 
+    if (OperationType == QUIC_OPER_TYPE_RETRY) {
+        //
+        // Retries only end up on a worker when the datapath fast path found
+        // the current stateless retry key expired. Create a new key (only
+        // possible at passive level) and then send the same way the fast path
+        // does.
+        //
+        QuicDispatchLockAcquire(&MsQuicLib.StatelessRetryKeysLock);
+        QUIC_KEY* StatelessRetryKey = QuicLibraryGetCurrentStatelessRetryKey();
+        QuicDispatchLockRelease(&MsQuicLib.StatelessRetryKeysLock);
+
+        if (StatelessRetryKey != NULL) {
+            (void)QuicBindingSendRetry(Binding, RecvDatagram);
+        }
+    } else {
+        //
+        // Version negotiation and stateless reset packets are built directly
+        // on the datapath threads and never reach a worker.
+        //
+        QUIC_TEL_ASSERT(FALSE); // Should be unreachable code.
+    }
+}
+
+//
+// Refills (once per period) and consumes from the binding's stateless
+// response token bucket. Returns TRUE if the caller may send a response.
+// Runs lock free on the datapath threads; during floods the bucket empties
+// and the excess packets are simply dropped.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicBindingConsumeStatelessResponseToken(
+    _In_ QUIC_BINDING* Binding
+    )
+{
+    long TimeNow = (long)QuicTimeMs32();
+    long LastFill = Binding->StatelessResponseLastFillTimeMs;
+    if (QuicTimeDiff32((uint32_t)LastFill, (uint32_t)TimeNow) >=
+            QUIC_STATELESS_RESPONSE_BUCKET_PERIOD_MS &&
+        InterlockedCompareExchange(
+            &Binding->StatelessResponseLastFillTimeMs,
+            TimeNow,
+            LastFill) == LastFill) {
+        InterlockedExchange(
+            &Binding->StatelessResponseTokens,
+            QUIC_STATELESS_RESPONSE_BUCKET_TOKENS);
+    }
+    return InterlockedDecrement(&Binding->StatelessResponseTokens) >= 0;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBindingSendVersionNegotiation(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_RECV_DATAGRAM* Datagram
+    )
+{
+    QUIC_RECV_PACKET* RecvPacket =
+        QuicDataPathRecvDatagramToRecvPacket(Datagram);
+
+    QUIC_DBG_ASSERT(RecvPacket->ValidatedHeaderInv);
+    QUIC_DBG_ASSERT(RecvPacket->DestCid != NULL);
+    QUIC_DBG_ASSERT(RecvPacket->SourceCid != NULL);
+
+    if (!QuicBindingConsumeStatelessResponseToken(Binding)) {
+        QuicPacketLogDrop(Binding, RecvPacket, "VN rate limited");
+        return;
+    }
+
     QUIC_DATAPATH_SEND_CONTEXT* SendContext =
         QuicDataPathBindingAllocSendContext(Binding->DatapathBinding, 0);
     if (SendContext == NULL) {
         QuicTraceEvent(
             AllocFailure,
             "Allocation of '%s' failed. (%llu bytes)",
-            "stateless send context",
+            "vn send context",
             0);
-        goto Exit;
+        return;
     }
 
-    if (OperationType == QUIC_OPER_TYPE_VERSION_NEGOTIATION) {
-
-        QUIC_DBG_ASSERT(RecvPacket->DestCid != NULL);
-        QUIC_DBG_ASSERT(RecvPacket->SourceCid != NULL);
-
-        uint16_t PacketLength =
-            sizeof(QUIC_VERSION_NEGOTIATION_PACKET) +   // Header
-            RecvPacket->SourceCidLen +
-            sizeof(uint8_t) +
-            RecvPacket->DestCidLen +
-            sizeof(uint32_t) +                          // One random version
-            sizeof(QuicSupportedVersionList);           // Our actual supported versions
+    uint16_t PacketLength =
+        sizeof(QUIC_VERSION_NEGOTIATION_PACKET) +   // Header
+        RecvPacket->SourceCidLen +
+        sizeof(uint8_t) +
+        RecvPacket->DestCidLen +
+        sizeof(Binding->VerNegVersions);            // Preformatted version list
 
-        QUIC_BUFFER* SendDatagram =
-            QuicDataPathBindingAllocSendDatagram(SendContext, PacketLength);
-        if (SendDatagram == NULL) {
-            QuicTraceEvent(
-                AllocFailure,
-                "Allocation of '%s' failed. (%llu bytes)",
-                "vn datagram",
-                PacketLength);
-            goto Exit;
-        }
+    QUIC_BUFFER* SendDatagram =
+        QuicDataPathBindingAllocSendDatagram(SendContext, PacketLength);
+    if (SendDatagram == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "vn datagram",
+            PacketLength);
+        QuicDataPathBindingFreeSendContext(SendContext);
+        return;
+    }
 
-        QUIC_VERSION_NEGOTIATION_PACKET* VerNeg =
-            (QUIC_VERSION_NEGOTIATION_PACKET*)SendDatagram->Buffer;
-        QUIC_DBG_ASSERT(SendDatagram->Length == PacketLength);
-
-        VerNeg->IsLongHeader = TRUE;
-        VerNeg->Version = QUIC_VERSION_VER_NEG;
-
-        uint8_t* Buffer = VerNeg->DestCid;
-        VerNeg->DestCidLength = RecvPacket->SourceCidLen;
-        memcpy(
-            Buffer,
-            RecvPacket->SourceCid,
-            RecvPacket->SourceCidLen);
-        Buffer += RecvPacket->SourceCidLen;
-
-        *Buffer = RecvPacket->DestCidLen;
-        Buffer++;
-        memcpy(
-            Buffer,
-            RecvPacket->DestCid,
-            RecvPacket->DestCidLen);
-        Buffer += RecvPacket->DestCidLen;
-
-        uint8_t RandomValue = 0;
-        QuicRandom(sizeof(uint8_t), &RandomValue);
-        VerNeg->Unused = 0x7F & RandomValue;
-
-        uint32_t* SupportedVersion = (uint32_t*)Buffer;
-        SupportedVersion[0] = Binding->RandomReservedVersion;
-        QuicCopyMemory(
-            &SupportedVersion[1],
-            QuicSupportedVersionList,
-            sizeof(QuicSupportedVersionList));
+    QUIC_VERSION_NEGOTIATION_PACKET* VerNeg =
+        (QUIC_VERSION_NEGOTIATION_PACKET*)SendDatagram->Buffer;
+    QUIC_DBG_ASSERT(SendDatagram->Length == PacketLength);
+
+    VerNeg->IsLongHeader = TRUE;
+    VerNeg->Version = QUIC_VERSION_VER_NEG;
+
+    uint8_t* Buffer = VerNeg->DestCid;
+    VerNeg->DestCidLength = RecvPacket->SourceCidLen;
+    memcpy(
+        Buffer,
+        RecvPacket->SourceCid,
+        RecvPacket->SourceCidLen);
+    Buffer += RecvPacket->SourceCidLen;
+
+    *Buffer = RecvPacket->DestCidLen;
+    Buffer++;
+    memcpy(
+        Buffer,
+        RecvPacket->DestCid,
+        RecvPacket->DestCidLen);
+    Buffer += RecvPacket->DestCidLen;
+
+    uint8_t RandomValue = 0;
+    QuicRandom(sizeof(uint8_t), &RandomValue);
+    VerNeg->Unused = 0x7F & RandomValue;
+
+    QuicCopyMemory(
+        Buffer,
+        Binding->VerNegVersions,
+        sizeof(Binding->VerNegVersions));
+
+    QuicTraceLogVerbose(
+        PacketTxVersionNegotiation,
+        "[S][TX][-] VN");
 
-        QuicTraceLogVerbose(
-            PacketTxVersionNegotiation,
-            "[S][TX][-] VN");
+    QuicBindingSendFromTo(
+        Binding,
+        &Datagram->Tuple->LocalAddress,
+        &Datagram->Tuple->RemoteAddress,
+        NULL,
+        SendContext);
+}
 
-    } else if (OperationType == QUIC_OPER_TYPE_STATELESS_RESET) {
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBindingSendStatelessReset(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_RECV_DATAGRAM* Datagram
+    )
+{
+    QUIC_RECV_PACKET* RecvPacket =
+        QuicDataPathRecvDatagramToRecvPacket(Datagram);
 
-        QUIC_DBG_ASSERT(RecvPacket->DestCid != NULL);
-        QUIC_DBG_ASSERT(RecvPacket->SourceCid == NULL);
+    QUIC_DBG_ASSERT(RecvPacket->ValidatedHeaderInv);
+    QUIC_DBG_ASSERT(RecvPacket->DestCid != NULL);
+    QUIC_DBG_ASSERT(RecvPacket->SourceCid == NULL);
 
-        //
-        // There are a few requirements for sending stateless reset packets:
-        //
-        //   - It must be smaller than the received packet.
-        //   - It must be larger than a spec defined minimum (39 bytes).
-        //   - It must be sufficiently random so that a middle box cannot easily
-        //     detect that it is a stateless reset packet.
-        //
+    if (Datagram->BufferLength <= QUIC_MIN_STATELESS_RESET_PACKET_LENGTH) {
+        QuicPacketLogDrop(Binding, RecvPacket,
+            "Packet too short for stateless reset");
+        return;
+    }
 
+    if (Binding->Exclusive) {
         //
-        // Add a bit of randomness (3 bits worth) to the packet length.
+        // Can't support stateless reset in exclusive mode, because we don't
+        // use a connection ID. Without a connection ID, a stateless reset
+        // token cannot be generated.
         //
-        uint8_t PacketLength;
-        QuicRandom(sizeof(PacketLength), &PacketLength);
-        PacketLength >>= 5; // Only drop 5 of the 8 bits of randomness.
-        PacketLength += QUIC_RECOMMENDED_STATELESS_RESET_PACKET_LENGTH;
-
-        if (PacketLength >= RecvPacket->BufferLength) {
-            //
-            // Can't go over the recieve packet's length.
-            //
-            PacketLength = (uint8_t)RecvPacket->BufferLength - 1;
-        }
-
-        QUIC_DBG_ASSERT(PacketLength >= QUIC_MIN_STATELESS_RESET_PACKET_LENGTH);
-
-        QUIC_BUFFER* SendDatagram =
-            QuicDataPathBindingAllocSendDatagram(SendContext, PacketLength);
-        if (SendDatagram == NULL) {
-            QuicTraceEvent(
-                AllocFailure,
-                "Allocation of '%s' failed. (%llu bytes)",
-                "reset datagram",
-                PacketLength);
-            goto Exit;
-        }
-
-        QUIC_SHORT_HEADER_V1* ResetPacket =
-            (QUIC_SHORT_HEADER_V1*)SendDatagram->Buffer;
-        QUIC_DBG_ASSERT(SendDatagram->Length == PacketLength);
-
-        QuicRandom(
-            PacketLength - QUIC_STATELESS_RESET_TOKEN_LENGTH,
-            SendDatagram->Buffer);
-        ResetPacket->IsLongHeader = FALSE;
-        ResetPacket->FixedBit = 1;
-        ResetPacket->KeyPhase = RecvPacket->SH->KeyPhase;
-        QuicBindingGenerateStatelessResetToken(
-            Binding,
-            RecvPacket->DestCid,
-            SendDatagram->Buffer + PacketLength - QUIC_STATELESS_RESET_TOKEN_LENGTH);
-
-        QuicTraceLogVerbose(
-            PacketTxStatelessReset,
-            "[S][TX][-] SR %s",
-            QuicCidBufToStr(
-                SendDatagram->Buffer + PacketLength - QUIC_STATELESS_RESET_TOKEN_LENGTH,
-                QUIC_STATELESS_RESET_TOKEN_LENGTH
-            ).Buffer);
-
-    } else if (OperationType == QUIC_OPER_TYPE_RETRY) {
-
-        QUIC_DBG_ASSERT(RecvPacket->DestCid != NULL);
-        QUIC_DBG_ASSERT(RecvPacket->SourceCid != NULL);
-
-        uint16_t PacketLength = QuicPacketMaxBufferSizeForRetryV1();
-        QUIC_BUFFER* SendDatagram =
-            QuicDataPathBindingAllocSendDatagram(SendContext, PacketLength);
-        if (SendDatagram == NULL) {
-            QuicTraceEvent(
-                AllocFailure,
-                "Allocation of '%s' failed. (%llu bytes)",
-                "retry datagram",
-                PacketLength);
-            goto Exit;
-        }
-
-        uint8_t NewDestCid[MSQUIC_CID_MAX_LENGTH];
-        QUIC_DBG_ASSERT(sizeof(NewDestCid) >= MsQuicLib.CidTotalLength);
-        QuicRandom(sizeof(NewDestCid), NewDestCid);
-
-        QUIC_RETRY_TOKEN_CONTENTS Token = { 0 };
-        Token.Authenticated.Timestamp = QuicTimeEpochMs64();
+        QuicPacketLogDrop(Binding, RecvPacket,
+            "No stateless reset on exclusive binding");
+        return;
+    }
 
-        Token.Encrypted.RemoteAddress = RecvDatagram->Tuple->RemoteAddress;
-        QuicCopyMemory(Token.Encrypted.OrigConnId, RecvPacket->DestCid, RecvPacket->DestCidLen);
-        Token.Encrypted.OrigConnIdLength = RecvPacket->DestCidLen;
+    if (!QuicBindingConsumeStatelessResponseToken(Binding)) {
+        QuicPacketLogDrop(Binding, RecvPacket, "SR rate limited");
+        return;
+    }
 
-        uint8_t Iv[QUIC_IV_LENGTH];
-        if (MsQuicLib.CidTotalLength >= sizeof(Iv)) {
-            QuicCopyMemory(Iv, NewDestCid, sizeof(Iv));
-            for (uint8_t i = sizeof(Iv); i < MsQuicLib.CidTotalLength; ++i) {
-                Iv[i % sizeof(Iv)] ^= NewDestCid[i];
-            }
-        } else {
-            QuicZeroMemory(Iv, sizeof(Iv));
-            QuicCopyMemory(Iv, NewDestCid, MsQuicLib.CidTotalLength);
-        }
+    QUIC_DATAPATH_SEND_CONTEXT* SendContext =
+        QuicDataPathBindingAllocSendContext(Binding->DatapathBinding, 0);
+    if (SendContext == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "reset send context",
+            0);
+        return;
+    }
 
-        QuicLockAcquire(&MsQuicLib.StatelessRetryKeysLock);
+    //
+    // There are a few requirements for sending stateless reset packets:
+    //
+    //   - It must be smaller than the received packet.
+    //   - It must be larger than a spec defined minimum (39 bytes).
+    //   - It must be sufficiently random so that a middle box cannot easily
+    //     detect that it is a stateless reset packet.
+    //
 
-        QUIC_KEY* StatelessRetryKey = QuicLibraryGetCurrentStatelessRetryKey();
-        if (StatelessRetryKey == NULL) {
-            QuicLockRelease(&MsQuicLib.StatelessRetryKeysLock);
-            goto Exit;
-        }
+    //
+    // Add a bit of randomness (3 bits worth) to the packet length.
+    //
+    uint8_t PacketLength;
+    QuicRandom(sizeof(PacketLength), &PacketLength);
+    PacketLength >>= 5; // Only drop 5 of the 8 bits of randomness.
+    PacketLength += QUIC_RECOMMENDED_STATELESS_RESET_PACKET_LENGTH;
 
-        QUIC_STATUS Status =
-            QuicEncrypt(
-                StatelessRetryKey,
-                Iv,
-                sizeof(Token.Authenticated), (uint8_t*) &Token.Authenticated,
-                sizeof(Token.Encrypted) + sizeof(Token.EncryptionTag), (uint8_t*)&(Token.Encrypted));
+    if (PacketLength >= RecvPacket->BufferLength) {
+        //
+        // Can't go over the recieve packet's length.
+        //
+        PacketLength = (uint8_t)RecvPacket->BufferLength - 1;
+    }
 
-        QuicLockRelease(&MsQuicLib.StatelessRetryKeysLock);
-        if (QUIC_FAILED(Status)) {
-            goto Exit;
-        }
+    QUIC_DBG_ASSERT(PacketLength >= QUIC_MIN_STATELESS_RESET_PACKET_LENGTH);
 
-        SendDatagram->Length =
-            QuicPacketEncodeRetryV1(
-                RecvPacket->LH->Version,
-                RecvPacket->SourceCid, RecvPacket->SourceCidLen,
-                NewDestCid, MsQuicLib.CidTotalLength,
-                RecvPacket->DestCid, RecvPacket->DestCidLen,
-                sizeof(Token),
-                (uint8_t*)&Token,
-                (uint16_t)SendDatagram->Length,
-                (uint8_t*)SendDatagram->Buffer);
-        QUIC_DBG_ASSERT(SendDatagram->Length != 0);
+    QUIC_BUFFER* SendDatagram =
+        QuicDataPathBindingAllocSendDatagram(SendContext, PacketLength);
+    if (SendDatagram == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "reset datagram",
+            PacketLength);
+        QuicDataPathBindingFreeSendContext(SendContext);
+        return;
+    }
 
-        QuicTraceLogVerbose(
-            PacketTxRetry,
-            "[S][TX][-] LH Ver:0x%x DestCid:%s SrcCid:%s Type:R OrigDestCid:%s (Token %hu bytes)",
-            RecvPacket->LH->Version,
-            QuicCidBufToStr(RecvPacket->SourceCid, RecvPacket->SourceCidLen).Buffer,
-            QuicCidBufToStr(NewDestCid, MsQuicLib.CidTotalLength).Buffer,
-            QuicCidBufToStr(RecvPacket->DestCid, RecvPacket->DestCidLen).Buffer,
-            (uint16_t)sizeof(Token));
+    QUIC_SHORT_HEADER_V1* ResetPacket =
+        (QUIC_SHORT_HEADER_V1*)SendDatagram->Buffer;
+    QUIC_DBG_ASSERT(SendDatagram->Length == PacketLength);
+
+    QuicRandom(
+        PacketLength - QUIC_STATELESS_RESET_TOKEN_LENGTH,
+        SendDatagram->Buffer);
+    ResetPacket->IsLongHeader = FALSE;
+    ResetPacket->FixedBit = 1;
+    ResetPacket->KeyPhase = RecvPacket->SH->KeyPhase;
+    QuicBindingGenerateStatelessResetToken(
+        Binding,
+        RecvPacket->DestCid,
+        SendDatagram->Buffer + PacketLength - QUIC_STATELESS_RESET_TOKEN_LENGTH);
 
-    } else {
-        QUIC_TEL_ASSERT(FALSE); // Should be unreachable code.
-        goto Exit;
-    }
+    QuicTraceLogVerbose(
+        PacketTxStatelessReset,
+        "[S][TX][-] SR %s",
+        QuicCidBufToStr(
+            SendDatagram->Buffer + PacketLength - QUIC_STATELESS_RESET_TOKEN_LENGTH,
+            QUIC_STATELESS_RESET_TOKEN_LENGTH
+        ).Buffer);
 
     QuicBindingSendFromTo(
         Binding,
-        &RecvDatagram->Tuple->LocalAddress,
-        &RecvDatagram->Tuple->RemoteAddress,
+        &Datagram->Tuple->LocalAddress,
+        &Datagram->Tuple->RemoteAddress,
+        NULL,
         SendContext);
-    SendContext = NULL;
-
-Exit:
-
-    if (SendContext != NULL) {
-        QuicDataPathBindingFreeSendContext(SendContext);
-    }
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -920,18 +1095,21 @@ QuicBindingReleaseStatelessOperation(
     )
 {
     QUIC_BINDING* Binding = StatelessCtx->Binding;
+    QUIC_STATELESS_OPER_SHARD* Shard =
+        QuicBindingGetStatelessOperShard(
+            Binding, QuicAddrHash(&StatelessCtx->RemoteAddress));
 
     if (ReturnDatagram) {
         QuicDataPathBindingReturnRecvDatagrams(StatelessCtx->Datagram);
     }
     StatelessCtx->Datagram = NULL;
 
-    QuicDispatchLockAcquire(&Binding->StatelessOperLock);
+    QuicDispatchLockAcquire(&Shard->Lock);
 
     StatelessCtx->IsProcessed = TRUE;
     uint8_t FreeCtx = StatelessCtx->IsExpired;
 
-    QuicDispatchLockRelease(&Binding->StatelessOperLock);
+    QuicDispatchLockRelease(&Shard->Lock);
 
     if (StatelessCtx->HasBindingRef) {
         QuicLibraryReleaseBinding(Binding);
@@ -946,34 +1124,122 @@ QuicBindingReleaseStatelessOperation(
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
-QuicBindingQueueStatelessReset(
+QuicBindingSendRetry(
     _In_ QUIC_BINDING* Binding,
     _In_ QUIC_RECV_DATAGRAM* Datagram
     )
 {
-    QUIC_DBG_ASSERT(!Binding->Exclusive);
-    QUIC_DBG_ASSERT(!((QUIC_SHORT_HEADER_V1*)Datagram->Buffer)->IsLongHeader);
+    QUIC_RECV_PACKET* RecvPacket =
+        QuicDataPathRecvDatagramToRecvPacket(Datagram);
 
-    if (Datagram->BufferLength <= QUIC_MIN_STATELESS_RESET_PACKET_LENGTH) {
-        QuicPacketLogDrop(Binding, QuicDataPathRecvDatagramToRecvPacket(Datagram),
-            "Packet too short for stateless reset");
-        return FALSE;
+    QUIC_DBG_ASSERT(RecvPacket->ValidatedHeaderInv);
+    QUIC_DBG_ASSERT(RecvPacket->DestCid != NULL);
+    QUIC_DBG_ASSERT(RecvPacket->SourceCid != NULL);
+
+    uint8_t NewDestCid[MSQUIC_CID_MAX_LENGTH];
+    QUIC_DBG_ASSERT(sizeof(NewDestCid) >= MsQuicLib.CidTotalLength);
+    QuicRandom(sizeof(NewDestCid), NewDestCid);
+
+    QUIC_RETRY_TOKEN_CONTENTS Token = { 0 };
+    Token.Authenticated.Timestamp = QuicTimeEpochMs64();
+
+    Token.Encrypted.RemoteAddress = Datagram->Tuple->RemoteAddress;
+    QuicCopyMemory(Token.Encrypted.OrigConnId, RecvPacket->DestCid, RecvPacket->DestCidLen);
+    Token.Encrypted.OrigConnIdLength = RecvPacket->DestCidLen;
+
+    uint8_t Iv[QUIC_IV_LENGTH];
+    if (MsQuicLib.CidTotalLength >= sizeof(Iv)) {
+        QuicCopyMemory(Iv, NewDestCid, sizeof(Iv));
+        for (uint8_t i = sizeof(Iv); i < MsQuicLib.CidTotalLength; ++i) {
+            Iv[i % sizeof(Iv)] ^= NewDestCid[i];
+        }
+    } else {
+        QuicZeroMemory(Iv, sizeof(Iv));
+        QuicCopyMemory(Iv, NewDestCid, MsQuicLib.CidTotalLength);
     }
 
-    if (Binding->Exclusive) {
-        //
-        // Can't support stateless reset in exclusive mode, because we don't use
-        // a connection ID. Without a connection ID, a stateless reset token
-        // cannot be generated.
-        //
-        QuicPacketLogDrop(Binding, QuicDataPathRecvDatagramToRecvPacket(Datagram),
-            "No stateless reset on exclusive binding");
+    QUIC_DATAPATH_SEND_CONTEXT* SendContext =
+        QuicDataPathBindingAllocSendContext(Binding->DatapathBinding, 0);
+    if (SendContext == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "retry send context",
+            0);
+        return TRUE; // Dropped, but handled.
+    }
+
+    uint16_t PacketLength = QuicPacketMaxBufferSizeForRetryV1();
+    QUIC_BUFFER* SendDatagram =
+        QuicDataPathBindingAllocSendDatagram(SendContext, PacketLength);
+    if (SendDatagram == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "retry datagram",
+            PacketLength);
+        QuicDataPathBindingFreeSendContext(SendContext);
+        return TRUE; // Dropped, but handled.
+    }
+
+    QuicDispatchLockAcquire(&MsQuicLib.StatelessRetryKeysLock);
+
+    //
+    // Look up (but never create, so this can run on the datapath) the retry
+    // key for the token's timestamp. If it has expired, the caller must queue
+    // the retry to a worker to create a new key at passive level.
+    //
+    QUIC_KEY* StatelessRetryKey =
+        QuicLibraryGetStatelessRetryKeyForTimestamp(
+            (int64_t)Token.Authenticated.Timestamp);
+    if (StatelessRetryKey == NULL) {
+        QuicDispatchLockRelease(&MsQuicLib.StatelessRetryKeysLock);
+        QuicDataPathBindingFreeSendContext(SendContext);
         return FALSE;
     }
 
-    return
-        QuicBindingQueueStatelessOperation(
-            Binding, QUIC_OPER_TYPE_STATELESS_RESET, Datagram);
+    QUIC_STATUS Status =
+        QuicEncrypt(
+            StatelessRetryKey,
+            Iv,
+            sizeof(Token.Authenticated), (uint8_t*) &Token.Authenticated,
+            sizeof(Token.Encrypted) + sizeof(Token.EncryptionTag), (uint8_t*)&(Token.Encrypted));
+
+    QuicDispatchLockRelease(&MsQuicLib.StatelessRetryKeysLock);
+    if (QUIC_FAILED(Status)) {
+        QuicDataPathBindingFreeSendContext(SendContext);
+        return TRUE; // Dropped, but handled.
+    }
+
+    SendDatagram->Length =
+        QuicPacketEncodeRetryV1(
+            RecvPacket->LH->Version,
+            RecvPacket->SourceCid, RecvPacket->SourceCidLen,
+            NewDestCid, MsQuicLib.CidTotalLength,
+            RecvPacket->DestCid, RecvPacket->DestCidLen,
+            sizeof(Token),
+            (uint8_t*)&Token,
+            (uint16_t)SendDatagram->Length,
+            (uint8_t*)SendDatagram->Buffer);
+    QUIC_DBG_ASSERT(SendDatagram->Length != 0);
+
+    QuicTraceLogVerbose(
+        PacketTxRetry,
+        "[S][TX][-] LH Ver:0x%x DestCid:%s SrcCid:%s Type:R OrigDestCid:%s (Token %hu bytes)",
+        RecvPacket->LH->Version,
+        QuicCidBufToStr(RecvPacket->SourceCid, RecvPacket->SourceCidLen).Buffer,
+        QuicCidBufToStr(NewDestCid, MsQuicLib.CidTotalLength).Buffer,
+        QuicCidBufToStr(RecvPacket->DestCid, RecvPacket->DestCidLen).Buffer,
+        (uint16_t)sizeof(Token));
+
+    QuicBindingSendFromTo(
+        Binding,
+        &Datagram->Tuple->LocalAddress,
+        &Datagram->Tuple->RemoteAddress,
+        NULL,
+        SendContext);
+
+    return TRUE;
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -1008,10 +1274,16 @@ QuicBindingPreprocessDatagram(
         if (!QuicIsVersionSupported(Packet->Invariant->LONG_HDR.Version)) {
             if (!QuicBindingHasListenerRegistered(Binding)) {
                 QuicPacketLogDrop(Binding, Packet, "No listener to send VN");
+            } else if (
+                !QuicBindingAdmitStatelessResponse(
+                    Binding, QUIC_STATELESS_CLASS_VER_NEG)) {
+                QuicPacketLogDrop(Binding, Packet, "VN rate limited");
             } else {
-                *ReleaseDatagram =
-                    !QuicBindingQueueStatelessOperation(
-                        Binding, QUIC_OPER_TYPE_VERSION_NEGOTIATION, Datagram);
+                //
+                // The version negotiation packet is built and sent directly
+                // on the datapath thread, so the datagram is always released.
+                //
+                QuicBindingSendVersionNegotiation(Binding, Datagram);
             }
             return FALSE;
         }
@@ -1191,7 +1463,7 @@ QuicBindingCreateConnection(
 Exit:
 
     NewConnection->SourceCids.Next = NULL;
-    QUIC_FREE(SourceCid);
+    QuicCidFreeSource(SourceCid);
     QuicConnRelease(NewConnection, QUIC_CONN_REF_LOOKUP_RESULT);
 
     if (BindingRefAdded) {
@@ -1304,9 +1576,17 @@ QuicBindingDeliverDatagrams(
         if (Packet->IsShortHeader) {
             //
             // For unattributed short header packets we can try to send a
-            // stateless reset back in response.
+            // stateless reset back in response. The reset is built and sent
+            // directly on the datapath thread, so the datagram is always
+            // released.
             //
-            return QuicBindingQueueStatelessReset(Binding, DatagramChain);
+            if (QuicBindingAdmitStatelessResponse(
+                    Binding, QUIC_STATELESS_CLASS_RESET)) {
+                QuicBindingSendStatelessReset(Binding, DatagramChain);
+            } else {
+                QuicPacketLogDrop(Binding, Packet, "Stateless reset rate limited");
+            }
+            return FALSE;
         }
 
         if (Packet->Invariant->LONG_HDR.Version == QUIC_VERSION_VER_NEG) {
@@ -1356,6 +1636,21 @@ QuicBindingDeliverDatagrams(
         BOOLEAN DropPacket = FALSE;
         if (QuicBindingShouldRetryConnection(
                 Binding, Packet, TokenLength, Token, &DropPacket)) {
+            //
+            // Send the retry directly on the datapath thread. Under Initial
+            // floods this is the hot path, so skipping the worker hop and
+            // the per-operation allocations matters. Only fall back to a
+            // worker when the retry key has expired and a new one needs to
+            // be created at passive level.
+            //
+            if (!QuicBindingAdmitStatelessResponse(
+                    Binding, QUIC_STATELESS_CLASS_RETRY)) {
+                QuicPacketLogDrop(Binding, Packet, "Retry rate limited");
+                return FALSE;
+            }
+            if (QuicBindingSendRetry(Binding, DatagramChain)) {
+                return FALSE;
+            }
             return
                 QuicBindingQueueStatelessOperation(
                     Binding, QUIC_OPER_TYPE_RETRY, DatagramChain);
@@ -1394,6 +1689,8 @@ QuicBindingReceive(
     QUIC_RECV_DATAGRAM** SubChainTail = &SubChain;
     QUIC_RECV_DATAGRAM** SubChainDataTail = &SubChain;
     uint32_t SubChainLength = 0;
+    uint32_t TotalChainLength = 0;
+    uint64_t TotalDatagramBytes = 0;
 
     //
     // Breaks the chain of datagrams into subchains by destination CID and
@@ -1404,15 +1701,43 @@ QuicBindingReceive(
     // code will check that each packet has a destination CID matching the
     // connection it was delivered to.
     //
+    // The chain is flattened into an array of datagram pointers a batch at a
+    // time before the validation work runs, so the per-datagram processing
+    // below iterates an array instead of chasing Next pointers, and the next
+    // datagram's payload can be prefetched while the current one is parsed.
+    //
+
+    QUIC_RECV_DATAGRAM* Batch[QUIC_RECEIVE_FLATTEN_BATCH_SIZE];
+    uint32_t BatchCount = 0;
+    uint32_t BatchIndex = 0;
 
     QUIC_RECV_DATAGRAM* Datagram;
-    while ((Datagram = DatagramChain) != NULL) {
+    for (;;) {
 
-        //
-        // Remove the head.
-        //
-        DatagramChain = Datagram->Next;
+        if (BatchIndex == BatchCount) {
+            //
+            // Refill the array with the next run of the chain. This loop does
+            // nothing but walk the links, so it streams through the chain as
+            // fast as the dependent loads allow.
+            //
+            BatchCount = 0;
+            BatchIndex = 0;
+            while (DatagramChain != NULL && BatchCount < ARRAYSIZE(Batch)) {
+                Batch[BatchCount++] = DatagramChain;
+                DatagramChain = DatagramChain->Next;
+            }
+            if (BatchCount == 0) {
+                break;
+            }
+        }
+
+        Datagram = Batch[BatchIndex++];
         Datagram->Next = NULL;
+        if (BatchIndex < BatchCount) {
+            QuicPrefetchForRead(Batch[BatchIndex]->Buffer);
+        }
+        TotalChainLength++;
+        TotalDatagramBytes += Datagram->BufferLength;
 
         //
         // Perform initial validation.
@@ -1443,7 +1768,7 @@ QuicBindingReceive(
                 NULL : QuicDataPathRecvDatagramToRecvPacket(SubChain);
         if (!Binding->Exclusive && SubChain != NULL &&
             (Packet->DestCidLen != SubChainPacket->DestCidLen ||
-             memcmp(Packet->DestCid, SubChainPacket->DestCid, Packet->DestCidLen) != 0)) {
+             !QuicCidEqual(Packet->DestCid, SubChainPacket->DestCid, Packet->DestCidLen))) {
             if (!QuicBindingDeliverDatagrams(Binding, SubChain, SubChainLength)) {
                 *ReleaseChainTail = SubChain;
                 ReleaseChainTail = SubChainDataTail;
@@ -1492,6 +1817,9 @@ QuicBindingReceive(
     if (ReleaseChain != NULL) {
         QuicDataPathBindingReturnRecvDatagrams(ReleaseChain);
     }
+
+    QuicPerfCounterAdd(QUIC_PERF_COUNTER_PKTS_RECV, TotalChainLength);
+    QuicPerfCounterAdd(QUIC_PERF_COUNTER_BYTES_RECV, TotalDatagramBytes);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -1565,6 +1893,7 @@ QuicBindingSendFromTo(
     _In_ QUIC_BINDING* Binding,
     _In_ const QUIC_ADDR * LocalAddress,
     _In_ const QUIC_ADDR * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     )
 {
@@ -1578,6 +1907,7 @@ QuicBindingSendFromTo(
                 Binding->DatapathBinding,
                 LocalAddress,
                 RemoteAddress,
+                SendCache,
                 SendContext);
         if (QUIC_FAILED(Status)) {
             QuicTraceLogWarning(
@@ -1615,7 +1945,33 @@ QuicBindingGenerateStatelessResetToken(
     )
 {
     uint8_t HashOutput[QUIC_HASH_SHA256_SIZE];
+    uint32_t CacheIndex =
+        QuicHashSimple(MsQuicLib.CidTotalLength, CID) &
+        (QUIC_STATELESS_RESET_TOKEN_CACHE_SIZE - 1);
+
     QuicDispatchLockAcquire(&Binding->ResetTokenLock);
+
+    //
+    // Check the token cache first. Tokens are deterministic per-CID, so a hit
+    // skips the hash computation entirely. This matters on the receive miss
+    // path, where repeated probes of dead connections would otherwise pay for
+    // a fresh hash on every packet. The CIDs are public data, so a simple
+    // memcmp comparison is fine here.
+    //
+    if (Binding->ResetTokenCache[CacheIndex].CidLength ==
+            MsQuicLib.CidTotalLength &&
+        memcmp(
+            Binding->ResetTokenCache[CacheIndex].Cid,
+            CID,
+            MsQuicLib.CidTotalLength) == 0) {
+        QuicCopyMemory(
+            ResetToken,
+            Binding->ResetTokenCache[CacheIndex].Token,
+            QUIC_STATELESS_RESET_TOKEN_LENGTH);
+        QuicDispatchLockRelease(&Binding->ResetTokenLock);
+        return QUIC_STATUS_SUCCESS;
+    }
+
     QUIC_STATUS Status =
         QuicHashCompute(
             Binding->ResetTokenHash,
@@ -1623,6 +1979,18 @@ QuicBindingGenerateStatelessResetToken(
             MsQuicLib.CidTotalLength,
             sizeof(HashOutput),
             HashOutput);
+    if (QUIC_SUCCEEDED(Status)) {
+        Binding->ResetTokenCache[CacheIndex].CidLength =
+            (uint8_t)MsQuicLib.CidTotalLength;
+        QuicCopyMemory(
+            Binding->ResetTokenCache[CacheIndex].Cid,
+            CID,
+            MsQuicLib.CidTotalLength);
+        QuicCopyMemory(
+            Binding->ResetTokenCache[CacheIndex].Token,
+            HashOutput,
+            QUIC_STATELESS_RESET_TOKEN_LENGTH);
+    }
     QuicDispatchLockRelease(&Binding->ResetTokenLock);
     if (QUIC_SUCCEEDED(Status)) {
         QuicCopyMemory(
@@ -149,10 +149,51 @@ typedef enum QUIC_BINDING_LOOKUP_TYPE {
 
 } QUIC_BINDING_LOOKUP_TYPE;
 
+//
+// Defined in packet.h, which is included after this header; redeclared here
+// so the binding can embed a preformatted copy of the version list.
+//
+extern const uint32_t QuicSupportedVersionList[QUIC_SUPPORTED_VERSION_COUNT];
+
+//
+// A single shard of a binding's stateless operation tracking. The tracking
+// is sharded by remote address hash so that, under attack rates, datagrams
+// from unrelated sources age and insert entries without contending on a
+// single binding-wide lock.
+//
+typedef struct QUIC_STATELESS_OPER_SHARD {
+
+    QUIC_DISPATCH_LOCK Lock;
+
+    //
+    // Entries indexed by remote address, for duplicate suppression.
+    //
+    QUIC_HASHTABLE Table;
+
+    //
+    // Entries in creation time order, for expiration.
+    //
+    QUIC_LIST_ENTRY List;
+
+    uint32_t Count;
+
+} QUIC_STATELESS_OPER_SHARD;
+
 //
 // Represents a UDP binding of local IP address and UDP port, and optionally
 // remote IP address.
 //
+//
+// The classes of stateless responses a binding can send, in increasing order
+// of importance under flood.
+//
+typedef enum QUIC_STATELESS_CLASS {
+    QUIC_STATELESS_CLASS_VER_NEG,
+    QUIC_STATELESS_CLASS_RETRY,
+    QUIC_STATELESS_CLASS_RESET,
+    QUIC_STATELESS_CLASS_COUNT
+} QUIC_STATELESS_CLASS;
+
 typedef struct QUIC_BINDING {
 
     //
@@ -190,6 +231,21 @@ typedef struct QUIC_BINDING {
     //
     uint32_t RandomReservedVersion;
 
+    //
+    // Preformatted version list for version negotiation packets: the random
+    // reserved version followed by QuicSupportedVersionList. Filled once at
+    // initialization so the datapath threads can copy it directly into
+    // outgoing packets.
+    //
+    uint32_t VerNegVersions[1 + ARRAYSIZE(QuicSupportedVersionList)];
+
+    //
+    // Token bucket limiting the stateless responses (version negotiation and
+    // stateless reset) built directly on the datapath threads.
+    //
+    long StatelessResponseTokens;
+    long StatelessResponseLastFillTimeMs;
+
 #ifdef QUIC_COMPARTMENT_ID
     //
     // The network compartment ID.
@@ -224,13 +280,32 @@ typedef struct QUIC_BINDING {
     QUIC_DISPATCH_LOCK ResetTokenLock;
 
     //
-    // Stateless operation tracking structures.
+    // Direct-mapped cache of previously generated stateless reset tokens,
+    // protected by ResetTokenLock. A zero CidLength indicates an empty slot.
+    // Tokens are a pure function of the CID and the per-binding key, so
+    // entries never need to be invalidated, only evicted.
+    //
+    struct {
+        uint8_t CidLength;
+        uint8_t Cid[MSQUIC_CID_MAX_LENGTH];
+        uint8_t Token[QUIC_STATELESS_RESET_TOKEN_LENGTH];
+    } ResetTokenCache[QUIC_STATELESS_RESET_TOKEN_CACHE_SIZE];
+
+    //
+    // Token buckets for admitting stateless responses under load, one per
+    // response class. Protected by StatelessAdmitLock.
+    //
+    QUIC_DISPATCH_LOCK StatelessAdmitLock;
+    struct {
+        uint32_t Tokens;
+        uint64_t LastRefillTimeUs;
+    } StatelessAdmit[QUIC_STATELESS_CLASS_COUNT];
+
+    //
+    // Stateless operation tracking structures, sharded by remote address
+    // hash.
     //
-    QUIC_DISPATCH_LOCK StatelessOperLock;
-    QUIC_HASHTABLE StatelessOperTable;
-    QUIC_LIST_ENTRY StatelessOperList;
-    QUIC_POOL StatelessOperCtxPool;
-    uint32_t StatelessOperCount;
+    QUIC_STATELESS_OPER_SHARD StatelessOperShards[QUIC_STATELESS_OPER_SHARD_COUNT];
 
     struct {
 
@@ -283,6 +358,19 @@ QuicBindingTraceRundown(
     _In_ QUIC_BINDING* Binding
     );
 
+//
+// Takes a token from the given stateless response class's admission bucket.
+// Returns FALSE if the bucket is empty, in which case the response must not
+// be sent. Called on the datapath threads before any allocations are made
+// for the response.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicBindingAdmitStatelessResponse(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_STATELESS_CLASS Class
+    );
+
 //
 // Looks up the listener based on the ALPN list. Optionally, outputs the
 // first ALPN that matches.
@@ -326,6 +414,19 @@ QuicBindingAddSourceConnectionID(
     _In_ QUIC_CID_HASH_ENTRY* SourceCid
     );
 
+//
+// Attempts to insert a batch of the connection's new source CIDs into the
+// binding's lookup table with a single write lock acquisition. Returns the
+// number inserted; uninserted entries are left with IsInLookupTable FALSE.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint8_t
+QuicBindingAddSourceConnectionIDs(
+    _In_ QUIC_BINDING* Binding,
+    _In_reads_(Count) QUIC_CID_HASH_ENTRY** SourceCids,
+    _In_ uint8_t Count
+    );
+
 //
 // Removes a single source CID from the binding's lookup table.
 //
@@ -411,9 +512,47 @@ QuicBindingSendFromTo(
     _In_ QUIC_BINDING* Binding,
     _In_ const QUIC_ADDR * LocalAddress,
     _In_ const QUIC_ADDR * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
+//
+// Attempts to build and send a retry packet for a received Initial directly
+// on the datapath thread, with no per-operation allocation or worker hop.
+// Returns FALSE if the current stateless retry key has expired, in which case
+// the caller should queue the retry to a worker so a new key can be created.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicBindingSendRetry(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_RECV_DATAGRAM* Datagram
+    );
+
+//
+// Builds and sends a version negotiation packet for a received packet of an
+// unsupported version, directly on the datapath thread. Subject to the
+// binding's stateless response token bucket.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBindingSendVersionNegotiation(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_RECV_DATAGRAM* Datagram
+    );
+
+//
+// Builds and sends a stateless reset packet for an unattributed short header
+// packet, directly on the datapath thread. Subject to the binding's stateless
+// response token bucket.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicBindingSendStatelessReset(
+    _In_ QUIC_BINDING* Binding,
+    _In_ QUIC_RECV_DATAGRAM* Datagram
+    );
+
 //
 // Generates a stateless reset token for the given connection ID.
 //
@@ -456,13 +595,13 @@ QuicRetryTokenDecrypt(
         QuicCopyMemory(Iv, Packet->DestCid, MsQuicLib.CidTotalLength);
     }
 
-    QuicLockAcquire(&MsQuicLib.StatelessRetryKeysLock);
+    QuicDispatchLockAcquire(&MsQuicLib.StatelessRetryKeysLock);
 
     QUIC_KEY* StatelessRetryKey =
         QuicLibraryGetStatelessRetryKeyForTimestamp(
             Token->Authenticated.Timestamp);
     if (StatelessRetryKey == NULL) {
-        QuicLockRelease(&MsQuicLib.StatelessRetryKeysLock);
+        QuicDispatchLockRelease(&MsQuicLib.StatelessRetryKeysLock);
         return FALSE;
     }
 
@@ -475,6 +614,6 @@ QuicRetryTokenDecrypt(
             sizeof(Token->Encrypted) + sizeof(Token->EncryptionTag),
             (uint8_t*)&Token->Encrypted);
 
-    QuicLockRelease(&MsQuicLib.StatelessRetryKeysLock);
+    QuicDispatchLockRelease(&MsQuicLib.StatelessRetryKeysLock);
     return QUIC_SUCCEEDED(Status);
 }
@@ -82,6 +82,34 @@ QUIC_STATIC_ASSERT(
 //
 #define QUIC_CID_MAX_COLLISION_RETRY                8
 
+//
+// The largest CID the pre-allocated per-connection source CID slots reserve
+// room for. Deployments that use short CIDs exclusively can shrink this at
+// build time (e.g. -DMSQUIC_MAX_SUPPORTED_CID_LENGTH=8) to tighten the slot
+// array; a longer client-chosen initial CID then just falls back to an
+// exactly-sized heap allocation. Must cover the CIDs MsQuic itself generates
+// and may not exceed the version 1 protocol limit.
+//
+#ifndef MSQUIC_MAX_SUPPORTED_CID_LENGTH
+#define MSQUIC_MAX_SUPPORTED_CID_LENGTH QUIC_MAX_CONNECTION_ID_LENGTH_V1
+#endif
+
+QUIC_STATIC_ASSERT(
+    MSQUIC_MAX_SUPPORTED_CID_LENGTH >= MSQUIC_CID_MAX_LENGTH,
+    "Slots must be able to hold any CID MsQuic generates");
+
+QUIC_STATIC_ASSERT(
+    MSQUIC_MAX_SUPPORTED_CID_LENGTH <= QUIC_MAX_CONNECTION_ID_LENGTH_V1,
+    "CIDs can't exceed the version 1 limit");
+
+//
+// The number of source CID hash entries pre-allocated inside each connection.
+// Sized for the active CID limit plus the initial (client-chosen) CID and a
+// handshake racing duplicate. Anything beyond that (e.g. the transient burst
+// while replacing all CIDs after a peer migration) falls back to the heap.
+//
+#define QUIC_CONN_SOURCE_CID_SLOT_COUNT (QUIC_ACTIVE_CONNECTION_ID_LIMIT + 2)
+
 //
 // Connection ID Structures
 //
@@ -129,6 +157,11 @@ typedef struct QUIC_CID {
     // Used for source CIDs. The CID is in the binding's lookup table.
     //
     uint8_t IsInLookupTable : 1;
+    //
+    // Used for source CIDs. The backing memory is one of the connection's
+    // pre-allocated CID slots instead of a separate heap allocation.
+    //
+    uint8_t IsPreallocated : 1;
 
     uint8_t Length;
     QUIC_VAR_INT SequenceNumber;
@@ -154,6 +187,129 @@ typedef struct QUIC_CID_HASH_ENTRY {
 
 } QUIC_CID_HASH_ENTRY;
 
+//
+// Pre-allocated backing storage for a single source CID hash entry. The raw
+// buffer reserves room for the largest CID the entry's zero-length Data array
+// may hold.
+//
+typedef struct QUIC_CID_SLOT {
+
+    BOOLEAN InUse;
+    union {
+        QUIC_CID_HASH_ENTRY Entry;
+        uint8_t Raw[
+            sizeof(QUIC_CID_HASH_ENTRY) +
+            MSQUIC_MAX_SUPPORTED_CID_LENGTH];
+    };
+
+} QUIC_CID_SLOT;
+
+//
+// Compares two connection ID buffers for equality. CIDs are at most 20
+// bytes, so instead of a byte loop this does at most three unaligned word
+// compares (the tail words overlap the preceding ones) and ORs the
+// differences together, resolving most mismatches on the first compare.
+// The loads go through QuicCopyMemory so they stay legal on architectures
+// that fault on unaligned access; compilers turn them into plain loads
+// where those are cheap. Integer-only on purpose: this also runs in kernel
+// mode, where vector instructions are off limits.
+//
+inline
+BOOLEAN
+QuicCidEqual(
+    _In_reads_(Length)
+        const uint8_t* const A,
+    _In_reads_(Length)
+        const uint8_t* const B,
+    _In_ uint8_t Length
+    )
+{
+    if (Length >= 8) {
+        uint64_t WordA, WordB, Diff;
+        QuicCopyMemory(&WordA, A, sizeof(WordA));
+        QuicCopyMemory(&WordB, B, sizeof(WordB));
+        Diff = WordA ^ WordB;
+        if (Length > 16) {
+            QuicCopyMemory(&WordA, A + 8, sizeof(WordA));
+            QuicCopyMemory(&WordB, B + 8, sizeof(WordB));
+            Diff |= WordA ^ WordB;
+        }
+        QuicCopyMemory(&WordA, A + Length - 8, sizeof(WordA));
+        QuicCopyMemory(&WordB, B + Length - 8, sizeof(WordB));
+        Diff |= WordA ^ WordB;
+        return Diff == 0;
+    }
+    if (Length >= 4) {
+        uint32_t WordA, WordB, Diff;
+        QuicCopyMemory(&WordA, A, sizeof(WordA));
+        QuicCopyMemory(&WordB, B, sizeof(WordB));
+        Diff = WordA ^ WordB;
+        QuicCopyMemory(&WordA, A + Length - 4, sizeof(WordA));
+        QuicCopyMemory(&WordB, B + Length - 4, sizeof(WordB));
+        Diff |= WordA ^ WordB;
+        return Diff == 0;
+    }
+    uint8_t Diff = 0;
+    for (uint8_t i = 0; i < Length; ++i) {
+        Diff |= (uint8_t)(A[i] ^ B[i]);
+    }
+    return Diff == 0;
+}
+
+//
+// Allocates backing storage for a source CID hash entry, preferring one of
+// the given pre-allocated slots and falling back to the heap only when all
+// slots are in use. The returned entry has a zeroed CID.
+//
+inline
+_Success_(return != NULL)
+QUIC_CID_HASH_ENTRY*
+QuicCidSourceAlloc(
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots,
+    _In_ uint8_t Length
+    )
+{
+    if (Slots != NULL && Length <= MSQUIC_MAX_SUPPORTED_CID_LENGTH) {
+        for (uint32_t i = 0; i < QUIC_CONN_SOURCE_CID_SLOT_COUNT; ++i) {
+            if (!Slots[i].InUse) {
+                Slots[i].InUse = TRUE;
+                QuicZeroMemory(&Slots[i].Entry.CID, sizeof(Slots[i].Entry.CID));
+                Slots[i].Entry.CID.IsPreallocated = TRUE;
+                return &Slots[i].Entry;
+            }
+        }
+    }
+
+    QUIC_CID_HASH_ENTRY* Entry =
+        (QUIC_CID_HASH_ENTRY*)
+        QUIC_ALLOC_NONPAGED(
+            sizeof(QUIC_CID_HASH_ENTRY) +
+            Length);
+    if (Entry != NULL) {
+        QuicZeroMemory(&Entry->CID, sizeof(Entry->CID));
+    }
+
+    return Entry;
+}
+
+//
+// Frees a source CID hash entry, returning pre-allocated entries to their
+// connection's slot instead of the heap.
+//
+inline
+void
+QuicCidFreeSource(
+    _In_ QUIC_CID_HASH_ENTRY* Entry
+    )
+{
+    if (Entry->CID.IsPreallocated) {
+        QUIC_CONTAINING_RECORD(Entry, QUIC_CID_SLOT, Entry)->InUse = FALSE;
+    } else {
+        QUIC_FREE(Entry);
+    }
+}
+
 //
 // Creates a new null/empty source connection ID, that will be used on the
 // receive path.
@@ -162,15 +318,15 @@ inline
 _Success_(return != NULL)
 QUIC_CID_HASH_ENTRY*
 QuicCidNewNullSource(
-    _In_ QUIC_CONNECTION* Connection
+    _In_ QUIC_CONNECTION* Connection,
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots
     )
 {
-    QUIC_CID_HASH_ENTRY* Entry = 
-        (QUIC_CID_HASH_ENTRY*)QUIC_ALLOC_NONPAGED(sizeof(QUIC_CID_HASH_ENTRY));
+    QUIC_CID_HASH_ENTRY* Entry = QuicCidSourceAlloc(Slots, 0);
 
     if (Entry != NULL) {
         Entry->Connection = Connection;
-        QuicZeroMemory(&Entry->CID, sizeof(Entry->CID));
     }
 
     return Entry;
@@ -184,20 +340,17 @@ _Success_(return != NULL)
 QUIC_CID_HASH_ENTRY*
 QuicCidNewSource(
     _In_ QUIC_CONNECTION* Connection,
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots,
     _In_ uint8_t Length,
     _In_reads_(Length)
         const uint8_t* const Data
     )
 {
-    QUIC_CID_HASH_ENTRY* Entry =
-        (QUIC_CID_HASH_ENTRY*)
-        QUIC_ALLOC_NONPAGED(
-            sizeof(QUIC_CID_HASH_ENTRY) +
-            Length);
+    QUIC_CID_HASH_ENTRY* Entry = QuicCidSourceAlloc(Slots, Length);
 
     if (Entry != NULL) {
         Entry->Connection = Connection;
-        QuicZeroMemory(&Entry->CID, sizeof(Entry->CID));
         Entry->CID.Length = Length;
         if (Length != 0) {
             memcpy(Entry->CID.Data, Data, Length);
@@ -5,6 +5,16 @@
 
 --*/
 
+//
+// The set of supported congestion control algorithms. The value is settable
+// via QUIC_SETTING_CONGESTION_CONTROL_ALGORITHM.
+//
+typedef enum QUIC_CONGESTION_CONTROL_ALGORITHM {
+    QUIC_CONGESTION_CONTROL_ALGORITHM_CUBIC,
+    QUIC_CONGESTION_CONTROL_ALGORITHM_BBR,
+    QUIC_CONGESTION_CONTROL_ALGORITHM_MAX
+} QUIC_CONGESTION_CONTROL_ALGORITHM;
+
 typedef struct QUIC_CONGESTION_CONTROL {
 
     //
@@ -25,11 +35,6 @@ typedef struct QUIC_CONGESTION_CONTROL {
     //
     BOOLEAN IsInPersistentCongestion : 1;
 
-    //
-    // TRUE if there has been at least one ACK.
-    //
-    BOOLEAN TimeOfLastAckValid : 1;
-
     //
     // The size of the initial congestion window, in packets.
     //
@@ -62,12 +67,6 @@ typedef struct QUIC_CONGESTION_CONTROL {
     //
     uint8_t Exemptions;
 
-    uint64_t TimeOfLastAck; // millisec
-    uint64_t TimeOfCongAvoidStart; // millisec
-    uint32_t KCubic; // millisec
-    uint32_t WindowMax; // bytes
-    uint32_t WindowLastMax; // bytes
-
     //
     // This variable tracks the largest packet that was outstanding at the time
     // the last congestion event occurred. An ACK for any packet number greater
@@ -75,6 +74,47 @@ typedef struct QUIC_CONGESTION_CONTROL {
     //
     uint64_t RecoverySentPacketNumber;
 
+    //
+    // Algorithm-specific entry points. Set by the algorithm's Initialize
+    // function. The fields above are shared by all algorithms so external
+    // consumers (logging, send buffering) can read them directly.
+    //
+    void (*Reset)(
+        _In_ struct QUIC_CONGESTION_CONTROL* Cc
+        );
+    uint32_t (*GetSendAllowance)(
+        _In_ struct QUIC_CONGESTION_CONTROL* Cc,
+        _In_ uint64_t TimeSinceLastSend,
+        _In_ BOOLEAN TimeSinceLastSendValid
+        );
+    BOOLEAN (*OnDataAcknowledged)(
+        _In_ struct QUIC_CONGESTION_CONTROL* Cc,
+        _In_ uint64_t TimeNow,
+        _In_ uint64_t LargestPacketNumberAcked,
+        _In_ uint32_t NumRetransmittableBytes,
+        _In_ uint32_t SmoothedRtt
+        );
+    void (*OnDataLost)(
+        _In_ struct QUIC_CONGESTION_CONTROL* Cc,
+        _In_ uint64_t LargestPacketNumberLost,
+        _In_ uint64_t LargestPacketNumberSent,
+        _In_ uint32_t NumRetransmittableBytes,
+        _In_ BOOLEAN PersistentCongestion
+        );
+    void (*OnEcnCongestionEvent)(
+        _In_ struct QUIC_CONGESTION_CONTROL* Cc,
+        _In_ uint64_t LargestPacketNumberAcked,
+        _In_ uint64_t LargestPacketNumberSent
+        );
+
+    //
+    // Algorithm-specific state.
+    //
+    union {
+        QUIC_CONGESTION_CONTROL_CUBIC Cubic;
+        QUIC_CONGESTION_CONTROL_BBR Bbr;
+    } Ctx;
+
 } QUIC_CONGESTION_CONTROL;
 
 //
@@ -170,4 +210,30 @@ QuicCongestionControlOnDataLost(
     _In_ uint64_t LargestPacketNumberSent,
     _In_ uint32_t NumRetransmittableBytes,
     _In_ BOOLEAN PersistentCongestion
-    );
\ No newline at end of file
+    );
+
+//
+// Called when the peer reports an increased count of CE-marked packets in an
+// ACK frame. Treated as a congestion signal, but no data was lost.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCongestionControlOnEcnCongestionEvent(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t LargestPacketNumberAcked,
+    _In_ uint64_t LargestPacketNumberSent
+    );
+
+//
+// Helpers shared by the algorithm implementations.
+//
+
+//
+// Returns TRUE if we became unblocked.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicCongestionControlUpdateBlockedState(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ BOOLEAN PreviousCanSendState
+    );
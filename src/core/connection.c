@@ -14,9 +14,10 @@ Abstract:
 
     The connection drains operations in the QuicConnDrainOperations function.
     The only requirement here is that this function is not called in parallel
-    on multiple threads. The function will drain up to QUIC_SETTINGS's
-    MaxOperationsPerDrain operations per call, so as to not starve any other
-    work.
+    on multiple threads. The function drains a bounded batch of operations per
+    call, so as to not starve any other work: at least QUIC_SETTINGS's
+    MaxOperationsPerDrain, plus a deficit-round-robin bonus that backlogged
+    connections accumulate across calls.
 
     While most of the connection specific work is managed by other interfaces,
     the following things are managed in this file:
@@ -85,6 +86,7 @@ QuicConnAlloc(
 #if DEBUG
     InterlockedIncrement(&MsQuicLib.ConnectionCount);
 #endif
+    QuicPerfCounterIncrement(QUIC_PERF_COUNTER_CONN_CREATED);
 
     Connection->Stats.CorrelationId =
         InterlockedIncrement64((int64_t*)&MsQuicLib.ConnectionCorrelationId) - 1;
@@ -106,7 +108,10 @@ QuicConnAlloc(
     Connection->State.ShareBinding = IsServer;
     Connection->Stats.Timing.Start = QuicTimeUs64();
     Connection->SourceCidLimit = QUIC_ACTIVE_CONNECTION_ID_LIMIT;
+    Connection->TraceClassMask = QUIC_TRACE_CLASS_ALL;
     Connection->AckDelayExponent = QUIC_ACK_DELAY_EXPONENT;
+    Connection->PacketTolerance = QUIC_MIN_ACK_SEND_NUMBER;
+    Connection->PeerPacketTolerance = QUIC_MIN_ACK_SEND_NUMBER;
     Connection->PeerTransportParams.AckDelayExponent = QUIC_TP_ACK_DELAY_EXPONENT_DEFAULT;
     Connection->ReceiveQueueTail = &Connection->ReceiveQueue;
     QuicDispatchLockInitialize(&Connection->ReceiveQueueLock);
@@ -116,6 +121,7 @@ QuicConnAlloc(
     QuicOperationQueueInitialize(&Connection->OperQ);
     QuicSendInitialize(&Connection->Send);
     QuicLossDetectionInitialize(&Connection->LossDetection);
+    QuicDatagramInitialize(&Connection->Datagram);
 
     QUIC_PATH* Path = &Connection->Paths[0];
     QuicPathInitialize(Connection, Path);
@@ -135,6 +141,13 @@ QuicConnAlloc(
         //
         QuicConnApplySettings(Connection, &MsQuicLib.Settings);
 
+        //
+        // The gap between the datapath receive timestamp of the first packet
+        // and Timing.Start is time the datagram spent queued before any
+        // connection processing happened.
+        //
+        Connection->Stats.Timing.FirstPacketRecv = Datagram->RecvTimeUs;
+
         const QUIC_RECV_PACKET* Packet =
             QuicDataPathRecvDatagramToRecvPacket(Datagram);
 
@@ -167,6 +180,7 @@ QuicConnAlloc(
             (const uint8_t*)&Path->LocalAddress);
 
         Path->RemoteAddress = Datagram->Tuple->RemoteAddress;
+        QuicPathInvalidateSendCache(Path);
         Connection->State.RemoteAddressSet = TRUE;
         QuicTraceEvent(
             ConnRemoteAddrAdded,
@@ -191,7 +205,11 @@ QuicConnAlloc(
             Path->DestCid->CID.Data);
 
         QUIC_CID_HASH_ENTRY* SourceCid =
-            QuicCidNewSource(Connection, Packet->DestCidLen, Packet->DestCid);
+            QuicCidNewSource(
+                Connection,
+                Connection->SourceCidSlots,
+                Packet->DestCidLen,
+                Packet->DestCid);
         if (SourceCid == NULL) {
             goto Error;
         }
@@ -211,6 +229,7 @@ QuicConnAlloc(
         Connection->State.ExternalOwner = TRUE;
         Path->IsPeerValidated = TRUE;
         Path->Allowance = UINT32_MAX;
+        QuicPathBumpVersion(Path);
 
         Path->DestCid = QuicCidNewRandomDestination();
         if (Path->DestCid == NULL) {
@@ -317,7 +336,7 @@ Error:
         Connection->State.HandleClosed = TRUE;
         Connection->State.Uninitialized = TRUE;
         if (Datagram != NULL) {
-            QUIC_FREE(
+            QuicCidFreeSource(
                 QUIC_CONTAINING_RECORD(
                     Connection->SourceCids.Next,
                     QUIC_CID_HASH_ENTRY,
@@ -347,6 +366,7 @@ QuicConnFree(
     QUIC_TEL_ASSERT(QuicListIsEmpty(&Connection->Streams.ClosedStreams));
     QuicLossDetectionUninitialize(&Connection->LossDetection);
     QuicSendUninitialize(&Connection->Send);
+    QuicDatagramUninitialize(&Connection->Datagram);
     while (!QuicListIsEmpty(&Connection->DestCids)) {
         QUIC_CID_QUIC_LIST_ENTRY *CID =
             QUIC_CONTAINING_RECORD(
@@ -357,6 +377,7 @@ QuicConnFree(
     }
     if (Connection->Worker != NULL) {
         QuicOperationQueueClear(Connection->Worker, &Connection->OperQ);
+        InterlockedDecrement(&Connection->Worker->ConnectionCount);
     }
     if (Connection->ReceiveQueue != NULL) {
         QUIC_RECV_DATAGRAM* Datagram = Connection->ReceiveQueue;
@@ -380,6 +401,9 @@ QuicConnFree(
     if (Connection->RemoteServerName != NULL) {
         QUIC_FREE(Connection->RemoteServerName);
     }
+    if (Connection->PoolServerName != NULL) {
+        QUIC_FREE(Connection->PoolServerName);
+    }
     if (Connection->OrigCID != NULL) {
         QUIC_FREE(Connection->OrigCID);
     }
@@ -394,6 +418,7 @@ QuicConnFree(
 #if DEBUG
     InterlockedDecrement(&MsQuicLib.ConnectionCount);
 #endif
+    QuicPerfCounterIncrement(QUIC_PERF_COUNTER_CONN_DESTROYED);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -405,11 +430,13 @@ QuicConnApplySettings(
 {
     Connection->State.UsePacing = Settings->PacingDefault;
     Connection->MaxAckDelayMs = Settings->MaxAckDelayMs;
+    Connection->AckPiggybackDelayUs = Settings->AckPiggybackDelayUs;
     Connection->Paths[0].SmoothedRtt = MS_TO_US(Settings->InitialRttMs);
     Connection->DisconnectTimeoutUs = MS_TO_US(Settings->DisconnectTimeoutMs);
     Connection->IdleTimeoutMs = Settings->IdleTimeoutMs;
     Connection->HandshakeIdleTimeoutMs = Settings->HandshakeIdleTimeoutMs;
     Connection->KeepAliveIntervalMs = Settings->KeepAliveIntervalMs;
+    Connection->CurrentKeepAliveIntervalMs = Settings->KeepAliveIntervalMs;
 
     uint8_t PeerStreamType =
         QuicConnIsServer(Connection) ?
@@ -448,6 +475,201 @@ QuicConnShutdown(
     QuicConnCloseLocally(Connection, CloseFlags, ErrorCode, NULL);
 }
 
+//
+// Brings up the alternate path used to race the client handshake over a
+// second local interface. Best effort: any failure here just leaves the
+// connection single homed on the primary path.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnStartHandshakeRacing(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    QUIC_DBG_ASSERT(!QuicConnIsServer(Connection));
+    QUIC_DBG_ASSERT(Connection->PathsCount == 1);
+
+    if (QuicAddrCompare(
+            &Connection->RacingLocalAddress,
+            &Connection->Paths[0].LocalAddress)) {
+        //
+        // The primary path already ended up on the alternate interface, so
+        // there is nothing to race.
+        //
+        return;
+    }
+
+    QUIC_PATH* Path = &Connection->Paths[1];
+    QuicPathInitialize(Connection, Path);
+    Path->IsRacing = TRUE;
+    Path->LocalAddress = Connection->RacingLocalAddress;
+    Path->RemoteAddress = Connection->Paths[0].RemoteAddress;
+    Path->DestCid = Connection->Paths[0].DestCid;
+
+    QUIC_STATUS Status =
+        QuicLibraryGetBinding(
+            Connection->Session,
+            Connection->State.ShareBinding,
+            FALSE,
+            &Path->LocalAddress,
+            &Path->RemoteAddress,
+            &Path->Binding);
+    if (QUIC_FAILED(Status)) {
+        QuicTraceEvent(
+            ConnErrorStatus,
+            "[conn][%p] ERROR, %u, %s.",
+            Connection, Status,
+            "Get racing path binding");
+        return;
+    }
+
+    //
+    // The racing binding needs its own lookup entry so the server's packets
+    // arriving on it are routed to this connection. Duplicate the bytes of
+    // the source CID registered on the primary binding; the same CID must
+    // match on both 4-tuples.
+    //
+    QUIC_CID_HASH_ENTRY* SourceCid =
+        QUIC_CONTAINING_RECORD(
+            Connection->SourceCids.Next,
+            QUIC_CID_HASH_ENTRY,
+            Link);
+    Connection->RacingSourceCid =
+        QuicCidNewSource(
+            Connection,
+            Connection->SourceCidSlots,
+            SourceCid->CID.Length,
+            SourceCid->CID.Data);
+    if (Connection->RacingSourceCid == NULL ||
+        !QuicBindingAddSourceConnectionID(
+            Path->Binding, Connection->RacingSourceCid)) {
+        if (Connection->RacingSourceCid != NULL) {
+            QuicCidFreeSource(Connection->RacingSourceCid);
+            Connection->RacingSourceCid = NULL;
+        }
+        QuicLibraryReleaseBinding(Path->Binding);
+        Path->Binding = NULL;
+        return;
+    }
+
+    QuicDataPathBindingGetLocalAddress(
+        Path->Binding->DatapathBinding,
+        &Path->LocalAddress);
+
+    Connection->PathsCount = 2;
+    Connection->State.HandshakeRacing = TRUE;
+
+    QuicTraceLogConnInfo(
+        RacingStarted,
+        Connection,
+        "Path[%hhu] Racing handshake over alternate interface",
+        Path->ID);
+}
+
+//
+// Tears down the racing path without promoting it: used when the primary
+// path wins the race and when the connection is cleaned up mid-race.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnCancelHandshakeRacing(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    Connection->State.HandshakeRacing = FALSE;
+
+    for (uint8_t i = 1; i < Connection->PathsCount; ++i) {
+        if (!Connection->Paths[i].IsRacing) {
+            continue;
+        }
+        QuicTraceLogConnInfo(
+            RacingCancelled,
+            Connection,
+            "Path[%hhu] Racing cancelled",
+            Connection->Paths[i].ID);
+        if (Connection->RacingSourceCid != NULL) {
+            QuicBindingRemoveSourceConnectionID(
+                Connection->Paths[i].Binding,
+                Connection->RacingSourceCid);
+            QuicCidFreeSource(Connection->RacingSourceCid);
+            Connection->RacingSourceCid = NULL;
+        }
+        QuicLibraryReleaseBinding(Connection->Paths[i].Binding);
+        QuicPathRemove(Connection, i);
+        break;
+    }
+}
+
+//
+// Invoked when the first valid server packet is received while the handshake
+// is being raced over two local interfaces. Whichever path it arrived on
+// wins; the loser's binding is released and its server-side half is left to
+// time out.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnResolveHandshakeRacing(
+    _In_ QUIC_CONNECTION* Connection,
+    _Inout_ QUIC_PATH** Path
+    )
+{
+    if (!(*Path)->IsRacing) {
+        //
+        // The primary interface answered first. Just tear the alternate down.
+        //
+        QuicConnCancelHandshakeRacing(Connection);
+        return;
+    }
+
+    Connection->State.HandshakeRacing = FALSE;
+
+    QUIC_PATH* Winner = *Path;
+    QUIC_BINDING* LoserBinding = Connection->Paths[0].Binding;
+
+    QuicTraceLogConnInfo(
+        RacingPathWon,
+        Connection,
+        "Path[%hhu] Won the handshake race",
+        Winner->ID);
+
+    //
+    // Move the connection's real source CIDs onto the winning binding first
+    // and only then retire the temporary racing lookup entry, so there is no
+    // window where further server packets on the winning 4-tuple can't be
+    // matched. The lookup tolerates the momentary duplicate.
+    //
+    QuicBindingMoveSourceConnectionIDs(
+        LoserBinding, Winner->Binding, Connection);
+    QuicBindingRemoveSourceConnectionID(
+        Winner->Binding, Connection->RacingSourceCid);
+    QuicCidFreeSource(Connection->RacingSourceCid);
+    Connection->RacingSourceCid = NULL;
+
+    Winner->IsRacing = FALSE;
+    QuicPathSetActive(Connection, Winner);
+    *Path = &Connection->Paths[0];
+
+    //
+    // The swap in QuicPathSetActive left the old active path's state in the
+    // winner's old slot. Drop it along with its binding.
+    //
+    QuicLibraryReleaseBinding(LoserBinding);
+    QuicPathRemove(Connection, (uint8_t)(Winner - Connection->Paths));
+
+    //
+    // The handshake tracks the current destination CID on the active path
+    // and may have already updated it (to the server's chosen CID) while the
+    // loser was still at index 0. Re-point the active path at the list head,
+    // which is always the CID in use during the handshake.
+    //
+    QUIC_DBG_ASSERT(!QuicListIsEmpty(&Connection->DestCids));
+    Connection->Paths[0].DestCid =
+        QUIC_CONTAINING_RECORD(
+            Connection->DestCids.Flink,
+            QUIC_CID_QUIC_LIST_ENTRY,
+            Link);
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicConnUninitialize(
@@ -468,6 +690,14 @@ QuicConnUninitialize(
         QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
         QUIC_ERROR_NO_ERROR);
 
+    //
+    // If the handshake race never resolved, drop the alternate path now so
+    // its binding and lookup entry don't outlive the connection.
+    //
+    if (Connection->State.HandshakeRacing) {
+        QuicConnCancelHandshakeRacing(Connection);
+    }
+
     //
     // Remove all entries in the binding's lookup tables so we don't get any
     // more packets queued.
@@ -487,6 +717,13 @@ QuicConnUninitialize(
         }
     }
 
+    //
+    // With the packet spaces gone a pending delayed ACK can never fire.
+    // Clear the timer state so send flag updates later in teardown (e.g.
+    // datagram shutdown) don't trip send validation.
+    //
+    Connection->Send.DelayedAckTimerActive = FALSE;
+
     //
     // Clean up the rest of the internal state.
     //
@@ -645,6 +882,24 @@ QuicConnTraceRundownOper(
     QuicStreamSetTraceRundown(&Connection->Streams);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicConnQueueSettingsUpdate(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    QUIC_OPERATION* Oper;
+    if ((Oper = QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_SETTINGS_UPDATE)) != NULL) {
+        QuicConnQueueOper(Connection, Oper);
+    } else {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "settings update operation",
+            0);
+    }
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicConnIndicateEvent(
@@ -693,6 +948,52 @@ QuicConnIndicateEvent(
     return Status;
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+uint16_t
+QuicConnGetMaxStreamPacketPayload(
+    _In_ const QUIC_CONNECTION* Connection
+    )
+{
+    //
+    // Start from the path MTU and subtract the worst case short header,
+    // encryption overhead and stream frame header (type byte plus full size
+    // varints), as a conservative estimate. An app writing in chunks of this
+    // size never has a chunk split across packets.
+    //
+    const uint16_t Overhead =
+        MIN_SHORT_HEADER_LENGTH_V1 +
+        QUIC_MAX_CONNECTION_ID_LENGTH_V1 +
+        QUIC_ENCRYPTION_OVERHEAD +
+        sizeof(uint8_t) +   // Stream frame type
+        8 +                 // Worst case stream ID
+        8 +                 // Worst case offset
+        2;                  // Explicit length
+    uint16_t Mtu = Connection->Paths[0].Mtu;
+    if (Mtu <= Overhead) {
+        return 0;
+    }
+    return Mtu - Overhead;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnIndicatePacketPayloadChanged(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    QUIC_CONNECTION_EVENT Event;
+    Event.Type = QUIC_CONNECTION_EVENT_PACKET_PAYLOAD_CHANGED;
+    Event.PACKET_PAYLOAD_CHANGED.MaxStreamPayloadSize =
+        QuicConnGetMaxStreamPacketPayload(Connection);
+
+    QuicTraceLogConnVerbose(
+        IndicatePacketPayloadChanged,
+        Connection,
+        "Indicating QUIC_CONNECTION_EVENT_PACKET_PAYLOAD_CHANGED [%hu bytes]",
+        Event.PACKET_PAYLOAD_CHANGED.MaxStreamPayloadSize);
+    (void)QuicConnIndicateEvent(Connection, &Event);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
 QuicConnQueueOper(
@@ -744,6 +1045,7 @@ QuicConnUpdateRtt(
     }
 
     Path->LatestRttSample = LatestRtt;
+    QuicPathUpdateMinRttWindow(Path, QuicTimeUs32(), LatestRtt);
     if (LatestRtt < Path->MinRtt) {
         Path->MinRtt = LatestRtt;
     }
@@ -809,6 +1111,7 @@ QuicConnGenerateNewSourceCid(
         SourceCid =
             QuicCidNewRandomSource(
                 Connection,
+                Connection->SourceCidSlots,
                 Connection->ServerID,
                 Connection->PartitionID,
                 Connection->Registration->CidPrefixLength,
@@ -823,7 +1126,7 @@ QuicConnGenerateNewSourceCid(
             return NULL;
         }
         if (!QuicBindingAddSourceConnectionID(Connection->Paths[0].Binding, SourceCid)) {
-            QUIC_FREE(SourceCid);
+            QuicCidFreeSource(SourceCid);
             SourceCid = NULL;
             if (++TryCount > QUIC_CID_MAX_COLLISION_RETRY) {
                 QuicTraceEvent(
@@ -928,10 +1231,85 @@ QuicConnGenerateNewSourceCids(
         }
     }
 
-    for (uint8_t i = 0; i < NewCidCount; ++i) {
-        if (QuicConnGenerateNewSourceCid(Connection, FALSE) == NULL) {
-            break;
+    if (NewCidCount == 0) {
+        return;
+    }
+
+    //
+    // Pre-generate the whole batch of CIDs up front so they can all be
+    // registered with the binding's lookup table under a single write lock
+    // acquisition, instead of taking the lock once per CID.
+    //
+    QUIC_DBG_ASSERT(NewCidCount <= QUIC_ACTIVE_CONNECTION_ID_LIMIT);
+    QUIC_CID_HASH_ENTRY* NewCids[QUIC_ACTIVE_CONNECTION_ID_LIMIT];
+    uint8_t GeneratedCount = 0;
+    while (GeneratedCount < NewCidCount) {
+        QUIC_CID_HASH_ENTRY* SourceCid =
+            QuicCidNewRandomSource(
+                Connection,
+                Connection->SourceCidSlots,
+                Connection->ServerID,
+                Connection->PartitionID,
+                Connection->Registration->CidPrefixLength,
+                Connection->Registration->CidPrefix);
+        if (SourceCid == NULL) {
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "new Src CID",
+                sizeof(QUIC_CID_HASH_ENTRY) + MsQuicLib.CidTotalLength);
+            QuicConnFatalError(Connection, QUIC_STATUS_INTERNAL_ERROR, NULL);
+            while (GeneratedCount != 0) {
+                QuicCidFreeSource(NewCids[--GeneratedCount]);
+            }
+            return;
+        }
+        NewCids[GeneratedCount++] = SourceCid;
+    }
+
+    QuicBindingAddSourceConnectionIDs(
+        Connection->Paths[0].Binding, NewCids, GeneratedCount);
+
+    QUIC_SINGLE_LIST_ENTRY** Tail = &Connection->SourceCids.Next;
+    while (*Tail != NULL) {
+        Tail = &(*Tail)->Next;
+    }
+
+    for (uint8_t i = 0; i < GeneratedCount; ++i) {
+        QUIC_CID_HASH_ENTRY* SourceCid = NewCids[i];
+        if (!SourceCid->CID.IsInLookupTable) {
+            //
+            // The CID collided with an existing one (or failed to insert).
+            // Fall back to the single CID path, which retries with fresh
+            // randomness.
+            //
+            QuicCidFreeSource(SourceCid);
+            if (QuicConnGenerateNewSourceCid(Connection, FALSE) == NULL) {
+                return;
+            }
+            Tail = &Connection->SourceCids.Next;
+            while (*Tail != NULL) {
+                Tail = &(*Tail)->Next;
+            }
+            continue;
+        }
+
+        SourceCid->CID.SequenceNumber = Connection->NextSourceCidSequenceNumber++;
+        QuicTraceEvent(
+            ConnSourceCidAdded,
+            "[conn][%p] (SeqNum=%llu) New Source CID: %!CID!",
+            Connection,
+            SourceCid->CID.SequenceNumber,
+            SourceCid->CID.Length,
+            SourceCid->CID.Data);
+        if (SourceCid->CID.SequenceNumber > 0) {
+            SourceCid->CID.NeedsToSend = TRUE;
+            QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_NEW_CONNECTION_ID);
         }
+
+        *Tail = &SourceCid->Link;
+        SourceCid->Link.Next = NULL;
+        Tail = &SourceCid->Link.Next;
     }
 }
 
@@ -1217,6 +1595,7 @@ QuicConnTimerExpired(
     uint32_t i = 0;
     QUIC_CONN_TIMER_ENTRY Temp[QUIC_CONN_TIMER_COUNT];
     BOOLEAN FlushSendImmediate = FALSE;
+    BOOLEAN RearmAckDelayTimer = FALSE;
 
     while (i < ARRAYSIZE(Connection->Timers) &&
            Connection->Timers[i].ExpirationTime <= TimeNow) {
@@ -1224,7 +1603,16 @@ QuicConnTimerExpired(
         ++i;
     }
 
-    QUIC_DBG_ASSERT(i != 0);
+    if (i == 0) {
+        //
+        // The timers were canceled or rescheduled (by a worker draining this
+        // connection's operations on a different thread) after this
+        // connection was pulled from the timer wheel. Nothing to do but put
+        // it back.
+        //
+        QuicTimerWheelUpdateConnection(&Connection->Worker->TimerWheel, Connection);
+        return;
+    }
 
     QuicCopyMemory(
         Temp,
@@ -1248,6 +1636,7 @@ QuicConnTimerExpired(
             "LOSS_DETECTION",
             "KEEP_ALIVE",
             "IDLE",
+            "HIBERNATE",
             "SHUTDOWN",
             "INVALID"
         };
@@ -1262,8 +1651,23 @@ QuicConnTimerExpired(
                 "[conn][%p] Execute: %u",
                 Connection,
                 QUIC_CONN_TIMER_ACK_DELAY);
-            QuicSendProcessDelayedAckTimer(&Connection->Send);
-            FlushSendImmediate = TRUE;
+            if (Connection->AckPiggybackDelayUs != 0 &&
+                !Connection->Send.AckPiggybackDeferred &&
+                Connection->Send.SendFlags == 0 &&
+                QuicListIsEmpty(&Connection->Send.SendStreams)) {
+                //
+                // Nothing is queued for the ACK to piggyback on, so hold it
+                // one extra short window in the hope outbound data (e.g. an
+                // RPC response) shows up to carry it. The deferral is
+                // one-shot, and the timer can't be re-armed from inside this
+                // loop, so that's done after the wheel update below.
+                //
+                Connection->Send.AckPiggybackDeferred = TRUE;
+                RearmAckDelayTimer = TRUE;
+            } else {
+                QuicSendProcessDelayedAckTimer(&Connection->Send);
+                FlushSendImmediate = TRUE;
+            }
         } else if (Temp[j].Type == QUIC_CONN_TIMER_PACING) {
             QuicTraceEvent(
                 ConnExecTimerOper,
@@ -1275,7 +1679,12 @@ QuicConnTimerExpired(
             QUIC_OPERATION* Oper;
             if ((Oper = QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_TIMER_EXPIRED)) != NULL) {
                 Oper->TIMER_EXPIRED.Type = Temp[j].Type;
-                QuicConnQueueOper(Connection, Oper);
+                //
+                // Timer work is deadline driven (e.g. loss probes), so it
+                // jumps ahead of any receive and API operations already
+                // backlogged in the queue instead of waiting behind them.
+                //
+                QuicConnQueueHighestPriorityOper(Connection, Oper);
             } else {
                 QuicTraceEvent(
                     AllocFailure,
@@ -1288,6 +1697,18 @@ QuicConnTimerExpired(
 
     QuicTimerWheelUpdateConnection(&Connection->Worker->TimerWheel, Connection);
 
+    if (RearmAckDelayTimer) {
+        //
+        // Deferred from the loop above because inserting a timer there would
+        // mess up the timer loop. The timer wheel runs on millisecond
+        // granularity, so the piggyback window rounds up to at least 1ms.
+        //
+        QuicConnTimerSet(
+            Connection,
+            QUIC_CONN_TIMER_ACK_DELAY,
+            max(1, US_TO_MS(Connection->AckPiggybackDelayUs)));
+    }
+
     if (FlushSendImmediate) {
         //
         // We don't want to actually call the flush immediate above as it can
@@ -1340,6 +1761,10 @@ QuicConnOnShutdownComplete(
     }
     Connection->State.HandleShutdown = TRUE;
 
+    if (Connection->State.Started && !Connection->State.Connected) {
+        QuicPerfCounterIncrement(QUIC_PERF_COUNTER_CONN_HANDSHAKE_FAIL);
+    }
+
     QuicTraceEvent(
         ConnShutdownComplete,
         "[conn][%p] Shutdown complete, PeerFailedToAcknowledged=%hhu.",
@@ -1613,9 +2038,11 @@ QuicConnTryClose(
         }
 
         //
-        // On initial close, we must shut down all the current streams.
+        // On initial close, we must shut down all the current streams and
+        // cancel any queued datagram sends.
         //
         QuicStreamSetShutdown(&Connection->Streams);
+        QuicDatagramSendShutdown(&Connection->Datagram);
     }
 
     if (SilentClose ||
@@ -1725,13 +2152,17 @@ QuicConnStart(
 #endif
 
         //
-        // Resolve the server name to IP address.
+        // Resolve the server name to IP address. The datapath is brought up
+        // lazily, so it may not exist yet at this point.
         //
-        Status =
-            QuicDataPathResolveAddress(
-                MsQuicLib.Datapath,
-                ServerName,
-                &Path->RemoteAddress);
+        Status = QuicLibraryEnsureDatapath();
+        if (QUIC_SUCCEEDED(Status)) {
+            Status =
+                QuicDataPathResolveAddress(
+                    MsQuicLib.Datapath,
+                    ServerName,
+                    &Path->RemoteAddress);
+        }
 
 #ifdef QUIC_COMPARTMENT_ID
         if (RevertCompartmentId) {
@@ -1755,16 +2186,29 @@ QuicConnStart(
         (const uint8_t*)&Path->RemoteAddress);
 
     //
-    // Get the binding for the current local & remote addresses.
+    // Get the binding for the current local & remote addresses. In port spray
+    // mode, connections without an explicit local address share one of a
+    // small pool of bindings, striped by partition, instead of opening a
+    // socket per connection.
     //
-    Status =
-        QuicLibraryGetBinding(
-            Connection->Session,
-            Connection->State.ShareBinding,
-            FALSE,
-            Connection->State.LocalAddressSet ? &Path->LocalAddress : NULL,
-            &Path->RemoteAddress,
-            &Path->Binding);
+    if (!Connection->State.LocalAddressSet &&
+        MsQuicLib.Settings.ClientPortSprayCount > 0) {
+        Connection->State.ShareBinding = TRUE; // Sharing requires a real source CID.
+        Status =
+            QuicLibraryGetClientSprayBinding(
+                Connection->Session,
+                Connection->PartitionID,
+                &Path->Binding);
+    } else {
+        Status =
+            QuicLibraryGetBinding(
+                Connection->Session,
+                Connection->State.ShareBinding,
+                FALSE,
+                Connection->State.LocalAddressSet ? &Path->LocalAddress : NULL,
+                &Path->RemoteAddress,
+                &Path->Binding);
+    }
     if (QUIC_FAILED(Status)) {
         goto Exit;
     }
@@ -1778,12 +2222,13 @@ QuicConnStart(
         SourceCid =
             QuicCidNewRandomSource(
                 Connection,
+                Connection->SourceCidSlots,
                 NULL,
                 Connection->PartitionID,
                 Connection->Registration->CidPrefixLength,
                 Connection->Registration->CidPrefix);
     } else {
-        SourceCid = QuicCidNewNullSource(Connection);
+        SourceCid = QuicCidNewNullSource(Connection, Connection->SourceCidSlots);
     }
     if (SourceCid == NULL) {
         Status = QUIC_STATUS_OUT_OF_MEMORY;
@@ -1818,6 +2263,10 @@ QuicConnStart(
         LOG_ADDR_LEN(Path->LocalAddress),
         (const uint8_t*)&Path->LocalAddress);
 
+    if (Connection->State.RacingLocalAddressSet) {
+        QuicConnStartHandshakeRacing(Connection);
+    }
+
     //
     // Save the server name.
     //
@@ -1915,7 +2364,7 @@ QuicConnInitializeCrypto(
         QuicConnTimerSet(
             Connection,
             QUIC_CONN_TIMER_KEEP_ALIVE,
-            Connection->KeepAliveIntervalMs);
+            Connection->CurrentKeepAliveIntervalMs);
     }
 
 Error:
@@ -1949,10 +2398,16 @@ QuicConnHandshakeConfigure(
         LocalTP.InitialMaxStreamDataBidiRemote = Connection->Session->Settings.StreamRecvWindowDefault;
         LocalTP.InitialMaxStreamDataUni = Connection->Session->Settings.StreamRecvWindowDefault;
         LocalTP.InitialMaxData = Connection->Send.MaxData;
+        //
+        // Same receive capability calculation as the server side above.
+        //
         LocalTP.MaxPacketSize =
-            MaxUdpPayloadSizeFromMTU(
-                QuicDataPathBindingGetLocalMtu(
-                    Connection->Paths[0].Binding->DatapathBinding));
+            (QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath) &
+                QUIC_DATAPATH_FEATURE_RECV_COALESCING) ?
+                MAX_JUMBO_UDP_PAYLOAD_LENGTH :
+                MaxUdpPayloadSizeFromMTU(
+                    QuicDataPathBindingGetLocalMtu(
+                        Connection->Paths[0].Binding->DatapathBinding));
         LocalTP.ActiveConnectionIdLimit = QUIC_ACTIVE_CONNECTION_ID_LIMIT;
         LocalTP.Flags =
             QUIC_TP_FLAG_INITIAL_MAX_DATA |
@@ -1975,6 +2430,19 @@ QuicConnHandshakeConfigure(
         LocalTP.MaxAckDelay =
             Connection->MaxAckDelayMs + (uint32_t)MsQuicLib.TimerResolutionMs;
 
+        //
+        // The minimum we can delay an ACK is bounded by the platform's timer
+        // resolution. Advertising this parameter also tells the peer we
+        // support receiving ACK_FREQUENCY frames.
+        //
+        LocalTP.Flags |= QUIC_TP_FLAG_MIN_ACK_DELAY;
+        LocalTP.MinAckDelay = MS_TO_US((uint32_t)MsQuicLib.TimerResolutionMs);
+
+        if (Connection->Datagram.ReceiveEnabled) {
+            LocalTP.Flags |= QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE;
+            LocalTP.MaxDatagramFrameSize = QUIC_DEFAULT_MAX_DATAGRAM_FRAME_SIZE;
+        }
+
         const QUIC_CID_HASH_ENTRY* SourceCid =
             QUIC_CONTAINING_RECORD(
                 Connection->SourceCids.Next,
@@ -2072,10 +2540,19 @@ QuicConnHandshakeConfigure(
         LocalTP.InitialMaxStreamDataBidiRemote = Connection->Session->Settings.StreamRecvWindowDefault;
         LocalTP.InitialMaxStreamDataUni = Connection->Session->Settings.StreamRecvWindowDefault;
         LocalTP.InitialMaxData = Connection->Send.MaxData;
+        //
+        // When the datapath coalesces receives, the receive path accepts
+        // datagrams well past the local link MTU, so advertise up to the
+        // largest (jumbo) payload supported and let the peer's MTU discovery
+        // work out what actually fits through the path.
+        //
         LocalTP.MaxPacketSize =
-            MaxUdpPayloadSizeFromMTU(
-                QuicDataPathBindingGetLocalMtu(
-                    Connection->Paths[0].Binding->DatapathBinding));
+            (QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath) &
+                QUIC_DATAPATH_FEATURE_RECV_COALESCING) ?
+                MAX_JUMBO_UDP_PAYLOAD_LENGTH :
+                MaxUdpPayloadSizeFromMTU(
+                    QuicDataPathBindingGetLocalMtu(
+                        Connection->Paths[0].Binding->DatapathBinding));
         LocalTP.ActiveConnectionIdLimit = QUIC_ACTIVE_CONNECTION_ID_LIMIT;
         LocalTP.Flags =
             QUIC_TP_FLAG_INITIAL_MAX_DATA |
@@ -2094,6 +2571,17 @@ QuicConnHandshakeConfigure(
         LocalTP.MaxAckDelay =
             Connection->MaxAckDelayMs + MsQuicLib.TimerResolutionMs;
 
+        //
+        // Same ACK_FREQUENCY support indication as the server side above.
+        //
+        LocalTP.Flags |= QUIC_TP_FLAG_MIN_ACK_DELAY;
+        LocalTP.MinAckDelay = MS_TO_US((uint32_t)MsQuicLib.TimerResolutionMs);
+
+        if (Connection->Datagram.ReceiveEnabled) {
+            LocalTP.Flags |= QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE;
+            LocalTP.MaxDatagramFrameSize = QUIC_DEFAULT_MAX_DATAGRAM_FRAME_SIZE;
+        }
+
         if (Connection->AckDelayExponent != QUIC_TP_ACK_DELAY_EXPONENT_DEFAULT) {
             LocalTP.Flags |= QUIC_TP_FLAG_ACK_DELAY_EXPONENT;
             LocalTP.AckDelayExponent = Connection->AckDelayExponent;
@@ -2252,6 +2740,8 @@ QuicConnProcessPeerTransportParameters(
     Connection->Send.PeerMaxData =
         Connection->PeerTransportParams.InitialMaxData;
 
+    QuicDatagramOnSendStateChanged(&Connection->Datagram);
+
     QuicStreamSetInitializeTransportParameters(
         &Connection->Streams,
         Connection->PeerTransportParams.InitialMaxBidiStreams,
@@ -2267,18 +2757,40 @@ Error:
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
-QuicConnQueueRecvDatagrams(
+QuicConnUpdatePeerPacketTolerance(
     _In_ QUIC_CONNECTION* Connection,
-    _In_ QUIC_RECV_DATAGRAM* DatagramChain,
-    _In_ uint32_t DatagramChainLength
+    _In_ uint8_t NewPacketTolerance
     )
 {
-    QUIC_RECV_DATAGRAM** DatagramChainTail = &DatagramChain->Next;
-    DatagramChain->QueuedOnConnection = TRUE;
-    QuicDataPathRecvDatagramToRecvPacket(DatagramChain)->AssignedToConnection = TRUE;
-    while (*DatagramChainTail != NULL) {
-        (*DatagramChainTail)->QueuedOnConnection = TRUE;
-        QuicDataPathRecvDatagramToRecvPacket(*DatagramChainTail)->AssignedToConnection = TRUE;
+    QUIC_DBG_ASSERT(
+        Connection->PeerTransportParams.Flags & QUIC_TP_FLAG_MIN_ACK_DELAY);
+    if (Connection->PeerPacketTolerance != NewPacketTolerance) {
+        Connection->SendAckFreqSeqNum++;
+        Connection->PeerPacketTolerance = NewPacketTolerance;
+        QuicTraceLogConnVerbose(
+            UpdatePeerPacketTolerance,
+            Connection,
+            "Updating peer packet tolerance to %hhu",
+            NewPacketTolerance);
+        QuicSendSetSendFlag(
+            &Connection->Send, QUIC_CONN_SEND_FLAG_ACK_FREQUENCY);
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicConnQueueRecvDatagrams(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_RECV_DATAGRAM* DatagramChain,
+    _In_ uint32_t DatagramChainLength
+    )
+{
+    QUIC_RECV_DATAGRAM** DatagramChainTail = &DatagramChain->Next;
+    DatagramChain->QueuedOnConnection = TRUE;
+    QuicDataPathRecvDatagramToRecvPacket(DatagramChain)->AssignedToConnection = TRUE;
+    while (*DatagramChainTail != NULL) {
+        (*DatagramChainTail)->QueuedOnConnection = TRUE;
+        QuicDataPathRecvDatagramToRecvPacket(*DatagramChainTail)->AssignedToConnection = TRUE;
         DatagramChainTail = &((*DatagramChainTail)->Next);
     }
 
@@ -2314,14 +2826,40 @@ QuicConnQueueRecvDatagrams(
     if (QueueOperation) {
         QUIC_OPERATION* ConnOper =
             QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_FLUSH_RECV);
-        if (ConnOper != NULL) {
-            QuicConnQueueOper(Connection, ConnOper);
-        } else {
+        if (ConnOper == NULL) {
             QuicTraceEvent(
                 AllocFailure,
                 "Allocation of '%s' failed. (%llu bytes)",
                 "Flush Recv operation",
                 0);
+            return;
+        }
+
+        if (MsQuicLib.Settings.InlineDatapathRecvEnabled &&
+            Connection->State.Connected &&
+            Connection->Worker->IdealProcessor == QuicLibraryGetCurrentPartition() &&
+            QuicWorkerTryClaimConnection(Connection->Worker, Connection)) {
+            //
+            // This datapath thread serves the connection's partition and the
+            // connection is idle and uncontended, so drain the operation
+            // queue right here instead of waking the worker thread, removing
+            // a context switch from the receive path at low load. The drain
+            // requeues the connection if it leaves work behind, but doesn't
+            // wake the worker (its usual callers run on the worker thread),
+            // so that falls to us. Only valid where datapath receive
+            // callbacks run at passive level.
+            //
+            (void)QuicOperationEnqueue(&Connection->OperQ, ConnOper);
+            Connection->Stats.Schedule.LastQueueTime = QuicTimeUs32();
+            QuicConnAddRef(Connection, QUIC_CONN_REF_WORKER);
+            QuicWorkerProcessConnection(
+                Connection->Worker, Connection, QuicCurThreadID());
+            if (Connection->HasQueuedWork) {
+                QuicEventSet(Connection->Worker->Ready);
+            }
+
+        } else {
+            QuicConnQueueOper(Connection, ConnOper);
         }
     }
 }
@@ -2382,7 +2920,7 @@ QuicConnUpdateDestCid(
     QUIC_DBG_ASSERT(Connection->Paths[0].DestCid == DestCid);
 
     if (Packet->SourceCidLen != DestCid->CID.Length ||
-        memcmp(Packet->SourceCid, DestCid->CID.Data, DestCid->CID.Length) != 0) {
+        !QuicCidEqual(Packet->SourceCid, DestCid->CID.Data, DestCid->CID.Length)) {
 
         // TODO - Only update for the first packet of each type (Initial and Retry).
 
@@ -2802,114 +3340,140 @@ QuicConnRecvHeader(
         return FALSE;
     }
 
-    if (!Packet->IsShortHeader) {
-        if (Packet->Invariant->LONG_HDR.Version != Connection->Stats.QuicVersion) {
-            if (Packet->Invariant->LONG_HDR.Version == QUIC_VERSION_VER_NEG) {
-                Connection->Stats.VersionNegotiation = TRUE;
-
-                //
-                // Version negotiation is removed for the first version of QUIC.
-                // When it is put back, it will probably be implemented as in this
-                // function:
-                // QuicConnRecvVerNeg(Connection, Packet);
-                //
-                // For now, since there is a single version, receiving
-                // a version negotation packet means there is a version
-                // mismatch, so abandon the connect attempt.
-                //
+    //
+    // Once the handshake has been confirmed, the Initial and Handshake packet
+    // spaces (and their keys) have been discarded and the connection's version
+    // is fixed, so short header (1-RTT) packets are the only thing still
+    // accepted. Drop everything else up front and validate the short header
+    // with the straight-line template comparison, skipping all of the version
+    // and long header logic below.
+    //
+    if (Connection->State.HandshakeConfirmed) {
 
-                QuicConnCloseLocally(
-                    Connection,
-                    QUIC_CLOSE_INTERNAL_SILENT | QUIC_CLOSE_QUIC_STATUS,
-                    (uint64_t)QUIC_STATUS_VER_NEG_ERROR,
-                    NULL);
-            } else {
-                QuicPacketLogDropWithValue(Connection, Packet, "Invalid version", QuicByteSwapUint32(Packet->Invariant->LONG_HDR.Version));
-            }
+        if (!Packet->IsShortHeader) {
+            QuicPacketLogDrop(Connection, Packet, "Long header packet after handshake confirmed");
             return FALSE;
         }
-    } else {
-        if (!QuicIsVersionSupported(Connection->Stats.QuicVersion)) {
-            QuicPacketLogDrop(Connection, Packet, "SH packet during version negotiation");
+
+        if (!Packet->ValidatedHeaderVer &&
+            !QuicPacketValidateShortHeaderV1Fast(Connection, Packet)) {
             return FALSE;
         }
-    }
 
-    QUIC_FRE_ASSERT(QuicIsVersionSupported(Connection->Stats.QuicVersion));
+        Packet->KeyType = QUIC_PACKET_KEY_1_RTT;
 
-    //
-    // Begin non-version-independent logic. When future versions are supported,
-    // there may be some switches based on packet version.
-    //
+    } else {
 
-    if (!Packet->IsShortHeader) {
-        if (Packet->LH->Type == QUIC_RETRY) {
-            QuicConnRecvRetry(Connection, Packet);
-            return FALSE;
-        }
+        if (!Packet->IsShortHeader) {
+            if (Packet->Invariant->LONG_HDR.Version != Connection->Stats.QuicVersion) {
+                if (Packet->Invariant->LONG_HDR.Version == QUIC_VERSION_VER_NEG) {
+                    Connection->Stats.VersionNegotiation = TRUE;
 
-        const uint8_t* TokenBuffer = NULL;
-        uint16_t TokenLength = 0;
+                    //
+                    // Version negotiation is removed for the first version of QUIC.
+                    // When it is put back, it will probably be implemented as in this
+                    // function:
+                    // QuicConnRecvVerNeg(Connection, Packet);
+                    //
+                    // For now, since there is a single version, receiving
+                    // a version negotation packet means there is a version
+                    // mismatch, so abandon the connect attempt.
+                    //
 
-        if (!Packet->ValidatedHeaderVer &&
-            !QuicPacketValidateLongHeaderV1(
-                Connection,
-                QuicConnIsServer(Connection),
-                Packet,
-                &TokenBuffer,
-                &TokenLength)) {
-            return FALSE;
+                    QuicConnCloseLocally(
+                        Connection,
+                        QUIC_CLOSE_INTERNAL_SILENT | QUIC_CLOSE_QUIC_STATUS,
+                        (uint64_t)QUIC_STATUS_VER_NEG_ERROR,
+                        NULL);
+                } else {
+                    QuicPacketLogDropWithValue(Connection, Packet, "Invalid version", QuicByteSwapUint32(Packet->Invariant->LONG_HDR.Version));
+                }
+                return FALSE;
+            }
+        } else {
+            if (!QuicIsVersionSupported(Connection->Stats.QuicVersion)) {
+                QuicPacketLogDrop(Connection, Packet, "SH packet during version negotiation");
+                return FALSE;
+            }
         }
 
-        QUIC_PATH* Path = &Connection->Paths[0];
-        if (!Path->IsPeerValidated && Packet->ValidToken) {
+        QUIC_FRE_ASSERT(QuicIsVersionSupported(Connection->Stats.QuicVersion));
 
-            QUIC_DBG_ASSERT(TokenBuffer == NULL);
-            QuicPacketDecodeRetryTokenV1(Packet, &TokenBuffer, &TokenLength);
-            QUIC_DBG_ASSERT(TokenLength == sizeof(QUIC_RETRY_TOKEN_CONTENTS));
+        //
+        // Begin non-version-independent logic. When future versions are supported,
+        // there may be some switches based on packet version.
+        //
 
-            QUIC_RETRY_TOKEN_CONTENTS Token;
-            if (!QuicRetryTokenDecrypt(Packet, TokenBuffer, &Token)) {
-                QUIC_DBG_ASSERT(FALSE); // Was already decrypted sucessfully once.
-                QuicPacketLogDrop(Connection, Packet, "Retry token decrypt failure");
+        if (!Packet->IsShortHeader) {
+            if (Packet->LH->Type == QUIC_RETRY) {
+                QuicConnRecvRetry(Connection, Packet);
                 return FALSE;
             }
 
-            QUIC_DBG_ASSERT(Token.Encrypted.OrigConnIdLength <= sizeof(Token.Encrypted.OrigConnId));
-            QUIC_DBG_ASSERT(QuicAddrCompare(&Path->RemoteAddress, &Token.Encrypted.RemoteAddress));
+            const uint8_t* TokenBuffer = NULL;
+            uint16_t TokenLength = 0;
 
-            Connection->OrigCID =
-                QUIC_ALLOC_NONPAGED(
-                    sizeof(QUIC_CID) +
-                    Token.Encrypted.OrigConnIdLength);
-            if (Connection->OrigCID == NULL) {
-                QuicTraceEvent(
-                    AllocFailure,
-                    "Allocation of '%s' failed. (%llu bytes)",
-                    "OrigCID",
-                    sizeof(QUIC_CID) + Token.Encrypted.OrigConnIdLength);
+            if (!Packet->ValidatedHeaderVer &&
+                !QuicPacketValidateLongHeaderV1(
+                    Connection,
+                    QuicConnIsServer(Connection),
+                    Packet,
+                    &TokenBuffer,
+                    &TokenLength)) {
                 return FALSE;
             }
 
-            Connection->OrigCID->Length = Token.Encrypted.OrigConnIdLength;
-            QuicCopyMemory(
-                Connection->OrigCID->Data,
-                Token.Encrypted.OrigConnId,
-                Token.Encrypted.OrigConnIdLength);
+            QUIC_PATH* Path = &Connection->Paths[0];
+            if (!Path->IsPeerValidated && Packet->ValidToken) {
 
-            QuicPathSetValid(Connection, Path, QUIC_PATH_VALID_INITIAL_TOKEN);
-        }
+                QUIC_DBG_ASSERT(TokenBuffer == NULL);
+                QuicPacketDecodeRetryTokenV1(Packet, &TokenBuffer, &TokenLength);
+                QUIC_DBG_ASSERT(TokenLength == sizeof(QUIC_RETRY_TOKEN_CONTENTS));
 
-        Packet->KeyType = QuicPacketTypeToKeyType(Packet->LH->Type);
+                QUIC_RETRY_TOKEN_CONTENTS Token;
+                if (!QuicRetryTokenDecrypt(Packet, TokenBuffer, &Token)) {
+                    QUIC_DBG_ASSERT(FALSE); // Was already decrypted sucessfully once.
+                    QuicPacketLogDrop(Connection, Packet, "Retry token decrypt failure");
+                    return FALSE;
+                }
 
-    } else {
+                QUIC_DBG_ASSERT(Token.Encrypted.OrigConnIdLength <= sizeof(Token.Encrypted.OrigConnId));
+                QUIC_DBG_ASSERT(QuicAddrCompare(&Path->RemoteAddress, &Token.Encrypted.RemoteAddress));
 
-        if (!Packet->ValidatedHeaderVer &&
-            !QuicPacketValidateShortHeaderV1(Connection, Packet)) {
-            return FALSE;
+                Connection->OrigCID =
+                    QUIC_ALLOC_NONPAGED(
+                        sizeof(QUIC_CID) +
+                        Token.Encrypted.OrigConnIdLength);
+                if (Connection->OrigCID == NULL) {
+                    QuicTraceEvent(
+                        AllocFailure,
+                        "Allocation of '%s' failed. (%llu bytes)",
+                        "OrigCID",
+                        sizeof(QUIC_CID) + Token.Encrypted.OrigConnIdLength);
+                    return FALSE;
+                }
+
+                Connection->OrigCID->Length = Token.Encrypted.OrigConnIdLength;
+                QuicCopyMemory(
+                    Connection->OrigCID->Data,
+                    Token.Encrypted.OrigConnId,
+                    Token.Encrypted.OrigConnIdLength);
+
+                QuicPathSetValid(Connection, Path, QUIC_PATH_VALID_INITIAL_TOKEN);
+            }
+
+            Packet->KeyType = QuicPacketTypeToKeyType(Packet->LH->Type);
+
+        } else {
+
+            if (!Packet->ValidatedHeaderVer &&
+                !QuicPacketValidateShortHeaderV1(Connection, Packet)) {
+                return FALSE;
+            }
+
+            Packet->KeyType = QUIC_PACKET_KEY_1_RTT;
         }
 
-        Packet->KeyType = QUIC_PACKET_KEY_1_RTT;
     }
 
     if (Connection->State.EncryptionEnabled &&
@@ -3366,10 +3930,12 @@ QuicConnRecvFrames(
     while (Offset < PayloadLength) {
 
         //
-        // Read the frame type.
+        // Read the frame type. Extension frame types don't fit in a single
+        // byte, so the type is always decoded as a variable-length integer.
         //
-        QUIC_FRAME_TYPE FrameType = Payload[Offset];
-        if (FrameType > MAX_QUIC_FRAME) {
+        QUIC_VAR_INT FrameType64;
+        if (!QuicVarIntDecode(PayloadLength, Payload, &Offset, &FrameType64) ||
+            !QUIC_FRAME_IS_KNOWN(FrameType64)) {
             QuicTraceEvent(
                 ConnError,
                 "[conn][%p] ERROR, %s.",
@@ -3378,6 +3944,7 @@ QuicConnRecvFrames(
             QuicConnTransportError(Connection, QUIC_ERROR_FRAME_ENCODING_ERROR);
             return FALSE;
         }
+        QUIC_FRAME_TYPE FrameType = (QUIC_FRAME_TYPE)FrameType64;
 
         //
         // Validate allowable frames based on the packet type.
@@ -3415,6 +3982,7 @@ QuicConnRecvFrames(
             case QUIC_FRAME_ACK:
             case QUIC_FRAME_ACK_1:
             case QUIC_FRAME_HANDSHAKE_DONE:
+            case QUIC_FRAME_ACK_FREQUENCY:
                 QuicTraceEvent(
                     ConnErrorStatus,
                     "[conn][%p] ERROR, %u, %s.",
@@ -3431,8 +3999,6 @@ QuicConnRecvFrames(
             }
         }
 
-        Offset += sizeof(uint8_t);
-
         //
         // Process the frame based on the frame type.
         //
@@ -3459,11 +4025,14 @@ QuicConnRecvFrames(
         case QUIC_FRAME_ACK:
         case QUIC_FRAME_ACK_1: {
             BOOLEAN InvalidAckFrame;
+            uint64_t ProfileStart =
+                MsQuicLib.PacketStageProfiling ? QuicCpuCycles() : 0;
             if (!QuicLossDetectionProcessAckFrame(
                     &Connection->LossDetection,
                     Path,
                     EncryptLevel,
                     FrameType,
+                    QuicDataPathRecvPacketToRecvDatagram(Packet)->RecvTimeUs,
                     PayloadLength,
                     Payload,
                     &Offset,
@@ -3478,6 +4047,10 @@ QuicConnRecvFrames(
                 }
                 return FALSE;
             }
+            if (MsQuicLib.PacketStageProfiling) {
+                Connection->RxStageProfile.AckCycles +=
+                    QuicCpuCycles() - ProfileStart;
+            }
 
             Packet->HasNonProbingFrame = TRUE;
             break;
@@ -3920,7 +4493,7 @@ QuicConnRecvFrames(
                     &IsLastCid);
             if (SourceCid != NULL) {
                 BOOLEAN CidAlreadyRetired = SourceCid->CID.Retired;
-                QUIC_FREE(SourceCid);
+                QuicCidFreeSource(SourceCid);
                 if (IsLastCid) {
                     QuicTraceEvent(
                         ConnError,
@@ -4065,6 +4638,86 @@ QuicConnRecvFrames(
             break;
         }
 
+        case QUIC_FRAME_DATAGRAM:
+        case QUIC_FRAME_DATAGRAM_1: {
+            if (!Connection->Datagram.ReceiveEnabled) {
+                QuicTraceEvent(
+                    ConnError,
+                    "[conn][%p] ERROR, %s.",
+                    Connection,
+                    "Received DATAGRAM frame when not negotiated");
+                QuicConnTransportError(Connection, QUIC_ERROR_PROTOCOL_VIOLATION);
+                return FALSE;
+            }
+
+            QUIC_DATAGRAM_EX Frame;
+            if (!QuicDatagramFrameDecode(FrameType, PayloadLength, Payload, &Offset, &Frame)) {
+                QuicTraceEvent(
+                    ConnError,
+                    "[conn][%p] ERROR, %s.",
+                    Connection,
+                    "Decoding DATAGRAM frame");
+                QuicConnTransportError(Connection, QUIC_ERROR_FRAME_ENCODING_ERROR);
+                return FALSE;
+            }
+
+            if (Closed) {
+                break; // Ignore frame if we are closed.
+            }
+
+            QuicDatagramIndicateReceive(&Connection->Datagram, &Frame);
+
+            Packet->HasNonProbingFrame = TRUE;
+            break;
+        }
+
+        case QUIC_FRAME_ACK_FREQUENCY: {
+            QUIC_ACK_FREQUENCY_EX Frame;
+            if (!QuicAckFrequencyFrameDecode(PayloadLength, Payload, &Offset, &Frame)) {
+                QuicTraceEvent(
+                    ConnError,
+                    "[conn][%p] ERROR, %s.",
+                    Connection,
+                    "Decoding ACK_FREQUENCY frame");
+                QuicConnTransportError(Connection, QUIC_ERROR_FRAME_ENCODING_ERROR);
+                return FALSE;
+            }
+
+            if (Frame.PacketTolerance == 0 ||
+                Frame.UpdateMaxAckDelay < MS_TO_US((uint32_t)MsQuicLib.TimerResolutionMs)) {
+                QuicTraceEvent(
+                    ConnError,
+                    "[conn][%p] ERROR, %s.",
+                    Connection,
+                    "Invalid ACK_FREQUENCY frame values");
+                QuicConnTransportError(Connection, QUIC_ERROR_PROTOCOL_VIOLATION);
+                return FALSE;
+            }
+
+            if (Closed) {
+                break; // Ignore frame if we are closed.
+            }
+
+            if (Frame.SequenceNumber < Connection->NextRecvAckFreqSeqNum) {
+                break; // Reordered, stale packet tolerance update. Ignore.
+            }
+
+            Connection->NextRecvAckFreqSeqNum = Frame.SequenceNumber + 1;
+            Connection->PacketTolerance =
+                Frame.PacketTolerance > UINT8_MAX ?
+                    UINT8_MAX : (uint8_t)Frame.PacketTolerance;
+            Connection->MaxAckDelayMs = (uint32_t)US_TO_MS(Frame.UpdateMaxAckDelay);
+            QuicTraceLogConnVerbose(
+                UpdatePacketTolerance,
+                Connection,
+                "Updating packet tolerance to %hhu",
+                Connection->PacketTolerance);
+
+            AckPacketImmediately = TRUE;
+            Packet->HasNonProbingFrame = TRUE;
+            break;
+        }
+
         default:
             //
             // No default case necessary, as we have already validated the frame
@@ -4097,6 +4750,8 @@ Done:
         QuicAckTrackerAckPacket(
             &Connection->Packets[EncryptLevel]->AckTracker,
             Packet->PacketNumber,
+            QUIC_ECN_FROM_TOS(
+                QuicDataPathRecvPacketToRecvDatagram(Packet)->TypeOfService),
             AckPacketImmediately);
     }
 
@@ -4148,7 +4803,7 @@ QuicConnRecvPostProcessing(
                             NextSourceCid->CID.SequenceNumber,
                             NextSourceCid->CID.Length,
                             NextSourceCid->CID.Data);
-                        QUIC_FREE(NextSourceCid);
+                        QuicCidFreeSource(NextSourceCid);
                     }
                 }
             } else {
@@ -4160,7 +4815,14 @@ QuicConnRecvPostProcessing(
     if (!(*Path)->GotValidPacket) {
         (*Path)->GotValidPacket = TRUE;
 
-        if (!(*Path)->IsActive) {
+        if (Connection->State.HandshakeRacing) {
+            //
+            // First valid server packet while racing the handshake over two
+            // local interfaces: the path it arrived on wins the race.
+            //
+            QuicConnResolveHandshakeRacing(Connection, Path);
+
+        } else if (!(*Path)->IsActive) {
 
             //
             // This is the first valid packet received on this non-active path.
@@ -4216,6 +4878,80 @@ QuicConnRecvPostProcessing(
     }
 }
 
+//
+// Flushes the receive stage cycle accumulators into a single perf event
+// reporting the average per-packet cost of each stage over the window.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnRxStageProfileFlush(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    uint32_t Count = Connection->RxStageProfile.PacketCount;
+    QUIC_DBG_ASSERT(Count != 0);
+
+    uint64_t Parse = Connection->RxStageProfile.ParseCycles / Count;
+    uint64_t Crypto = Connection->RxStageProfile.CryptoCycles / Count;
+    uint64_t Frame = Connection->RxStageProfile.FrameCycles / Count;
+    uint64_t Ack = Connection->RxStageProfile.AckCycles / Count;
+
+    QuicPerfEventRingWrite(
+        &Connection->Worker->PerfEvents,
+        QUIC_PERF_EVENT_RX_STAGES,
+        (uint64_t)(uintptr_t)Connection,
+        min(Parse, 0xFFFFull) |
+        (min(Crypto, 0xFFFFull) << 16) |
+        (min(Frame, 0xFFFFull) << 32) |
+        (min(Ack, 0xFFFFull) << 48));
+
+    QuicZeroMemory(
+        &Connection->RxStageProfile, sizeof(Connection->RxStageProfile));
+}
+
+//
+// Indicates any stream data made ready by the packets processed so far,
+// without waiting for the rest of the datagram chain to drain. The receive
+// flush operations are pulled straight off the operation queue so the data
+// doesn't sit behind the remainder of the receive processing.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnFlushStreamRecv(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    QUIC_OPERATION* BatchOpers[QUIC_MAX_BATCHED_RECEIVE_COUNT];
+    QUIC_STREAM* BatchStreams[QUIC_MAX_BATCHED_RECEIVE_COUNT];
+    uint32_t BatchCount = 0;
+
+    while (BatchCount < QUIC_MAX_BATCHED_RECEIVE_COUNT &&
+        (BatchOpers[BatchCount] =
+            QuicOperationDequeueType(
+                &Connection->OperQ,
+                QUIC_OPER_TYPE_FLUSH_STREAM_RECV)) != NULL) {
+        BatchStreams[BatchCount] =
+            BatchOpers[BatchCount]->FLUSH_STREAM_RECEIVE.Stream;
+        BatchCount++;
+    }
+
+    if (BatchCount == 0) {
+        return;
+    }
+
+    if (Connection->State.BatchedReceiveEnabled) {
+        QuicStreamRecvFlushBatch(Connection, BatchStreams, BatchCount);
+    } else {
+        for (uint32_t i = 0; i < BatchCount; ++i) {
+            QuicStreamRecvFlush(BatchStreams[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < BatchCount; ++i) {
+        QuicOperationFree(Connection->Worker, BatchOpers[i]);
+    }
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicConnRecvDatagramBatch(
@@ -4229,6 +4965,8 @@ QuicConnRecvDatagramBatch(
     )
 {
     uint8_t HpMask[QUIC_HP_SAMPLE_LENGTH * QUIC_MAX_CRYPTO_BATCH_COUNT];
+    const BOOLEAN Profiling = MsQuicLib.PacketStageProfiling;
+    uint64_t ProfileStart = 0;
 
     QUIC_DBG_ASSERT(BatchCount > 0 && BatchCount <= QUIC_MAX_CRYPTO_BATCH_COUNT);
     QUIC_RECV_PACKET* Packet = QuicDataPathRecvDatagramToRecvPacket(Datagrams[0]);
@@ -4244,6 +4982,10 @@ QuicConnRecvDatagramBatch(
         return;
     }
 
+    if (Profiling) {
+        ProfileStart = QuicCpuCycles();
+    }
+
     if (Connection->State.EncryptionEnabled &&
         Connection->State.HeaderProtectionEnabled) {
         if (QUIC_FAILED(
@@ -4259,12 +5001,60 @@ QuicConnRecvDatagramBatch(
         QuicZeroMemory(HpMask, BatchCount * QUIC_HP_SAMPLE_LENGTH);
     }
 
+    if (Profiling) {
+        Connection->RxStageProfile.CryptoCycles +=
+            QuicCpuCycles() - ProfileStart;
+    }
+
+    //
+    // Defer the per-packet ACK scheduling work while draining the batch, so
+    // the timestamping and send/timer decisions are paid once per batch
+    // instead of once per packet.
+    //
+    QUIC_ENCRYPT_LEVEL EncryptLevel = QuicKeyTypeToEncryptLevel(Packet->KeyType);
+    QuicAckTrackerBatchBegin(&Connection->Packets[EncryptLevel]->AckTracker);
+
+    //
+    // The batch is processed in stages, each a tight loop over the whole
+    // batch: header-protection removal and packet number decode first, then
+    // payload decryption, then frame processing. Keeping each stage's code
+    // and data hot across the batch beats interleaving the stages per
+    // packet, and gives the crypto stage contiguous work to batch.
+    //
+    BOOLEAN Decrypted[QUIC_MAX_CRYPTO_BATCH_COUNT];
+
+    if (Profiling) {
+        ProfileStart = QuicCpuCycles();
+    }
+
     for (uint8_t i = 0; i < BatchCount; ++i) {
         QUIC_DBG_ASSERT(Datagrams[i]->Allocated);
+        Decrypted[i] =
+            QuicConnRecvPrepareDecrypt(
+                Connection,
+                QuicDataPathRecvDatagramToRecvPacket(Datagrams[i]),
+                HpMask + i * QUIC_HP_SAMPLE_LENGTH);
+    }
+
+    for (uint8_t i = 0; i < BatchCount; ++i) {
+        if (Decrypted[i]) {
+            Decrypted[i] =
+                QuicConnRecvDecryptAndAuthenticate(
+                    Connection,
+                    Path,
+                    QuicDataPathRecvDatagramToRecvPacket(Datagrams[i]));
+        }
+    }
+
+    if (Profiling) {
+        uint64_t Now = QuicCpuCycles();
+        Connection->RxStageProfile.CryptoCycles += Now - ProfileStart;
+        ProfileStart = Now;
+    }
+
+    for (uint8_t i = 0; i < BatchCount; ++i) {
         Packet = QuicDataPathRecvDatagramToRecvPacket(Datagrams[i]);
-        if (QuicConnRecvPrepareDecrypt(
-                Connection, Packet, HpMask + i * QUIC_HP_SAMPLE_LENGTH) &&
-            QuicConnRecvDecryptAndAuthenticate(Connection, Path, Packet) &&
+        if (Decrypted[i] &&
             QuicConnRecvFrames(Connection, Path, Packet)) {
 
             QuicConnRecvPostProcessing(Connection, &Path, Packet);
@@ -4283,12 +5073,38 @@ QuicConnRecvDatagramBatch(
                 } else {
                     Path->SpinBit = !Packet->SH->SpinBit;
                 }
+                QuicPathBumpVersion(Path);
             }
 
         } else {
             Connection->Stats.Recv.DroppedPackets++;
         }
     }
+
+    if (Profiling) {
+        Connection->RxStageProfile.FrameCycles +=
+            QuicCpuCycles() - ProfileStart;
+        Connection->RxStageProfile.PacketCount += BatchCount;
+        if (Connection->RxStageProfile.PacketCount >=
+                QUIC_RX_STAGE_PROFILE_WINDOW) {
+            QuicConnRxStageProfileFlush(Connection);
+        }
+    }
+
+    if (Connection->Packets[EncryptLevel] != NULL) {
+        //
+        // The packet space can be discarded while processing the batch (e.g.
+        // handshake completion), taking its ack tracker with it.
+        //
+        QuicAckTrackerBatchEnd(&Connection->Packets[EncryptLevel]->AckTracker);
+    }
+
+    //
+    // Deliver any stream data this batch produced before moving on to the
+    // rest of the datagram chain, so the first bytes of a coalesced datagram
+    // don't wait on packets that haven't been decrypted yet.
+    //
+    QuicConnFlushStreamRecv(Connection);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -4400,10 +5216,18 @@ QuicConnRecvDatagrams(
                     Datagram->BufferLength - (uint16_t)(Packet->Buffer - Datagram->Buffer);
             }
 
-            if (!QuicConnRecvHeader(
+            uint64_t ProfileStart =
+                MsQuicLib.PacketStageProfiling ? QuicCpuCycles() : 0;
+            BOOLEAN HeaderValid =
+                QuicConnRecvHeader(
                     Connection,
                     Packet,
-                    Cipher + BatchCount * QUIC_HP_SAMPLE_LENGTH)) {
+                    Cipher + BatchCount * QUIC_HP_SAMPLE_LENGTH);
+            if (MsQuicLib.PacketStageProfiling) {
+                Connection->RxStageProfile.ParseCycles +=
+                    QuicCpuCycles() - ProfileStart;
+            }
+            if (!HeaderValid) {
                 if (Packet->DecryptionDeferred) {
                     Connection->Stats.Recv.TotalPackets--; // Don't count the packet right now.
                 } else {
@@ -4491,7 +5315,7 @@ QuicConnRecvDatagrams(
                         &RecvState);
                     BatchCount = 0;
                 }
-                QuicDataPathBindingReturnRecvDatagrams(ReleaseChain);
+                QuicWorkerQueueRecvRelease(Connection->Worker, ReleaseChain);
                 ReleaseChain = NULL;
                 ReleaseChainTail = &ReleaseChain;
                 ReleaseChainCount = 0;
@@ -4515,7 +5339,7 @@ QuicConnRecvDatagrams(
     }
 
     if (ReleaseChain != NULL) {
-        QuicDataPathBindingReturnRecvDatagrams(ReleaseChain);
+        QuicWorkerQueueRecvRelease(Connection->Worker, ReleaseChain);
     }
 
     //
@@ -4525,7 +5349,8 @@ QuicConnRecvDatagrams(
     // to the array shifting that happens in QuicPathRemove.
     //
     for (uint8_t i = Connection->PathsCount - 1; i > 0; --i) {
-        if (!Connection->Paths[i].GotValidPacket) {
+        if (!Connection->Paths[i].GotValidPacket &&
+            !Connection->Paths[i].IsRacing) {
             QuicTraceLogConnInfo(
                 PathDiscarded,
                 Connection,
@@ -4543,6 +5368,19 @@ QuicConnRecvDatagrams(
         QuicConnGenerateNewSourceCids(Connection, TRUE);
         Connection->State.UpdateWorker = TRUE;
     }
+
+    //
+    // Expedite path validation: if any surviving path owes a PATH_RESPONSE
+    // for a challenge processed above, echo it now instead of waiting for the
+    // queued send flush. A migrating peer is blocked on exactly this packet,
+    // so the queue delay shows up directly as a migration pause.
+    //
+    if ((Connection->Send.SendFlags & QUIC_CONN_SEND_FLAG_PATH_RESPONSE) &&
+        Connection->Crypto.TlsState.WriteKeys[QUIC_PACKET_KEY_1_RTT] != NULL &&
+        !Connection->State.ClosedLocally) {
+        Connection->Send.SendFlags &= ~QUIC_CONN_SEND_FLAG_PATH_RESPONSE;
+        QuicSendPathResponses(&Connection->Send);
+    }
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -4681,6 +5519,20 @@ QuicConnResetIdleTimeout(
     )
 {
     uint64_t IdleTimeoutMs;
+
+    if (Connection->State.Hibernated) {
+        //
+        // Traffic again; the connection is no longer hibernated. The memory
+        // released on hibernation reallocates on demand, so clearing the flag
+        // is all the rehydration that is needed.
+        //
+        Connection->State.Hibernated = FALSE;
+        QuicTraceLogConnVerbose(
+            Rehydrate,
+            Connection,
+            "Rehydrated from hibernation");
+    }
+
     if (Connection->State.Connected) {
         //
         // Use the (non-zero) min value between local and peer's configuration.
@@ -4717,7 +5569,16 @@ QuicConnResetIdleTimeout(
         QuicConnTimerSet(
             Connection,
             QUIC_CONN_TIMER_KEEP_ALIVE,
-            Connection->KeepAliveIntervalMs);
+            Connection->CurrentKeepAliveIntervalMs);
+    }
+
+    if (Connection->State.Connected &&
+        Connection->Session != NULL &&
+        Connection->Session->Settings.HibernationIdleTimeoutMs != 0) {
+        QuicConnTimerSet(
+            Connection,
+            QUIC_CONN_TIMER_HIBERNATE,
+            Connection->Session->Settings.HibernationIdleTimeoutMs);
     }
 }
 
@@ -4743,6 +5604,37 @@ QuicConnProcessKeepAliveOperation(
     _In_ QUIC_CONNECTION* Connection
     )
 {
+    //
+    // The timer firing means a full effective interval passed with no
+    // activity. If the previous keep alive still got a response in its
+    // interval, the NAT binding demonstrably survives the current spacing,
+    // so stretch it out (bounded) to cut idle wakeups and PING encrypts.
+    // An unanswered keep alive drops back to the configured interval.
+    //
+    if (Connection->KeepAliveLastRecvPackets != 0 &&
+        Connection->CurrentKeepAliveIntervalMs != 0) {
+        if (Connection->Stats.Recv.TotalPackets !=
+            Connection->KeepAliveLastRecvPackets) {
+            uint64_t Extended =
+                min(
+                    2ULL * Connection->CurrentKeepAliveIntervalMs,
+                    (uint64_t)Connection->KeepAliveIntervalMs *
+                        QUIC_KEEP_ALIVE_EXTENSION_LIMIT);
+            if (Extended != Connection->CurrentKeepAliveIntervalMs) {
+                Connection->CurrentKeepAliveIntervalMs = (uint32_t)Extended;
+                QuicTraceLogConnVerbose(
+                    KeepAliveIntervalExtended,
+                    Connection,
+                    "Keep alive interval extended to %u ms",
+                    Connection->CurrentKeepAliveIntervalMs);
+            }
+        } else {
+            Connection->CurrentKeepAliveIntervalMs =
+                Connection->KeepAliveIntervalMs;
+        }
+    }
+    Connection->KeepAliveLastRecvPackets = Connection->Stats.Recv.TotalPackets;
+
     //
     // Send a PING frame to keep the connection alive.
     //
@@ -4755,7 +5647,94 @@ QuicConnProcessKeepAliveOperation(
     QuicConnTimerSet(
         Connection,
         QUIC_CONN_TIMER_KEEP_ALIVE,
-        Connection->KeepAliveIntervalMs);
+        Connection->CurrentKeepAliveIntervalMs);
+}
+
+//
+// Re-reads the session's current settings snapshot and applies the subset
+// that is safe to change on a live connection: local timeouts, keep-alive
+// and send-side behavior knobs. Values the peer has already been told about
+// in the transport parameters (max ACK delay, stream counts, flow control
+// windows) and in-flight congestion control state are deliberately left
+// alone; those only apply to new connections.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnSettingsUpdateOper(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    if (Connection->Session == NULL) {
+        return; // Already unregistered from the session.
+    }
+
+    const QUIC_SETTINGS* Settings =
+        &Connection->Session->SettingsSnapshot->Settings;
+
+    Connection->State.UsePacing = Settings->PacingDefault;
+    Connection->AckPiggybackDelayUs = Settings->AckPiggybackDelayUs;
+    Connection->DisconnectTimeoutUs = MS_TO_US(Settings->DisconnectTimeoutMs);
+
+    //
+    // The idle timer re-derives its effective timeout (capped by the peer's
+    // advertised idle timeout) every time it is reset, so the new value takes
+    // effect on the next packet exchange.
+    //
+    Connection->IdleTimeoutMs = Settings->IdleTimeoutMs;
+    Connection->HandshakeIdleTimeoutMs = Settings->HandshakeIdleTimeoutMs;
+
+    if (Connection->KeepAliveIntervalMs != Settings->KeepAliveIntervalMs) {
+        if (Connection->State.Started &&
+            Connection->KeepAliveIntervalMs != 0) {
+            QuicConnTimerCancel(Connection, QUIC_CONN_TIMER_KEEP_ALIVE);
+        }
+        Connection->KeepAliveIntervalMs = Settings->KeepAliveIntervalMs;
+        Connection->CurrentKeepAliveIntervalMs = Settings->KeepAliveIntervalMs;
+        Connection->KeepAliveLastRecvPackets = 0; // Restart interval extension.
+        if (Connection->State.Started &&
+            Connection->KeepAliveIntervalMs != 0) {
+            QuicConnProcessKeepAliveOperation(Connection);
+        }
+    }
+
+    QuicTraceLogConnInfo(
+        ApplyLiveSettings,
+        Connection,
+        "Applied updated settings to live connection");
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnProcessHibernateTimerOperation(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    //
+    // The connection has been idle long enough to shed the memory that only
+    // matters while traffic is flowing. Everything released here reallocates
+    // on demand, so the next packet rehydrates the connection lazily. The
+    // timer is one-shot; activity re-arms it via QuicConnResetIdleTimeout.
+    //
+    if (!Connection->State.Connected ||
+        Connection->State.ClosedLocally ||
+        Connection->State.ClosedRemotely ||
+        Connection->State.Hibernated) {
+        return;
+    }
+
+    QuicSendFreeRetransmitCache(&Connection->Send);
+    QuicRecvBufferShrink(
+        &Connection->Crypto.RecvBuffer,
+        QUIC_DEFAULT_STREAM_RECV_BUFFER_SIZE);
+    QuicStreamSetHibernate(
+        &Connection->Streams,
+        Connection->Session->Settings.StreamRecvBufferDefault);
+
+    Connection->State.Hibernated = TRUE;
+    QuicTraceLogConnVerbose(
+        Hibernate,
+        Connection,
+        "Hibernated after idle period");
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -4831,6 +5810,7 @@ QuicConnParamSet(
 
         Connection->State.LocalAddressSet = TRUE;
         QuicCopyMemory(&Connection->Paths[0].LocalAddress, Buffer, sizeof(QUIC_ADDR));
+        QuicPathInvalidateSendCache(&Connection->Paths[0]);
         QuicTraceEvent(
             ConnLocalAddrAdded,
             "[conn][%p] New Local IP: %!SOCKADDR!",
@@ -4891,6 +5871,33 @@ QuicConnParamSet(
         break;
     }
 
+    case QUIC_PARAM_CONN_RACING_LOCAL_ADDRESS: {
+
+        if (BufferLength != sizeof(QUIC_ADDR)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (QuicConnIsServer(Connection) || Connection->State.Started) {
+            Status = QUIC_STATUS_INVALID_STATE;
+            break;
+        }
+
+        const QUIC_ADDR* LocalAddress = (const QUIC_ADDR*)Buffer;
+
+        if (!QuicAddrIsValid(LocalAddress)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        QuicCopyMemory(
+            &Connection->RacingLocalAddress, Buffer, sizeof(QUIC_ADDR));
+        Connection->State.RacingLocalAddressSet = TRUE;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
     case QUIC_PARAM_CONN_REMOTE_ADDRESS: {
 
         if (BufferLength != sizeof(QUIC_ADDR)) {
@@ -4910,6 +5917,7 @@ QuicConnParamSet(
 
         Connection->State.RemoteAddressSet = TRUE;
         QuicCopyMemory(&Connection->Paths[0].RemoteAddress, Buffer, sizeof(QUIC_ADDR));
+        QuicPathInvalidateSendCache(&Connection->Paths[0]);
         //
         // Don't log new Remote address added here because it is logged when
         // the connection is started.
@@ -5054,6 +6062,8 @@ QuicConnParamSet(
         }
 
         Connection->KeepAliveIntervalMs = *(uint32_t*)Buffer;
+        Connection->CurrentKeepAliveIntervalMs = Connection->KeepAliveIntervalMs;
+        Connection->KeepAliveLastRecvPackets = 0; // Restart interval extension.
 
         QuicTraceLogConnInfo(
             UpdateKeepAlive,
@@ -5218,6 +6228,83 @@ QuicConnParamSet(
         break;
     }
 
+    case QUIC_PARAM_CONN_DATAGRAM_RECEIVE_ENABLED:
+
+        if (BufferLength != sizeof(uint8_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (Connection->State.Started) {
+            //
+            // Can't change after the transport parameters have been sent.
+            //
+            Status = QUIC_STATUS_INVALID_STATE;
+            break;
+        }
+
+        Connection->Datagram.ReceiveEnabled = *(uint8_t*)Buffer != 0;
+
+        QuicTraceLogConnVerbose(
+            DatagramReceiveEnableUpdated,
+            Connection,
+            "Updated datagram receive enabled to %hhu",
+            Connection->Datagram.ReceiveEnabled);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_INLINE_API_SEND:
+
+        if (BufferLength != sizeof(uint8_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+        Connection->State.InlineApiSend = *(uint8_t*)Buffer;
+
+        QuicTraceLogConnInfo(
+            UpdateInlineApiSend,
+            Connection,
+            "Updated InlineApiSend = %hhu",
+            Connection->State.InlineApiSend);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_BATCHED_RECEIVE_ENABLED:
+
+        if (BufferLength != sizeof(uint8_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+        Connection->State.BatchedReceiveEnabled = *(uint8_t*)Buffer;
+
+        QuicTraceLogConnInfo(
+            UpdateBatchedReceiveEnabled,
+            Connection,
+            "Updated BatchedReceiveEnabled = %hhu",
+            Connection->State.BatchedReceiveEnabled);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_BATCHED_SEND_COMPLETE_ENABLED:
+
+        if (BufferLength != sizeof(uint8_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+        Connection->State.BatchedSendCompleteEnabled = *(uint8_t*)Buffer;
+
+        QuicTraceLogConnInfo(
+            UpdateBatchedSendCompleteEnabled,
+            Connection,
+            "Updated BatchedSendCompleteEnabled = %hhu",
+            Connection->State.BatchedSendCompleteEnabled);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     case QUIC_PARAM_CONN_FORCE_KEY_UPDATE:
 
         if (!Connection->State.Connected ||
@@ -5510,6 +6597,9 @@ QuicConnParamGet(
         Stats->Timing.Start = Connection->Stats.Timing.Start;
         Stats->Timing.InitialFlightEnd = Connection->Stats.Timing.InitialFlightEnd;
         Stats->Timing.HandshakeFlightEnd = Connection->Stats.Timing.HandshakeFlightEnd;
+        Stats->Timing.FirstPacketRecv = Connection->Stats.Timing.FirstPacketRecv;
+        Stats->Timing.HandshakeComplete = Connection->Stats.Timing.HandshakeComplete;
+        Stats->Timing.ConnectedCallback = Connection->Stats.Timing.ConnectedCallback;
         Stats->Send.PathMtu = Path->Mtu;
         Stats->Send.TotalPackets = Connection->Stats.Send.TotalPackets;
         Stats->Send.RetransmittablePackets = Connection->Stats.Send.RetransmittablePackets;
@@ -5527,11 +6617,29 @@ QuicConnParamGet(
         Stats->Recv.TotalStreamBytes = Connection->Stats.Recv.TotalStreamBytes;
         Stats->Recv.DecryptionFailures = Connection->Stats.Recv.DecryptionFailures;
         Stats->Misc.KeyUpdateCount = Connection->Stats.Misc.KeyUpdateCount;
+        Stats->Congestion.CongestionWindow =
+            Connection->CongestionControl.CongestionWindow;
+        Stats->Congestion.BytesInFlight =
+            Connection->CongestionControl.BytesInFlight;
+        Stats->SendBuffer.PostedBytes = Connection->SendBuffer.PostedBytes;
+        Stats->SendBuffer.IdealBytes = Connection->SendBuffer.IdealBytes;
+        Stats->SendBuffer.StallTimeUs = Connection->SendBuffer.TotalStallTimeUs;
+        Stats->SendBuffer.BufferedBytes = Connection->SendBuffer.BufferedBytes;
+        if (Connection->SendBuffer.StallStartTimeUs != 0) {
+            Stats->SendBuffer.StallTimeUs +=
+                QuicTimeDiff64(
+                    Connection->SendBuffer.StallStartTimeUs, QuicTimeUs64());
+        }
 
         if (Param == QUIC_PARAM_CONN_STATISTICS_PLAT) {
             Stats->Timing.Start = QuicTimeUs64ToPlat(Stats->Timing.Start);
             Stats->Timing.InitialFlightEnd = QuicTimeUs64ToPlat(Stats->Timing.InitialFlightEnd);
             Stats->Timing.HandshakeFlightEnd = QuicTimeUs64ToPlat(Stats->Timing.HandshakeFlightEnd);
+            if (Stats->Timing.FirstPacketRecv != 0) {
+                Stats->Timing.FirstPacketRecv = QuicTimeUs64ToPlat(Stats->Timing.FirstPacketRecv);
+            }
+            Stats->Timing.HandshakeComplete = QuicTimeUs64ToPlat(Stats->Timing.HandshakeComplete);
+            Stats->Timing.ConnectedCallback = QuicTimeUs64ToPlat(Stats->Timing.ConnectedCallback);
         }
 
         *BufferLength = sizeof(QUIC_STATISTICS);
@@ -5771,6 +6879,143 @@ QuicConnParamGet(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_CONN_DATAGRAM_RECEIVE_ENABLED:
+
+        if (*BufferLength < sizeof(uint8_t)) {
+            *BufferLength = sizeof(uint8_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint8_t);
+        *(uint8_t*)Buffer = Connection->Datagram.ReceiveEnabled;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_DATAGRAM_SEND_ENABLED:
+
+        if (*BufferLength < sizeof(uint8_t)) {
+            *BufferLength = sizeof(uint8_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint8_t);
+        *(uint8_t*)Buffer = Connection->Datagram.SendEnabled;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_INLINE_API_SEND:
+
+        if (*BufferLength < sizeof(uint8_t)) {
+            *BufferLength = sizeof(uint8_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint8_t);
+        *(uint8_t*)Buffer = Connection->State.InlineApiSend;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_BATCHED_RECEIVE_ENABLED:
+
+        if (*BufferLength < sizeof(uint8_t)) {
+            *BufferLength = sizeof(uint8_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint8_t);
+        *(uint8_t*)Buffer = Connection->State.BatchedReceiveEnabled;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_BATCHED_SEND_COMPLETE_ENABLED:
+
+        if (*BufferLength < sizeof(uint8_t)) {
+            *BufferLength = sizeof(uint8_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint8_t);
+        *(uint8_t*)Buffer = Connection->State.BatchedSendCompleteEnabled;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_CONN_DELIVERY_RATE: {
+
+        if (*BufferLength < sizeof(QUIC_DELIVERY_RATE_INFO)) {
+            *BufferLength = sizeof(QUIC_DELIVERY_RATE_INFO);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        QUIC_DELIVERY_RATE_INFO* Info = (QUIC_DELIVERY_RATE_INFO*)Buffer;
+        Info->DeliveryRate = Connection->LossDetection.DeliveryRate;
+        Info->MinRtt = Connection->Paths[0].MinRtt;
+        Info->AppLimited = Connection->LossDetection.DeliveryRateAppLimited;
+
+        *BufferLength = sizeof(QUIC_DELIVERY_RATE_INFO);
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
+    case QUIC_PARAM_CONN_MAX_STREAM_PACKET_PAYLOAD:
+
+        if (*BufferLength < sizeof(uint16_t)) {
+            *BufferLength = sizeof(uint16_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint16_t);
+        *(uint16_t*)Buffer = QuicConnGetMaxStreamPacketPayload(Connection);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -5847,6 +7092,10 @@ QuicConnProcessApiOperation(
                 ApiCtx->STRM_RECV_SET_ENABLED.IsEnabled);
         break;
 
+    case QUIC_API_TYPE_DATAGRAM_SEND:
+        QuicDatagramSendFlush(&Connection->Datagram);
+        break;
+
     case QUIC_API_TYPE_SET_PARAM:
         Status =
             QuicLibrarySetParam(
@@ -5898,6 +7147,9 @@ QuicConnProcessExpiredTimer(
     case QUIC_CONN_TIMER_KEEP_ALIVE:
         QuicConnProcessKeepAliveOperation(Connection);
         break;
+    case QUIC_CONN_TIMER_HIBERNATE:
+        QuicConnProcessHibernateTimerOperation(Connection);
+        break;
     case QUIC_CONN_TIMER_SHUTDOWN:
         QuicConnProcessShutdownTimerOperation(Connection);
         break;
@@ -5914,12 +7166,27 @@ QuicConnDrainOperations(
     )
 {
     QUIC_OPERATION* Oper;
-    const uint32_t MaxOperationCount =
+    const uint32_t DrainQuantum =
         (Connection->Session == NULL || Connection->Session->Registration == NULL) ?
             MsQuicLib.Settings.MaxOperationsPerDrain :
             Connection->Session->Settings.MaxOperationsPerDrain;
+    //
+    // The budget is one quantum plus any deficit carried over from previous
+    // drains whose backlog outran their budget, so a bulk connection ramps up
+    // to longer batches (fewer requeue round trips through the worker) while
+    // one that drains to empty stays at the base quantum and gets out of the
+    // way quickly.
+    //
+    const uint32_t MaxOperationCount = DrainQuantum + Connection->DrainDeficit;
+    const uint64_t DrainStartTime = QuicTimeUs64();
+    uint64_t PrevOperEndTime = DrainStartTime;
+    uint64_t ApiCallTimeUs = 0;
+    uint64_t FlushRecvTimeUs = 0;
+    uint64_t FlushSendTimeUs = 0;
+    uint64_t TimerTimeUs = 0;
     uint32_t OperationCount = 0;
     BOOLEAN HasMoreWorkToDo = TRUE;
+    BOOLEAN TimeSliceExpired = FALSE;
 
     QUIC_PASSIVE_CODE();
 
@@ -5954,6 +7221,7 @@ QuicConnDrainOperations(
         QuicOperLog(Connection, Oper);
 
         BOOLEAN FreeOper = Oper->FreeAfterProcess;
+        const QUIC_OPERATION_TYPE OperType = Oper->Type;
 
         switch (Oper->Type) {
 
@@ -5975,7 +7243,32 @@ QuicConnDrainOperations(
             break;
 
         case QUIC_OPER_TYPE_FLUSH_STREAM_RECV:
-            QuicStreamRecvFlush(Oper->FLUSH_STREAM_RECEIVE.Stream);
+            if (!Connection->State.BatchedReceiveEnabled) {
+                QuicStreamRecvFlush(Oper->FLUSH_STREAM_RECEIVE.Stream);
+            } else {
+                //
+                // Collect any immediately following stream receive flushes
+                // so all their data is delivered to the app in a single
+                // batched receive event.
+                //
+                QUIC_OPERATION* BatchOpers[QUIC_MAX_BATCHED_RECEIVE_COUNT - 1];
+                QUIC_STREAM* BatchStreams[QUIC_MAX_BATCHED_RECEIVE_COUNT];
+                uint32_t BatchCount = 1;
+                BatchStreams[0] = Oper->FLUSH_STREAM_RECEIVE.Stream;
+                while (BatchCount < QUIC_MAX_BATCHED_RECEIVE_COUNT &&
+                    (BatchOpers[BatchCount - 1] =
+                        QuicOperationDequeueIfType(
+                            &Connection->OperQ,
+                            QUIC_OPER_TYPE_FLUSH_STREAM_RECV)) != NULL) {
+                    BatchStreams[BatchCount] =
+                        BatchOpers[BatchCount - 1]->FLUSH_STREAM_RECEIVE.Stream;
+                    BatchCount++;
+                }
+                QuicStreamRecvFlushBatch(Connection, BatchStreams, BatchCount);
+                for (uint32_t i = 0; i < BatchCount - 1; ++i) {
+                    QuicOperationFree(Connection->Worker, BatchOpers[i]);
+                }
+            }
             break;
 
         case QUIC_OPER_TYPE_FLUSH_SEND:
@@ -6006,6 +7299,10 @@ QuicConnDrainOperations(
             QuicConnTraceRundownOper(Connection);
             break;
 
+        case QUIC_OPER_TYPE_SETTINGS_UPDATE:
+            QuicConnSettingsUpdateOper(Connection);
+            break;
+
         default:
             QUIC_FRE_ASSERT(FALSE);
             break;
@@ -6018,6 +7315,61 @@ QuicConnDrainOperations(
         }
 
         Connection->Stats.Schedule.OperationCount++;
+
+        //
+        // Attribute the service time to the operation type, reusing the
+        // timestamp the time-slice check below needs anyway. The per-drain
+        // accumulators are flushed to the counters in one batch at the end,
+        // so the per-operation cost is just the bucketing switch.
+        //
+        const uint64_t OperEndTime = QuicTimeUs64();
+        const uint64_t OperTimeUs = QuicTimeDiff64(PrevOperEndTime, OperEndTime);
+        PrevOperEndTime = OperEndTime;
+        switch (OperType) {
+        case QUIC_OPER_TYPE_API_CALL:
+            ApiCallTimeUs += OperTimeUs;
+            break;
+        case QUIC_OPER_TYPE_FLUSH_RECV:
+            FlushRecvTimeUs += OperTimeUs;
+            break;
+        case QUIC_OPER_TYPE_FLUSH_SEND:
+            FlushSendTimeUs += OperTimeUs;
+            break;
+        case QUIC_OPER_TYPE_TIMER_EXPIRED:
+            TimerTimeUs += OperTimeUs;
+            break;
+        default:
+            break;
+        }
+
+        if (QuicTimeDiff64(DrainStartTime, OperEndTime) >=
+                QUIC_MAX_DRAIN_TIME_US) {
+            //
+            // This connection has used up its time slice even though the
+            // operation budget isn't exhausted, so a few expensive operations
+            // can't convoy the worker's other connections. HasMoreWorkToDo
+            // stays TRUE, so the worker requeues this connection behind them.
+            //
+            TimeSliceExpired = TRUE;
+            break;
+        }
+    }
+
+    if (ApiCallTimeUs != 0) {
+        QuicPerfCounterAdd(
+            QUIC_PERF_COUNTER_OPER_API_CALL_TIME_US, ApiCallTimeUs);
+    }
+    if (FlushRecvTimeUs != 0) {
+        QuicPerfCounterAdd(
+            QUIC_PERF_COUNTER_OPER_FLUSH_RECV_TIME_US, FlushRecvTimeUs);
+    }
+    if (FlushSendTimeUs != 0) {
+        QuicPerfCounterAdd(
+            QUIC_PERF_COUNTER_OPER_FLUSH_SEND_TIME_US, FlushSendTimeUs);
+    }
+    if (TimerTimeUs != 0) {
+        QuicPerfCounterAdd(
+            QUIC_PERF_COUNTER_OPER_TIMER_TIME_US, TimerTimeUs);
     }
 
     if (!Connection->State.ExternalOwner && Connection->State.ClosedLocally) {
@@ -6052,12 +7404,43 @@ QuicConnDrainOperations(
         if (!Connection->State.Uninitialized) {
             QuicConnUninitialize(Connection);
         }
+        Connection->LossDetection.UpdateTimerPending = FALSE;
         HasMoreWorkToDo = FALSE;
+    } else {
+        //
+        // Loss detection timer updates requested during the drain above were
+        // coalesced into a single pending flag. Recompute the timer once now,
+        // which writes the timer wheel only if the earliest deadline changed.
+        //
+        QuicLossDetectionProcessDeferredTimerUpdate(&Connection->LossDetection);
     }
 
     QuicStreamSetDrainClosedStreams(&Connection->Streams);
 
+    //
+    // Return the packet metadata freed by the ACK processing above to the
+    // worker's pool now, in one batch, so the frees don't interleave with
+    // the parsing loops.
+    //
+    QuicLossDetectionProcessDeferredFrees(&Connection->LossDetection);
+
     QuicConnValidate(Connection);
 
+    if (HasMoreWorkToDo) {
+        //
+        // Don't grow the deficit when the drain ended on the time budget: the
+        // connection is limited by time, not the operation count, so a larger
+        // batch next visit would just go unused.
+        //
+        if (!TimeSliceExpired) {
+            Connection->DrainDeficit =
+                (uint16_t)min(
+                    Connection->DrainDeficit + DrainQuantum,
+                    DrainQuantum * QUIC_MAX_DRAIN_DEFICIT_QUANTA);
+        }
+    } else {
+        Connection->DrainDeficit = 0;
+    }
+
     return HasMoreWorkToDo;
 }
@@ -130,6 +130,18 @@ typedef union QUIC_CONNECTION_STATE {
         //
         BOOLEAN ShareBinding : 1;
 
+        //
+        // Indicates the app supplied an alternate local address to race the
+        // handshake over. Client only.
+        //
+        BOOLEAN RacingLocalAddressSet : 1;
+
+        //
+        // Indicates the handshake is currently being raced over two local
+        // interfaces and the winning path hasn't been decided yet.
+        //
+        BOOLEAN HandshakeRacing : 1;
+
         //
         // Indicates the TestTransportParameter variable has been set by the app.
         //
@@ -141,6 +153,41 @@ typedef union QUIC_CONNECTION_STATE {
         //
         BOOLEAN UseRoundRobinStreamScheduling : 1;
 
+        //
+        // Indicates stream sends may execute inline on the API thread when
+        // the connection is idle and uncontended, instead of always hopping
+        // to the worker thread. Requires API calls at passive level.
+        //
+        BOOLEAN InlineApiSend : 1;
+
+        //
+        // Indicates stream receive data is delivered in batched
+        // QUIC_CONNECTION_EVENT_BATCHED_RECEIVE events instead of per-stream
+        // QUIC_STREAM_EVENT_RECEIVE events.
+        //
+        BOOLEAN BatchedReceiveEnabled : 1;
+
+        //
+        // Indicates stream send completions are delivered in batched
+        // QUIC_STREAM_EVENT_BATCHED_SEND_COMPLETE events instead of one
+        // QUIC_STREAM_EVENT_SEND_COMPLETE event per send request.
+        //
+        BOOLEAN BatchedSendCompleteEnabled : 1;
+
+        //
+        // Indicates the connection has been idle long enough to hibernate:
+        // memory that only matters while traffic is flowing has been released
+        // and is reallocated on demand. Cleared on the next activity.
+        //
+        BOOLEAN Hibernated : 1;
+
+        //
+        // Indicates a session drain has already queued a shutdown for this
+        // connection, so later drain batches skip it. Only written under the
+        // session's ConnectionsLock by the drain thread.
+        //
+        BOOLEAN DrainShutdownQueued : 1;
+
 #ifdef QuicVerifierEnabledByAddr
         //
         // The calling app is being verified (app or driver verifier).
@@ -205,6 +252,9 @@ typedef struct QUIC_CONN_STATS {
         uint64_t Start;
         uint64_t InitialFlightEnd;      // Processed all peer's Initial packets
         uint64_t HandshakeFlightEnd;    // Processed all peer's Handshake packets
+        uint64_t FirstPacketRecv;       // Datapath receive of the first packet (server only)
+        uint64_t HandshakeComplete;     // TLS reported the handshake complete
+        uint64_t ConnectedCallback;     // CONNECTED event returned from the app
     } Timing;
 
     struct {
@@ -254,14 +304,180 @@ typedef struct QUIC_CONN_STATS {
 //   N.B. In general, all variables should only be written on the QUIC worker
 //        thread.
 //
-typedef struct QUIC_CONNECTION {
+// The struct is laid out in two halves: the fields at the top are the ones
+// touched for (almost) every packet on the receive and send paths, packed
+// together so those paths pull in as few cachelines as possible; everything
+// after the 'cold state' marker is only read at configuration time, during
+// the handshake or on rare control operations. Add new fields to the half
+// that matches their access pattern.
+//
+typedef struct QUIC_CACHEALIGN QUIC_CONNECTION {
 
     struct QUIC_HANDLE;
 
     //
-    // Link into the session's list of connections.
+    // The worker that is processing this connection.
     //
-    QUIC_LIST_ENTRY SessionLink;
+    QUIC_WORKER* Worker;
+
+    //
+    // Number of references to the handle.
+    //
+    long RefCount;
+
+#if DEBUG
+    short RefTypeCount[QUIC_CONN_REF_COUNT];
+#endif
+
+    //
+    // The current connnection state/flags.
+    //
+    QUIC_CONNECTION_STATE State;
+
+    //
+    // Runtime trace class enablement (QUIC_TRACE_CLASS_* flags), cached from
+    // the registration when the connection is registered with a session. Read
+    // by the class-gated trace macros on the packet paths.
+    //
+    uint32_t TraceClassMask;
+
+    //
+    // The current worker thread ID. 0 if not being processed right now.
+    //
+    QUIC_THREAD_ID WorkerThreadID;
+
+    //
+    // Indicates whether a worker is currently processing a connection.
+    // N.B. Multi-threaded access, synchronized by worker's connection lock.
+    //
+    BOOLEAN WorkerProcessing : 1;
+    BOOLEAN HasQueuedWork : 1;
+
+    //
+    // Indicates a worker wake was deferred because an API batch was open.
+    // N.B. Multi-threaded access, synchronized by worker's connection lock.
+    //
+    BOOLEAN ApiBatchWakePending : 1;
+
+    //
+    // Nesting depth of currently open API batches. While non-zero, worker
+    // wakes for newly queued operations are deferred to the batch commit.
+    // N.B. Multi-threaded access, synchronized by worker's connection lock.
+    //
+    uint8_t ApiBatchDepth;
+
+    //
+    // Set of current reasons sending more packets is currently blocked.
+    //
+    uint8_t OutFlowBlockedReasons; // Set of QUIC_FLOW_BLOCKED_* flags
+
+    //
+    // Number of paths the connection is currently tracking.
+    //
+    _Field_range_(0, QUIC_MAX_PATH_COUNT)
+    uint8_t PathsCount;
+
+    //
+    // The next identifier to use for a new path.
+    //
+    uint8_t NextPathId;
+
+    //
+    // Ack Delay Exponent. Used to scale actual wire encoded value by
+    // 2 ^ ack_delay_exponent.
+    //
+    uint8_t AckDelayExponent;
+
+    //
+    // The number of ACK eliciting packets we may receive before we must send
+    // an ACK. Updated by the peer via ACK_FREQUENCY frames.
+    //
+    uint8_t PacketTolerance;
+
+    //
+    // The number of ACK eliciting packets the peer may receive before it must
+    // send an ACK; the value carried in the last ACK_FREQUENCY frame we sent.
+    //
+    uint8_t PeerPacketTolerance;
+
+    //
+    // The number of skip list levels (including level 0) the connection is
+    // currently linked at.
+    //
+    uint8_t TimerSkipHeight;
+
+    //
+    // Maximum amount of time the connection waits before acknowledging a
+    // received packet.
+    //
+    uint32_t MaxAckDelayMs;
+
+    //
+    // The extra time (in us) a delayed ACK with no outbound data to carry it
+    // waits for data to piggyback on before being flushed standalone. Zero
+    // disables the extra wait.
+    //
+    uint32_t AckPiggybackDelayUs;
+
+    //
+    // Per-encryption level packet space information.
+    //
+    QUIC_PACKET_SPACE* Packets[QUIC_ENCRYPT_LEVEL_COUNT];
+
+    //
+    // Per-path state. The first entry in the list is the active path. All the
+    // rest (if any) are other tracked paths, sorted from most to least recently
+    // used.
+    //
+    QUIC_PATH Paths[QUIC_MAX_PATH_COUNT];
+
+    //
+    // The send manager for the connection.
+    //
+    QUIC_SEND Send;
+    QUIC_SEND_BUFFER SendBuffer;
+
+    //
+    // Manages all the information for outstanding sent packets.
+    //
+    QUIC_LOSS_DETECTION LossDetection;
+
+    //
+    // Congestion control state.
+    //
+    QUIC_CONGESTION_CONTROL CongestionControl;
+
+    //
+    // All the information and management logic for streams.
+    //
+    QUIC_STREAM_SET Streams;
+
+    //
+    // Working space for decoded ACK ranges. All ACK frames that are received
+    // are first decoded into this range.
+    //
+    QUIC_RANGE DecodedAckRanges;
+
+    //
+    // Receive packet queue.
+    //
+    uint32_t ReceiveQueueCount;
+    QUIC_RECV_DATAGRAM* ReceiveQueue;
+    QUIC_RECV_DATAGRAM** ReceiveQueueTail;
+    QUIC_DISPATCH_LOCK ReceiveQueueLock;
+
+    //
+    // The queue of operations to process.
+    //
+    QUIC_OPERATION_QUEUE OperQ;
+
+    //
+    // Deficit round robin credit for the operation drain, in operations.
+    // Grows (bounded) each time a drain ends with backlog remaining, so bulk
+    // connections earn longer batches, and resets once the queue is drained
+    // empty. Only accessed by the thread draining the connection.
+    //
+    uint16_t DrainDeficit;
 
     //
     // Link in the worker's connection queue.
@@ -270,104 +486,114 @@ typedef struct QUIC_CONNECTION {
     QUIC_LIST_ENTRY WorkerLink;
 
     //
-    // Link in the timer wheel's list.
+    // Level 0 link in the timer wheel slot's skip list. A NULL Flink
+    // indicates the connection is not currently in the timer wheel.
     //
     QUIC_LIST_ENTRY TimerLink;
 
     //
-    // The worker that is processing this connection.
+    // Links for the higher skip list levels. A connection of height H is
+    // linked at levels 1 through H-1 via TimerSkipLinks[0..H-2]. Only valid
+    // while the connection is in the timer wheel.
     //
-    QUIC_WORKER* Worker;
+    QUIC_LIST_ENTRY TimerSkipLinks[QUIC_TIMER_WHEEL_SKIP_LEVELS - 1];
 
     //
-    // The top level registration this connection is a part of.
+    // Sorted array of all timers for the connection.
     //
-    QUIC_REGISTRATION* Registration;
+    QUIC_CONN_TIMER_ENTRY Timers[QUIC_CONN_TIMER_COUNT];
 
     //
-    // The top level session this connection is a part of.
+    // The handler for the API client's callbacks.
     //
-    QUIC_SESSION* Session;
+    QUIC_CONNECTION_CALLBACK_HANDLER ClientCallbackHandler;
 
     //
-    // Number of references to the handle.
+    // Statistics
     //
-    long RefCount;
+    QUIC_CONN_STATS Stats;
 
-#if DEBUG
-    short RefTypeCount[QUIC_CONN_REF_COUNT];
-#endif
+    //
+    // Per-stage cycle accumulators for the receive path packet cost
+    // profiler. Only updated while the (global) packet stage profiling
+    // parameter is enabled; flushed into a QUIC_PERF_EVENT_RX_STAGES perf
+    // event every QUIC_RX_STAGE_PROFILE_WINDOW packets.
+    //
+    struct {
+        uint64_t ParseCycles;
+        uint64_t CryptoCycles;
+        uint64_t FrameCycles;
+        uint64_t AckCycles;
+        uint32_t PacketCount;
+    } RxStageProfile;
 
     //
-    // The current connnection state/flags.
+    // Manages the stream of cryptographic TLS data sent and received. The
+    // packet keys in TlsState are read per packet; the rest is handshake-only.
     //
-    QUIC_CONNECTION_STATE State;
+    QUIC_CRYPTO Crypto;
 
     //
-    // The current worker thread ID. 0 if not being processed right now.
+    // Manages the unreliable datagram extension.
     //
-    QUIC_THREAD_ID WorkerThreadID;
+    QUIC_DATAGRAM Datagram;
 
     //
-    // The set of ignore flags for server certificate validation to pass to TLS.
+    // Cold state. Everything below is configuration, handshake-only or
+    // rare-event state, not touched on the per-packet paths.
     //
-    uint32_t ServerCertValidationFlags;
 
     //
-    // The server ID for the connection ID.
+    // Link into the session's list of connections.
     //
-    uint8_t ServerID[MSQUIC_MAX_CID_SID_LENGTH];
+    QUIC_LIST_ENTRY SessionLink;
 
     //
-    // The partition ID for the connection ID.
+    // The top level registration this connection is a part of.
     //
-    uint8_t PartitionID;
+    QUIC_REGISTRATION* Registration;
 
     //
-    // Number of non-retired desintation CIDs we currently have cached.
+    // The top level session this connection is a part of.
     //
-    uint8_t DestCidCount;
+    QUIC_SESSION* Session;
 
     //
-    // The maximum number of source CIDs to give the peer. This is a minimum of
-    // what we're willing to support and what the peer is willing to accept.
+    // The set of ignore flags for server certificate validation to pass to TLS.
     //
-    uint8_t SourceCidLimit;
+    uint32_t ServerCertValidationFlags;
 
     //
-    // Number of paths the connection is currently tracking.
+    // The server ID for the connection ID.
     //
-    _Field_range_(0, QUIC_MAX_PATH_COUNT)
-    uint8_t PathsCount;
+    uint8_t ServerID[MSQUIC_MAX_CID_SID_LENGTH];
 
     //
-    // The next identifier to use for a new path.
+    // The partition ID for the connection ID.
     //
-    uint8_t NextPathId;
+    uint8_t PartitionID;
 
     //
-    // Indicates whether a worker is currently processing a connection.
-    // N.B. Multi-threaded access, synchronized by worker's connection lock.
+    // Number of non-retired desintation CIDs we currently have cached.
     //
-    BOOLEAN WorkerProcessing : 1;
-    BOOLEAN HasQueuedWork : 1;
+    uint8_t DestCidCount;
 
     //
-    // Set of current reasons sending more packets is currently blocked.
+    // The maximum number of source CIDs to give the peer. This is a minimum of
+    // what we're willing to support and what the peer is willing to accept.
     //
-    uint8_t OutFlowBlockedReasons; // Set of QUIC_FLOW_BLOCKED_* flags
+    uint8_t SourceCidLimit;
 
     //
-    // Ack Delay Exponent. Used to scale actual wire encoded value by
-    // 2 ^ ack_delay_exponent.
+    // The sequence number to use for the next ACK_FREQUENCY frame we send.
     //
-    uint8_t AckDelayExponent;
+    uint64_t SendAckFreqSeqNum;
 
     //
-    // Maximum amount of time the connection waits before acknowledging a
-    // received packet.
+    // The smallest sequence number we will accept in a received ACK_FREQUENCY
+    // frame. Smaller sequence numbers indicate stale (reordered) updates.
     //
-    uint32_t MaxAckDelayMs;
+    uint64_t NextRecvAckFreqSeqNum;
 
     //
     // The idle timeout period (in milliseconds).
@@ -390,6 +616,23 @@ typedef struct QUIC_CONNECTION {
     //
     uint32_t KeepAliveIntervalMs;
 
+    //
+    // The effective keep alive interval (in milliseconds) currently in use.
+    // Starts at KeepAliveIntervalMs and doubles, up to
+    // QUIC_KEEP_ALIVE_EXTENSION_LIMIT times the configured interval, each
+    // time a keep alive elicits a response after a full interval of silence;
+    // evidence the path's NAT binding survives the longer spacing. Falls back
+    // to the configured interval when a keep alive goes unanswered.
+    //
+    uint32_t CurrentKeepAliveIntervalMs;
+
+    //
+    // The value of Stats.Recv.TotalPackets when the last keep alive was sent.
+    // Zero means no keep alive has been sent yet. Used to tell whether
+    // anything (at minimum the keep alive's ACK) arrived since then.
+    //
+    uint64_t KeepAliveLastRecvPackets;
+
     //
     // The sequence number to use for the next source CID.
     //
@@ -402,16 +645,15 @@ typedef struct QUIC_CONNECTION {
     QUIC_VAR_INT RetirePriorTo;
 
     //
-    // Per-path state. The first entry in the list is the active path. All the
-    // rest (if any) are other tracked paths, sorted from most to least recently
-    // used.
+    // The list of connection IDs used for receiving.
     //
-    QUIC_PATH Paths[QUIC_MAX_PATH_COUNT];
+    QUIC_SINGLE_LIST_ENTRY SourceCids;
 
     //
-    // The list of connection IDs used for receiving.
+    // Pre-allocated backing storage for the source CID hash entries, so
+    // registering CIDs on the handshake path doesn't hit the allocator.
     //
-    QUIC_SINGLE_LIST_ENTRY SourceCids;
+    QUIC_CID_SLOT SourceCidSlots[QUIC_CONN_SOURCE_CID_SLOT_COUNT];
 
     //
     // The list of connection IDs used for sending. Given to us by the peer.
@@ -424,22 +666,18 @@ typedef struct QUIC_CONNECTION {
     QUIC_CID* OrigCID;
 
     //
-    // Sorted array of all timers for the connection.
+    // The alternate local address the client handshake is raced over, and
+    // the temporary lookup entry that routes the server's packets on the
+    // racing path's binding to this connection. The entry duplicates the
+    // connection's source CID bytes and is intentionally kept out of the
+    // SourceCids list; both are released when the race resolves.
     //
-    QUIC_CONN_TIMER_ENTRY Timers[QUIC_CONN_TIMER_COUNT];
+    QUIC_ADDR RacingLocalAddress;
+    QUIC_CID_HASH_ENTRY* RacingSourceCid;
 
     //
-    // Receive packet queue.
+    // Back up operation and API context for when the pools are exhausted.
     //
-    uint32_t ReceiveQueueCount;
-    QUIC_RECV_DATAGRAM* ReceiveQueue;
-    QUIC_RECV_DATAGRAM** ReceiveQueueTail;
-    QUIC_DISPATCH_LOCK ReceiveQueueLock;
-
-    //
-    // The queue of operations to process.
-    //
-    QUIC_OPERATION_QUEUE OperQ;
     QUIC_OPERATION BackUpOper;
     QUIC_API_CONTEXT BackupApiContext;
     uint16_t BackUpOperUsed;
@@ -466,6 +704,16 @@ typedef struct QUIC_CONNECTION {
     _Field_z_
     const char* RemoteServerName;
 
+    //
+    // The session connection pool key. Only set (before start) on client
+    // connections created through the ConnectionPoolGet API; NULL for
+    // connections that don't participate in the pool.
+    //
+    _Field_z_
+    char* PoolServerName;
+    uint16_t PoolServerNameLength;
+    uint16_t PoolServerPort;
+
     //
     // The entry into the remote hash lookup table, which is used only during the
     // handshake.
@@ -477,53 +725,6 @@ typedef struct QUIC_CONNECTION {
     //
     QUIC_TRANSPORT_PARAMETERS PeerTransportParams;
 
-    //
-    // Working space for decoded ACK ranges. All ACK frames that are received
-    // are first decoded into this range.
-    //
-    QUIC_RANGE DecodedAckRanges;
-
-    //
-    // All the information and management logic for streams.
-    //
-    QUIC_STREAM_SET Streams;
-
-    //
-    // Congestion control state.
-    //
-    QUIC_CONGESTION_CONTROL CongestionControl;
-
-    //
-    // Manages all the information for outstanding sent packets.
-    //
-    QUIC_LOSS_DETECTION LossDetection;
-
-    //
-    // Per-encryption level packet space information.
-    //
-    QUIC_PACKET_SPACE* Packets[QUIC_ENCRYPT_LEVEL_COUNT];
-
-    //
-    // Manages the stream of cryptographic TLS data sent and received.
-    //
-    QUIC_CRYPTO Crypto;
-
-    //
-    // The send manager for the connection.
-    //
-    QUIC_SEND Send;
-    QUIC_SEND_BUFFER SendBuffer;
-
-    //
-    // The handler for the API client's callbacks.
-    //
-    QUIC_CONNECTION_CALLBACK_HANDLER ClientCallbackHandler;
-
-    //
-    // Statistics
-    //
-    QUIC_CONN_STATS Stats;
-
     //
     // Mostly test specific state.
     //
@@ -629,6 +830,19 @@ QuicSendGetConnection(
     return QUIC_CONTAINING_RECORD(Send, QUIC_CONNECTION, Send);
 }
 
+//
+// Helper to get the owning QUIC_CONNECTION for the datagram module.
+//
+inline
+_Ret_notnull_
+QUIC_CONNECTION*
+QuicDatagramGetConnection(
+    _In_ QUIC_DATAGRAM* Datagram
+    )
+{
+    return QUIC_CONTAINING_RECORD(Datagram, QUIC_CONNECTION, Datagram);
+}
+
 //
 // Helper to get the owning QUIC_CONNECTION for the congestion control module.
 //
@@ -910,6 +1124,16 @@ QuicConnQueueTraceRundown(
     _In_ QUIC_CONNECTION* Connection
     );
 
+//
+// Queues an operation to re-read the session's settings snapshot and
+// hot-apply the subset that is safe to change on a live connection.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicConnQueueSettingsUpdate(
+    _In_ QUIC_CONNECTION* Connection
+    );
+
 //
 // Indicates an event to the application layer.
 //
@@ -920,6 +1144,27 @@ QuicConnIndicateEvent(
     _Inout_ QUIC_CONNECTION_EVENT* Event
     );
 
+//
+// Calculates a conservative maximum stream frame payload that fits in a
+// single short header packet on the active path, so apps can size their
+// writes to packet boundaries.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+uint16_t
+QuicConnGetMaxStreamPacketPayload(
+    _In_ const QUIC_CONNECTION* Connection
+    );
+
+//
+// Indicates the max stream payload per packet changed (e.g. a PMTU update)
+// to the application layer.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicConnIndicatePacketPayloadChanged(
+    _In_ QUIC_CONNECTION* Connection
+    );
+
 //
 // Allows the connection to drain some operations that it currently has
 // queued up. Returns TRUE if there are still work to do after the function
@@ -1184,6 +1429,17 @@ QuicConnProcessPeerTransportParameters(
     _In_ BOOLEAN FromCache
     );
 
+//
+// Updates the packet tolerance we request of the peer, queuing an
+// ACK_FREQUENCY frame if the value changed.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicConnUpdatePeerPacketTolerance(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ uint8_t NewPacketTolerance
+    );
+
 //
 // Configures the security config.
 //
@@ -33,7 +33,8 @@ QuicCryptoDumpSendState(
 
         QUIC_CONNECTION* Connection = QuicCryptoGetConnection(Crypto);
 
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             CryptoDump,
             Connection,
             "QS:%u MAX:%u UNA:%u NXT:%u RECOV:%u-%u",
@@ -48,7 +49,8 @@ QuicCryptoDumpSendState(
         uint32_t i = 0;
         QUIC_SUBRANGE* Sack;
         while ((Sack = QuicRangeGetSafe(&Crypto->SparseAckRanges, i++)) != NULL) {
-            QuicTraceLogConnVerbose(
+            QuicTraceLogConnVerboseClass(
+                QUIC_TRACE_CLASS_CRYPTO,
                 CryptoDumpUnacked,
                 Connection,
                 "  unACKed: [%llu, %llu]",
@@ -57,7 +59,8 @@ QuicCryptoDumpSendState(
             UnAcked = Sack->Low + Sack->Count;
         }
         if (UnAcked < (uint64_t)Crypto->MaxSentLength) {
-            QuicTraceLogConnVerbose(
+            QuicTraceLogConnVerboseClass(
+                QUIC_TRACE_CLASS_CRYPTO,
                 CryptoDumpUnacked2,
                 Connection,
                 "  unACKed: [%llu, %u]",
@@ -118,7 +121,7 @@ QuicCryptoInitialize(
             &Crypto->RecvBuffer,
             InitialRecvBufferLength,
             QUIC_DEFAULT_STREAM_FC_WINDOW_SIZE / 2,
-            TRUE);
+            QUIC_RECV_BUF_MODE_SINGLE); // TLS parsing needs contiguous data.
     if (QUIC_FAILED(Status)) {
         goto Exit;
     }
@@ -327,6 +330,14 @@ QuicCryptoHandshakeConfirmed(
     QuicBindingOnConnectionHandshakeConfirmed(Path->Binding, Connection);
 
     QuicCryptoDiscardKeys(Crypto, QUIC_PACKET_KEY_HANDSHAKE);
+
+    //
+    // Proactively derive the next generation of 1-RTT keys, so the first key
+    // update (send-triggered, peer initiated or forced by the app) doesn't
+    // have to run the key schedule inline on the packet path. If this fails
+    // the update sites still derive on demand.
+    //
+    (void)QuicCryptoGenerateNewKeys(Connection);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -345,7 +356,8 @@ QuicCryptoDiscardKeys(
     }
 
     QUIC_CONNECTION* Connection = QuicCryptoGetConnection(Crypto);
-    QuicTraceLogConnInfo(
+    QuicTraceLogConnInfoClass(
+        QUIC_TRACE_CLASS_CRYPTO,
         DiscardKeyType,
         Connection,
         "Discarding key type = %hhu",
@@ -393,7 +405,8 @@ QuicCryptoOnServerComplete(
     _In_ QUIC_CRYPTO* Crypto
     )
 {
-    QuicTraceLogConnInfo(
+    QuicTraceLogConnInfoClass(
+        QUIC_TRACE_CLASS_CRYPTO,
         CryptoStateDiscard,
         QuicCryptoGetConnection(Crypto),
         "Crypto/TLS state no longer needed");
@@ -471,7 +484,8 @@ QuicCryptoWriteOneFrame(
 
     uint16_t HeaderLength = sizeof(uint8_t) + QuicVarIntSize(CryptoOffset);
     if (BufferLength < *Offset + HeaderLength + 4) {
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             NoMoreRoomForCrypto,
             Connection,
             "No room for CRYPTO frame");
@@ -494,7 +508,8 @@ QuicCryptoWriteOneFrame(
     QUIC_DBG_ASSERT(Frame.Length > 0);
     *FramePayloadBytes = (uint16_t)Frame.Length;
 
-    QuicTraceLogConnVerbose(
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_CRYPTO,
         AddCryptoFrame,
         Connection,
         "Sending %hu crypto bytes, offset=%u",
@@ -828,7 +843,8 @@ QuicCryptoOnLoss(
 
         QUIC_CONNECTION* Connection = QuicCryptoGetConnection(Crypto);
 
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             RecoverCrypto,
             Connection,
             "Recovering crypto from %llu up to %llu",
@@ -871,7 +887,8 @@ QuicCryptoOnAck(
 
     QUIC_CONNECTION* Connection = QuicCryptoGetConnection(Crypto);
 
-    QuicTraceLogConnVerbose(
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_CRYPTO,
         AckCrypto,
         Connection,
         "Received ack for %u crypto bytes, offset=%u",
@@ -1050,7 +1067,8 @@ QuicCryptoProcessDataFrame(
         }
     }
 
-    QuicTraceLogConnVerbose(
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_CRYPTO,
         RecvCrypto,
         Connection,
         "Received %hu crypto bytes, offset=%llu Ready=%hhu",
@@ -1147,7 +1165,8 @@ QuicCryptoProcessTlsCompletion(
     }
 
     if (ResultFlags & QUIC_TLS_RESULT_EARLY_DATA_ACCEPT) {
-        QuicTraceLogConnInfo(
+        QuicTraceLogConnInfoClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             ZeroRttAccepted,
             Connection,
             "0-RTT accepted");
@@ -1155,7 +1174,8 @@ QuicCryptoProcessTlsCompletion(
     }
 
     if (ResultFlags & QUIC_TLS_RESULT_EARLY_DATA_REJECT) {
-        QuicTraceLogConnInfo(
+        QuicTraceLogConnInfoClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             ZeroRttRejected,
             Connection,
             "0-RTT rejected");
@@ -1320,7 +1340,8 @@ QuicCryptoProcessTlsCompletion(
             //
             // Handshake is confirmed on the server side as soon as it completes.
             //
-            QuicTraceLogConnInfo(
+            QuicTraceLogConnInfoClass(
+                QUIC_TRACE_CLASS_CRYPTO,
                 HandshakeConfirmedServer,
                 Connection,
                 "Handshake confirmed (server)");
@@ -1334,6 +1355,7 @@ QuicCryptoProcessTlsCompletion(
         // CONNECTED event is indicated to the app).
         //
         Connection->State.Connected = TRUE;
+        Connection->Stats.Timing.HandshakeComplete = QuicTimeUs64();
 
         QuicConnGenerateNewSourceCids(Connection, FALSE);
 
@@ -1378,14 +1400,33 @@ QuicCryptoProcessTlsCompletion(
         Event.CONNECTED.SessionResumed = Crypto->TlsState.SessionResumed;
         Event.CONNECTED.NegotiatedAlpnLength = Crypto->TlsState.NegotiatedAlpn[0];
         Event.CONNECTED.NegotiatedAlpn = Crypto->TlsState.NegotiatedAlpn + 1;
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             IndicateConnected,
             Connection,
             "Indicating QUIC_CONNECTION_EVENT_CONNECTED (Resume=%hhu)",
             Event.CONNECTED.SessionResumed);
         (void)QuicConnIndicateEvent(Connection, &Event);
+        Connection->Stats.Timing.ConnectedCallback = QuicTimeUs64();
 
-        QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_PMTUD);
+        QuicTraceLogConnInfoClass(
+            QUIC_TRACE_CLASS_CRYPTO,
+            HandshakeLatency,
+            Connection,
+            "Handshake latency: queue=%llu us, crypto=%llu us, callback=%llu us",
+            Connection->Stats.Timing.FirstPacketRecv == 0 ?
+                0 :
+                QuicTimeDiff64(
+                    Connection->Stats.Timing.FirstPacketRecv,
+                    Connection->Stats.Timing.Start),
+            QuicTimeDiff64(
+                Connection->Stats.Timing.Start,
+                Connection->Stats.Timing.HandshakeComplete),
+            QuicTimeDiff64(
+                Connection->Stats.Timing.HandshakeComplete,
+                Connection->Stats.Timing.ConnectedCallback));
+
+        QuicPathMtuDiscoveryStart(Connection, &Connection->Paths[0]);
 
         if (QuicConnIsServer(Connection) &&
             Crypto->TlsState.BufferOffset1Rtt != 0 &&
@@ -1397,7 +1438,8 @@ QuicCryptoProcessTlsCompletion(
     }
 
     if (ResultFlags & QUIC_TLS_RESULT_TICKET) {
-        QuicTraceLogConnInfo(
+        QuicTraceLogConnInfoClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             TicketReady,
             Connection,
             "Ticket ready");
@@ -1419,7 +1461,8 @@ QuicCryptoProcessDataComplete(
     Crypto->TlsCallPending = FALSE;
     if (RecvBufferConsumed != 0) {
         Crypto->RecvTotalConsumed += RecvBufferConsumed;
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_CRYPTO,
             DrainCrypto,
             QuicCryptoGetConnection(Crypto),
             "Draining %u crypto bytes",
@@ -1494,15 +1537,29 @@ QuicCryptoProcessData(
 
         QUIC_CONNECTION* Connection = QuicCryptoGetConnection(Crypto);
 
-        Buffer.Length =
-            QuicCrytpoTlsGetCompleteTlsMessagesLength(
-                Buffer.Buffer, Buffer.Length);
-        if (Buffer.Length == 0) {
-            QuicTraceLogConnVerbose(
-                CryptoNotReady,
-                Connection,
-                "No complete TLS messages to process");
-            goto Error;
+        if (!QuicTlsSupportsPartialInput ||
+            (BufferOffset == 0 &&
+             QuicConnIsServer(Connection) &&
+             !Connection->State.ExternalOwner)) {
+            //
+            // Trim the data so TLS is fed complete messages only. When the TLS
+            // provider can buffer and hash partial messages itself, this is
+            // skipped so transcript work overlaps the wait for the rest of the
+            // flight; the exception is the server's ClientHello preprocessing
+            // below, which always needs the complete message to extract the
+            // ALPN and SNI.
+            //
+            Buffer.Length =
+                QuicCrytpoTlsGetCompleteTlsMessagesLength(
+                    Buffer.Buffer, Buffer.Length);
+            if (Buffer.Length == 0) {
+                QuicTraceLogConnVerboseClass(
+                    QUIC_TRACE_CLASS_CRYPTO,
+                    CryptoNotReady,
+                    Connection,
+                    "No complete TLS messages to process");
+                goto Error;
+            }
         }
 
         if (BufferOffset == 0 &&
@@ -1608,9 +1665,15 @@ QuicCryptoProcessData(
     Crypto->TlsDataPending = FALSE;
     Crypto->TlsCallPending = TRUE;
 
+    uint64_t TlsStartTime = QuicTimeUs64();
+
     QUIC_TLS_RESULT_FLAGS ResultFlags =
         QuicTlsProcessData(Crypto->TLS, Buffer.Buffer, &Buffer.Length, &Crypto->TlsState);
 
+    QuicPerfCounterAdd(
+        QUIC_PERF_COUNTER_TLS_HANDSHAKE_TIME_US,
+        QuicTimeDiff64(TlsStartTime, QuicTimeUs64()));
+
     QUIC_TEL_ASSERT(!IsClientInitial || ResultFlags != QUIC_TLS_RESULT_PENDING); // TODO - Support async for client Initial?
 
     if (ResultFlags != QUIC_TLS_RESULT_PENDING) {
@@ -1763,4 +1826,11 @@ QuicCryptoUpdateKeyPhase(
     PacketSpace->AwaitingKeyPhaseConfirmation = TRUE;
 
     PacketSpace->CurrentKeyPhaseBytesSent = 0;
+
+    //
+    // Re-stage the next generation of keys, the same as at handshake
+    // confirmation, so the packet that reveals the next key update doesn't
+    // pay for the key schedule inline either.
+    //
+    (void)QuicCryptoGenerateNewKeys(Connection);
 }
@@ -52,6 +52,13 @@ typedef enum eSniNameType {
 
 #define QUIC_TP_ID_MAX QUIC_TP_ID_ACTIVE_CONNECTION_ID_LIMIT
 
+//
+// Extension transport parameters (not assigned a contiguous ID by the
+// transport RFC).
+//
+#define QUIC_TP_ID_MAX_DATAGRAM_FRAME_SIZE                  32      // varint
+#define QUIC_TP_ID_MIN_ACK_DELAY                            0xDE1A  // varint
+
 BOOLEAN
 QuicTpIdIsReserved(
     _In_ QUIC_VAR_INT ID
@@ -626,6 +633,57 @@ QuicCryptoTlsEncodeTransportParameters(
         Connection,
         "Encoding Transport Parameters");
 
+    //
+    // Most connections in a session encode byte-identical transport
+    // parameters, except for the stateless reset token. Cache the encoded
+    // blob on the session, keyed on a snapshot of the input with the token
+    // bytes zeroed, and just patch the token in on a hit. The snapshot
+    // comparison relies on callers zero-initializing the whole struct.
+    // Connections carrying rarely used per-connection parameters (original
+    // CID after Retry, test parameters) bypass the cache.
+    //
+    QUIC_SESSION* Session = Connection->Session;
+    QUIC_TRANSPORT_PARAMETERS CacheParams;
+    uint16_t ResetTokenOffset = 0;
+    BOOLEAN Cacheable =
+        Session != NULL &&
+        !Connection->State.TestTransportParameterSet &&
+        !(TransportParams->Flags & QUIC_TP_FLAG_ORIGINAL_CONNECTION_ID) &&
+        !(TransportParams->Flags & QUIC_TP_FLAG_PREFERRED_ADDRESS);
+    if (Cacheable) {
+        CacheParams = *TransportParams;
+        QuicZeroMemory(
+            CacheParams.StatelessResetToken,
+            sizeof(CacheParams.StatelessResetToken));
+
+        QuicDispatchLockAcquire(&Session->TpCacheLock);
+        if (Session->TpCacheValid &&
+            memcmp(&CacheParams, &Session->TpCacheParams, sizeof(CacheParams)) == 0) {
+            uint8_t* CachedCopy = QUIC_ALLOC_NONPAGED(Session->TpCacheLength);
+            if (CachedCopy != NULL) {
+                QuicCopyMemory(
+                    CachedCopy, Session->TpCacheBlob, Session->TpCacheLength);
+                uint32_t CachedLength = Session->TpCacheLength;
+                uint16_t TokenOffset = Session->TpCacheResetTokenOffset;
+                QuicDispatchLockRelease(&Session->TpCacheLock);
+                if (TokenOffset != 0) {
+                    QuicCopyMemory(
+                        CachedCopy + TokenOffset,
+                        TransportParams->StatelessResetToken,
+                        QUIC_STATELESS_RESET_TOKEN_LENGTH);
+                }
+                *TPLen = CachedLength;
+                QuicTraceLogConnVerbose(
+                    EncodeTPCached,
+                    Connection,
+                    "Reused %u byte cached QUIC TP encoding",
+                    CachedLength);
+                return CachedCopy;
+            }
+        }
+        QuicDispatchLockRelease(&Session->TpCacheLock);
+    }
+
     size_t RequiredTPLen = 0;
     if (TransportParams->Flags & QUIC_TP_FLAG_ORIGINAL_CONNECTION_ID) {
         QUIC_DBG_ASSERT(QuicConnIsServer(Connection));
@@ -718,6 +776,18 @@ QuicCryptoTlsEncodeTransportParameters(
                 QUIC_TP_ID_ACTIVE_CONNECTION_ID_LIMIT,
                 QuicVarIntSize(TransportParams->ActiveConnectionIdLimit));
     }
+    if (TransportParams->Flags & QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE) {
+        RequiredTPLen +=
+            TlsTransportParamLength(
+                QUIC_TP_ID_MAX_DATAGRAM_FRAME_SIZE,
+                QuicVarIntSize(TransportParams->MaxDatagramFrameSize));
+    }
+    if (TransportParams->Flags & QUIC_TP_FLAG_MIN_ACK_DELAY) {
+        RequiredTPLen +=
+            TlsTransportParamLength(
+                QUIC_TP_ID_MIN_ACK_DELAY,
+                QuicVarIntSize(TransportParams->MinAckDelay));
+    }
     if (Connection->State.TestTransportParameterSet) {
         RequiredTPLen +=
             TlsTransportParamLength(
@@ -785,6 +855,8 @@ QuicCryptoTlsEncodeTransportParameters(
                 QUIC_STATELESS_RESET_TOKEN_LENGTH,
                 TransportParams->StatelessResetToken,
                 TPBuf);
+        ResetTokenOffset =
+            (uint16_t)(TPBuf - TPBufBase - QUIC_STATELESS_RESET_TOKEN_LENGTH);
         QuicTraceLogConnVerbose(
             EncodeTPStatelessResetToken,
             Connection,
@@ -924,6 +996,28 @@ QuicCryptoTlsEncodeTransportParameters(
             "TP: Connection ID Limit (%llu)",
             TransportParams->ActiveConnectionIdLimit);
     }
+    if (TransportParams->Flags & QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE) {
+        TPBuf =
+            TlsWriteTransportParamVarInt(
+                QUIC_TP_ID_MAX_DATAGRAM_FRAME_SIZE,
+                TransportParams->MaxDatagramFrameSize, TPBuf);
+        QuicTraceLogConnVerbose(
+            EncodeTPMaxDatagramFrameSize,
+            Connection,
+            "TP: Max Datagram Frame Size (%llu bytes)",
+            TransportParams->MaxDatagramFrameSize);
+    }
+    if (TransportParams->Flags & QUIC_TP_FLAG_MIN_ACK_DELAY) {
+        TPBuf =
+            TlsWriteTransportParamVarInt(
+                QUIC_TP_ID_MIN_ACK_DELAY,
+                TransportParams->MinAckDelay, TPBuf);
+        QuicTraceLogConnVerbose(
+            EncodeTPMinAckDelay,
+            Connection,
+            "TP: Min ACK Delay (%llu us)",
+            TransportParams->MinAckDelay);
+    }
     if (Connection->State.TestTransportParameterSet) {
         TPBuf =
             TlsWriteTransportParam(
@@ -957,6 +1051,34 @@ QuicCryptoTlsEncodeTransportParameters(
             (uint16_t)FinalTPLength);
     }
 
+    if (Cacheable) {
+        //
+        // Store a copy (with the token bytes zeroed back out) for the next
+        // connection with the same parameters. Failure to allocate just
+        // means the next encode isn't served from the cache.
+        //
+        uint8_t* CacheBlob = QUIC_ALLOC_NONPAGED(*TPLen);
+        if (CacheBlob != NULL) {
+            QuicCopyMemory(CacheBlob, TPBufBase, *TPLen);
+            if (ResetTokenOffset != 0) {
+                QuicZeroMemory(
+                    CacheBlob + ResetTokenOffset,
+                    QUIC_STATELESS_RESET_TOKEN_LENGTH);
+            }
+            QuicDispatchLockAcquire(&Session->TpCacheLock);
+            uint8_t* OldBlob = Session->TpCacheBlob;
+            Session->TpCacheBlob = CacheBlob;
+            Session->TpCacheLength = *TPLen;
+            Session->TpCacheResetTokenOffset = ResetTokenOffset;
+            Session->TpCacheParams = CacheParams;
+            Session->TpCacheValid = TRUE;
+            QuicDispatchLockRelease(&Session->TpCacheLock);
+            if (OldBlob != NULL) {
+                QUIC_FREE(OldBlob);
+            }
+        }
+    }
+
     return TPBufBase;
 }
 
@@ -1393,6 +1515,50 @@ QuicCryptoTlsDecodeTransportParameters(
                 TransportParams->ActiveConnectionIdLimit);
             break;
 
+        case QUIC_TP_ID_MAX_DATAGRAM_FRAME_SIZE:
+            if (!TRY_READ_VAR_INT(TransportParams->MaxDatagramFrameSize)) {
+                QuicTraceEvent(
+                    ConnErrorStatus,
+                    "[conn][%p] ERROR, %u, %s.",
+                    Connection,
+                    Length,
+                    "Invalid length of QUIC_TP_ID_MAX_DATAGRAM_FRAME_SIZE");
+                goto Exit;
+            }
+            TransportParams->Flags |= QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE;
+            QuicTraceLogConnVerbose(
+                DecodeTPMaxDatagramFrameSize,
+                Connection,
+                "TP: Max Datagram Frame Size (%llu bytes)",
+                TransportParams->MaxDatagramFrameSize);
+            break;
+
+        case QUIC_TP_ID_MIN_ACK_DELAY:
+            if (!TRY_READ_VAR_INT(TransportParams->MinAckDelay)) {
+                QuicTraceEvent(
+                    ConnErrorStatus,
+                    "[conn][%p] ERROR, %u, %s.",
+                    Connection,
+                    Length,
+                    "Invalid length of QUIC_TP_ID_MIN_ACK_DELAY");
+                goto Exit;
+            }
+            if (TransportParams->MinAckDelay > QUIC_TP_MIN_ACK_DELAY_MAX) {
+                QuicTraceEvent(
+                    ConnError,
+                    "[conn][%p] ERROR, %s.",
+                    Connection,
+                    "Invalid value of QUIC_TP_ID_MIN_ACK_DELAY");
+                goto Exit;
+            }
+            TransportParams->Flags |= QUIC_TP_FLAG_MIN_ACK_DELAY;
+            QuicTraceLogConnVerbose(
+                DecodeTPMinAckDelay,
+                Connection,
+                "TP: Min ACK Delay (%llu us)",
+                TransportParams->MinAckDelay);
+            break;
+
         default:
             if (QuicTpIdIsReserved(Id)) {
                 QuicTraceLogConnWarning(
@@ -1415,6 +1581,16 @@ QuicCryptoTlsDecodeTransportParameters(
         Offset += Length;
     }
 
+    if ((TransportParams->Flags & QUIC_TP_FLAG_MIN_ACK_DELAY) &&
+        TransportParams->MinAckDelay > MS_TO_US(TransportParams->MaxAckDelay)) {
+        QuicTraceEvent(
+            ConnError,
+            "[conn][%p] ERROR, %s.",
+            Connection,
+            "MinAckDelay is larger than MaxAckDelay");
+        goto Exit;
+    }
+
     Result = TRUE;
 
 Exit:
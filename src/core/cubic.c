@@ -0,0 +1,696 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    The CUBIC congestion control algorithm (RFC8312).
+
+    The send rate is limited to the available bandwidth by
+    limiting the number of bytes in flight to CongestionWindow.
+
+    Slow start exits early, before the first loss, via HyStart++ (RFC 9406):
+    when the minimum RTT of a round grows noticeably over the previous
+    round's, the queue is starting to build, so growth is reduced for a few
+    rounds (the conservative phase) and then, if the RTT increase persists,
+    slow start ends at the current window instead of overshooting into loss.
+
+--*/
+
+#include "precomp.h"
+
+//
+// BETA and C from RFC8312. 10x multiples for integer arithmetic.
+//
+#define TEN_TIMES_BETA_CUBIC 7
+#define TEN_TIMES_C_CUBIC 4
+
+//
+// HyStart++ (RFC 9406) parameters: the number of RTT samples needed per
+// round, the clamps on the RTT increase threshold (an eighth of the RTT),
+// the slow start growth divisor while in the conservative phase, and the
+// number of conservative rounds before slow start is exited for good.
+//
+#define HYSTART_MIN_RTT_SAMPLES 8
+#define HYSTART_MIN_RTT_THRESH_US 4000
+#define HYSTART_MAX_RTT_THRESH_US 16000
+#define HYSTART_CSS_GROWTH_DIVISOR 4
+#define HYSTART_CSS_ROUNDS 5
+
+//
+// Shifting nth root algorithm.
+//
+// This works sort of like long division: we look at the radicand in aligned
+// chunks of 3 bits to compute each bit of the root. This is somewhat
+// intuitive, since 2^3 = 8, i.e. one bit is needed to encode the cube root
+// of a 3-bit number.
+//
+// At each step, we have a root value computed "so far" (i.e. the most
+// significant bits of the root) and we need to find the correct value of
+// the LSB of the (shifted) root so that it satisfies the two conditions:
+// y^3 <= x
+// (y+1)^3 > x
+// ...where y represents the shifted value of the root "computed so far"
+// and x represents the bits of the radicand "shifted in so far."
+//
+// The initial shift of 30 bits gives us 3-bit-aligned chunks.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+CubeRoot(
+    uint32_t Radicand
+    )
+{
+    int i;
+    uint32_t x = 0;
+    uint32_t y = 0;
+
+    for (i = 30; i >= 0; i -= 3) {
+        x = x * 8 + ((Radicand >> i) & 7);
+        if ((y * 2 + 1) * (y * 2 + 1) * (y * 2 + 1) <= x) {
+            y = y * 2 + 1;
+        } else {
+            y = y * 2;
+        }
+    }
+    return y;
+}
+
+void
+QuicConnLogCubic(
+    _In_ const QUIC_CONNECTION* const Connection
+    )
+{
+    UNREFERENCED_PARAMETER(Connection);
+    QuicTraceEvent(
+        ConnCubic,
+        "[conn][%p] CUBIC: SlowStartThreshold=%u K=%u WindowMax=%u WindowLastMax=%u",
+        Connection,
+        Connection->CongestionControl.SlowStartThreshold,
+        Connection->CongestionControl.Ctx.Cubic.KCubic,
+        Connection->CongestionControl.Ctx.Cubic.WindowMax,
+        Connection->CongestionControl.Ctx.Cubic.WindowLastMax);
+}
+
+//
+// Resets the HyStart++ round state so the next slow start begins a fresh
+// delay measurement.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+static
+void
+QuicCubicHyStartReset(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    QUIC_CONGESTION_CONTROL_CUBIC* Cubic = &Cc->Ctx.Cubic;
+    Cubic->HyStartInConservativePhase = FALSE;
+    Cubic->HyStartRoundEnd = 0;
+    Cubic->HyStartLastRoundMinRtt = UINT32_MAX;
+    Cubic->HyStartCurrentRoundMinRtt = UINT32_MAX;
+    Cubic->HyStartRttSampleCount = 0;
+    Cubic->HyStartConservativeRounds = 0;
+}
+
+//
+// Runs the HyStart++ delay based exit logic for an ACK received during slow
+// start. May move slow start into the conservative phase or, if the RTT
+// increase persists through it, end slow start by lowering
+// SlowStartThreshold to the current window.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+static
+void
+QuicCubicHyStartOnDataAcknowledged(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t LargestPacketNumberAcked
+    )
+{
+    QUIC_CONGESTION_CONTROL_CUBIC* Cubic = &Cc->Ctx.Cubic;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    const QUIC_PATH* Path = &Connection->Paths[0];
+
+    if (!Path->GotFirstRttSample) {
+        return;
+    }
+
+    //
+    // Fold the latest RTT sample from loss detection into the current
+    // round's minimum.
+    //
+    if (Cubic->HyStartRttSampleCount < HYSTART_MIN_RTT_SAMPLES) {
+        Cubic->HyStartRttSampleCount++;
+        if (Path->LatestRttSample < Cubic->HyStartCurrentRoundMinRtt) {
+            Cubic->HyStartCurrentRoundMinRtt = Path->LatestRttSample;
+        }
+    }
+
+    if (Cubic->HyStartRttSampleCount == HYSTART_MIN_RTT_SAMPLES &&
+        Cubic->HyStartLastRoundMinRtt != UINT32_MAX) {
+
+        if (!Cubic->HyStartInConservativePhase) {
+            //
+            // Enough samples this round to compare against the last one. If
+            // the RTT grew past the threshold, the bottleneck queue is
+            // starting to build: switch to conservative growth.
+            //
+            uint32_t RttThresh = Cubic->HyStartLastRoundMinRtt / 8;
+            if (RttThresh < HYSTART_MIN_RTT_THRESH_US) {
+                RttThresh = HYSTART_MIN_RTT_THRESH_US;
+            } else if (RttThresh > HYSTART_MAX_RTT_THRESH_US) {
+                RttThresh = HYSTART_MAX_RTT_THRESH_US;
+            }
+            if (Cubic->HyStartCurrentRoundMinRtt >=
+                Cubic->HyStartLastRoundMinRtt + RttThresh) {
+                QuicTraceLogConnInfoClass(
+                    QUIC_TRACE_CLASS_CONGESTION,
+                    CubicHyStartConservative,
+                    Connection,
+                    "HyStart: conservative phase (RTT %u -> %u us)",
+                    Cubic->HyStartLastRoundMinRtt,
+                    Cubic->HyStartCurrentRoundMinRtt);
+                Cubic->HyStartInConservativePhase = TRUE;
+                Cubic->HyStartConservativeRounds = 0;
+                Cubic->HyStartConservativeBaselineRtt =
+                    Cubic->HyStartCurrentRoundMinRtt;
+            }
+
+        } else if (Cubic->HyStartCurrentRoundMinRtt <
+            Cubic->HyStartConservativeBaselineRtt) {
+            //
+            // The RTT came back down, so the increase apparently wasn't queue
+            // buildup (e.g. it was a route change). Resume regular slow start.
+            //
+            QuicTraceLogConnInfoClass(
+                QUIC_TRACE_CLASS_CONGESTION,
+                CubicHyStartResume,
+                Connection,
+                "HyStart: RTT recovered, resuming slow start");
+            Cubic->HyStartInConservativePhase = FALSE;
+        }
+    }
+
+    if (LargestPacketNumberAcked >= Cubic->HyStartRoundEnd) {
+        //
+        // The round is over; roll the measurement over to the next one.
+        //
+        if (Cubic->HyStartInConservativePhase &&
+            ++Cubic->HyStartConservativeRounds >= HYSTART_CSS_ROUNDS) {
+            //
+            // The RTT increase persisted through the whole conservative
+            // phase; end slow start at the current window, starting
+            // congestion avoidance from here instead of growing into loss.
+            //
+            QuicTraceLogConnInfoClass(
+                QUIC_TRACE_CLASS_CONGESTION,
+                CubicHyStartExit,
+                Connection,
+                "HyStart: exiting slow start at window of %u bytes",
+                Cc->CongestionWindow);
+            Cc->SlowStartThreshold = Cc->CongestionWindow;
+            Cubic->WindowMax = Cc->CongestionWindow;
+            Cubic->WindowLastMax = Cubic->WindowMax;
+            Cubic->KCubic = 0;
+        }
+        Cubic->HyStartRoundEnd =
+            Connection->LossDetection.LargestSentPacketNumber;
+        Cubic->HyStartLastRoundMinRtt = Cubic->HyStartCurrentRoundMinRtt;
+        Cubic->HyStartCurrentRoundMinRtt = UINT32_MAX;
+        Cubic->HyStartRttSampleCount = 0;
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlReset(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    QuicCubicHyStartReset(Cc);
+    Cc->SlowStartThreshold = UINT32_MAX;
+    Cc->IsInRecovery = FALSE;
+    Cc->HasHadCongestionEvent = FALSE;
+    Cc->CongestionWindow = Connection->Paths[0].Mtu * Cc->InitialWindowPackets;
+    Cc->BytesInFlightMax = Cc->CongestionWindow / 2;
+    Cc->BytesInFlight = 0;
+    QuicConnLogOutFlowStats(Connection);
+    QuicConnLogCubic(Connection);
+}
+
+//
+// Attempts to predict what the congestion window will be one RTT from now.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicCubicCongestionControlPredictNextWindow(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    //
+    // TODO - Replace NewReno prediction logic.
+    //
+    uint32_t Wnd;
+    if (Cc->CongestionWindow < Cc->SlowStartThreshold) {
+        Wnd = Cc->CongestionWindow << 1;
+        if (Wnd > Cc->SlowStartThreshold) {
+            Wnd = Cc->SlowStartThreshold;
+        }
+    } else {
+        Wnd =
+            Cc->CongestionWindow +
+            QuicCongestionControlGetConnection(Cc)->Paths[0].Mtu;
+    }
+    return Wnd;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicCubicCongestionControlGetSendAllowance(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t TimeSinceLastSend, // microsec
+    _In_ BOOLEAN TimeSinceLastSendValid
+    )
+{
+    uint32_t SendAllowance;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    if (Cc->BytesInFlight >= Cc->CongestionWindow) {
+        //
+        // We are CC blocked, so we can't send anything.
+        //
+        SendAllowance = 0;
+
+    } else if (!Connection->State.UsePacing || !Connection->Paths[0].GotFirstRttSample) {
+        //
+        // Pacing is disabled or we don't have an RTT sample yet, so just send
+        // everything we can.
+        //
+        SendAllowance = Cc->CongestionWindow - Cc->BytesInFlight;
+
+    } else {
+        //
+        // Try to pace: if the window and RTT are large enough, the window can
+        // be split into chunks which are spread out over the RTT.
+        // SendAllowance will be set to the size of the next chunk.
+        //
+        uint32_t MinChunkSize = QUIC_SEND_PACING_MIN_CHUNK * Connection->Paths[0].Mtu;
+        if (Connection->Paths[0].SmoothedRtt < MS_TO_US(QUIC_SEND_PACING_INTERVAL) ||
+            Cc->CongestionWindow < MinChunkSize ||
+            !TimeSinceLastSendValid) {
+            //
+            // Either the RTT is too small (i.e. it cannot be split into
+            // multiple intervals based on the timer granularity) or the window
+            // is too small (i.e. it cannot be split into chunks larger than
+            // MinChunkSize) for us to use pacing, or this is the first send,
+            // in which case the pacing formula (which uses the time since the
+            // last send) is invalid.
+            //
+            SendAllowance = Cc->CongestionWindow - Cc->BytesInFlight;
+
+        } else {
+
+            //
+            // We are pacing, so calculate the current chunk size based on how
+            // long it's been since we sent the previous chunk.
+            //
+
+            //
+            // Since the window grows via ACK feedback and since we defer
+            // packets when pacing, using the current window to calculate the
+            // pacing interval is not quite as aggressive as we'd like. Instead,
+            // use the predicted window of the next RTT.
+            //
+            uint64_t EstimatedWnd = QuicCubicCongestionControlPredictNextWindow(Cc);
+
+            SendAllowance =
+                (uint32_t)((EstimatedWnd * TimeSinceLastSend) / Connection->Paths[0].SmoothedRtt);
+            if (SendAllowance < MinChunkSize) {
+                SendAllowance = MinChunkSize;
+            }
+            if (SendAllowance > (Cc->CongestionWindow - Cc->BytesInFlight)) {
+                SendAllowance = Cc->CongestionWindow - Cc->BytesInFlight;
+            }
+            if (SendAllowance > (Cc->CongestionWindow >> 1)) {
+                SendAllowance = Cc->CongestionWindow >> 1; // Don't send more than half the current window.
+            }
+            uint32_t MaxBurstSize = QUIC_SEND_PACING_MAX_BURST * Connection->Paths[0].Mtu;
+            if (SendAllowance > MaxBurstSize) {
+                //
+                // Cap the chunk at what the datapath can serialize in one
+                // batch. Anything larger hits the wire as a line-rate burst,
+                // which induces loss on shallow-buffered paths.
+                //
+                SendAllowance = MaxBurstSize;
+            }
+        }
+    }
+    return SendAllowance;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlOnCongestionEvent(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    QUIC_CONGESTION_CONTROL_CUBIC* Cubic = &Cc->Ctx.Cubic;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    QuicTraceEvent(
+        ConnCongestion,
+        "[conn][%p] Congestion event",
+        Connection);
+    Connection->Stats.Send.CongestionCount++;
+
+    Cc->IsInRecovery = TRUE;
+    Cc->HasHadCongestionEvent = TRUE;
+
+    //
+    // Loss feedback supersedes any in-progress HyStart measurement.
+    //
+    QuicCubicHyStartReset(Cc);
+
+    Cubic->WindowMax = Cc->CongestionWindow;
+    if (Cubic->WindowLastMax > Cubic->WindowMax) {
+        //
+        // Fast convergence.
+        //
+        Cubic->WindowLastMax = Cubic->WindowMax;
+        Cubic->WindowMax = Cubic->WindowMax * (10 + TEN_TIMES_BETA_CUBIC) / 20;
+    } else {
+        Cubic->WindowLastMax = Cubic->WindowMax;
+    }
+
+    //
+    // K = (WindowMax * (1 - BETA) / C) ^ (1/3)
+    // BETA := multiplicative window decrease factor.
+    //
+    // Here we reduce rounding error by left-shifting the CubeRoot argument
+    // by 9 before the division and then right-shifting the result by 3
+    // (since 2^9 = 2^3^3).
+    //
+    Cubic->KCubic =
+        CubeRoot(
+            (Cubic->WindowMax / Connection->Paths[0].Mtu * (10 - TEN_TIMES_BETA_CUBIC) << 9) /
+            TEN_TIMES_C_CUBIC);
+    Cubic->KCubic = S_TO_MS(Cubic->KCubic);
+    Cubic->KCubic >>= 3;
+
+    Cc->SlowStartThreshold =
+    Cc->CongestionWindow =
+        max(
+            (uint32_t)Connection->Paths[0].Mtu * Cc->InitialWindowPackets,
+            Cc->CongestionWindow * TEN_TIMES_BETA_CUBIC / 10);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlOnPersistentCongestionEvent(
+    _In_ QUIC_CONGESTION_CONTROL* Cc
+    )
+{
+    QUIC_CONGESTION_CONTROL_CUBIC* Cubic = &Cc->Ctx.Cubic;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    QuicTraceEvent(
+        ConnPersistentCongestion,
+        "[conn][%p] Persistent congestion event",
+        Connection);
+    Connection->Stats.Send.PersistentCongestionCount++;
+
+    Cc->IsInPersistentCongestion = TRUE;
+    Cubic->WindowMax =
+        Cubic->WindowLastMax =
+        Cc->SlowStartThreshold =
+            Cc->CongestionWindow * TEN_TIMES_BETA_CUBIC / 10;
+    Cc->CongestionWindow =
+        Connection->Paths[0].Mtu * QUIC_PERSISTENT_CONGESTION_WINDOW_PACKETS;
+    Cubic->KCubic = 0;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicCubicCongestionControlOnDataAcknowledged(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t TimeNow, // millisec
+    _In_ uint64_t LargestPacketNumberAcked,
+    _In_ uint32_t NumRetransmittableBytes,
+    _In_ uint32_t SmoothedRtt
+    )
+{
+    QUIC_CONGESTION_CONTROL_CUBIC* Cubic = &Cc->Ctx.Cubic;
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+    BOOLEAN PreviousCanSendState = QuicCongestionControlCanSend(Cc);
+
+    QUIC_DBG_ASSERT(Cc->BytesInFlight >= NumRetransmittableBytes);
+    Cc->BytesInFlight -= NumRetransmittableBytes;
+
+    if (Cc->IsInRecovery) {
+        if (LargestPacketNumberAcked > Cc->RecoverySentPacketNumber) {
+            //
+            // Done recovering. Note that completion of recovery is defined a
+            // bit differently here than in TCP: we simply require an ACK for a
+            // packet sent after recovery started.
+            //
+            QuicTraceEvent(
+                ConnRecoveryExit,
+                "[conn][%p] Recovery complete",
+                Connection);
+            Cc->IsInRecovery = FALSE;
+            Cc->IsInPersistentCongestion = FALSE;
+            Cubic->TimeOfCongAvoidStart = QuicTimeMs64();
+        }
+        goto Exit;
+    } else if (NumRetransmittableBytes == 0) {
+        goto Exit;
+    }
+
+    if (Cc->CongestionWindow < Cc->SlowStartThreshold) {
+
+        //
+        // Slow Start, with a HyStart++ delay based exit. While in the
+        // conservative phase the growth is divided down, so that if the
+        // observed RTT increase was real queue buildup, the overshoot (and
+        // the resulting loss burst) stays small.
+        //
+
+        QuicCubicHyStartOnDataAcknowledged(Cc, LargestPacketNumberAcked);
+
+        if (Cubic->HyStartInConservativePhase) {
+            Cc->CongestionWindow +=
+                NumRetransmittableBytes / HYSTART_CSS_GROWTH_DIVISOR;
+        } else {
+            Cc->CongestionWindow += NumRetransmittableBytes;
+        }
+        if (Cc->CongestionWindow >= Cc->SlowStartThreshold) {
+            Cubic->TimeOfCongAvoidStart = QuicTimeMs64();
+        }
+
+    } else {
+
+        //
+        // Congestion Avoidance
+        //
+
+        //
+        // We require steady ACK feedback to justify window growth. If there is
+        // a long time gap between ACKs, add the gap to TimeOfCongAvoidStart to
+        // reduce the value of TimeInCongAvoid, which effectively freezes window
+        // growth during the gap.
+        //
+        if (Cubic->TimeOfLastAckValid) {
+            uint64_t TimeSinceLastAck = QuicTimeDiff64(Cubic->TimeOfLastAck, TimeNow);
+            if (TimeSinceLastAck > Cc->SendIdleTimeoutMs &&
+                TimeSinceLastAck > US_TO_MS(Connection->Paths[0].SmoothedRtt + 4 * Connection->Paths[0].RttVariance)) {
+                Cubic->TimeOfCongAvoidStart += TimeSinceLastAck;
+                if (QuicTimeAtOrBefore64(TimeNow, Cubic->TimeOfCongAvoidStart)) {
+                    Cubic->TimeOfCongAvoidStart = TimeNow;
+                }
+            }
+        }
+
+        uint64_t TimeInCongAvoid =
+            QuicTimeDiff64(Cubic->TimeOfCongAvoidStart, QuicTimeMs64());
+        if (TimeInCongAvoid > UINT32_MAX) {
+            TimeInCongAvoid = UINT32_MAX;
+        }
+
+        //
+        // Compute the cubic window:
+        // W_cubic(t) = C*(t-K)^3 + WindowMax.
+        // (t in seconds; window sizes in MSS)
+        //
+        // NB: The RFC uses W_cubic(t+RTT) rather than W_cubic(t), so we
+        // add RTT to DeltaT.
+        //
+        // Here we have 30 bits' worth of right shift. This is to convert
+        // millisec^3 to sec^3. Each ten bit's worth of shift approximates
+        // a division by 1000. The order of operations is chosen to strike
+        // a balance between rounding error and overflow protection.
+        // With C = 0.4 and MTU=0xffff, we are safe from overflow for
+        // DeltaT < ~2.5M (about 30min).
+        //
+
+        int64_t DeltaT = TimeInCongAvoid - Cubic->KCubic + US_TO_MS(SmoothedRtt);
+
+        int64_t CubicWindow =
+            ((((DeltaT * DeltaT) >> 10) * DeltaT *
+              (int64_t)(Connection->Paths[0].Mtu * TEN_TIMES_C_CUBIC / 10)) >> 20) +
+            (int64_t)Cubic->WindowMax;
+
+        if (CubicWindow < 0) {
+            //
+            // The window came out so large it overflowed. We want to limit the
+            // huge window below anyway, so just set it to the limiting value.
+            //
+            CubicWindow = 2 * Cc->BytesInFlightMax;
+        }
+
+        //
+        // Compute the AIMD window (called W_est in the RFC):
+        // W_est(t) = WindowMax*BETA + [3*(1-BETA)/(1+BETA)] * (t/RTT).
+        // (again, window sizes in MSS)
+        //
+        // This is a window with linear growth which is designed
+        // to have the same average window size as an AIMD window
+        // with BETA=0.5 and a slope of 1MSS/RTT. Since our
+        // BETA is 0.7, we need a smaller slope than 1MSS/RTT to
+        // have this property.
+        //
+        // Also, for our value of BETA we have [3*(1-BETA)/(1+BETA)] ~= 0.5,
+        // so we simplify the calculation as:
+        // W_est(t) ~= WindowMax*BETA + (t/(2*RTT)).
+        //
+        // Using max(RTT, 1) prevents division by zero.
+        //
+
+        QUIC_STATIC_ASSERT(TEN_TIMES_BETA_CUBIC == 7, "TEN_TIMES_BETA_CUBIC must be 7 for simplified calculation.");
+
+        int64_t AimdWindow =
+            Cubic->WindowMax * TEN_TIMES_BETA_CUBIC / 10 +
+            TimeInCongAvoid * Connection->Paths[0].Mtu / (2 * max(1, US_TO_MS(SmoothedRtt)));
+
+        //
+        // Use the cubic or AIMD window, whichever is larger.
+        //
+        if (AimdWindow > CubicWindow) {
+            Cc->CongestionWindow = (uint32_t)max(AimdWindow, Cc->CongestionWindow + 1);
+        } else {
+            //
+            // Here we increment by a fraction of the difference, per the spec,
+            // rather than setting the window equal to CubicWindow. This helps
+            // prevent a burst when transitioning into congestion avoidance, since
+            // the cubic window may be significantly different from SlowStartThreshold.
+            //
+            Cc->CongestionWindow +=
+                (uint32_t)max(
+                    ((CubicWindow - Cc->CongestionWindow) * Connection->Paths[0].Mtu) / Cc->CongestionWindow,
+                    1);
+        }
+    }
+
+    //
+    // Limit the growth of the window based on the number of bytes we
+    // actually manage to put on the wire, which may be limited by flow
+    // control or by the app posting a limited number of bytes. This must
+    // be done to prevent the window from growing without loss feedback from
+    // the network.
+    //
+    // Using 2 * BytesInFlightMax for the limit allows for exponential growth
+    // in the window when not otherwise limited.
+    //
+    if (Cc->CongestionWindow > 2 * Cc->BytesInFlightMax) {
+        Cc->CongestionWindow = 2 * Cc->BytesInFlightMax;
+    }
+
+Exit:
+
+    Cubic->TimeOfLastAck = TimeNow;
+    Cubic->TimeOfLastAckValid = TRUE;
+    return QuicCongestionControlUpdateBlockedState(Cc, PreviousCanSendState);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlOnDataLost(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t LargestPacketNumberLost,
+    _In_ uint64_t LargestPacketNumberSent,
+    _In_ uint32_t NumRetransmittableBytes,
+    _In_ BOOLEAN PersistentCongestion
+    )
+{
+    BOOLEAN PreviousCanSendState = QuicCongestionControlCanSend(Cc);
+
+    //
+    // If data is lost after the most recent congestion event (or if there
+    // hasn't been a congestion event yet) then treat this loss as a new
+    // congestion event.
+    //
+    if (!Cc->HasHadCongestionEvent ||
+        LargestPacketNumberLost > Cc->RecoverySentPacketNumber) {
+
+        Cc->RecoverySentPacketNumber = LargestPacketNumberSent;
+        QuicCubicCongestionControlOnCongestionEvent(Cc);
+
+        if (PersistentCongestion && !Cc->IsInPersistentCongestion) {
+            QuicCubicCongestionControlOnPersistentCongestionEvent(Cc);
+        }
+    }
+
+    QUIC_DBG_ASSERT(Cc->BytesInFlight >= NumRetransmittableBytes);
+    Cc->BytesInFlight -= NumRetransmittableBytes;
+
+    QuicCongestionControlUpdateBlockedState(Cc, PreviousCanSendState);
+    QuicConnLogCubic(QuicCongestionControlGetConnection(Cc));
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlOnEcnCongestionEvent(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ uint64_t LargestPacketNumberAcked,
+    _In_ uint64_t LargestPacketNumberSent
+    )
+{
+    BOOLEAN PreviousCanSendState = QuicCongestionControlCanSend(Cc);
+
+    //
+    // A CE mark received after the most recent congestion event (or before
+    // any congestion event) starts a new recovery period, just like loss,
+    // except no bytes leave the network.
+    //
+    if (!Cc->HasHadCongestionEvent ||
+        LargestPacketNumberAcked > Cc->RecoverySentPacketNumber) {
+
+        Cc->RecoverySentPacketNumber = LargestPacketNumberSent;
+        QuicCubicCongestionControlOnCongestionEvent(Cc);
+    }
+
+    QuicCongestionControlUpdateBlockedState(Cc, PreviousCanSendState);
+    QuicConnLogCubic(QuicCongestionControlGetConnection(Cc));
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlInitialize(
+    _In_ QUIC_CONGESTION_CONTROL* Cc,
+    _In_ const QUIC_SETTINGS* Settings
+    )
+{
+    QUIC_CONNECTION* Connection = QuicCongestionControlGetConnection(Cc);
+
+    Cc->Reset = QuicCubicCongestionControlReset;
+    Cc->GetSendAllowance = QuicCubicCongestionControlGetSendAllowance;
+    Cc->OnDataAcknowledged = QuicCubicCongestionControlOnDataAcknowledged;
+    Cc->OnDataLost = QuicCubicCongestionControlOnDataLost;
+    Cc->OnEcnCongestionEvent = QuicCubicCongestionControlOnEcnCongestionEvent;
+
+    Cc->SlowStartThreshold = UINT32_MAX;
+    QuicCubicHyStartReset(Cc);
+    Cc->SendIdleTimeoutMs = Settings->SendIdleTimeoutMs;
+    Cc->InitialWindowPackets = Settings->InitialWindowPackets;
+    Cc->CongestionWindow = Connection->Paths[0].Mtu * Cc->InitialWindowPackets;
+    Cc->BytesInFlightMax = Cc->CongestionWindow / 2;
+    QuicConnLogOutFlowStats(Connection);
+    QuicConnLogCubic(Connection);
+}
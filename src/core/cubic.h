@@ -0,0 +1,56 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+--*/
+
+struct QUIC_CONGESTION_CONTROL;
+
+//
+// Per-connection state for the CUBIC congestion control algorithm.
+//
+typedef struct QUIC_CONGESTION_CONTROL_CUBIC {
+
+    //
+    // TRUE if there has been at least one ACK.
+    //
+    BOOLEAN TimeOfLastAckValid : 1;
+
+    //
+    // TRUE if HyStart++ moved slow start into its conservative phase because
+    // the RTT grew past the exit threshold.
+    //
+    BOOLEAN HyStartInConservativePhase : 1;
+
+    uint64_t TimeOfLastAck; // millisec
+    uint64_t TimeOfCongAvoidStart; // millisec
+    uint32_t KCubic; // millisec
+    uint32_t WindowMax; // bytes
+    uint32_t WindowLastMax; // bytes
+
+    //
+    // HyStart++ state. A "round" is one RTT worth of packets, delimited by
+    // the largest packet number sent when the previous round ended. The
+    // minimum RTT observed in each round is compared against the previous
+    // round's to detect queue buildup before slow start overshoots.
+    //
+    uint64_t HyStartRoundEnd; // Packet number ending the current round.
+    uint32_t HyStartLastRoundMinRtt; // microsec
+    uint32_t HyStartCurrentRoundMinRtt; // microsec
+    uint32_t HyStartConservativeBaselineRtt; // microsec
+    uint8_t HyStartRttSampleCount; // Samples taken this round.
+    uint8_t HyStartConservativeRounds; // Rounds spent in the conservative phase.
+
+} QUIC_CONGESTION_CONTROL_CUBIC;
+
+//
+// Initializes the CUBIC algorithm and binds it to the congestion control
+// context.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicCubicCongestionControlInitialize(
+    _In_ struct QUIC_CONGESTION_CONTROL* Cc,
+    _In_ const QUIC_SETTINGS* Settings
+    );
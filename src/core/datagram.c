@@ -0,0 +1,400 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    The datagram module manages the unreliable datagram extension. Datagram
+    sends completely bypass the stream machinery and the send buffering
+    logic; the payload is copied directly into a packet and never
+    retransmitted. The app is told the fate of each send (sent, acknowledged,
+    lost or canceled) via DATAGRAM_SEND_STATE_CHANGED events, and received
+    datagrams are delivered in a single DATAGRAM_RECEIVED event, with no
+    reassembly or buffering.
+
+--*/
+
+#include "precomp.h"
+
+//
+// Calculates the maximum datagram payload that both the peer's advertised
+// max_datagram_frame_size and the current path MTU allow us to send.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+uint16_t
+QuicDatagramGetMaxSendLength(
+    _In_ const QUIC_CONNECTION* Connection
+    )
+{
+    QUIC_DBG_ASSERT(
+        Connection->PeerTransportParams.Flags &
+        QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE);
+
+    //
+    // The peer's limit covers the whole frame, while the path MTU also has
+    // to account for the packet header and encryption overhead. Use the
+    // worst case header length, as a conservative estimate.
+    //
+    uint64_t MaxFrameSize = Connection->PeerTransportParams.MaxDatagramFrameSize;
+    uint64_t MtuFrameSize =
+        Connection->Paths[0].Mtu -
+        (MIN_SHORT_HEADER_LENGTH_V1 +
+         QUIC_MAX_CONNECTION_ID_LENGTH_V1 +
+         QUIC_ENCRYPTION_OVERHEAD);
+    if (MaxFrameSize > MtuFrameSize) {
+        MaxFrameSize = MtuFrameSize;
+    }
+
+    //
+    // Subtract off the frame type and (up to 2 byte) length field.
+    //
+    if (MaxFrameSize < 3) {
+        return 0;
+    }
+    return (uint16_t)(MaxFrameSize - 3);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramInitialize(
+    _Inout_ QUIC_DATAGRAM* Datagram
+    )
+{
+    Datagram->ReceiveEnabled = FALSE;
+    //
+    // Until the peer's transport parameters have been processed, assume it
+    // supports the extension so the app can queue sends (e.g. for 0-RTT).
+    // Any sends the peer turns out to not support get canceled then.
+    //
+    Datagram->SendEnabled = TRUE;
+    Datagram->MaxSendLength = UINT16_MAX;
+    Datagram->ApiQueue = NULL;
+    Datagram->SendQueue = NULL;
+    Datagram->SendQueueTail = &Datagram->SendQueue;
+    QuicDispatchLockInitialize(&Datagram->ApiQueueLock);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramIndicateSendStateChange(
+    _In_ QUIC_CONNECTION* Connection,
+    _Inout_ void** ClientContext,
+    _In_ QUIC_DATAGRAM_SEND_STATE State
+    )
+{
+    QUIC_CONNECTION_EVENT Event;
+    Event.Type = QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED;
+    Event.DATAGRAM_SEND_STATE_CHANGED.ClientContext = *ClientContext;
+    Event.DATAGRAM_SEND_STATE_CHANGED.State = State;
+
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_API,
+        DatagramSendStateChanged,
+        Connection,
+        "Indicating DATAGRAM_SEND_STATE_CHANGED [%p] to %u",
+        *ClientContext,
+        (uint32_t)State);
+    (void)QuicConnIndicateEvent(Connection, &Event);
+
+    *ClientContext = Event.DATAGRAM_SEND_STATE_CHANGED.ClientContext;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramCancelSend(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_SEND_REQUEST* SendRequest
+    )
+{
+    QuicDatagramIndicateSendStateChange(
+        Connection,
+        &SendRequest->ClientContext,
+        QUIC_DATAGRAM_SEND_CANCELED);
+    QuicPoolFree(&Connection->Worker->SendRequestPool, SendRequest);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramSendShutdown(
+    _In_ QUIC_DATAGRAM* Datagram
+    )
+{
+    QUIC_CONNECTION* Connection = QuicDatagramGetConnection(Datagram);
+
+    QuicDispatchLockAcquire(&Datagram->ApiQueueLock);
+    Datagram->SendEnabled = FALSE;
+    Datagram->MaxSendLength = 0;
+    QUIC_SEND_REQUEST* ApiQueue = Datagram->ApiQueue;
+    Datagram->ApiQueue = NULL;
+    QuicDispatchLockRelease(&Datagram->ApiQueueLock);
+
+    QuicSendClearSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_DATAGRAM);
+
+    while (Datagram->SendQueue != NULL) {
+        QUIC_SEND_REQUEST* SendRequest = Datagram->SendQueue;
+        Datagram->SendQueue = SendRequest->Next;
+        QuicDatagramCancelSend(Connection, SendRequest);
+    }
+    Datagram->SendQueueTail = &Datagram->SendQueue;
+
+    while (ApiQueue != NULL) {
+        QUIC_SEND_REQUEST* SendRequest = ApiQueue;
+        ApiQueue = SendRequest->Next;
+        QuicDatagramCancelSend(Connection, SendRequest);
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramUninitialize(
+    _In_ QUIC_DATAGRAM* Datagram
+    )
+{
+    QuicDatagramSendShutdown(Datagram);
+    QUIC_DBG_ASSERT(Datagram->ApiQueue == NULL);
+    QUIC_DBG_ASSERT(Datagram->SendQueue == NULL);
+    QuicDispatchLockUninitialize(&Datagram->ApiQueueLock);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramOnSendStateChanged(
+    _In_ QUIC_DATAGRAM* Datagram
+    )
+{
+    QUIC_CONNECTION* Connection = QuicDatagramGetConnection(Datagram);
+
+    BOOLEAN SendEnabled =
+        !!(Connection->PeerTransportParams.Flags &
+           QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE);
+    uint16_t NewMaxSendLength =
+        SendEnabled ? QuicDatagramGetMaxSendLength(Connection) : 0;
+    if (NewMaxSendLength == 0) {
+        SendEnabled = FALSE;
+    }
+
+    if (SendEnabled == Datagram->SendEnabled &&
+        NewMaxSendLength == Datagram->MaxSendLength) {
+        return;
+    }
+
+    if (!SendEnabled) {
+        //
+        // The peer doesn't support the extension after all. Cancel anything
+        // the app optimistically queued.
+        //
+        QuicDatagramSendShutdown(Datagram);
+
+    } else {
+        QuicDispatchLockAcquire(&Datagram->ApiQueueLock);
+        Datagram->SendEnabled = TRUE;
+        Datagram->MaxSendLength = NewMaxSendLength;
+        QuicDispatchLockRelease(&Datagram->ApiQueueLock);
+
+        //
+        // Cancel any previously queued sends that no longer fit.
+        //
+        QUIC_SEND_REQUEST** SendQueue = &Datagram->SendQueue;
+        while (*SendQueue != NULL) {
+            if ((*SendQueue)->TotalLength > NewMaxSendLength) {
+                QUIC_SEND_REQUEST* SendRequest = *SendQueue;
+                *SendQueue = SendRequest->Next;
+                QuicDatagramCancelSend(Connection, SendRequest);
+            } else {
+                SendQueue = &(*SendQueue)->Next;
+            }
+        }
+        Datagram->SendQueueTail = SendQueue;
+    }
+
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_API,
+        DatagramSendStateChangedV2,
+        Connection,
+        "Datagram send enabled=%hhu max_len=%hu",
+        SendEnabled,
+        NewMaxSendLength);
+
+    QUIC_CONNECTION_EVENT Event;
+    Event.Type = QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED;
+    Event.DATAGRAM_STATE_CHANGED.SendEnabled = SendEnabled;
+    Event.DATAGRAM_STATE_CHANGED.MaxSendLength = NewMaxSendLength;
+    (void)QuicConnIndicateEvent(Connection, &Event);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QuicDatagramQueueSend(
+    _In_ QUIC_DATAGRAM* Datagram,
+    _In_ QUIC_SEND_REQUEST* SendRequest
+    )
+{
+    QUIC_STATUS Status;
+    BOOLEAN QueueOper = TRUE;
+    QUIC_CONNECTION* Connection = QuicDatagramGetConnection(Datagram);
+
+    QuicDispatchLockAcquire(&Datagram->ApiQueueLock);
+    if (!Datagram->SendEnabled) {
+        Status = QUIC_STATUS_INVALID_STATE;
+    } else if (SendRequest->TotalLength > Datagram->MaxSendLength) {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+    } else {
+        QUIC_SEND_REQUEST** ApiQueueTail = &Datagram->ApiQueue;
+        while (*ApiQueueTail != NULL) {
+            ApiQueueTail = &((*ApiQueueTail)->Next);
+            QueueOper = FALSE; // Not necessary if the previous send hasn't been flushed yet.
+        }
+        *ApiQueueTail = SendRequest;
+        Status = QUIC_STATUS_SUCCESS;
+    }
+    QuicDispatchLockRelease(&Datagram->ApiQueueLock);
+
+    if (QUIC_FAILED(Status)) {
+        QuicPoolFree(&Connection->Worker->SendRequestPool, SendRequest);
+        goto Exit;
+    }
+
+    if (QueueOper) {
+        QUIC_OPERATION* Oper =
+            QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_API_CALL);
+        if (Oper == NULL) {
+            Status = QUIC_STATUS_OUT_OF_MEMORY;
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "DATAGRAM_SEND operation",
+                0);
+            goto Exit;
+        }
+        Oper->API_CALL.Context->Type = QUIC_API_TYPE_DATAGRAM_SEND;
+
+        //
+        // Queue the operation but don't wait for the completion.
+        //
+        QuicConnQueueOper(Connection, Oper);
+    }
+
+    Status = QUIC_STATUS_PENDING;
+
+Exit:
+
+    return Status;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramSendFlush(
+    _In_ QUIC_DATAGRAM* Datagram
+    )
+{
+    QUIC_CONNECTION* Connection = QuicDatagramGetConnection(Datagram);
+
+    QuicDispatchLockAcquire(&Datagram->ApiQueueLock);
+    QUIC_SEND_REQUEST* ApiQueue = Datagram->ApiQueue;
+    Datagram->ApiQueue = NULL;
+    QuicDispatchLockRelease(&Datagram->ApiQueueLock);
+
+    while (ApiQueue != NULL) {
+
+        QUIC_SEND_REQUEST* SendRequest = ApiQueue;
+        ApiQueue = SendRequest->Next;
+        SendRequest->Next = NULL;
+
+        if (QuicConnIsClosed(Connection) ||
+            !Datagram->SendEnabled ||
+            SendRequest->TotalLength > Datagram->MaxSendLength) {
+            //
+            // The connection started closing or the peer's transport
+            // parameters invalidated the send after it was queued.
+            //
+            QuicDatagramCancelSend(Connection, SendRequest);
+            continue;
+        }
+
+        *Datagram->SendQueueTail = SendRequest;
+        Datagram->SendQueueTail = &SendRequest->Next;
+    }
+
+    if (Datagram->SendQueue != NULL) {
+        QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_DATAGRAM);
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+BOOLEAN
+QuicDatagramWriteFrame(
+    _In_ QUIC_DATAGRAM* Datagram,
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    QUIC_CONNECTION* Connection = QuicDatagramGetConnection(Datagram);
+    uint16_t AvailableBufferLength =
+        (uint16_t)Builder->Datagram->Length - Builder->EncryptionOverhead;
+    BOOLEAN WroteFrame = FALSE;
+
+    while (Datagram->SendQueue != NULL) {
+
+        QUIC_SEND_REQUEST* SendRequest = Datagram->SendQueue;
+
+        if (!QuicDatagramFrameEncodeEx(
+                SendRequest->Buffers,
+                SendRequest->BufferCount,
+                SendRequest->TotalLength,
+                &Builder->DatagramLength,
+                AvailableBufferLength,
+                Builder->Datagram->Buffer)) {
+            break; // Ran out of room.
+        }
+
+        if ((Datagram->SendQueue = SendRequest->Next) == NULL) {
+            Datagram->SendQueueTail = &Datagram->SendQueue;
+        }
+
+        //
+        // The payload has been copied into the packet, so the send request
+        // isn't needed any more. The final state (acknowledged or lost) is
+        // indicated later, via the sent frame metadata.
+        //
+        QuicDatagramIndicateSendStateChange(
+            Connection,
+            &SendRequest->ClientContext,
+            QUIC_DATAGRAM_SEND_SENT);
+        Builder->Metadata->Frames[
+            Builder->Metadata->FrameCount].DATAGRAM.ClientContext =
+                SendRequest->ClientContext;
+        QuicPoolFree(&Connection->Worker->SendRequestPool, SendRequest);
+
+        WroteFrame = TRUE;
+        if (QuicPacketBuilderAddFrame(Builder, QUIC_FRAME_DATAGRAM_1, TRUE)) {
+            break; // Max frames per packet.
+        }
+    }
+
+    return WroteFrame;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramIndicateReceive(
+    _In_ QUIC_DATAGRAM* Datagram,
+    _In_ const QUIC_DATAGRAM_EX* Frame
+    )
+{
+    QUIC_CONNECTION* Connection = QuicDatagramGetConnection(Datagram);
+    QUIC_DBG_ASSERT(Datagram->ReceiveEnabled);
+
+    const QUIC_BUFFER Buffer = { Frame->Length, (uint8_t*)Frame->Data };
+
+    QUIC_CONNECTION_EVENT Event;
+    Event.Type = QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED;
+    Event.DATAGRAM_RECEIVED.Buffer = &Buffer;
+
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_API,
+        IndicateDatagramReceived,
+        Connection,
+        "Indicating DATAGRAM_RECEIVED [len=%hu]",
+        Frame->Length);
+    (void)QuicConnIndicateEvent(Connection, &Event);
+}
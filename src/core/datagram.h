@@ -0,0 +1,137 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+--*/
+
+typedef struct QUIC_PACKET_BUILDER QUIC_PACKET_BUILDER;
+
+//
+// All the state used by the unreliable datagram extension for a single
+// connection.
+//
+typedef struct QUIC_DATAGRAM {
+
+    //
+    // Queue of send requests that the app has queued up, but the worker
+    // thread has yet to flush to the send queue. Synchronized by the
+    // ApiQueueLock.
+    //
+    QUIC_DISPATCH_LOCK ApiQueueLock;
+    QUIC_SEND_REQUEST* ApiQueue;
+
+    //
+    // Queue of send requests ready to be framed into packets. Only accessed
+    // by the connection's worker thread.
+    //
+    QUIC_SEND_REQUEST* SendQueue;
+    QUIC_SEND_REQUEST** SendQueueTail;
+
+    //
+    // Indicates the app is willing to receive DATAGRAM frames. Must be
+    // configured before the handshake starts, as it determines whether the
+    // max_datagram_frame_size transport parameter is advertised.
+    //
+    BOOLEAN ReceiveEnabled;
+
+    //
+    // Indicates the peer is (or is still assumed to be, before the peer's
+    // transport parameters have been processed) willing to receive DATAGRAM
+    // frames.
+    //
+    BOOLEAN SendEnabled;
+
+    //
+    // The maximum datagram payload length the peer's advertised limit and
+    // the current path allow us to send. Zero when sending isn't allowed.
+    //
+    uint16_t MaxSendLength;
+
+} QUIC_DATAGRAM;
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramInitialize(
+    _Inout_ QUIC_DATAGRAM* Datagram
+    );
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramUninitialize(
+    _In_ QUIC_DATAGRAM* Datagram
+    );
+
+//
+// Cancels all outstanding send requests. Called when the connection is
+// closed or the peer turns out to not support the extension.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramSendShutdown(
+    _In_ QUIC_DATAGRAM* Datagram
+    );
+
+//
+// Recalculates the maximum sendable datagram length from the peer's
+// transport parameters and the path MTU, and indicates any change to the
+// app.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramOnSendStateChanged(
+    _In_ QUIC_DATAGRAM* Datagram
+    );
+
+//
+// Queues a new send request from an app (arbitrary) thread.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QuicDatagramQueueSend(
+    _In_ QUIC_DATAGRAM* Datagram,
+    _In_ QUIC_SEND_REQUEST* SendRequest
+    );
+
+//
+// Moves the API queued send requests to the send queue, on the worker
+// thread.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramSendFlush(
+    _In_ QUIC_DATAGRAM* Datagram
+    );
+
+//
+// Writes as many queued datagrams as will fit into the packet. Returns TRUE
+// if at least one frame was written.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+BOOLEAN
+QuicDatagramWriteFrame(
+    _In_ QUIC_DATAGRAM* Datagram,
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    );
+
+//
+// Delivers a received DATAGRAM frame's payload to the app.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramIndicateReceive(
+    _In_ QUIC_DATAGRAM* Datagram,
+    _In_ const QUIC_DATAGRAM_EX* Frame
+    );
+
+//
+// Indicates a send state change for a previously queued send to the app,
+// allowing it to update the client context in the process.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDatagramIndicateSendStateChange(
+    _In_ QUIC_CONNECTION* Connection,
+    _Inout_ void** ClientContext,
+    _In_ QUIC_DATAGRAM_SEND_STATE State
+    );
@@ -97,10 +97,10 @@ QuicAckHeaderDecode(
     _Out_ QUIC_ACK_EX* Frame
     )
 {
-    if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->LargestAcknowledged) ||
-        !QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->AckDelay) ||
-        !QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->AdditionalAckBlockCount) ||
-        !QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->FirstAckBlock) ||
+    if (!QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->LargestAcknowledged) ||
+        !QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->AckDelay) ||
+        !QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->AdditionalAckBlockCount) ||
+        !QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->FirstAckBlock) ||
         Frame->FirstAckBlock > Frame->LargestAcknowledged) {
         return FALSE;
     }
@@ -142,8 +142,8 @@ QuicAckBlockDecode(
     _Out_ QUIC_ACK_BLOCK_EX* Block
     )
 {
-    if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Block->Gap) ||
-        !QuicVarIntDecode(BufferLength, Buffer, Offset, &Block->AckBlock)) {
+    if (!QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Block->Gap) ||
+        !QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Block->AckBlock)) {
         return FALSE;
     }
     return TRUE;
@@ -160,7 +160,7 @@ QuicAckEcnEncode(
 {
     uint16_t RequiredLength =
         QuicVarIntSize(Ecn->ECT_0_Count) +
-        QuicVarIntSize(Ecn->ECT_0_Count) +
+        QuicVarIntSize(Ecn->ECT_1_Count) +
         QuicVarIntSize(Ecn->CE_Count);
 
     if (BufferLength < *Offset + RequiredLength) {
@@ -169,7 +169,7 @@ QuicAckEcnEncode(
 
     Buffer = Buffer + *Offset;
     Buffer = QuicVarIntEncode(Ecn->ECT_0_Count, Buffer);
-    Buffer = QuicVarIntEncode(Ecn->ECT_0_Count, Buffer);
+    Buffer = QuicVarIntEncode(Ecn->ECT_1_Count, Buffer);
     Buffer = QuicVarIntEncode(Ecn->CE_Count, Buffer);
     *Offset += RequiredLength;
 
@@ -370,6 +370,117 @@ QuicAckFrameDecode(
     return TRUE;
 }
 
+//
+// Decodes the ACK_FRAME directly into a caller-provided array of subranges
+// (sorted smallest to largest), skipping the intermediate QUIC_RANGE
+// construction. The frame encodes its blocks from largest to smallest and a
+// well-formed frame is strictly descending, so the array is just filled from
+// the end. If the frame has more blocks than the array holds, returns FALSE
+// with *InvalidFrame left FALSE and *BlockCount set to the required count, and
+// consumes nothing from the buffer; the caller should fall back to
+// QuicAckFrameDecode.
+//
+_Success_(return != FALSE)
+BOOLEAN
+QuicAckFrameDecodeFast(
+    _In_ QUIC_FRAME_TYPE FrameType,
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_ uint16_t* Offset,
+    _Out_ BOOLEAN* InvalidFrame,
+    _Out_writes_to_(BlockCapacity, *BlockCount)
+        QUIC_SUBRANGE* Blocks,
+    _In_ uint32_t BlockCapacity,
+    _Out_ uint32_t* BlockCount,
+    _When_(FrameType == QUIC_FRAME_ACK_1, _Out_)
+        QUIC_ACK_ECN_EX* Ecn,
+    _Out_ uint64_t* AckDelay
+    )
+{
+    uint16_t LocalOffset = *Offset;
+    *InvalidFrame = FALSE;
+    *BlockCount = 0;
+
+    //
+    // Decode the ACK frame header.
+    //
+    QUIC_ACK_EX Frame;
+    if (!QuicAckHeaderDecode(BufferLength, Buffer, &LocalOffset, &Frame)) {
+        *InvalidFrame = TRUE;
+        return FALSE;
+    }
+
+    if (Frame.AdditionalAckBlockCount >= QUIC_MAX_NUMBER_ACK_BLOCKS) {
+        *InvalidFrame = TRUE;
+        return FALSE;
+    }
+
+    *BlockCount = (uint32_t)Frame.AdditionalAckBlockCount + 1;
+    if (*BlockCount > BlockCapacity) {
+        return FALSE;
+    }
+
+    uint32_t Index = *BlockCount;
+
+    //
+    // The largest/first block.
+    //
+
+    uint64_t Largest = Frame.LargestAcknowledged;
+    uint64_t Count = Frame.FirstAckBlock + 1;
+
+    Index--;
+    Blocks[Index].Low = Largest - Count + 1;
+    Blocks[Index].Count = Count;
+
+    //
+    // All the rest of the blocks (if any).
+    //
+
+    for (uint32_t i = 0; i < (uint32_t)Frame.AdditionalAckBlockCount; i++) {
+
+        if (Count > Largest) {
+            *InvalidFrame = TRUE;
+            return FALSE;
+        }
+
+        Largest -= Count;
+
+        QUIC_ACK_BLOCK_EX Block;
+        if (!QuicAckBlockDecode(BufferLength, Buffer, &LocalOffset, &Block)) {
+            *InvalidFrame = TRUE;
+            return FALSE;
+        }
+
+        if (Block.Gap + 1 > Largest) {
+            *InvalidFrame = TRUE;
+            return FALSE;
+        }
+
+        Largest -= (Block.Gap + 1);
+        Count = Block.AckBlock + 1;
+
+        Index--;
+        Blocks[Index].Low = Largest - Count + 1;
+        Blocks[Index].Count = Count;
+    }
+
+    *AckDelay = Frame.AckDelay;
+
+    if (FrameType == QUIC_FRAME_ACK_1) {
+        //
+        // The ECN section was provided. Decode it as well.
+        //
+        if (!QuicAckEcnDecode(BufferLength, Buffer, &LocalOffset, Ecn)) {
+            return FALSE;
+        }
+    }
+
+    *Offset = LocalOffset;
+    return TRUE;
+}
+
 _Success_(return != FALSE)
 BOOLEAN
 QuicResetStreamFrameEncode(
@@ -617,18 +728,18 @@ QuicStreamFrameDecode(
     )
 {
     QUIC_STREAM_FRAME_TYPE Type = { .Type = FrameType };
-    if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->StreamID)) {
+    if (!QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->StreamID)) {
         return FALSE;
     }
     if (Type.OFF) {
-        if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->Offset)) {
+        if (!QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->Offset)) {
             return FALSE;
         }
     } else {
         Frame->Offset = 0;
     }
     if (Type.LEN) {
-        if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->Length) ||
+        if (!QuicVarIntDecodeFast(BufferLength, Buffer, Offset, &Frame->Length) ||
             BufferLength < Frame->Length + *Offset) {
             return FALSE;
         }
@@ -1122,6 +1233,117 @@ QuicConnCloseFrameDecode(
     return TRUE;
 }
 
+_Success_(return != FALSE)
+BOOLEAN
+QuicDatagramFrameEncodeEx(
+    _In_reads_(BufferCount)
+        const QUIC_BUFFER* const Buffers,
+    _In_ uint32_t BufferCount,
+    _In_ uint64_t TotalLength,
+    _Inout_ uint16_t* Offset,
+    _In_ uint16_t BufferLength,
+    _Out_writes_to_(BufferLength, *Offset) uint8_t* Buffer
+    )
+{
+    uint16_t RequiredLength =
+        QuicVarIntSize(QUIC_FRAME_DATAGRAM_1) + // Type
+        QuicVarIntSize(TotalLength) +
+        (uint16_t)TotalLength;
+
+    if (BufferLength < *Offset + RequiredLength) {
+        return FALSE;
+    }
+
+    Buffer = Buffer + *Offset;
+    Buffer = QuicVarIntEncode(QUIC_FRAME_DATAGRAM_1, Buffer);
+    Buffer = QuicVarIntEncode(TotalLength, Buffer);
+    for (uint32_t i = 0; i < BufferCount; ++i) {
+        QuicCopyMemory(Buffer, Buffers[i].Buffer, Buffers[i].Length);
+        Buffer += Buffers[i].Length;
+    }
+    *Offset += RequiredLength;
+
+    return TRUE;
+}
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicDatagramFrameDecode(
+    _In_ QUIC_FRAME_TYPE FrameType,
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_ uint16_t* Offset,
+    _Out_ QUIC_DATAGRAM_EX* Frame
+    )
+{
+    Frame->ExplicitLength = FrameType == QUIC_FRAME_DATAGRAM_1;
+    if (Frame->ExplicitLength) {
+        QUIC_VAR_INT Length;
+        if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Length) ||
+            (uint64_t)BufferLength < *Offset + Length) {
+            return FALSE;
+        }
+        Frame->Length = (uint16_t)Length;
+    } else {
+        //
+        // The datagram extends to the end of the packet.
+        //
+        Frame->Length = BufferLength - *Offset;
+    }
+    Frame->Data = Buffer + *Offset;
+    *Offset += Frame->Length;
+    return TRUE;
+}
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicAckFrequencyFrameEncode(
+    _In_ const QUIC_ACK_FREQUENCY_EX * const Frame,
+    _Inout_ uint16_t* Offset,
+    _In_ uint16_t BufferLength,
+    _Out_writes_to_(BufferLength, *Offset) uint8_t* Buffer
+    )
+{
+    uint16_t RequiredLength =
+        QuicVarIntSize(QUIC_FRAME_ACK_FREQUENCY) + // Type
+        QuicVarIntSize(Frame->SequenceNumber) +
+        QuicVarIntSize(Frame->PacketTolerance) +
+        QuicVarIntSize(Frame->UpdateMaxAckDelay);
+
+    if (BufferLength < *Offset + RequiredLength) {
+        return FALSE;
+    }
+
+    Buffer = Buffer + *Offset;
+    Buffer = QuicVarIntEncode(QUIC_FRAME_ACK_FREQUENCY, Buffer);
+    Buffer = QuicVarIntEncode(Frame->SequenceNumber, Buffer);
+    Buffer = QuicVarIntEncode(Frame->PacketTolerance, Buffer);
+    Buffer = QuicVarIntEncode(Frame->UpdateMaxAckDelay, Buffer);
+    *Offset += RequiredLength;
+
+    return TRUE;
+}
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicAckFrequencyFrameDecode(
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_ uint16_t* Offset,
+    _Out_ QUIC_ACK_FREQUENCY_EX* Frame
+    )
+{
+    if (!QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->SequenceNumber) ||
+        !QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->PacketTolerance) ||
+        !QuicVarIntDecode(BufferLength, Buffer, Offset, &Frame->UpdateMaxAckDelay)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicFrameLog(
@@ -1134,19 +1356,19 @@ QuicFrameLog(
     _Inout_ uint16_t* Offset
     )
 {
-    QUIC_FRAME_TYPE FrameType = Packet[*Offset];
-    if (FrameType > MAX_QUIC_FRAME) {
+    QUIC_VAR_INT FrameType64;
+    if (!QuicVarIntDecode(PacketLength, Packet, Offset, &FrameType64) ||
+        !QUIC_FRAME_IS_KNOWN(FrameType64)) {
         QuicTraceLogVerbose(
             FrameLogUnknownType,
-            "[%c][%cX][%llu]   unknown frame (%hu)",
+            "[%c][%cX][%llu]   unknown frame (%llu)",
             PtkConnPre(Connection),
             PktRxPre(Rx),
             PacketNumber,
-            FrameType);
+            FrameType64);
         return FALSE;
     }
-
-    *Offset += 1;
+    QUIC_FRAME_TYPE FrameType = (QUIC_FRAME_TYPE)FrameType64;
 
     switch (FrameType) {
 
@@ -1691,6 +1913,53 @@ QuicFrameLog(
             PacketNumber);
         break;
     }
+
+    case QUIC_FRAME_DATAGRAM:
+    case QUIC_FRAME_DATAGRAM_1: {
+        QUIC_DATAGRAM_EX Frame;
+        if (!QuicDatagramFrameDecode(FrameType, PacketLength, Packet, Offset, &Frame)) {
+            QuicTraceLogVerbose(
+                FrameLogDatagramInvalid,
+                "[%c][%cX][%llu]   DATAGRAM [Invalid]",
+                PtkConnPre(Connection),
+                PktRxPre(Rx),
+                PacketNumber);
+            return FALSE;
+        }
+
+        QuicTraceLogVerbose(
+            FrameLogDatagram,
+            "[%c][%cX][%llu]   DATAGRAM Len:%hu",
+            PtkConnPre(Connection),
+            PktRxPre(Rx),
+            PacketNumber,
+            Frame.Length);
+        break;
+    }
+
+    case QUIC_FRAME_ACK_FREQUENCY: {
+        QUIC_ACK_FREQUENCY_EX Frame;
+        if (!QuicAckFrequencyFrameDecode(PacketLength, Packet, Offset, &Frame)) {
+            QuicTraceLogVerbose(
+                FrameLogAckFrequencyInvalid,
+                "[%c][%cX][%llu]   ACK_FREQUENCY [Invalid]",
+                PtkConnPre(Connection),
+                PktRxPre(Rx),
+                PacketNumber);
+            return FALSE;
+        }
+
+        QuicTraceLogVerbose(
+            FrameLogAckFrequency,
+            "[%c][%cX][%llu]   ACK_FREQUENCY SeqNum:%llu PktTolerance:%llu MaxAckDelay:%llu us",
+            PtkConnPre(Connection),
+            PktRxPre(Rx),
+            PacketNumber,
+            Frame.SequenceNumber,
+            Frame.PacketTolerance,
+            Frame.UpdateMaxAckDelay);
+        break;
+    }
     }
 
     return TRUE;
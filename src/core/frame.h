@@ -114,12 +114,28 @@ typedef enum QUIC_FRAME_TYPE {
     QUIC_FRAME_PATH_RESPONSE        = 0x1b,
     QUIC_FRAME_CONNECTION_CLOSE     = 0x1c, // to 0x1d
     QUIC_FRAME_CONNECTION_CLOSE_1   = 0x1d,
-    QUIC_FRAME_HANDSHAKE_DONE       = 0x1e
+    QUIC_FRAME_HANDSHAKE_DONE       = 0x1e,
+    //
+    // Extension frames. These frame types take more than one byte on the wire
+    // (encoded as variable-length integers) and are only used when negotiated
+    // via a corresponding transport parameter.
+    //
+    QUIC_FRAME_DATAGRAM             = 0x30, // to 0x31
+    QUIC_FRAME_DATAGRAM_1           = 0x31,
+    QUIC_FRAME_ACK_FREQUENCY        = 0xaf
 
 } QUIC_FRAME_TYPE;
 
 #define MAX_QUIC_FRAME QUIC_FRAME_HANDSHAKE_DONE
 
+//
+// Indicates a frame type is one this implementation knows how to process.
+//
+#define QUIC_FRAME_IS_KNOWN(X) \
+    (X <= MAX_QUIC_FRAME || \
+     (X >= QUIC_FRAME_DATAGRAM && X <= QUIC_FRAME_DATAGRAM_1) || \
+     X == QUIC_FRAME_ACK_FREQUENCY)
+
 //
 // QUIC_FRAME_ACK Encoding/Decoding
 //
@@ -175,6 +191,24 @@ QuicAckFrameDecode(
     _Out_ uint64_t* AckDelay
     );
 
+_Success_(return != FALSE)
+BOOLEAN
+QuicAckFrameDecodeFast(
+    _In_ QUIC_FRAME_TYPE FrameType,
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_ uint16_t* Offset,
+    _Out_ BOOLEAN* InvalidFrame,
+    _Out_writes_to_(BlockCapacity, *BlockCount)
+        QUIC_SUBRANGE* Blocks, // Filled smallest to largest
+    _In_ uint32_t BlockCapacity,
+    _Out_ uint32_t* BlockCount,
+    _When_(FrameType == QUIC_FRAME_ACK_1, _Out_)
+        QUIC_ACK_ECN_EX* Ecn,
+    _Out_ uint64_t* AckDelay
+    );
+
 //
 // QUIC_FRAME_RESET_STREAM Encoding/Decoding
 //
@@ -699,6 +733,75 @@ QuicConnCloseFrameDecode(
     _Out_ QUIC_CONNECTION_CLOSE_EX* Frame
     );
 
+//
+// QUIC_FRAME_DATAGRAM Encoding/Decoding
+//
+
+typedef struct QUIC_DATAGRAM_EX {
+
+    BOOLEAN ExplicitLength; // A length field is present in the frame.
+    uint16_t Length;
+    _Field_size_bytes_(Length)
+    const uint8_t* Data;
+
+} QUIC_DATAGRAM_EX;
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicDatagramFrameEncodeEx(
+    _In_reads_(BufferCount)
+        const QUIC_BUFFER* const Buffers,
+    _In_ uint32_t BufferCount,
+    _In_ uint64_t TotalLength,
+    _Inout_ uint16_t* Offset,
+    _In_ uint16_t BufferLength,
+    _Out_writes_to_(BufferLength, *Offset)
+        uint8_t* Buffer
+    );
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicDatagramFrameDecode(
+    _In_ QUIC_FRAME_TYPE FrameType,
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_ uint16_t* Offset,
+    _Out_ QUIC_DATAGRAM_EX* Frame
+    );
+
+//
+// QUIC_FRAME_ACK_FREQUENCY Encoding/Decoding
+//
+
+typedef struct QUIC_ACK_FREQUENCY_EX {
+
+    QUIC_VAR_INT SequenceNumber;
+    QUIC_VAR_INT PacketTolerance;
+    QUIC_VAR_INT UpdateMaxAckDelay; // In microseconds.
+
+} QUIC_ACK_FREQUENCY_EX;
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicAckFrequencyFrameEncode(
+    _In_ const QUIC_ACK_FREQUENCY_EX * const Frame,
+    _Inout_ uint16_t* Offset,
+    _In_ uint16_t BufferLength,
+    _Out_writes_to_(BufferLength, *Offset)
+        uint8_t* Buffer
+    );
+
+_Success_(return != FALSE)
+BOOLEAN
+QuicAckFrequencyFrameDecode(
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_ uint16_t* Offset,
+    _Out_ QUIC_ACK_FREQUENCY_EX* Frame
+    );
+
 //
 // Helper functions
 //
@@ -24,9 +24,32 @@ QuicCidNewDestination(
         const uint8_t* const Data
     );
 
+BOOLEAN
+QuicCidEqual(
+    _In_reads_(Length)
+        const uint8_t* const A,
+    _In_reads_(Length)
+        const uint8_t* const B,
+    _In_ uint8_t Length
+    );
+
+QUIC_CID_HASH_ENTRY*
+QuicCidSourceAlloc(
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots,
+    _In_ uint8_t Length
+    );
+
+void
+QuicCidFreeSource(
+    _In_ QUIC_CID_HASH_ENTRY* Entry
+    );
+
 QUIC_CID_HASH_ENTRY*
 QuicCidNewSource(
     _In_ QUIC_CONNECTION* Connection,
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots,
     _In_ uint8_t Length,
     _In_reads_(Length)
         const uint8_t* const Data
@@ -34,12 +57,16 @@ QuicCidNewSource(
 
 QUIC_CID_HASH_ENTRY*
 QuicCidNewNullSource(
-    _In_ QUIC_CONNECTION* Connection
+    _In_ QUIC_CONNECTION* Connection,
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots
     );
 
 QUIC_CID_HASH_ENTRY*
 QuicCidNewRandomSource(
     _In_opt_ QUIC_CONNECTION* Connection,
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots,
     _In_reads_opt_(MsQuicLib.CidServerIdLength)
         const void* ServerID,
     _In_ uint8_t PartitionID,
@@ -142,6 +169,24 @@ QuicLibraryGetCurrentPartition(
     void
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint16_t
+QuicLibraryMapProcessor(
+    _In_ uint16_t Index
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicLibraryOnBufferMemoryChange(
+    _In_ int64_t Delta
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicLibraryUnderMemoryPressure(
+    void
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 uint8_t
 QuicPartitionIdCreate(
@@ -233,6 +278,13 @@ QuicRangeGetHigh(
     _In_ const QUIC_SUBRANGE* const Sub
     );
 
+QUIC_SUBRANGE*
+QuicRangeExtendSequential(
+    _Inout_ QUIC_RANGE* Range,
+    _In_ uint64_t LowValue,
+    _In_ uint64_t Count
+    );
+
 uint8_t
 QuicStreamFrameHeaderSize(
     _In_ const QUIC_STREAM_EX * const Frame
@@ -273,6 +325,11 @@ QuicSendGetConnection(
     _In_ QUIC_SEND* Send
     );
 
+QUIC_CONNECTION*
+QuicDatagramGetConnection(
+    _In_ QUIC_DATAGRAM* Datagram
+    );
+
 uint8_t
 QuicEncryptLevelToPacketType(
     QUIC_ENCRYPT_LEVEL Level
@@ -403,6 +460,17 @@ QuicVarIntDecode(
     _Out_ QUIC_VAR_INT* Value
     );
 
+BOOLEAN
+QuicVarIntDecodeFast(
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Deref_in_range_(0, BufferLength)
+    _Deref_out_range_(0, BufferLength)
+        uint16_t* Offset,
+    _Out_ QUIC_VAR_INT* Value
+    );
+
 uint8_t*
 QuicVarIntEncode(
     _In_ QUIC_VAR_INT Value,
@@ -459,6 +527,28 @@ QuicPathDecrementAllowance(
     _In_ uint32_t Amount
     );
 
+void
+QuicPathBumpVersion(
+    _In_ QUIC_PATH* Path
+    );
+
+void
+QuicPathInvalidateSendCache(
+    _In_ QUIC_PATH* Path
+    );
+
+void
+QuicPerfCounterAdd(
+    _In_ QUIC_PERFORMANCE_COUNTERS Type,
+    _In_ int64_t Value
+    );
+
+void
+QuicPerfCounterSet(
+    _In_ QUIC_PERFORMANCE_COUNTERS Type,
+    _In_ int64_t Value
+    );
+
 void
 QuicPktNumDecode(
     _In_ uint8_t PacketNumberLength,
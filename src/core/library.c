@@ -159,10 +159,17 @@ MsQuicLibraryInitialize(
 
     MsQuicLibraryReadSettings(NULL); // NULL means don't update registrations.
 
-    QuicLockInitialize(&MsQuicLib.StatelessRetryKeysLock);
+    QuicDispatchLockInitialize(&MsQuicLib.StatelessRetryKeysLock);
     QuicZeroMemory(&MsQuicLib.StatelessRetryKeys, sizeof(MsQuicLib.StatelessRetryKeys));
     QuicZeroMemory(&MsQuicLib.StatelessRetryKeysExpiration, sizeof(MsQuicLib.StatelessRetryKeysExpiration));
 
+    //
+    // Precompute the initial stateless retry key so retries sent directly on
+    // the datapath don't have to create it. Failure here is non-fatal; the
+    // key will be created by a worker on first use instead.
+    //
+    (void)QuicLibraryGetCurrentStatelessRetryKey();
+
     //
     // TODO: Add support for CPU hot swap/add.
     //
@@ -185,33 +192,35 @@ MsQuicLibraryInitialize(
         goto Error;
     }
 
+    QuicZeroMemory(
+        MsQuicLib.PerProc,
+        MsQuicLib.PartitionCount * sizeof(QUIC_LIBRARY_PP));
     for (uint8_t i = 0; i < MsQuicLib.PartitionCount; ++i) {
         QuicPoolInitialize(
             FALSE,
             sizeof(QUIC_CONNECTION),
             &MsQuicLib.PerProc[i].ConnectionPool);
+        QuicPoolInitialize(
+            FALSE,
+            sizeof(QUIC_PACKET_SPACE),
+            &MsQuicLib.PerProc[i].PacketSpacePool);
     }
 
-    Status =
-        QuicDataPathInitialize(
-            sizeof(QUIC_RECV_PACKET),
-            QuicBindingReceive,
-            QuicBindingUnreachable,
-            &MsQuicLib.Datapath);
-    if (QUIC_FAILED(Status)) {
-        QuicTraceEvent(
-            LibraryErrorStatus,
-            "[ lib] ERROR, %u, %s.",
-            Status,
-            "QuicDataPathInitialize");
-        goto Error;
-    }
+    //
+    // The datapath (and its per-processor worker threads) is not brought up
+    // here, but lazily by QuicLibraryEnsureDatapath when the first listener
+    // or connection actually needs it. That keeps MsQuicOpen cheap for
+    // processes that load the library long before (or without ever) sending
+    // anything, and keeps the process safe to fork before first use since no
+    // threads exist yet.
+    //
+    QUIC_DBG_ASSERT(MsQuicLib.Datapath == NULL);
 
     QuicTraceEvent(
         LibraryInitialized,
         "[ lib] Initialized, PartitionCount=%u DatapathFeatures=%u",
         MsQuicLib.PartitionCount,
-        QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath));
+        0); // Datapath features aren't known until it's initialized on first use.
 
 #ifdef QuicVerifierEnabled
     uint32_t Flags;
@@ -235,6 +244,7 @@ Error:
         if (MsQuicLib.PerProc != NULL) {
             for (uint8_t i = 0; i < MsQuicLib.PartitionCount; ++i) {
                 QuicPoolUninitialize(&MsQuicLib.PerProc[i].ConnectionPool);
+                QuicPoolUninitialize(&MsQuicLib.PerProc[i].PacketSpacePool);
             }
             QUIC_FREE(MsQuicLib.PerProc);
             MsQuicLib.PerProc = NULL;
@@ -294,6 +304,22 @@ MsQuicLibraryUninitialize(
     QUIC_TEL_ASSERT(MsQuicLib.ConnectionCount == 0);
 #endif
 
+    //
+    // Release the client port spray pool's binding references. All
+    // connections are gone by now, so this drops the last reference on each
+    // pooled binding.
+    //
+    if (MsQuicLib.ClientSprayBindings != NULL) {
+        for (uint8_t i = 0; i < MsQuicLib.ClientSprayBindingCount; ++i) {
+            if (MsQuicLib.ClientSprayBindings[i] != NULL) {
+                QuicLibraryReleaseBinding(MsQuicLib.ClientSprayBindings[i]);
+            }
+        }
+        QUIC_FREE(MsQuicLib.ClientSprayBindings);
+        MsQuicLib.ClientSprayBindings = NULL;
+        MsQuicLib.ClientSprayBindingCount = 0;
+    }
+
     //
     // If you hit this assert, MsQuic API is trying to be unloaded without
     // first being cleaned up all listeners and connections.
@@ -302,6 +328,7 @@ MsQuicLibraryUninitialize(
 
     for (uint8_t i = 0; i < MsQuicLib.PartitionCount; ++i) {
         QuicPoolUninitialize(&MsQuicLib.PerProc[i].ConnectionPool);
+        QuicPoolUninitialize(&MsQuicLib.PerProc[i].PacketSpacePool);
     }
     QUIC_FREE(MsQuicLib.PerProc);
     MsQuicLib.PerProc = NULL;
@@ -310,10 +337,12 @@ MsQuicLibraryUninitialize(
         QuicKeyFree(MsQuicLib.StatelessRetryKeys[i]);
         MsQuicLib.StatelessRetryKeys[i] = NULL;
     }
-    QuicLockUninitialize(&MsQuicLib.StatelessRetryKeysLock);
+    QuicDispatchLockUninitialize(&MsQuicLib.StatelessRetryKeysLock);
 
-    QuicDataPathUninitialize(MsQuicLib.Datapath);
-    MsQuicLib.Datapath = NULL;
+    if (MsQuicLib.Datapath != NULL) {
+        QuicDataPathUninitialize(MsQuicLib.Datapath);
+        MsQuicLib.Datapath = NULL;
+    }
 
     QuicTraceEvent(
         LibraryUninitialized,
@@ -322,6 +351,72 @@ MsQuicLibraryUninitialize(
     QuicPlatformUninitialize();
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicLibraryEnsureDatapath(
+    void
+    )
+{
+    QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
+
+    if (MsQuicLib.Datapath != NULL) {
+        //
+        // Already initialized. The pointer is never cleared while the library
+        // is referenced, so this unsynchronized check is safe.
+        //
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    QuicLockAcquire(&MsQuicLib.Lock);
+
+    if (MsQuicLib.Datapath == NULL) {
+        Status =
+            QuicDataPathInitialize(
+                sizeof(QUIC_RECV_PACKET),
+                QuicBindingReceive,
+                QuicBindingUnreachable,
+                &MsQuicLib.Datapath);
+        if (QUIC_SUCCEEDED(Status)) {
+            //
+            // Tell the datapath where the partition byte lives in locally
+            // generated CIDs (one byte past the server ID in the destination
+            // CID of a short header packet), so it can steer received
+            // datagrams to the processor that owns the connection.
+            //
+            QuicDataPathSetPartitionInfo(
+                MsQuicLib.Datapath,
+                1 + MsQuicLib.CidServerIdLength,
+                MsQuicLib.PartitionMask);
+            QuicDataPathSetDeferredSends(
+                MsQuicLib.Datapath,
+                MsQuicLib.Settings.DeferredSendEnabled);
+            if (MsQuicLib.ProcessorListLength != 0 ||
+                MsQuicLib.Settings.DatapathBusyPollEnabled) {
+                QuicDataPathSetProcessorConfig(
+                    MsQuicLib.Datapath,
+                    MsQuicLib.ProcessorListLength != 0 ?
+                        MsQuicLib.ProcessorList : NULL,
+                    MsQuicLib.ProcessorListLength,
+                    MsQuicLib.Settings.DatapathBusyPollEnabled);
+            }
+            QuicTraceEvent(
+                LibraryDatapathInitialized,
+                "[ lib] Datapath initialized, DatapathFeatures=%u",
+                QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath));
+        } else {
+            QuicTraceEvent(
+                LibraryErrorStatus,
+                "[ lib] ERROR, %u, %s.",
+                Status,
+                "QuicDataPathInitialize");
+        }
+    }
+
+    QuicLockRelease(&MsQuicLib.Lock);
+
+    return Status;
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 MsQuicAddRef(
@@ -481,12 +576,51 @@ QuicLibApplyLoadBalancingSetting(
     QUIC_FRE_ASSERT(MsQuicLib.CidTotalLength >= QUIC_MIN_INITIAL_CONNECTION_ID_LENGTH);
     QUIC_FRE_ASSERT(MsQuicLib.CidTotalLength <= MSQUIC_CID_MAX_LENGTH);
 
+    if (MsQuicLib.Datapath != NULL) {
+        //
+        // The server ID length just changed, so the partition byte moved.
+        //
+        QuicDataPathSetPartitionInfo(
+            MsQuicLib.Datapath,
+            1 + MsQuicLib.CidServerIdLength,
+            MsQuicLib.PartitionMask);
+    }
+
     QuicTraceLogInfo(
         LibraryCidLengthSet,
         "[ lib] CID Length = %hhu",
         MsQuicLib.CidTotalLength);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicLibrarySumPerfCounters(
+    _Out_writes_bytes_(BufferLength) uint8_t* Buffer,
+    _In_ uint32_t BufferLength
+    )
+{
+    QUIC_DBG_ASSERT(BufferLength <= QUIC_PERF_COUNTER_MAX * sizeof(int64_t));
+    QUIC_DBG_ASSERT(BufferLength % sizeof(int64_t) == 0);
+    const uint32_t CounterCount = BufferLength / sizeof(int64_t);
+    int64_t* const Counters = (int64_t*)Buffer;
+
+    QuicCopyMemory(Buffer, MsQuicLib.PerProc[0].PerfCounters, BufferLength);
+
+    for (uint8_t i = 1; i < MsQuicLib.PartitionCount; ++i) {
+        const int64_t* const PartitionCounters =
+            MsQuicLib.PerProc[i].PerfCounters;
+        for (uint32_t j = 0; j < CounterCount; ++j) {
+            if (j == QUIC_PERF_COUNTER_WORKER_QUEUE_DELAY_US) {
+                if (PartitionCounters[j] > Counters[j]) {
+                    Counters[j] = PartitionCounters[j];
+                }
+            } else {
+                Counters[j] += PartitionCounters[j];
+            }
+        }
+    }
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicLibrarySetGlobalParam(
@@ -541,6 +675,22 @@ QuicLibrarySetGlobalParam(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_GLOBAL_PACKET_PROFILING:
+
+        if (BufferLength != sizeof(uint8_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        MsQuicLib.PacketStageProfiling = *(uint8_t*)Buffer != FALSE;
+        QuicTraceLogInfo(
+            LibraryPacketProfilingSet,
+            "[ lib] Updated packet stage profiling = %hu",
+            MsQuicLib.PacketStageProfiling);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     case QUIC_PARAM_GLOBAL_LOAD_BALACING_MODE: {
 
         if (BufferLength != sizeof(uint16_t)) {
@@ -573,6 +723,58 @@ QuicLibrarySetGlobalParam(
         break;
     }
 
+    case QUIC_PARAM_GLOBAL_PROCESSOR_LIST: {
+
+        if (BufferLength % sizeof(uint16_t) != 0 ||
+            BufferLength / sizeof(uint16_t) > QUIC_MAX_PROCESSOR_LIST_LENGTH ||
+            (BufferLength != 0 && Buffer == NULL)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        const uint16_t* List = (const uint16_t*)Buffer;
+        const uint32_t Count = BufferLength / (uint32_t)sizeof(uint16_t);
+
+        Status = QUIC_STATUS_SUCCESS;
+        for (uint32_t i = 0; i < Count; ++i) {
+            if (List[i] >= QuicProcActiveCount()) {
+                Status = QUIC_STATUS_INVALID_PARAMETER;
+                break;
+            }
+        }
+        if (QUIC_FAILED(Status)) {
+            break;
+        }
+
+        QuicLockAcquire(&MsQuicLib.Lock);
+        if (MsQuicLib.Datapath != NULL ||
+            !QuicListIsEmpty(&MsQuicLib.Registrations)) {
+            //
+            // Worker and/or datapath threads have already been created, so
+            // the pinning can no longer be applied at thread creation.
+            //
+            QuicLockRelease(&MsQuicLib.Lock);
+            QuicTraceLogError(
+                LibraryProcessorListSetAfterInUse,
+                "[ lib] Tried to change processor list after threads created!");
+            Status = QUIC_STATUS_INVALID_STATE;
+            break;
+        }
+        if (Count != 0) {
+            QuicCopyMemory(MsQuicLib.ProcessorList, List, BufferLength);
+        }
+        MsQuicLib.ProcessorListLength = Count;
+        QuicLockRelease(&MsQuicLib.Lock);
+
+        QuicTraceLogInfo(
+            LibraryProcessorListSet,
+            "[ lib] Updated processor list, %u entries",
+            Count);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -653,6 +855,125 @@ QuicLibraryGetGlobalParam(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_GLOBAL_PROCESSOR_LIST: {
+
+        const uint32_t Length =
+            MsQuicLib.ProcessorListLength * (uint32_t)sizeof(uint16_t);
+
+        if (*BufferLength < Length) {
+            *BufferLength = Length;
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL && Length != 0) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = Length;
+        if (Length != 0) {
+            QuicCopyMemory(Buffer, MsQuicLib.ProcessorList, Length);
+        }
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
+    case QUIC_PARAM_GLOBAL_PERF_COUNTERS:
+
+        if (*BufferLength < sizeof(int64_t)) {
+            *BufferLength = QUIC_PERF_COUNTER_MAX * sizeof(int64_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // Allow snapshotting a prefix of the counters, so clients built
+        // against an older counter list keep working.
+        //
+        if (*BufferLength > QUIC_PERF_COUNTER_MAX * sizeof(int64_t)) {
+            *BufferLength = QUIC_PERF_COUNTER_MAX * sizeof(int64_t);
+        } else {
+            *BufferLength = (*BufferLength / sizeof(int64_t)) * sizeof(int64_t);
+        }
+        QuicLibrarySumPerfCounters(Buffer, *BufferLength);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_GLOBAL_DATAPATH_FEATURES:
+
+        if (*BufferLength < sizeof(uint32_t)) {
+            *BufferLength = sizeof(uint32_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        Status = QuicLibraryEnsureDatapath();
+        if (QUIC_FAILED(Status)) {
+            break;
+        }
+
+        *BufferLength = sizeof(uint32_t);
+        *(uint32_t*)Buffer =
+            QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_GLOBAL_TLS_PROVIDER_NAME: {
+
+        const uint32_t NameLength =
+            (uint32_t)strlen(QuicTlsLibraryName) + 1;
+
+        if (*BufferLength < NameLength) {
+            *BufferLength = NameLength;
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = NameLength;
+        QuicCopyMemory(Buffer, QuicTlsLibraryName, NameLength);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
+    case QUIC_PARAM_GLOBAL_TOTAL_ALLOC_COUNT:
+
+        if (*BufferLength < sizeof(int64_t)) {
+            *BufferLength = sizeof(int64_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(int64_t);
+        *(int64_t*)Buffer = QuicTotalAllocCount;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     case QUIC_PARAM_GLOBAL_ENCRYPTION:
 
         if (*BufferLength < sizeof(uint8_t)) {
@@ -672,6 +993,25 @@ QuicLibraryGetGlobalParam(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_GLOBAL_PACKET_PROFILING:
+
+        if (*BufferLength < sizeof(uint8_t)) {
+            *BufferLength = sizeof(uint8_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint8_t);
+        *(uint8_t*)Buffer = MsQuicLib.PacketStageProfiling;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -1017,6 +1357,15 @@ MsQuicOpen(
     Api->StreamReceiveComplete = MsQuicStreamReceiveComplete;
     Api->StreamReceiveSetEnabled = MsQuicStreamReceiveSetEnabled;
 
+    Api->DatagramSend = MsQuicDatagramSend;
+
+    Api->ConnectionBatchBegin = MsQuicConnectionBatchBegin;
+    Api->ConnectionBatchCommit = MsQuicConnectionBatchCommit;
+
+    Api->ConnectionPoolGet = MsQuicConnectionPoolGet;
+
+    Api->SessionDrain = MsQuicSessionDrain;
+
     *QuicApi = Api;
 
 Error:
@@ -1118,6 +1467,15 @@ QuicLibraryGetBinding(
     QUIC_BINDING* Binding;
     QUIC_ADDR NewLocalAddress;
 
+    //
+    // The datapath is brought up lazily, so make sure it exists before any
+    // bindings are looked up or created on it.
+    //
+    QUIC_STATUS DatapathStatus = QuicLibraryEnsureDatapath();
+    if (QUIC_FAILED(DatapathStatus)) {
+        return DatapathStatus;
+    }
+
     //
     // First check to see if a binding already exists that matches the
     // requested addresses.
@@ -1248,6 +1606,114 @@ Exit:
     return Status;
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicLibraryGetClientSprayBinding(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint8_t PartitionId,
+    _Out_ QUIC_BINDING** NewBinding
+    )
+{
+    QUIC_DBG_ASSERT(MsQuicLib.Settings.ClientPortSprayCount > 0);
+
+    //
+    // Lazily allocate the (fixed size) pool on first use. The array is
+    // allocated outside the lock and thrown away if another thread won the
+    // race.
+    //
+    if (MsQuicLib.ClientSprayBindings == NULL) {
+        uint8_t Count = MsQuicLib.Settings.ClientPortSprayCount;
+        QUIC_BINDING** Pool =
+            QUIC_ALLOC_NONPAGED(Count * sizeof(QUIC_BINDING*));
+        if (Pool == NULL) {
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "client spray binding pool",
+                Count * sizeof(QUIC_BINDING*));
+            return QUIC_STATUS_OUT_OF_MEMORY;
+        }
+        QuicZeroMemory(Pool, Count * sizeof(QUIC_BINDING*));
+
+        QuicDispatchLockAcquire(&MsQuicLib.DatapathLock);
+        if (MsQuicLib.ClientSprayBindings == NULL) {
+            //
+            // The pointer is the published guard for the lock-free readers
+            // above, so the count must be visible before it.
+            //
+            MsQuicLib.ClientSprayBindingCount = Count;
+            InterlockedExchangePointer(
+                (void**)&MsQuicLib.ClientSprayBindings, Pool);
+            Pool = NULL;
+        }
+        QuicDispatchLockRelease(&MsQuicLib.DatapathLock);
+
+        if (Pool != NULL) {
+            QUIC_FREE(Pool);
+        }
+    }
+
+    //
+    // The count is only guaranteed ordered against the pool pointer for
+    // readers inside the lock, so compute the slot there too.
+    //
+    QuicDispatchLockAcquire(&MsQuicLib.DatapathLock);
+    uint8_t Slot =
+        QuicPartitionIdGetIndex(PartitionId) % MsQuicLib.ClientSprayBindingCount;
+    QUIC_BINDING* Binding = MsQuicLib.ClientSprayBindings[Slot];
+    if (Binding != NULL) {
+        QUIC_DBG_ASSERT(Binding->RefCount > 0);
+        Binding->RefCount++;
+    }
+    QuicDispatchLockRelease(&MsQuicLib.DatapathLock);
+
+    if (Binding != NULL) {
+        *NewBinding = Binding;
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    //
+    // The slot hasn't been filled yet, so create a new shared, unconnected
+    // binding (on an ephemeral local port) for it.
+    //
+    QUIC_STATUS Status =
+        QuicLibraryGetBinding(
+            Session,
+            TRUE,   // ShareBinding
+            FALSE,  // ServerOwned
+            NULL,   // LocalAddress
+            NULL,   // RemoteAddress
+            &Binding);
+    if (QUIC_FAILED(Status)) {
+        return Status;
+    }
+
+    QuicDispatchLockAcquire(&MsQuicLib.DatapathLock);
+    QUIC_BINDING* RacedBinding = MsQuicLib.ClientSprayBindings[Slot];
+    if (RacedBinding == NULL) {
+        //
+        // The pool takes its own reference, in addition to the caller's.
+        //
+        MsQuicLib.ClientSprayBindings[Slot] = Binding;
+        Binding->RefCount++;
+    } else {
+        RacedBinding->RefCount++;
+    }
+    QuicDispatchLockRelease(&MsQuicLib.DatapathLock);
+
+    if (RacedBinding != NULL) {
+        //
+        // Another thread filled the slot first. Use its binding and throw
+        // ours away.
+        //
+        QuicLibraryReleaseBinding(Binding);
+        Binding = RacedBinding;
+    }
+
+    *NewBinding = Binding;
+    return QUIC_STATUS_SUCCESS;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicLibraryTryAddRefBinding(
@@ -1333,7 +1799,9 @@ QuicLibraryOnListenerRegistered(
             QuicWorkerPoolInitialize(
                 NULL,
                 0,
+                MsQuicLib.Settings.WorkerIdleSpinUs,
                 max(1, MsQuicLib.PartitionCount / 4),
+                NULL,
                 &MsQuicLib.WorkerPool))) {
             Success = FALSE;
             MsQuicSessionClose((HQUIC)MsQuicLib.UnregisteredSession);
@@ -1378,7 +1846,8 @@ QuicTraceRundown(
             LibraryRundown,
             "[ lib] Rundown, PartitionCount=%u DatapathFeatures=%u",
             MsQuicLib.PartitionCount,
-            QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath));
+            MsQuicLib.Datapath == NULL ?
+                0 : QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath));
 
         for (QUIC_LIST_ENTRY* Link = MsQuicLib.Registrations.Flink;
             Link != &MsQuicLib.Registrations;
@@ -46,6 +46,21 @@ typedef struct QUIC_CACHEALIGN QUIC_LIBRARY_PP {
     //
     QUIC_POOL ConnectionPool;
 
+    //
+    // Pool for QUIC_PACKET_SPACEs. Every connection allocates one per
+    // encryption level at initialization, so keeping them pooled alongside
+    // the connections keeps accept storms off the heap.
+    //
+    QUIC_POOL PacketSpacePool;
+
+    //
+    // This partition's slice of the library-wide performance counters. A
+    // snapshot sums (or takes the maximum of, for the gauges) the slices
+    // across all partitions. Kept per-partition and cache-line-padded (via
+    // the struct alignment) so the hot paths never contend on them.
+    //
+    int64_t PerfCounters[QUIC_PERF_COUNTER_MAX];
+
 } QUIC_LIBRARY_PP;
 
 //
@@ -79,30 +94,16 @@ typedef struct QUIC_LIBRARY {
     BOOLEAN EncryptionDisabled;
 
     //
-    // Index for the current stateless retry token key.
+    // Indicates the receive path logs per-stage packet cost perf events
+    // (QUIC_PERF_EVENT_RX_STAGES). Defaults to FALSE.
     //
-    BOOLEAN CurrentStatelessRetryKey;
+    BOOLEAN PacketStageProfiling;
 
     //
     // Configurable (app & registry) settings.
     //
     QUIC_SETTINGS Settings;
 
-    //
-    // Controls access to all non-datapath internal state of the library.
-    //
-    QUIC_LOCK Lock;
-
-    //
-    // Controls access to all datapath internal state of the library.
-    //
-    QUIC_DISPATCH_LOCK DatapathLock;
-
-    //
-    // Total outstanding references on the library.
-    //
-    uint32_t RefCount;
-
     //
     // Number of partitions currently being used.
     //
@@ -114,17 +115,14 @@ typedef struct QUIC_LIBRARY {
     //
     uint8_t PartitionMask;
 
-#if DEBUG
-    //
-    // Number of connections current allocated.
-    //
-    long ConnectionCount;
-#endif
-
     //
-    // Next worker to use in the pool.
+    // Optional app-supplied list of processors that worker and datapath
+    // threads are pinned to, in place of the default one-per-partition
+    // placement. Only settable while no worker or datapath threads exist
+    // yet. A length of zero means no list is configured.
     //
-    uint8_t NextWorkerIndex;
+    uint16_t ProcessorList[QUIC_MAX_PROCESSOR_LIST_LENGTH];
+    uint32_t ProcessorListLength;
 
     //
     // Estimated timer resolution for the platform.
@@ -141,56 +139,126 @@ typedef struct QUIC_LIBRARY {
     uint8_t CidTotalLength;
 
     //
-    // An identifier used for correlating connection logs and statistics.
+    // Handle to global persistent storage (registry).
     //
-    uint64_t ConnectionCorrelationId;
+    QUIC_STORAGE* Storage;
 
     //
-    // The estiamted current total memory usage for handshake connections.
+    // Datapath instance for the library. NULL until the first listener or
+    // connection needs it (see QuicLibraryEnsureDatapath); never cleared
+    // again until the library uninitializes.
     //
-    uint64_t CurrentHandshakeMemoryUsage;
+    QUIC_DATAPATH* Datapath;
 
     //
-    // Handle to global persistent storage (registry).
+    // Contains all (server) connections currently not in an app's registration.
     //
-    QUIC_STORAGE* Storage;
+    QUIC_SESSION* UnregisteredSession;
 
     //
-    // Datapath instance for the library.
+    // Set of workers that manage processing client Initial packets on the
+    // server side.
     //
-    QUIC_DATAPATH* Datapath;
+    QUIC_WORKER_POOL* WorkerPool;
+
+    //
+    // Per-processor storage. Count of `PartitionCount`.
+    //
+    _Field_size_(PartitionCount)
+    QUIC_LIBRARY_PP* PerProc;
+
+    //
+    // The Toeplitz hash used for hashing received long header packets.
+    //
+    QUIC_TOEPLITZ_HASH ToeplitzHash;
+
+    //
+    // Everything above is read-mostly once the library is initialized. The
+    // state below is written from arbitrary processors, so each group sits
+    // on its own cache line (QUIC_CACHEALIGN) to keep those writes from
+    // bouncing the lines holding the configuration.
+    //
+
+    //
+    // Controls access to all non-datapath internal state of the library,
+    // grouped with the state it guards.
+    //
+    QUIC_CACHEALIGN QUIC_LOCK Lock;
+
+    //
+    // Total outstanding references on the library.
+    //
+    uint32_t RefCount;
+
+#if DEBUG
+    //
+    // Number of connections current allocated.
+    //
+    long ConnectionCount;
+#endif
+
+    //
+    // Next worker to use in the pool.
+    //
+    uint8_t NextWorkerIndex;
 
     //
     // List of all registrations in the current process (or kernel).
     //
     QUIC_LIST_ENTRY Registrations;
 
+    //
+    // Controls access to all datapath internal state of the library, grouped
+    // with the state it guards.
+    //
+    QUIC_CACHEALIGN QUIC_DISPATCH_LOCK DatapathLock;
+
     //
     // List of all UDP bindings in the current process (or kernel).
     //
     QUIC_LIST_ENTRY Bindings;
 
     //
-    // Contains all (server) connections currently not in an app's registration.
+    // Lazily created pool of shared client bindings, used when the (global)
+    // ClientPortSprayCount setting is nonzero. Client connections without an
+    // explicit local address are striped across the pool by partition, so
+    // high connection count clients neither contend on a single shared
+    // binding nor open a socket per connection. The count is snapshotted from
+    // the setting when the pool is first used. Guarded by DatapathLock; the
+    // pool holds one reference on each binding.
     //
-    QUIC_SESSION* UnregisteredSession;
+    _Field_size_(ClientSprayBindingCount)
+    QUIC_BINDING** ClientSprayBindings;
+    uint8_t ClientSprayBindingCount;
 
     //
-    // Set of workers that manage processing client Initial packets on the
-    // server side.
+    // An identifier used for correlating connection logs and statistics.
+    // Updated with interlocked operations from any processor, as are the two
+    // memory estimates below.
     //
-    QUIC_WORKER_POOL* WorkerPool;
+    QUIC_CACHEALIGN uint64_t ConnectionCorrelationId;
 
     //
-    // Per-processor storage. Count of `PartitionCount`.
+    // The estiamted current total memory usage for handshake connections.
     //
-    _Field_size_(PartitionCount)
-    QUIC_LIBRARY_PP* PerProc;
+    uint64_t CurrentHandshakeMemoryUsage;
+
+    //
+    // The estimated current total memory usage of receive and send buffers
+    // across all connections.
+    //
+    uint64_t CurrentBufferMemoryUsage;
 
     //
-    // Controls access to the stateless retry keys when rotated.
+    // Controls access to the stateless retry keys when rotated. A dispatch
+    // lock so the keys can be used directly on the datapath.
     //
-    QUIC_LOCK StatelessRetryKeysLock;
+    QUIC_CACHEALIGN QUIC_DISPATCH_LOCK StatelessRetryKeysLock;
+
+    //
+    // Index for the current stateless retry token key.
+    //
+    BOOLEAN CurrentStatelessRetryKey;
 
     //
     // Keys used for encryption of stateless retry tokens.
@@ -202,11 +270,6 @@ typedef struct QUIC_LIBRARY {
     //
     int64_t StatelessRetryKeysExpiration[2];
 
-    //
-    // The Toeplitz hash used for hashing received long header packets.
-    //
-    QUIC_TOEPLITZ_HASH ToeplitzHash;
-
 } QUIC_LIBRARY;
 
 extern QUIC_LIBRARY MsQuicLib;
@@ -229,6 +292,107 @@ QuicLibraryGetCurrentPartition(
     return ((uint8_t)QuicProcCurrentNumber()) % MsQuicLib.PartitionCount;
 }
 
+//
+// Maps a logical (partition) index onto the app-configured processor list,
+// when one is set. Without a list the index is the processor.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+inline
+uint16_t
+QuicLibraryMapProcessor(
+    _In_ uint16_t Index
+    )
+{
+    if (MsQuicLib.ProcessorListLength == 0) {
+        return Index;
+    }
+    return MsQuicLib.ProcessorList[Index % MsQuicLib.ProcessorListLength];
+}
+
+//
+// Adds a value to a library-wide performance counter, on the current
+// partition's slice.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+inline
+void
+QuicPerfCounterAdd(
+    _In_ QUIC_PERFORMANCE_COUNTERS Type,
+    _In_ int64_t Value
+    )
+{
+    QUIC_DBG_ASSERT(Type < QUIC_PERF_COUNTER_MAX);
+    InterlockedExchangeAdd64(
+        &MsQuicLib.PerProc[QuicLibraryGetCurrentPartition()].PerfCounters[Type],
+        Value);
+}
+
+#define QuicPerfCounterIncrement(Type) QuicPerfCounterAdd(Type, 1)
+#define QuicPerfCounterDecrement(Type) QuicPerfCounterAdd(Type, -1)
+
+//
+// Adjusts the library's estimate of total buffer (receive and send) memory
+// usage by the given signed delta.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+inline
+void
+QuicLibraryOnBufferMemoryChange(
+    _In_ int64_t Delta
+    )
+{
+    InterlockedExchangeAdd64(
+        (int64_t*)&MsQuicLib.CurrentBufferMemoryUsage,
+        Delta);
+}
+
+//
+// Returns TRUE if buffer memory usage is over the configured fraction of
+// total system memory. While under pressure, receive window grants stop
+// growing, oversized idle windows shrink and the workers trim their pool
+// depots.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+inline
+BOOLEAN
+QuicLibraryUnderMemoryPressure(
+    void
+    )
+{
+    uint64_t CurrentMemoryLimit =
+        (MsQuicLib.Settings.BufferMemoryLimit * QuicTotalMemory) / UINT16_MAX;
+    return MsQuicLib.CurrentBufferMemoryUsage > CurrentMemoryLimit;
+}
+
+//
+// Overwrites a gauge-style performance counter on the current partition's
+// slice. A snapshot reports the maximum across the partitions.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+inline
+void
+QuicPerfCounterSet(
+    _In_ QUIC_PERFORMANCE_COUNTERS Type,
+    _In_ int64_t Value
+    )
+{
+    QUIC_DBG_ASSERT(Type < QUIC_PERF_COUNTER_MAX);
+    MsQuicLib.PerProc[QuicLibraryGetCurrentPartition()].PerfCounters[Type] =
+        Value;
+}
+
+//
+// Writes a snapshot of the library-wide performance counters, aggregated
+// across all partitions, to the supplied buffer. The buffer length must be a
+// multiple of sizeof(int64_t) and may cover a prefix of the counters.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicLibrarySumPerfCounters(
+    _Out_writes_bytes_(BufferLength) uint8_t* Buffer,
+    _In_ uint32_t BufferLength
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 inline
 uint8_t
@@ -269,6 +433,8 @@ _Success_(return != NULL)
 QUIC_CID_HASH_ENTRY*
 QuicCidNewRandomSource(
     _In_opt_ QUIC_CONNECTION* Connection,
+    _Inout_updates_opt_(QUIC_CONN_SOURCE_CID_SLOT_COUNT)
+        QUIC_CID_SLOT* Slots,
     _In_reads_opt_(MsQuicLib.CidServerIdLength)
         const void* ServerID,
     _In_ uint8_t PartitionID,
@@ -282,14 +448,10 @@ QuicCidNewRandomSource(
     QUIC_DBG_ASSERT(MSQUIC_CID_PAYLOAD_LENGTH > PrefixLength);
 
     QUIC_CID_HASH_ENTRY* Entry =
-        (QUIC_CID_HASH_ENTRY*)
-        QUIC_ALLOC_NONPAGED(
-            sizeof(QUIC_CID_HASH_ENTRY) +
-            MsQuicLib.CidTotalLength);
+        QuicCidSourceAlloc(Slots, MsQuicLib.CidTotalLength);
 
     if (Entry != NULL) {
         Entry->Connection = Connection;
-        QuicZeroMemory(&Entry->CID, sizeof(Entry->CID));
         Entry->CID.Length = MsQuicLib.CidTotalLength;
 
         uint8_t* Data = Entry->CID.Data;
@@ -353,6 +515,18 @@ QuicLibraryGetParam(
         void* Buffer
     );
 
+//
+// Initializes the library's datapath instance (and its per-processor worker
+// threads) on first use, if it hasn't been already. Deferred out of library
+// initialization to keep MsQuicOpen cheap and the process fork safe until
+// the first listener or connection actually needs the network.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicLibraryEnsureDatapath(
+    void
+    );
+
 //
 // Get the binding for the addresses.
 //
@@ -367,6 +541,19 @@ QuicLibraryGetBinding(
     _Out_ QUIC_BINDING** NewBinding
     );
 
+//
+// Gets a shared binding from the client port spray pool, striped by the
+// connection's partition. Only valid when the ClientPortSprayCount setting is
+// nonzero.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicLibraryGetClientSprayBinding(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint8_t PartitionId,
+    _Out_ QUIC_BINDING** NewBinding
+    );
+
 //
 // Tries to acquire a ref on the binding. Fails if already starting the clean up
 // process.
@@ -418,9 +605,10 @@ QuicLibraryGetCurrentStatelessRetryKey(
     );
 
 //
-// Returns the stateless retry key for that timestamp.
+// Returns the stateless retry key for that timestamp. Never creates a new
+// key, so it's safe to call on the datapath.
 //
-_IRQL_requires_max_(PASSIVE_LEVEL)
+_IRQL_requires_max_(DISPATCH_LEVEL)
 _Ret_maybenull_
 QUIC_KEY*
 QuicLibraryGetStatelessRetryKeyForTimestamp(
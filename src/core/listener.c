@@ -122,6 +122,9 @@ MsQuicListenerClose(
     MsQuicListenerStop(Handle);
 
     QuicRundownUninitialize(&Listener->Rundown);
+    if (Listener->ServerName != NULL) {
+        QUIC_FREE(Listener->ServerName);
+    }
     QUIC_FREE(Listener);
 
     QuicTraceEvent(
@@ -505,12 +508,59 @@ QuicListenerParamSet(
 {
     QUIC_STATUS Status;
 
-    UNREFERENCED_PARAMETER(Listener);
-    UNREFERENCED_PARAMETER(BufferLength);
-    UNREFERENCED_PARAMETER(Buffer);
-
     switch (Param) {
 
+    case QUIC_PARAM_LISTENER_SERVER_NAME: {
+
+        if (Listener->Binding != NULL) {
+            //
+            // The filter participates in the binding's listener sort order,
+            // so it can't change while registered.
+            //
+            Status = QUIC_STATUS_INVALID_STATE;
+            break;
+        }
+
+        //
+        // A terminating null in the buffer is optional; the stored filter is
+        // always unterminated, like the parsed ClientHello server name it is
+        // compared against.
+        //
+        uint32_t NameLength = BufferLength;
+        if (NameLength != 0 && ((const char*)Buffer)[NameLength - 1] == '\0') {
+            NameLength--;
+        }
+
+        if (NameLength > UINT16_MAX) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        char* NewServerName = NULL;
+        if (NameLength != 0) {
+            NewServerName = QUIC_ALLOC_NONPAGED(NameLength);
+            if (NewServerName == NULL) {
+                QuicTraceEvent(
+                    AllocFailure,
+                    "Allocation of '%s' failed. (%llu bytes)",
+                    "listener server name",
+                    NameLength);
+                Status = QUIC_STATUS_OUT_OF_MEMORY;
+                break;
+            }
+            QuicCopyMemory(NewServerName, Buffer, NameLength);
+        }
+
+        if (Listener->ServerName != NULL) {
+            QUIC_FREE(Listener->ServerName);
+        }
+        Listener->ServerName = NewServerName;
+        Listener->ServerNameLength = (uint16_t)NameLength;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -576,6 +626,28 @@ QuicListenerParamGet(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_LISTENER_SERVER_NAME:
+
+        if (*BufferLength < Listener->ServerNameLength) {
+            *BufferLength = Listener->ServerNameLength;
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = Listener->ServerNameLength;
+        if (Listener->ServerNameLength != 0) {
+            QuicCopyMemory(
+                Buffer, Listener->ServerName, Listener->ServerNameLength);
+        }
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
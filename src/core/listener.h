@@ -47,6 +47,17 @@ typedef struct QUIC_LISTENER {
     //
     QUIC_LISTENER_CALLBACK_HANDLER ClientCallbackHandler;
 
+    //
+    // Optional server name (SNI) filter, set before the listener is started.
+    // When present, only new connections whose ClientHello carries a matching
+    // server name are routed to this listener, so multiple tenants sharing an
+    // ALPN on one port can each run their own listener (and registration
+    // worker pool). NULL accepts any server name.
+    //
+    _Field_size_opt_(ServerNameLength)
+    char* ServerName;
+    uint16_t ServerNameLength;
+
     //
     // Stats for the Listener.
     //
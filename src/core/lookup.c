@@ -11,13 +11,98 @@ Abstract:
 
 #include "precomp.h"
 
+//
+// A single per-processor reader lock. Padded to a cacheline so readers on
+// different processors never share one.
+//
+typedef struct QUIC_CACHEALIGN QUIC_LOOKUP_READ_SHARD {
+
+    QUIC_DISPATCH_LOCK Lock;
+
+    //
+    // The CID entry the last lookup through this shard resolved to. Receive
+    // batches have strong flow locality, so the next lookup on this processor
+    // usually matches with one compare and skips the hash table entirely.
+    // Protected by Lock: readers update it holding the shard shared, and CID
+    // removal, which holds every shard, clears any pointers to the entry
+    // being removed.
+    //
+    QUIC_CID_HASH_ENTRY* LastHit;
+
+} QUIC_LOOKUP_READ_SHARD;
+
 typedef struct QUIC_CACHEALIGN QUIC_PARTITIONED_HASHTABLE {
 
-    QUIC_DISPATCH_RW_LOCK RwLock;
+    //
+    // The number of entries in the ReadShards array.
+    //
+    uint32_t ReadShardCount;
+
+    //
+    // Per-processor reader locks protecting Table. A reader only acquires the
+    // shard for the processor it is currently running on, so the receive hot
+    // path never bounces a lock cacheline between processors. A writer
+    // acquires every shard, which is acceptable since writes only happen
+    // during connection setup and teardown.
+    //
+    _Field_size_(ReadShardCount)
+    QUIC_LOOKUP_READ_SHARD* ReadShards;
+
     QUIC_HASHTABLE Table;
 
 } QUIC_PARTITIONED_HASHTABLE;
 
+//
+// Acquires the current processor's reader shard for the table. Returns the
+// shard index, which the caller must pass to the release call, in case the
+// thread migrates processors in between.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicLookupPartitionAcquireShared(
+    _In_ QUIC_PARTITIONED_HASHTABLE* Table
+    )
+{
+    uint32_t Shard = QuicProcCurrentNumber() % Table->ReadShardCount;
+    QuicDispatchLockAcquire(&Table->ReadShards[Shard].Lock);
+    return Shard;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicLookupPartitionReleaseShared(
+    _In_ QUIC_PARTITIONED_HASHTABLE* Table,
+    _In_ uint32_t Shard
+    )
+{
+    QuicDispatchLockRelease(&Table->ReadShards[Shard].Lock);
+}
+
+//
+// Acquires every reader shard, locking out all readers of the table.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicLookupPartitionAcquireExclusive(
+    _In_ QUIC_PARTITIONED_HASHTABLE* Table
+    )
+{
+    for (uint32_t i = 0; i < Table->ReadShardCount; i++) {
+        QuicDispatchLockAcquire(&Table->ReadShards[i].Lock);
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicLookupPartitionReleaseExclusive(
+    _In_ QUIC_PARTITIONED_HASHTABLE* Table
+    )
+{
+    for (uint32_t i = Table->ReadShardCount; i > 0; i--) {
+        QuicDispatchLockRelease(&Table->ReadShards[i - 1].Lock);
+    }
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicLookupInsertLocalCid(
@@ -53,7 +138,10 @@ QuicLookupUninitialize(
             QUIC_PARTITIONED_HASHTABLE* Table = &Lookup->HASH.Tables[i];
             QUIC_DBG_ASSERT(Table->Table.NumEntries == 0);
             QuicHashtableUninitialize(&Table->Table);
-            QuicDispatchRwLockUninitialize(&Table->RwLock);
+            for (uint32_t j = 0; j < Table->ReadShardCount; j++) {
+                QuicDispatchLockUninitialize(&Table->ReadShards[j].Lock);
+            }
+            QUIC_FREE(Table->ReadShards);
         }
         QUIC_FREE(Lookup->HASH.Tables);
     }
@@ -84,17 +172,39 @@ QuicLookupCreateHashTable(
 
     if (Lookup->HASH.Tables != NULL) {
 
+        uint32_t ReadShardCount = QuicProcMaxCount();
         uint8_t Cleanup = 0;
         for (uint8_t i = 0; i < PartitionCount; i++) {
-            if (!QuicHashtableInitializeEx(&Lookup->HASH.Tables[i].Table, QUIC_HASH_MIN_SIZE)) {
+            QUIC_PARTITIONED_HASHTABLE* Table = &Lookup->HASH.Tables[i];
+            if (!QuicHashtableInitializeEx(&Table->Table, QUIC_HASH_MIN_SIZE)) {
+                Cleanup = i;
+                break;
+            }
+            Table->ReadShardCount = ReadShardCount;
+            Table->ReadShards =
+                QUIC_ALLOC_NONPAGED(ReadShardCount * sizeof(QUIC_LOOKUP_READ_SHARD));
+            if (Table->ReadShards == NULL) {
+                QuicTraceEvent(
+                    AllocFailure,
+                    "Allocation of '%s' failed. (%llu bytes)", "lookup read shards",
+                    ReadShardCount * sizeof(QUIC_LOOKUP_READ_SHARD));
+                QuicHashtableUninitialize(&Table->Table);
                 Cleanup = i;
                 break;
             }
-            QuicDispatchRwLockInitialize(&Lookup->HASH.Tables[i].RwLock);
+            for (uint32_t j = 0; j < ReadShardCount; j++) {
+                QuicDispatchLockInitialize(&Table->ReadShards[j].Lock);
+                Table->ReadShards[j].LastHit = NULL;
+            }
         }
         if (Cleanup != 0) {
             for (uint8_t i = 0; i < Cleanup; i++) {
-                QuicHashtableUninitialize(&Lookup->HASH.Tables[i].Table);
+                QUIC_PARTITIONED_HASHTABLE* Table = &Lookup->HASH.Tables[i];
+                QuicHashtableUninitialize(&Table->Table);
+                for (uint32_t j = 0; j < Table->ReadShardCount; j++) {
+                    QuicDispatchLockUninitialize(&Table->ReadShards[j].Lock);
+                }
+                QUIC_FREE(Table->ReadShards);
             }
             QUIC_FREE(Lookup->HASH.Tables);
             Lookup->HASH.Tables = NULL;
@@ -217,11 +327,26 @@ QuicLookupRebalance(
                         FALSE);
                 }
                 QuicHashtableUninitialize(&PreviousTable[i].Table);
+                for (uint32_t j = 0; j < PreviousTable[i].ReadShardCount; j++) {
+                    QuicDispatchLockUninitialize(&PreviousTable[i].ReadShards[j].Lock);
+                }
+                QUIC_FREE(PreviousTable[i].ReadShards);
             }
             QUIC_FREE(PreviousTable);
         }
     }
 
+    if (Lookup->MaximizePartitioning &&
+        Lookup->PartitionCount == MsQuicLib.PartitionCount) {
+        //
+        // The tables are in their final form: the partition count only ever
+        // grows, and it can't grow past the library's partition count. From
+        // here on, the local CID lookup may index the tables without the
+        // lookup-wide lock.
+        //
+        Lookup->PartitioningFinal = TRUE;
+    }
+
     return TRUE;
 }
 
@@ -276,7 +401,7 @@ QuicCidMatchConnection(
             QUIC_CONTAINING_RECORD(Link, const QUIC_CID_HASH_ENTRY, Link);
 
         if (Length == Entry->CID.Length &&
-            (Length == 0 || memcmp(DestCid, Entry->CID.Data, Length) == 0)) {
+            QuicCidEqual(DestCid, Entry->CID.Data, Length)) {
             return TRUE;
         }
     }
@@ -285,12 +410,32 @@ QuicCidMatchConnection(
 }
 
 //
-// Uses the hash and destination connection ID to look up the connection in the
-// hash table. Returns the pointer to the connection if found; NULL otherwise.
+// Returns the partitioned hash table that a connection ID maps to, based on
+// the partition byte encoded in the CID.
 //
 _IRQL_requires_max_(DISPATCH_LEVEL)
-QUIC_CONNECTION*
-QuicHashLookupConnection(
+QUIC_PARTITIONED_HASHTABLE*
+QuicLookupGetPartitionedTable(
+    _In_ QUIC_LOOKUP* Lookup,
+    _In_reads_(MsQuicLib.CidServerIdLength + MSQUIC_CID_PID_LENGTH)
+        const uint8_t* const CID
+    )
+{
+    QUIC_DBG_ASSERT(Lookup->PartitionCount != 0);
+    QUIC_STATIC_ASSERT(MSQUIC_CID_PID_LENGTH == 1, "The code below assumes 1 byte");
+    uint32_t PartitionIndex = CID[MsQuicLib.CidServerIdLength];
+    PartitionIndex &= MsQuicLib.PartitionMask;
+    PartitionIndex %= Lookup->PartitionCount;
+    return &Lookup->HASH.Tables[PartitionIndex];
+}
+
+//
+// Uses the hash and destination connection ID to look up the CID entry in the
+// hash table. Returns the pointer to the entry if found; NULL otherwise.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_CID_HASH_ENTRY*
+QuicHashLookupCid(
     _In_ QUIC_HASHTABLE* Table,
     _In_reads_(Length)
         const uint8_t* const DestCid,
@@ -307,8 +452,8 @@ QuicHashLookupConnection(
             QUIC_CONTAINING_RECORD(TableEntry, QUIC_CID_HASH_ENTRY, Entry);
 
         if (CIDEntry->CID.Length == Length &&
-            memcmp(DestCid, CIDEntry->CID.Data, Length) == 0) {
-            return CIDEntry->Connection;
+            QuicCidEqual(DestCid, CIDEntry->CID.Data, Length)) {
+            return CIDEntry;
         }
 
         TableEntry = QuicHashtableLookupNext(Table, &Context);
@@ -348,20 +493,20 @@ QuicLookupFindConnectionByLocalCidInternal(
         // partitioned hash table array, and look up the connection in that
         // hash table.
         //
-        QUIC_STATIC_ASSERT(MSQUIC_CID_PID_LENGTH == 1, "The code below assumes 1 byte");
-        uint32_t PartitionIndex = CID[MsQuicLib.CidServerIdLength];
-        PartitionIndex &= MsQuicLib.PartitionMask;
-        PartitionIndex %= Lookup->PartitionCount;
-        QUIC_PARTITIONED_HASHTABLE* Table = &Lookup->HASH.Tables[PartitionIndex];
-
-        QuicDispatchRwLockAcquireShared(&Table->RwLock);
-        Connection =
-            QuicHashLookupConnection(
+        QUIC_PARTITIONED_HASHTABLE* Table =
+            QuicLookupGetPartitionedTable(Lookup, CID);
+
+        uint32_t Shard = QuicLookupPartitionAcquireShared(Table);
+        QUIC_CID_HASH_ENTRY* CidEntry =
+            QuicHashLookupCid(
                 &Table->Table,
                 CID,
                 CIDLen,
                 Hash);
-        QuicDispatchRwLockReleaseShared(&Table->RwLock);
+        if (CidEntry != NULL) {
+            Connection = CidEntry->Connection;
+        }
+        QuicLookupPartitionReleaseShared(Table, Shard);
     }
 
 #if QUIC_DEBUG_HASHTABLE_LOOKUP
@@ -409,7 +554,7 @@ QuicLookupFindConnectionByRemoteHashInternal(
 
         if (QuicAddrCompare(RemoteAddress, &Entry->RemoteAddress) &&
             RemoteCidLength == Entry->RemoteCidLength &&
-            memcmp(RemoteCid, Entry->RemoteCid, RemoteCidLength) == 0) {
+            QuicCidEqual(RemoteCid, Entry->RemoteCid, RemoteCidLength)) {
 #if QUIC_DEBUG_HASHTABLE_LOOKUP
             QuicTraceLogVerbose(
                 LookupRemoteHashFound,
@@ -466,23 +611,20 @@ QuicLookupInsertLocalCid(
         //
         // Insert the source connection ID into the hash table.
         //
-        QUIC_STATIC_ASSERT(MSQUIC_CID_PID_LENGTH == 1, "The code below assumes 1 byte");
-        uint32_t PartitionIndex = SourceCid->CID.Data[MsQuicLib.CidServerIdLength];
-        PartitionIndex &= MsQuicLib.PartitionMask;
-        PartitionIndex %= Lookup->PartitionCount;
-        QUIC_PARTITIONED_HASHTABLE* Table = &Lookup->HASH.Tables[PartitionIndex];
+        QUIC_PARTITIONED_HASHTABLE* Table =
+            QuicLookupGetPartitionedTable(Lookup, SourceCid->CID.Data);
 
-        QuicDispatchRwLockAcquireExclusive(&Table->RwLock);
+        QuicLookupPartitionAcquireExclusive(Table);
         QuicHashtableInsert(
             &Table->Table,
             &SourceCid->Entry,
             Hash,
             NULL);
-        QuicDispatchRwLockReleaseExclusive(&Table->RwLock);
+        QuicLookupPartitionReleaseExclusive(Table);
     }
 
     if (UpdateRefCount) {
-        Lookup->CidCount++;
+        InterlockedIncrement(&Lookup->CidCount);
         QuicConnAddRef(SourceCid->Connection, QUIC_CONN_REF_LOOKUP_TABLE);
     }
 
@@ -559,7 +701,8 @@ QuicLookupInsertRemoteHash(
 
 //
 // Removes a source connection ID from the lookup table. Requires the
-// Lookup->RwLock to be exlusively held.
+// Lookup->RwLock to be exlusively held, unless partitioning is final, in
+// which case the partition's reader shards (acquired internally) suffice.
 //
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
@@ -569,8 +712,8 @@ QuicLookupRemoveLocalCidInt(
     )
 {
     QUIC_DBG_ASSERT(SourceCid->CID.IsInLookupTable);
-    QUIC_DBG_ASSERT(Lookup->CidCount != 0);
-    Lookup->CidCount--;
+    long NewCidCount = InterlockedDecrement(&Lookup->CidCount);
+    QUIC_DBG_ASSERT(NewCidCount >= 0);
 
 #if QUIC_DEBUG_HASHTABLE_LOOKUP
     QuicTraceLogVerbose(
@@ -582,7 +725,7 @@ QuicLookupRemoveLocalCidInt(
 
     if (Lookup->PartitionCount == 0) {
         QUIC_DBG_ASSERT(Lookup->SINGLE.Connection == SourceCid->Connection);
-        if (Lookup->CidCount == 0) {
+        if (NewCidCount == 0) {
             //
             // This was the last CID reference, so we can clear the connection
             // pointer.
@@ -595,14 +738,20 @@ QuicLookupRemoveLocalCidInt(
         //
         // Remove the source connection ID from the multi-hash table.
         //
-        QUIC_STATIC_ASSERT(MSQUIC_CID_PID_LENGTH == 1, "The code below assumes 1 byte");
-        uint32_t PartitionIndex = SourceCid->CID.Data[MsQuicLib.CidServerIdLength];
-        PartitionIndex &= MsQuicLib.PartitionMask;
-        PartitionIndex %= Lookup->PartitionCount;
-        QUIC_PARTITIONED_HASHTABLE* Table = &Lookup->HASH.Tables[PartitionIndex];
-        QuicDispatchRwLockAcquireExclusive(&Table->RwLock);
+        QUIC_PARTITIONED_HASHTABLE* Table =
+            QuicLookupGetPartitionedTable(Lookup, SourceCid->CID.Data);
+        QuicLookupPartitionAcquireExclusive(Table);
         QuicHashtableRemove(&Table->Table, &SourceCid->Entry, NULL);
-        QuicDispatchRwLockReleaseExclusive(&Table->RwLock);
+        //
+        // All the reader shards are held, so the entry can be safely scrubbed
+        // from any last-hit caches pointing at it before it is freed.
+        //
+        for (uint32_t i = 0; i < Table->ReadShardCount; i++) {
+            if (Table->ReadShards[i].LastHit == SourceCid) {
+                Table->ReadShards[i].LastHit = NULL;
+            }
+        }
+        QuicLookupPartitionReleaseExclusive(Table);
     }
 }
 
@@ -615,6 +764,51 @@ QuicLookupFindConnectionByLocalCid(
     _In_ uint8_t CIDLen
     )
 {
+    if (Lookup->PartitioningFinal) {
+        //
+        // The partitioned tables will never be replaced again, so the
+        // receive hot path can go straight to the partition indicated by the
+        // CID without taking the lookup-wide lock. The processor's reader
+        // shard keeps the connection alive until the reference is added,
+        // since removals acquire every shard.
+        //
+        QUIC_DBG_ASSERT(CIDLen >= QUIC_MIN_INITIAL_CONNECTION_ID_LENGTH);
+        QUIC_PARTITIONED_HASHTABLE* Table =
+            QuicLookupGetPartitionedTable(Lookup, CID);
+
+        uint32_t Shard = QuicLookupPartitionAcquireShared(Table);
+
+        //
+        // Check this processor's last-hit entry first. Datagram batches are
+        // dominated by back-to-back packets of the same flow, so the common
+        // case is a single CID compare and no hash computation or table walk.
+        //
+        QUIC_LOOKUP_READ_SHARD* ReadShard = &Table->ReadShards[Shard];
+        QUIC_CID_HASH_ENTRY* CidEntry = ReadShard->LastHit;
+        if (CidEntry == NULL ||
+            CidEntry->CID.Length != CIDLen ||
+            memcmp(CID, CidEntry->CID.Data, CIDLen) != 0) {
+            CidEntry =
+                QuicHashLookupCid(
+                    &Table->Table,
+                    CID,
+                    CIDLen,
+                    QuicHashSimple(CIDLen, CID));
+            if (CidEntry != NULL) {
+                ReadShard->LastHit = CidEntry;
+            }
+        }
+
+        QUIC_CONNECTION* Connection = NULL;
+        if (CidEntry != NULL) {
+            Connection = CidEntry->Connection;
+            QuicConnAddRef(Connection, QUIC_CONN_REF_LOOKUP_RESULT);
+        }
+        QuicLookupPartitionReleaseShared(Table, Shard);
+
+        return Connection;
+    }
+
     uint32_t Hash = QuicHashSimple(CIDLen, CID);
 
     QuicDispatchRwLockAcquireShared(&Lookup->RwLock);
@@ -745,6 +939,40 @@ QuicLookupAddLocalCid(
     return Result;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint8_t
+QuicLookupAddLocalCids(
+    _In_ QUIC_LOOKUP* Lookup,
+    _In_reads_(Count) QUIC_CID_HASH_ENTRY** SourceCids,
+    _In_ uint8_t Count
+    )
+{
+    uint8_t Inserted = 0;
+
+    QuicDispatchRwLockAcquireExclusive(&Lookup->RwLock);
+
+    for (uint8_t i = 0; i < Count; ++i) {
+        QUIC_CID_HASH_ENTRY* SourceCid = SourceCids[i];
+        uint32_t Hash =
+            QuicHashSimple(SourceCid->CID.Length, SourceCid->CID.Data);
+
+        QUIC_DBG_ASSERT(!SourceCid->CID.IsInLookupTable);
+
+        if (QuicLookupFindConnectionByLocalCidInternal(
+                Lookup,
+                SourceCid->CID.Data,
+                SourceCid->CID.Length,
+                Hash) == NULL &&
+            QuicLookupInsertLocalCid(Lookup, Hash, SourceCid, TRUE)) {
+            Inserted++;
+        }
+    }
+
+    QuicDispatchRwLockReleaseExclusive(&Lookup->RwLock);
+
+    return Inserted;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicLookupAddRemoteHash(
@@ -806,10 +1034,20 @@ QuicLookupRemoveLocalCid(
     _In_ QUIC_CID_HASH_ENTRY* SourceCid
     )
 {
-    QuicDispatchRwLockAcquireExclusive(&Lookup->RwLock);
+    //
+    // Once the partitioned tables are final, removal only touches the CID's
+    // own partition, so the lookup-wide lock (which would stall receive for
+    // every partition) isn't needed.
+    //
+    const BOOLEAN PartitioningFinal = Lookup->PartitioningFinal;
+    if (!PartitioningFinal) {
+        QuicDispatchRwLockAcquireExclusive(&Lookup->RwLock);
+    }
     QuicLookupRemoveLocalCidInt(Lookup, SourceCid);
     SourceCid->CID.IsInLookupTable = FALSE;
-    QuicDispatchRwLockReleaseExclusive(&Lookup->RwLock);
+    if (!PartitioningFinal) {
+        QuicDispatchRwLockReleaseExclusive(&Lookup->RwLock);
+    }
     QuicConnRelease(SourceCid->Connection, QUIC_CONN_REF_LOOKUP_TABLE);
 }
 
@@ -849,7 +1087,15 @@ QuicLookupRemoveLocalCids(
 {
     uint8_t ReleaseRefCount = 0;
 
-    QuicDispatchRwLockAcquireExclusive(&Lookup->RwLock);
+    //
+    // Once the partitioned tables are final, each CID removal only touches
+    // that CID's partition, so batched teardown doesn't stall receive on
+    // every partition behind the lookup-wide lock.
+    //
+    const BOOLEAN PartitioningFinal = Lookup->PartitioningFinal;
+    if (!PartitioningFinal) {
+        QuicDispatchRwLockAcquireExclusive(&Lookup->RwLock);
+    }
     while (Connection->SourceCids.Next != NULL) {
         QUIC_CID_HASH_ENTRY *CID =
             QUIC_CONTAINING_RECORD(
@@ -861,9 +1107,11 @@ QuicLookupRemoveLocalCids(
             CID->CID.IsInLookupTable = FALSE;
             ReleaseRefCount++;
         }
-        QUIC_FREE(CID);
+        QuicCidFreeSource(CID);
+    }
+    if (!PartitioningFinal) {
+        QuicDispatchRwLockReleaseExclusive(&Lookup->RwLock);
     }
-    QuicDispatchRwLockReleaseExclusive(&Lookup->RwLock);
 
     for (uint8_t i = 0; i < ReleaseRefCount; i++) {
 #pragma prefast(suppress:6001, "SAL doesn't understand ref counts")
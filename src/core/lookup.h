@@ -29,9 +29,17 @@ typedef struct QUIC_LOOKUP {
     BOOLEAN MaximizePartitioning;
 
     //
-    // Number of connection IDs in the lookup.
+    // Indicates the partitioned tables have reached their final form and
+    // will never be replaced again. Once set, the local CID lookup only
+    // needs the individual partition's lock, not the lookup-wide RwLock.
     //
-    uint32_t CidCount;
+    BOOLEAN PartitioningFinal;
+
+    //
+    // Number of connection IDs in the lookup. Updated with interlocked
+    // operations because the removal fast path doesn't hold the RwLock.
+    //
+    long CidCount;
 
     //
     // Lock for accessing the lookup data.
@@ -144,6 +152,20 @@ QuicLookupAddLocalCid(
     _Out_opt_ QUIC_CONNECTION** Collision
     );
 
+//
+// Attempts to insert a batch of local CIDs into the lookup, under a single
+// write lock acquisition. Entries that collide (or fail to insert) are left
+// with IsInLookupTable FALSE for the caller to clean up and retry
+// individually. Returns the number of CIDs inserted.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint8_t
+QuicLookupAddLocalCids(
+    _In_ QUIC_LOOKUP* Lookup,
+    _In_reads_(Count) QUIC_CID_HASH_ENTRY** SourceCids,
+    _In_ uint8_t Count
+    );
+
 //
 // Attempts to insert the remote hash into the lookup.
 //
@@ -60,6 +60,59 @@ QuicLossDetectionInitializeInternalState(
 {
     LossDetection->PacketsInFlight = 0;
     LossDetection->ProbeCount = 0;
+    LossDetection->PacketReorderThreshold = QUIC_PACKET_REORDER_THRESHOLD;
+    LossDetection->DeliveredBytes = 0;
+    LossDetection->DeliveredTime = 0;
+    LossDetection->AppLimitedDelivered = 0;
+    LossDetection->DeliveryRate = 0;
+    LossDetection->DeliveryRateTime = 0;
+    LossDetection->DeliveryRateAppLimited = FALSE;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionSetAppLimited(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    )
+{
+    QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
+
+    //
+    // Samples stay untrusted until everything currently in the network has
+    // been delivered; nonzero doubles as the "app limited" indicator.
+    //
+    LossDetection->AppLimitedDelivered =
+        LossDetection->DeliveredBytes +
+        Connection->CongestionControl.BytesInFlight;
+    if (LossDetection->AppLimitedDelivered == 0) {
+        LossDetection->AppLimitedDelivered = 1;
+    }
+}
+
+//
+// Grows the packet reorder threshold to cover an observed reordering
+// distance, so the same reordering doesn't trigger (spurious) packet based
+// loss detection again.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionUpdateReorderThreshold(
+    _In_ QUIC_LOSS_DETECTION* LossDetection,
+    _In_ uint64_t ReorderDistance
+    )
+{
+    if (ReorderDistance > QUIC_PACKET_REORDER_THRESHOLD_MAX) {
+        ReorderDistance = QUIC_PACKET_REORDER_THRESHOLD_MAX;
+    }
+    if (ReorderDistance > LossDetection->PacketReorderThreshold) {
+        QuicTraceLogConnInfoClass(
+            QUIC_TRACE_CLASS_LOSS,
+            ReorderThresholdUpdated,
+            QuicLossDetectionGetConnection(LossDetection),
+            "Packet reorder threshold updated to %llu",
+            ReorderDistance);
+        LossDetection->PacketReorderThreshold = ReorderDistance;
+    }
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -69,12 +122,84 @@ QuicLossDetectionInitialize(
     )
 {
     LossDetection->SentPackets = NULL;
-    LossDetection->SentPacketsTail = &LossDetection->SentPackets;
+    LossDetection->SentPacketsCount = 0;
+    LossDetection->SentPacketsSize = 0;
+    LossDetection->LowestTrackedPacketNumber = 0;
     LossDetection->LostPackets = NULL;
     LossDetection->LostPacketsTail = &LossDetection->LostPackets;
+    LossDetection->UpdateTimerPending = FALSE;
+    LossDetection->DeferredFreePackets = NULL;
     QuicLossDetectionInitializeInternalState(LossDetection);
 }
 
+//
+// Queues the packet metadata to be returned to the worker's pool at the end
+// of the current operation drain. Used on the ACK processing paths so the
+// frees (and the stream releases they trigger) don't interleave their cache
+// traffic with the parsing loops.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionDeferPacketFree(
+    _In_ QUIC_LOSS_DETECTION* LossDetection,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    )
+{
+    Packet->Next = LossDetection->DeferredFreePackets;
+    LossDetection->DeferredFreePackets = Packet;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionProcessDeferredFrees(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    )
+{
+    QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
+    while (LossDetection->DeferredFreePackets != NULL) {
+        QUIC_SENT_PACKET_METADATA* Packet = LossDetection->DeferredFreePackets;
+        LossDetection->DeferredFreePackets = Packet->Next;
+        QuicSentPacketPoolReturnPacketMetadata(
+            &Connection->Worker->SentPacketPool, Packet);
+    }
+}
+
+//
+// Removes the packet from the outstanding-packet ring. The caller owns the
+// packet metadata afterwards.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionUntrackPacket(
+    _In_ QUIC_LOSS_DETECTION* LossDetection,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    )
+{
+    uint32_t Slot =
+        (uint32_t)(Packet->PacketNumber & (LossDetection->SentPacketsSize - 1));
+    QUIC_DBG_ASSERT(LossDetection->SentPackets[Slot] == Packet);
+    LossDetection->SentPackets[Slot] = NULL;
+    LossDetection->SentPacketsCount--;
+}
+
+//
+// Advances the bottom of the tracked packet number window past any slots
+// freed by removals, so the window stays as small as possible.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionTrimTrackedWindow(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    )
+{
+    while (LossDetection->SentPacketsCount != 0 &&
+        LossDetection->SentPackets[
+            LossDetection->LowestTrackedPacketNumber &
+            (LossDetection->SentPacketsSize - 1)] == NULL) {
+        LossDetection->LowestTrackedPacketNumber++;
+    }
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicLossDetectionUninitialize(
@@ -83,9 +208,23 @@ QuicLossDetectionUninitialize(
 {
     QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
 
-    while (LossDetection->SentPackets != NULL) {
-        QUIC_SENT_PACKET_METADATA* Packet = LossDetection->SentPackets;
-        LossDetection->SentPackets = LossDetection->SentPackets->Next;
+    QuicLossDetectionProcessDeferredFrees(LossDetection);
+
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        QUIC_SENT_PACKET_METADATA* Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet == NULL) {
+            continue;
+        }
+        QuicLossDetectionUntrackPacket(LossDetection, Packet);
+
+        if (Packet->CachedPayload != NULL) {
+            QuicSendReleaseCachedPayload(&Connection->Send, Packet);
+        }
 
         if (Packet->Flags.IsRetransmittable) {
             QuicTraceLogVerbose(
@@ -98,6 +237,11 @@ QuicLossDetectionUninitialize(
 
         QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
     }
+    if (LossDetection->SentPackets != NULL) {
+        QUIC_FREE(LossDetection->SentPackets);
+        LossDetection->SentPackets = NULL;
+        LossDetection->SentPacketsSize = 0;
+    }
     while (LossDetection->LostPackets != NULL) {
         QUIC_SENT_PACKET_METADATA* Packet = LossDetection->LostPackets;
         LossDetection->LostPackets = LossDetection->LostPackets->Next;
@@ -131,13 +275,20 @@ QuicLossDetectionReset(
     // Throw away any outstanding packets.
     //
 
-    while (LossDetection->SentPackets != NULL) {
-        QUIC_SENT_PACKET_METADATA* Packet = LossDetection->SentPackets;
-        LossDetection->SentPackets = LossDetection->SentPackets->Next;
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        QUIC_SENT_PACKET_METADATA* Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet == NULL) {
+            continue;
+        }
+        QuicLossDetectionUntrackPacket(LossDetection, Packet);
         QuicLossDetectionRetransmitFrames(LossDetection, Packet);
         QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
     }
-    LossDetection->SentPacketsTail = &LossDetection->SentPackets;
 
     while (LossDetection->LostPackets != NULL) {
         QUIC_SENT_PACKET_METADATA* Packet = LossDetection->LostPackets;
@@ -159,11 +310,18 @@ QuicLossDetectionOldestOutstandingPacket(
     _In_ QUIC_LOSS_DETECTION* LossDetection
     )
 {
-    QUIC_SENT_PACKET_METADATA* Packet = LossDetection->SentPackets;
-    while (Packet != NULL && !Packet->Flags.IsRetransmittable) {
-        Packet = Packet->Next;
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        QUIC_SENT_PACKET_METADATA* Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet != NULL && Packet->Flags.IsRetransmittable) {
+            return Packet;
+        }
     }
-    return Packet;
+    return NULL;
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -199,8 +357,9 @@ typedef enum QUIC_LOSS_TIMER_TYPE {
 } QUIC_LOSS_TIMER_TYPE;
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
+static
 void
-QuicLossDetectionUpdateTimer(
+QuicLossDetectionUpdateTimerInternal(
     _In_ QUIC_LOSS_DETECTION* LossDetection
     )
 {
@@ -341,6 +500,107 @@ QuicLossDetectionUpdateTimer(
     QuicConnTimerSet(Connection, QUIC_CONN_TIMER_LOSS_DETECTION, Delay);
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionUpdateTimer(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    )
+{
+    QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
+
+    if (Connection->OperQ.ActivelyProcessing) {
+        //
+        // The worker is in the middle of draining the operation queue, which
+        // can request timer updates many times (once per ACK frame, send
+        // flush, etc.). Instead of recomputing the deadlines and touching the
+        // timer wheel every time, coalesce them all into a single update at
+        // the end of the drain.
+        //
+        LossDetection->UpdateTimerPending = TRUE;
+        return;
+    }
+
+    QuicLossDetectionUpdateTimerInternal(LossDetection);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionProcessDeferredTimerUpdate(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    )
+{
+    if (LossDetection->UpdateTimerPending) {
+        LossDetection->UpdateTimerPending = FALSE;
+        QuicLossDetectionUpdateTimerInternal(LossDetection);
+    }
+}
+
+//
+// Makes sure the outstanding-packet ring has a usable slot for the given
+// (newly sent, largest so far) packet number, growing the ring if the tracked
+// window has outgrown it.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicLossDetectionEnsureSentPacketSlot(
+    _In_ QUIC_LOSS_DETECTION* LossDetection,
+    _In_ uint64_t PacketNumber
+    )
+{
+    if (LossDetection->SentPacketsCount == 0) {
+        LossDetection->LowestTrackedPacketNumber = PacketNumber;
+    }
+
+    if (LossDetection->SentPackets != NULL &&
+        PacketNumber - LossDetection->LowestTrackedPacketNumber <
+            LossDetection->SentPacketsSize) {
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    uint32_t NewSize =
+        LossDetection->SentPacketsSize == 0 ?
+            QUIC_INITIAL_SENT_PACKETS_SIZE : LossDetection->SentPacketsSize;
+    while (NewSize != 0 &&
+        PacketNumber - LossDetection->LowestTrackedPacketNumber >= NewSize) {
+        NewSize <<= 1;
+    }
+    if (NewSize == 0) {
+        return QUIC_STATUS_OUT_OF_MEMORY; // Window grew past 2^31 packets.
+    }
+
+    QUIC_SENT_PACKET_METADATA** NewSentPackets =
+        QUIC_ALLOC_NONPAGED(NewSize * sizeof(QUIC_SENT_PACKET_METADATA*));
+    if (NewSentPackets == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "sent packet ring",
+            NewSize * sizeof(QUIC_SENT_PACKET_METADATA*));
+        return QUIC_STATUS_OUT_OF_MEMORY;
+    }
+    QuicZeroMemory(NewSentPackets, NewSize * sizeof(QUIC_SENT_PACKET_METADATA*));
+
+    for (uint64_t Number = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            Number <= LossDetection->LargestSentPacketNumber;
+         Number++) {
+        QUIC_SENT_PACKET_METADATA* Packet =
+            LossDetection->SentPackets[
+                Number & (LossDetection->SentPacketsSize - 1)];
+        if (Packet != NULL) {
+            NewSentPackets[Number & (NewSize - 1)] = Packet;
+        }
+    }
+
+    if (LossDetection->SentPackets != NULL) {
+        QUIC_FREE(LossDetection->SentPackets);
+    }
+    LossDetection->SentPackets = NewSentPackets;
+    LossDetection->SentPacketsSize = NewSize;
+
+    return QUIC_STATUS_SUCCESS;
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicLossDetectionOnPacketSent(
@@ -369,14 +629,49 @@ QuicLossDetectionOnPacketSent(
         sizeof(QUIC_SENT_PACKET_METADATA) +
         sizeof(QUIC_SENT_FRAME_METADATA) * TempSentPacket->FrameCount);
 
-    LossDetection->LargestSentPacketNumber = TempSentPacket->PacketNumber;
+    //
+    // Ownership of any cached payload copy moves to the tracked metadata.
+    //
+    TempSentPacket->CachedPayload = NULL;
+    TempSentPacket->CachedPayloadLength = 0;
+
+    //
+    // Capture the delivery totals for rate sampling. After an idle period
+    // the delivery clock restarts at this send, so the idle gap doesn't
+    // dilute the packet's eventual sample.
+    //
+    if (LossDetection->PacketsInFlight == 0) {
+        LossDetection->DeliveredTime = SentPacket->SentTime;
+    }
+    SentPacket->Delivered = LossDetection->DeliveredBytes;
+    SentPacket->DeliveredTime = LossDetection->DeliveredTime;
+    SentPacket->Flags.IsAppLimited = LossDetection->AppLimitedDelivered != 0;
+
+    QUIC_DBG_ASSERT(
+        LossDetection->SentPacketsCount == 0 ||
+        LossDetection->LargestSentPacketNumber < TempSentPacket->PacketNumber);
 
     //
-    // Add to the outstanding-packet queue.
+    // Add to the outstanding-packet ring.
     //
+    QUIC_STATUS Status =
+        QuicLossDetectionEnsureSentPacketSlot(
+            LossDetection, TempSentPacket->PacketNumber);
+    if (QUIC_FAILED(Status)) {
+        if (SentPacket->CachedPayload != NULL) {
+            QuicSendReleaseCachedPayload(&Connection->Send, SentPacket);
+        }
+        QuicSentPacketPoolReturnPacketMetadata(
+            &Connection->Worker->SentPacketPool, SentPacket);
+        return Status;
+    }
+
+    LossDetection->LargestSentPacketNumber = TempSentPacket->PacketNumber;
     SentPacket->Next = NULL;
-    *LossDetection->SentPacketsTail = SentPacket;
-    LossDetection->SentPacketsTail = &SentPacket->Next;
+    LossDetection->SentPackets[
+        SentPacket->PacketNumber & (LossDetection->SentPacketsSize - 1)] =
+            SentPacket;
+    LossDetection->SentPacketsCount++;
 
     QUIC_DBG_ASSERT(
         SentPacket->Flags.KeyType != QUIC_PACKET_KEY_0_RTT ||
@@ -417,14 +712,27 @@ QuicLossDetectionOnPacketAcknowledged(
     QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
     QUIC_PATH* Path = QuicConnGetPathByID(Connection, Packet->PathId);
 
+    LossDetection->DeliveredBytes += Packet->PacketLength;
+
+    if (Packet->CachedPayload != NULL) {
+        QuicSendReleaseCachedPayload(&Connection->Send, Packet);
+    }
+
     _Analysis_assume_(
         EncryptLevel >= QUIC_ENCRYPT_LEVEL_INITIAL &&
         EncryptLevel < QUIC_ENCRYPT_LEVEL_COUNT);
 
+    QuicPerfEventRingWrite(
+        &Connection->Worker->PerfEvents,
+        QUIC_PERF_EVENT_PACKET_ACKED,
+        (uint64_t)(uintptr_t)Connection,
+        Packet->PacketNumber);
+
     if (!QuicConnIsServer(Connection) &&
         !Connection->State.HandshakeConfirmed &&
         Packet->Flags.KeyType == QUIC_PACKET_KEY_1_RTT) {
-        QuicTraceLogConnInfo(
+        QuicTraceLogConnInfoClass(
+            QUIC_TRACE_CLASS_LOSS,
             HandshakeConfirmedAck,
             Connection,
             "Handshake confirmed (ack)");
@@ -436,11 +744,20 @@ QuicLossDetectionOnPacketAcknowledged(
         PacketSpace->AwaitingKeyPhaseConfirmation &&
         Packet->Flags.KeyPhase == PacketSpace->CurrentKeyPhase &&
         Packet->PacketNumber >= PacketSpace->WriteKeyPhaseStartPacketNumber) {
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_LOSS,
             KeyChangeConfirmed,
             Connection,
             "Key change confirmed by peer");
         PacketSpace->AwaitingKeyPhaseConfirmation = FALSE;
+
+        //
+        // With the phase confirmed, pre-derive the next generation of keys
+        // here on the ACK path so the next update finds them ready instead
+        // of running the key schedule inline on the packet path. Failure is
+        // benign; the update sites derive on demand.
+        //
+        (void)QuicCryptoGenerateNewKeys(Connection);
     }
 
     for (uint8_t i = 0; i < Packet->FrameCount; i++) {
@@ -488,7 +805,8 @@ QuicLossDetectionOnPacketAcknowledged(
                 QuicSendSetStreamSendFlag(
                     &Connection->Send,
                     Packet->Frames[i].STREAM_DATA_BLOCKED.Stream,
-                    QUIC_STREAM_SEND_FLAG_DATA_BLOCKED);
+                    QUIC_STREAM_SEND_FLAG_DATA_BLOCKED,
+                    FALSE);
             }
             break;
 
@@ -517,11 +835,19 @@ QuicLossDetectionOnPacketAcknowledged(
             }
             break;
         }
+
+        case QUIC_FRAME_DATAGRAM:
+        case QUIC_FRAME_DATAGRAM_1:
+            QuicDatagramIndicateSendStateChange(
+                Connection,
+                &Packet->Frames[i].DATAGRAM.ClientContext,
+                QUIC_DATAGRAM_SEND_ACKNOWLEDGED);
+            break;
         }
     }
 
     if (Path != NULL && Packet->Flags.IsPMTUD) {
-        QuicSendOnMtuProbePacketAcked(&Connection->Send, Path, Packet);
+        QuicPathMtuDiscoveryProbeAcked(Connection, Path, Packet);
     }
 }
 
@@ -539,6 +865,19 @@ QuicLossDetectionRetransmitFrames(
     QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
     BOOLEAN NewDataQueued = FALSE;
 
+    if (Packet->CachedPayload != NULL) {
+        //
+        // The plaintext payload of this packet was cached at send time, so
+        // queue it for a byte-identical retransmission (new packet number,
+        // re-encrypt) instead of re-framing the data below. If the clone
+        // can't be allocated, release the copy and take the normal path.
+        //
+        if (QuicSendQueueRetransmitPacket(&Connection->Send, Packet)) {
+            return TRUE;
+        }
+        QuicSendReleaseCachedPayload(&Connection->Send, Packet);
+    }
+
     for (uint8_t i = 0; i < Packet->FrameCount; i++) {
         switch (Packet->Frames[i].Type) {
         case QUIC_FRAME_PING:
@@ -555,7 +894,8 @@ QuicLossDetectionRetransmitFrames(
                 QuicSendSetStreamSendFlag(
                     &Connection->Send,
                     Packet->Frames[i].RESET_STREAM.Stream,
-                    QUIC_STREAM_SEND_FLAG_SEND_ABORT);
+                    QUIC_STREAM_SEND_FLAG_SEND_ABORT,
+                    FALSE);
             break;
 
         case QUIC_FRAME_STOP_SENDING:
@@ -563,7 +903,8 @@ QuicLossDetectionRetransmitFrames(
                 QuicSendSetStreamSendFlag(
                     &Connection->Send,
                     Packet->Frames[i].STOP_SENDING.Stream,
-                    QUIC_STREAM_SEND_FLAG_RECV_ABORT);
+                    QUIC_STREAM_SEND_FLAG_RECV_ABORT,
+                    FALSE);
             break;
 
         case QUIC_FRAME_CRYPTO:
@@ -599,7 +940,8 @@ QuicLossDetectionRetransmitFrames(
                 QuicSendSetStreamSendFlag(
                     &Connection->Send,
                     Packet->Frames[i].MAX_STREAM_DATA.Stream,
-                    QUIC_STREAM_SEND_FLAG_MAX_DATA);
+                    QUIC_STREAM_SEND_FLAG_MAX_DATA,
+                    FALSE);
             break;
 
         case QUIC_FRAME_MAX_STREAMS:
@@ -621,7 +963,8 @@ QuicLossDetectionRetransmitFrames(
                 QuicSendSetStreamSendFlag(
                     &Connection->Send,
                     Packet->Frames[i].STREAM_DATA_BLOCKED.Stream,
-                    QUIC_STREAM_SEND_FLAG_DATA_BLOCKED);
+                    QUIC_STREAM_SEND_FLAG_DATA_BLOCKED,
+                    FALSE);
             break;
 
         case QUIC_FRAME_NEW_CONNECTION_ID: {
@@ -678,6 +1021,32 @@ QuicLossDetectionRetransmitFrames(
                     &Connection->Send,
                     QUIC_CONN_SEND_FLAG_HANDSHAKE_DONE);
             break;
+
+        case QUIC_FRAME_ACK_FREQUENCY:
+            //
+            // Only retransmit if this frame is still the most recent update.
+            // A newer update already queued (or sent) supersedes this one.
+            //
+            if (Packet->Frames[i].ACK_FREQUENCY.Sequence ==
+                    Connection->SendAckFreqSeqNum) {
+                NewDataQueued |=
+                    QuicSendSetSendFlag(
+                        &Connection->Send,
+                        QUIC_CONN_SEND_FLAG_ACK_FREQUENCY);
+            }
+            break;
+
+        case QUIC_FRAME_DATAGRAM:
+        case QUIC_FRAME_DATAGRAM_1:
+            //
+            // Datagrams are never retransmitted. Just tell the app the send
+            // was lost.
+            //
+            QuicDatagramIndicateSendStateChange(
+                Connection,
+                &Packet->Frames[i].DATAGRAM.ClientContext,
+                QUIC_DATAGRAM_SEND_LOST_DISCARDED);
+            break;
         }
     }
 
@@ -717,14 +1086,14 @@ QuicLossDetectionDetectAndHandleLostPackets(
                 PtkConnPre(Connection),
                 Packet->PacketNumber);
             LossDetection->LostPackets = Packet->Next;
-            QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
+            QuicLossDetectionDeferPacketFree(LossDetection, Packet);
         }
         if (LossDetection->LostPackets == NULL) {
             LossDetection->LostPacketsTail = &LossDetection->LostPackets;
         }
     }
 
-    if (LossDetection->SentPackets != NULL) {
+    if (LossDetection->SentPacketsCount != 0) {
         //
         // Remove "suspect" packets inferred lost from out-of-order ACKs.
         // The spec has:
@@ -737,9 +1106,16 @@ QuicLossDetectionDetectAndHandleLostPackets(
         uint32_t Rtt = max(Path->SmoothedRtt, Path->LatestRttSample);
         uint32_t TimeReorderThreshold = QUIC_TIME_REORDER_THRESHOLD(Rtt);
         uint64_t LargestLostPacketNumber = 0;
-        QUIC_SENT_PACKET_METADATA* PrevPacket = NULL;
-        Packet = LossDetection->SentPackets;
-        while (Packet != NULL) {
+        for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+             LossDetection->SentPacketsCount != 0 &&
+                PacketNumber <= LossDetection->LargestSentPacketNumber;
+             PacketNumber++) {
+            Packet =
+                LossDetection->SentPackets[
+                    PacketNumber & (LossDetection->SentPacketsSize - 1)];
+            if (Packet == NULL) {
+                continue;
+            }
 
             BOOLEAN NonretransmittableHandshakePacket =
                 !Packet->Flags.IsRetransmittable &&
@@ -748,10 +1124,8 @@ QuicLossDetectionDetectAndHandleLostPackets(
                 QuicKeyTypeToEncryptLevel(Packet->Flags.KeyType);
 
             if (EncryptLevel > LossDetection->LargestAckEncryptLevel) {
-                PrevPacket = Packet;
-                Packet = Packet->Next;
                 continue;
-            } else if (Packet->PacketNumber + QUIC_PACKET_REORDER_THRESHOLD < LossDetection->LargestAck) {
+            } else if (Packet->PacketNumber + LossDetection->PacketReorderThreshold < LossDetection->LargestAck) {
                 if (!NonretransmittableHandshakePacket) {
                     QuicTraceLogVerbose(
                         PacketTxLostFack,
@@ -789,26 +1163,51 @@ QuicLossDetectionDetectAndHandleLostPackets(
             }
 
             Connection->Stats.Send.SuspectedLostPackets++;
+            QuicPerfCounterIncrement(QUIC_PERF_COUNTER_PKTS_SUSPECTED_LOST);
+            QuicPerfEventRingWrite(
+                &Connection->Worker->PerfEvents,
+                QUIC_PERF_EVENT_PACKET_LOST,
+                (uint64_t)(uintptr_t)Connection,
+                Packet->PacketNumber);
             if (Packet->Flags.IsRetransmittable) {
                 --LossDetection->PacketsInFlight;
-                LostRetransmittableBytes += Packet->PacketLength;
-                QuicLossDetectionRetransmitFrames(LossDetection, Packet);
+                if (Packet->Flags.IsPMTUD) {
+                    //
+                    // A lost MTU probe says nothing about congestion on the
+                    // path, just (most likely) that the probed size doesn't
+                    // fit through it. Remove its bytes from flight without
+                    // triggering a congestion event and let the search
+                    // continue.
+                    //
+                    if (QuicCongestionControlOnDataInvalidated(
+                            &Connection->CongestionControl,
+                            Packet->PacketLength)) {
+                        //
+                        // We were previously blocked and are now unblocked.
+                        //
+                        QuicSendQueueFlush(
+                            &Connection->Send, REASON_CONGESTION_CONTROL);
+                    }
+                    QUIC_PATH* ProbePath =
+                        QuicConnGetPathByID(Connection, Packet->PathId);
+                    if (ProbePath != NULL) {
+                        QuicPathMtuDiscoveryProbeLost(Connection, ProbePath);
+                    }
+                } else {
+                    LostRetransmittableBytes += Packet->PacketLength;
+                    QuicLossDetectionRetransmitFrames(LossDetection, Packet);
+                }
             }
 
             LargestLostPacketNumber = Packet->PacketNumber;
-            if (PrevPacket == NULL) {
-                LossDetection->SentPackets = Packet->Next;
-            } else {
-                PrevPacket->Next = Packet->Next;
-            }
+            QuicLossDetectionUntrackPacket(LossDetection, Packet);
 
             *LossDetection->LostPacketsTail = Packet;
             LossDetection->LostPacketsTail = &Packet->Next;
-            Packet = Packet->Next;
-            *LossDetection->LostPacketsTail = NULL;
+            Packet->Next = NULL;
         }
-        if (LossDetection->SentPackets == NULL) {
-            LossDetection->SentPacketsTail = &LossDetection->SentPackets;
+        QuicLossDetectionTrimTrackedWindow(LossDetection);
+        if (LossDetection->SentPacketsCount == 0) {
             QUIC_DBG_ASSERT(LossDetection->PacketsInFlight == 0);
         }
 
@@ -826,7 +1225,6 @@ QuicLossDetectionDetectAndHandleLostPackets(
         }
     }
 
-    QUIC_DBG_ASSERT(LossDetection->SentPackets != NULL || LossDetection->SentPacketsTail == &LossDetection->SentPackets);
     QUIC_DBG_ASSERT(LossDetection->LostPackets != NULL || LossDetection->LostPacketsTail == &LossDetection->LostPackets);
 
     return LostRetransmittableBytes > 0;
@@ -882,7 +1280,7 @@ QuicLossDetectionDiscardPackets(
                 Packet->PacketNumber,
                 QuicPacketTraceType(Packet));
             QuicLossDetectionOnPacketAcknowledged(LossDetection, EncryptLevel, Packet);
-            QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
+            QuicLossDetectionDeferPacketFree(LossDetection, Packet);
 
             Packet = NextPacket;
 
@@ -892,51 +1290,39 @@ QuicLossDetectionDiscardPackets(
         }
     }
 
-    PrevPacket = NULL;
-    Packet = LossDetection->SentPackets;
-    while (Packet != NULL) {
-        QUIC_SENT_PACKET_METADATA* NextPacket = Packet->Next;
-
-        if (Packet->Flags.KeyType == KeyType) {
-            if (PrevPacket != NULL) {
-                PrevPacket->Next = NextPacket;
-                if (NextPacket == NULL) {
-                    LossDetection->SentPacketsTail = &PrevPacket->Next;
-                }
-            } else {
-                LossDetection->SentPackets = NextPacket;
-                if (NextPacket == NULL) {
-                    LossDetection->SentPacketsTail = &LossDetection->SentPackets;
-                }
-            }
-
-            QuicTraceLogVerbose(
-                PacketTxAckedImplicit,
-                "[%c][TX][%llu] ACKed (implicit)",
-                PtkConnPre(Connection),
-                Packet->PacketNumber);
-            QuicTraceEvent(
-                ConnPacketACKed,
-                "[conn][%p][TX][%llu] %hhu ACKed",
-                Connection,
-                Packet->PacketNumber,
-                QuicPacketTraceType(Packet));
-
-            if (Packet->Flags.IsRetransmittable) {
-                LossDetection->PacketsInFlight--;
-                AckedRetransmittableBytes += Packet->PacketLength;
-            }
-
-            QuicLossDetectionOnPacketAcknowledged(LossDetection, EncryptLevel, Packet);
-            QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet == NULL || Packet->Flags.KeyType != KeyType) {
+            continue;
+        }
+        QuicLossDetectionUntrackPacket(LossDetection, Packet);
 
-            Packet = NextPacket;
+        QuicTraceLogVerbose(
+            PacketTxAckedImplicit,
+            "[%c][TX][%llu] ACKed (implicit)",
+            PtkConnPre(Connection),
+            Packet->PacketNumber);
+        QuicTraceEvent(
+            ConnPacketACKed,
+            "[conn][%p][TX][%llu] %hhu ACKed",
+            Connection,
+            Packet->PacketNumber,
+            QuicPacketTraceType(Packet));
 
-        } else {
-            PrevPacket = Packet;
-            Packet = NextPacket;
+        if (Packet->Flags.IsRetransmittable) {
+            LossDetection->PacketsInFlight--;
+            AckedRetransmittableBytes += Packet->PacketLength;
         }
+
+        QuicLossDetectionOnPacketAcknowledged(LossDetection, EncryptLevel, Packet);
+        QuicLossDetectionDeferPacketFree(LossDetection, Packet);
     }
+    QuicLossDetectionTrimTrackedWindow(LossDetection);
 
     if (AckedRetransmittableBytes > 0) {
         const QUIC_PATH* Path = &Connection->Paths[0]; // TODO - Correct?
@@ -961,7 +1347,6 @@ QuicLossDetectionOnZeroRttRejected(
     )
 {
     QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
-    QUIC_SENT_PACKET_METADATA* PrevPacket;
     QUIC_SENT_PACKET_METADATA* Packet;
     uint32_t CountRetransmittableBytes = 0;
 
@@ -969,45 +1354,33 @@ QuicLossDetectionOnZeroRttRejected(
     // Marks all the packets as lost so they can be retransmitted immediately.
     //
 
-    PrevPacket = NULL;
-    Packet = LossDetection->SentPackets;
-    while (Packet != NULL) {
-        QUIC_SENT_PACKET_METADATA* NextPacket = Packet->Next;
-
-        if (Packet->Flags.KeyType == QUIC_PACKET_KEY_0_RTT) {
-            if (PrevPacket != NULL) {
-                PrevPacket->Next = NextPacket;
-                if (NextPacket == NULL) {
-                    LossDetection->SentPacketsTail = &PrevPacket->Next;
-                }
-            } else {
-                LossDetection->SentPackets = NextPacket;
-                if (NextPacket == NULL) {
-                    LossDetection->SentPacketsTail = &LossDetection->SentPackets;
-                }
-            }
-
-            QuicTraceLogVerbose(
-                PacketTx0RttRejected,
-                "[%c][TX][%llu] Rejected",
-                PtkConnPre(Connection),
-                Packet->PacketNumber);
-
-            QUIC_DBG_ASSERT(Packet->Flags.IsRetransmittable);
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet == NULL || Packet->Flags.KeyType != QUIC_PACKET_KEY_0_RTT) {
+            continue;
+        }
+        QuicLossDetectionUntrackPacket(LossDetection, Packet);
 
-            LossDetection->PacketsInFlight--;
-            CountRetransmittableBytes += Packet->PacketLength;
+        QuicTraceLogVerbose(
+            PacketTx0RttRejected,
+            "[%c][TX][%llu] Rejected",
+            PtkConnPre(Connection),
+            Packet->PacketNumber);
 
-            QuicLossDetectionRetransmitFrames(LossDetection, Packet);
-            QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
+        QUIC_DBG_ASSERT(Packet->Flags.IsRetransmittable);
 
-            Packet = NextPacket;
+        LossDetection->PacketsInFlight--;
+        CountRetransmittableBytes += Packet->PacketLength;
 
-        } else {
-            PrevPacket = Packet;
-            Packet = NextPacket;
-        }
+        QuicLossDetectionRetransmitFrames(LossDetection, Packet);
+        QuicLossDetectionDeferPacketFree(LossDetection, Packet);
     }
+    QuicLossDetectionTrimTrackedWindow(LossDetection);
 
     if (CountRetransmittableBytes > 0) {
         if (QuicCongestionControlOnDataInvalidated(
@@ -1028,7 +1401,11 @@ QuicLossDetectionProcessAckBlocks(
     _In_ QUIC_PATH* Path,
     _In_ QUIC_ENCRYPT_LEVEL EncryptLevel,
     _In_ uint64_t AckDelay,
-    _In_ QUIC_RANGE* AckBlocks,
+    _In_ uint64_t RecvTimeUs,
+    _In_reads_(AckBlockCount)
+        QUIC_SUBRANGE* AckBlocks, // Sorted smallest to largest
+    _In_ uint32_t AckBlockCount,
+    _In_opt_ const QUIC_ACK_ECN_EX* Ecn,
     _Out_ BOOLEAN* InvalidAckBlock
     )
 {
@@ -1037,22 +1414,32 @@ QuicLossDetectionProcessAckBlocks(
 
     uint32_t PacketsInFlight = 0;
     uint32_t AckedRetransmittableBytes = 0;
+    uint64_t EcnEctCounter = 0;
     QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
-    uint32_t TimeNow = QuicTimeUs32();
+    //
+    // Base "now" on the datapath's receive timestamp for the ACK when one is
+    // available, so RTT and delivery-rate samples don't include the wakeup
+    // and queue delay between the datagram arriving and the worker
+    // processing it.
+    //
+    uint32_t TimeNow =
+        RecvTimeUs != 0 ? (uint32_t)RecvTimeUs : QuicTimeUs32();
     uint32_t SmallestRtt = (uint32_t)(-1);
     BOOLEAN NewLargestAck = FALSE;
     BOOLEAN NewLargestAckRetransmittable = FALSE;
     BOOLEAN NewLargestAckDifferentPath = FALSE;
+    uint64_t SampleDelivered = 0;
+    uint32_t SampleDeliveredTime = 0;
+    BOOLEAN SampleAppLimited = FALSE;
+    BOOLEAN SampleValid = FALSE;
 
     *InvalidAckBlock = FALSE;
 
     QUIC_SENT_PACKET_METADATA** LostPacketsStart = &LossDetection->LostPackets;
-    QUIC_SENT_PACKET_METADATA** SentPacketsStart = &LossDetection->SentPackets;
     QUIC_SENT_PACKET_METADATA* LargestAckedPacket = NULL;
 
-    uint32_t i = 0;
-    QUIC_SUBRANGE* AckBlock;
-    while ((AckBlock = QuicRangeGetSafe(AckBlocks, i++)) != NULL) {
+    for (uint32_t i = 0; i < AckBlockCount; i++) {
+        QUIC_SUBRANGE* AckBlock = &AckBlocks[i];
 
         //
         // Check to see if any packets in the LostPackets list are acknowledged,
@@ -1071,6 +1458,16 @@ QuicLossDetectionProcessAckBlocks(
                     (*End)->PacketNumber);
                 Connection->Stats.Send.SpuriousLostPackets++;
                 //
+                // The packet was declared lost by the packet threshold but
+                // has now been acknowledged, so the path reorders at least
+                // this far. Grow the threshold to match.
+                //
+                if ((*End)->PacketNumber < LossDetection->LargestAck) {
+                    QuicLossDetectionUpdateReorderThreshold(
+                        LossDetection,
+                        LossDetection->LargestAck - (*End)->PacketNumber);
+                }
+                //
                 // NOTE: we don't increment AckedRetransmittableBytes here
                 // because we already told the congestion control module that
                 // this packet left the network.
@@ -1090,35 +1487,53 @@ QuicLossDetectionProcessAckBlocks(
         }
 
         //
-        // Now find all the acknowledged packets in the SentPackets list.
+        // Now find all the acknowledged packets in the outstanding-packet
+        // ring, directly by packet number.
         //
-        if (*SentPacketsStart != NULL) {
-            while (*SentPacketsStart && (*SentPacketsStart)->PacketNumber < AckBlock->Low) {
-                SentPacketsStart = &((*SentPacketsStart)->Next);
+        if (LossDetection->SentPacketsCount != 0) {
+            uint64_t Low = AckBlock->Low;
+            if (Low < LossDetection->LowestTrackedPacketNumber) {
+                Low = LossDetection->LowestTrackedPacketNumber;
             }
-            QUIC_SENT_PACKET_METADATA** End = SentPacketsStart;
-            while (*End && (*End)->PacketNumber <= QuicRangeGetHigh(AckBlock)) {
+            uint64_t High = QuicRangeGetHigh(AckBlock);
+            if (High > LossDetection->LargestSentPacketNumber) {
+                High = LossDetection->LargestSentPacketNumber;
+            }
+            for (uint64_t PacketNumber = Low; PacketNumber <= High; PacketNumber++) {
+                QUIC_SENT_PACKET_METADATA* Packet =
+                    LossDetection->SentPackets[
+                        PacketNumber & (LossDetection->SentPacketsSize - 1)];
+                if (Packet == NULL) {
+                    continue;
+                }
 
-                if ((*End)->Flags.IsRetransmittable) {
-                    PacketsInFlight++;
-                    AckedRetransmittableBytes += (*End)->PacketLength;
+                //
+                // A packet acknowledged for the first time below the largest
+                // previously acknowledged packet number was delivered (or
+                // acknowledged) out of order. Keep the reorder threshold
+                // above the distances the path actually produces, before
+                // they turn into spurious retransmits.
+                //
+                if (Packet->PacketNumber < LossDetection->LargestAck) {
+                    QuicLossDetectionUpdateReorderThreshold(
+                        LossDetection,
+                        LossDetection->LargestAck - Packet->PacketNumber);
                 }
-                LargestAckedPacket = *End;
-                End = &((*End)->Next);
-            }
 
-            if (SentPacketsStart != End) {
                 //
-                // Remove the ACKed packets from the outstanding packet list.
+                // Remove the ACKed packet from the outstanding packet ring.
                 //
-                *AckedPacketsTail = *SentPacketsStart;
-                AckedPacketsTail = End;
-                *SentPacketsStart = *End;
-                *End = NULL;
-                if (End == LossDetection->SentPacketsTail) {
-                    LossDetection->SentPacketsTail = SentPacketsStart;
+                QuicLossDetectionUntrackPacket(LossDetection, Packet);
+
+                if (Packet->Flags.IsRetransmittable) {
+                    PacketsInFlight++;
+                    AckedRetransmittableBytes += Packet->PacketLength;
                 }
-                QUIC_DBG_ASSERT(LossDetection->SentPackets != NULL || LossDetection->SentPacketsTail == &LossDetection->SentPackets);
+                LargestAckedPacket = Packet;
+
+                *AckedPacketsTail = Packet;
+                AckedPacketsTail = &Packet->Next;
+                Packet->Next = NULL;
             }
         }
 
@@ -1134,6 +1549,8 @@ QuicLossDetectionProcessAckBlocks(
         }
     }
 
+    QuicLossDetectionTrimTrackedWindow(LossDetection);
+
     if (AckedPackets == NULL) {
         //
         // Nothing was acknowledged, so we can exit now.
@@ -1175,13 +1592,53 @@ QuicLossDetectionProcessAckBlocks(
             QuicPacketTraceType(Packet));
 
         SmallestRtt = min(SmallestRtt, PacketRtt);
+        EcnEctCounter += Packet->Flags.EcnEctSet;
+
+        //
+        // The rate sample comes from the acknowledged packet that was sent
+        // with the most data already delivered (i.e. the newest).
+        //
+        if (!SampleValid || Packet->Delivered >= SampleDelivered) {
+            SampleValid = TRUE;
+            SampleDelivered = Packet->Delivered;
+            SampleDeliveredTime = Packet->DeliveredTime;
+            SampleAppLimited = Packet->Flags.IsAppLimited;
+        }
 
         QuicLossDetectionOnPacketAcknowledged(LossDetection, EncryptLevel, Packet);
-        QuicSentPacketPoolReturnPacketMetadata(&Connection->Worker->SentPacketPool, Packet);
+        QuicLossDetectionDeferPacketFree(LossDetection, Packet);
     }
 
     LossDetection->PacketsInFlight -= PacketsInFlight;
 
+    //
+    // Fold this ACK batch into the delivery-rate estimate: bytes delivered
+    // since the sample packet was sent, over the time that took. Larger
+    // samples always win; smaller ones replace the estimate only once it has
+    // aged out, and only if they weren't taken while app-limited.
+    //
+    LossDetection->DeliveredTime = TimeNow;
+    if (SampleValid) {
+        uint32_t SampleInterval = QuicTimeDiff32(SampleDeliveredTime, TimeNow);
+        if (SampleInterval != 0) {
+            uint64_t Rate =
+                (LossDetection->DeliveredBytes - SampleDelivered) * 1000000 /
+                SampleInterval;
+            if (Rate >= LossDetection->DeliveryRate ||
+                (!SampleAppLimited &&
+                 QuicTimeDiff32(LossDetection->DeliveryRateTime, TimeNow) >
+                    QUIC_DELIVERY_RATE_WINDOW_US)) {
+                LossDetection->DeliveryRate = Rate;
+                LossDetection->DeliveryRateTime = TimeNow;
+                LossDetection->DeliveryRateAppLimited = SampleAppLimited;
+            }
+        }
+        if (LossDetection->AppLimitedDelivered != 0 &&
+            LossDetection->DeliveredBytes > LossDetection->AppLimitedDelivered) {
+            LossDetection->AppLimitedDelivered = 0;
+        }
+    }
+
     if (NewLargestAckRetransmittable && !NewLargestAckDifferentPath) {
         //
         // Update the current RTT with the smallest RTT calculated, which
@@ -1206,6 +1663,39 @@ QuicLossDetectionProcessAckBlocks(
         QuicLossDetectionDetectAndHandleLostPackets(LossDetection, TimeNow);
     }
 
+    if (!Path->EcnFailed && EcnEctCounter != 0) {
+        //
+        // The peer acknowledged packets we sent with the ECT(0) codepoint, so
+        // validate its ECN feedback (RFC 9000 section 13.4.2) and respond to
+        // any newly reported CE marks as a congestion signal.
+        //
+        QUIC_PACKET_SPACE* Packets = Connection->Packets[EncryptLevel];
+        Packets->EcnEctCounter += EcnEctCounter;
+        if (Ecn == NULL ||
+            Ecn->ECT_1_Count != 0 ||
+            Ecn->ECT_0_Count + Ecn->CE_Count < Packets->EcnEctCounter) {
+            //
+            // The feedback is missing or inconsistent with what we sent. The
+            // path doesn't reliably carry the marks, so stop setting them.
+            //
+            QuicTraceLogConnInfoClass(
+                QUIC_TRACE_CLASS_LOSS,
+                EcnValidationFailed,
+                Connection,
+                "ECN validation failed, disabling ECN on path[%hhu]",
+                Path->ID);
+            Path->EcnFailed = TRUE;
+            QuicPathBumpVersion(Path);
+
+        } else if (Ecn->CE_Count > Packets->EcnCeCounter) {
+            Packets->EcnCeCounter = Ecn->CE_Count;
+            QuicCongestionControlOnEcnCongestionEvent(
+                &Connection->CongestionControl,
+                LossDetection->LargestAck,
+                LossDetection->LargestSentPacketNumber);
+        }
+    }
+
     if (NewLargestAck || AckedRetransmittableBytes > 0) {
         if (QuicCongestionControlOnDataAcknowledged(
                 &Connection->CongestionControl,
@@ -1222,6 +1712,32 @@ QuicLossDetectionProcessAckBlocks(
 
     LossDetection->ProbeCount = 0;
 
+    if (Connection->PeerTransportParams.Flags & QUIC_TP_FLAG_MIN_ACK_DELAY) {
+        //
+        // The peer supports ACK_FREQUENCY frames, so scale the number of
+        // packets it may receive before having to ACK with the congestion
+        // window, targeting a fixed number of ACKs per window. This keeps the
+        // ACK-generation cost roughly constant as the send rate grows.
+        //
+        uint32_t PacketsPerWindow =
+            Connection->CongestionControl.CongestionWindow / Path->Mtu;
+        uint32_t NewPacketTolerance =
+            PacketsPerWindow / QUIC_ACK_FREQUENCY_WINDOW_DIVISOR;
+        if (NewPacketTolerance < QUIC_MIN_ACK_SEND_NUMBER) {
+            NewPacketTolerance = QUIC_MIN_ACK_SEND_NUMBER;
+        } else if (NewPacketTolerance > UINT8_MAX) {
+            NewPacketTolerance = UINT8_MAX;
+        }
+        QuicConnUpdatePeerPacketTolerance(
+            Connection, (uint8_t)NewPacketTolerance);
+    }
+
+    //
+    // The path is demonstrably alive, so this is a good time to check whether
+    // a completed MTU search is due to be restarted.
+    //
+    QuicPathMtuDiscoveryCheckRaiseTimeout(Connection, Path);
+
     //
     // At least one packet was ACKed. If all packets were ACKed then we'll
     // cancel the timer; otherwise we'll reset the timer.
@@ -1236,6 +1752,7 @@ QuicLossDetectionProcessAckFrame(
     _In_ QUIC_PATH* Path,
     _In_ QUIC_ENCRYPT_LEVEL EncryptLevel,
     _In_ QUIC_FRAME_TYPE FrameType,
+    _In_ uint64_t RecvTimeUs,
     _In_ uint16_t BufferLength,
     _In_reads_bytes_(BufferLength)
         const uint8_t* const Buffer,
@@ -1253,22 +1770,54 @@ QuicLossDetectionProcessAckFrame(
     uint64_t AckDelay; // microsec
     QUIC_ACK_ECN_EX Ecn;
 
+    QUIC_SUBRANGE StackBlocks[QUIC_MAX_ACK_BLOCKS_STACK_DECODE];
+    QUIC_SUBRANGE* AckBlocks = StackBlocks;
+    uint32_t AckBlockCount = 0;
+    BOOLEAN UsedDecodedAckRanges = FALSE;
+
+    //
+    // Decode the blocks straight onto the stack (sorted smallest to largest)
+    // so they can feed the sent-packet walk without building up a QUIC_RANGE
+    // first.
+    //
     BOOLEAN Result =
-        QuicAckFrameDecode(
+        QuicAckFrameDecodeFast(
             FrameType,
             BufferLength,
             Buffer,
             Offset,
             InvalidFrame,
-            &Connection->DecodedAckRanges,
+            StackBlocks,
+            ARRAYSIZE(StackBlocks),
+            &AckBlockCount,
             &Ecn,
             &AckDelay);
 
+    if (!Result && !*InvalidFrame &&
+        AckBlockCount > ARRAYSIZE(StackBlocks)) {
+        //
+        // More blocks than fit on the stack. Take the heap-backed path.
+        //
+        UsedDecodedAckRanges = TRUE;
+        Result =
+            QuicAckFrameDecode(
+                FrameType,
+                BufferLength,
+                Buffer,
+                Offset,
+                InvalidFrame,
+                &Connection->DecodedAckRanges,
+                &Ecn,
+                &AckDelay);
+        AckBlocks = Connection->DecodedAckRanges.SubRanges;
+        AckBlockCount = QuicRangeSize(&Connection->DecodedAckRanges);
+    }
+
     if (Result) {
 
-        uint64_t Largest;
-        if (!QuicRangeGetMaxSafe(&Connection->DecodedAckRanges, &Largest) ||
-            LossDetection->LargestSentPacketNumber < Largest) {
+        if (AckBlockCount == 0 ||
+            LossDetection->LargestSentPacketNumber <
+                QuicRangeGetHigh(&AckBlocks[AckBlockCount - 1])) {
 
             //
             // The ACK frame should never acknowledge a packet number we haven't
@@ -1279,7 +1828,6 @@ QuicLossDetectionProcessAckFrame(
 
         } else {
 
-            // TODO - Use ECN information.
             AckDelay <<= Connection->PeerTransportParams.AckDelayExponent;
 
             QuicLossDetectionProcessAckBlocks(
@@ -1287,12 +1835,17 @@ QuicLossDetectionProcessAckFrame(
                 Path,
                 EncryptLevel,
                 AckDelay,
-                &Connection->DecodedAckRanges,
+                RecvTimeUs,
+                AckBlocks,
+                AckBlockCount,
+                FrameType == QUIC_FRAME_ACK_1 ? &Ecn : NULL,
                 InvalidFrame);
         }
     }
 
-    QuicRangeReset(&Connection->DecodedAckRanges);
+    if (UsedDecodedAckRanges) {
+        QuicRangeReset(&Connection->DecodedAckRanges);
+    }
 
     return Result;
 }
@@ -1309,7 +1862,8 @@ QuicLossDetectionScheduleProbe(
     QUIC_CONNECTION* Connection = QuicLossDetectionGetConnection(LossDetection);
 
     LossDetection->ProbeCount++;
-    QuicTraceLogConnInfo(
+    QuicTraceLogConnInfoClass(
+        QUIC_TRACE_CLASS_LOSS,
         ScheduleProbe,
         Connection,
         "probe round %lu",
@@ -1354,11 +1908,79 @@ QuicLossDetectionScheduleProbe(
 
     //
     // Not enough new stream data exists to fill the probing packets. Schedule
-    // retransmits if possible.
+    // retransmits if possible. Rather than blindly resending the oldest
+    // packets, first pick the packet carrying the lowest offset outstanding
+    // STREAM bytes of the highest priority stream, so a probe that gets
+    // through unblocks the app soonest. The rest (and packets without STREAM
+    // frames) are filled oldest first, as before.
     //
-    QUIC_SENT_PACKET_METADATA* Packet = LossDetection->SentPackets;
-    while (Packet != NULL) {
-        if (Packet->Flags.IsRetransmittable) {
+    QUIC_SENT_PACKET_METADATA* BestStreamPacket = NULL;
+    uint16_t BestPriority = 0;
+    uint64_t BestOffset = 0;
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        QUIC_SENT_PACKET_METADATA* Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet == NULL || !Packet->Flags.IsRetransmittable) {
+            continue;
+        }
+        for (uint8_t i = 0; i < Packet->FrameCount; i++) {
+            switch (Packet->Frames[i].Type) {
+            case QUIC_FRAME_STREAM:
+            case QUIC_FRAME_STREAM_1:
+            case QUIC_FRAME_STREAM_2:
+            case QUIC_FRAME_STREAM_3:
+            case QUIC_FRAME_STREAM_4:
+            case QUIC_FRAME_STREAM_5:
+            case QUIC_FRAME_STREAM_6:
+            case QUIC_FRAME_STREAM_7:
+                if (BestStreamPacket == NULL ||
+                    Packet->Frames[i].STREAM.Stream->SendPriority > BestPriority ||
+                    (Packet->Frames[i].STREAM.Stream->SendPriority == BestPriority &&
+                     Packet->Frames[i].STREAM.Offset < BestOffset)) {
+                    BestStreamPacket = Packet;
+                    BestPriority = Packet->Frames[i].STREAM.Stream->SendPriority;
+                    BestOffset = Packet->Frames[i].STREAM.Offset;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (BestStreamPacket != NULL) {
+        QuicTraceLogVerbose(
+            PacketTxProbeRetransmit,
+            "[%c][TX][%llu] Probe Retransmit",
+            PtkConnPre(Connection),
+            BestStreamPacket->PacketNumber);
+        QuicTraceEvent(
+            ConnPacketLost,
+            "[conn][%p][TX][%llu] %hhu Lost: %hhu",
+            Connection,
+            BestStreamPacket->PacketNumber,
+            QuicPacketTraceType(BestStreamPacket),
+            QUIC_TRACE_PACKET_LOSS_PROBE);
+        if (QuicLossDetectionRetransmitFrames(LossDetection, BestStreamPacket) &&
+            --NumPackets == 0) {
+            return;
+        }
+    }
+
+    for (uint64_t PacketNumber = LossDetection->LowestTrackedPacketNumber;
+         LossDetection->SentPacketsCount != 0 &&
+            PacketNumber <= LossDetection->LargestSentPacketNumber;
+         PacketNumber++) {
+        QUIC_SENT_PACKET_METADATA* Packet =
+            LossDetection->SentPackets[
+                PacketNumber & (LossDetection->SentPacketsSize - 1)];
+        if (Packet != NULL &&
+            Packet != BestStreamPacket &&
+            Packet->Flags.IsRetransmittable) {
             QuicTraceLogVerbose(
                 PacketTxProbeRetransmit,
                 "[%c][TX][%llu] Probe Retransmit",
@@ -1376,7 +1998,6 @@ QuicLossDetectionScheduleProbe(
                 return;
             }
         }
-        Packet = Packet->Next;
     }
 
     //
@@ -23,20 +23,19 @@ typedef struct QUIC_LOSS_DETECTION {
     QUIC_ENCRYPT_LEVEL LargestAckEncryptLevel;
 
     //
-    // N.B.: SentPackets and LostPackets are generally kept in ascending packet
-    // number order, and packets in the LostPackets list generally have smaller
-    // numbers than those in the SentPackets list. The only case this is not
-    // true is during the handshake. Since multiple encryption levels are used
-    // in parallel, higher numbered packets in lower encryption levels can be
-    // "lost" sooner than the higher encryption levels.
-    //
-
-    //
-    // Outstanding packets.
+    // Outstanding packets, indexed by packet number. The slot for packet
+    // number N is SentPackets[N & (SentPacketsSize - 1)]; a NULL slot means
+    // the packet is no longer outstanding. All outstanding packets fall in
+    // the window [LowestTrackedPacketNumber, LargestSentPacketNumber] and the
+    // ring is grown whenever that window would outgrow it, so lookup by
+    // packet number is constant time. Allocated on first send.
     //
     uint64_t LargestSentPacketNumber;
-    QUIC_SENT_PACKET_METADATA* SentPackets;
-    QUIC_SENT_PACKET_METADATA** SentPacketsTail;
+    uint64_t LowestTrackedPacketNumber;
+    uint32_t SentPacketsCount;
+    uint32_t SentPacketsSize; // Always zero or a power of two.
+    _Field_size_(SentPacketsSize)
+    QUIC_SENT_PACKET_METADATA** SentPackets;
 
     uint32_t TimeOfLastPacketSent;
 
@@ -46,6 +45,12 @@ typedef struct QUIC_LOSS_DETECTION {
     // comes in later than expected. For accounting purposes we don't consider
     // these packets to be in the network.
     //
+    // N.B.: The list is generally kept in ascending packet number order. The
+    // only case this is not true is during the handshake. Since multiple
+    // encryption levels are used in parallel, higher numbered packets in
+    // lower encryption levels can be "lost" sooner than the higher encryption
+    // levels.
+    //
     QUIC_SENT_PACKET_METADATA* LostPackets;
     QUIC_SENT_PACKET_METADATA** LostPacketsTail;
 
@@ -54,6 +59,53 @@ typedef struct QUIC_LOSS_DETECTION {
     //
     uint16_t ProbeCount;
 
+    //
+    // The current packet reorder threshold for (FACK) loss detection. Starts
+    // at QUIC_PACKET_REORDER_THRESHOLD and grows (up to
+    // QUIC_PACKET_REORDER_THRESHOLD_MAX) to cover the largest reordering
+    // observed on the path, so reordering links don't cause spurious
+    // retransmits. The (RACK) time threshold remains the backstop signal.
+    //
+    uint64_t PacketReorderThreshold;
+
+    //
+    // Indicates a timer recomputation was requested while the connection was
+    // draining operations, and has been deferred to the end of the drain.
+    //
+    BOOLEAN UpdateTimerPending;
+
+    //
+    // Packets whose metadata is done with, held back so the returns to the
+    // worker's pool happen in one batch at the end of the operation drain
+    // instead of interleaved with the ACK parsing loops.
+    //
+    QUIC_SENT_PACKET_METADATA* DeferredFreePackets;
+
+    //
+    // Delivery-rate estimator state. Each sent packet records the totals
+    // below at send time, and each ACK batch turns the newest acknowledged
+    // packet's record into a rate sample: bytes delivered since the packet
+    // was sent, over the time that took.
+    //
+    uint64_t DeliveredBytes;
+    uint32_t DeliveredTime; // In microseconds
+
+    //
+    // While nonzero, the send path has run out of application data and
+    // samples can't be trusted to reflect the path. Holds the DeliveredBytes
+    // total that must be exceeded before samples are trustworthy again.
+    //
+    uint64_t AppLimitedDelivered;
+
+    //
+    // The current delivery rate estimate, in bytes per second. A sample
+    // replaces the estimate if it is larger, or if the estimate is older
+    // than QUIC_DELIVERY_RATE_WINDOW_US (so rate drops are seen too).
+    //
+    uint64_t DeliveryRate;
+    uint32_t DeliveryRateTime; // In microseconds
+    BOOLEAN DeliveryRateAppLimited;
+
 } QUIC_LOSS_DETECTION;
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -95,7 +147,9 @@ QuicLossDetectionOnZeroRttRejected(
     );
 
 //
-// Resets the timer based on the current state.
+// Resets the timer based on the current state. While the connection is
+// draining operations, the recomputation is coalesced and deferred to the
+// end of the drain.
 //
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
@@ -103,6 +157,26 @@ QuicLossDetectionUpdateTimer(
     _In_ QUIC_LOSS_DETECTION* LossDetection
     );
 
+//
+// Performs any timer recomputation deferred during the operation drain that
+// just completed.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionProcessDeferredTimerUpdate(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    );
+
+//
+// Returns all packet metadata frees deferred during the operation drain that
+// just completed to the worker's pool.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionProcessDeferredFrees(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    );
+
 //
 // Returns the current PTO in microseconds.
 //
@@ -114,6 +188,17 @@ QuicLossDetectionComputeProbeTimeout(
     _In_ uint32_t Count
     );
 
+//
+// Queues (re)transmission of the data carried by the frames in the given
+// packet metadata. Returns TRUE if any new data was queued to be sent.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+BOOLEAN
+QuicLossDetectionRetransmitFrames(
+    _In_ QUIC_LOSS_DETECTION* LossDetection,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    );
+
 //
 // Called when a new packet is sent.
 //
@@ -126,9 +211,22 @@ QuicLossDetectionOnPacketSent(
     );
 
 //
-// Processes a received ACK frame. Returns true if the frame could be
-// successfully processed. On failure, 'InvalidFrame' indicates if the frame
-// was corrupt or not.
+// Called when the send path runs out of application data while the
+// congestion controller would still allow more to be sent. Delivery rate
+// samples taken from packets sent in this condition measure the app, not
+// the path, and are not allowed to lower the rate estimate.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicLossDetectionSetAppLimited(
+    _In_ QUIC_LOSS_DETECTION* LossDetection
+    );
+
+//
+// Processes a received ACK frame. 'RecvTimeUs' is the datapath's receive
+// timestamp for the datagram carrying the frame (zero if unknown). Returns
+// true if the frame could be successfully processed. On failure,
+// 'InvalidFrame' indicates if the frame was corrupt or not.
 //
 _IRQL_requires_max_(PASSIVE_LEVEL)
 BOOLEAN
@@ -137,6 +235,7 @@ QuicLossDetectionProcessAckFrame(
     _In_ QUIC_PATH* Path,
     _In_ QUIC_ENCRYPT_LEVEL EncryptLevel,
     _In_ QUIC_FRAME_TYPE FrameType,
+    _In_ uint64_t RecvTimeUs,
     _In_ uint16_t BufferLength,
     _In_reads_bytes_(BufferLength)
         const uint8_t* const Buffer,
@@ -20,6 +20,16 @@ Abstract:
     is the only thread that touches the connection itself, which simplifies
     synchronization.
 
+    The queue itself is lock-free: producers push onto an interlocked LIFO
+    stack (a second stack exists for the front-of-queue operations) and the
+    consumer steals the whole stack at once, reversing it into its private
+    FIFO list. Producers therefore never contend with the drain loop. The
+    only cross-thread handshake is the ActivelyProcessing flag, which the
+    consumer clears before its final (emptiness-determining) steal so that a
+    concurrent producer either gets collected by that steal or observes the
+    flag cleared and requeues the connection; a spurious requeue is harmless
+    because the worker deduplicates scheduling under its own lock.
+
 --*/
 
 #include "precomp.h"
@@ -31,7 +41,8 @@ QuicOperationQueueInitialize(
     )
 {
     OperQ->ActivelyProcessing = FALSE;
-    QuicDispatchLockInitialize(&OperQ->Lock);
+    OperQ->PushStack = NULL;
+    OperQ->PriorityPushStack = NULL;
     QuicListInitializeHead(&OperQ->List);
 }
 
@@ -43,7 +54,8 @@ QuicOperationQueueUninitialize(
 {
     UNREFERENCED_PARAMETER(OperQ);
     QUIC_DBG_ASSERT(QuicListIsEmpty(&OperQ->List));
-    QuicDispatchLockUninitialize(&OperQ->Lock);
+    QUIC_DBG_ASSERT(OperQ->PushStack == NULL);
+    QUIC_DBG_ASSERT(OperQ->PriorityPushStack == NULL);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -116,22 +128,89 @@ QuicOperationFree(
     QuicPoolFree(&Worker->OperPool, Oper);
 }
 
+//
+// Pushes an operation onto one of the producer stacks. Returns the previous
+// top of the stack.
+//
 _IRQL_requires_max_(DISPATCH_LEVEL)
-BOOLEAN
-QuicOperationEnqueue(
-    _In_ QUIC_OPERATION_QUEUE* OperQ,
+QUIC_LIST_ENTRY*
+QuicOperationStackPush(
+    _Inout_ QUIC_LIST_ENTRY* volatile* Stack,
     _In_ QUIC_OPERATION* Oper
     )
 {
-    BOOLEAN StartProcessing;
-    QuicDispatchLockAcquire(&OperQ->Lock);
 #if DEBUG
     QUIC_DBG_ASSERT(Oper->Link.Flink == NULL);
 #endif
-    StartProcessing = QuicListIsEmpty(&OperQ->List) && !OperQ->ActivelyProcessing;
-    QuicListInsertTail(&OperQ->List, &Oper->Link);
-    QuicDispatchLockRelease(&OperQ->Lock);
-    return StartProcessing;
+    QUIC_LIST_ENTRY* Top;
+    do {
+        Top = *Stack;
+        Oper->Link.Flink = Top;
+    } while (InterlockedCompareExchangePointer(
+                 (void* volatile*)Stack, &Oper->Link, Top) != Top);
+    return Top;
+}
+
+//
+// Steals everything from the producer stacks and splices it into the
+// consumer's private list. The normal stack is reversed to restore FIFO
+// order; the priority stack is spliced (in LIFO order) in front of
+// everything else.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicOperationQueueCollect(
+    _In_ QUIC_OPERATION_QUEUE* OperQ
+    )
+{
+    QUIC_LIST_ENTRY* Entry;
+    QUIC_LIST_ENTRY* Reversed;
+
+    Entry =
+        (QUIC_LIST_ENTRY*)
+            InterlockedExchangePointer(
+                (void* volatile*)&OperQ->PushStack, NULL);
+    Reversed = NULL;
+    while (Entry != NULL) {
+        QUIC_LIST_ENTRY* Next = Entry->Flink;
+        Entry->Flink = Reversed;
+        Reversed = Entry;
+        Entry = Next;
+    }
+    while (Reversed != NULL) {
+        QUIC_LIST_ENTRY* Next = Reversed->Flink;
+        QuicListInsertTail(&OperQ->List, Reversed);
+        Reversed = Next;
+    }
+
+    Entry =
+        (QUIC_LIST_ENTRY*)
+            InterlockedExchangePointer(
+                (void* volatile*)&OperQ->PriorityPushStack, NULL);
+    Reversed = NULL;
+    while (Entry != NULL) {
+        QUIC_LIST_ENTRY* Next = Entry->Flink;
+        Entry->Flink = Reversed;
+        Reversed = Entry;
+        Entry = Next;
+    }
+    while (Reversed != NULL) {
+        QUIC_LIST_ENTRY* Next = Reversed->Flink;
+        QuicListInsertHead(&OperQ->List, Reversed);
+        Reversed = Next;
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicOperationEnqueue(
+    _In_ QUIC_OPERATION_QUEUE* OperQ,
+    _In_ QUIC_OPERATION* Oper
+    )
+{
+    return
+        QuicOperationStackPush(&OperQ->PushStack, Oper) == NULL &&
+        !OperQ->ActivelyProcessing;
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -141,15 +220,9 @@ QuicOperationEnqueueFront(
     _In_ QUIC_OPERATION* Oper
     )
 {
-    BOOLEAN StartProcessing;
-    QuicDispatchLockAcquire(&OperQ->Lock);
-#if DEBUG
-    QUIC_DBG_ASSERT(Oper->Link.Flink == NULL);
-#endif
-    StartProcessing = QuicListIsEmpty(&OperQ->List) && !OperQ->ActivelyProcessing;
-    QuicListInsertHead(&OperQ->List, &Oper->Link);
-    QuicDispatchLockRelease(&OperQ->Lock);
-    return StartProcessing;
+    return
+        QuicOperationStackPush(&OperQ->PriorityPushStack, Oper) == NULL &&
+        !OperQ->ActivelyProcessing;
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -158,24 +231,88 @@ QuicOperationDequeue(
     _In_ QUIC_OPERATION_QUEUE* OperQ
     )
 {
-    QUIC_OPERATION* Oper;
-    QuicDispatchLockAcquire(&OperQ->Lock);
     if (QuicListIsEmpty(&OperQ->List)) {
+        //
+        // Clear the flag before the steal. A producer that pushes after the
+        // steal then observes it cleared and requeues the connection, so the
+        // operation can't be stranded; one that pushes before the steal gets
+        // collected below.
+        //
         OperQ->ActivelyProcessing = FALSE;
-        Oper = NULL;
-    } else {
-        OperQ->ActivelyProcessing = TRUE;
-        Oper =
-            QUIC_CONTAINING_RECORD(
-                QuicListRemoveHead(&OperQ->List), QUIC_OPERATION, Link);
+    }
+
+    QuicOperationQueueCollect(OperQ);
+
+    if (QuicListIsEmpty(&OperQ->List)) {
+        return NULL;
+    }
+
+    OperQ->ActivelyProcessing = TRUE;
+    QUIC_OPERATION* Oper =
+        QUIC_CONTAINING_RECORD(
+            QuicListRemoveHead(&OperQ->List), QUIC_OPERATION, Link);
 #if DEBUG
-        Oper->Link.Flink = NULL;
+    Oper->Link.Flink = NULL;
 #endif
+    return Oper;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_OPERATION*
+QuicOperationDequeueIfType(
+    _In_ QUIC_OPERATION_QUEUE* OperQ,
+    _In_ QUIC_OPERATION_TYPE Type
+    )
+{
+    QUIC_DBG_ASSERT(OperQ->ActivelyProcessing);
+
+    QuicOperationQueueCollect(OperQ);
+
+    if (QuicListIsEmpty(&OperQ->List)) {
+        return NULL;
     }
-    QuicDispatchLockRelease(&OperQ->Lock);
+
+    QUIC_OPERATION* Oper =
+        QUIC_CONTAINING_RECORD(OperQ->List.Flink, QUIC_OPERATION, Link);
+    if (Oper->Type != Type) {
+        return NULL;
+    }
+
+    QuicListEntryRemove(&Oper->Link);
+#if DEBUG
+    Oper->Link.Flink = NULL;
+#endif
     return Oper;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_OPERATION*
+QuicOperationDequeueType(
+    _In_ QUIC_OPERATION_QUEUE* OperQ,
+    _In_ QUIC_OPERATION_TYPE Type
+    )
+{
+    QUIC_DBG_ASSERT(OperQ->ActivelyProcessing);
+
+    QuicOperationQueueCollect(OperQ);
+
+    for (QUIC_LIST_ENTRY* Entry = OperQ->List.Flink;
+         Entry != &OperQ->List;
+         Entry = Entry->Flink) {
+        QUIC_OPERATION* Oper =
+            QUIC_CONTAINING_RECORD(Entry, QUIC_OPERATION, Link);
+        if (Oper->Type == Type) {
+            QuicListEntryRemove(&Oper->Link);
+#if DEBUG
+            Oper->Link.Flink = NULL;
+#endif
+            return Oper;
+        }
+    }
+
+    return NULL;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
 QuicOperationQueueClear(
@@ -186,10 +323,9 @@ QuicOperationQueueClear(
     QUIC_LIST_ENTRY OldList;
     QuicListInitializeHead(&OldList);
 
-    QuicDispatchLockAcquire(&OperQ->Lock);
     OperQ->ActivelyProcessing = FALSE;
+    QuicOperationQueueCollect(OperQ);
     QuicListMoveItems(&OperQ->List, &OldList);
-    QuicDispatchLockRelease(&OperQ->Lock);
 
     while (!QuicListIsEmpty(&OldList)) {
         QUIC_OPERATION* Oper =
@@ -26,6 +26,7 @@ typedef enum QUIC_OPERATION_TYPE {
     QUIC_OPER_TYPE_TLS_COMPLETE,        // A TLS process call completed.
     QUIC_OPER_TYPE_TIMER_EXPIRED,       // A timer expired.
     QUIC_OPER_TYPE_TRACE_RUNDOWN,       // A trace rundown was triggered.
+    QUIC_OPER_TYPE_SETTINGS_UPDATE,     // Hot-apply updated session settings.
 
     //
     // All stateless operations follow.
@@ -50,6 +51,8 @@ typedef enum QUIC_API_TYPE {
     QUIC_API_TYPE_STRM_RECV_COMPLETE,
     QUIC_API_TYPE_STRM_RECV_SET_ENABLED,
 
+    QUIC_API_TYPE_DATAGRAM_SEND,
+
     QUIC_API_TYPE_SET_PARAM,
     QUIC_API_TYPE_GET_PARAM
 
@@ -150,6 +153,7 @@ typedef enum QUIC_CONN_TIMER_TYPE {
     QUIC_CONN_TIMER_LOSS_DETECTION,
     QUIC_CONN_TIMER_KEEP_ALIVE,
     QUIC_CONN_TIMER_IDLE,
+    QUIC_CONN_TIMER_HIBERNATE,
     QUIC_CONN_TIMER_SHUTDOWN,
 
     QUIC_CONN_TIMER_COUNT
@@ -249,19 +253,33 @@ QuicOperLog(
 }
 
 //
-// A queue of operations to be executed for a connection.
+// A queue of operations to be executed for a connection. Producers (API
+// threads, datapath threads and timers) push onto lock-free LIFO stacks; the
+// draining QUIC_WORKER periodically steals the whole stacks and splices them
+// into its private list, so producers never contend with the consumer.
 //
 typedef struct QUIC_OPERATION_QUEUE {
 
     //
-    // TRUE if the queue is being drained.
+    // TRUE if the queue is being drained. Only written by the consumer;
+    // producers read it to decide if the connection needs to be (re)queued
+    // on the worker.
     //
-    BOOLEAN ActivelyProcessing;
+    BOOLEAN volatile ActivelyProcessing;
 
     //
-    // Queue of pending operations.
+    // Producer stacks of pending operations, linked through Link.Flink and
+    // pushed with interlocked operations. The priority stack holds the
+    // operations enqueued at the front of the queue; popping it in LIFO
+    // order matches the old insert-at-head semantics.
+    //
+    QUIC_LIST_ENTRY* volatile PushStack;
+    QUIC_LIST_ENTRY* volatile PriorityPushStack;
+
+    //
+    // The consumer's private queue of stolen operations. Only ever touched
+    // by the draining worker.
     //
-    QUIC_DISPATCH_LOCK Lock;
     QUIC_LIST_ENTRY List;
 
 } QUIC_OPERATION_QUEUE;
@@ -335,6 +353,30 @@ QuicOperationDequeue(
     _In_ QUIC_OPERATION_QUEUE* OperQ
     );
 
+//
+// Dequeues the next operation only if it is of the given type. Returns NULL
+// if the queue is empty or the next operation has a different type. May only
+// be called while the queue is actively being processed.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_OPERATION*
+QuicOperationDequeueIfType(
+    _In_ QUIC_OPERATION_QUEUE* OperQ,
+    _In_ QUIC_OPERATION_TYPE Type
+    );
+
+//
+// Dequeues the first queued operation of the given type, regardless of its
+// position in the queue. Returns NULL if none is queued. May only be called
+// while the queue is actively being processed.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_OPERATION*
+QuicOperationDequeueType(
+    _In_ QUIC_OPERATION_QUEUE* OperQ,
+    _In_ QUIC_OPERATION_TYPE Type
+    );
+
 //
 // Dequeues and frees all operations.
 //
@@ -16,8 +16,12 @@ Abstract:
 // The list is in priority order (highest to lowest).
 //
 const uint32_t QuicSupportedVersionList[] = {
+#ifdef QUIC_SINGLE_VERSION
+    QUIC_VERSION_LATEST
+#else
     QUIC_VERSION_DRAFT_27,
     QUIC_VERSION_MS_1
+#endif
 };
 
 const uint8_t QuicInitialSaltVersion1[] =
@@ -141,7 +145,7 @@ QuicPacketValidateInvariant(
         //
 
         if (Packet->DestCidLen != DestCidLen ||
-            memcmp(Packet->DestCid, DestCid, DestCidLen) != 0) {
+            !QuicCidEqual(Packet->DestCid, DestCid, DestCidLen)) {
             QuicPacketLogDrop(Owner, Packet, "DestCid don't match");
             return FALSE;
         }
@@ -151,7 +155,7 @@ QuicPacketValidateInvariant(
             QUIC_DBG_ASSERT(Packet->SourceCid != NULL);
 
             if (Packet->SourceCidLen != SourceCidLen ||
-                memcmp(Packet->SourceCid, SourceCid, SourceCidLen) != 0) {
+                !QuicCidEqual(Packet->SourceCid, SourceCid, SourceCidLen)) {
                 QuicPacketLogDrop(Owner, Packet, "SourceCid don't match");
                 return FALSE;
             }
@@ -506,6 +510,35 @@ QuicPacketValidateShortHeaderV1(
     return TRUE;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicPacketValidateShortHeaderV1Fast(
+    _In_ const void* Owner, // Binding or Connection depending on state
+    _Inout_ QUIC_RECV_PACKET* Packet
+    )
+{
+    QUIC_DBG_ASSERT(Packet->ValidatedHeaderInv);
+    QUIC_DBG_ASSERT(Packet->IsShortHeader);
+    QUIC_DBG_ASSERT(Packet->BufferLength >= Packet->HeaderLength);
+
+    //
+    // A single masked comparison validates the header form and fixed bits at
+    // once. The rest of the first byte is protected or random, so there is
+    // nothing else to check before decryption.
+    //
+    if ((Packet->Buffer[0] & QUIC_SHORT_HEADER_BYTE_MASK_V1) !=
+            QUIC_SHORT_HEADER_BYTE_V1) {
+        QuicPacketLogDrop(Owner, Packet, "Invalid SH FixedBit bits values");
+        return FALSE;
+    }
+
+    Packet->PayloadLength = Packet->BufferLength - Packet->HeaderLength;
+    Packet->ValidatedHeaderVer = TRUE;
+
+    return TRUE;
+}
+
 _Null_terminated_ const char*
 QuicLongHeaderTypeToString(uint8_t Type)
 {
@@ -8,7 +8,7 @@
 //
 // The list of supported QUIC version numbers, in network byte order.
 //
-extern const uint32_t QuicSupportedVersionList[2];
+extern const uint32_t QuicSupportedVersionList[QUIC_SUPPORTED_VERSION_COUNT];
 
 //
 // Version specific salts.
@@ -217,6 +217,15 @@ typedef struct QUIC_SHORT_HEADER_V1 {
     4 * sizeof(uint8_t) \
 )
 
+//
+// Expected first byte template for a v1 short header packet: header form bit
+// clear (short header) and fixed bit set. The remaining bits are either
+// covered by header protection or random (spin bit), so they can't be
+// validated before decryption.
+//
+#define QUIC_SHORT_HEADER_BYTE_MASK_V1 0xC0
+#define QUIC_SHORT_HEADER_BYTE_V1      0x40
+
 #pragma pack(pop)
 
 //
@@ -274,6 +283,21 @@ QuicPacketValidateShortHeaderV1(
     _Inout_ QUIC_RECV_PACKET* Packet
     );
 
+//
+// Straight-line validation of a short header packet on an established
+// connection: a single comparison of the first byte against the expected
+// short header template replaces the separate invariant and version
+// specific validation passes. Only call once the invariant part (including
+// the destination CID) has already been validated.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicPacketValidateShortHeaderV1Fast(
+    _In_ const void* Owner, // Binding or Connection depending on state
+    _Inout_ QUIC_RECV_PACKET* Packet
+    );
+
 inline
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
@@ -30,6 +30,31 @@ QuicPacketBuilderSendBatch(
     _Inout_ QUIC_PACKET_BUILDER* Builder
     );
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicPacketBuilderFinalizeCrypto(
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    );
+
+//
+// Copies the send-relevant path state into the builder and records the path
+// version it corresponds to.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPacketBuilderSnapshotPath(
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    const QUIC_PATH* Path = Builder->Path;
+    Builder->PathVersion = Path->Version;
+    Builder->PathMtu = Path->Mtu;
+    Builder->PathMtuProbeSize = Path->MtuProbeSize;
+    Builder->PathFamily = QuicAddrGetFamily(&Path->RemoteAddress);
+    Builder->PathSpinBit = Path->SpinBit;
+    Builder->PathEcnFailed = Path->EcnFailed;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Success_(return != FALSE)
 BOOLEAN
@@ -49,6 +74,31 @@ QuicPacketBuilderInitialize(
         Connection->State.EncryptionEnabled ?
             QUIC_ENCRYPTION_OVERHEAD : 0;
 
+    //
+    // Reset all the transient bookkeeping explicitly, since the builder may
+    // be a reused per-worker instance rather than freshly zeroed stack space.
+    // The large crypto scratch arrays are deliberately left untouched; they
+    // are always written before being read.
+    //
+    Builder->SendContext = NULL;
+    Builder->MirrorSendContext = NULL;
+    Builder->Datagram = NULL;
+    Builder->Key = NULL;
+    Builder->BatchCount = 0;
+    Builder->TotalCountDatagrams = 0;
+    QuicPacketBuilderSnapshotPath(Builder);
+
+    //
+    // Without send segmentation each datagram is an individual message on the
+    // wire, so don't build the huge batches that only pay off when the whole
+    // batch is handed to the kernel as one segmented buffer.
+    //
+    Builder->MaxDatagrams =
+        (QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath) &
+            QUIC_DATAPATH_FEATURE_SEND_SEGMENTATION) ?
+            QUIC_MAX_DATAGRAMS_PER_SEND :
+            QUIC_MAX_DATAGRAMS_PER_SEND_UNSEGMENTED;
+
     if (Connection->SourceCids.Next == NULL) {
         QuicTraceLogConnWarning(
             NoSrcCidAvailable,
@@ -71,13 +121,15 @@ QuicPacketBuilderInitialize(
     } else {
         TimeSinceLastSend = 0;
     }
+    Builder->AmplificationBudget =
+        Path->IsPeerValidated ? UINT32_MAX : Path->Allowance;
     Builder->SendAllowance =
         QuicCongestionControlGetSendAllowance(
             &Connection->CongestionControl,
             TimeSinceLastSend,
             Connection->Send.LastFlushTimeValid);
-    if (Builder->SendAllowance > Path->Allowance) {
-        Builder->SendAllowance = Path->Allowance;
+    if (Builder->SendAllowance > Builder->AmplificationBudget) {
+        Builder->SendAllowance = Builder->AmplificationBudget;
     }
     Connection->Send.LastFlushTime = TimeNow;
     Connection->Send.LastFlushTimeValid = TRUE;
@@ -95,6 +147,15 @@ QuicPacketBuilderCleanup(
         QuicPacketBuilderFinalize(Builder, TRUE);
     }
 
+    if (Builder->MirrorSendContext != NULL) {
+        //
+        // The racing path went away before the batch was sent; drop the
+        // copies.
+        //
+        QuicDataPathBindingFreeSendContext(Builder->MirrorSendContext);
+        Builder->MirrorSendContext = NULL;
+    }
+
     if (Builder->PacketBatchSent && Builder->PacketBatchRetransmittable) {
         QuicLossDetectionUpdateTimer(&Builder->Connection->LossDetection);
     }
@@ -136,12 +197,16 @@ QuicPacketBuilderPrepare(
         return FALSE;
     }
 
+    if (Builder->PathVersion != Builder->Path->Version) {
+        QuicPacketBuilderSnapshotPath(Builder);
+    }
+
     BOOLEAN Result = FALSE;
     uint8_t NewPacketType = QuicKeyTypeToPacketType(NewPacketKeyType);
-    uint16_t DatagramSize = Builder->Path->Mtu;
-    if ((uint32_t)DatagramSize > Builder->Path->Allowance) {
+    uint16_t DatagramSize = Builder->PathMtu;
+    if ((uint32_t)DatagramSize > Builder->AmplificationBudget) {
         QUIC_DBG_ASSERT(!IsPathMtuDiscovery); // PMTUD always happens after source addr validation.
-        DatagramSize = (uint16_t)Builder->Path->Allowance;
+        DatagramSize = (uint16_t)Builder->AmplificationBudget;
     }
     QUIC_DBG_ASSERT(!IsPathMtuDiscovery || !IsTailLossProbe); // Never both.
 
@@ -161,7 +226,7 @@ QuicPacketBuilderPrepare(
             QuicPacketBuilderFinalize(Builder, IsPathMtuDiscovery);
         }
         if (Builder->SendContext == NULL &&
-            Builder->TotalCountDatagrams >= QUIC_MAX_DATAGRAMS_PER_SEND) {
+            Builder->TotalCountDatagrams >= Builder->MaxDatagrams) {
             goto Error;
         }
         NewQuicPacket = TRUE;
@@ -186,7 +251,7 @@ QuicPacketBuilderPrepare(
                     IsPathMtuDiscovery ?
                         0 :
                         MaxUdpPayloadSizeForFamily(
-                            QuicAddrGetFamily(&Builder->Path->RemoteAddress),
+                            Builder->PathFamily,
                             DatagramSize));
             if (Builder->SendContext == NULL) {
                 QuicTraceEvent(
@@ -196,12 +261,16 @@ QuicPacketBuilderPrepare(
                     0);
                 goto Error;
             }
+            QuicDataPathBindingSetEcnCodePoint(
+                Builder->SendContext,
+                (Connection->Session->Settings.EcnEnabled && !Builder->PathEcnFailed) ?
+                    QUIC_ECN_ECT_0 : QUIC_ECN_NON_ECT);
         }
 
         uint16_t NewDatagramLength =
             MaxUdpPayloadSizeForFamily(
-                QuicAddrGetFamily(&Builder->Path->RemoteAddress),
-                IsPathMtuDiscovery ? QUIC_MAX_MTU : DatagramSize);
+                Builder->PathFamily,
+                IsPathMtuDiscovery ? Builder->PathMtuProbeSize : DatagramSize);
         if ((Connection->PeerTransportParams.Flags & QUIC_TP_FLAG_MAX_PACKET_SIZE) &&
             NewDatagramLength > Connection->PeerTransportParams.MaxPacketSize) {
             NewDatagramLength = (uint16_t)Connection->PeerTransportParams.MaxPacketSize;
@@ -248,14 +317,15 @@ QuicPacketBuilderPrepare(
             //
             Builder->MinimumDatagramLength =
                 MaxUdpPayloadSizeForFamily(
-                    QuicAddrGetFamily(&Builder->Path->RemoteAddress),
+                    Builder->PathFamily,
                     QUIC_INITIAL_PACKET_LENGTH);
 
         } else if (IsPathMtuDiscovery) {
             Builder->MinimumDatagramLength = NewDatagramLength;
         }
 
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             PacketBuilderNewDatagram,
             Connection,
             "New UDP datagram. Space: %u",
@@ -281,6 +351,10 @@ QuicPacketBuilderPrepare(
         Builder->Metadata->Flags.IsRetransmittable = FALSE;
         Builder->Metadata->Flags.HasCrypto = FALSE;
         Builder->Metadata->Flags.IsPMTUD = IsPathMtuDiscovery;
+        Builder->Metadata->Flags.EcnEctSet =
+            Connection->Session->Settings.EcnEnabled && !Builder->PathEcnFailed;
+        Builder->Metadata->CachedPayload = NULL;
+        Builder->Metadata->CachedPayloadLength = 0;
 
         Builder->PacketStart = Builder->DatagramLength;
         Builder->HeaderLength = 0;
@@ -303,7 +377,7 @@ QuicPacketBuilderPrepare(
                         &Builder->Path->DestCid->CID,
                         Builder->Metadata->PacketNumber,
                         Builder->PacketNumberLength,
-                        Builder->Path->SpinBit,
+                        Builder->PathSpinBit,
                         PacketSpace->CurrentKeyPhase,
                         BufferSpaceAvailable,
                         Header);
@@ -340,7 +414,8 @@ QuicPacketBuilderPrepare(
 
         Builder->DatagramLength += Builder->HeaderLength;
 
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             PacketBuilderNewPacket,
             Connection,
             "New QUIC packet. Space: %hu. Type: %hx",
@@ -543,6 +618,126 @@ QuicPacketBuilderFinalizeHeaderProtection(
     Builder->BatchCount = 0;
 }
 
+//
+// Encrypts the accumulated batch of short header packets in a single call, so
+// the AEAD implementation can pipeline across them, then finishes the header
+// protection for the batch.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicPacketBuilderFinalizeCrypto(
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    QUIC_DBG_ASSERT(Builder->Key != NULL);
+    QUIC_DBG_ASSERT(Builder->BatchCount != 0);
+
+    QUIC_STATUS Status;
+    if (QUIC_FAILED(
+        Status =
+        QuicEncryptBatch(
+            Builder->Key->PacketKey,
+            Builder->BatchCount,
+            Builder->IvBatch,
+            Builder->HeaderLengthBatch,
+            Builder->PayloadLengthBatch,
+            Builder->HeaderBatch))) {
+        Builder->BatchCount = 0;
+        QuicConnFatalError(Builder->Connection, Status, "Encryption failure");
+        return;
+    }
+
+    uint32_t BatchPayloadBytes = 0;
+    for (uint8_t i = 0; i < Builder->BatchCount; ++i) {
+        BatchPayloadBytes += Builder->PayloadLengthBatch[i];
+    }
+    QuicPerfCounterAdd(QUIC_PERF_COUNTER_TLS_BYTES_ENCRYPTED, BatchPayloadBytes);
+
+    //
+    // Sample the fresh cipher text for the header protection masks. Short
+    // header packets always use a 4 byte packet number, so the sample starts
+    // right at the beginning of the encrypted payload.
+    //
+    for (uint8_t i = 0; i < Builder->BatchCount; ++i) {
+        QuicCopyMemory(
+            Builder->CipherBatch + i * QUIC_HP_SAMPLE_LENGTH,
+            Builder->HeaderBatch[i] + Builder->HeaderLengthBatch[i],
+            QUIC_HP_SAMPLE_LENGTH);
+    }
+
+    QuicPacketBuilderFinalizeHeaderProtection(Builder);
+}
+
+//
+// Returns the path racing the handshake on the alternate local interface, if
+// any.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static
+_Ret_maybenull_
+QUIC_PATH*
+QuicPacketBuilderGetRacingPath(
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    for (uint8_t i = 1; i < Connection->PathsCount; ++i) {
+        if (Connection->Paths[i].IsRacing) {
+            return &Connection->Paths[i];
+        }
+    }
+    return NULL;
+}
+
+//
+// Copies the just-finalized datagram into a send context targeting the
+// racing path's binding, so the same handshake flight goes out both raced
+// interfaces. Best effort: an allocation failure just skips the copy and
+// leaves the primary path's transmission unaffected.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static
+void
+QuicPacketBuilderMirrorDatagram(
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    if (!Builder->Path->IsActive) {
+        return;
+    }
+
+    QUIC_PATH* RacingPath =
+        QuicPacketBuilderGetRacingPath(Builder->Connection);
+    if (RacingPath == NULL) {
+        return;
+    }
+
+    if (Builder->MirrorSendContext == NULL) {
+        Builder->MirrorSendContext =
+            QuicDataPathBindingAllocSendContext(
+                RacingPath->Binding->DatapathBinding,
+                MaxUdpPayloadSizeForFamily(
+                    QuicAddrGetFamily(&RacingPath->RemoteAddress),
+                    RacingPath->Mtu));
+        if (Builder->MirrorSendContext == NULL) {
+            return;
+        }
+    }
+
+    QUIC_BUFFER* MirrorDatagram =
+        QuicDataPathBindingAllocSendDatagram(
+            Builder->MirrorSendContext,
+            Builder->DatagramLength);
+    if (MirrorDatagram == NULL) {
+        return;
+    }
+
+    QuicCopyMemory(
+        MirrorDatagram->Buffer,
+        Builder->Datagram->Buffer,
+        Builder->DatagramLength);
+    MirrorDatagram->Length = Builder->DatagramLength;
+}
+
 //
 // This function completes the current QUIC packet. It updates the header if
 // necessary and encrypts the payload. If there isn't enough space for another
@@ -612,11 +807,18 @@ QuicPacketBuilderFinalize(
 
         if (!FlushBatchedDatagrams && QuicDataPathIsPaddingPreferred(MsQuicLib.Datapath)) {
             //
-            // When buffering multiple datagrams in a single contiguous buffer
-            // (at the datapath layer), all but the last datagram needs to be
-            // fully padded.
+            // For the datapath to hand the whole batch to the NIC as a single
+            // segmented send, all but the last datagram need to be padded to
+            // the same size. That trade is only worth it when the datagram is
+            // already mostly full; padding out a mostly-empty datagram costs
+            // more bytes on the wire than the segmentation saves, so in that
+            // case send it at its natural size and let the datapath fall back
+            // to individual sends.
             //
-            Builder->MinimumDatagramLength = (uint16_t)Builder->Datagram->Length;
+            if (Builder->Datagram->Length - ExpectedFinalDatagramLength <=
+                Builder->Datagram->Length / QUIC_MAX_BATCH_PADDING_DIVISOR) {
+                Builder->MinimumDatagramLength = (uint16_t)Builder->Datagram->Length;
+            }
         }
     }
 
@@ -677,6 +879,29 @@ QuicPacketBuilderFinalize(
             Builder->HeaderLength);
     }
 
+    if (Connection->Session->Settings.RetransmitCacheEnabled &&
+        Builder->PacketType == SEND_PACKET_SHORT_HEADER_TYPE &&
+        Builder->Metadata->Flags.IsRetransmittable &&
+        !Builder->Metadata->Flags.IsPMTUD &&
+        Connection->Send.RetransmitCacheBytes + PayloadLength <=
+            QUIC_RETRANSMIT_CACHE_BUDGET) {
+        //
+        // Keep a copy of the plaintext payload so that if this packet is lost
+        // it can be retransmitted byte-identical (new packet number,
+        // re-encrypt) instead of re-framed from scratch. Best effort: without
+        // the copy, loss just takes the normal re-frame path.
+        //
+        Builder->Metadata->CachedPayload = QUIC_ALLOC_NONPAGED(PayloadLength);
+        if (Builder->Metadata->CachedPayload != NULL) {
+            QuicCopyMemory(
+                Builder->Metadata->CachedPayload,
+                Header + Builder->HeaderLength,
+                PayloadLength);
+            Builder->Metadata->CachedPayloadLength = PayloadLength;
+            Connection->Send.RetransmitCacheBytes += PayloadLength;
+        }
+    }
+
     if (Connection->State.EncryptionEnabled) {
 
         //
@@ -688,47 +913,55 @@ QuicPacketBuilderFinalize(
 
         uint8_t* Payload = Header + Builder->HeaderLength;
 
-        uint8_t Iv[QUIC_IV_LENGTH];
-        QuicCryptoCombineIvAndPacketNumber(Builder->Key->Iv, (uint8_t*) &Builder->Metadata->PacketNumber, Iv);
-
         QUIC_STATUS Status;
-        if (QUIC_FAILED(
-            Status =
-            QuicEncrypt(
-                Builder->Key->PacketKey,
-                Iv,
-                Builder->HeaderLength,
-                Header,
-                PayloadLength,
-                Payload))) {
-            QuicConnFatalError(Connection, Status, "Encryption failure");
-            goto Exit;
-        }
+        if (Builder->PacketType == SEND_PACKET_SHORT_HEADER_TYPE &&
+            Connection->State.HeaderProtectionEnabled) {
+            QUIC_DBG_ASSERT(Builder->BatchCount < QUIC_MAX_CRYPTO_BATCH_COUNT);
 
-        if (Connection->State.HeaderProtectionEnabled) {
+            //
+            // Defer the encryption of short header packets. The whole batch
+            // is encrypted (and header protected) with single calls once it
+            // fills up or the datagrams are flushed, so the AEAD can pipeline
+            // across packets.
+            //
 
-            uint8_t* PnStart = Payload - Builder->PacketNumberLength;
+            QuicCryptoCombineIvAndPacketNumber(
+                Builder->Key->Iv,
+                (uint8_t*)&Builder->Metadata->PacketNumber,
+                Builder->IvBatch + Builder->BatchCount * QUIC_IV_LENGTH);
+            Builder->HeaderBatch[Builder->BatchCount] = Header;
+            Builder->HeaderLengthBatch[Builder->BatchCount] = Builder->HeaderLength;
+            Builder->PayloadLengthBatch[Builder->BatchCount] = PayloadLength;
 
-            if (Builder->PacketType == SEND_PACKET_SHORT_HEADER_TYPE) {
-                QUIC_DBG_ASSERT(Builder->BatchCount < QUIC_MAX_CRYPTO_BATCH_COUNT);
+            if (++Builder->BatchCount == QUIC_MAX_CRYPTO_BATCH_COUNT) {
+                QuicPacketBuilderFinalizeCrypto(Builder);
+            }
 
-                //
-                // Batch the header protection for short header packets.
-                //
+        } else {
 
-                QuicCopyMemory(
-                    Builder->CipherBatch + Builder->BatchCount * QUIC_HP_SAMPLE_LENGTH,
-                    PnStart + 4,
-                    QUIC_HP_SAMPLE_LENGTH);
-                Builder->HeaderBatch[Builder->BatchCount] = Header;
+            uint8_t Iv[QUIC_IV_LENGTH];
+            QuicCryptoCombineIvAndPacketNumber(Builder->Key->Iv, (uint8_t*) &Builder->Metadata->PacketNumber, Iv);
+
+            if (QUIC_FAILED(
+                Status =
+                QuicEncrypt(
+                    Builder->Key->PacketKey,
+                    Iv,
+                    Builder->HeaderLength,
+                    Header,
+                    PayloadLength,
+                    Payload))) {
+                QuicConnFatalError(Connection, Status, "Encryption failure");
+                goto Exit;
+            }
 
-                if (++Builder->BatchCount == QUIC_MAX_CRYPTO_BATCH_COUNT) {
-                    QuicPacketBuilderFinalizeHeaderProtection(Builder);
-                }
+            QuicPerfCounterAdd(QUIC_PERF_COUNTER_TLS_BYTES_ENCRYPTED, PayloadLength);
 
-            } else {
+            if (Connection->State.HeaderProtectionEnabled) {
                 QUIC_DBG_ASSERT(Builder->BatchCount == 0);
 
+                uint8_t* PnStart = Payload - Builder->PacketNumberLength;
+
                 //
                 // Individually do header protection for long header packets as
                 // they generally use different keys.
@@ -769,6 +1002,14 @@ QuicPacketBuilderFinalize(
             !PacketSpace->AwaitingKeyPhaseConfirmation &&
             Connection->State.HandshakeConfirmed) {
 
+            //
+            // The packets in the crypto batch were built for the current key.
+            // Finish them off before rolling over to the new one.
+            //
+            if (Builder->BatchCount != 0) {
+                QuicPacketBuilderFinalizeCrypto(Builder);
+            }
+
             Status = QuicCryptoGenerateNewKeys(Connection);
             if (QUIC_FAILED(Status)) {
                 QuicTraceEvent(
@@ -801,6 +1042,13 @@ QuicPacketBuilderFinalize(
     Builder->Metadata->PacketLength =
         Builder->HeaderLength + PayloadLength;
 
+    QuicPerfCounterIncrement(QUIC_PERF_COUNTER_PKTS_SENT);
+    QuicPerfCounterAdd(
+        QUIC_PERF_COUNTER_BYTES_SENT, Builder->Metadata->PacketLength);
+    if (!Builder->Metadata->Flags.IsRetransmittable) {
+        QuicPerfCounterIncrement(QUIC_PERF_COUNTER_PKTS_ACK_ONLY_SENT);
+    }
+
     QuicTraceEvent(
         ConnPacketSent,
         "[conn][%p][TX][%llu] %hhu (%hu bytes)",
@@ -808,10 +1056,31 @@ QuicPacketBuilderFinalize(
         Builder->Metadata->PacketNumber,
         QuicPacketTraceType(Builder->Metadata),
         Builder->Metadata->PacketLength);
-    QuicLossDetectionOnPacketSent(
-        &Connection->LossDetection,
-        Builder->Path,
-        Builder->Metadata);
+    QuicPerfEventRingWrite(
+        &Connection->Worker->PerfEvents,
+        QUIC_PERF_EVENT_PACKET_SENT,
+        (uint64_t)(uintptr_t)Connection,
+        Builder->Metadata->PacketNumber);
+    QUIC_STATUS Status =
+        QuicLossDetectionOnPacketSent(
+            &Connection->LossDetection,
+            Builder->Path,
+            Builder->Metadata);
+    if (QUIC_FAILED(Status)) {
+        //
+        // Without sent-packet metadata the packet's frames could never be
+        // detected as lost or retransmitted, so the connection can't be
+        // allowed to limp along without it.
+        //
+        QuicTraceEvent(
+            ConnErrorStatus,
+            "[conn][%p] ERROR, %u, %s.",
+            Connection,
+            Status,
+            "Track sent packet");
+        QuicConnFatalError(Connection, Status, "Track sent packet");
+        goto Exit;
+    }
 
     if (Builder->Metadata->Flags.IsRetransmittable) {
         Builder->PacketBatchRetransmittable = TRUE;
@@ -824,10 +1093,31 @@ QuicPacketBuilderFinalize(
         } else {
             Builder->SendAllowance -= Builder->Metadata->PacketLength;
         }
+
+        //
+        // Consume the amplification budget on unvalidated paths. The path's
+        // own allowance is decremented by loss detection above, which also
+        // drives the flow blocked state.
+        //
+        if (Builder->AmplificationBudget != UINT32_MAX) {
+            if ((uint32_t)Builder->Metadata->PacketLength > Builder->AmplificationBudget) {
+                Builder->AmplificationBudget = 0;
+            } else {
+                Builder->AmplificationBudget -= Builder->Metadata->PacketLength;
+            }
+        }
     }
 
 Exit:
 
+    if (Builder->Metadata->CachedPayload != NULL) {
+        //
+        // The packet never made it to loss tracking (encryption or key update
+        // failure), so drop the cached copy.
+        //
+        QuicSendReleaseCachedPayload(&Connection->Send, Builder->Metadata);
+    }
+
     //
     // Send the packet out if necessary.
     //
@@ -835,13 +1125,16 @@ Exit:
     if (FinalQuicPacket) {
         if (Builder->Datagram != NULL) {
             Builder->Datagram->Length = Builder->DatagramLength;
+            if (Connection->State.HandshakeRacing) {
+                QuicPacketBuilderMirrorDatagram(Builder);
+            }
             Builder->Datagram = NULL;
             ++Builder->TotalCountDatagrams;
         }
 
         if (FlushBatchedDatagrams || QuicDataPathBindingIsSendContextFull(Builder->SendContext)) {
             if (Builder->BatchCount != 0) {
-                QuicPacketBuilderFinalizeHeaderProtection(Builder);
+                QuicPacketBuilderFinalizeCrypto(Builder);
             }
             QuicPacketBuilderSendBatch(Builder);
         }
@@ -863,7 +1156,8 @@ QuicPacketBuilderSendBatch(
     _Inout_ QUIC_PACKET_BUILDER* Builder
     )
 {
-    QuicTraceLogConnVerbose(
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_DATAPATH,
         PacketBuilderSendBatch,
         Builder->Connection,
         "Sending batch. %hu datagrams",
@@ -880,9 +1174,28 @@ QuicPacketBuilderSendBatch(
             Builder->Path->Binding,
             &Builder->Path->LocalAddress,
             &Builder->Path->RemoteAddress,
+            &Builder->Path->SendCache,
             Builder->SendContext);
     }
 
+    if (Builder->MirrorSendContext != NULL) {
+        //
+        // Transmit the copies of this batch on the racing path. The racing
+        // binding is always bound to the specific alternate interface.
+        //
+        QUIC_PATH* RacingPath =
+            QuicPacketBuilderGetRacingPath(Builder->Connection);
+        if (RacingPath != NULL) {
+            QuicBindingSendTo(
+                RacingPath->Binding,
+                &RacingPath->RemoteAddress,
+                Builder->MirrorSendContext);
+        } else {
+            QuicDataPathBindingFreeSendContext(Builder->MirrorSendContext);
+        }
+        Builder->MirrorSendContext = NULL;
+    }
+
     Builder->PacketBatchSent = TRUE;
     Builder->SendContext = NULL;
 }
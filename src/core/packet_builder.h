@@ -20,6 +20,18 @@ typedef struct QUIC_PACKET_BUILDER {
     //
     QUIC_PATH* Path;
 
+    //
+    // Read-mostly snapshot of the path state consulted per packet, refreshed
+    // only when the path's version changes. Keeps the per-packet checks to a
+    // single version compare instead of re-walking QUIC_PATH.
+    //
+    uint32_t PathVersion;
+    uint16_t PathMtu;
+    uint16_t PathMtuProbeSize;
+    QUIC_ADDRESS_FAMILY PathFamily;
+    BOOLEAN PathSpinBit;
+    BOOLEAN PathEcnFailed;
+
     //
     // The source connection ID.
     //
@@ -30,6 +42,13 @@ typedef struct QUIC_PACKET_BUILDER {
     //
     QUIC_DATAPATH_SEND_CONTEXT* SendContext;
 
+    //
+    // While the handshake is being raced over two local interfaces, holds
+    // the copies of the built datagrams to also transmit on the racing
+    // path's binding.
+    //
+    QUIC_DATAPATH_SEND_CONTEXT* MirrorSendContext;
+
     //
     // Represents a single UDP payload. Can contain multiple coalesced QUIC
     // packets.
@@ -57,6 +76,19 @@ typedef struct QUIC_PACKET_BUILDER {
     //
     uint8_t* HeaderBatch[QUIC_MAX_CRYPTO_BATCH_COUNT];
 
+    //
+    // IVs for the batched packets, encrypted together in a single call so the
+    // AEAD can pipeline across packets.
+    //
+    uint8_t IvBatch[QUIC_IV_LENGTH * QUIC_MAX_CRYPTO_BATCH_COUNT];
+
+    //
+    // Header and payload lengths of the batched packets. The payload lengths
+    // include the encryption overhead.
+    //
+    uint16_t HeaderLengthBatch[QUIC_MAX_CRYPTO_BATCH_COUNT];
+    uint16_t PayloadLengthBatch[QUIC_MAX_CRYPTO_BATCH_COUNT];
+
     //
     // Indicates a batch of packets has been sent.
     //
@@ -78,6 +110,12 @@ typedef struct QUIC_PACKET_BUILDER {
     //
     uint8_t TotalCountDatagrams;
 
+    //
+    // The maximum number of datagrams to create for a single flush, picked at
+    // initialization from the datapath's supported features.
+    //
+    uint8_t MaxDatagrams;
+
     //
     // The size of the encryption AEAD tag at the end of the current QUIC
     // packet.
@@ -131,6 +169,15 @@ typedef struct QUIC_PACKET_BUILDER {
     //
     uint32_t SendAllowance;
 
+    //
+    // The number of bytes amplification protection still allows on the path.
+    // Snapshotted from the path's allowance at initialization and consumed as
+    // retransmittable packets are finalized, so the whole flight is sized
+    // from one budget instead of re-consulting the path per datagram.
+    // UINT32_MAX once the peer's address has been validated.
+    //
+    uint32_t AmplificationBudget;
+
     //
     // Represents the metadata of the current QUIC packet.
     //
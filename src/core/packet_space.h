@@ -79,6 +79,14 @@ typedef struct QUIC_PACKET_SPACE {
     //
     QUIC_ACK_TRACKER AckTracker;
 
+    //
+    // The running total of ECT-marked packets we have sent that the peer has
+    // acknowledged, and the largest CE count the peer has reported, used for
+    // ECN validation and congestion response.
+    //
+    uint64_t EcnEctCounter;
+    uint64_t EcnCeCounter;
+
     //
     // Packet number of the first sent packet of the current key phase.
     //
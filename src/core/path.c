@@ -25,6 +25,7 @@ QuicPathInitialize(
     QuicZeroMemory(Path, sizeof(QUIC_PATH));
     Path->ID = Connection->NextPathId++; // TODO - Check for duplicates after wrap around?
     Path->MinRtt = UINT32_MAX;
+    Path->WindowedMinRtt = UINT32_MAX;
     Path->Mtu = QUIC_DEFAULT_PATH_MTU;
     if (Connection->Session != NULL) {
         Path->SmoothedRtt = MS_TO_US(Connection->Session->Settings.InitialRttMs);
@@ -127,15 +128,266 @@ QuicPathSetValid(
         ReasonStrings[Reason]);
 
     Path->IsPeerValidated = TRUE;
+    QuicPathBumpVersion(Path);
     QuicPathSetAllowance(Connection, Path, UINT32_MAX);
 
     if (Path->IsPeerValidated && Reason == QUIC_PATH_VALID_PATH_RESPONSE) {
         //
-        // If the active path was just validated, then let's queue up a PMTUD
-        // packet.
+        // If the active path was just validated, then start searching for the
+        // path's MTU.
+        //
+        QuicPathMtuDiscoveryStart(Connection, Path);
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathUpdateMinRttWindow(
+    _Inout_ QUIC_PATH* Path,
+    _In_ uint32_t TimeNow,
+    _In_ uint32_t LatestRtt
+    )
+{
+    //
+    // Drop samples that can never be the window minimum again: anything at
+    // least as large as the new sample. This keeps the entries monotonically
+    // increasing from the head.
+    //
+    while (Path->MinRttWindowCount != 0) {
+        uint8_t Newest =
+            (Path->MinRttWindowHead + Path->MinRttWindowCount - 1) %
+                QUIC_MIN_RTT_WINDOW_LENGTH;
+        if (Path->MinRttWindow[Newest].Rtt < LatestRtt) {
+            break;
+        }
+        Path->MinRttWindowCount--;
+    }
+
+    if (Path->MinRttWindowCount == QUIC_MIN_RTT_WINDOW_LENGTH) {
+        //
+        // No room for the new sample. Replace the newest (largest) entry so
+        // the window minimum is preserved.
+        //
+        Path->MinRttWindowCount--;
+    }
+
+    uint8_t Insert =
+        (Path->MinRttWindowHead + Path->MinRttWindowCount) %
+            QUIC_MIN_RTT_WINDOW_LENGTH;
+    Path->MinRttWindow[Insert].Time = TimeNow;
+    Path->MinRttWindow[Insert].Rtt = LatestRtt;
+    Path->MinRttWindowCount++;
+
+    //
+    // Age out samples older than the window, always keeping at least the
+    // sample just added.
+    //
+    while (Path->MinRttWindowCount > 1 &&
+        QuicTimeDiff32(
+            Path->MinRttWindow[Path->MinRttWindowHead].Time,
+            TimeNow) > QUIC_MIN_RTT_WINDOW) {
+        Path->MinRttWindowHead =
+            (Path->MinRttWindowHead + 1) % QUIC_MIN_RTT_WINDOW_LENGTH;
+        Path->MinRttWindowCount--;
+    }
+
+    Path->WindowedMinRtt = Path->MinRttWindow[Path->MinRttWindowHead].Rtt;
+}
+
+//
+// Returns the next MTU to probe for: half way between the current MTU and the
+// largest MTU still worth probing for, rounded up so the probe is always
+// larger than the current MTU.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+static
+uint16_t
+QuicPathMtuDiscoveryNextProbeSize(
+    _In_ const QUIC_PATH* Path
+    )
+{
+    return Path->Mtu + (Path->MtuMaxProbeSize - Path->Mtu + 1) / 2;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+static
+void
+QuicPathMtuDiscoveryComplete(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    )
+{
+    Path->MtuSearchComplete = TRUE;
+    Path->MtuSearchCompleteTime = QuicTimeUs64();
+    QuicTraceLogConnInfo(
+        PathMtuSearchComplete,
+        Connection,
+        "Path[%hhu] MTU search complete at %hu bytes",
+        Path->ID,
+        Path->Mtu);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathMtuDiscoveryStart(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    )
+{
+    QUIC_DBG_ASSERT(Path->IsPeerValidated);
+
+    //
+    // When the datapath can send jumbo sized datagrams, probe all the way up
+    // to jumbo frame sizes; whether they fit through the path is exactly what
+    // the search discovers.
+    //
+    uint16_t MaxMtu =
+        (QuicDataPathGetSupportedFeatures(MsQuicLib.Datapath) &
+            QUIC_DATAPATH_FEATURE_JUMBO_SEND) ?
+            QUIC_MAX_JUMBO_MTU : QUIC_MAX_MTU;
+
+    //
+    // The peer's max_packet_size transport parameter limits what it is
+    // willing to receive, so don't probe past that.
+    //
+    if ((Connection->PeerTransportParams.Flags & QUIC_TP_FLAG_MAX_PACKET_SIZE) &&
+        Connection->PeerTransportParams.MaxPacketSize < UINT16_MAX) {
+        uint16_t PeerMtu =
+            PacketSizeFromUdpPayloadSize(
+                QuicAddrGetFamily(&Path->RemoteAddress),
+                (uint16_t)Connection->PeerTransportParams.MaxPacketSize);
+        if (PeerMtu < MaxMtu) {
+            MaxMtu = PeerMtu;
+        }
+    }
+
+    Path->MtuMaxProbeSize = MaxMtu;
+    Path->MtuProbeCount = 0;
+
+    if (Path->Mtu + QUIC_DPLPMTUD_MIN_STEP > Path->MtuMaxProbeSize) {
+        //
+        // Nothing meaningful left to probe for.
+        //
+        QuicPathMtuDiscoveryComplete(Connection, Path);
+        return;
+    }
+
+    Path->MtuSearchComplete = FALSE;
+    Path->MtuProbeSize = QuicPathMtuDiscoveryNextProbeSize(Path);
+    QuicPathBumpVersion(Path);
+
+    QuicTraceLogConnInfo(
+        PathMtuProbing,
+        Connection,
+        "Path[%hhu] Probing MTU of %hu bytes",
+        Path->ID,
+        Path->MtuProbeSize);
+
+    QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_PMTUD);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicPathMtuDiscoveryProbeAcked(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path,
+    _In_ const QUIC_SENT_PACKET_METADATA* Packet
+    )
+{
+    uint16_t AckedMtu =
+        PacketSizeFromUdpPayloadSize(
+            QuicAddrGetFamily(&Path->RemoteAddress),
+            Packet->PacketLength);
+    if (AckedMtu <= Path->Mtu) {
+        //
+        // A stale probe from an earlier (smaller) search step.
+        //
+        return;
+    }
+
+    Path->Mtu = AckedMtu;
+    QuicPathBumpVersion(Path);
+    QuicTraceLogConnInfo(
+        PathMtuUpdated,
+        Connection,
+        "Path[%hhu] MTU updated to %u bytes",
+        Path->ID,
+        Path->Mtu);
+
+    if (Path == &Connection->Paths[0]) {
+        //
+        // Let the app know the usable payload per packet grew, so it can
+        // resize its writes to the new packet boundary.
+        //
+        QuicConnIndicatePacketPayloadChanged(Connection);
+    }
+
+    if (Path->MtuSearchComplete) {
+        return;
+    }
+
+    Path->MtuProbeCount = 0;
+    if (Path->Mtu + QUIC_DPLPMTUD_MIN_STEP > Path->MtuMaxProbeSize) {
+        QuicPathMtuDiscoveryComplete(Connection, Path);
+        return;
+    }
+
+    Path->MtuProbeSize = QuicPathMtuDiscoveryNextProbeSize(Path);
+    QuicPathBumpVersion(Path);
+    QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_PMTUD);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathMtuDiscoveryProbeLost(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    )
+{
+    if (Path->MtuSearchComplete) {
+        return;
+    }
+
+    if (++Path->MtuProbeCount < QUIC_DPLPMTUD_MAX_PROBE_RETRIES) {
+        //
+        // Retry the same probe size a few times before giving up on it, since
+        // the loss may have had nothing to do with the packet's size.
         //
         QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_PMTUD);
+        return;
+    }
+
+    //
+    // The probe size doesn't fit through the path. Lower the search ceiling
+    // below it and continue the search downward.
+    //
+    Path->MtuMaxProbeSize = Path->MtuProbeSize - 1;
+    Path->MtuProbeCount = 0;
+
+    if (Path->Mtu + QUIC_DPLPMTUD_MIN_STEP > Path->MtuMaxProbeSize) {
+        QuicPathMtuDiscoveryComplete(Connection, Path);
+        return;
     }
+
+    Path->MtuProbeSize = QuicPathMtuDiscoveryNextProbeSize(Path);
+    QuicPathBumpVersion(Path);
+    QuicSendSetSendFlag(&Connection->Send, QUIC_CONN_SEND_FLAG_PMTUD);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathMtuDiscoveryCheckRaiseTimeout(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    )
+{
+    if (!Path->MtuSearchComplete ||
+        QuicTimeDiff64(Path->MtuSearchCompleteTime, QuicTimeUs64()) <
+            QUIC_DPLPMTUD_RAISE_TIMEOUT) {
+        return;
+    }
+
+    QuicPathMtuDiscoveryStart(Connection, Path);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -154,6 +406,58 @@ QuicConnGetPathByID(
     return NULL;
 }
 
+//
+// Carries the RTT, MTU and peer validation state over from a path whose
+// remote IP address has already been validated. Used when the peer's address
+// changes only by UDP port (i.e. a NAT rebinding), so the "new" path is
+// almost certainly the same physical path and doesn't need to start from
+// scratch with a validation round trip and default estimates.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static
+void
+QuicPathInheritValidatedState(
+    _In_ QUIC_CONNECTION* Connection,
+    _Inout_ QUIC_PATH* Path,
+    _In_ const QUIC_PATH* Source
+    )
+{
+    //
+    // The IP address itself was recently validated, so skipping the
+    // amplification protection phase for the rebound tuple is safe; a path
+    // challenge still gets sent to confirm the peer owns the new tuple.
+    //
+    Path->IsPeerValidated = TRUE;
+    Path->Allowance = UINT32_MAX;
+
+    Path->GotFirstRttSample = Source->GotFirstRttSample;
+    Path->SmoothedRtt = Source->SmoothedRtt;
+    Path->MinRtt = Source->MinRtt;
+    Path->MaxRtt = Source->MaxRtt;
+    Path->RttVariance = Source->RttVariance;
+    Path->LatestRttSample = Source->LatestRttSample;
+    QuicCopyMemory(
+        Path->MinRttWindow, Source->MinRttWindow, sizeof(Path->MinRttWindow));
+    Path->MinRttWindowHead = Source->MinRttWindowHead;
+    Path->MinRttWindowCount = Source->MinRttWindowCount;
+    Path->WindowedMinRtt = Source->WindowedMinRtt;
+
+    Path->Mtu = Source->Mtu;
+    Path->MtuProbeSize = Source->MtuProbeSize;
+    Path->MtuMaxProbeSize = Source->MtuMaxProbeSize;
+    Path->MtuProbeCount = Source->MtuProbeCount;
+    Path->MtuSearchComplete = Source->MtuSearchComplete;
+    Path->MtuSearchCompleteTime = Source->MtuSearchCompleteTime;
+    QuicPathBumpVersion(Path);
+
+    QuicTraceLogConnInfo(
+        PathRebindInherited,
+        Connection,
+        "Path[%hhu] Inherited validated state from Path[%hhu] (NAT rebind)",
+        Path->ID,
+        Source->ID);
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 _Ret_maybenull_
 QUIC_PATH*
@@ -206,6 +510,23 @@ QuicConnGetPathForDatagram(
     Path->LocalAddress = Datagram->Tuple->LocalAddress;
     Path->RemoteAddress = Datagram->Tuple->RemoteAddress;
 
+    //
+    // If the peer's new address only differs by UDP port from a path that is
+    // already validated, this is a NAT rebinding rather than a genuine new
+    // path, so don't restart validation and the estimates from scratch.
+    //
+    for (uint8_t i = 0; i < Connection->PathsCount; ++i) {
+        const QUIC_PATH* Other = &Connection->Paths[i];
+        if (Other != Path &&
+            Other->IsPeerValidated &&
+            QuicAddrGetFamily(&Other->RemoteAddress) ==
+                QuicAddrGetFamily(&Path->RemoteAddress) &&
+            QuicAddrCompareIp(&Other->RemoteAddress, &Path->RemoteAddress)) {
+            QuicPathInheritValidatedState(Connection, Path, Other);
+            break;
+        }
+    }
+
     return Path;
 }
 
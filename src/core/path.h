@@ -5,6 +5,8 @@
 
 --*/
 
+typedef struct QUIC_SENT_PACKET_METADATA QUIC_SENT_PACKET_METADATA;
+
 //
 // Represents all the per-path information of a connection.
 //
@@ -57,11 +59,58 @@ typedef struct QUIC_PATH {
     //
     BOOLEAN SendResponse : 1;
 
+    //
+    // Indicates the path MTU discovery search has completed (either because
+    // it converged or because probing isn't possible yet).
+    //
+    BOOLEAN MtuSearchComplete : 1;
+
+    //
+    // Indicates ECN validation failed on this path (the peer or network is
+    // dropping, bleaching or misreporting the marks), so packets are no
+    // longer marked ECT.
+    //
+    BOOLEAN EcnFailed : 1;
+
+    //
+    // This path is the alternate local interface the client handshake is
+    // being raced over. Only set while the connection's HandshakeRacing
+    // state is active; cleared if the path wins the race.
+    //
+    BOOLEAN IsRacing : 1;
+
+    //
+    // Incremented whenever send-relevant state on the path (addresses, MTU,
+    // validity, spin/ECN bits) changes, so consumers caching a snapshot of
+    // that state can revalidate it with a single compare. Gives path state a
+    // coherent publication point for the send path.
+    //
+    uint32_t Version;
+
     //
     // The currently calculated path MTU.
     //
     uint16_t Mtu;
 
+    //
+    // The MTU currently being probed for and the largest MTU still worth
+    // probing for. Only valid while the search is in progress.
+    //
+    uint16_t MtuProbeSize;
+    uint16_t MtuMaxProbeSize;
+
+    //
+    // The number of times the current probe size has been sent without being
+    // acknowledged.
+    //
+    uint8_t MtuProbeCount;
+
+    //
+    // The time (in us) the MTU search last completed. Used to periodically
+    // restart the search in case the path starts supporting a larger MTU.
+    //
+    uint64_t MtuSearchCompleteTime;
+
     //
     // The binding used for sending/receiving UDP packets.
     //
@@ -77,6 +126,13 @@ typedef struct QUIC_PATH {
     //
     QUIC_ADDR RemoteAddress;
 
+    //
+    // The cached, preformatted datapath send headers for this path. Must be
+    // invalidated (via QuicPathInvalidateSendCache) whenever either of the
+    // path's addresses changes.
+    //
+    QUIC_DATAPATH_SEND_CACHE SendCache;
+
     //
     // The destination CID used for sending on this path.
     //
@@ -98,6 +154,21 @@ typedef struct QUIC_PATH {
     uint32_t RttVariance;
     uint32_t LatestRttSample;
 
+    //
+    // Windowed minimum RTT filter. The entries form an increasing sequence
+    // (a monotonic deque) of the RTT samples that are still candidates to be
+    // the minimum over the last QUIC_MIN_RTT_WINDOW; the head entry holds the
+    // current windowed minimum. Unlike MinRtt, this estimate ages out, so it
+    // recovers after a route change.
+    //
+    struct {
+        uint32_t Time; // microsec
+        uint32_t Rtt; // microsec
+    } MinRttWindow[QUIC_MIN_RTT_WINDOW_LENGTH];
+    uint8_t MinRttWindowHead; // Index of the oldest (minimum) entry.
+    uint8_t MinRttWindowCount;
+    uint32_t WindowedMinRtt;
+
     //
     // The last path challenge we received and needs to be sent back as in a
     // PATH_RESPONSE frame.
@@ -112,9 +183,36 @@ typedef struct QUIC_PATH {
 } QUIC_PATH;
 
 QUIC_STATIC_ASSERT(
-    sizeof(QUIC_PATH) < 256,
+    sizeof(QUIC_PATH) < 384,
     "Ensure path struct stays small since we prealloc them");
 
+//
+// Marks the path's send-relevant state as changed. Must be called whenever a
+// field the packet builder snapshots is updated.
+//
+inline
+void
+QuicPathBumpVersion(
+    _In_ QUIC_PATH* Path
+    )
+{
+    Path->Version++;
+}
+
+//
+// Invalidates the cached datapath send headers for the path. Must be called
+// whenever either of the path's addresses changes.
+//
+inline
+void
+QuicPathInvalidateSendCache(
+    _In_ QUIC_PATH* Path
+    )
+{
+    Path->SendCache.IsPrepared = FALSE;
+    QuicPathBumpVersion(Path);
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicPathInitialize(
@@ -185,6 +283,60 @@ QuicPathSetActive(
     _In_ QUIC_PATH* Path
     );
 
+//
+// Feeds the latest RTT sample into the path's windowed minimum RTT filter.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathUpdateMinRttWindow(
+    _Inout_ QUIC_PATH* Path,
+    _In_ uint32_t TimeNow,
+    _In_ uint32_t LatestRtt
+    );
+
+//
+// Starts (or restarts) the path MTU discovery search on the path.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathMtuDiscoveryStart(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    );
+
+//
+// Invoked when an MTU probe packet was acknowledged by the peer. May
+// indicate a PACKET_PAYLOAD_CHANGED event to the application.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicPathMtuDiscoveryProbeAcked(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path,
+    _In_ const QUIC_SENT_PACKET_METADATA* Packet
+    );
+
+//
+// Invoked when an MTU probe packet was determined to be lost.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathMtuDiscoveryProbeLost(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    );
+
+//
+// Restarts the MTU discovery search if enough time has passed since the last
+// one completed.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPathMtuDiscoveryCheckRaiseTimeout(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_PATH* Path
+    );
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 _Ret_maybenull_
 QUIC_PATH*
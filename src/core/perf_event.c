@@ -0,0 +1,88 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    The always-on, per-worker ring buffer of binary performance events. See
+    perf_event.h for the synchronization scheme.
+
+--*/
+
+#include "precomp.h"
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPerfEventRingWrite(
+    _Inout_ QUIC_PERF_EVENT_RING* Ring,
+    _In_ QUIC_PERF_EVENT_TYPE Type,
+    _In_ uint64_t Context,
+    _In_ uint64_t Value
+    )
+{
+    int64_t Sequence = InterlockedIncrement64(&Ring->WriteSequence);
+    QUIC_PERF_EVENT* Event =
+        &Ring->Events[(uint64_t)Sequence % QUIC_PERF_EVENT_RING_LENGTH];
+
+    Event->Timestamp = QuicTimeUs64();
+    Event->Context = Context;
+    Event->Value = Value;
+    Event->Type = (uint32_t)Type;
+    Event->Reserved = 0;
+
+    //
+    // Publish the event. The interlocked operation is a full barrier, so the
+    // payload stores above are visible before the new sequence number is. The
+    // slot is exclusively owned between the claim and here unless the ring
+    // wrapped a whole lap in that window, in which case the reader's sequence
+    // validation discards the torn slot.
+    //
+    InterlockedExchangeAdd64(&Event->Sequence, Sequence - Event->Sequence);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicPerfEventRingRead(
+    _In_ const QUIC_PERF_EVENT_RING* Ring,
+    _Inout_ int64_t* ReadSequence,
+    _Out_writes_to_(Count, return)
+        QUIC_PERF_EVENT* Events,
+    _In_ uint32_t Count
+    )
+{
+    //
+    // Snapshot the most recently claimed sequence number. Events claimed
+    // after this point are left for the next read.
+    //
+    int64_t WriteSequence = *(volatile const int64_t*)&Ring->WriteSequence;
+
+    int64_t Sequence = *ReadSequence + 1;
+    if (WriteSequence - Sequence >= QUIC_PERF_EVENT_RING_LENGTH) {
+        //
+        // The reader has fallen at least a full ring behind. Skip ahead past
+        // the events that have already been overwritten.
+        //
+        Sequence = WriteSequence - QUIC_PERF_EVENT_RING_LENGTH + 1;
+    }
+
+    uint32_t EventsRead = 0;
+    while (Sequence <= WriteSequence && EventsRead < Count) {
+        const QUIC_PERF_EVENT* Slot =
+            &Ring->Events[(uint64_t)Sequence % QUIC_PERF_EVENT_RING_LENGTH];
+        Events[EventsRead] = *Slot;
+        //
+        // Only keep the copy if the slot still holds the expected sequence
+        // number; otherwise a writer lapped the reader while it was copying
+        // and the payload can't be trusted.
+        //
+        if (Events[EventsRead].Sequence == Sequence &&
+            *(volatile const int64_t*)&Slot->Sequence == Sequence) {
+            EventsRead++;
+        }
+        Sequence++;
+    }
+
+    *ReadSequence = Sequence - 1;
+    return EventsRead;
+}
@@ -0,0 +1,64 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+--*/
+
+//
+// A lock-free ring buffer of fixed-size binary performance events
+// (QUIC_PERF_EVENT, defined in msquicp.h). Each worker owns one ring. Writers
+// claim a slot with a single interlocked increment and publish the event by
+// storing its sequence number last, which keeps logging cheap enough to leave
+// enabled in production, independent of whether the platform tracing in
+// quic_trace.h is compiled in. Readers validate each slot's sequence number
+// after copying it, dropping the (rare) events that were overwritten
+// mid-copy.
+//
+typedef struct QUIC_PERF_EVENT_RING {
+
+    //
+    // The sequence number of the most recently claimed slot. The slot for
+    // sequence number N is Events[N % QUIC_PERF_EVENT_RING_LENGTH]. Sequence
+    // numbers start at 1, so a zeroed slot is never mistaken for a published
+    // event.
+    //
+    int64_t WriteSequence;
+
+    //
+    // The event slots. A slot is valid once its Sequence field matches the
+    // sequence number it was claimed for.
+    //
+    QUIC_PERF_EVENT Events[QUIC_PERF_EVENT_RING_LENGTH];
+
+} QUIC_PERF_EVENT_RING;
+
+//
+// Logs a single event to the ring, overwriting the oldest event if the ring
+// is full. Callable from any thread.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicPerfEventRingWrite(
+    _Inout_ QUIC_PERF_EVENT_RING* Ring,
+    _In_ QUIC_PERF_EVENT_TYPE Type,
+    _In_ uint64_t Context,
+    _In_ uint64_t Value
+    );
+
+//
+// Copies the events published after *ReadSequence into the caller's buffer,
+// oldest first, and updates *ReadSequence to the last sequence number
+// consumed. If the caller has fallen more than a full ring behind, the events
+// that have already been overwritten are silently skipped. Returns the number
+// of events copied.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+uint32_t
+QuicPerfEventRingRead(
+    _In_ const QUIC_PERF_EVENT_RING* Ring,
+    _Inout_ int64_t* ReadSequence,
+    _Out_writes_to_(Count, return)
+        QUIC_PERF_EVENT* Events,
+    _In_ uint32_t Count
+    );
@@ -55,9 +55,12 @@ extern "C" {
 #include "frame.h"
 #include "packet.h"
 #include "sent_packet_metadata.h"
+#include "perf_event.h"
 #include "worker.h"
 #include "ack_tracker.h"
 #include "packet_space.h"
+#include "cubic.h"
+#include "bbr.h"
 #include "congestion_control.h"
 #include "loss_detection.h"
 #include "send.h"
@@ -65,6 +68,7 @@ extern "C" {
 #include "crypto.h"
 #include "stream.h"
 #include "stream_set.h"
+#include "datagram.h"
 #include "connection.h"
 #include "packet_builder.h"
 #include "listener.h"
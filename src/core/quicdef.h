@@ -45,17 +45,31 @@ typedef struct QUIC_PATH QUIC_PATH;
 #define QUIC_AMPLIFICATION_RATIO                3
 
 //
-// The max expected reordering in terms of number of packets
-// (for FACK loss detection).
+// The initial expected reordering in terms of number of packets
+// (for FACK loss detection). The threshold adapts upward when larger
+// reordering is actually observed on the path.
 //
 #define QUIC_PACKET_REORDER_THRESHOLD           3
 
+//
+// The cap for the adaptive packet reorder threshold. Reordering beyond this
+// is left to the (RACK) time threshold to sort out, so a pathological path
+// can't defer packet based loss detection indefinitely.
+//
+#define QUIC_PACKET_REORDER_THRESHOLD_MAX       128
+
 //
 // The max expected reordering in terms of time
 // (for RACK loss detection).
 //
 #define QUIC_TIME_REORDER_THRESHOLD(rtt)        ((rtt) + ((rtt) / 8))
 
+//
+// How long the delivery rate estimate may rest on a single large sample
+// before a smaller (non app-limited) sample is allowed to replace it.
+//
+#define QUIC_DELIVERY_RATE_WINDOW_US            (1 * 1000 * 1000)
+
 //
 // Number of consecutive PTOs after which the network is considered to be
 // experiencing persistent congestion.
@@ -76,15 +90,61 @@ typedef struct QUIC_PATH QUIC_PATH;
 
 //
 // The minimum number of ACK eliciting packets to receive before overriding ACK
-// delay.
+// delay. Used as the default packet tolerance until the peer updates it with
+// an ACK_FREQUENCY frame.
 //
 #define QUIC_MIN_ACK_SEND_NUMBER                2
 
+//
+// The number of ACKs the peer is asked to send per congestion window of
+// packets, used to calculate the packet tolerance carried in ACK_FREQUENCY
+// frames.
+//
+#define QUIC_ACK_FREQUENCY_WINDOW_DIVISOR       4
+
+//
+// The length of time (in microseconds) over which the windowed minimum RTT
+// filter keeps samples. Samples older than this age out, so the estimate
+// recovers after a route change, unlike the lifetime minimum.
+//
+#define QUIC_MIN_RTT_WINDOW                     S_TO_US(10)
+
+//
+// The maximum number of candidate samples kept by the windowed minimum RTT
+// filter.
+//
+#define QUIC_MIN_RTT_WINDOW_LENGTH              5
+
+//
+// The value of the max_datagram_frame_size transport parameter we advertise
+// when the app enables datagram receives. A single packet limits the usable
+// size well below this, so it doesn't constrain the peer in practice.
+//
+#define QUIC_DEFAULT_MAX_DATAGRAM_FRAME_SIZE    65535
+
+//
+// The number of shards in the server resumption ticket cache. Must be a power
+// of two.
+//
+#define QUIC_SERVER_TICKET_SHARD_COUNT          16
+
+//
+// The default maximum number of entries, across all shards, in the server
+// resumption ticket cache.
+//
+#define QUIC_DEFAULT_SERVER_TICKET_CACHE_CAPACITY 4096
+
 //
 // The size of the stateless reset token.
 //
 #define QUIC_STATELESS_RESET_TOKEN_LENGTH       16
 
+//
+// The number of slots in the per-binding cache of previously generated
+// stateless reset tokens. Must be a power of two.
+//
+#define QUIC_STATELESS_RESET_TOKEN_CACHE_SIZE   64
+
 //
 // The minimum length for a stateless reset packet.
 //
@@ -113,17 +173,65 @@ typedef struct QUIC_PATH QUIC_PATH;
 //
 #define QUIC_MAX_PARTITION_COUNT                64
 
+//
+// Maximum number of entries in the app-supplied processor list that worker
+// and datapath threads are pinned to (QUIC_PARAM_GLOBAL_PROCESSOR_LIST).
+//
+#define QUIC_MAX_PROCESSOR_LIST_LENGTH          64
+
 //
 // The fraction ((0 to UINT16_MAX) / UINT16_MAX) of memory that must be
 // exhausted before enabling retry.
 //
 #define QUIC_DEFAULT_RETRY_MEMORY_FRACTION      65 // ~0.1%
 
+//
+// The fraction ((0 to UINT16_MAX) / UINT16_MAX) of memory the library's
+// receive and send buffers may consume before memory pressure mode kicks in:
+// receive window grants stop growing, oversized idle windows shrink and the
+// workers' pool depots are trimmed.
+//
+#define QUIC_DEFAULT_BUFFER_MEMORY_FRACTION     16384 // ~25%
+
 //
 // The maximum amount of queue delay a worker should take on (in ms).
 //
 #define QUIC_MAX_WORKER_QUEUE_DELAY             250
 
+//
+// The number of binary performance events each worker's ring buffer holds.
+// Must be a power of two.
+//
+#define QUIC_PERF_EVENT_RING_LENGTH             1024
+
+//
+// The number of received packets each QUIC_PERF_EVENT_RX_STAGES perf event
+// averages the per-stage receive costs over, while packet stage profiling
+// is enabled.
+//
+#define QUIC_RX_STAGE_PROFILE_WINDOW            64
+
+//
+// The number of entries a worker thread warms each of its pools with at
+// startup, so the backing memory gets first-touched on the worker's own NUMA
+// node.
+//
+#define QUIC_MAX_WORKER_POOL_PREWARM            16
+
+//
+// How long a worker thread busy-polls its queues for new work before parking
+// on its ready event (in us). Avoids a futex wake and context switch per
+// burst under steady load. Zero disables the spin phase.
+//
+#define QUIC_DEFAULT_WORKER_IDLE_SPIN_US        20
+
+//
+// The idle spin duration (in us) for workers of a registration opened with
+// the real-time execution profile, used when it is larger than the global
+// default.
+//
+#define QUIC_WORKER_IDLE_SPIN_US_REAL_TIME      100
+
 //
 // The maximum number of simultaneous stateless operations that can be queued on
 // a single worker.
@@ -136,18 +244,81 @@ typedef struct QUIC_PATH QUIC_PATH;
 //
 #define QUIC_MAX_BINDING_STATELESS_OPERATIONS   100
 
+//
+// Per-class token bucket parameters for admitting stateless responses on the
+// datapath threads, in responses per second and maximum saved-up burst.
+// Stateless resets are the most valuable class under flood (they let
+// legitimate peers tear down connections we no longer know about), retries
+// next, and version negotiation least.
+//
+#define QUIC_STATELESS_ADMIT_RATE_VER_NEG       100
+#define QUIC_STATELESS_ADMIT_BURST_VER_NEG      20
+#define QUIC_STATELESS_ADMIT_RATE_RETRY         1000
+#define QUIC_STATELESS_ADMIT_BURST_RETRY        200
+#define QUIC_STATELESS_ADMIT_RATE_RESET         4000
+#define QUIC_STATELESS_ADMIT_BURST_RESET        800
+
+//
+// The number of shards the binding's stateless operation tracking is split
+// into. Must be a power of two.
+//
+#define QUIC_STATELESS_OPER_SHARD_COUNT         8
+
 //
 // The number of milliseconds we keep an entry in the binding stateless
 // operation table before removing it.
 //
 #define QUIC_STATELESS_OPERATION_EXPIRATION_MS  100
 
+//
+// The number of stateless responses (version negotiation and stateless reset)
+// a binding may build directly on the datapath threads per refill period, and
+// the length of that period. This token bucket is what bounds the work a
+// flood of unmatched packets can generate.
+//
+#define QUIC_STATELESS_RESPONSE_BUCKET_TOKENS   128
+#define QUIC_STATELESS_RESPONSE_BUCKET_PERIOD_MS 100
+
 //
 // The maximum number of operations a connection will drain from its queue per
 // call to QuicConnDrainOperations.
 //
 #define QUIC_MAX_OPERATIONS_PER_DRAIN           16
 
+//
+// The default number of shared client bindings to spray connections across
+// when no explicit local address is given. Zero disables spray mode, giving
+// each client connection its own (exclusive) binding.
+//
+#define QUIC_DEFAULT_CLIENT_PORT_SPRAY_COUNT    0
+
+//
+// Execution profile overrides for the drain batch size. Bulk profiles drain
+// more operations per connection visit to amortize the scheduling overhead;
+// the real-time profile drains fewer so that no single connection can hold
+// the worker thread for long.
+//
+#define QUIC_MAX_OPERATIONS_PER_DRAIN_BULK      64
+#define QUIC_MAX_OPERATIONS_PER_DRAIN_REAL_TIME 4
+
+//
+// The maximum number of extra drain quanta a persistently backlogged
+// connection can accumulate via the drain deficit, i.e. its batch tops out
+// at (1 + this) times MaxOperationsPerDrain.
+//
+#define QUIC_MAX_DRAIN_DEFICIT_QUANTA           3
+
+//
+// Time budgets (in microseconds) bounding how long a single connection can
+// hold a worker thread. The drain budget caps one whole call to
+// QuicConnDrainOperations regardless of how many operations the count budget
+// would still allow. The operation slice caps a single oversized flush
+// operation (send flush or stream receive flush), which yields and requeues
+// itself so the worker's other connections get the thread in between.
+//
+#define QUIC_MAX_DRAIN_TIME_US                  1000
+#define QUIC_OPERATION_TIME_SLICE_US            500
+
 //
 // Used as a hint for the maximum number of UDP datagrams to send for each
 // FLUSH_SEND operation. The actual number will generally exceed this value up
@@ -155,17 +326,62 @@ typedef struct QUIC_PATH QUIC_PATH;
 //
 #define QUIC_MAX_DATAGRAMS_PER_SEND             245
 
+//
+// The datagram hint used instead when the datapath doesn't support send
+// segmentation. Each datagram is then an individual message on the wire, so
+// large batches just multiply syscalls and hold the connection on the worker
+// longer.
+//
+#define QUIC_MAX_DATAGRAMS_PER_SEND_UNSEGMENTED 64
+
 //
 // The number of packets we write for a single stream before going to the next
 // one in the round robin.
 //
 #define QUIC_STREAM_SEND_BATCH_COUNT            8
 
+//
+// The number of streams of each type the stream set indexes directly by ID.
+// Streams with larger IDs fall back to the hash table lookup.
+//
+#define QUIC_STREAM_SET_DIRECT_COUNT            16
+
+//
+// The maximum number of closed stream objects a connection caches for reuse,
+// so workloads that open and close a stream per request don't pay the
+// stream's receive buffer and ACK range allocations on every open.
+//
+#define QUIC_STREAM_RECYCLE_CACHE_SIZE          8
+
 //
 // The maximum number of received packets to batch process at a time.
 //
 #define QUIC_MAX_RECEIVE_BATCH_COUNT            32
 
+//
+// The maximum number of streams indicated in a single batched receive event.
+//
+#define QUIC_MAX_BATCHED_RECEIVE_COUNT          8
+
+//
+// The maximum number of send requests indicated in a single batched send
+// complete event.
+//
+#define QUIC_MAX_BATCHED_SEND_COMPLETE_COUNT    32
+
+//
+// The number of received ACK blocks that can be decoded on the stack. Frames
+// with more blocks than this take the slower, heap-backed decode path.
+//
+#define QUIC_MAX_ACK_BLOCKS_STACK_DECODE        64
+
+//
+// The initial size (in entries) of the packet-number-indexed ring of
+// outstanding sent packets. Doubled whenever the tracked packet number window
+// outgrows it.
+//
+#define QUIC_INITIAL_SENT_PACKETS_SIZE          256
+
 //
 // The maximum number of crypto operations to batch.
 //
@@ -214,6 +430,12 @@ typedef struct QUIC_PATH QUIC_PATH;
 //
 #define QUIC_MAX_RANGE_ALLOC_SIZE               0x100000    // 1084576
 #define QUIC_MAX_RANGE_DUPLICATE_PACKETS        0x1000      // 4096
+
+//
+// The number of recent packet numbers covered by the ack tracker's duplicate
+// detection bitmap. Must be a power of two and a multiple of 64.
+//
+#define QUIC_DUPLICATE_PACKET_BITMAP_SIZE       4096
 #define QUIC_MAX_RANGE_ACK_PACKETS              0x800       // 2048
 #define QUIC_MAX_RANGE_DECODE_ACKS              0x1000      // 4096
 
@@ -228,6 +450,24 @@ QUIC_STATIC_ASSERT(IS_POWER_OF_TWO(QUIC_MAX_RANGE_DECODE_ACKS), L"Must be power
 //
 #define QUIC_DEFAULT_PATH_MTU                   QUIC_MIN_MTU
 
+//
+// The number of probe packets lost at a given probe size before path MTU
+// discovery concludes the size doesn't fit and lowers its search ceiling.
+//
+#define QUIC_DPLPMTUD_MAX_PROBE_RETRIES         3
+
+//
+// The smallest MTU increase worth probing for. When the gap between the
+// current MTU and the search ceiling drops below this, the search completes.
+//
+#define QUIC_DPLPMTUD_MIN_STEP                  64
+
+//
+// The amount of time (in microseconds) to wait after a path MTU search
+// completes before probing again, in case the path now supports a larger MTU.
+//
+#define QUIC_DPLPMTUD_RAISE_TIMEOUT             S_TO_US(600)
+
 //
 // The maximum time an app callback can take before we log a warning.
 // Apps should generally take less than a millisecond for each callback if at
@@ -275,12 +515,56 @@ QUIC_STATIC_ASSERT(
 //
 #define QUIC_DEFAULT_KEEP_ALIVE_INTERVAL        0
 
+//
+// The maximum multiple of the configured keep alive interval that the
+// effective interval may adaptively grow to, while keep alives keep
+// eliciting a response at the longer spacing.
+//
+#define QUIC_KEEP_ALIVE_EXTENSION_LIMIT         8
+
+//
+// The default idle period (in milliseconds) after which a connected
+// connection hibernates: it releases memory that only matters while traffic
+// is flowing (retransmit cache, grown receive buffers) and rehydrates
+// lazily on the next packet. Zero disables hibernation.
+//
+#define QUIC_DEFAULT_HIBERNATION_IDLE_TIMEOUT   0
+
 //
 // The flow control window is doubled when more than (1 / ratio) of the current
 // window is delivered to the app within 1 RTT.
 //
 #define QUIC_RECV_BUFFER_DRAIN_RATIO            2
 
+//
+// Multiple of the measured bandwidth-delay product the stream receive window
+// is tuned to. The window is sized to the next power of two at or above
+// (delivery rate * min RTT * multiplier), so it stops limiting throughput
+// without committing the maximum window to every stream.
+//
+#define QUIC_RECV_BUFFER_BDP_MULTIPLIER         2
+
+//
+// A stream's receive window is only shrunk when the tuning target falls to
+// (1 / ratio) of the current window or lower, to keep transient dips in the
+// app's absorb rate from thrashing the window size.
+//
+#define QUIC_RECV_BUFFER_SHRINK_RATIO           4
+
+//
+// Below the drain threshold, a flow control update is only worth a packet of
+// its own once the peer's remaining send allowance falls under (1 / ratio) of
+// the stream's receive window. Above that, the update is queued but rides
+// along with the next packet sent for any other reason.
+//
+#define QUIC_RECV_WINDOW_UPDATE_RATIO           4
+
+//
+// The receive window tuning logic runs when the drain threshold is hit or,
+// for slowly draining streams, at least this many microseconds apart.
+//
+#define QUIC_RECV_BUFFER_TUNING_INTERVAL_US     (250 * 1000)
+
 //
 // The default value for send buffering being enabled or not.
 //
@@ -315,6 +599,15 @@ QUIC_STATIC_ASSERT(
 //
 #define QUIC_MIN_PACKET_SPARE_SPACE             64
 
+//
+// The largest fraction (expressed as a divisor) of a batched datagram that
+// will be spent on padding just to keep the batch's datagrams uniformly
+// sized for segmented sends. A datagram that would need more padding than
+// this goes out at its natural size instead, and the datapath falls back to
+// individual sends for the batch.
+//
+#define QUIC_MAX_BATCH_PADDING_DIVISOR          4
+
 //
 // The maximum number of paths a single connection will keep track of.
 //
@@ -338,6 +631,11 @@ QUIC_STATIC_ASSERT(
 //
 #define QUIC_DEFAULT_SEND_PACING                TRUE
 
+//
+// The default congestion control algorithm.
+//
+#define QUIC_DEFAULT_CONGESTION_CONTROL_ALGORITHM QUIC_CONGESTION_CONTROL_ALGORITHM_CUBIC
+
 //
 // The number of milliseconds between pacing chunks.
 //
@@ -348,6 +646,13 @@ QUIC_STATIC_ASSERT(
 //
 #define QUIC_SEND_PACING_MIN_CHUNK              4u
 
+//
+// The maximum number of packets to burst per pacing chunk. Matches the
+// largest send batch the datapath can put on the wire at once, so pacing
+// never releases more than the NIC can serialize back to back.
+//
+#define QUIC_SEND_PACING_MAX_BURST              32u
+
 //
 // The maximum number of bytes to send in a given key phase
 // before performing a key phase update. Roughly, 274GB.
@@ -363,6 +668,15 @@ QUIC_STATIC_ASSERT(
 // The scaling factor used locally for AckDelay field in the ACK_FRAME.
 //
 #define QUIC_ACK_DELAY_EXPONENT                 8
+
+//
+// The extra time (in microseconds) a delayed ACK with no outbound data to
+// carry it waits for data to piggyback on before being flushed standalone.
+// Disabled by default; request-response workloads can enable it to cut
+// ACK-only packet volume.
+//
+#define QUIC_DEFAULT_ACK_PIGGYBACK_DELAY_US     0
+
 //
 // The length of the client initial packets sent. Instead of the required min of
 // 1200 we send the full 1280 to give the server more credit to overcome
@@ -386,6 +700,49 @@ QUIC_STATIC_ASSERT(
 //
 #define QUIC_DEFAULT_LOAD_BALANCING_MODE        QUIC_LOAD_BALANCING_DISABLED
 
+//
+// The default value for marking sent packets ECN capable. Disabled by
+// default because networks that bleach or drop marked packets still exist;
+// an app or admin opts in where the path is known good.
+//
+#define QUIC_DEFAULT_ECN_ENABLED                FALSE
+
+//
+// The default value for keeping plaintext payload copies of in-flight packets
+// so lost packets can be retransmitted byte-identical instead of re-framed.
+//
+#define QUIC_DEFAULT_RETRANSMIT_CACHE_ENABLED   FALSE
+
+//
+// The default value for draining a connection's operation queue directly on
+// the datapath thread that received for it, when that thread serves the
+// connection's partition, instead of always handing off to the worker thread.
+// Disabled by default; only supported where datapath receive callbacks run at
+// passive level.
+//
+#define QUIC_DEFAULT_INLINE_DATAPATH_RECV       FALSE
+
+//
+// The default value for handing completed send batches to the datapath
+// thread instead of performing the socket syscall on the worker thread, so
+// encrypting the next batch overlaps with writing the previous one. Disabled
+// by default; only supported by datapaths that send inline.
+//
+#define QUIC_DEFAULT_DEFERRED_SEND_ENABLED      FALSE
+
+//
+// Whether the datapath threads poll for work with a zero timeout instead of
+// blocking in the kernel. Burns the whole core, so only sensible when the
+// threads are pinned to isolated cores dedicated to packet processing.
+//
+#define QUIC_DEFAULT_DATAPATH_BUSY_POLL         FALSE
+
+//
+// The maximum number of payload bytes a connection may have cached for
+// byte-identical retransmission at any one time.
+//
+#define QUIC_RETRANSMIT_CACHE_BUDGET            0x20000 // 128 KB
+
 /*************************************************************
                   PERSISTENT SETTINGS
 *************************************************************/
@@ -394,21 +751,31 @@ QUIC_STATIC_ASSERT(
 
 #define QUIC_SETTING_MAX_PARTITION_COUNT        "MaxPartitionCount"
 #define QUIC_SETTING_RETRY_MEMORY_FRACTION      "RetryMemoryFraction"
+#define QUIC_SETTING_BUFFER_MEMORY_FRACTION     "BufferMemoryFraction"
 #define QUIC_SETTING_LOAD_BALANCING_MODE        "LoadBalancingMode"
 #define QUIC_SETTING_MAX_WORKER_QUEUE_DELAY     "MaxWorkerQueueDelayMs"
+#define QUIC_SETTING_WORKER_IDLE_SPIN_US        "WorkerIdleSpinUs"
 #define QUIC_SETTING_MAX_STATELESS_OPERATIONS   "MaxStatelessOperations"
 #define QUIC_SETTING_MAX_OPERATIONS_PER_DRAIN   "MaxOperationsPerDrain"
+#define QUIC_SETTING_CLIENT_PORT_SPRAY_COUNT    "ClientPortSprayCount"
 
 #define QUIC_SETTING_SEND_PACING_DEFAULT        "SendPacingDefault"
 #define QUIC_SETTING_MIGRATION_ENABLED          "MigrationEnabled"
+#define QUIC_SETTING_ECN_ENABLED                "EcnEnabled"
+#define QUIC_SETTING_RETRANSMIT_CACHE_ENABLED   "RetransmitCacheEnabled"
+#define QUIC_SETTING_INLINE_DATAPATH_RECV       "InlineDatapathRecvEnabled"
+#define QUIC_SETTING_DEFERRED_SEND_ENABLED      "DeferredSendEnabled"
+#define QUIC_SETTING_DATAPATH_BUSY_POLL         "DatapathBusyPollEnabled"
 
 #define QUIC_SETTING_INITIAL_WINDOW_PACKETS     "InitialWindowPackets"
 #define QUIC_SETTING_SEND_IDLE_TIMEOUT_MS       "SendIdleTimeoutMs"
 
 #define QUIC_SETTING_INITIAL_RTT                "InitialRttMs"
 #define QUIC_SETTING_MAX_ACK_DELAY              "MaxAckDelayMs"
+#define QUIC_SETTING_ACK_PIGGYBACK_DELAY        "AckPiggybackDelayUs"
 #define QUIC_SETTING_DISCONNECT_TIMEOUT         "DisconnectTimeoutMs"
 #define QUIC_SETTING_KEEP_ALIVE_INTERVAL        "KeepAliveIntervalMs"
+#define QUIC_SETTING_HIBERNATION_IDLE_TIMEOUT   "HibernationIdleTimeoutMs"
 #define QUIC_SETTING_IDLE_TIMEOUT               "IdleTimeoutMs"
 #define QUIC_SETTING_HANDSHAKE_IDLE_TIMEOUT     "HandshakeIdleTimeoutMs"
 
@@ -419,3 +786,5 @@ QUIC_STATIC_ASSERT(
 #define QUIC_SETTING_CONN_FLOW_CONTROL_WINDOW   "ConnFlowControlWindow"
 
 #define QUIC_SETTING_MAX_BYTES_PER_KEY_PHASE    "MaxBytesPerKey"
+
+#define QUIC_SETTING_CONGESTION_CONTROL_ALGORITHM "CongestionControlAlgorithm"
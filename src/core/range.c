@@ -12,8 +12,6 @@ Abstract:
 
 #include "precomp.h"
 
-#define INITIAL_SUBRANGE_COUNT 8
-
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QuicRangeInitialize(
@@ -22,18 +20,15 @@ QuicRangeInitialize(
     )
 {
     Range->UsedLength = 0;
-    Range->AllocLength = INITIAL_SUBRANGE_COUNT;
+    Range->AllocLength = QUIC_RANGE_INITIAL_SUB_COUNT;
     Range->MaxAllocSize = MaxAllocSize;
-    QUIC_FRE_ASSERT(sizeof(QUIC_SUBRANGE) * INITIAL_SUBRANGE_COUNT < MaxAllocSize);
-    Range->SubRanges = QUIC_ALLOC_NONPAGED(sizeof(QUIC_SUBRANGE) * INITIAL_SUBRANGE_COUNT);
-    if (Range->SubRanges == NULL) {
-        QuicTraceEvent(
-            AllocFailure,
-            "Allocation of '%s' failed. (%llu bytes)",
-            "range",
-            sizeof(QUIC_SUBRANGE) * INITIAL_SUBRANGE_COUNT);
-    }
-    return (Range->SubRanges == NULL) ? QUIC_STATUS_OUT_OF_MEMORY : QUIC_STATUS_SUCCESS;
+    QUIC_FRE_ASSERT(sizeof(Range->PreAllocSubRanges) <= MaxAllocSize);
+    //
+    // Start out on the inline array. The heap isn't touched until the range
+    // outgrows it, which the overwhelmingly-sequential common case never does.
+    //
+    Range->SubRanges = Range->PreAllocSubRanges;
+    return QUIC_STATUS_SUCCESS;
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -42,7 +37,9 @@ QuicRangeUninitialize(
     _In_ QUIC_RANGE* Range
     )
 {
-    QUIC_FREE(Range->SubRanges);
+    if (Range->SubRanges != Range->PreAllocSubRanges) {
+        QUIC_FREE(Range->SubRanges);
+    }
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -112,7 +109,9 @@ QuicRangeGrow(
             (Range->UsedLength - NextIndex) * sizeof(QUIC_SUBRANGE));
     }
 
-    QUIC_FREE(Range->SubRanges);
+    if (Range->SubRanges != Range->PreAllocSubRanges) {
+        QUIC_FREE(Range->SubRanges);
+    }
     Range->SubRanges = NewSubRanges;
     Range->AllocLength = NewAllocLength;
     Range->UsedLength++; // For the next write index.
@@ -194,14 +193,21 @@ QuicRangeRemoveSubranges(
     Range->UsedLength -= Count;
 
     BOOLEAN Reallocated = FALSE;
-    if (Range->AllocLength >= INITIAL_SUBRANGE_COUNT * 2 &&
+    if (Range->AllocLength > QUIC_RANGE_INITIAL_SUB_COUNT &&
         Range->UsedLength < Range->AllocLength / 4) {
         //
-        // Shrink
+        // Shrink. Once small enough, move back onto the inline array and give
+        // the heap allocation up entirely.
         //
         uint32_t NewAllocLength = Range->AllocLength / 2;
-        QUIC_SUBRANGE* NewSubRanges =
-            QUIC_ALLOC_NONPAGED(sizeof(QUIC_SUBRANGE) * NewAllocLength);
+        QUIC_SUBRANGE* NewSubRanges;
+        if (NewAllocLength <= QUIC_RANGE_INITIAL_SUB_COUNT) {
+            NewAllocLength = QUIC_RANGE_INITIAL_SUB_COUNT;
+            NewSubRanges = Range->PreAllocSubRanges;
+        } else {
+            NewSubRanges =
+                QUIC_ALLOC_NONPAGED(sizeof(QUIC_SUBRANGE) * NewAllocLength);
+        }
         if (NewSubRanges != NULL) {
             memcpy(
                 NewSubRanges,
@@ -382,6 +388,59 @@ QuicRangeAddValue(
     return QuicRangeAddRange(Range, Value, 1, &DontCare) != NULL;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicRangeAddRanges(
+    _Inout_ QUIC_RANGE* Range,
+    _In_reads_(Count) const QUIC_SUBRANGE* Subs,
+    _In_ uint32_t Count
+    )
+{
+    //
+    // Reserve room for the worst case (nothing merges) up front so the loop
+    // below allocates at most once, instead of once per doubling. Failing to
+    // reserve (or hitting the allocation cap) isn't fatal; the per-subrange
+    // inserts grow and age out values as usual.
+    //
+    uint32_t NewAllocLength = Range->AllocLength;
+    while (NewAllocLength < Range->UsedLength + Count &&
+           NewAllocLength < QUIC_MAX_RANGE_ALLOC_SIZE &&
+           (NewAllocLength << 1) * sizeof(QUIC_SUBRANGE) <= Range->MaxAllocSize) {
+        NewAllocLength <<= 1;
+    }
+    if (NewAllocLength != Range->AllocLength) {
+        QUIC_SUBRANGE* NewSubRanges =
+            QUIC_ALLOC_NONPAGED(sizeof(QUIC_SUBRANGE) * NewAllocLength);
+        if (NewSubRanges != NULL) {
+            memcpy(
+                NewSubRanges,
+                Range->SubRanges,
+                Range->UsedLength * sizeof(QUIC_SUBRANGE));
+            if (Range->SubRanges != Range->PreAllocSubRanges) {
+                QUIC_FREE(Range->SubRanges);
+            }
+            Range->SubRanges = NewSubRanges;
+            Range->AllocLength = NewAllocLength;
+        }
+    }
+
+    //
+    // The input is sorted ascending, so each insert lands at (or merges into)
+    // the tail, which QuicRangeAddRange handles without searching.
+    //
+    BOOLEAN DontCare;
+    for (uint32_t i = 0; i < Count; i++) {
+        QUIC_DBG_ASSERT(i == 0 || Subs[i].Low > QuicRangeGetHigh(&Subs[i - 1]));
+        if (QuicRangeAddRange(
+                Range, Subs[i].Low, Subs[i].Count, &DontCare) == NULL) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Success_(return != FALSE)
 BOOLEAN
@@ -8,6 +8,13 @@
 #define QUIC_RANGE_NO_MAX_ALLOC_SIZE    UINT32_MAX
 #define QUIC_RANGE_USE_BINARY_SEARCH    1
 
+//
+// Number of subranges stored directly inside the QUIC_RANGE structure. Most
+// ranges (in-order streams, well-behaved ACK trackers) never use more than a
+// few subranges, so this avoids touching the heap in the common case.
+//
+#define QUIC_RANGE_INITIAL_SUB_COUNT    4
+
 typedef struct QUIC_SUBRANGE {
 
     uint64_t Low;
@@ -61,6 +68,13 @@ typedef struct QUIC_RANGE {
     _Field_range_(sizeof(QUIC_SUBRANGE), sizeof(QUIC_SUBRANGE) * QUIC_MAX_RANGE_ALLOC_SIZE)
     uint32_t MaxAllocSize;
 
+    //
+    // Inline storage used for the 'SubRanges' array until it outgrows it.
+    // N.B. Because 'SubRanges' may point here, the structure must not be
+    // copied or relocated once initialized.
+    //
+    QUIC_SUBRANGE PreAllocSubRanges[QUIC_RANGE_INITIAL_SUB_COUNT];
+
 } QUIC_RANGE;
 
 //
@@ -271,6 +285,48 @@ QuicRangeAddValue(
     _In_ uint64_t Value
     );
 
+//
+// O(1) fast path for fully in-order insertion: when the range is empty or
+// collapsed to a single subrange starting at zero (no gap has ever been left
+// open) and the new values overlap or abut its end, the subrange is simply
+// extended like a high-water mark, with no search or insert. Returns the
+// extended subrange, or NULL when the insertion isn't sequential, in which
+// case nothing was modified and QuicRangeAddRange must be used instead.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Success_(return != NULL)
+inline
+QUIC_SUBRANGE*
+QuicRangeExtendSequential(
+    _Inout_ QUIC_RANGE* Range,
+    _In_ uint64_t LowValue,
+    _In_ uint64_t Count
+    )
+{
+    if (QuicRangeSize(Range) == 0) {
+        if (LowValue == 0) {
+            //
+            // The inline subrange storage is always at least one deep, so
+            // the first subrange can be claimed without any allocation.
+            //
+            QUIC_SUBRANGE* Sub = QuicRangeGet(Range, 0);
+            Sub->Low = 0;
+            Sub->Count = Count;
+            Range->UsedLength = 1;
+            return Sub;
+        }
+    } else if (QuicRangeSize(Range) == 1) {
+        QUIC_SUBRANGE* Sub = QuicRangeGet(Range, 0);
+        if (Sub->Low == 0 &&
+            LowValue <= Sub->Count &&
+            LowValue + Count > Sub->Count) {
+            Sub->Count = LowValue + Count;
+            return Sub;
+        }
+    }
+    return NULL;
+}
+
 //
 // O(n)      when QUIC_RANGE_USE_BINARY_SEARCH == 0
 // O(log(n)) when QUIC_RANGE_USE_BINARY_SEARCH == 1
@@ -287,6 +343,21 @@ QuicRangeAddRange(
     _Out_ BOOLEAN* RangeUpdated
     );
 
+//
+// Merges an array of subranges, sorted ascending and disjoint, into the
+// range. Space for the worst case (nothing merges) is reserved up front, so
+// the whole operation performs at most one allocation. Returns TRUE if
+// successful or FALSE on an allocation failure.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicRangeAddRanges(
+    _Inout_ QUIC_RANGE* Range,
+    _In_reads_(Count) const QUIC_SUBRANGE* Subs,
+    _In_ uint32_t Count
+    );
+
 //
 // Removes a number of subranges from the range. Returns TRUE if the list was
 // shrunk (reallocated) because of the removal operation.
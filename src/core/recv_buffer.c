@@ -40,17 +40,57 @@ Abstract:
 
     Currently, only growing the virtual buffer length is supported.
 
+    The description above applies to the single and circular modes, which back
+    the buffer with one contiguous allocation. The multiple mode instead backs
+    it with a list of linked chunks: growth appends a new chunk (doubling the
+    total allocation) and drains retire fully consumed chunks, so bytes are
+    only ever copied once, on write. Reads in this mode return one buffer per
+    chunk spanned by the contiguous data.
+
 --*/
 
 #include "precomp.h"
 
+//
+// Allocates a new chunk of the given size, appends it to the chunk list and
+// adds its size to the total allocation.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Success_(return != NULL)
+QUIC_RECV_CHUNK*
+QuicRecvChunkAlloc(
+    _Inout_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint32_t AllocLength,
+    _In_ uint64_t StartOffset
+    )
+{
+    QUIC_RECV_CHUNK* Chunk =
+        QUIC_ALLOC_NONPAGED(sizeof(QUIC_RECV_CHUNK) + AllocLength);
+    if (Chunk == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "recv_buffer chunk",
+            sizeof(QUIC_RECV_CHUNK) + AllocLength);
+        return NULL;
+    }
+
+    Chunk->StartOffset = StartOffset;
+    Chunk->AllocLength = AllocLength;
+    QuicListInsertTail(&RecvBuffer->Chunks, &Chunk->Link);
+    RecvBuffer->AllocBufferLength += AllocLength;
+    QuicLibraryOnBufferMemoryChange(AllocLength);
+
+    return Chunk;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QuicRecvBufferInitialize(
     _Inout_ QUIC_RECV_BUFFER* RecvBuffer,
     _In_ uint32_t AllocBufferLength,
     _In_ uint32_t VirtualBufferLength,
-    _In_ BOOLEAN CopyOnDrain
+    _In_ QUIC_RECV_BUF_MODE Mode
     )
 {
     QUIC_STATUS Status;
@@ -59,15 +99,29 @@ QuicRecvBufferInitialize(
     QUIC_DBG_ASSERT(VirtualBufferLength != 0 && (VirtualBufferLength & (VirtualBufferLength - 1)) == 0); // Power of 2
     QUIC_DBG_ASSERT(AllocBufferLength <= VirtualBufferLength);
 
-    RecvBuffer->Buffer = QUIC_ALLOC_NONPAGED(AllocBufferLength);
-    if (RecvBuffer->Buffer == NULL) {
-        QuicTraceEvent(
-            AllocFailure,
-            "Allocation of '%s' failed. (%llu bytes)",
-            "recv_buffer",
-            AllocBufferLength);
-        Status = QUIC_STATUS_OUT_OF_MEMORY;
-        goto Error;
+    RecvBuffer->Mode = Mode;
+    RecvBuffer->Buffer = NULL;
+    RecvBuffer->AllocBufferLength = 0;
+    QuicListInitializeHead(&RecvBuffer->Chunks);
+
+    if (Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+        if (QuicRecvChunkAlloc(RecvBuffer, AllocBufferLength, 0) == NULL) {
+            Status = QUIC_STATUS_OUT_OF_MEMORY;
+            goto Error;
+        }
+    } else {
+        RecvBuffer->Buffer = QUIC_ALLOC_NONPAGED(AllocBufferLength);
+        if (RecvBuffer->Buffer == NULL) {
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "recv_buffer",
+                AllocBufferLength);
+            Status = QUIC_STATUS_OUT_OF_MEMORY;
+            goto Error;
+        }
+        RecvBuffer->AllocBufferLength = AllocBufferLength;
+        QuicLibraryOnBufferMemoryChange(AllocBufferLength);
     }
 
     Status =
@@ -80,16 +134,26 @@ QuicRecvBufferInitialize(
             "Allocation of '%s' failed. (%llu bytes)",
             "recv_buffer written ranged",
             QUIC_MAX_RANGE_ALLOC_SIZE);
-        QUIC_FREE(RecvBuffer->Buffer);
+        QuicLibraryOnBufferMemoryChange(-(int64_t)RecvBuffer->AllocBufferLength);
+        if (RecvBuffer->Buffer != NULL) {
+            QUIC_FREE(RecvBuffer->Buffer);
+        }
+        while (!QuicListIsEmpty(&RecvBuffer->Chunks)) {
+            QUIC_FREE(
+                QUIC_CONTAINING_RECORD(
+                    QuicListRemoveHead(&RecvBuffer->Chunks),
+                    QUIC_RECV_CHUNK,
+                    Link));
+        }
         goto Error;
     }
 
-    RecvBuffer->AllocBufferLength = AllocBufferLength;
     RecvBuffer->VirtualBufferLength = VirtualBufferLength;
     RecvBuffer->BufferStart = 0;
     RecvBuffer->BaseOffset = 0;
-    RecvBuffer->CopyOnDrain = CopyOnDrain;
     RecvBuffer->ExternalBufferReference = FALSE;
+    RecvBuffer->ReadPendingCount = 0;
+    RecvBuffer->ReadPendingLength = 0;
     RecvBuffer->OldBuffer = NULL;
     Status = QUIC_STATUS_SUCCESS;
 
@@ -105,8 +169,18 @@ QuicRecvBufferUninitialize(
     )
 {
     QuicRangeUninitialize(&RecvBuffer->WrittenRanges);
-    QUIC_FREE(RecvBuffer->Buffer);
-    RecvBuffer->Buffer = NULL;
+    QuicLibraryOnBufferMemoryChange(-(int64_t)RecvBuffer->AllocBufferLength);
+    if (RecvBuffer->Buffer != NULL) {
+        QUIC_FREE(RecvBuffer->Buffer);
+        RecvBuffer->Buffer = NULL;
+    }
+    while (!QuicListIsEmpty(&RecvBuffer->Chunks)) {
+        QUIC_FREE(
+            QUIC_CONTAINING_RECORD(
+                QuicListRemoveHead(&RecvBuffer->Chunks),
+                QUIC_RECV_CHUNK,
+                Link));
+    }
     if (RecvBuffer->OldBuffer != NULL) {
         QUIC_FREE(RecvBuffer->OldBuffer);
         RecvBuffer->OldBuffer = NULL;
@@ -155,6 +229,8 @@ QuicRecvBufferResize(
 {
     QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
 
+    QUIC_DBG_ASSERT(RecvBuffer->Mode != QUIC_RECV_BUF_MODE_MULTIPLE);
+
     //
     // First check whether there is any work to do (since shrinks
     // can be deferred, a shrink request might be followed immediately
@@ -194,6 +270,8 @@ QuicRecvBufferResize(
             QUIC_FREE(RecvBuffer->Buffer);
         }
 
+        QuicLibraryOnBufferMemoryChange(
+            (int64_t)TargetBufferLength - (int64_t)RecvBuffer->AllocBufferLength);
         RecvBuffer->Buffer = NewBuffer;
         RecvBuffer->AllocBufferLength = TargetBufferLength;
         RecvBuffer->BufferStart = 0;
@@ -211,10 +289,98 @@ QuicRecvBufferSetVirtualBufferLength(
     _In_ uint32_t NewLength
     )
 {
-    QUIC_FRE_ASSERT(NewLength >= RecvBuffer->VirtualBufferLength); // Don't support decrease yet.
+    QUIC_FRE_ASSERT(NewLength >= RecvBuffer->AllocBufferLength);
     RecvBuffer->VirtualBufferLength = NewLength;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicRecvBufferShrink(
+    _In_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint32_t TargetBufferLength
+    )
+{
+    if (RecvBuffer->ExternalBufferReference ||
+        RecvBuffer->AllocBufferLength <= TargetBufferLength ||
+        QuicRecvBufferHasUnreadData(RecvBuffer)) {
+        return FALSE;
+    }
+
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+        //
+        // With nothing buffered the drain path has already retired all but
+        // one chunk, but that survivor keeps its grown size. Allocate the
+        // small replacement first (so the chunk list is never left empty on
+        // failure) and then free the old chunk(s).
+        //
+        QUIC_LIST_ENTRY* OldEntry = RecvBuffer->Chunks.Flink;
+        QUIC_RECV_CHUNK* NewChunk =
+            QuicRecvChunkAlloc(
+                RecvBuffer, TargetBufferLength, RecvBuffer->BaseOffset);
+        if (NewChunk == NULL) {
+            return FALSE;
+        }
+        while (OldEntry != &NewChunk->Link) {
+            QUIC_RECV_CHUNK* Chunk =
+                QUIC_CONTAINING_RECORD(OldEntry, QUIC_RECV_CHUNK, Link);
+            OldEntry = OldEntry->Flink;
+            QuicListEntryRemove(&Chunk->Link);
+            RecvBuffer->AllocBufferLength -= Chunk->AllocLength;
+            QuicLibraryOnBufferMemoryChange(-(int64_t)Chunk->AllocLength);
+            QUIC_FREE(Chunk);
+        }
+        return TRUE;
+    }
+
+    return QUIC_SUCCEEDED(QuicRecvBufferResize(RecvBuffer, TargetBufferLength));
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicRecvBufferReset(
+    _Inout_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint32_t AllocBufferLength,
+    _In_ uint32_t VirtualBufferLength
+    )
+{
+    QUIC_DBG_ASSERT(!RecvBuffer->ExternalBufferReference);
+    QUIC_DBG_ASSERT(RecvBuffer->ReadPendingCount == 0);
+
+    if (RecvBuffer->OldBuffer != NULL) {
+        QUIC_FREE(RecvBuffer->OldBuffer);
+        RecvBuffer->OldBuffer = NULL;
+    }
+
+    QuicRangeReset(&RecvBuffer->WrittenRanges);
+    RecvBuffer->BaseOffset = 0;
+    RecvBuffer->BufferStart = 0;
+    RecvBuffer->ReadPendingLength = 0;
+
+    //
+    // Release any growth beyond the default allocation. If the shrink fails
+    // (allocation failure) the buffer just stays at its grown size.
+    //
+    QuicRecvBufferShrink(RecvBuffer, AllocBufferLength);
+
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+        //
+        // Rebase the surviving chunk(s) to the start of the stream.
+        //
+        uint64_t Offset = 0;
+        for (QUIC_LIST_ENTRY* Entry = RecvBuffer->Chunks.Flink;
+            Entry != &RecvBuffer->Chunks;
+            Entry = Entry->Flink) {
+            QUIC_RECV_CHUNK* Chunk =
+                QUIC_CONTAINING_RECORD(Entry, QUIC_RECV_CHUNK, Link);
+            Chunk->StartOffset = Offset;
+            Offset += Chunk->AllocLength;
+        }
+    }
+
+    RecvBuffer->VirtualBufferLength =
+        max(VirtualBufferLength, RecvBuffer->AllocBufferLength);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicRecvBufferHasUnreadData(
@@ -235,6 +401,58 @@ QuicRecvBufferAlreadyReadData(
     return BufferOffset + BufferLength <= RecvBuffer->BaseOffset;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicRecvBufferDeliveredInline(
+    _In_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint64_t BufferOffset,
+    _In_ uint64_t BufferLength
+    )
+{
+    QUIC_DBG_ASSERT(BufferLength != 0);
+    QUIC_DBG_ASSERT(!RecvBuffer->ExternalBufferReference);
+    QUIC_DBG_ASSERT(RecvBuffer->ReadPendingCount == 0);
+    QUIC_DBG_ASSERT(BufferOffset == RecvBuffer->BaseOffset);
+    QUIC_DBG_ASSERT(!QuicRecvBufferHasUnreadData(RecvBuffer));
+
+    //
+    // The write is contiguous with everything already below the base offset,
+    // so it just extends the front subrange and cannot fail to allocate.
+    //
+    QUIC_SUBRANGE* UpdatedRange =
+        QuicRangeExtendSequential(
+            &RecvBuffer->WrittenRanges,
+            BufferOffset,
+            BufferLength);
+    if (UpdatedRange == NULL) {
+        BOOLEAN WrittenRangesUpdated;
+        UpdatedRange =
+            QuicRangeAddRange(
+                &RecvBuffer->WrittenRanges,
+                BufferOffset,
+                BufferLength,
+                &WrittenRangesUpdated);
+        QUIC_DBG_ASSERT(UpdatedRange != NULL);
+    }
+    UNREFERENCED_PARAMETER(UpdatedRange);
+
+    RecvBuffer->BaseOffset += BufferLength;
+
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+        //
+        // Keep the (sole) chunk rebased to the new front of the buffer, the
+        // same as a drain of everything would have.
+        //
+        QUIC_DBG_ASSERT(RecvBuffer->Chunks.Flink == RecvBuffer->Chunks.Blink);
+        QUIC_RECV_CHUNK* Chunk =
+            QUIC_CONTAINING_RECORD(
+                RecvBuffer->Chunks.Flink, QUIC_RECV_CHUNK, Link);
+        Chunk->StartOffset = RecvBuffer->BaseOffset;
+    } else {
+        RecvBuffer->BufferStart = 0;
+    }
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QuicRecvBufferWrite(
@@ -300,7 +518,49 @@ QuicRecvBufferWrite(
     // Check to see if the input buffer is trying to write beyond the
     // currently allocated length.
     //
-    if (AbsoluteLength > RecvBuffer->BaseOffset + RecvBuffer->AllocBufferLength) {
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+
+        //
+        // Make room for the new data by appending chunks. Each new chunk is
+        // the size of the current total allocation (doubling it), and the
+        // existing chunks (and any external references into them) are left
+        // untouched.
+        //
+        QUIC_RECV_CHUNK* LastChunk =
+            QUIC_CONTAINING_RECORD(
+                RecvBuffer->Chunks.Blink, QUIC_RECV_CHUNK, Link);
+        uint64_t AllocEnd = LastChunk->StartOffset + LastChunk->AllocLength;
+        while (AbsoluteLength > AllocEnd) {
+            uint32_t NewChunkLength = RecvBuffer->AllocBufferLength;
+            if (QuicRecvChunkAlloc(RecvBuffer, NewChunkLength, AllocEnd) == NULL) {
+                Status = QUIC_STATUS_OUT_OF_MEMORY;
+                goto Error;
+            }
+            AllocEnd += NewChunkLength;
+        }
+
+    } else if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_SINGLE &&
+        AbsoluteLength >
+            RecvBuffer->BaseOffset + RecvBuffer->AllocBufferLength - RecvBuffer->BufferStart &&
+        AbsoluteLength <= RecvBuffer->BaseOffset + RecvBuffer->AllocBufferLength &&
+        !RecvBuffer->ExternalBufferReference) {
+
+        //
+        // The write doesn't fit in the space left after the (lazily advanced)
+        // start of the data, but does fit in the allocation. Perform the
+        // compaction that was deferred by the drain path. This can't be done
+        // while external code holds a reference into the buffer; in that case
+        // the reallocating grow path below is taken instead.
+        //
+        QuicMoveMemory(
+            RecvBuffer->Buffer,
+            RecvBuffer->Buffer + RecvBuffer->BufferStart,
+            QuicRecvBufferGetSpan(RecvBuffer));
+        RecvBuffer->BufferStart = 0;
+
+    } else if (AbsoluteLength >
+            RecvBuffer->BaseOffset + RecvBuffer->AllocBufferLength -
+            (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_SINGLE ? RecvBuffer->BufferStart : 0)) {
 
         //
         // Make room for the new data.
@@ -319,14 +579,27 @@ QuicRecvBufferWrite(
     }
 
     //
-    // Set the input range as a valid written range.
+    // Set the input range as a valid written range. Almost all stream data
+    // arrives perfectly in order, which keeps the written ranges collapsed
+    // to a single subrange at zero, so the O(1) high-water-mark extension
+    // is tried first and the general search/insert machinery is only paid
+    // once a gap has been left open.
     //
     UpdatedRange =
-        QuicRangeAddRange(
+        QuicRangeExtendSequential(
             &RecvBuffer->WrittenRanges,
             BufferOffset,
-            BufferLength,
-            &WrittenRangesUpdated);
+            BufferLength);
+    if (UpdatedRange != NULL) {
+        WrittenRangesUpdated = TRUE;
+    } else {
+        UpdatedRange =
+            QuicRangeAddRange(
+                &RecvBuffer->WrittenRanges,
+                BufferOffset,
+                BufferLength,
+                &WrittenRangesUpdated);
+    }
     if (!UpdatedRange) {
         QuicTraceEvent(
             AllocFailure,
@@ -355,6 +628,38 @@ QuicRecvBufferWrite(
         RelativeOffset = (uint32_t)(BufferOffset - RecvBuffer->BaseOffset);
     }
 
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+
+        //
+        // Copy the data into the chunk(s) covering the write's offset range.
+        // The growth logic above guarantees the range is fully backed.
+        //
+        uint64_t WriteOffset = RecvBuffer->BaseOffset + RelativeOffset;
+        QUIC_LIST_ENTRY* Entry = RecvBuffer->Chunks.Flink;
+        while (BufferLength != 0) {
+            QUIC_DBG_ASSERT(Entry != &RecvBuffer->Chunks);
+            QUIC_RECV_CHUNK* Chunk =
+                QUIC_CONTAINING_RECORD(Entry, QUIC_RECV_CHUNK, Link);
+            Entry = Entry->Flink;
+            if (WriteOffset >= Chunk->StartOffset + Chunk->AllocLength) {
+                continue;
+            }
+            uint32_t ChunkOffset = (uint32_t)(WriteOffset - Chunk->StartOffset);
+            uint16_t CopyLength =
+                (uint16_t)min(
+                    (uint32_t)BufferLength,
+                    Chunk->AllocLength - ChunkOffset);
+            QuicCopyMemory(Chunk->Buffer + ChunkOffset, Buffer, CopyLength);
+            Buffer += CopyLength;
+            WriteOffset += CopyLength;
+            BufferLength -= CopyLength;
+        }
+
+        *ReadyToRead = UpdatedRange->Low == 0;
+        Status = QUIC_STATUS_SUCCESS;
+        goto Error;
+    }
+
     //
     // Calculate the actual starting point in the buffer that we will write to,
     // accounting for wrap around.
@@ -426,7 +731,14 @@ QuicRecvBufferRead(
     BOOLEAN LastWrittenRange;
     uint64_t WrittenRangeLength;
 
-    QUIC_DBG_ASSERT(!RecvBuffer->ExternalBufferReference);
+    //
+    // Only the chunk mode supports handing out a new read while previous
+    // reads are still outstanding, because its chunks stay in place until
+    // drained. The other modes may move the bytes underneath the caller.
+    //
+    QUIC_DBG_ASSERT(
+        !RecvBuffer->ExternalBufferReference ||
+        RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE);
 
     //
     // Query if the front of the buffer has been written.
@@ -439,16 +751,51 @@ QuicRecvBufferRead(
             &LastWrittenRange);
 
     //
-    // Exit now if there isn't any data ready to be read.
+    // Exit now if there isn't any data ready to be read that isn't already
+    // covered by an outstanding read.
     //
-    if (!BaseOffsetIsWritten || WrittenRangeLength == 0) {
+    if (!BaseOffsetIsWritten ||
+        WrittenRangeLength <= RecvBuffer->ReadPendingLength) {
         return FALSE;
     }
 
     RecvBuffer->ExternalBufferReference = TRUE;
-    *BufferOffset = RecvBuffer->BaseOffset;
+    *BufferOffset = RecvBuffer->BaseOffset + RecvBuffer->ReadPendingLength;
 
-    if (RecvBuffer->BufferStart + WrittenRangeLength > RecvBuffer->AllocBufferLength) {
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+        //
+        // Return one buffer per chunk spanned by the contiguous data, picking
+        // up where any outstanding reads left off. If the data spans more
+        // chunks than the caller's array can describe, the rest is simply
+        // left for a subsequent read.
+        //
+        uint64_t ReadOffset = RecvBuffer->BaseOffset + RecvBuffer->ReadPendingLength;
+        uint64_t RemainingLength = WrittenRangeLength - RecvBuffer->ReadPendingLength;
+        uint32_t Count = 0;
+        QUIC_LIST_ENTRY* Entry = RecvBuffer->Chunks.Flink;
+        while (RemainingLength != 0 && Count < *BufferCount) {
+            QUIC_DBG_ASSERT(Entry != &RecvBuffer->Chunks);
+            QUIC_RECV_CHUNK* Chunk =
+                QUIC_CONTAINING_RECORD(Entry, QUIC_RECV_CHUNK, Link);
+            Entry = Entry->Flink;
+            if (ReadOffset >= Chunk->StartOffset + Chunk->AllocLength) {
+                continue;
+            }
+            uint32_t ChunkOffset = (uint32_t)(ReadOffset - Chunk->StartOffset);
+            uint64_t ChunkReadLength =
+                min(RemainingLength, Chunk->AllocLength - ChunkOffset);
+            Buffers[Count].Length = (uint32_t)ChunkReadLength;
+            Buffers[Count].Buffer = Chunk->Buffer + ChunkOffset;
+            Count++;
+            ReadOffset += ChunkReadLength;
+            RemainingLength -= ChunkReadLength;
+        }
+        QUIC_DBG_ASSERT(Count != 0);
+        *BufferCount = Count;
+        RecvBuffer->ReadPendingLength =
+            ReadOffset - RecvBuffer->BaseOffset;
+
+    } else if (RecvBuffer->BufferStart + WrittenRangeLength > RecvBuffer->AllocBufferLength) {
         //
         // Circular buffer wrap around case.
         //
@@ -466,6 +813,11 @@ QuicRecvBufferRead(
         Buffers[0].Buffer = RecvBuffer->Buffer + RecvBuffer->BufferStart;
     }
 
+    if (RecvBuffer->Mode != QUIC_RECV_BUF_MODE_MULTIPLE) {
+        RecvBuffer->ReadPendingLength = WrittenRangeLength;
+    }
+    RecvBuffer->ReadPendingCount++;
+
     return TRUE;
 }
 
@@ -477,11 +829,25 @@ QuicRecvBufferDrain(
     )
 {
     QUIC_DBG_ASSERT(RecvBuffer->ExternalBufferReference);
-    RecvBuffer->ExternalBufferReference = FALSE;
+    QUIC_DBG_ASSERT(RecvBuffer->ReadPendingCount != 0);
 
-    if (RecvBuffer->OldBuffer != NULL) {
-        QUIC_FREE(RecvBuffer->OldBuffer);
-        RecvBuffer->OldBuffer = NULL;
+    RecvBuffer->ReadPendingCount--;
+    if (RecvBuffer->ReadPendingCount == 0) {
+        //
+        // The last outstanding read just completed, so no external code
+        // references the buffer any more. Any bytes that were indicated but
+        // not consumed stop being considered pending and get picked up again
+        // by a future read.
+        //
+        RecvBuffer->ExternalBufferReference = FALSE;
+        RecvBuffer->ReadPendingLength = 0;
+        if (RecvBuffer->OldBuffer != NULL) {
+            QUIC_FREE(RecvBuffer->OldBuffer);
+            RecvBuffer->OldBuffer = NULL;
+        }
+    } else {
+        QUIC_DBG_ASSERT(BufferLength <= RecvBuffer->ReadPendingLength);
+        RecvBuffer->ReadPendingLength -= BufferLength;
     }
 
     if (BufferLength == 0) {
@@ -491,6 +857,36 @@ QuicRecvBufferDrain(
     RecvBuffer->BaseOffset += BufferLength;
     uint64_t TotalWrittenLength = QuicRangeGetMax(&RecvBuffer->WrittenRanges) + 1;
 
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_MULTIPLE) {
+        //
+        // Retire (free) chunks that have been completely consumed. The last
+        // chunk is always kept, and once everything has been drained it is
+        // rebased to the new front of the buffer so it is fully reusable.
+        //
+        BOOLEAN AllDrained = RecvBuffer->BaseOffset == TotalWrittenLength;
+        while (RecvBuffer->Chunks.Flink != RecvBuffer->Chunks.Blink) {
+            QUIC_RECV_CHUNK* Chunk =
+                QUIC_CONTAINING_RECORD(
+                    RecvBuffer->Chunks.Flink, QUIC_RECV_CHUNK, Link);
+            if (!AllDrained &&
+                Chunk->StartOffset + Chunk->AllocLength > RecvBuffer->BaseOffset) {
+                break;
+            }
+            QuicListRemoveHead(&RecvBuffer->Chunks);
+            RecvBuffer->AllocBufferLength -= Chunk->AllocLength;
+            QuicLibraryOnBufferMemoryChange(-(int64_t)Chunk->AllocLength);
+            QUIC_FREE(Chunk);
+        }
+        if (AllDrained) {
+            QUIC_RECV_CHUNK* Chunk =
+                QUIC_CONTAINING_RECORD(
+                    RecvBuffer->Chunks.Flink, QUIC_RECV_CHUNK, Link);
+            Chunk->StartOffset = RecvBuffer->BaseOffset;
+            return TRUE;
+        }
+        return RecvBuffer->BaseOffset == QuicRangeGet(&RecvBuffer->WrittenRanges, 0)->Count;
+    }
+
     if (RecvBuffer->BaseOffset == TotalWrittenLength) {
         //
         // All buffer has been drained. Just reset start back to beginning.
@@ -499,15 +895,15 @@ QuicRecvBufferDrain(
         return TRUE;
     }
 
-    if (RecvBuffer->CopyOnDrain) {
-        QUIC_DBG_ASSERT(RecvBuffer->BufferStart == 0);
+    if (RecvBuffer->Mode == QUIC_RECV_BUF_MODE_SINGLE) {
         //
-        // Copy remaining bytes in the buffer to the beginning.
+        // Just advance the start of the data. The remaining bytes stay where
+        // they are (still contiguous, since this mode never wraps) and are
+        // only compacted to the front if a later write actually needs the
+        // tail space, so a partial drain doesn't recopy the residue.
         //
-        QuicMoveMemory(
-            RecvBuffer->Buffer,
-            RecvBuffer->Buffer + BufferLength,
-            (size_t)(TotalWrittenLength - RecvBuffer->BaseOffset));
+        RecvBuffer->BufferStart += (uint32_t)BufferLength;
+        QUIC_DBG_ASSERT(RecvBuffer->BufferStart <= RecvBuffer->AllocBufferLength);
     } else {
         //
         // Increment the buffer start, making sure to account for circular
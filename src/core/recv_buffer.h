@@ -5,13 +5,68 @@
 
 --*/
 
+//
+// Controls the internal memory representation of the receive buffer.
+//
+typedef enum QUIC_RECV_BUF_MODE {
+
+    //
+    // A single contiguous buffer that never wraps, so reads always return a
+    // single contiguous span. Drains just advance the start of the data;
+    // the residue is only compacted to the front if a later write needs the
+    // tail space.
+    //
+    QUIC_RECV_BUF_MODE_SINGLE,
+
+    //
+    // A circular buffer. Drains just advance the start pointer, but growth
+    // requires reallocating and copying into a larger buffer.
+    //
+    QUIC_RECV_BUF_MODE_CIRCULAR,
+
+    //
+    // A list of linked chunks. Growth appends a new chunk and drains retire
+    // fully consumed chunks, so no bytes are ever copied; reads return one
+    // buffer per chunk spanned.
+    //
+    QUIC_RECV_BUF_MODE_MULTIPLE
+
+} QUIC_RECV_BUF_MODE;
+
+//
+// A single contiguous block of buffered bytes, used in the
+// QUIC_RECV_BUF_MODE_MULTIPLE mode.
+//
+typedef struct QUIC_RECV_CHUNK {
+
+    //
+    // The link in the receive buffer's list of chunks.
+    //
+    QUIC_LIST_ENTRY Link;
+
+    //
+    // The stream offset of the first byte of 'Buffer'.
+    //
+    uint64_t StartOffset;
+
+    //
+    // Length of memory allocated for 'Buffer'.
+    //
+    uint32_t AllocLength;
+
+    //
+    // The buffered bytes.
+    //
+    uint8_t Buffer[0];
+
+} QUIC_RECV_CHUNK;
+
 typedef struct QUIC_RECV_BUFFER {
 
     //
-    // Flag to indicate that after a drain, copy any remaining bytes to the
-    // front of the buffer or reset the pointers to 0.
+    // The memory representation currently in use.
     //
-    BOOLEAN CopyOnDrain : 1;
+    QUIC_RECV_BUF_MODE Mode;
 
     //
     // Flag to indicate that some external code is currently referencing the
@@ -20,6 +75,20 @@ typedef struct QUIC_RECV_BUFFER {
     //
     BOOLEAN ExternalBufferReference : 1;
 
+    //
+    // The number of reads handed out (via QuicRecvBufferRead) that haven't
+    // been drained yet. Only ever greater than one in the
+    // QUIC_RECV_BUF_MODE_MULTIPLE mode, where chunks stay in place so new
+    // data can be read while previous reads are still outstanding.
+    //
+    uint32_t ReadPendingCount;
+
+    //
+    // The number of bytes, starting at BaseOffset, covered by outstanding
+    // reads. New reads start delivery at BaseOffset + ReadPendingLength.
+    //
+    uint64_t ReadPendingLength;
+
     //
     // Previous buffer that needs to be freed as soon as the external reference
     // is released.
@@ -27,13 +96,20 @@ typedef struct QUIC_RECV_BUFFER {
     uint8_t * OldBuffer;
 
     //
-    // Circular buffer used for storing the writes.
+    // Circular buffer used for storing the writes. Unused (NULL) in the
+    // QUIC_RECV_BUF_MODE_MULTIPLE mode, which uses 'Chunks' instead.
     //
     uint8_t * Buffer;
 
     //
-    // Length of memory allocated for 'Buffer'. Dynamically grows up to
-    // VirtualBufferLength.
+    // The list of chunks (QUIC_RECV_CHUNK) storing the writes, in stream
+    // offset order. Only used in the QUIC_RECV_BUF_MODE_MULTIPLE mode.
+    //
+    QUIC_LIST_ENTRY Chunks;
+
+    //
+    // Total length of memory allocated for the buffered bytes, across all
+    // chunks. Dynamically grows up to VirtualBufferLength.
     //
     uint32_t AllocBufferLength;
 
@@ -65,7 +141,7 @@ QuicRecvBufferInitialize(
     _Inout_ QUIC_RECV_BUFFER* RecvBuffer,
     _In_ uint32_t AllocBufferLength,
     _In_ uint32_t VirtualBufferLength,
-    _In_ BOOLEAN CopyOnDrain
+    _In_ QUIC_RECV_BUF_MODE Mode
     );
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -93,6 +169,33 @@ QuicRecvBufferSetVirtualBufferLength(
     _In_ uint32_t NewLength
     );
 
+//
+// Releases buffer memory the receive buffer has grown beyond the given
+// target allocation size, when no buffered bytes would be lost. Used to
+// shrink long-idle connections; the buffer regrows on demand. Returns TRUE
+// if any memory was released.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicRecvBufferShrink(
+    _In_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint32_t TargetBufferLength
+    );
+
+//
+// Returns a previously used receive buffer to its freshly initialized state,
+// keeping the buffer allocations (shrunk back to the given default size)
+// so a recycled owner skips the reallocation cost. May only be called once
+// any external buffer reference has been released.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicRecvBufferReset(
+    _Inout_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint32_t AllocBufferLength,
+    _In_ uint32_t VirtualBufferLength
+    );
+
 //
 // Returns TRUE there is any unread data in the receive buffer.
 //
@@ -130,12 +233,31 @@ QuicRecvBufferWrite(
     _Out_ BOOLEAN* ReadyToRead
     );
 
+//
+// Records bytes at the front of the buffer that were delivered to (and
+// consumed by) the client directly out of the packet buffer, without ever
+// being copied in. The bytes still count as written, so retransmits of the
+// same data are recognized as duplicates. May only be called when the
+// buffer holds no data and no reads are outstanding.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicRecvBufferDeliveredInline(
+    _In_ QUIC_RECV_BUFFER* RecvBuffer,
+    _In_ uint64_t BufferOffset,
+    _In_ uint64_t BufferLength
+    );
+
 //
 // Returns a pointer into the buffer for data ready to be delivered
 // to the client.
 //
 // Since this returns an internal pointer, the caller must retain
 // exclusive access to the buffer until it calls QuicRecvBufferDrain.
+// In the QUIC_RECV_BUF_MODE_MULTIPLE mode the chunks handed out stay in
+// place, so additional reads (returning only data not covered by a
+// previous read) are allowed while earlier reads are still outstanding,
+// as long as each read is eventually drained, in order.
 //
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Success_(return != FALSE)
@@ -150,9 +272,11 @@ QuicRecvBufferRead(
 
 //
 // Marks a number of bytes at the beginning of the buffer as
-// delivered (freeing space in the buffer).
+// delivered (freeing space in the buffer) and completes the oldest
+// outstanding read.
 //
-// Invalidates the pointer returned by QuicRecvBufferRead.
+// Invalidates the pointers returned by QuicRecvBufferRead for the
+// consumed bytes.
 //
 // Returns TRUE if there is no more data available to be read.
 //
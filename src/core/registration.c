@@ -63,6 +63,7 @@ MsQuicRegistrationOpen(
     Registration->ClientContext = NULL;
     Registration->NoPartitioning = FALSE;
     Registration->ExecProfile = Config == NULL ? QUIC_EXECUTION_PROFILE_LOW_LATENCY : Config->ExecutionProfile;
+    Registration->TraceClasses = QUIC_TRACE_CLASS_ALL;
     Registration->CidPrefixLength = 0;
     Registration->CidPrefix = NULL;
     QuicLockInitialize(&Registration->Lock);
@@ -76,6 +77,7 @@ MsQuicRegistrationOpen(
     }
 
     uint16_t WorkerThreadFlags = 0;
+    uint32_t WorkerIdleSpinUs = MsQuicLib.Settings.WorkerIdleSpinUs;
     switch (Registration->ExecProfile) {
     default:
     case QUIC_EXECUTION_PROFILE_LOW_LATENCY:
@@ -87,20 +89,65 @@ MsQuicRegistrationOpen(
     case QUIC_EXECUTION_PROFILE_TYPE_SCAVENGER:
         WorkerThreadFlags = 0;
         Registration->NoPartitioning = TRUE;
+        //
+        // Scavenger workers always yield the processor when out of work.
+        //
+        WorkerIdleSpinUs = 0;
         break;
     case QUIC_EXECUTION_PROFILE_TYPE_REAL_TIME:
         WorkerThreadFlags =
             QUIC_THREAD_FLAG_SET_IDEAL_PROC |
             QUIC_THREAD_FLAG_SET_AFFINITIZE |
             QUIC_THREAD_FLAG_HIGH_PRIORITY;
+        //
+        // Real-time workers trade processor time for wake latency and spin
+        // longer before parking.
+        //
+        if (WorkerIdleSpinUs < QUIC_WORKER_IDLE_SPIN_US_REAL_TIME) {
+            WorkerIdleSpinUs = QUIC_WORKER_IDLE_SPIN_US_REAL_TIME;
+        }
         break;
     }
 
+    //
+    // Optional per-registration worker placement. A zero WorkerCount keeps
+    // the default of one worker per library partition; the scavenger profile
+    // always runs a single worker.
+    //
+    uint8_t WorkerCount =
+        Registration->NoPartitioning ? 1 : MsQuicLib.PartitionCount;
+    const uint8_t* WorkerProcessorList = NULL;
+    if (Config != NULL &&
+        (Config->WorkerCount != 0 || Config->ProcessorList != NULL)) {
+        uint8_t RequestedCount =
+            Config->WorkerCount != 0 ?
+                Config->WorkerCount : Config->ProcessorCount;
+        if (RequestedCount == 0 ||
+            (Registration->NoPartitioning && RequestedCount != 1) ||
+            (Config->ProcessorList != NULL &&
+             Config->ProcessorCount != RequestedCount)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            goto Error;
+        }
+        if (Config->ProcessorList != NULL) {
+            for (uint8_t i = 0; i < Config->ProcessorCount; i++) {
+                if (Config->ProcessorList[i] >= QuicProcActiveCount()) {
+                    Status = QUIC_STATUS_INVALID_PARAMETER;
+                    goto Error;
+                }
+            }
+            WorkerProcessorList = Config->ProcessorList;
+        }
+        WorkerCount = RequestedCount;
+    }
+
     Status =
         QuicWorkerPoolInitialize(
             Registration,
             WorkerThreadFlags,
-            Registration->NoPartitioning ? 1 : MsQuicLib.PartitionCount,
+            WorkerIdleSpinUs,
+            WorkerCount,
+            WorkerProcessorList,
             &Registration->WorkerPool);
     if (QUIC_FAILED(Status)) {
         goto Error;
@@ -338,6 +385,13 @@ QuicRegistrationAcceptConnection(
 
     uint8_t Index =
         Registration->NoPartitioning ? 0 : QuicPartitionIdGetIndex(Connection->PartitionID);
+    if (Index >= Registration->WorkerPool->WorkerCount) {
+        //
+        // The registration runs fewer workers than there are library
+        // partitions; fold the partition index down onto the pool.
+        //
+        Index %= Registration->WorkerPool->WorkerCount;
+    }
 
     //
     // TODO - Look for other worker instead if the proposed worker is overloaded?
@@ -359,6 +413,9 @@ QuicRegistrationQueueNewConnection(
 {
     uint8_t Index =
         Registration->NoPartitioning ? 0 : QuicPartitionIdGetIndex(Connection->PartitionID);
+    if (Index >= Registration->WorkerPool->WorkerCount) {
+        Index %= Registration->WorkerPool->WorkerCount;
+    }
 
     //
     // TODO - Look for other worker instead if the proposed worker is overloaded?
@@ -416,6 +473,23 @@ QuicRegistrationParamSet(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_REGISTRATION_TRACE_CLASSES:
+
+        if (BufferLength != sizeof(uint32_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // Connections capture the mask when they are registered with a
+        // session, so the new value applies to connections created from here
+        // on; existing connections keep the mask they started with.
+        //
+        Registration->TraceClasses = *(uint32_t*)Buffer;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -461,6 +535,115 @@ QuicRegistrationParamGet(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_REGISTRATION_TRACE_CLASSES:
+
+        if (*BufferLength < sizeof(uint32_t)) {
+            *BufferLength = sizeof(uint32_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(uint32_t);
+        *(uint32_t*)Buffer = Registration->TraceClasses;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_REGISTRATION_PERF_EVENTS: {
+
+        const QUIC_WORKER_POOL* WorkerPool = Registration->WorkerPool;
+        uint32_t EventsPerWorker =
+            (*BufferLength / sizeof(QUIC_PERF_EVENT)) / WorkerPool->WorkerCount;
+
+        if (EventsPerWorker == 0) {
+            *BufferLength =
+                WorkerPool->WorkerCount * QUIC_PERF_EVENT_RING_LENGTH *
+                sizeof(QUIC_PERF_EVENT);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // Stateless snapshot: returns up to the last EventsPerWorker events
+        // from each worker's ring, oldest first per worker. The caller
+        // correlates repeated snapshots with the per-event sequence numbers.
+        //
+        QUIC_PERF_EVENT* Events = (QUIC_PERF_EVENT*)Buffer;
+        uint32_t EventsRead = 0;
+        for (uint32_t i = 0; i < WorkerPool->WorkerCount; ++i) {
+            const QUIC_PERF_EVENT_RING* Ring =
+                &WorkerPool->Workers[i].PerfEvents;
+            int64_t ReadSequence = Ring->WriteSequence - EventsPerWorker;
+            if (ReadSequence < 0) {
+                ReadSequence = 0;
+            }
+            EventsRead +=
+                QuicPerfEventRingRead(
+                    Ring,
+                    &ReadSequence,
+                    Events + EventsRead,
+                    EventsPerWorker);
+        }
+
+        *BufferLength = EventsRead * sizeof(QUIC_PERF_EVENT);
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
+    case QUIC_PARAM_REGISTRATION_WORKER_STATS: {
+
+        const QUIC_WORKER_POOL* WorkerPool = Registration->WorkerPool;
+        uint32_t RequiredLength =
+            WorkerPool->WorkerCount * sizeof(QUIC_WORKER_STATS);
+
+        if (*BufferLength < RequiredLength) {
+            *BufferLength = RequiredLength;
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // Unsynchronized snapshot: the workers keep running, so individual
+        // fields are consistent but may be torn relative to each other.
+        //
+        QUIC_WORKER_STATS* Stats = (QUIC_WORKER_STATS*)Buffer;
+        for (uint32_t i = 0; i < WorkerPool->WorkerCount; ++i) {
+            const QUIC_WORKER* Worker = &WorkerPool->Workers[i];
+            QuicZeroMemory(&Stats[i], sizeof(Stats[i]));
+            Stats[i].IdealProcessor = Worker->IdealProcessor;
+            Stats[i].IsActive = Worker->IsActive;
+            Stats[i].AverageQueueDelayUs = Worker->AverageQueueDelay;
+            Stats[i].ConnectionCount = (uint32_t)Worker->ConnectionCount;
+            Stats[i].QueuedOperationCount = Worker->OperationCount;
+            Stats[i].TotalBusyTimeUs = Worker->TotalBusyTimeUs;
+            Stats[i].TotalIdleTimeUs = Worker->TotalIdleTimeUs;
+            Stats[i].DroppedOperationCount = Worker->DroppedOperationCount;
+            Stats[i].DrainCount = Worker->DrainCount;
+            for (uint32_t j = 0; j < QUIC_WORKER_STATS_DRAIN_BUCKETS; ++j) {
+                Stats[i].DrainHistogram[j] = Worker->DrainHistogram[j];
+            }
+        }
+
+        *BufferLength = RequiredLength;
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -40,6 +40,12 @@ typedef struct QUIC_REGISTRATION {
     //
     QUIC_EXECUTION_PROFILE ExecProfile;
 
+    //
+    // Runtime trace class enablement (QUIC_TRACE_CLASS_* flags) for this
+    // registration's connections.
+    //
+    uint32_t TraceClasses;
+
     //
     // An app configured prefix for all connection IDs in this registration.
     //
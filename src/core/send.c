@@ -29,6 +29,27 @@ QuicSendInitialize(
     )
 {
     QuicListInitializeHead(&Send->SendStreams);
+    Send->RetransmitCacheTail = &Send->RetransmitCache;
+}
+
+//
+// Frees all queued retransmit cache entries.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSendFreeRetransmitCache(
+    _In_ QUIC_SEND* Send
+    )
+{
+    QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
+    while (Send->RetransmitCache != NULL) {
+        QUIC_SENT_PACKET_METADATA* Packet = Send->RetransmitCache;
+        Send->RetransmitCache = Packet->Next;
+        QuicSendReleaseCachedPayload(Send, Packet);
+        QuicSentPacketPoolReturnPacketMetadata(
+            &Connection->Worker->SentPacketPool, Packet);
+    }
+    Send->RetransmitCacheTail = &Send->RetransmitCache;
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -42,6 +63,8 @@ QuicSendUninitialize(
         Send->InitialToken = NULL;
     }
 
+    QuicSendFreeRetransmitCache(Send);
+
     //
     // Release all the stream refs.
     //
@@ -78,13 +101,16 @@ QuicSendReset(
 {
     Send->SendFlags = 0;
     Send->LastFlushTime = 0;
+    QuicSendFreeRetransmitCache(Send);
     if (Send->DelayedAckTimerActive) {
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             CancelAckDelayTimer,
             QuicSendGetConnection(Send),
             "Canceling ACK_DELAY timer");
         QuicConnTimerCancel(QuicSendGetConnection(Send), QUIC_CONN_TIMER_ACK_DELAY);
         Send->DelayedAckTimerActive = FALSE;
+        Send->AckPiggybackDeferred = FALSE;
     }
     QuicConnTimerCancel(
         QuicSendGetConnection(Send),
@@ -115,43 +141,98 @@ QuicSendQueueFlush(
     _In_ QUIC_SEND_FLUSH_REASON Reason
     )
 {
-    if (!Send->FlushOperationPending && QuicSendCanSendFlagsNow(Send)) {
+    if (!Send->FlushOperationPending &&
+        QuicSendCanSendFlagsNow(Send) &&
+        InterlockedCompareExchange16(
+            &Send->FlushOperationPending, TRUE, FALSE) == FALSE) {
         QUIC_OPERATION* Oper;
         QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
         if ((Oper = QuicOperationAlloc(Connection->Worker, QUIC_OPER_TYPE_FLUSH_SEND)) != NULL) {
-            Send->FlushOperationPending = TRUE;
             QuicTraceEvent(
                 ConnQueueSendFlush,
                 "[conn][%p] Queueing send flush, reason=%u",
                 Connection,
                 Reason);
             QuicConnQueueOper(Connection, Oper);
+        } else {
+            //
+            // Release the claim so a later queue attempt retries the
+            // allocation.
+            //
+            InterlockedCompareExchange16(
+                &Send->FlushOperationPending, FALSE, TRUE);
         }
     }
 }
 
+//
+// Inserts the stream into the send queue, which is kept sorted by priority
+// (highest first). The stream goes after any queued streams of the same
+// priority, so equal priority streams are serviced in the order they were
+// queued.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static
+void
+QuicSendInsertStreamByPriority(
+    _In_ QUIC_SEND* Send,
+    _In_ QUIC_STREAM* Stream
+    )
+{
+    QUIC_LIST_ENTRY* Entry = Send->SendStreams.Blink;
+    while (Entry != &Send->SendStreams &&
+        QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, SendLink)->SendPriority <
+            Stream->SendPriority) {
+        Entry = Entry->Blink;
+    }
+    QuicListInsertHead(Entry, &Stream->SendLink); // Insert after Entry.
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSendUpdateStreamPriority(
+    _In_ QUIC_SEND* Send,
+    _In_ QUIC_STREAM* Stream
+    )
+{
+    QUIC_DBG_ASSERT(Stream->SendLink.Flink != NULL);
+    QuicListEntryRemove(&Stream->SendLink);
+    QuicSendInsertStreamByPriority(Send, Stream);
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicSendQueueFlushForStream(
     _In_ QUIC_SEND* Send,
     _In_ QUIC_STREAM* Stream,
-    _In_ BOOLEAN WasPreviouslyQueued
+    _In_ BOOLEAN WasPreviouslyQueued,
+    _In_ BOOLEAN DelaySend
     )
 {
     if (!WasPreviouslyQueued) {
         //
-        // Not previously queued, so add the stream to the end of the queue.
+        // Not previously queued, so add the stream to the send queue in
+        // priority order.
         //
         QUIC_DBG_ASSERT(Stream->SendLink.Flink == NULL);
-        QuicListInsertTail(&Send->SendStreams, &Stream->SendLink);
+        QuicSendInsertStreamByPriority(Send, Stream);
         QuicStreamAddRef(Stream, QUIC_STREAM_REF_SEND);
     }
 
-    if (Stream->Connection->State.Started) {
+    if (DelaySend) {
+        //
+        // The app expects more data to be queued soon, so hold off on
+        // scheduling the flush. The data still goes out with the next flush,
+        // whatever triggers it.
+        //
+        Stream->Flags.SendDelayed = TRUE;
+
+    } else if (Stream->Connection->State.Started) {
         //
         // Schedule the flush even if we didn't just queue the stream,
         // because it may have been previously blocked.
         //
+        Stream->Flags.SendDelayed = FALSE;
         QuicSendQueueFlush(Send, REASON_STREAM_FLAGS);
     }
 }
@@ -166,11 +247,12 @@ QuicSendValidate(
     QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
 
     BOOLEAN HasAckElicitingPacketsToAcknowledge = FALSE;
+    BOOLEAN AckTrackerBatching = FALSE;
     for (uint32_t i = 0; i < QUIC_ENCRYPT_LEVEL_COUNT; ++i) {
         if (Connection->Packets[i] != NULL) {
+            AckTrackerBatching |= Connection->Packets[i]->AckTracker.Batching;
             if (Connection->Packets[i]->AckTracker.AckElicitingPacketsToAcknowledge) {
                 HasAckElicitingPacketsToAcknowledge = TRUE;
-                break;
             }
         }
     }
@@ -181,7 +263,13 @@ QuicSendValidate(
     } else if (Send->DelayedAckTimerActive) {
         QUIC_DBG_ASSERT(HasAckElicitingPacketsToAcknowledge);
     } else if (!Connection->State.ClosedLocally && !Connection->State.ClosedRemotely) {
-        QUIC_DBG_ASSERT(!HasAckElicitingPacketsToAcknowledge);
+        //
+        // While a receive batch is in progress the ACK scheduling decisions
+        // for any newly counted ACK eliciting packets are deferred until
+        // QuicAckTrackerBatchEnd, so the count can transiently be nonzero
+        // with neither the ACK send flag nor the delayed ACK timer set.
+        //
+        QUIC_DBG_ASSERT(AckTrackerBatching || !HasAckElicitingPacketsToAcknowledge);
     }
 }
 #else
@@ -204,16 +292,19 @@ QuicSendSetSendFlag(
         !QuicConnIsClosed(Connection) || IsCloseFrame;
 
     if (SendFlags & QUIC_CONN_SEND_FLAG_ACK && Send->DelayedAckTimerActive) {
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             CancelAckDelayTimer,
             Connection,
             "Canceling ACK_DELAY timer");
         QuicConnTimerCancel(Connection, QUIC_CONN_TIMER_ACK_DELAY);
         Send->DelayedAckTimerActive = FALSE;
+        Send->AckPiggybackDeferred = FALSE;
     }
 
     if (CanSetFlag && (Send->SendFlags & SendFlags) != SendFlags) {
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             ScheduleSendFlags,
             Connection,
             "Scheduling flags 0x%x to 0x%x",
@@ -253,6 +344,45 @@ QuicSendSetSendFlag(
     return CanSetFlag;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicSendSetDelayedSendFlag(
+    _In_ QUIC_SEND* Send,
+    _In_ uint32_t SendFlags
+    )
+{
+    QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
+
+    //
+    // ACK and close frames have their own scheduling logic and must go
+    // through QuicSendSetSendFlag.
+    //
+    QUIC_DBG_ASSERT(
+        !(SendFlags &
+          (QUIC_CONN_SEND_FLAG_ACK |
+           QUIC_CONN_SEND_FLAG_CONNECTION_CLOSE |
+           QUIC_CONN_SEND_FLAG_APPLICATION_CLOSE)));
+
+    if (QuicConnIsClosed(Connection)) {
+        return FALSE;
+    }
+
+    if ((Send->SendFlags & SendFlags) != SendFlags) {
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
+            ScheduleDelayedSendFlags,
+            Connection,
+            "Scheduling delayed flags 0x%x to 0x%x",
+            SendFlags,
+            Send->SendFlags);
+        Send->SendFlags |= SendFlags;
+    }
+
+    QuicSendValidate(Send);
+
+    return TRUE;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
 QuicSendClearSendFlag(
@@ -261,7 +391,8 @@ QuicSendClearSendFlag(
     )
 {
     if (Send->SendFlags & SendFlags) {
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             RemoveSendFlags,
             QuicSendGetConnection(Send),
             "Removing flags %x",
@@ -294,12 +425,14 @@ QuicSendUpdateAckState(
             QUIC_DBG_ASSERT(!Send->DelayedAckTimerActive);
             Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_ACK;
         } else if (Send->DelayedAckTimerActive) {
-            QuicTraceLogConnVerbose(
+            QuicTraceLogConnVerboseClass(
+                QUIC_TRACE_CLASS_DATAPATH,
                 CancelAckDelayTimer,
                 Connection,
                 "Canceling ACK_DELAY timer");
             QuicConnTimerCancel(Connection, QUIC_CONN_TIMER_ACK_DELAY);
             Send->DelayedAckTimerActive = FALSE;
+            Send->AckPiggybackDeferred = FALSE;
         }
     }
 
@@ -311,7 +444,8 @@ BOOLEAN
 QuicSendSetStreamSendFlag(
     _In_ QUIC_SEND* Send,
     _In_ QUIC_STREAM* Stream,
-    _In_ uint32_t SendFlags
+    _In_ uint32_t SendFlags,
+    _In_ BOOLEAN DelaySend
     )
 {
     QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
@@ -345,7 +479,9 @@ QuicSendSetStreamSendFlag(
         SendFlags &= ~QUIC_STREAM_SEND_FLAG_MAX_DATA;
     }
 
-    if ((Stream->SendFlags | SendFlags) != Stream->SendFlags) {
+    if ((Stream->SendFlags | SendFlags) != Stream->SendFlags ||
+        (Stream->Flags.SendDelayed && !DelaySend &&
+         (SendFlags & QUIC_STREAM_SEND_FLAG_DATA))) {
 
         QuicTraceLogStreamVerbose(
             SetSendFlag,
@@ -355,12 +491,15 @@ QuicSendSetStreamSendFlag(
             Stream->SendFlags);
 
         if (Stream->Flags.Started &&
-            (Stream->SendFlags & SendFlags) != SendFlags) {
+            ((Stream->SendFlags & SendFlags) != SendFlags ||
+             Stream->Flags.SendDelayed)) {
             //
-            // Since this is new data for a started stream, we need to queue
-            // up the send to flush the stream data.
+            // Since this is new data for a started stream (or a flush of
+            // previously delayed data), we need to queue up the send to flush
+            // the stream data.
             //
-            QuicSendQueueFlushForStream(Send, Stream, Stream->SendFlags != 0);
+            QuicSendQueueFlushForStream(
+                Send, Stream, Stream->SendFlags != 0, DelaySend);
         }
         Stream->SendFlags |= SendFlags;
     }
@@ -403,57 +542,26 @@ QuicSendClearStreamSendFlag(
     }
 }
 
+//
+// Writes the rarely sent connection-level frames (everything other than ACK
+// and CRYPTO) to the packet, in priority order. Only called when at least one
+// of QUIC_CONN_SEND_FLAGS_RARE is pending, so the steady state build path
+// doesn't pay for these branches. Returns TRUE if packet building should stop
+// (the packet is full or a close frame was written), FALSE to continue with
+// the normal exit logic.
+//
 _IRQL_requires_max_(PASSIVE_LEVEL)
 BOOLEAN
-QuicSendWriteFrames(
+QuicSendWriteRareFrames(
     _In_ QUIC_SEND* Send,
-    _Inout_ QUIC_PACKET_BUILDER* Builder
+    _Inout_ QUIC_PACKET_BUILDER* Builder,
+    _In_ uint16_t AvailableBufferLength,
+    _In_ BOOLEAN IsCongestionControlBlocked,
+    _In_ BOOLEAN Is1RttEncryptionLevel,
+    _Inout_ BOOLEAN* RanOutOfRoom
     )
 {
-    QUIC_DBG_ASSERT(Builder->Metadata->FrameCount < QUIC_MAX_FRAMES_PER_PACKET);
-
     QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
-    uint16_t AvailableBufferLength =
-        (uint16_t)Builder->Datagram->Length - Builder->EncryptionOverhead;
-    uint8_t PrevFrameCount = Builder->Metadata->FrameCount;
-    BOOLEAN RanOutOfRoom = FALSE;
-
-    QUIC_PACKET_SPACE* Packets = Connection->Packets[Builder->EncryptLevel];
-    QUIC_DBG_ASSERT(Packets != NULL);
-
-    BOOLEAN IsCongestionControlBlocked = !QuicPacketBuilderHasAllowance(Builder);
-
-    BOOLEAN Is1RttEncryptionLevel =
-        Builder->Metadata->Flags.KeyType == QUIC_PACKET_KEY_1_RTT ||
-        Builder->Metadata->Flags.KeyType == QUIC_PACKET_KEY_0_RTT;
-
-    //
-    // Now fill the packet with available frames, in priority order, until we
-    // run out of space. The order below was generally chosen based on the
-    // perceived importance of each type of frame. ACKs are the most important
-    // frame, followed by connection close and then the rest of the connection
-    // specific frames.
-    //
-
-    if (Builder->PacketType != QUIC_0_RTT_PROTECTED &&
-        QuicAckTrackerHasPacketsToAck(&Packets->AckTracker)) {
-        if (!QuicAckTrackerAckFrameEncode(&Packets->AckTracker, Builder)) {
-            RanOutOfRoom = TRUE;
-            goto Exit;
-        }
-    }
-
-    if (!IsCongestionControlBlocked &&
-        Send->SendFlags & QUIC_CONN_SEND_FLAG_CRYPTO &&
-        Builder->PacketType == QuicEncryptLevelToPacketType(QuicCryptoGetNextEncryptLevel(&Connection->Crypto))) {
-        if (QuicCryptoWriteFrames(&Connection->Crypto, Builder)) {
-            if (Builder->Metadata->FrameCount == QUIC_MAX_FRAMES_PER_PACKET) {
-                return TRUE;
-            }
-        } else {
-            RanOutOfRoom = TRUE;
-        }
-    }
 
     if ((Send->SendFlags & QUIC_CONN_SEND_FLAG_CONNECTION_CLOSE) ||
         ((Send->SendFlags & QUIC_CONN_SEND_FLAG_APPLICATION_CLOSE) && Is1RttEncryptionLevel)) {
@@ -486,7 +594,7 @@ QuicSendWriteFrames(
             (void)QuicPacketBuilderAddFrame(
                 Builder, IsApplicationClose ? QUIC_FRAME_CONNECTION_CLOSE_1 : QUIC_FRAME_CONNECTION_CLOSE, FALSE);
         } else {
-            RanOutOfRoom = TRUE;
+            *RanOutOfRoom = TRUE;
         }
 
         return TRUE;
@@ -496,8 +604,8 @@ QuicSendWriteFrames(
         //
         // Everything below this is not allowed to be sent while CC blocked.
         //
-        RanOutOfRoom = TRUE;
-        goto Exit;
+        *RanOutOfRoom = TRUE;
+        return FALSE;
     }
 
     if (Send->SendFlags & QUIC_CONN_SEND_FLAG_PATH_RESPONSE) {
@@ -528,7 +636,7 @@ QuicSendWriteFrames(
                     break;
                 }
             } else {
-                RanOutOfRoom = TRUE;
+                *RanOutOfRoom = TRUE;
                 break;
             }
         }
@@ -554,7 +662,33 @@ QuicSendWriteFrames(
                     return TRUE;
                 }
             } else {
-                RanOutOfRoom = TRUE;
+                *RanOutOfRoom = TRUE;
+            }
+        }
+
+        if (Send->SendFlags & QUIC_CONN_SEND_FLAG_ACK_FREQUENCY) {
+
+            QUIC_ACK_FREQUENCY_EX Frame;
+            Frame.SequenceNumber = Connection->SendAckFreqSeqNum;
+            Frame.PacketTolerance = Connection->PeerPacketTolerance;
+            Frame.UpdateMaxAckDelay =
+                MS_TO_US(Connection->PeerTransportParams.MaxAckDelay);
+
+            if (QuicAckFrequencyFrameEncode(
+                    &Frame,
+                    &Builder->DatagramLength,
+                    AvailableBufferLength,
+                    Builder->Datagram->Buffer)) {
+
+                Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_ACK_FREQUENCY;
+                Builder->Metadata->Frames[
+                    Builder->Metadata->FrameCount].ACK_FREQUENCY.Sequence =
+                        Frame.SequenceNumber;
+                if (QuicPacketBuilderAddFrame(Builder, QUIC_FRAME_ACK_FREQUENCY, TRUE)) {
+                    return TRUE;
+                }
+            } else {
+                *RanOutOfRoom = TRUE;
             }
         }
 
@@ -573,7 +707,7 @@ QuicSendWriteFrames(
                     return TRUE;
                 }
             } else {
-                RanOutOfRoom = TRUE;
+                *RanOutOfRoom = TRUE;
             }
         }
 
@@ -592,7 +726,7 @@ QuicSendWriteFrames(
                     return TRUE;
                 }
             } else {
-                RanOutOfRoom = TRUE;
+                *RanOutOfRoom = TRUE;
             }
         }
 
@@ -615,7 +749,7 @@ QuicSendWriteFrames(
                     return TRUE;
                 }
             } else {
-                RanOutOfRoom = TRUE;
+                *RanOutOfRoom = TRUE;
             }
         }
 
@@ -638,7 +772,7 @@ QuicSendWriteFrames(
                     return TRUE;
                 }
             } else {
-                RanOutOfRoom = TRUE;
+                *RanOutOfRoom = TRUE;
             }
         }
 
@@ -695,7 +829,7 @@ QuicSendWriteFrames(
                         QuicPacketBuilderAddFrame(
                             Builder, QUIC_FRAME_NEW_CONNECTION_ID, TRUE);
                 } else {
-                    RanOutOfRoom = TRUE;
+                    *RanOutOfRoom = TRUE;
                     HasMoreCidsToSend = TRUE;
                     break;
                 }
@@ -703,7 +837,7 @@ QuicSendWriteFrames(
             if (!HasMoreCidsToSend) {
                 Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_NEW_CONNECTION_ID;
             }
-            if (MaxFrameLimitHit || RanOutOfRoom) {
+            if (MaxFrameLimitHit || *RanOutOfRoom) {
                 return TRUE;
             }
         }
@@ -746,7 +880,7 @@ QuicSendWriteFrames(
                         QuicPacketBuilderAddFrame(
                             Builder, QUIC_FRAME_RETIRE_CONNECTION_ID, TRUE);
                 } else {
-                    RanOutOfRoom = TRUE;
+                    *RanOutOfRoom = TRUE;
                     HasMoreCidsToSend = TRUE;
                     break;
                 }
@@ -754,10 +888,24 @@ QuicSendWriteFrames(
             if (!HasMoreCidsToSend) {
                 Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_RETIRE_CONNECTION_ID;
             }
-            if (MaxFrameLimitHit || RanOutOfRoom) {
+            if (MaxFrameLimitHit || *RanOutOfRoom) {
                 return TRUE;
             }
         }
+
+        if (Send->SendFlags & QUIC_CONN_SEND_FLAG_DATAGRAM) {
+
+            if (QuicDatagramWriteFrame(&Connection->Datagram, Builder)) {
+                if (Connection->Datagram.SendQueue == NULL) {
+                    Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_DATAGRAM;
+                }
+                if (Builder->Metadata->FrameCount == QUIC_MAX_FRAMES_PER_PACKET) {
+                    return TRUE;
+                }
+            } else {
+                *RanOutOfRoom = TRUE;
+            }
+        }
     }
 
     if (Send->SendFlags & QUIC_CONN_SEND_FLAG_PING) {
@@ -769,11 +917,84 @@ QuicSendWriteFrames(
             if (QuicPacketBuilderAddFrame(Builder, QUIC_FRAME_PING, TRUE)) {
                 return TRUE;
             }
+        } else {
+            *RanOutOfRoom = TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+BOOLEAN
+QuicSendWriteFrames(
+    _In_ QUIC_SEND* Send,
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    QUIC_DBG_ASSERT(Builder->Metadata->FrameCount < QUIC_MAX_FRAMES_PER_PACKET);
+
+    QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
+    uint16_t AvailableBufferLength =
+        (uint16_t)Builder->Datagram->Length - Builder->EncryptionOverhead;
+    uint8_t PrevFrameCount = Builder->Metadata->FrameCount;
+    BOOLEAN RanOutOfRoom = FALSE;
+
+    QUIC_PACKET_SPACE* Packets = Connection->Packets[Builder->EncryptLevel];
+    QUIC_DBG_ASSERT(Packets != NULL);
+
+    BOOLEAN IsCongestionControlBlocked = !QuicPacketBuilderHasAllowance(Builder);
+
+    BOOLEAN Is1RttEncryptionLevel =
+        Builder->Metadata->Flags.KeyType == QUIC_PACKET_KEY_1_RTT ||
+        Builder->Metadata->Flags.KeyType == QUIC_PACKET_KEY_0_RTT;
+
+    //
+    // Now fill the packet with available frames, in priority order, until we
+    // run out of space. The order below was generally chosen based on the
+    // perceived importance of each type of frame. ACKs are the most important
+    // frame, followed by connection close and then the rest of the connection
+    // specific frames.
+    //
+
+    if (Builder->PacketType != QUIC_0_RTT_PROTECTED &&
+        QuicAckTrackerHasPacketsToAck(&Packets->AckTracker)) {
+        if (!QuicAckTrackerAckFrameEncode(&Packets->AckTracker, Builder)) {
+            RanOutOfRoom = TRUE;
+            goto Exit;
+        }
+    }
+
+    if (!IsCongestionControlBlocked &&
+        Send->SendFlags & QUIC_CONN_SEND_FLAG_CRYPTO &&
+        Builder->PacketType == QuicEncryptLevelToPacketType(QuicCryptoGetNextEncryptLevel(&Connection->Crypto))) {
+        if (QuicCryptoWriteFrames(&Connection->Crypto, Builder)) {
+            if (Builder->Metadata->FrameCount == QUIC_MAX_FRAMES_PER_PACKET) {
+                return TRUE;
+            }
         } else {
             RanOutOfRoom = TRUE;
         }
     }
 
+    if (Send->SendFlags & QUIC_CONN_SEND_FLAGS_RARE) {
+        if (QuicSendWriteRareFrames(
+                Send,
+                Builder,
+                AvailableBufferLength,
+                IsCongestionControlBlocked,
+                Is1RttEncryptionLevel,
+                &RanOutOfRoom)) {
+            return TRUE;
+        }
+    } else if (IsCongestionControlBlocked) {
+        //
+        // Nothing else is allowed to be sent while blocked by congestion
+        // control.
+        //
+        RanOutOfRoom = TRUE;
+    }
+
 Exit:
 
     //
@@ -832,10 +1053,21 @@ QuicSendGetNextStream(
 
             if (Connection->State.UseRoundRobinStreamScheduling) {
                 //
-                // Move the stream to the end of the queue.
+                // Move the stream behind any other queued streams of the same
+                // priority, so equal priority streams share the connection
+                // round robin while higher priority ones still go first.
                 //
-                QuicListEntryRemove(&Stream->SendLink);
-                QuicListInsertTail(&Send->SendStreams, &Stream->SendLink);
+                QUIC_LIST_ENTRY* LastEntry = Stream->SendLink.Flink;
+                while (LastEntry != &Send->SendStreams &&
+                    Stream->SendPriority <=
+                        QUIC_CONTAINING_RECORD(
+                            LastEntry, QUIC_STREAM, SendLink)->SendPriority) {
+                    LastEntry = LastEntry->Flink;
+                }
+                if (LastEntry->Blink != &Stream->SendLink) {
+                    QuicListEntryRemove(&Stream->SendLink);
+                    QuicListInsertTail(LastEntry, &Stream->SendLink); // Insert before LastEntry.
+                }
 
                 *PacketCount = QUIC_STREAM_SEND_BATCH_COUNT;
 
@@ -917,6 +1149,89 @@ QuicSendPathChallenges(
     }
 }
 
+//
+// This function immediately echoes a PATH_RESPONSE frame on every path that
+// currently owes one, each on its own path so the response takes the route
+// the challenge arrived on. Called straight from receive processing so
+// migration probes are answered without a send flush round trip.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSendPathResponses(
+    _In_ QUIC_SEND* Send
+    )
+{
+    QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
+    BOOLEAN AnyDeferred = FALSE;
+
+    QUIC_DBG_ASSERT(Connection->Crypto.TlsState.WriteKeys[QUIC_PACKET_KEY_1_RTT] != NULL);
+
+    for (uint8_t i = 0; i < Connection->PathsCount; ++i) {
+
+        QUIC_PATH* Path = &Connection->Paths[i];
+        if (!Path->SendResponse) {
+            continue;
+        }
+
+        if (Path->Allowance < QUIC_MIN_SEND_ALLOWANCE) {
+            AnyDeferred = TRUE;
+            continue;
+        }
+
+        QUIC_PACKET_BUILDER Builder = { 0 };
+        if (!QuicPacketBuilderInitialize(&Builder, Connection, Path)) {
+            AnyDeferred = TRUE;
+            continue;
+        }
+        _Analysis_assume_(Builder.Metadata != NULL);
+
+        if (!QuicPacketBuilderPrepareForControlFrames(
+                &Builder, FALSE, QUIC_CONN_SEND_FLAG_PATH_RESPONSE)) {
+            AnyDeferred = TRUE;
+            continue;
+        }
+
+        uint16_t AvailableBufferLength =
+            (uint16_t)Builder.Datagram->Length - Builder.EncryptionOverhead;
+
+        QUIC_PATH_RESPONSE_EX Frame = { 0 };
+        QuicCopyMemory(Frame.Data, Path->Response, sizeof(Frame.Data));
+
+        BOOLEAN Result =
+            QuicPathChallengeFrameEncode(
+                QUIC_FRAME_PATH_RESPONSE,
+                &Frame,
+                &Builder.DatagramLength,
+                AvailableBufferLength,
+                Builder.Datagram->Buffer);
+
+        QUIC_DBG_ASSERT(Result);
+        if (Result) {
+            QuicCopyMemory(
+                Builder.Metadata->Frames[0].PATH_RESPONSE.Data,
+                Frame.Data,
+                sizeof(Frame.Data));
+
+            Result = QuicPacketBuilderAddFrame(&Builder, QUIC_FRAME_PATH_RESPONSE, TRUE);
+            QUIC_DBG_ASSERT(!Result);
+            UNREFERENCED_PARAMETER(Result);
+
+            Path->SendResponse = FALSE;
+        } else {
+            AnyDeferred = TRUE;
+        }
+
+        QuicPacketBuilderFinalize(&Builder, TRUE);
+    }
+
+    if (AnyDeferred) {
+        //
+        // Leave the remaining responses to the normal send flush.
+        //
+        QuicSendSetSendFlag(Send, QUIC_CONN_SEND_FLAG_PATH_RESPONSE);
+    }
+}
+
 typedef enum QUIC_SEND_RESULT {
 
     QUIC_SEND_COMPLETE,
@@ -925,6 +1240,173 @@ typedef enum QUIC_SEND_RESULT {
 
 } QUIC_SEND_RESULT;
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicSendReleaseCachedPayload(
+    _In_ QUIC_SEND* Send,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    )
+{
+    QUIC_DBG_ASSERT(Packet->CachedPayload != NULL);
+    QUIC_DBG_ASSERT(Send->RetransmitCacheBytes >= Packet->CachedPayloadLength);
+    QUIC_FREE(Packet->CachedPayload);
+    Packet->CachedPayload = NULL;
+    Send->RetransmitCacheBytes -= Packet->CachedPayloadLength;
+    Packet->CachedPayloadLength = 0;
+}
+
+//
+// Adds a stream reference for each frame in the packet metadata that holds a
+// stream pointer. Mirrors the releases done by
+// QuicSentPacketPoolReturnPacketMetadata.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicSendAddPacketMetadataStreamRefs(
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    )
+{
+    for (uint8_t i = 0; i < Packet->FrameCount; i++) {
+        switch (Packet->Frames[i].Type)
+        {
+        case QUIC_FRAME_RESET_STREAM:
+            QuicStreamAddRef(Packet->Frames[i].RESET_STREAM.Stream, QUIC_STREAM_REF_SEND_PACKET);
+            break;
+        case QUIC_FRAME_MAX_STREAM_DATA:
+            QuicStreamAddRef(Packet->Frames[i].MAX_STREAM_DATA.Stream, QUIC_STREAM_REF_SEND_PACKET);
+            break;
+        case QUIC_FRAME_STREAM_DATA_BLOCKED:
+            QuicStreamAddRef(Packet->Frames[i].STREAM_DATA_BLOCKED.Stream, QUIC_STREAM_REF_SEND_PACKET);
+            break;
+        case QUIC_FRAME_STOP_SENDING:
+            QuicStreamAddRef(Packet->Frames[i].STOP_SENDING.Stream, QUIC_STREAM_REF_SEND_PACKET);
+            break;
+        case QUIC_FRAME_STREAM:
+            QuicStreamAddRef(Packet->Frames[i].STREAM.Stream, QUIC_STREAM_REF_SEND_PACKET);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicSendQueueRetransmitPacket(
+    _In_ QUIC_SEND* Send,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    )
+{
+    QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
+    QUIC_DBG_ASSERT(Packet->CachedPayload != NULL);
+
+    QUIC_SENT_PACKET_METADATA* Clone =
+        QuicSentPacketPoolGetPacketMetadata(
+            &Connection->Worker->SentPacketPool, Packet->FrameCount);
+    if (Clone == NULL) {
+        return FALSE;
+    }
+    QuicCopyMemory(
+        Clone,
+        Packet,
+        sizeof(QUIC_SENT_PACKET_METADATA) +
+        sizeof(QUIC_SENT_FRAME_METADATA) * Packet->FrameCount);
+    Clone->Next = NULL;
+
+    //
+    // The clone takes over the cached payload and its own stream references.
+    //
+    Packet->CachedPayload = NULL;
+    Packet->CachedPayloadLength = 0;
+    QuicSendAddPacketMetadataStreamRefs(Clone);
+
+    *Send->RetransmitCacheTail = Clone;
+    Send->RetransmitCacheTail = &Clone->Next;
+
+    QuicSendQueueFlush(Send, REASON_LOSS);
+    return TRUE;
+}
+
+//
+// Writes the head retransmit cache entry's payload into the current (empty)
+// packet being built. Returns FALSE if the current packet needs to be
+// finalized first.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicSendWriteRetransmitPacket(
+    _In_ QUIC_SEND* Send,
+    _Inout_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
+    QUIC_SENT_PACKET_METADATA* Packet = Send->RetransmitCache;
+    QUIC_DBG_ASSERT(Packet != NULL);
+    QUIC_DBG_ASSERT(Packet->CachedPayload != NULL);
+
+    if (Builder->Metadata->FrameCount != 0) {
+        //
+        // The cached payload is a complete packet payload, so it needs an
+        // empty packet to copy into. Finalize the current packet and let the
+        // next loop iteration start a fresh one.
+        //
+        return FALSE;
+    }
+
+    Send->RetransmitCache = Packet->Next;
+    if (Send->RetransmitCache == NULL) {
+        Send->RetransmitCacheTail = &Send->RetransmitCache;
+    }
+
+    if ((uint32_t)Builder->DatagramLength + Packet->CachedPayloadLength +
+            Builder->EncryptionOverhead > Builder->Datagram->Length) {
+        //
+        // The payload no longer fits in a datagram (e.g. the path MTU
+        // shrank), so fall back to re-framing the data from scratch.
+        //
+        QuicSendReleaseCachedPayload(Send, Packet);
+        QuicLossDetectionRetransmitFrames(&Connection->LossDetection, Packet);
+        QuicSentPacketPoolReturnPacketMetadata(
+            &Connection->Worker->SentPacketPool, Packet);
+        return FALSE;
+    }
+
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_DATAPATH,
+        RetransmitCachedPayload,
+        Connection,
+        "Retransmitting cached payload of packet %llu (%hu bytes)",
+        Packet->PacketNumber,
+        Packet->CachedPayloadLength);
+
+    //
+    // Copy the payload and the frame metadata onto the new packet, which
+    // takes its own stream references.
+    //
+    QuicCopyMemory(
+        Builder->Datagram->Buffer + Builder->DatagramLength,
+        Packet->CachedPayload,
+        Packet->CachedPayloadLength);
+    Builder->DatagramLength += Packet->CachedPayloadLength;
+
+    Builder->Metadata->FrameCount = Packet->FrameCount;
+    QuicCopyMemory(
+        Builder->Metadata->Frames,
+        Packet->Frames,
+        sizeof(QUIC_SENT_FRAME_METADATA) * Packet->FrameCount);
+    Builder->Metadata->Flags.IsRetransmittable = TRUE;
+    Builder->Metadata->Flags.HasCrypto = Packet->Flags.HasCrypto;
+    QuicSendAddPacketMetadataStreamRefs(Builder->Metadata);
+
+    QuicSendReleaseCachedPayload(Send, Packet);
+    QuicSentPacketPoolReturnPacketMetadata(
+        &Connection->Worker->SentPacketPool, Packet);
+
+    return TRUE;
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 BOOLEAN
 QuicSendFlush(
@@ -939,7 +1421,9 @@ QuicSendFlush(
     QuicConnRemoveOutFlowBlockedReason(
         Connection, QUIC_FLOW_BLOCKED_SCHEDULING | QUIC_FLOW_BLOCKED_PACING);
 
-    if (Send->SendFlags == 0 && QuicListIsEmpty(&Send->SendStreams)) {
+    if (Send->SendFlags == 0 &&
+        QuicListIsEmpty(&Send->SendStreams) &&
+        Send->RetransmitCache == NULL) {
         return TRUE;
     }
 
@@ -953,33 +1437,39 @@ QuicSendFlush(
     QUIC_SEND_RESULT Result = QUIC_SEND_INCOMPLETE;
     QUIC_STREAM* Stream = NULL;
     uint32_t StreamPacketCount = 0;
+    const uint64_t FlushStartTime = QuicTimeUs64();
 
     if (Send->SendFlags & QUIC_CONN_SEND_FLAG_PATH_CHALLENGE) {
         Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_PATH_CHALLENGE;
         QuicSendPathChallenges(Send);
     }
 
-    QUIC_PACKET_BUILDER Builder = { 0 };
-    if (!QuicPacketBuilderInitialize(&Builder, Connection, Path)) {
+    QUIC_PACKET_BUILDER StackBuilder;
+    QUIC_PACKET_BUILDER* Builder =
+        QuicWorkerGetPacketBuilder(Connection->Worker, &StackBuilder);
+    if (!QuicPacketBuilderInitialize(Builder, Connection, Path)) {
         //
         // If this fails, the connection is in a bad (likely partially
         // uninitialized) state, so just ignore the send flush call. This can
         // happen if a loss detection fires right after shutdown.
         //
+        QuicWorkerReleasePacketBuilder(Connection->Worker, Builder);
         return TRUE;
     }
-    _Analysis_assume_(Builder.Metadata != NULL);
+    _Analysis_assume_(Builder->Metadata != NULL);
 
-    QuicTraceLogConnVerbose(
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_DATAPATH,
         FlushSend,
         Connection,
         "Flushing send. Allowance=%u bytes",
-        Builder.SendAllowance);
+        Builder->SendAllowance);
 
     do {
 
-        if (Path->Allowance < QUIC_MIN_SEND_ALLOWANCE) {
-            QuicTraceLogConnVerbose(
+        if (Builder->AmplificationBudget < QUIC_MIN_SEND_ALLOWANCE) {
+            QuicTraceLogConnVerboseClass(
+                QUIC_TRACE_CLASS_DATAPATH,
                 AmplificationProtectionBlocked,
                 Connection,
                 "Cannot send any more because of amplification protection");
@@ -993,7 +1483,7 @@ QuicSendFlush(
             SendFlags &= QUIC_CONN_SEND_FLAG_ALLOWED_HANDSHAKE;
         }
 
-        if (!QuicPacketBuilderHasAllowance(&Builder)) {
+        if (!QuicPacketBuilderHasAllowance(Builder)) {
             //
             // While we are CC blocked, very few things are still allowed to
             // be sent. If those are queued then we can still send.
@@ -1004,17 +1494,34 @@ QuicSendFlush(
                     // The current pacing chunk is finished. We need to schedule a
                     // new pacing send.
                     //
+                    //
+                    // Delay until the pacing rate (roughly one congestion
+                    // window per RTT) has earned another minimum chunk's
+                    // worth of bytes, so chunks are spread evenly over the
+                    // RTT instead of released on a fixed coarse interval.
+                    //
+                    uint32_t PacingDelayMs =
+                        (uint32_t)(
+                            ((uint64_t)QUIC_SEND_PACING_MIN_CHUNK * Path->Mtu *
+                             max(1, US_TO_MS(Path->SmoothedRtt))) /
+                            Connection->CongestionControl.CongestionWindow);
+                    if (PacingDelayMs == 0) {
+                        PacingDelayMs = 1;
+                    } else if (PacingDelayMs > QUIC_SEND_PACING_INTERVAL) {
+                        PacingDelayMs = QUIC_SEND_PACING_INTERVAL;
+                    }
                     QuicConnAddOutFlowBlockedReason(
                         Connection, QUIC_FLOW_BLOCKED_PACING);
-                    QuicTraceLogConnVerbose(
+                    QuicTraceLogConnVerboseClass(
+                        QUIC_TRACE_CLASS_DATAPATH,
                         SetPacingTimer,
                         Connection,
                         "Setting delayed send (PACING) timer for %u ms",
-                        QUIC_SEND_PACING_INTERVAL);
+                        PacingDelayMs);
                     QuicConnTimerSet(
                         Connection,
                         QUIC_CONN_TIMER_PACING,
-                        QUIC_SEND_PACING_INTERVAL);
+                        PacingDelayMs);
                     Result = QUIC_SEND_DELAYED_PACING;
                 } else {
                     //
@@ -1030,29 +1537,38 @@ QuicSendFlush(
         // We write data to packets in the following order:
         //
         //   1. Connection wide control data.
-        //   2. Stream (control and application) data.
-        //   3. Path MTU discovery packets.
+        //   2. Cached payloads of lost packets.
+        //   3. Stream (control and application) data.
+        //   4. Path MTU discovery packets.
         //
 
         BOOLEAN WrotePacketFrames;
         BOOLEAN FlushBatchedDatagrams = FALSE;
         if ((SendFlags & ~QUIC_CONN_SEND_FLAG_PMTUD) != 0) {
             if (!QuicPacketBuilderPrepareForControlFrames(
-                    &Builder,
+                    Builder,
                     Send->TailLossProbeNeeded,
                     Send->SendFlags & ~QUIC_CONN_SEND_FLAG_PMTUD)) {
                 break;
             }
-            WrotePacketFrames = QuicSendWriteFrames(Send, &Builder);
+            WrotePacketFrames = QuicSendWriteFrames(Send, Builder);
+
+        } else if (Send->RetransmitCache != NULL) {
+            if (!QuicPacketBuilderPrepareForStreamFrames(
+                    Builder,
+                    Send->TailLossProbeNeeded)) {
+                break;
+            }
+            WrotePacketFrames = QuicSendWriteRetransmitPacket(Send, Builder);
 
         } else if (Stream != NULL ||
             (Stream = QuicSendGetNextStream(Send, &StreamPacketCount)) != NULL) {
             if (!QuicPacketBuilderPrepareForStreamFrames(
-                    &Builder,
+                    Builder,
                     Send->TailLossProbeNeeded)) {
                 break;
             }
-            WrotePacketFrames = QuicStreamSendWrite(Stream, &Builder);
+            WrotePacketFrames = QuicStreamSendWrite(Stream, Builder);
 
             if (Stream->SendFlags == 0) {
                 //
@@ -1073,19 +1589,19 @@ QuicSendFlush(
             }
 
         } else if (SendFlags == QUIC_CONN_SEND_FLAG_PMTUD) {
-            if (!QuicPacketBuilderPrepareForPathMtuDiscovery(&Builder)) {
+            if (!QuicPacketBuilderPrepareForPathMtuDiscovery(Builder)) {
                 break;
             }
             FlushBatchedDatagrams = TRUE;
             Send->SendFlags &= ~QUIC_CONN_SEND_FLAG_PMTUD;
-            if (Builder.Metadata->FrameCount < QUIC_MAX_FRAMES_PER_PACKET &&
-                Builder.DatagramLength < Builder.Datagram->Length - Builder.EncryptionOverhead) {
+            if (Builder->Metadata->FrameCount < QUIC_MAX_FRAMES_PER_PACKET &&
+                Builder->DatagramLength < Builder->Datagram->Length - Builder->EncryptionOverhead) {
                 //
                 // We are doing PMTUD, so make sure there is a PING frame in there, if
                 // we have room, just to make sure we get an ACK.
                 //
-                Builder.Datagram->Buffer[Builder.DatagramLength++] = QUIC_FRAME_PING;
-                Builder.Metadata->Frames[Builder.Metadata->FrameCount++].Type = QUIC_FRAME_PING;
+                Builder->Datagram->Buffer[Builder->DatagramLength++] = QUIC_FRAME_PING;
+                Builder->Metadata->Frames[Builder->Metadata->FrameCount++].Type = QUIC_FRAME_PING;
                 WrotePacketFrames = TRUE;
             } else {
                 WrotePacketFrames = FALSE;
@@ -1093,8 +1609,11 @@ QuicSendFlush(
 
         } else {
             //
-            // Nothing else left to send right now.
+            // Nothing else left to send right now. The congestion controller
+            // would have allowed more, so the connection is app-limited and
+            // delivery rate samples must be marked accordingly.
             //
+            QuicLossDetectionSetAppLimited(&Connection->LossDetection);
             Result = QUIC_SEND_COMPLETE;
             break;
         }
@@ -1102,22 +1621,33 @@ QuicSendFlush(
         Send->TailLossProbeNeeded = FALSE;
 
         if (!WrotePacketFrames ||
-            Builder.Metadata->FrameCount == QUIC_MAX_FRAMES_PER_PACKET ||
-            Builder.Datagram->Length - Builder.DatagramLength < QUIC_MIN_PACKET_SPARE_SPACE) {
+            Builder->Metadata->FrameCount == QUIC_MAX_FRAMES_PER_PACKET ||
+            Builder->Datagram->Length - Builder->DatagramLength < QUIC_MIN_PACKET_SPARE_SPACE) {
 
             //
             // We now have enough data in the current packet that we should
             // finalize it.
             //
-            QuicPacketBuilderFinalize(&Builder, FlushBatchedDatagrams);
+            QuicPacketBuilderFinalize(Builder, FlushBatchedDatagrams);
         }
 
-    } while (Builder.SendContext != NULL ||
-        Builder.TotalCountDatagrams < QUIC_MAX_DATAGRAMS_PER_SEND);
+        //
+        // Keep building until the datagram budget or the time slice for this
+        // flush is used up. A partially built datagram is always finished
+        // first, so an expired slice never truncates a packet; it just stops
+        // new ones from being started. Breaking out with work remaining
+        // leaves Result as QUIC_SEND_INCOMPLETE, which requeues the flush.
+        //
+    } while (Builder->SendContext != NULL ||
+        (Builder->TotalCountDatagrams < Builder->MaxDatagrams &&
+         QuicTimeDiff64(FlushStartTime, QuicTimeUs64()) <
+            QUIC_OPERATION_TIME_SLICE_US));
 
-    QuicPacketBuilderCleanup(&Builder);
+    QuicPacketBuilderCleanup(Builder);
+    QuicWorkerReleasePacketBuilder(Connection->Worker, Builder);
 
-    QuicTraceLogConnVerbose(
+    QuicTraceLogConnVerboseClass(
+        QUIC_TRACE_CLASS_DATAPATH,
         SendFlushComplete,
         Connection,
         "Flush complete flags=0x%x",
@@ -1152,7 +1682,8 @@ QuicSendStartDelayedAckTimer(
         !Connection->State.ClosedLocally &&
         !Connection->State.ClosedRemotely) {
 
-        QuicTraceLogConnVerbose(
+        QuicTraceLogConnVerboseClass(
+            QUIC_TRACE_CLASS_DATAPATH,
             StartAckDelayTimer,
             Connection,
             "Starting ACK_DELAY timer for %u ms",
@@ -1174,6 +1705,7 @@ QuicSendProcessDelayedAckTimer(
     QUIC_DBG_ASSERT(Send->DelayedAckTimerActive);
     QUIC_DBG_ASSERT(!(Send->SendFlags & QUIC_CONN_SEND_FLAG_ACK));
     Send->DelayedAckTimerActive = FALSE;
+    Send->AckPiggybackDeferred = FALSE;
 
     QUIC_CONNECTION* Connection = QuicSendGetConnection(Send);
 
@@ -1193,23 +1725,3 @@ QuicSendProcessDelayedAckTimer(
 
     QuicSendValidate(Send);
 }
-
-_IRQL_requires_max_(DISPATCH_LEVEL)
-void
-QuicSendOnMtuProbePacketAcked(
-    _In_ QUIC_SEND* Send,
-    _In_ QUIC_PATH* Path,
-    _In_ QUIC_SENT_PACKET_METADATA* Packet
-    )
-{
-    Path->Mtu =
-        PacketSizeFromUdpPayloadSize(
-            QuicAddrGetFamily(&Path->RemoteAddress),
-            Packet->PacketLength);
-    QuicTraceLogConnInfo(
-        PathMtuUpdated,
-        QuicSendGetConnection(Send),
-        "Path[%hhu] MTU updated to %u bytes",
-        Path->ID,
-        Path->Mtu);
-}
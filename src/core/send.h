@@ -84,6 +84,8 @@ QuicPacketTypeToEncryptLevel(
 #define QUIC_CONN_SEND_FLAG_PATH_RESPONSE           0x00000800
 #define QUIC_CONN_SEND_FLAG_PING                    0x00001000
 #define QUIC_CONN_SEND_FLAG_HANDSHAKE_DONE          0x00002000
+#define QUIC_CONN_SEND_FLAG_ACK_FREQUENCY           0x00004000
+#define QUIC_CONN_SEND_FLAG_DATAGRAM                0x00008000
 #define QUIC_CONN_SEND_FLAG_PMTUD                   0x80000000
 
 //
@@ -96,6 +98,29 @@ QuicPacketTypeToEncryptLevel(
     QUIC_CONN_SEND_FLAG_APPLICATION_CLOSE \
 )
 
+//
+// Connection-level frames other than ACK and CRYPTO are rarely pending in
+// steady state. QuicSendWriteFrames tests this mask once per packet and only
+// walks the individual branches for these frames when one of them is set,
+// keeping the common ACK(+STREAM) build path free of dead branches.
+//
+#define QUIC_CONN_SEND_FLAGS_RARE \
+( \
+    QUIC_CONN_SEND_FLAG_CONNECTION_CLOSE | \
+    QUIC_CONN_SEND_FLAG_APPLICATION_CLOSE | \
+    QUIC_CONN_SEND_FLAG_DATA_BLOCKED | \
+    QUIC_CONN_SEND_FLAG_MAX_DATA | \
+    QUIC_CONN_SEND_FLAG_MAX_STREAMS_BIDI | \
+    QUIC_CONN_SEND_FLAG_MAX_STREAMS_UNI | \
+    QUIC_CONN_SEND_FLAG_NEW_CONNECTION_ID | \
+    QUIC_CONN_SEND_FLAG_RETIRE_CONNECTION_ID | \
+    QUIC_CONN_SEND_FLAG_PATH_RESPONSE | \
+    QUIC_CONN_SEND_FLAG_PING | \
+    QUIC_CONN_SEND_FLAG_HANDSHAKE_DONE | \
+    QUIC_CONN_SEND_FLAG_ACK_FREQUENCY | \
+    QUIC_CONN_SEND_FLAG_DATAGRAM \
+)
+
 //
 // Flags we need to remove (and prevent from being added) when the connection
 // is closed.
@@ -111,6 +136,8 @@ QuicPacketTypeToEncryptLevel(
     QUIC_CONN_SEND_FLAG_PATH_CHALLENGE | \
     QUIC_CONN_SEND_FLAG_PATH_RESPONSE | \
     QUIC_CONN_SEND_FLAG_PING | \
+    QUIC_CONN_SEND_FLAG_ACK_FREQUENCY | \
+    QUIC_CONN_SEND_FLAG_DATAGRAM | \
     QUIC_CONN_SEND_FLAG_PMTUD \
 )
 
@@ -161,14 +188,16 @@ inline BOOLEAN HasStreamDataFrames(uint32_t Flags)
 typedef struct QUIC_SEND {
 
     //
-    // Indicates the FLUSH_SEND operation is already pending on the Connection.
+    // Indicates the delayed ACK timer is running.
     //
-    BOOLEAN FlushOperationPending : 1;
+    BOOLEAN DelayedAckTimerActive : 1;
 
     //
-    // Indicates the delayed ACK timer is running.
+    // Indicates the delayed ACK timer already expired once with no outbound
+    // data to carry the ACK, and was re-armed for one extra piggyback window.
+    // One-shot: the next expiry always flushes.
     //
-    BOOLEAN DelayedAckTimerActive : 1;
+    BOOLEAN AckPiggybackDeferred : 1;
 
     //
     // TRUE if LastFlushTime is valid (i.e. if there has been at least
@@ -181,6 +210,15 @@ typedef struct QUIC_SEND {
     //
     BOOLEAN TailLossProbeNeeded : 1;
 
+    //
+    // Indicates a FLUSH_SEND operation is already queued on the connection,
+    // which is what collapses a burst of stream unblocks into a single
+    // worker operation. Claimed with an interlocked operation because API
+    // threads queue flushes concurrently with the worker, so it must not
+    // share a byte with the worker-only flags above.
+    //
+    short FlushOperationPending;
+
     //
     // The next packet number to use.
     //
@@ -223,6 +261,15 @@ typedef struct QUIC_SEND {
     //
     QUIC_LIST_ENTRY SendStreams;
 
+    //
+    // Lost packets (with cached plaintext payloads) queued for byte-identical
+    // retransmission, in loss order, and the total number of cached payload
+    // bytes currently allocated against QUIC_RETRANSMIT_CACHE_BUDGET.
+    //
+    QUIC_SENT_PACKET_METADATA* RetransmitCache;
+    QUIC_SENT_PACKET_METADATA** RetransmitCacheTail;
+    uint32_t RetransmitCacheBytes;
+
     //
     // The current token to send with an Initial packet.
     //
@@ -247,6 +294,15 @@ QuicSendUninitialize(
     _In_ QUIC_SEND* Send
     );
 
+//
+// Frees all queued retransmit cache entries.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSendFreeRetransmitCache(
+    _In_ QUIC_SEND* Send
+    );
+
 #if DEBUG
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
@@ -304,7 +360,8 @@ void
 QuicSendQueueFlushForStream(
     _In_ QUIC_SEND* Send,
     _In_ QUIC_STREAM* Stream,
-    _In_ BOOLEAN WasPreviouslyQueued
+    _In_ BOOLEAN WasPreviouslyQueued,
+    _In_ BOOLEAN DelaySend
     );
 
 //
@@ -317,6 +374,42 @@ QuicSendFlush(
     _In_ QUIC_SEND* Send
     );
 
+//
+// Immediately sends a PATH_RESPONSE frame on every path that currently owes
+// one, without waiting for the queued send flush. Paths that can't be
+// serviced right now (no allowance, no packet buffer) fall back to the
+// normal flush via the PATH_RESPONSE send flag.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSendPathResponses(
+    _In_ QUIC_SEND* Send
+    );
+
+//
+// Queues a lost packet's cached plaintext payload for byte-identical
+// retransmission. Returns FALSE if the clone couldn't be allocated, in which
+// case the caller falls back to re-framing the data.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicSendQueueRetransmitPacket(
+    _In_ QUIC_SEND* Send,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    );
+
+//
+// Frees a packet's cached payload copy and returns its bytes to the
+// connection's retransmit cache budget.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicSendReleaseCachedPayload(
+    _In_ QUIC_SEND* Send,
+    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    );
+
 //
 // Starts the delayed ACK timer if not already running.
 //
@@ -346,6 +439,19 @@ QuicSendSetSendFlag(
     _In_ uint32_t SendFlag
     );
 
+//
+// Same as QuicSendSetSendFlag, except no send flush is scheduled: the frames
+// ride along with the next packet sent for any other reason. Only for frames
+// that are purely advisory until some threshold is crossed (e.g. flow control
+// updates).
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicSendSetDelayedSendFlag(
+    _In_ QUIC_SEND* Send,
+    _In_ uint32_t SendFlag
+    );
+
 //
 // Clears the given QUIC_CONN_SEND_FLAG_*.
 //
@@ -374,7 +480,8 @@ BOOLEAN
 QuicSendSetStreamSendFlag(
     _In_ QUIC_SEND* Send,
     _In_ QUIC_STREAM* Stream,
-    _In_ uint32_t SendFlag
+    _In_ uint32_t SendFlag,
+    _In_ BOOLEAN DelaySend
     );
 
 //
@@ -390,14 +497,13 @@ QuicSendClearStreamSendFlag(
     );
 
 //
-// Invoked on receiving an ACK for a MTU probe packet.
+// Updates the stream's position in the send queue after its priority changed.
 //
-_IRQL_requires_max_(DISPATCH_LEVEL)
+_IRQL_requires_max_(PASSIVE_LEVEL)
 void
-QuicSendOnMtuProbePacketAcked(
+QuicSendUpdateStreamPriority(
     _In_ QUIC_SEND* Send,
-    _In_ QUIC_PATH* Path,
-    _In_ QUIC_SENT_PACKET_METADATA* Packet
+    _In_ QUIC_STREAM* Stream
     );
 
 #if QUIC_SEND_FAKE_LOSS
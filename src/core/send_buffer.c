@@ -74,6 +74,22 @@ QuicSendBufferUninitialize(
     UNREFERENCED_PARAMETER(SendBuffer);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicSendBufferUpdateStall(
+    _Inout_ QUIC_SEND_BUFFER* SendBuffer
+    )
+{
+    BOOLEAN Stalled = SendBuffer->PostedBytes < SendBuffer->IdealBytes;
+    if (Stalled && SendBuffer->StallStartTimeUs == 0) {
+        SendBuffer->StallStartTimeUs = QuicTimeUs64();
+    } else if (!Stalled && SendBuffer->StallStartTimeUs != 0) {
+        SendBuffer->TotalStallTimeUs +=
+            QuicTimeDiff64(SendBuffer->StallStartTimeUs, QuicTimeUs64());
+        SendBuffer->StallStartTimeUs = 0;
+    }
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Success_(return != NULL)
 uint8_t*
@@ -86,6 +102,7 @@ QuicSendBufferAlloc(
 
     if (Buf != NULL) {
         SendBuffer->BufferedBytes += Size;
+        QuicLibraryOnBufferMemoryChange(Size);
     } else {
         QuicTraceEvent(
             AllocFailure,
@@ -107,6 +124,7 @@ QuicSendBufferFree(
 {
     QUIC_FREE(Buf);
     SendBuffer->BufferedBytes -= Size;
+    QuicLibraryOnBufferMemoryChange(-(int64_t)Size);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -174,7 +192,17 @@ QuicSendBufferFill(
         //
         // Buffer as many requests as we can before moving to the next stream.
         //
+        // A request posted with QUIC_SEND_FLAG_NO_BUFFERING is never copied;
+        // its buffers stay referenced until the bytes are acknowledged and
+        // only then is it completed. To preserve per-stream completion order
+        // it also stops us from buffering (and thereby completing early) any
+        // requests queued behind it. The bookmark advances past it when the
+        // request itself completes.
+        //
         while (Req != NULL && QuicSendBufferHasSpace(&Connection->SendBuffer)) {
+            if (Req->Flags & QUIC_SEND_FLAG_NO_BUFFERING) {
+                break;
+            }
             if (QUIC_FAILED(QuicStreamSendBufferRequest(Stream, Req))) {
                 return;
             }
@@ -236,17 +264,17 @@ QuicSendBufferConnectionAdjust(
         QUIC_IDEAL_SEND_BUFFER_THRESHOLD(Connection->SendBuffer.IdealBytes)) {
         Connection->SendBuffer.IdealBytes =
             min(2 * Connection->CongestionControl.BytesInFlightMax, QUIC_MAX_IDEAL_SEND_BUFFER_SIZE);
+        QuicSendBufferUpdateStall(&Connection->SendBuffer);
 
-        QUIC_HASHTABLE_ENUMERATOR Enumerator;
-        QUIC_HASHTABLE_ENTRY* Entry;
-        QuicHashtableEnumerateBegin(Connection->Streams.StreamTable, &Enumerator);
-        while ((Entry = QuicHashtableEnumerateNext(Connection->Streams.StreamTable, &Enumerator)) != NULL) {
-            QUIC_STREAM* Stream = QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
+        QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+        QUIC_STREAM* Stream;
+        QuicFlatHashtableEnumerateBegin(Connection->Streams.StreamTable, &Enumerator);
+        while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(Connection->Streams.StreamTable, &Enumerator)) != NULL) {
             if (Stream->Flags.SendEnabled) {
                 QuicSendBufferStreamAdjust(Stream);
             }
         }
-        QuicHashtableEnumerateEnd(Connection->Streams.StreamTable, &Enumerator);
+        QuicFlatHashtableEnumerateEnd(Connection->Streams.StreamTable, &Enumerator);
 
         if (Connection->State.UseSendBuffer) {
             QuicSendBufferFill(Connection);
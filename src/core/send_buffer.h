@@ -27,6 +27,14 @@ typedef struct QUIC_SEND_BUFFER {
     //
     uint64_t IdealBytes;
 
+    //
+    // Accumulated time, in microseconds, that PostedBytes has been below
+    // IdealBytes (i.e. the app wasn't keeping the send pipeline full), plus
+    // the start time of the current such period (nonzero while stalled).
+    //
+    uint64_t TotalStallTimeUs;
+    uint64_t StallStartTimeUs;
+
 } QUIC_SEND_BUFFER;
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -41,6 +49,17 @@ QuicSendBufferUninitialize(
     _In_ QUIC_SEND_BUFFER* SendBuffer
     );
 
+//
+// Starts or stops the send buffer stall clock based on the current posted
+// byte accounting. Should be called whenever PostedBytes or IdealBytes
+// changes.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicSendBufferUpdateStall(
+    _Inout_ QUIC_SEND_BUFFER* SendBuffer
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Success_(return != NULL)
 uint8_t*
@@ -11,8 +11,9 @@ Abstract:
     to determine what exactly was acknowledged or lost.
 
     The size of a QUIC_SENT_PACKET_METADATA depends on the number of frames
-    contained in the packet. The allocator uses a different pool for each
-    possible size.
+    contained in the packet. The allocator uses two size classes: a compact
+    one covering the common few-frame packets and a maximum sized one for the
+    rare packets with more frames than that.
 
 --*/
 
@@ -24,16 +25,16 @@ QuicSentPacketPoolInitialize(
     _Inout_ QUIC_SENT_PACKET_POOL* Pool
     )
 {
-    for (uint8_t i = 0; i < ARRAYSIZE(Pool->Pools); i++) {
-        uint16_t PacketMetadataSize =
-            (i + 1) * sizeof(QUIC_SENT_FRAME_METADATA) +
-            sizeof(QUIC_SENT_PACKET_METADATA);
-
-        QuicPoolInitialize(
-            FALSE,  // IsPaged
-            PacketMetadataSize,
-            Pool->Pools + i);
-    }
+    QuicPoolInitialize(
+        FALSE,  // IsPaged
+        sizeof(QUIC_SENT_PACKET_METADATA) +
+            QUIC_SENT_PACKET_FEW_FRAME_COUNT * sizeof(QUIC_SENT_FRAME_METADATA),
+        &Pool->FewFramePool);
+    QuicPoolInitialize(
+        FALSE,  // IsPaged
+        sizeof(QUIC_SENT_PACKET_METADATA) +
+            QUIC_MAX_FRAMES_PER_PACKET * sizeof(QUIC_SENT_FRAME_METADATA),
+        &Pool->MaxFramePool);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -42,9 +43,8 @@ QuicSentPacketPoolUninitialize(
     _In_ QUIC_SENT_PACKET_POOL* Pool
     )
 {
-    for (uint8_t i = 0; i < ARRAYSIZE(Pool->Pools); i++) {
-        QuicPoolUninitialize(Pool->Pools + i);
-    }
+    QuicPoolUninitialize(&Pool->FewFramePool);
+    QuicPoolUninitialize(&Pool->MaxFramePool);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -54,9 +54,13 @@ QuicSentPacketPoolGetPacketMetadata(
     _In_ uint8_t FrameCount
     )
 {
+    QUIC_DBG_ASSERT(
+        FrameCount > 0 && FrameCount <= QUIC_MAX_FRAMES_PER_PACKET);
     return
         (QUIC_SENT_PACKET_METADATA*)
-        QuicPoolAlloc(Pool->Pools + FrameCount - 1);
+        QuicPoolAlloc(
+            FrameCount <= QUIC_SENT_PACKET_FEW_FRAME_COUNT ?
+                &Pool->FewFramePool : &Pool->MaxFramePool);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -96,5 +100,8 @@ QuicSentPacketPoolReturnPacketMetadata(
         }
     }
 
-    QuicPoolFree(Pool->Pools + Metadata->FrameCount - 1, Metadata);
+    QuicPoolFree(
+        Metadata->FrameCount <= QUIC_SENT_PACKET_FEW_FRAME_COUNT ?
+            &Pool->FewFramePool : &Pool->MaxFramePool,
+        Metadata);
 }
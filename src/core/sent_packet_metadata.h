@@ -63,6 +63,12 @@ typedef struct QUIC_SENT_FRAME_METADATA {
         struct {
             uint8_t Data[8];
         } PATH_RESPONSE;
+        struct {
+            QUIC_VAR_INT Sequence;
+        } ACK_FREQUENCY;
+        struct {
+            void* ClientContext;
+        } DATAGRAM;
     };
     uint8_t Type; // QUIC_FRAME_*
     uint8_t Flags; // QUIC_SENT_FRAME_FLAG_*
@@ -76,6 +82,8 @@ typedef struct QUIC_SEND_PACKET_FLAGS {
     BOOLEAN HasCrypto               : 1;
     BOOLEAN IsPMTUD                 : 1;
     BOOLEAN KeyPhase                : 1;
+    BOOLEAN EcnEctSet               : 1; // Sent with the ECT(0) codepoint.
+    BOOLEAN IsAppLimited            : 1; // Sent while starved for app data.
 
 } QUIC_SEND_PACKET_FLAGS;
 
@@ -96,6 +104,22 @@ typedef struct QUIC_SENT_PACKET_METADATA {
     //
     QUIC_SEND_PACKET_FLAGS Flags;
 
+    //
+    // Optional copy of the packet's plaintext frame payload, kept so a lost
+    // packet can be retransmitted by re-encrypting the same bytes under a new
+    // packet number instead of re-framing the data from scratch. Allocated
+    // against the connection's retransmit cache budget.
+    //
+    uint8_t* CachedPayload;
+    uint16_t CachedPayloadLength;
+
+    //
+    // Snapshot of the loss detection delivery totals when this packet was
+    // sent, used to produce a delivery rate sample when it is acknowledged.
+    //
+    uint64_t Delivered;
+    uint32_t DeliveredTime; // In microseconds
+
     //
     // Frames included in this packet.
     //
@@ -134,12 +158,27 @@ QUIC_STATIC_ASSERT(
     "Max Send Packet Metadata should be small enough to be allocated on the stack");
 
 //
-// A collection of object pools for each size of packet and
-// associated frame metadata.
+// The number of frames the compact sent packet metadata layout can hold.
+// The vast majority of packets carry at most a STREAM frame, an ACK and one
+// more control frame, so this covers the common case while keeping the
+// allocation small enough to fit in two cache lines.
+//
+#define QUIC_SENT_PACKET_FEW_FRAME_COUNT 3
+
+QUIC_STATIC_ASSERT(
+    sizeof(QUIC_SENT_PACKET_METADATA) +
+        QUIC_SENT_PACKET_FEW_FRAME_COUNT * sizeof(QUIC_SENT_FRAME_METADATA) <= 128,
+    "Few frame sent packet metadata should fit in two cache lines");
+
+//
+// A pair of object pools for sent packet metadata: a compact fixed size for
+// the common few-frame packets and a maximum size for the rare many-frame
+// packets.
 //
 typedef struct QUIC_SENT_PACKET_POOL {
 
-    QUIC_POOL Pools[QUIC_MAX_FRAMES_PER_PACKET];
+    QUIC_POOL FewFramePool; // Up to QUIC_SENT_PACKET_FEW_FRAME_COUNT frames.
+    QUIC_POOL MaxFramePool; // Up to QUIC_MAX_FRAMES_PER_PACKET frames.
 
 } QUIC_SENT_PACKET_POOL;
 
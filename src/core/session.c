@@ -88,8 +88,15 @@ QuicSessionAlloc(
 
     QuicRundownInitialize(&Session->Rundown);
     QuicRwLockInitialize(&Session->ServerCacheLock);
+    for (uint32_t i = 0; i < QUIC_SERVER_TICKET_SHARD_COUNT; ++i) {
+        QuicRwLockInitialize(&Session->ServerTicketShards[i].Lock);
+        QuicListInitializeHead(&Session->ServerTicketShards[i].EvictionList);
+        Session->ServerTicketShards[i].Count = 0;
+    }
+    Session->ServerTicketCacheCapacity = QUIC_DEFAULT_SERVER_TICKET_CACHE_CAPACITY;
     QuicDispatchLockInitialize(&Session->ConnectionsLock);
     QuicListInitializeHead(&Session->Connections);
+    QuicDispatchLockInitialize(&Session->TpCacheLock);
 
     *NewSession = Session;
 
@@ -139,6 +146,24 @@ MsQuicSessionFree(
         }
         QuicHashtableUninitialize(&Session->ServerCache);
 
+        //
+        // Enumerate and free all entries in the server ticket cache shards.
+        //
+        for (uint32_t i = 0; i < QUIC_SERVER_TICKET_SHARD_COUNT; ++i) {
+            QUIC_SERVER_TICKET_SHARD* Shard = &Session->ServerTicketShards[i];
+            QuicHashtableEnumerateBegin(&Shard->Table, &Enumerator);
+            while (TRUE) {
+                Entry = QuicHashtableEnumerateNext(&Shard->Table, &Enumerator);
+                if (Entry == NULL) {
+                    QuicHashtableEnumerateEnd(&Shard->Table, &Enumerator);
+                    break;
+                }
+                QuicHashtableRemove(&Shard->Table, Entry, NULL);
+                QUIC_FREE(Entry);
+            }
+            QuicHashtableUninitialize(&Shard->Table);
+        }
+
         QuicStorageClose(Session->AppSpecificStorage);
 #ifdef QUIC_SILO
         QuicStorageClose(Session->Storage);
@@ -146,7 +171,25 @@ MsQuicSessionFree(
 #endif
     }
 
+    //
+    // No readers are left at this point (the storages above no longer deliver
+    // change notifications either), so the whole snapshot chain can go.
+    //
+    QUIC_SETTINGS_SNAPSHOT* Snapshot = Session->SettingsSnapshot;
+    while (Snapshot != NULL) {
+        QUIC_SETTINGS_SNAPSHOT* Retired = Snapshot->Retired;
+        QUIC_FREE(Snapshot);
+        Snapshot = Retired;
+    }
+
+    if (Session->TpCacheBlob != NULL) {
+        QUIC_FREE(Session->TpCacheBlob);
+    }
+    QuicDispatchLockUninitialize(&Session->TpCacheLock);
     QuicDispatchLockUninitialize(&Session->ConnectionsLock);
+    for (uint32_t i = 0; i < QUIC_SERVER_TICKET_SHARD_COUNT; ++i) {
+        QuicRwLockUninitialize(&Session->ServerTicketShards[i].Lock);
+    }
     QuicRwLockUninitialize(&Session->ServerCacheLock);
     QuicTraceEvent(
         SessionDestroyed,
@@ -207,6 +250,28 @@ MsQuicSessionOpen(
         goto Error;
     }
 
+    uint32_t ShardsInitialized = 0;
+    while (ShardsInitialized < QUIC_SERVER_TICKET_SHARD_COUNT &&
+        QuicHashtableInitializeEx(
+            &Session->ServerTicketShards[ShardsInitialized].Table,
+            QUIC_HASH_MIN_SIZE)) {
+        ShardsInitialized++;
+    }
+    if (ShardsInitialized != QUIC_SERVER_TICKET_SHARD_COUNT) {
+        QuicTraceEvent(
+            SessionError,
+            "[sess][%p] ERROR, %s.",
+            Session,
+            "Server ticket cache initialize");
+        while (ShardsInitialized != 0) {
+            QuicHashtableUninitialize(
+                &Session->ServerTicketShards[--ShardsInitialized].Table);
+        }
+        QuicHashtableUninitialize(&Session->ServerCache);
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        goto Error;
+    }
+
     Status = QuicTlsSessionInitialize(&Session->TlsSession);
     if (QUIC_FAILED(Status)) {
         QuicTraceEvent(
@@ -215,6 +280,9 @@ MsQuicSessionOpen(
             Session,
             Status,
             "QuicTlsSessionInitialize");
+        for (uint32_t i = 0; i < QUIC_SERVER_TICKET_SHARD_COUNT; ++i) {
+            QuicHashtableUninitialize(&Session->ServerTicketShards[i].Table);
+        }
         QuicHashtableUninitialize(&Session->ServerCache);
         goto Error;
     }
@@ -265,6 +333,14 @@ MsQuicSessionOpen(
     }
 
     QuicSessionSettingsChanged(Session);
+    if (Session->SettingsSnapshot == NULL) {
+        //
+        // The initial settings snapshot couldn't be allocated, and every
+        // connection registration depends on one existing.
+        //
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        goto Error;
+    }
 
     QuicLockAcquire(&Session->Registration->Lock);
     QuicListInsertTail(&Session->Registration->Sessions, &Session->Link);
@@ -319,6 +395,16 @@ MsQuicSessionClose(
         "[sess][%p] Cleaning up",
         Session);
 
+    if (Session->DrainThreadStarted) {
+        //
+        // End any in-progress paced drain before tearing the session down.
+        //
+        Session->DrainStop = TRUE;
+        QuicThreadWait(&Session->DrainThread);
+        QuicThreadDelete(&Session->DrainThread);
+        Session->DrainThreadStarted = FALSE;
+    }
+
     if (Session->Registration != NULL) {
         QuicLockAcquire(&Session->Registration->Lock);
         QuicListEntryRemove(&Session->Link);
@@ -410,6 +496,157 @@ MsQuicSessionShutdown(
         "[ api] Exit");
 }
 
+//
+// Thread callback that paces a session drain. Each time slice it queues a
+// shutdown on a bounded batch of connections, rotating each processed entry
+// to the tail of the connection list, and exits once the head of the list
+// has already been processed (meaning every connection has been visited) or
+// the session starts closing. Connections registered after the drain has
+// rotated past them are not shut down, matching SessionShutdown's snapshot
+// semantics.
+//
+QUIC_THREAD_CALLBACK(QuicSessionDrainThread, Context)
+{
+    QUIC_SESSION* Session = (QUIC_SESSION*)Context;
+
+    //
+    // Queue shutdowns in ten batches per second, so each slice stays small
+    // and a coarse sleep suffices for the pacing.
+    //
+    uint32_t BatchSize = Session->DrainRatePerSecond / 10;
+    if (BatchSize == 0) {
+        BatchSize = 1;
+    }
+
+    BOOLEAN Complete = FALSE;
+    while (!Complete && !Session->DrainStop) {
+
+        QuicDispatchLockAcquire(&Session->ConnectionsLock);
+
+        for (uint32_t i = 0; i < BatchSize; ++i) {
+            if (QuicListIsEmpty(&Session->Connections)) {
+                Complete = TRUE;
+                break;
+            }
+
+            QUIC_CONNECTION* Connection =
+                QUIC_CONTAINING_RECORD(
+                    Session->Connections.Flink, QUIC_CONNECTION, SessionLink);
+
+            if (Connection->State.DrainShutdownQueued) {
+                //
+                // Processed entries sit at the tail, so a processed head
+                // means the drain has visited every connection.
+                //
+                Complete = TRUE;
+                break;
+            }
+
+            Connection->State.DrainShutdownQueued = TRUE;
+            QuicListEntryRemove(&Connection->SessionLink);
+            QuicListInsertTail(&Session->Connections, &Connection->SessionLink);
+
+            if (InterlockedCompareExchange16(
+                    (short*)&Connection->BackUpOperUsed, 1, 0) == 0) {
+
+                QUIC_OPERATION* Oper = &Connection->BackUpOper;
+                Oper->FreeAfterProcess = FALSE;
+                Oper->Type = QUIC_OPER_TYPE_API_CALL;
+                Oper->API_CALL.Context = &Connection->BackupApiContext;
+                Oper->API_CALL.Context->Type = QUIC_API_TYPE_CONN_SHUTDOWN;
+                Oper->API_CALL.Context->CONN_SHUTDOWN.Flags = Session->DrainFlags;
+                Oper->API_CALL.Context->CONN_SHUTDOWN.ErrorCode = Session->DrainErrorCode;
+                QuicConnQueueHighestPriorityOper(Connection, Oper);
+            }
+        }
+
+        QuicDispatchLockRelease(&Session->ConnectionsLock);
+
+        if (!Complete && !Session->DrainStop) {
+            QuicSleep(100); // One pacing slice.
+        }
+    }
+
+    QuicTraceLogInfo(
+        SessionDrainComplete,
+        "[sess][%p] Drain complete",
+        Session);
+
+    QUIC_THREAD_RETURN(QUIC_STATUS_SUCCESS);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QUIC_API
+MsQuicSessionDrain(
+    _In_ _Pre_defensive_ HQUIC Handle,
+    _In_ QUIC_CONNECTION_SHUTDOWN_FLAGS Flags,
+    _In_ _Pre_defensive_ QUIC_UINT62 ErrorCode,
+    _In_ uint32_t RatePerSecond
+    )
+{
+    QUIC_STATUS Status;
+
+    QuicTraceEvent(
+        ApiEnter,
+        "[ api] Enter %u (%p).",
+        QUIC_TRACE_API_SESSION_DRAIN,
+        Handle);
+
+    if (Handle == NULL ||
+        Handle->Type != QUIC_HANDLE_TYPE_SESSION ||
+        ErrorCode > QUIC_UINT62_MAX ||
+        RatePerSecond == 0) {
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        goto Error;
+    }
+
+#pragma prefast(suppress: __WARNING_25024, "Pointer cast already validated.")
+    QUIC_SESSION* Session = (QUIC_SESSION*)Handle;
+
+    if (InterlockedCompareExchange16(&Session->DrainActive, 1, 0) != 0) {
+        Status = QUIC_STATUS_INVALID_STATE;
+        goto Error;
+    }
+
+    QuicTraceLogInfo(
+        SessionDrainStart,
+        "[sess][%p] Draining connections, Flags=%u, ErrorCode=%llu, Rate=%u",
+        Session,
+        Flags,
+        ErrorCode,
+        RatePerSecond);
+
+    Session->DrainFlags = Flags;
+    Session->DrainErrorCode = ErrorCode;
+    Session->DrainRatePerSecond = RatePerSecond;
+    Session->DrainStop = FALSE;
+
+    QUIC_THREAD_CONFIG ThreadConfig = {
+        0,
+        0,
+        "quic_drain",
+        QuicSessionDrainThread,
+        Session
+    };
+
+    Status = QuicThreadCreate(&ThreadConfig, &Session->DrainThread);
+    if (QUIC_FAILED(Status)) {
+        InterlockedCompareExchange16(&Session->DrainActive, 0, 1);
+        goto Error;
+    }
+    Session->DrainThreadStarted = TRUE;
+
+Error:
+
+    QuicTraceEvent(
+        ApiExitStatus,
+        "[ api] Exit %u",
+        Status);
+
+    return Status;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 const uint8_t*
 QuicSessionFindAlpnInList(
@@ -506,6 +743,35 @@ QuicSessionTraceRundown(
     QuicDispatchLockRelease(&Session->ConnectionsLock);
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionSettingsPublish(
+    _Inout_ QUIC_SESSION* Session
+    )
+{
+    QUIC_SETTINGS_SNAPSHOT* Snapshot =
+        QUIC_ALLOC_NONPAGED(sizeof(QUIC_SETTINGS_SNAPSHOT));
+    if (Snapshot == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "settings snapshot",
+            sizeof(QUIC_SETTINGS_SNAPSHOT));
+        return; // Readers keep using the previous snapshot.
+    }
+
+    Snapshot->Settings = Session->Settings;
+
+    //
+    // Swap the new snapshot in and chain the replaced one behind it. The old
+    // snapshot may still be in use by a concurrent reader, so it is not freed
+    // until the whole chain is torn down with the session.
+    //
+    Snapshot->Retired =
+        (QUIC_SETTINGS_SNAPSHOT*)InterlockedExchangePointer(
+            (void**)&Session->SettingsSnapshot, Snapshot);
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 _Function_class_(QUIC_STORAGE_CHANGE_CALLBACK)
 void
@@ -524,6 +790,16 @@ QuicSessionSettingsChanged(
     QuicSettingsCopy(&Session->Settings, &MsQuicLib.Settings);
 #endif
 
+    //
+    // The registration's execution profile provides coherent defaults for
+    // the scheduling related settings; explicit app and app specific storage
+    // settings still win.
+    //
+    if (Session->Registration != NULL) {
+        QuicSettingsApplyExecProfile(
+            &Session->Settings, Session->Registration->ExecProfile);
+    }
+
     if (Session->AppSpecificStorage != NULL) {
         QuicSettingsLoad(&Session->Settings, Session->AppSpecificStorage);
     }
@@ -534,6 +810,25 @@ QuicSessionSettingsChanged(
         Session,
         &Session->Settings);
     QuicSettingsDump(&Session->Settings);
+
+    QuicSessionSettingsPublish(Session);
+
+    //
+    // Propagate the new settings to the existing connections as well, so a
+    // storage-driven tuning change doesn't require connection churn to take
+    // effect. Each connection gets a queued operation that hot-applies the
+    // live-safe subset on its own worker, at normal operation priority.
+    //
+    QuicDispatchLockAcquire(&Session->ConnectionsLock);
+
+    for (QUIC_LIST_ENTRY* Link = Session->Connections.Flink;
+        Link != &Session->Connections;
+        Link = Link->Flink) {
+        QuicConnQueueSettingsUpdate(
+            QUIC_CONTAINING_RECORD(Link, QUIC_CONNECTION, SessionLink));
+    }
+
+    QuicDispatchLockRelease(&Session->ConnectionsLock);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -548,10 +843,15 @@ QuicSessionRegisterConnection(
 
     if (Session->Registration != NULL) {
         Connection->Registration = Session->Registration;
+        Connection->TraceClassMask = Session->Registration->TraceClasses;
 #ifdef QuicVerifierEnabledByAddr
         Connection->State.IsVerifying = Session->Registration->IsVerifying;
 #endif
-        QuicConnApplySettings(Connection, &Session->Settings);
+        //
+        // A single pointer read picks up the current immutable settings
+        // snapshot, so this never contends with a settings change.
+        //
+        QuicConnApplySettings(Connection, &Session->SettingsSnapshot->Settings);
     }
 
     QuicTraceEvent(
@@ -588,6 +888,50 @@ QuicSessionUnregisterConnection(
     QuicRundownRelease(&Session->Rundown);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Ret_maybenull_
+QUIC_CONNECTION*
+QuicSessionPoolLookupConnection(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t ServerNameLength,
+    _In_reads_(ServerNameLength)
+        const char* ServerName,
+    _In_ uint16_t ServerPort
+    )
+{
+    QUIC_CONNECTION* Found = NULL;
+
+    //
+    // The session's connection list holds connections until their final
+    // uninitialize, so closed (and even handle-closed) connections may still
+    // be present and must be filtered out here.
+    //
+    QuicDispatchLockAcquire(&Session->ConnectionsLock);
+    for (QUIC_LIST_ENTRY* Entry = Session->Connections.Flink;
+        Entry != &Session->Connections;
+        Entry = Entry->Flink) {
+        QUIC_CONNECTION* Connection =
+            QUIC_CONTAINING_RECORD(Entry, QUIC_CONNECTION, SessionLink);
+        if (Connection->PoolServerName != NULL &&
+            Connection->PoolServerPort == ServerPort &&
+            Connection->PoolServerNameLength == ServerNameLength &&
+            Connection->State.Connected &&
+            !Connection->State.HandleClosed &&
+            !Connection->State.ClosedLocally &&
+            !Connection->State.ClosedRemotely &&
+            memcmp(
+                Connection->PoolServerName,
+                ServerName,
+                ServerNameLength) == 0) {
+            Found = Connection;
+            break;
+        }
+    }
+    QuicDispatchLockRelease(&Session->ConnectionsLock);
+
+    return Found;
+}
+
 //
 // Requires Session->Lock to be held (shared or exclusive).
 //
@@ -733,6 +1077,245 @@ QuicSessionServerCacheSetState(
         SecConfig);
 }
 
+//
+// Returns the shard responsible for the given ticket hash.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_SERVER_TICKET_SHARD*
+QuicSessionServerTicketCacheGetShard(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint32_t Hash
+    )
+{
+    return
+        &Session->ServerTicketShards[
+            Hash & (QUIC_SERVER_TICKET_SHARD_COUNT - 1)];
+}
+
+//
+// Requires the shard's lock to be held (shared or exclusive).
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_SERVER_TICKET*
+QuicSessionServerTicketCacheLookup(
+    _In_ QUIC_SERVER_TICKET_SHARD* Shard,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId,
+    _In_ uint32_t Hash
+    )
+{
+    QUIC_HASHTABLE_LOOKUP_CONTEXT Context;
+    QUIC_HASHTABLE_ENTRY* Entry =
+        QuicHashtableLookup(&Shard->Table, Hash, &Context);
+
+    while (Entry != NULL) {
+        QUIC_SERVER_TICKET* Temp =
+            QUIC_CONTAINING_RECORD(Entry, QUIC_SERVER_TICKET, Entry);
+        if (Temp->TicketIdLength == TicketIdLength &&
+            memcmp(Temp->TicketId, TicketId, TicketIdLength) == 0) {
+            return Temp;
+        }
+        Entry = QuicHashtableLookupNext(&Shard->Table, &Context);
+    }
+
+    return NULL;
+}
+
+//
+// Requires the shard's lock to be held exclusive.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionServerTicketCacheEvict(
+    _In_ QUIC_SERVER_TICKET_SHARD* Shard,
+    _In_ uint32_t ShardCapacity
+    )
+{
+    while (Shard->Count > ShardCapacity) {
+        QUIC_SERVER_TICKET* Oldest =
+            QUIC_CONTAINING_RECORD(
+                QuicListRemoveHead(&Shard->EvictionList),
+                QUIC_SERVER_TICKET,
+                EvictionLink);
+        QuicHashtableRemove(&Shard->Table, &Oldest->Entry, NULL);
+        QUIC_FREE(Oldest);
+        Shard->Count--;
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicSessionServerTicketCacheGetState(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId,
+    _Out_ uint32_t* QuicVersion,
+    _Out_ QUIC_TRANSPORT_PARAMETERS* Parameters
+    )
+{
+    uint32_t Hash = QuicHashSimple(TicketIdLength, TicketId);
+    QUIC_SERVER_TICKET_SHARD* Shard =
+        QuicSessionServerTicketCacheGetShard(Session, Hash);
+
+    //
+    // Lookups only take the lock shared, so they don't update the eviction
+    // order. Eviction is oldest write first, which is close enough to LRU for
+    // resumption state and keeps the (hot) read path contention free.
+    //
+    QuicRwLockAcquireShared(&Shard->Lock);
+
+    QUIC_SERVER_TICKET* Ticket =
+        QuicSessionServerTicketCacheLookup(
+            Shard,
+            TicketIdLength,
+            TicketId,
+            Hash);
+
+    if (Ticket != NULL) {
+        *QuicVersion = Ticket->QuicVersion;
+        *Parameters = Ticket->TransportParameters;
+    }
+
+    QuicRwLockReleaseShared(&Shard->Lock);
+
+    return Ticket != NULL;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionServerTicketCacheSetState(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId,
+    _In_ uint32_t QuicVersion,
+    _In_ const QUIC_TRANSPORT_PARAMETERS* Parameters
+    )
+{
+    //
+    // The total capacity is spread evenly over the shards. A capacity less
+    // than the shard count disables the cache.
+    //
+    uint32_t ShardCapacity =
+        Session->ServerTicketCacheCapacity / QUIC_SERVER_TICKET_SHARD_COUNT;
+    if (ShardCapacity == 0) {
+        return;
+    }
+
+    uint32_t Hash = QuicHashSimple(TicketIdLength, TicketId);
+    QUIC_SERVER_TICKET_SHARD* Shard =
+        QuicSessionServerTicketCacheGetShard(Session, Hash);
+
+    QuicRwLockAcquireExclusive(&Shard->Lock);
+
+    QUIC_SERVER_TICKET* Ticket =
+        QuicSessionServerTicketCacheLookup(
+            Shard,
+            TicketIdLength,
+            TicketId,
+            Hash);
+
+    if (Ticket != NULL) {
+        Ticket->QuicVersion = QuicVersion;
+        Ticket->TransportParameters = *Parameters;
+
+        //
+        // Move the entry to the back of the eviction list, as it was just
+        // refreshed.
+        //
+        QuicListEntryRemove(&Ticket->EvictionLink);
+        QuicListInsertTail(&Shard->EvictionList, &Ticket->EvictionLink);
+
+    } else {
+#pragma prefast(suppress: __WARNING_6014, "Memory is correctly freed (MsQuicSessionClose).")
+        Ticket = QUIC_ALLOC_PAGED(sizeof(QUIC_SERVER_TICKET) + TicketIdLength);
+
+        if (Ticket != NULL) {
+            memcpy(Ticket + 1, TicketId, TicketIdLength);
+            Ticket->TicketId = (const uint8_t*)(Ticket + 1);
+            Ticket->TicketIdLength = TicketIdLength;
+            Ticket->QuicVersion = QuicVersion;
+            Ticket->EarlyDataConsumed = FALSE;
+            Ticket->TransportParameters = *Parameters;
+
+            QuicHashtableInsert(&Shard->Table, &Ticket->Entry, Hash, NULL);
+            QuicListInsertTail(&Shard->EvictionList, &Ticket->EvictionLink);
+            Shard->Count++;
+
+            QuicSessionServerTicketCacheEvict(Shard, ShardCapacity);
+
+        } else {
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "server ticket cache entry",
+                sizeof(QUIC_SERVER_TICKET) + TicketIdLength);
+        }
+    }
+
+    QuicRwLockReleaseExclusive(&Shard->Lock);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return != FALSE)
+BOOLEAN
+QuicSessionServerTicketCacheTryAcceptEarlyData(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId
+    )
+{
+    uint32_t Hash = QuicHashSimple(TicketIdLength, TicketId);
+    QUIC_SERVER_TICKET_SHARD* Shard =
+        QuicSessionServerTicketCacheGetShard(Session, Hash);
+
+    //
+    // The consume is a write even on the lookup path, so the lock is always
+    // taken exclusive. Only resumed handshakes that offer early data come
+    // through here, so this doesn't contend with the (shared) lookups the
+    // rest of the resumption path performs.
+    //
+    QuicRwLockAcquireExclusive(&Shard->Lock);
+
+    QUIC_SERVER_TICKET* Ticket =
+        QuicSessionServerTicketCacheLookup(
+            Shard,
+            TicketIdLength,
+            TicketId,
+            Hash);
+
+    BOOLEAN Accept = Ticket != NULL && !Ticket->EarlyDataConsumed;
+    if (Accept) {
+        Ticket->EarlyDataConsumed = TRUE;
+    }
+
+    QuicRwLockReleaseExclusive(&Shard->Lock);
+
+    return Accept;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionServerTicketCacheSetCapacity(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint32_t Capacity
+    )
+{
+    Session->ServerTicketCacheCapacity = Capacity;
+
+    uint32_t ShardCapacity = Capacity / QUIC_SERVER_TICKET_SHARD_COUNT;
+    for (uint32_t i = 0; i < QUIC_SERVER_TICKET_SHARD_COUNT; ++i) {
+        QUIC_SERVER_TICKET_SHARD* Shard = &Session->ServerTicketShards[i];
+        QuicRwLockAcquireExclusive(&Shard->Lock);
+        QuicSessionServerTicketCacheEvict(Shard, ShardCapacity);
+        QuicRwLockReleaseExclusive(&Shard->Lock);
+    }
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicSessionParamGet(
@@ -859,6 +1442,25 @@ QuicSessionParamGet(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_SESSION_SERVER_TICKET_CACHE_CAPACITY:
+
+        if (*BufferLength < sizeof(Session->ServerTicketCacheCapacity)) {
+            *BufferLength = sizeof(Session->ServerTicketCacheCapacity);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(Session->ServerTicketCacheCapacity);
+        *(uint32_t*)Buffer = Session->ServerTicketCacheCapacity;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
@@ -911,6 +1513,8 @@ QuicSessionParamSet(
             Session,
             Session->Settings.BidiStreamCount);
 
+        QuicSessionSettingsPublish(Session);
+
         Status = QUIC_STATUS_SUCCESS;
         break;
     }
@@ -931,6 +1535,8 @@ QuicSessionParamSet(
             Session,
             Session->Settings.UnidiStreamCount);
 
+        QuicSessionSettingsPublish(Session);
+
         Status = QUIC_STATUS_SUCCESS;
         break;
     }
@@ -951,6 +1557,8 @@ QuicSessionParamSet(
             Session,
             Session->Settings.IdleTimeoutMs);
 
+        QuicSessionSettingsPublish(Session);
+
         Status = QUIC_STATUS_SUCCESS;
         break;
     }
@@ -971,6 +1579,8 @@ QuicSessionParamSet(
             Session,
             Session->Settings.DisconnectTimeoutMs);
 
+        QuicSessionSettingsPublish(Session);
+
         Status = QUIC_STATUS_SUCCESS;
         break;
     }
@@ -1031,6 +1641,8 @@ QuicSessionParamSet(
             Session,
             Session->Settings.MaxBytesPerKey);
 
+        QuicSessionSettingsPublish(Session);
+
         Status = QUIC_STATUS_SUCCESS;
         break;
     }
@@ -1050,6 +1662,26 @@ QuicSessionParamSet(
             Session,
             Session->Settings.MigrationEnabled);
 
+        QuicSessionSettingsPublish(Session);
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+    }
+
+    case QUIC_PARAM_SESSION_SERVER_TICKET_CACHE_CAPACITY: {
+        if (BufferLength != sizeof(uint32_t)) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        QuicSessionServerTicketCacheSetCapacity(Session, *(uint32_t*)Buffer);
+
+        QuicTraceLogInfo(
+            SessionServerTicketCacheCapacitySet,
+            "[sess][%p] Updated server ticket cache capacity to %u entries",
+            Session,
+            Session->ServerTicketCacheCapacity);
+
         Status = QUIC_STATUS_SUCCESS;
         break;
     }
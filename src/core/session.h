@@ -33,6 +33,57 @@ typedef struct QUIC_SERVER_CACHE {
 
 } QUIC_SERVER_CACHE;
 
+//
+// Represents server-side state (negotiated version and transport parameters)
+// cached for a previously issued resumption ticket.
+//
+typedef struct QUIC_SERVER_TICKET {
+
+    QUIC_HASHTABLE_ENTRY Entry;
+
+    //
+    // Link in the owning shard's eviction list.
+    //
+    QUIC_LIST_ENTRY EvictionLink;
+
+    const uint8_t* TicketId;
+
+    uint16_t TicketIdLength;
+
+    uint32_t QuicVersion;
+
+    //
+    // Indicates early data has already been accepted under this ticket.
+    // Tickets are single use for 0-RTT, so a replayed ClientHello reusing
+    // the ticket has its early data rejected (the handshake itself still
+    // completes as 1-RTT).
+    //
+    BOOLEAN EarlyDataConsumed;
+
+    QUIC_TRANSPORT_PARAMETERS TransportParameters;
+
+} QUIC_SERVER_TICKET;
+
+//
+// A single shard of the server resumption ticket cache. Each shard has its own
+// lock so lookups for unrelated tickets don't contend.
+//
+typedef struct QUIC_SERVER_TICKET_SHARD {
+
+    QUIC_RW_LOCK Lock;
+
+    QUIC_HASHTABLE Table;
+
+    //
+    // Entries in insertion/update order, oldest first. Once the shard is at
+    // capacity, new insertions evict from the head of this list.
+    //
+    QUIC_LIST_ENTRY EvictionList;
+
+    uint32_t Count;
+
+} QUIC_SERVER_TICKET_SHARD;
+
 //
 // Represents a library session context.
 //
@@ -83,22 +134,71 @@ typedef struct QUIC_SESSION {
     QUIC_STORAGE* AppSpecificStorage;
 
     //
-    // Configurable (app & registry) settings.
+    // Configurable (app & registry) settings. This is the working copy that
+    // settings changes are resolved into; it is never read on the connection
+    // create path.
     //
     QUIC_SETTINGS Settings;
 
+    //
+    // The currently published snapshot of Settings, read with a single
+    // pointer load when a connection is registered. Only ever replaced, never
+    // modified or freed, until the session itself is freed.
+    //
+    QUIC_SETTINGS_SNAPSHOT* SettingsSnapshot;
+
     //
     // Per server cached state information.
     //
     QUIC_HASHTABLE ServerCache;
     QUIC_RW_LOCK ServerCacheLock;
 
+    //
+    // Per ticket cached server-side resumption state, sharded to reduce lock
+    // contention.
+    //
+    QUIC_SERVER_TICKET_SHARD ServerTicketShards[QUIC_SERVER_TICKET_SHARD_COUNT];
+
+    //
+    // Maximum number of entries, across all shards, in the server ticket
+    // cache. Zero disables caching.
+    //
+    uint32_t ServerTicketCacheCapacity;
+
     //
     // List of all connections in the session.
     //
     QUIC_LIST_ENTRY Connections;
     QUIC_DISPATCH_LOCK ConnectionsLock;
 
+    //
+    // Paced drain of the session's connections, if one has been started via
+    // the SessionDrain API. The drain thread queues connection shutdowns in
+    // timed batches and exits once every connection has been told to shut
+    // down. DrainActive guards against concurrent drains; DrainStop is set
+    // by session close to end the drain early.
+    //
+    QUIC_THREAD DrainThread;
+    BOOLEAN DrainThreadStarted;
+    BOOLEAN DrainStop;
+    short DrainActive;
+    QUIC_CONNECTION_SHUTDOWN_FLAGS DrainFlags;
+    uint64_t DrainErrorCode;
+    uint32_t DrainRatePerSecond;
+
+    //
+    // Cached encoding of the local transport parameters, shared by all
+    // connections whose parameters (ignoring the per-connection stateless
+    // reset token) are identical. TpCacheParams is the snapshot the cache
+    // was built from, with the reset token bytes zeroed.
+    //
+    QUIC_DISPATCH_LOCK TpCacheLock;
+    BOOLEAN TpCacheValid;
+    uint16_t TpCacheResetTokenOffset;
+    uint32_t TpCacheLength;
+    uint8_t* TpCacheBlob;
+    QUIC_TRANSPORT_PARAMETERS TpCacheParams;
+
     //
     // The application layer protocol negotiation buffers. Encoded in the TLS
     // extension format.
@@ -183,6 +283,16 @@ QuicSessionSettingsChanged(
     _Inout_ QUIC_SESSION* Session
     );
 
+//
+// Publishes a new immutable snapshot of the session's current settings. On
+// allocation failure the previously published snapshot stays in place.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionSettingsPublish(
+    _Inout_ QUIC_SESSION* Session
+    );
+
 //
 // Registers the connection with the session.
 //
@@ -202,6 +312,22 @@ QuicSessionUnregisterConnection(
     _Inout_ QUIC_CONNECTION* Connection
     );
 
+//
+// Searches the session's registered connections for an established, still
+// open pooled connection to the given server name and port. Only connections
+// created through the ConnectionPoolGet API are candidates.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Ret_maybenull_
+QUIC_CONNECTION*
+QuicSessionPoolLookupConnection(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t ServerNameLength,
+    _In_reads_(ServerNameLength)
+        const char* ServerName,
+    _In_ uint16_t ServerPort
+    );
+
 //
 // Gets a session parameter.
 //
@@ -254,3 +380,59 @@ QuicSessionServerCacheSetState(
     _In_ const QUIC_TRANSPORT_PARAMETERS* Parameters,
     _In_ QUIC_SEC_CONFIG* SecConfig
     );
+
+//
+// Gets the server-side resumption state previously cached for a ticket.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return!=FALSE)
+BOOLEAN
+QuicSessionServerTicketCacheGetState(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId,
+    _Out_ uint32_t* QuicVersion,
+    _Out_ QUIC_TRANSPORT_PARAMETERS* Parameters
+    );
+
+//
+// Sets/updates the server-side resumption state cached for a ticket, evicting
+// the oldest entries in the shard once it is at capacity.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionServerTicketCacheSetState(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId,
+    _In_ uint32_t QuicVersion,
+    _In_ const QUIC_TRANSPORT_PARAMETERS* Parameters
+    );
+
+//
+// Atomically consumes the ticket's single allowance for early data. Returns
+// FALSE if the ticket is unknown or its allowance was already consumed, in
+// which case the caller must reject the early data.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Success_(return!=FALSE)
+BOOLEAN
+QuicSessionServerTicketCacheTryAcceptEarlyData(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint16_t TicketIdLength,
+    _In_reads_(TicketIdLength)
+        const uint8_t* TicketId
+    );
+
+//
+// Updates the total server ticket cache capacity, evicting entries as
+// necessary to get under the new limit.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSessionServerTicketCacheSetCapacity(
+    _In_ QUIC_SESSION* Session,
+    _In_ uint32_t Capacity
+    );
@@ -23,21 +23,45 @@ QuicSettingsSetDefault(
     if (!Settings->AppSet.MigrationEnabled) {
         Settings->MigrationEnabled = QUIC_DEFAULT_MIGRATION_ENABLED;
     }
+    if (!Settings->AppSet.EcnEnabled) {
+        Settings->EcnEnabled = QUIC_DEFAULT_ECN_ENABLED;
+    }
+    if (!Settings->AppSet.RetransmitCacheEnabled) {
+        Settings->RetransmitCacheEnabled = QUIC_DEFAULT_RETRANSMIT_CACHE_ENABLED;
+    }
+    if (!Settings->AppSet.InlineDatapathRecvEnabled) {
+        Settings->InlineDatapathRecvEnabled = QUIC_DEFAULT_INLINE_DATAPATH_RECV;
+    }
+    if (!Settings->AppSet.DeferredSendEnabled) {
+        Settings->DeferredSendEnabled = QUIC_DEFAULT_DEFERRED_SEND_ENABLED;
+    }
+    if (!Settings->AppSet.DatapathBusyPollEnabled) {
+        Settings->DatapathBusyPollEnabled = QUIC_DEFAULT_DATAPATH_BUSY_POLL;
+    }
     if (!Settings->AppSet.MaxPartitionCount) {
         Settings->MaxPartitionCount = QUIC_MAX_PARTITION_COUNT;
     }
     if (!Settings->AppSet.MaxOperationsPerDrain) {
         Settings->MaxOperationsPerDrain = QUIC_MAX_OPERATIONS_PER_DRAIN;
     }
+    if (!Settings->AppSet.ClientPortSprayCount) {
+        Settings->ClientPortSprayCount = QUIC_DEFAULT_CLIENT_PORT_SPRAY_COUNT;
+    }
     if (!Settings->AppSet.RetryMemoryLimit) {
         Settings->RetryMemoryLimit = QUIC_DEFAULT_RETRY_MEMORY_FRACTION;
     }
+    if (!Settings->AppSet.BufferMemoryLimit) {
+        Settings->BufferMemoryLimit = QUIC_DEFAULT_BUFFER_MEMORY_FRACTION;
+    }
     if (!Settings->AppSet.LoadBalancingMode) {
         Settings->LoadBalancingMode = QUIC_DEFAULT_LOAD_BALANCING_MODE;
     }
     if (!Settings->AppSet.MaxWorkerQueueDelayUs) {
         Settings->MaxWorkerQueueDelayUs = MS_TO_US(QUIC_MAX_WORKER_QUEUE_DELAY);
     }
+    if (!Settings->AppSet.WorkerIdleSpinUs) {
+        Settings->WorkerIdleSpinUs = QUIC_DEFAULT_WORKER_IDLE_SPIN_US;
+    }
     if (!Settings->AppSet.MaxStatelessOperations) {
         Settings->MaxStatelessOperations = QUIC_MAX_STATELESS_OPERATIONS;
     }
@@ -53,12 +77,18 @@ QuicSettingsSetDefault(
     if (!Settings->AppSet.MaxAckDelayMs) {
         Settings->MaxAckDelayMs = QUIC_TP_MAX_ACK_DELAY_DEFAULT;
     }
+    if (!Settings->AppSet.AckPiggybackDelayUs) {
+        Settings->AckPiggybackDelayUs = QUIC_DEFAULT_ACK_PIGGYBACK_DELAY_US;
+    }
     if (!Settings->AppSet.DisconnectTimeoutMs) {
         Settings->DisconnectTimeoutMs = QUIC_DEFAULT_DISCONNECT_TIMEOUT;
     }
     if (!Settings->AppSet.KeepAliveIntervalMs) {
         Settings->KeepAliveIntervalMs = QUIC_DEFAULT_KEEP_ALIVE_INTERVAL;
     }
+    if (!Settings->AppSet.HibernationIdleTimeoutMs) {
+        Settings->HibernationIdleTimeoutMs = QUIC_DEFAULT_HIBERNATION_IDLE_TIMEOUT;
+    }
     if (!Settings->AppSet.IdleTimeoutMs) {
         Settings->IdleTimeoutMs = QUIC_DEFAULT_IDLE_TIMEOUT;
     }
@@ -89,6 +119,47 @@ QuicSettingsSetDefault(
     if (!Settings->AppSet.MaxBytesPerKey) {
         Settings->MaxBytesPerKey = QUIC_DEFAULT_MAX_BYTES_PER_KEY;
     }
+    if (!Settings->AppSet.CongestionControlAlgorithm) {
+        Settings->CongestionControlAlgorithm = QUIC_DEFAULT_CONGESTION_CONTROL_ALGORITHM;
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSettingsApplyExecProfile(
+    _Inout_ QUIC_SETTINGS* Settings,
+    _In_ QUIC_EXECUTION_PROFILE ExecProfile
+    )
+{
+    switch (ExecProfile) {
+    default:
+    case QUIC_EXECUTION_PROFILE_LOW_LATENCY:
+        break;
+    case QUIC_EXECUTION_PROFILE_TYPE_MAX_THROUGHPUT:
+    case QUIC_EXECUTION_PROFILE_TYPE_SCAVENGER:
+        //
+        // Bulk profiles prefer fewer, larger drains over scheduling latency.
+        //
+        if (!Settings->AppSet.MaxOperationsPerDrain) {
+            Settings->MaxOperationsPerDrain = QUIC_MAX_OPERATIONS_PER_DRAIN_BULK;
+        }
+        break;
+    case QUIC_EXECUTION_PROFILE_TYPE_REAL_TIME:
+        //
+        // The real-time profile keeps drains short so no connection can hold
+        // the worker thread for long, and sends as soon as the congestion
+        // controller allows instead of smoothing bursts with the pacing
+        // timer.
+        //
+        if (!Settings->AppSet.MaxOperationsPerDrain) {
+            Settings->MaxOperationsPerDrain =
+                QUIC_MAX_OPERATIONS_PER_DRAIN_REAL_TIME;
+        }
+        if (!Settings->AppSet.PacingDefault) {
+            Settings->PacingDefault = FALSE;
+        }
+        break;
+    }
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -104,21 +175,45 @@ QuicSettingsCopy(
     if (!Settings->AppSet.MigrationEnabled) {
         Settings->MigrationEnabled = ParentSettings->MigrationEnabled;
     }
+    if (!Settings->AppSet.EcnEnabled) {
+        Settings->EcnEnabled = ParentSettings->EcnEnabled;
+    }
+    if (!Settings->AppSet.RetransmitCacheEnabled) {
+        Settings->RetransmitCacheEnabled = ParentSettings->RetransmitCacheEnabled;
+    }
+    if (!Settings->AppSet.InlineDatapathRecvEnabled) {
+        Settings->InlineDatapathRecvEnabled = ParentSettings->InlineDatapathRecvEnabled;
+    }
+    if (!Settings->AppSet.DeferredSendEnabled) {
+        Settings->DeferredSendEnabled = ParentSettings->DeferredSendEnabled;
+    }
+    if (!Settings->AppSet.DatapathBusyPollEnabled) {
+        Settings->DatapathBusyPollEnabled = ParentSettings->DatapathBusyPollEnabled;
+    }
     if (!Settings->AppSet.MaxPartitionCount) {
         Settings->MaxPartitionCount = ParentSettings->MaxPartitionCount;
     }
     if (!Settings->AppSet.MaxOperationsPerDrain) {
         Settings->MaxOperationsPerDrain = ParentSettings->MaxOperationsPerDrain;
     }
+    if (!Settings->AppSet.ClientPortSprayCount) {
+        Settings->ClientPortSprayCount = ParentSettings->ClientPortSprayCount;
+    }
     if (!Settings->AppSet.RetryMemoryLimit) {
         Settings->RetryMemoryLimit = ParentSettings->RetryMemoryLimit;
     }
+    if (!Settings->AppSet.BufferMemoryLimit) {
+        Settings->BufferMemoryLimit = ParentSettings->BufferMemoryLimit;
+    }
     if (!Settings->AppSet.LoadBalancingMode) {
         Settings->LoadBalancingMode = ParentSettings->LoadBalancingMode;
     }
     if (!Settings->AppSet.MaxWorkerQueueDelayUs) {
         Settings->MaxWorkerQueueDelayUs = ParentSettings->MaxWorkerQueueDelayUs;
     }
+    if (!Settings->AppSet.WorkerIdleSpinUs) {
+        Settings->WorkerIdleSpinUs = ParentSettings->WorkerIdleSpinUs;
+    }
     if (!Settings->AppSet.MaxStatelessOperations) {
         Settings->MaxStatelessOperations = ParentSettings->MaxStatelessOperations;
     }
@@ -134,12 +229,18 @@ QuicSettingsCopy(
     if (!Settings->AppSet.MaxAckDelayMs) {
         Settings->MaxAckDelayMs = ParentSettings->MaxAckDelayMs;
     }
+    if (!Settings->AppSet.AckPiggybackDelayUs) {
+        Settings->AckPiggybackDelayUs = ParentSettings->AckPiggybackDelayUs;
+    }
     if (!Settings->AppSet.DisconnectTimeoutMs) {
         Settings->DisconnectTimeoutMs = ParentSettings->DisconnectTimeoutMs;
     }
     if (!Settings->AppSet.KeepAliveIntervalMs) {
         Settings->KeepAliveIntervalMs = ParentSettings->KeepAliveIntervalMs;
     }
+    if (!Settings->AppSet.HibernationIdleTimeoutMs) {
+        Settings->HibernationIdleTimeoutMs = ParentSettings->HibernationIdleTimeoutMs;
+    }
     if (!Settings->AppSet.IdleTimeoutMs) {
         Settings->IdleTimeoutMs = ParentSettings->IdleTimeoutMs;
     }
@@ -170,6 +271,9 @@ QuicSettingsCopy(
     if (!Settings->AppSet.MaxBytesPerKey) {
         Settings->MaxBytesPerKey = ParentSettings->MaxBytesPerKey;
     }
+    if (!Settings->AppSet.CongestionControlAlgorithm) {
+        Settings->CongestionControlAlgorithm = ParentSettings->CongestionControlAlgorithm;
+    }
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -204,6 +308,61 @@ QuicSettingsLoad(
         Settings->MigrationEnabled = !!Value;
     }
 
+    if (!Settings->AppSet.EcnEnabled) {
+        Value = QUIC_DEFAULT_ECN_ENABLED;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_ECN_ENABLED,
+            (uint8_t*)&Value,
+            &ValueLen);
+        Settings->EcnEnabled = !!Value;
+    }
+
+    if (!Settings->AppSet.RetransmitCacheEnabled) {
+        Value = QUIC_DEFAULT_RETRANSMIT_CACHE_ENABLED;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_RETRANSMIT_CACHE_ENABLED,
+            (uint8_t*)&Value,
+            &ValueLen);
+        Settings->RetransmitCacheEnabled = !!Value;
+    }
+
+    if (!Settings->AppSet.InlineDatapathRecvEnabled) {
+        Value = QUIC_DEFAULT_INLINE_DATAPATH_RECV;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_INLINE_DATAPATH_RECV,
+            (uint8_t*)&Value,
+            &ValueLen);
+        Settings->InlineDatapathRecvEnabled = !!Value;
+    }
+
+    if (!Settings->AppSet.DeferredSendEnabled) {
+        Value = QUIC_DEFAULT_DEFERRED_SEND_ENABLED;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_DEFERRED_SEND_ENABLED,
+            (uint8_t*)&Value,
+            &ValueLen);
+        Settings->DeferredSendEnabled = !!Value;
+    }
+
+    if (!Settings->AppSet.DatapathBusyPollEnabled) {
+        Value = QUIC_DEFAULT_DATAPATH_BUSY_POLL;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_DATAPATH_BUSY_POLL,
+            (uint8_t*)&Value,
+            &ValueLen);
+        Settings->DatapathBusyPollEnabled = !!Value;
+    }
+
     if (!Settings->AppSet.MaxPartitionCount) {
         Value = QUIC_MAX_PARTITION_COUNT;
         ValueLen = sizeof(Value);
@@ -230,6 +389,19 @@ QuicSettingsLoad(
         }
     }
 
+    if (!Settings->AppSet.ClientPortSprayCount) {
+        Value = QUIC_DEFAULT_CLIENT_PORT_SPRAY_COUNT;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_CLIENT_PORT_SPRAY_COUNT,
+            (uint8_t*)&Value,
+            &ValueLen);
+        if (Value <= UINT8_MAX) {
+            Settings->ClientPortSprayCount = (uint8_t)Value;
+        }
+    }
+
     if (!Settings->AppSet.RetryMemoryLimit) {
         Value = QUIC_DEFAULT_RETRY_MEMORY_FRACTION;
         ValueLen = sizeof(Value);
@@ -243,6 +415,19 @@ QuicSettingsLoad(
         }
     }
 
+    if (!Settings->AppSet.BufferMemoryLimit) {
+        Value = QUIC_DEFAULT_BUFFER_MEMORY_FRACTION;
+        ValueLen = sizeof(Value);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_BUFFER_MEMORY_FRACTION,
+            (uint8_t*)&Value,
+            &ValueLen);
+        if (Value <= UINT16_MAX) {
+            Settings->BufferMemoryLimit = (uint16_t)Value;
+        }
+    }
+
     if (!Settings->AppSet.LoadBalancingMode &&
         !MsQuicLib.InUse) {
         Value = QUIC_DEFAULT_LOAD_BALANCING_MODE;
@@ -268,6 +453,15 @@ QuicSettingsLoad(
         Settings->MaxWorkerQueueDelayUs = MS_TO_US(Value);  // Convert to us
     }
 
+    if (!Settings->AppSet.WorkerIdleSpinUs) {
+        ValueLen = sizeof(Settings->WorkerIdleSpinUs);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_WORKER_IDLE_SPIN_US,
+            (uint8_t*)&Settings->WorkerIdleSpinUs,
+            &ValueLen);
+    }
+
     if (!Settings->AppSet.MaxStatelessOperations) {
         ValueLen = sizeof(Settings->MaxStatelessOperations);
         QuicStorageReadValue(
@@ -316,6 +510,15 @@ QuicSettingsLoad(
         }
     }
 
+    if (!Settings->AppSet.AckPiggybackDelayUs) {
+        ValueLen = sizeof(Settings->AckPiggybackDelayUs);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_ACK_PIGGYBACK_DELAY,
+            (uint8_t*)&Settings->AckPiggybackDelayUs,
+            &ValueLen);
+    }
+
     if (!Settings->AppSet.DisconnectTimeoutMs) {
         ValueLen = sizeof(Settings->DisconnectTimeoutMs);
         QuicStorageReadValue(
@@ -337,6 +540,15 @@ QuicSettingsLoad(
             &ValueLen);
     }
 
+    if (!Settings->AppSet.HibernationIdleTimeoutMs) {
+        ValueLen = sizeof(Settings->HibernationIdleTimeoutMs);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_HIBERNATION_IDLE_TIMEOUT,
+            (uint8_t*)&Settings->HibernationIdleTimeoutMs,
+            &ValueLen);
+    }
+
     if (!Settings->AppSet.IdleTimeoutMs) {
         union {
             uint32_t Half;
@@ -439,6 +651,18 @@ QuicSettingsLoad(
             Settings->MaxBytesPerKey = QUIC_DEFAULT_MAX_BYTES_PER_KEY;
         }
     }
+
+    if (!Settings->AppSet.CongestionControlAlgorithm) {
+        ValueLen = sizeof(Settings->CongestionControlAlgorithm);
+        QuicStorageReadValue(
+            Storage,
+            QUIC_SETTING_CONGESTION_CONTROL_ALGORITHM,
+            (uint8_t*)&Settings->CongestionControlAlgorithm,
+            &ValueLen);
+        if (Settings->CongestionControlAlgorithm >= QUIC_CONGESTION_CONTROL_ALGORITHM_MAX) {
+            Settings->CongestionControlAlgorithm = QUIC_DEFAULT_CONGESTION_CONTROL_ALGORITHM;
+        }
+    }
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -449,18 +673,28 @@ QuicSettingsDump(
 {
     QuicTraceLogVerbose(SettingDumpPacingDefault,           "[sett] PacingDefault          = %hhu", Settings->PacingDefault);
     QuicTraceLogVerbose(SettingDumpMigrationEnabled,        "[sett] MigrationEnabled       = %hhu", Settings->MigrationEnabled);
+    QuicTraceLogVerbose(SettingDumpEcnEnabled,              "[sett] EcnEnabled             = %hhu", Settings->EcnEnabled);
+    QuicTraceLogVerbose(SettingDumpRetransmitCache,         "[sett] RetransmitCacheEnabled = %hhu", Settings->RetransmitCacheEnabled);
+    QuicTraceLogVerbose(SettingDumpInlineDatapathRecv,      "[sett] InlineDatapathRecv     = %hhu", Settings->InlineDatapathRecvEnabled);
+    QuicTraceLogVerbose(SettingDumpDeferredSend,            "[sett] DeferredSendEnabled    = %hhu", Settings->DeferredSendEnabled);
+    QuicTraceLogVerbose(SettingDumpDatapathBusyPoll,        "[sett] DatapathBusyPoll       = %hhu", Settings->DatapathBusyPollEnabled);
     QuicTraceLogVerbose(SettingDumpMaxPartitionCount,       "[sett] MaxPartitionCount      = %hhu", Settings->MaxPartitionCount);
     QuicTraceLogVerbose(SettingDumpMaxOperationsPerDrain,   "[sett] MaxOperationsPerDrain  = %hhu", Settings->MaxOperationsPerDrain);
+    QuicTraceLogVerbose(SettingDumpClientPortSprayCount,    "[sett] ClientPortSprayCount   = %hhu", Settings->ClientPortSprayCount);
     QuicTraceLogVerbose(SettingDumpRetryMemoryLimit,        "[sett] RetryMemoryLimit       = %hu", Settings->RetryMemoryLimit);
+    QuicTraceLogVerbose(SettingDumpBufferMemoryLimit,       "[sett] BufferMemoryLimit      = %hu", Settings->BufferMemoryLimit);
     QuicTraceLogVerbose(SettingDumpLoadBalancingMode,       "[sett] LoadBalancingMode      = %hu", Settings->LoadBalancingMode);
     QuicTraceLogVerbose(SettingDumpMaxStatelessOperations,  "[sett] MaxStatelessOperations = %u", Settings->MaxStatelessOperations);
     QuicTraceLogVerbose(SettingDumpMaxWorkerQueueDelayUs,   "[sett] MaxWorkerQueueDelayUs  = %u", Settings->MaxWorkerQueueDelayUs);
+    QuicTraceLogVerbose(SettingDumpWorkerIdleSpinUs,        "[sett] WorkerIdleSpinUs       = %u", Settings->WorkerIdleSpinUs);
     QuicTraceLogVerbose(SettingDumpInitialWindowPackets,    "[sett] InitialWindowPackets   = %u", Settings->InitialWindowPackets);
     QuicTraceLogVerbose(SettingDumpSendIdleTimeoutMs,       "[sett] SendIdleTimeoutMs      = %u", Settings->SendIdleTimeoutMs);
     QuicTraceLogVerbose(SettingDumpInitialRttMs,            "[sett] InitialRttMs           = %u", Settings->InitialRttMs);
     QuicTraceLogVerbose(SettingDumpMaxAckDelayMs,           "[sett] MaxAckDelayMs          = %u", Settings->MaxAckDelayMs);
+    QuicTraceLogVerbose(SettingDumpAckPiggybackDelayUs,     "[sett] AckPiggybackDelayUs    = %u", Settings->AckPiggybackDelayUs);
     QuicTraceLogVerbose(SettingDumpDisconnectTimeoutMs,     "[sett] DisconnectTimeoutMs    = %u", Settings->DisconnectTimeoutMs);
     QuicTraceLogVerbose(SettingDumpKeepAliveIntervalMs,     "[sett] KeepAliveIntervalMs    = %u", Settings->KeepAliveIntervalMs);
+    QuicTraceLogVerbose(SettingDumpHibernationIdleTimeout,  "[sett] HibernationIdleTimeout = %u", Settings->HibernationIdleTimeoutMs);
     QuicTraceLogVerbose(SettingDumpIdleTimeoutMs,           "[sett] IdleTimeoutMs          = %llu", Settings->IdleTimeoutMs);
     QuicTraceLogVerbose(SettingDumpBidiStreamCount,         "[sett] BidiStreamCount        = %hu", Settings->BidiStreamCount);
     QuicTraceLogVerbose(SettingDumpUnidiStreamCount,        "[sett] UnidiStreamCount       = %hu", Settings->UnidiStreamCount);
@@ -470,4 +704,5 @@ QuicSettingsDump(
     QuicTraceLogVerbose(SettingDumpStreamRecvBufferDefault, "[sett] StreamRecvBufferDefault= %u", Settings->StreamRecvBufferDefault);
     QuicTraceLogVerbose(SettingDumpConnFlowControlWindow,   "[sett] ConnFlowControlWindow  = %u", Settings->ConnFlowControlWindow);
     QuicTraceLogVerbose(SettingDumpMaxBytesPerKey,          "[sett] MaxBytesPerKey         = %llu", Settings->MaxBytesPerKey);
+    QuicTraceLogVerbose(SettingDumpCongestionControl,       "[sett] CongestionControl      = %hu", Settings->CongestionControlAlgorithm);
 }
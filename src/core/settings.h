@@ -9,18 +9,28 @@ typedef struct QUIC_SETTINGS {
 
     BOOLEAN PacingDefault;
     BOOLEAN MigrationEnabled;
+    BOOLEAN EcnEnabled;
+    BOOLEAN RetransmitCacheEnabled;
+    BOOLEAN InlineDatapathRecvEnabled;  // Global only
+    BOOLEAN DeferredSendEnabled;        // Global only
+    BOOLEAN DatapathBusyPollEnabled;    // Global only
     uint8_t MaxPartitionCount;          // Global only
     uint8_t MaxOperationsPerDrain;      // Global only
+    uint8_t ClientPortSprayCount;       // Global only
     uint16_t RetryMemoryLimit;          // Global only
+    uint16_t BufferMemoryLimit;         // Global only
     uint16_t LoadBalancingMode;         // Global only
     uint32_t MaxWorkerQueueDelayUs;
+    uint32_t WorkerIdleSpinUs;          // Global only
     uint32_t MaxStatelessOperations;
     uint32_t InitialWindowPackets;
     uint32_t SendIdleTimeoutMs;
     uint32_t InitialRttMs;
     uint32_t MaxAckDelayMs;
+    uint32_t AckPiggybackDelayUs;
     uint32_t DisconnectTimeoutMs;
     uint32_t KeepAliveIntervalMs;
+    uint32_t HibernationIdleTimeoutMs;
     uint64_t HandshakeIdleTimeoutMs;
     uint64_t IdleTimeoutMs;
     uint16_t BidiStreamCount;
@@ -31,22 +41,33 @@ typedef struct QUIC_SETTINGS {
     uint32_t StreamRecvBufferDefault;
     uint32_t ConnFlowControlWindow;
     uint64_t MaxBytesPerKey;
+    uint16_t CongestionControlAlgorithm; // QUIC_CONGESTION_CONTROL_ALGORITHM
 
     struct {
         BOOLEAN PacingDefault : 1;
         BOOLEAN MigrationEnabled : 1;
+        BOOLEAN EcnEnabled : 1;
+        BOOLEAN RetransmitCacheEnabled : 1;
+        BOOLEAN InlineDatapathRecvEnabled : 1;
+        BOOLEAN DeferredSendEnabled : 1;
+        BOOLEAN DatapathBusyPollEnabled : 1;
         BOOLEAN MaxPartitionCount : 1;
         BOOLEAN MaxOperationsPerDrain : 1;
+        BOOLEAN ClientPortSprayCount : 1;
         BOOLEAN RetryMemoryLimit : 1;
+        BOOLEAN BufferMemoryLimit : 1;
         BOOLEAN LoadBalancingMode : 1;
         BOOLEAN MaxWorkerQueueDelayUs : 1;
+        BOOLEAN WorkerIdleSpinUs : 1;
         BOOLEAN MaxStatelessOperations : 1;
         BOOLEAN InitialWindowPackets : 1;
         BOOLEAN SendIdleTimeoutMs : 1;
         BOOLEAN InitialRttMs : 1;
         BOOLEAN MaxAckDelayMs : 1;
+        BOOLEAN AckPiggybackDelayUs : 1;
         BOOLEAN DisconnectTimeoutMs : 1;
         BOOLEAN KeepAliveIntervalMs : 1;
+        BOOLEAN HibernationIdleTimeoutMs : 1;
         BOOLEAN IdleTimeoutMs : 1;
         BOOLEAN HandshakeIdleTimeoutMs : 1;
         BOOLEAN BidiStreamCount : 1;
@@ -57,10 +78,28 @@ typedef struct QUIC_SETTINGS {
         BOOLEAN StreamRecvBufferDefault : 1;
         BOOLEAN ConnFlowControlWindow : 1;
         BOOLEAN MaxBytesPerKey : 1;
+        BOOLEAN CongestionControlAlgorithm : 1;
     } AppSet;
 
 } QUIC_SETTINGS;
 
+//
+// An immutable snapshot of a session's resolved settings. The session
+// publishes a new snapshot (with a single pointer exchange) every time its
+// settings change, so connection creation can pick up the current settings
+// with one pointer read instead of copying the struct under a lock. Replaced
+// snapshots stay chained via Retired until the session is freed, so a reader
+// holding the old pointer never races a free.
+//
+typedef struct QUIC_SETTINGS_SNAPSHOT QUIC_SETTINGS_SNAPSHOT;
+
+struct QUIC_SETTINGS_SNAPSHOT {
+
+    QUIC_SETTINGS_SNAPSHOT* Retired; // The next older, replaced snapshot.
+    QUIC_SETTINGS Settings;
+
+};
+
 //
 // Initializes all settings to default values, if not already set by the app.
 //
@@ -80,6 +119,17 @@ QuicSettingsCopy(
     _In_ const QUIC_SETTINGS* ParentSettings
     );
 
+//
+// Applies the defaults implied by the registration's execution profile, for
+// settings not explicitly set by the app.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicSettingsApplyExecProfile(
+    _Inout_ QUIC_SETTINGS* Settings,
+    _In_ QUIC_EXECUTION_PROFILE ExecProfile
+    );
+
 //
 // Loads the settings from storage, if not already set by the app.
 //
@@ -25,13 +25,29 @@ QuicStreamInitialize(
 {
     QUIC_STATUS Status;
     QUIC_STREAM* Stream;
+    BOOLEAN Recycled = FALSE;
 
-    Stream = QuicPoolAlloc(&Connection->Worker->StreamPool);
-    if (Stream == NULL) {
-        Status = QUIC_STATUS_OUT_OF_MEMORY;
-        goto Exit;
+    Stream = QuicStreamSetGetRecycledStream(&Connection->Streams);
+    if (Stream != NULL) {
+        //
+        // Salvage the receive buffer and ACK range allocations from the
+        // recycled object. Restoring the structs into the same object keeps
+        // their internal self-referential pointers valid.
+        //
+        QUIC_RECV_BUFFER RecvBuffer = Stream->RecvBuffer;
+        QUIC_RANGE SparseAckRanges = Stream->SparseAckRanges;
+        QuicZeroMemory(Stream, sizeof(QUIC_STREAM));
+        Stream->RecvBuffer = RecvBuffer;
+        Stream->SparseAckRanges = SparseAckRanges;
+        Recycled = TRUE;
+    } else {
+        Stream = QuicPoolAlloc(&Connection->Worker->StreamPool);
+        if (Stream == NULL) {
+            Status = QUIC_STATUS_OUT_OF_MEMORY;
+            goto Exit;
+        }
+        QuicZeroMemory(Stream, sizeof(QUIC_STREAM));
     }
-    QuicZeroMemory(Stream, sizeof(QUIC_STREAM));
 
     Stream->Type = QUIC_HANDLE_TYPE_STREAM;
     Stream->Connection = Connection;
@@ -44,6 +60,7 @@ QuicStreamInitialize(
     Stream->RecvMaxLength = UINT64_MAX;
     Stream->RefCount = 1;
     Stream->SendRequestsTail = &Stream->SendRequests;
+    Stream->SendPriority = QUIC_STREAM_PRIORITY_DEFAULT;
     QuicDispatchLockInitialize(&Stream->ApiSendRequestLock);
     QuicRefInitialize(&Stream->RefCount);
 #if DEBUG
@@ -76,23 +93,37 @@ QuicStreamInitialize(
         }
     }
 
-    Status =
-        QuicRangeInitialize(
-            QUIC_MAX_RANGE_ALLOC_SIZE,
-            &Stream->SparseAckRanges);
-    if (QUIC_FAILED(Status)) {
-        goto Exit;
-    }
-
-    Status =
-        QuicRecvBufferInitialize(
+    if (Recycled) {
+        //
+        // The recycled allocations just need to be reset back to their
+        // initial state, which cannot fail.
+        //
+        QuicRangeReset(&Stream->SparseAckRanges);
+        QuicRecvBufferReset(
             &Stream->RecvBuffer,
             Connection->Session->Settings.StreamRecvBufferDefault,
-            Connection->Session->Settings.StreamRecvWindowDefault,
-            FALSE);
-    if (QUIC_FAILED(Status)) {
-        QuicRangeUninitialize(&Stream->SparseAckRanges);
-        goto Exit;
+            Connection->Session->Settings.StreamRecvWindowDefault);
+        Status = QUIC_STATUS_SUCCESS;
+
+    } else {
+        Status =
+            QuicRangeInitialize(
+                QUIC_MAX_RANGE_ALLOC_SIZE,
+                &Stream->SparseAckRanges);
+        if (QUIC_FAILED(Status)) {
+            goto Exit;
+        }
+
+        Status =
+            QuicRecvBufferInitialize(
+                &Stream->RecvBuffer,
+                Connection->Session->Settings.StreamRecvBufferDefault,
+                Connection->Session->Settings.StreamRecvWindowDefault,
+                QUIC_RECV_BUF_MODE_MULTIPLE);
+        if (QUIC_FAILED(Status)) {
+            QuicRangeUninitialize(&Stream->SparseAckRanges);
+            goto Exit;
+        }
     }
 
     Stream->MaxAllowedRecvOffset = Stream->RecvBuffer.VirtualBufferLength;
@@ -120,6 +151,7 @@ QuicStreamFree(
     )
 {
     BOOLEAN WasStarted = Stream->Flags.Started;
+    QUIC_CONNECTION* Connection = Stream->Connection;
 
     QUIC_TEL_ASSERT(Stream->RefCount == 0);
     QUIC_TEL_ASSERT(Stream->Flags.ShutdownComplete);
@@ -132,13 +164,22 @@ QuicStreamFree(
     QUIC_TEL_ASSERT(Stream->ApiSendRequests == NULL);
     QUIC_TEL_ASSERT(Stream->SendRequests == NULL);
 
-    QuicRecvBufferUninitialize(&Stream->RecvBuffer);
-    QuicRangeUninitialize(&Stream->SparseAckRanges);
     QuicDispatchLockUninitialize(&Stream->ApiSendRequestLock);
     QuicRefUninitialize(&Stream->RefCount);
 
     Stream->Flags.Freed = TRUE;
-    QuicPoolFree(&Stream->Connection->Worker->StreamPool, Stream);
+
+    //
+    // Offer the object to the connection's recycle cache, which keeps the
+    // receive buffer and ACK range allocations for the next stream open.
+    // Not possible while the app still references the receive buffer.
+    //
+    if (Stream->RecvBuffer.ExternalBufferReference ||
+        !QuicStreamSetRecycleStream(&Connection->Streams, Stream)) {
+        QuicRecvBufferUninitialize(&Stream->RecvBuffer);
+        QuicRangeUninitialize(&Stream->SparseAckRanges);
+        QuicPoolFree(&Connection->Worker->StreamPool, Stream);
+    }
 
     if (WasStarted) {
 #pragma warning(push)
@@ -220,7 +261,7 @@ QuicStreamStart(
         // stream data to be sent out now.
         //
         QuicSendQueueFlushForStream(
-            &Stream->Connection->Send, Stream, FALSE);
+            &Stream->Connection->Send, Stream, FALSE, FALSE);
     }
 
     Stream->Flags.SendOpen = !!(Flags & QUIC_STREAM_START_FLAG_IMMEDIATE);
@@ -228,7 +269,8 @@ QuicStreamStart(
         QuicSendSetStreamSendFlag(
             &Stream->Connection->Send,
             Stream,
-            QUIC_STREAM_SEND_FLAG_OPEN);
+            QUIC_STREAM_SEND_FLAG_OPEN,
+            FALSE);
     }
 
     Stream->MaxAllowedSendOffset =
@@ -492,11 +534,65 @@ QuicStreamParamSet(
         const void* Buffer
     )
 {
-    UNREFERENCED_PARAMETER(Stream);
-    UNREFERENCED_PARAMETER(Param);
-    UNREFERENCED_PARAMETER(BufferLength);
-    UNREFERENCED_PARAMETER(Buffer);
-    return QUIC_STATUS_INVALID_PARAMETER;
+    QUIC_STATUS Status;
+
+    switch (Param)
+    {
+    case QUIC_PARAM_STREAM_PRIORITY:
+
+        if (BufferLength != sizeof(Stream->SendPriority) || Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (Stream->SendPriority != *(uint16_t*)Buffer) {
+            Stream->SendPriority = *(uint16_t*)Buffer;
+            if (Stream->SendLink.Flink != NULL) {
+                //
+                // The stream is already queued to send; move it to the spot
+                // in the queue its new priority calls for.
+                //
+                QuicSendUpdateStreamPriority(
+                    &Stream->Connection->Send, Stream);
+            }
+        }
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_STREAM_INLINE_RECEIVES:
+
+        if (BufferLength != sizeof(BOOLEAN) || Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        Stream->Flags.ReceiveInline = *(BOOLEAN*)Buffer;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_STREAM_CANCEL_UNSENT:
+
+        if (BufferLength != sizeof(BOOLEAN) || Buffer == NULL ||
+            !*(BOOLEAN*)Buffer) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // Set params execute on the worker thread, so this is already
+        // serialized with the send path.
+        //
+        Status = QuicStreamSendCancelUnsent(Stream);
+        break;
+
+    default:
+        Status = QUIC_STATUS_INVALID_PARAMETER;
+        break;
+    }
+
+    return Status;
 }
 
 QUIC_STATUS
@@ -580,6 +676,51 @@ QuicStreamParamGet(
         Status = QUIC_STATUS_SUCCESS;
         break;
 
+    case QUIC_PARAM_STREAM_QUEUED_SEND_BYTES:
+
+        if (*BufferLength < sizeof(uint64_t)) {
+            *BufferLength = sizeof(uint64_t);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // Everything the app has posted on this stream that the library still
+        // holds: data not yet sent plus data in flight awaiting
+        // acknowledgment. Paired with IDEAL_SEND_BUFFER_SIZE this lets an app
+        // keep just enough queued to avoid starving the link.
+        //
+        *BufferLength = sizeof(uint64_t);
+        *(uint64_t*)Buffer =
+            Stream->QueuedSendOffset - Stream->UnAckedOffset;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
+    case QUIC_PARAM_STREAM_PRIORITY:
+
+        if (*BufferLength < sizeof(Stream->SendPriority)) {
+            *BufferLength = sizeof(Stream->SendPriority);
+            Status = QUIC_STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (Buffer == NULL) {
+            Status = QUIC_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *BufferLength = sizeof(Stream->SendPriority);
+        *(uint16_t*)Buffer = Stream->SendPriority;
+
+        Status = QUIC_STATUS_SUCCESS;
+        break;
+
     default:
         Status = QUIC_STATUS_INVALID_PARAMETER;
         break;
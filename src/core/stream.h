@@ -37,6 +37,12 @@ typedef struct QUIC_CONNECTION QUIC_CONNECTION;
 
 #define QUIC_STREAM_EVENT_RECEIVE_TLS_INIT     0xff    // Private event for server receive ClientHello.
 
+//
+// The default send priority assigned to new streams. The middle of the range,
+// so apps can both raise and lower priorities around it.
+//
+#define QUIC_STREAM_PRIORITY_DEFAULT        0x7FFF
+
 //
 // Internal send flags. The public ones are defined in msquic.h.
 //
@@ -110,6 +116,8 @@ typedef union QUIC_STREAM_FLAGS {
 
         BOOLEAN SendOpen                : 1;    // Send a STREAM frame immediately on start.
         BOOLEAN SendOpenAcked           : 1;    // A STREAM frame has been acknowledged.
+        BOOLEAN SendDelayed             : 1;    // The app wants to delay the send flush, as
+                                                // more data is expected to be queued soon.
 
         BOOLEAN LocalNotAllowed         : 1;    // Peer's unidirectional stream.
         BOOLEAN LocalCloseFin           : 1;    // Locally closed (graceful).
@@ -131,6 +139,8 @@ typedef union QUIC_STREAM_FLAGS {
         BOOLEAN ReceiveFlushQueued      : 1;    // The receive flush operation is queued.
         BOOLEAN ReceiveDataPending      : 1;    // Data (or FIN) is queued and ready for delivery.
         BOOLEAN ReceiveCallPending      : 1;    // There is an uncompleted receive to the app.
+        BOOLEAN ReceiveInline           : 1;    // App opted in to receives indicated directly
+                                                // out of the packet buffer.
 
         BOOLEAN HandleSendShutdown      : 1;    // Send shutdown complete callback delivered.
         BOOLEAN HandleShutdown          : 1;    // Shutdown callback delivered.
@@ -192,23 +202,25 @@ typedef struct QUIC_STREAM {
     short RefTypeCount[QUIC_STREAM_REF_COUNT];
 #endif
 
-    union {
-        //
-        // The entry in the connection's hashtable of streams.
-        //
-        QUIC_HASHTABLE_ENTRY TableEntry;
-
-        //
-        // The entry in the connection's list of closed streams to clean up.
-        //
-        QUIC_LIST_ENTRY ClosedLink;
-    };
+    //
+    // The entry in the connection's list of closed streams to clean up. The
+    // connection's hash table of streams stores the stream pointer directly
+    // and needs no entry here.
+    //
+    QUIC_LIST_ENTRY ClosedLink;
 
     //
     // The list entry in the output module's send list.
     //
     QUIC_LIST_ENTRY SendLink;
 
+    //
+    // The entry in the stream set's list of streams blocked on stream ID flow
+    // control. Only valid while QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL is
+    // set in OutFlowBlockedReasons.
+    //
+    QUIC_LIST_ENTRY WaitingForIdFlowControlLink;
+
     //
     // The parent connection for this stream.
     //
@@ -235,6 +247,13 @@ typedef struct QUIC_STREAM {
     //
     uint8_t OutFlowBlockedReasons; // Set of QUIC_FLOW_BLOCKED_* flags
 
+    //
+    // The relative priority of this stream's data versus other streams on the
+    // same connection. Higher values get framed into packets first. Streams
+    // of equal priority share the connection in round robin order.
+    //
+    uint16_t SendPriority;
+
     //
     // Send State
     //
@@ -263,6 +282,15 @@ typedef struct QUIC_STREAM {
     //
     QUIC_SEND_REQUEST* SendBookmark;
 
+    //
+    // Cursor within SendBookmark, so the common in-order send path doesn't
+    // have to rescan the request's buffer array for every packet: the index
+    // of the buffer the cursor sits in and the absolute stream offset of that
+    // buffer's first byte. Only valid while SendBookmark is non-NULL.
+    //
+    uint32_t SendBookmarkIndex;
+    uint64_t SendBookmarkOffset;
+
     //
     // Shortcut pointer: NULL, or the next unbuffered send request.
     //
@@ -360,7 +388,9 @@ typedef struct QUIC_STREAM {
     uint64_t RecvMaxLength;
 
     //
-    // The length of the pending receive call to the app.
+    // The total length of all pending receive calls to the app. More than
+    // one receive can be outstanding when the app re-enables receive
+    // callbacks while still holding earlier buffers.
     //
     uint64_t RecvPendingLength;
 
@@ -680,6 +710,18 @@ QuicStreamSendShutdown(
     _In_ QUIC_VAR_INT ErrorCode   // Only for !Graceful
     );
 
+//
+// Cancels (completing them immediately) all queued send requests that haven't
+// had any of their bytes framed into a packet yet, shortening the stream to
+// the data already on the wire. Data that has been sent at least once is left
+// alone, since skipping it would leave a hole the peer must wait on forever.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicStreamSendCancelUnsent(
+    _In_ QUIC_STREAM* Stream
+    );
+
 //
 // Send path has completed shutdown.
 //
@@ -811,6 +853,18 @@ QuicStreamRecvFlush(
     _In_ QUIC_STREAM* Stream
     );
 
+//
+// Delivers receive data for multiple streams to the API client in a single
+// connection-level batched receive event.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamRecvFlushBatch(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_reads_(StreamCount) QUIC_STREAM** Streams,
+    _In_ uint32_t StreamCount
+    );
+
 //
 // Enables or disables receive callbacks for the stream.
 //
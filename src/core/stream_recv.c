@@ -19,6 +19,13 @@ QuicStreamReceiveComplete(
     _In_ uint64_t BufferLength
     );
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamOnBytesDelivered(
+    _In_ QUIC_STREAM* Stream,
+    _In_ uint64_t BytesDelivered
+    );
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicStreamRecvShutdown(
@@ -62,7 +69,8 @@ QuicStreamRecvShutdown(
     QuicSendSetStreamSendFlag(
         &Stream->Connection->Send,
         Stream,
-        QUIC_STREAM_SEND_FLAG_RECV_ABORT);
+        QUIC_STREAM_SEND_FLAG_RECV_ABORT,
+        FALSE);
 
     //
     // Remove any flags we shouldn't be sending now the receive direction is
@@ -94,12 +102,14 @@ QuicStreamRecvQueueFlush(
 {
     //
     // The caller has indicated data is ready to be indicated to the
-    // application. Queue a FLUSH_RECV if one isn't already queued.
+    // application. Queue a FLUSH_RECV if one isn't already queued. A
+    // previous receive call still being pending doesn't block the flush:
+    // if the app re-enabled receives while holding the earlier buffers,
+    // any newly arrived data is indicated in additional (new) chunks.
     //
 
     if (Stream->Flags.ReceiveEnabled &&
         Stream->Flags.ReceiveDataPending &&
-        !Stream->Flags.ReceiveCallPending &&
         !Stream->Flags.ReceiveFlushQueued) {
 
         QuicTraceLogStreamVerbose(
@@ -255,6 +265,191 @@ QuicStreamProcessStopSendingFrame(
     }
 }
 
+//
+// Attempts to indicate a STREAM frame's payload to the app directly out of
+// the decrypted packet buffer, skipping the copy into the receive buffer.
+// Only possible for in-order data when nothing else is buffered or pending,
+// and only for streams that opted in (the packet buffer doesn't outlive
+// frame processing, so the app has to consume the data in the callback).
+// Returns TRUE if the frame was fully handled, FALSE to fall back to the
+// buffered path (in which case nothing has been indicated).
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+BOOLEAN
+QuicStreamTryDeliverInline(
+    _In_ QUIC_STREAM* Stream,
+    _In_ BOOLEAN EncryptedWith0Rtt,
+    _In_ const QUIC_STREAM_EX* Frame,
+    _Inout_ BOOLEAN* ReadyToDeliver
+    )
+{
+    if (!Stream->Flags.ReceiveInline ||
+        !Stream->Flags.ReceiveEnabled ||
+        Stream->Flags.ReceiveCallPending ||
+        Stream->Flags.ReceiveDataPending ||
+        Frame->Offset != Stream->RecvBuffer.BaseOffset ||
+        QuicRecvBufferHasUnreadData(&Stream->RecvBuffer)) {
+        return FALSE;
+    }
+
+    //
+    // Both flow control windows must cover the whole frame. Edge cases near
+    // the limits take the buffered path, which already handles them.
+    //
+    if (Frame->Length > Stream->RecvBuffer.VirtualBufferLength ||
+        Frame->Length >
+            Stream->Connection->Send.MaxData -
+            Stream->Connection->Send.OrderedStreamBytesReceived) {
+        return FALSE;
+    }
+
+    QUIC_BUFFER RecvBuffer;
+    RecvBuffer.Length = (uint32_t)Frame->Length;
+    RecvBuffer.Buffer = (uint8_t*)Frame->Data;
+
+    QUIC_STREAM_EVENT Event = {0};
+    Event.Type = QUIC_STREAM_EVENT_RECEIVE;
+    Event.RECEIVE.AbsoluteOffset = Frame->Offset;
+    Event.RECEIVE.TotalBufferLength = Frame->Length;
+    Event.RECEIVE.BufferCount = 1;
+    Event.RECEIVE.Buffers = &RecvBuffer;
+    if (EncryptedWith0Rtt) {
+        Event.RECEIVE.Flags |= QUIC_RECEIVE_FLAG_0_RTT;
+    }
+    if (Frame->Fin) {
+        Event.RECEIVE.Flags |= QUIC_RECEIVE_FLAG_FIN;
+    }
+
+    Stream->Flags.ReceiveEnabled = FALSE;
+    Stream->Flags.ReceiveCallPending = TRUE;
+    Stream->RecvPendingLength = Frame->Length;
+
+    QuicTraceLogStreamVerbose(
+        IndicateReceiveInline,
+        Stream,
+        "Indicating QUIC_STREAM_EVENT_RECEIVE (inline) [%llu bytes, 0x%x flags]",
+        Event.RECEIVE.TotalBufferLength,
+        Event.RECEIVE.Flags);
+
+    QUIC_STATUS Status = QuicStreamIndicateEvent(Stream, &Event);
+
+    if (Status == QUIC_STATUS_PENDING) {
+        //
+        // The app broke the inline receive contract: the buffers it was
+        // given don't survive frame processing. Buffer the data and take a
+        // matching read on the receive buffer, so the app's later completion
+        // finds the same state a buffered indication would have left. The
+        // data is then indicated again, from the copy, once the app
+        // re-enables receive callbacks.
+        //
+        QUIC_TEL_ASSERTMSG_ARGS(
+            FALSE,
+            "App pended an inline receive",
+            Stream->Connection->Registration->AppName,
+            0, 0);
+
+        uint64_t WriteLength = Frame->Length;
+        BOOLEAN ReadyToRead;
+        if (QUIC_FAILED(
+            QuicRecvBufferWrite(
+                &Stream->RecvBuffer,
+                Frame->Offset,
+                (uint16_t)Frame->Length,
+                Frame->Data,
+                &WriteLength,
+                &ReadyToRead))) {
+            //
+            // The data was already indicated and can't be recovered.
+            //
+            QuicConnFatalError(
+                Stream->Connection,
+                QUIC_STATUS_OUT_OF_MEMORY,
+                "Out of memory buffering inline receive");
+            return TRUE;
+        }
+        Stream->Connection->Send.OrderedStreamBytesReceived += WriteLength;
+
+        uint64_t ReadOffset;
+        uint32_t ReadBufferCount = 3;
+        QUIC_BUFFER ReadBuffers[3];
+        (void)QuicRecvBufferRead(
+            &Stream->RecvBuffer, &ReadOffset, &ReadBufferCount, ReadBuffers);
+        Stream->Flags.ReceiveDataPending = TRUE;
+        return TRUE;
+    }
+
+    uint64_t Consumed = Event.RECEIVE.TotalBufferLength;
+
+    QUIC_FRE_ASSERTMSG(
+        Consumed <= Frame->Length,
+        "App overflowed read buffer!");
+    QUIC_TEL_ASSERTMSG_ARGS(
+        QUIC_SUCCEEDED(Status) || Status == QUIC_STATUS_CONTINUE,
+        "App failed recv callback",
+        Stream->Connection->Registration->AppName,
+        Status, 0);
+
+    Stream->Flags.ReceiveCallPending = FALSE;
+    Stream->RecvPendingLength = 0;
+
+    if (Consumed != 0) {
+        QuicRecvBufferDeliveredInline(
+            &Stream->RecvBuffer, Frame->Offset, Consumed);
+    }
+    uint64_t NewOrderedBytes = Consumed;
+
+    if (Consumed < Frame->Length) {
+        //
+        // The app didn't consume everything. Buffer the rest; it gets
+        // indicated again (from the copy) once receive callbacks resume.
+        //
+        uint64_t WriteLength = Frame->Length - Consumed;
+        BOOLEAN ReadyToRead;
+        if (QUIC_FAILED(
+            QuicRecvBufferWrite(
+                &Stream->RecvBuffer,
+                Frame->Offset + Consumed,
+                (uint16_t)(Frame->Length - Consumed),
+                Frame->Data + Consumed,
+                &WriteLength,
+                &ReadyToRead))) {
+            QuicConnFatalError(
+                Stream->Connection,
+                QUIC_STATUS_OUT_OF_MEMORY,
+                "Out of memory buffering inline receive");
+            return TRUE;
+        }
+        NewOrderedBytes += WriteLength;
+        Stream->Flags.ReceiveDataPending = TRUE;
+    }
+
+    Stream->Connection->Send.OrderedStreamBytesReceived += NewOrderedBytes;
+
+    if (Consumed != 0) {
+        QuicStreamOnBytesDelivered(Stream, Consumed);
+    }
+
+    if (Status == QUIC_STATUS_CONTINUE || Consumed == Frame->Length) {
+        //
+        // All the data was drained (or the app explicitly asked to keep the
+        // callbacks coming), so additional receives can be indicated.
+        //
+        Stream->Flags.ReceiveEnabled = TRUE;
+    }
+
+    if (!Stream->Flags.ReceiveEnabled) {
+        QuicTraceEvent(
+            StreamRecvState,
+            "[strm][%p] Recv State: %hhu",
+            Stream,
+            QuicStreamRecvGetState(Stream));
+    } else if (Stream->Flags.ReceiveDataPending) {
+        *ReadyToDeliver = TRUE;
+    }
+
+    return TRUE;
+}
+
 //
 // Processes a STREAM frame.
 //
@@ -327,6 +522,21 @@ QuicStreamProcessStreamFrame(
 
         Status = QUIC_STATUS_SUCCESS;
 
+    } else if (
+        QuicStreamTryDeliverInline(
+            Stream, EncryptedWith0Rtt, Frame, &ReadyToDeliver)) {
+
+        //
+        // The payload was indicated straight out of the packet buffer;
+        // nothing (except any part the app didn't consume) was copied into
+        // the receive buffer.
+        //
+        if (EncryptedWith0Rtt && EndOffset > Stream->RecvMax0RttLength) {
+            Stream->RecvMax0RttLength = EndOffset;
+        }
+        Stream->Connection->Stats.Recv.TotalStreamBytes += Frame->Length;
+        Status = QUIC_STATUS_SUCCESS;
+
     } else {
 
         //
@@ -528,7 +738,8 @@ QuicStreamRecv(
         QuicSendSetStreamSendFlag(
             &Stream->Connection->Send,
             Stream,
-            QUIC_STREAM_SEND_FLAG_MAX_DATA);
+            QUIC_STREAM_SEND_FLAG_MAX_DATA,
+            FALSE);
 
         break;
     }
@@ -552,13 +763,12 @@ QuicStreamRecv(
 }
 
 //
-// Generally, every time bytes are delivered to the application we update our max
+// Every time bytes are delivered to the application we advance our max
 // data (stream and connection) values and queue an update to be sent to the
-// peer. It is done every time, because nearly always an ACK frame is also
-// ready to be sent out, so we might as well take advantage of that packet to
-// send this data as well. If we don't have an ACK ready to be sent out
-// immediately then we only update the values if we have reached the drain
-// limit.
+// peer. Only reaching the drain limit, or the peer's remaining send allowance
+// running low, is worth a packet of its own though; otherwise the update is
+// queued without scheduling a send, so the frames ride along with the next
+// packet that goes out for any other reason (nearly always an ACK).
 //
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
@@ -573,64 +783,116 @@ QuicStreamOnBytesDelivered(
     Stream->RecvWindowBytesDelivered += BytesDelivered;
     Stream->Connection->Send.MaxData += BytesDelivered;
 
-    if (Stream->RecvWindowBytesDelivered >= RecvBufferDrainThreshold) {
+    BOOLEAN ScheduleSend = TRUE;
 
-        uint32_t TimeNow = QuicTimeUs32();
+    uint32_t TimeNow = QuicTimeUs32();
+    uint32_t Elapsed = QuicTimeDiff32(Stream->RecvWindowLastUpdate, TimeNow);
 
-        //
-        // Limit stream FC window growth by the connection FC window size.
-        //
-        if (Stream->RecvBuffer.VirtualBufferLength <
-            Stream->Connection->Session->Settings.ConnFlowControlWindow) {
+    if (Stream->RecvWindowBytesDelivered >= RecvBufferDrainThreshold ||
+        Elapsed >= QUIC_RECV_BUFFER_TUNING_INTERVAL_US) {
 
-            uint32_t TimeThreshold = (uint32_t)
-                ((Stream->RecvWindowBytesDelivered * Stream->Connection->Paths[0].MinRtt) / RecvBufferDrainThreshold);
-            if (QuicTimeDiff32(Stream->RecvWindowLastUpdate, TimeNow) <= TimeThreshold) {
+        uint32_t MinRtt = Stream->Connection->Paths[0].WindowedMinRtt;
+        if (Elapsed != 0 && MinRtt != 0) {
 
-                //
-                // Buffer tuning:
-                //
-                // VirtualBufferLength limits the connection's throughput to:
-                //   R = VirtualBufferLength / RTT
-                //
-                // We've delivered data at an average rate of at least:
-                //   R / QUIC_RECV_BUFFER_DRAIN_RATIO
-                //
-                // Double VirtualBufferLength to make sure it doesn't limit
-                // throughput.
-                //
-                // Mainly people complain about flow control when it limits
-                // throughput. But if we grow the buffer limit and then the app
-                // stops receiving data, bytes will pile up in the buffer. We could
-                // add logic to shrink the buffer when the app absorb rate is too
-                // low.
-                //
+            //
+            // Buffer tuning:
+            //
+            // VirtualBufferLength limits the connection's throughput to:
+            //   R = VirtualBufferLength / RTT
+            //
+            // Size the window to a multiple of the observed bandwidth-delay
+            // product instead of blindly doubling: fast paths jump straight
+            // to the window their delivery rate requires, and streams the
+            // app drains slowly give memory back instead of keeping the
+            // largest window they ever needed.
+            //
+            uint64_t TargetLength =
+                (Stream->RecvWindowBytesDelivered * MinRtt *
+                 QUIC_RECV_BUFFER_BDP_MULTIPLIER) / Elapsed;
+
+            //
+            // Round the target up to a power of two, and limit stream FC
+            // window growth by the connection FC window size.
+            //
+            uint32_t NewLength =
+                Stream->Connection->Session->Settings.StreamRecvWindowDefault;
+            while (NewLength < TargetLength &&
+                NewLength <
+                    Stream->Connection->Session->Settings.ConnFlowControlWindow) {
+                NewLength <<= 1;
+            }
+
+            //
+            // Under library-wide memory pressure the window stops growing,
+            // and any oversized window shrinks without waiting for the
+            // usual hysteresis.
+            //
+            BOOLEAN MemoryPressure = QuicLibraryUnderMemoryPressure();
+
+            if (NewLength > Stream->RecvBuffer.VirtualBufferLength &&
+                !MemoryPressure) {
 
                 QuicTraceLogStreamVerbose(
                     IncreaseRxBuffer,
                     Stream,
-                    "Increasing max RX buffer size to %u (MinRtt=%u; TimeNow=%u; LastUpdate=%u)",
-                    Stream->RecvBuffer.VirtualBufferLength * 2,
-                    Stream->Connection->Paths[0].MinRtt,
-                    TimeNow,
-                    Stream->RecvWindowLastUpdate);
+                    "Increasing max RX buffer size to %u (MinRtt=%u; Elapsed=%u)",
+                    NewLength,
+                    MinRtt,
+                    Elapsed);
 
                 QuicRecvBufferSetVirtualBufferLength(
                     &Stream->RecvBuffer,
-                    Stream->RecvBuffer.VirtualBufferLength * 2);
+                    NewLength);
+
+            } else if (NewLength < Stream->RecvBuffer.VirtualBufferLength &&
+                (MemoryPressure ||
+                 NewLength <=
+                    Stream->RecvBuffer.VirtualBufferLength /
+                        QUIC_RECV_BUFFER_SHRINK_RATIO)) {
+
+                //
+                // Only future MAX_STREAM_DATA updates get smaller; the
+                // window already advertised to the peer (and any buffer
+                // already allocated) is never taken back.
+                //
+                uint64_t AdvertisedWindow =
+                    Stream->MaxAllowedRecvOffset - Stream->RecvBuffer.BaseOffset;
+                while (NewLength < AdvertisedWindow ||
+                    NewLength < Stream->RecvBuffer.AllocBufferLength) {
+                    NewLength <<= 1;
+                }
+
+                if (NewLength < Stream->RecvBuffer.VirtualBufferLength) {
+
+                    QuicTraceLogStreamVerbose(
+                        DecreaseRxBuffer,
+                        Stream,
+                        "Decreasing max RX buffer size to %u (MinRtt=%u; Elapsed=%u)",
+                        NewLength,
+                        MinRtt,
+                        Elapsed);
+
+                    QuicRecvBufferSetVirtualBufferLength(
+                        &Stream->RecvBuffer,
+                        NewLength);
+                }
             }
         }
 
         Stream->RecvWindowLastUpdate = TimeNow;
         Stream->RecvWindowBytesDelivered = 0;
 
-    } else if (!(Stream->Connection->Send.SendFlags & QUIC_CONN_SEND_FLAG_ACK)) {
+    } else {
         //
-        // We haven't hit the drain limit AND we don't have any ACKs to send
-        // immediately, so we don't need to immediately update the max data
-        // values.
+        // We haven't hit the drain limit, so the update isn't worth a packet
+        // of its own unless the peer's remaining send allowance is running
+        // low. Below that, the update is queued without scheduling a send and
+        // just rides along with the next packet sent for any other reason.
         //
-        return;
+        ScheduleSend =
+            Stream->MaxAllowedRecvOffset - Stream->RecvBuffer.BaseOffset <
+                Stream->RecvBuffer.VirtualBufferLength /
+                    QUIC_RECV_WINDOW_UPDATE_RATIO;
     }
 
     //
@@ -642,20 +904,31 @@ QuicStreamOnBytesDelivered(
         Stream,
         "Updating flow control window");
 
+    //
+    // A freshly shrunk window can leave the next advertisement equal to (but
+    // never below) the one already sent.
+    //
     QUIC_DBG_ASSERT(
-        Stream->RecvBuffer.BaseOffset + Stream->RecvBuffer.VirtualBufferLength >
+        Stream->RecvBuffer.BaseOffset + Stream->RecvBuffer.VirtualBufferLength >=
         Stream->MaxAllowedRecvOffset);
 
     Stream->MaxAllowedRecvOffset =
         Stream->RecvBuffer.BaseOffset + Stream->RecvBuffer.VirtualBufferLength;
 
-    QuicSendSetSendFlag(
-        &Stream->Connection->Send,
-        QUIC_CONN_SEND_FLAG_MAX_DATA);
+    if (ScheduleSend) {
+        QuicSendSetSendFlag(
+            &Stream->Connection->Send,
+            QUIC_CONN_SEND_FLAG_MAX_DATA);
+    } else {
+        QuicSendSetDelayedSendFlag(
+            &Stream->Connection->Send,
+            QUIC_CONN_SEND_FLAG_MAX_DATA);
+    }
     QuicSendSetStreamSendFlag(
         &Stream->Connection->Send,
         Stream,
-        QUIC_STREAM_SEND_FLAG_MAX_DATA);
+        QUIC_STREAM_SEND_FLAG_MAX_DATA,
+        !ScheduleSend);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -674,16 +947,21 @@ QuicStreamRecvFlush(
     }
 
     QUIC_TEL_ASSERT(Stream->Flags.ReceiveDataPending);
-    QUIC_TEL_ASSERT(!Stream->Flags.ReceiveCallPending);
 
+    const uint64_t FlushStartTime = QuicTimeUs64();
     BOOLEAN FlushRecv = TRUE;
     while (FlushRecv) {
 
-        QUIC_BUFFER RecvBuffers[2];
+        //
+        // The chunked receive buffer returns one buffer per chunk spanned.
+        // Anything beyond what fits here is just delivered on the next loop
+        // iteration.
+        //
+        QUIC_BUFFER RecvBuffers[3];
         QUIC_STREAM_EVENT Event = {0};
         Event.Type = QUIC_STREAM_EVENT_RECEIVE;
         Event.RECEIVE.Flags = 0;
-        Event.RECEIVE.BufferCount = 2;
+        Event.RECEIVE.BufferCount = 3;
         Event.RECEIVE.Buffers = RecvBuffers;
 
         //
@@ -696,6 +974,15 @@ QuicStreamRecvFlush(
                 &Event.RECEIVE.BufferCount,
                 RecvBuffers);
 
+        if (!DataAvailable && Stream->Flags.ReceiveCallPending) {
+            //
+            // Everything currently buffered is already covered by earlier
+            // receives that are still pending completion. Nothing new to
+            // indicate.
+            //
+            return;
+        }
+
         Stream->Flags.ReceiveEnabled = FALSE;
         Stream->Flags.ReceiveCallPending = TRUE;
 
@@ -704,7 +991,7 @@ QuicStreamRecvFlush(
                 Event.RECEIVE.TotalBufferLength += RecvBuffers[i].Length;
             }
             QUIC_DBG_ASSERT(Event.RECEIVE.TotalBufferLength != 0);
-            Stream->RecvPendingLength = Event.RECEIVE.TotalBufferLength;
+            Stream->RecvPendingLength += Event.RECEIVE.TotalBufferLength;
 
             if (Event.RECEIVE.AbsoluteOffset < Stream->RecvMax0RttLength) {
                 //
@@ -781,6 +1068,177 @@ QuicStreamRecvFlush(
         }
 
         FlushRecv = QuicStreamReceiveComplete(Stream, Event.RECEIVE.TotalBufferLength);
+
+        if (FlushRecv &&
+            QuicTimeDiff64(FlushStartTime, QuicTimeUs64()) >=
+                QUIC_OPERATION_TIME_SLICE_US) {
+            //
+            // The app is draining synchronously, but this stream has used up
+            // its time slice. Requeue the flush and yield the worker so the
+            // connection's other streams (and the worker's other connections)
+            // aren't starved behind one large buffered stream.
+            //
+            QuicStreamRecvQueueFlush(Stream);
+            break;
+        }
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamRecvFlushBatch(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_reads_(StreamCount) QUIC_STREAM** Streams,
+    _In_ uint32_t StreamCount
+    )
+{
+    QUIC_BUFFER RecvBuffers[QUIC_MAX_BATCHED_RECEIVE_COUNT][3];
+    QUIC_BATCHED_RECEIVE_ENTRY Entries[QUIC_MAX_BATCHED_RECEIVE_COUNT];
+    QUIC_STREAM* EntryStreams[QUIC_MAX_BATCHED_RECEIVE_COUNT];
+    uint32_t EntryCount = 0;
+
+    QUIC_DBG_ASSERT(StreamCount <= QUIC_MAX_BATCHED_RECEIVE_COUNT);
+
+    for (uint32_t i = 0; i < StreamCount; ++i) {
+        QUIC_STREAM* Stream = Streams[i];
+
+        Stream->Flags.ReceiveFlushQueued = FALSE;
+        if (!Stream->Flags.ReceiveEnabled) {
+            QuicTraceLogStreamVerbose(
+                IgnoreRecvFlushBatch,
+                Stream,
+                "Ignoring recv flush (recv disabled)");
+            continue;
+        }
+
+        QUIC_TEL_ASSERT(Stream->Flags.ReceiveDataPending);
+
+        if (Stream->Flags.ReceiveCallPending) {
+            //
+            // The app re-enabled receives while earlier receives are still
+            // pending completion. Overlapped receives can't be expressed in
+            // the batched event, so deliver this stream individually.
+            //
+            QuicStreamRecvFlush(Stream);
+            continue;
+        }
+
+        QUIC_BATCHED_RECEIVE_ENTRY* Entry = &Entries[EntryCount];
+        QuicZeroMemory(Entry, sizeof(*Entry));
+        Entry->Buffers = RecvBuffers[EntryCount];
+        Entry->BufferCount = 3;
+
+        BOOLEAN DataAvailable =
+            QuicRecvBufferRead(
+                &Stream->RecvBuffer,
+                &Entry->AbsoluteOffset,
+                &Entry->BufferCount,
+                RecvBuffers[EntryCount]);
+
+        Stream->Flags.ReceiveEnabled = FALSE;
+        Stream->Flags.ReceiveCallPending = TRUE;
+
+        if (!DataAvailable) {
+            //
+            // FIN only case. There is nothing to deliver to the app, so
+            // complete the (empty) receive immediately.
+            //
+            Stream->RecvPendingLength = 0;
+            if (QuicStreamReceiveComplete(Stream, 0)) {
+                QuicStreamRecvFlush(Stream);
+            }
+            continue;
+        }
+
+        for (uint32_t j = 0; j < Entry->BufferCount; ++j) {
+            Entry->TotalBufferLength += RecvBuffers[EntryCount][j].Length;
+        }
+        QUIC_DBG_ASSERT(Entry->TotalBufferLength != 0);
+        Stream->RecvPendingLength += Entry->TotalBufferLength;
+
+        if (Entry->AbsoluteOffset < Stream->RecvMax0RttLength) {
+            //
+            // This data includes data encrypted with 0-RTT key.
+            //
+            Entry->Flags |= QUIC_RECEIVE_FLAG_0_RTT;
+        }
+
+        if (Entry->AbsoluteOffset + Entry->TotalBufferLength == Stream->RecvMaxLength) {
+            //
+            // This data goes all the way to the FIN.
+            //
+            Entry->Flags |= QUIC_RECEIVE_FLAG_FIN;
+        }
+
+        Entry->Stream = (HQUIC)Stream;
+        Entry->StreamContext = Stream->ClientContext;
+        Entry->BytesConsumed = Entry->TotalBufferLength;
+        Entry->Status = QUIC_STATUS_SUCCESS;
+        EntryStreams[EntryCount] = Stream;
+        EntryCount++;
+    }
+
+    if (EntryCount == 0) {
+        return;
+    }
+
+    QUIC_CONNECTION_EVENT Event;
+    Event.Type = QUIC_CONNECTION_EVENT_BATCHED_RECEIVE;
+    Event.BATCHED_RECEIVE.Entries = Entries;
+    Event.BATCHED_RECEIVE.EntryCount = EntryCount;
+
+    QuicTraceLogConnVerbose(
+        IndicateBatchedReceive,
+        Connection,
+        "Indicating QUIC_CONNECTION_EVENT_BATCHED_RECEIVE [%u entries]",
+        EntryCount);
+    (void)QuicConnIndicateEvent(Connection, &Event);
+
+    for (uint32_t i = 0; i < EntryCount; ++i) {
+        QUIC_STREAM* Stream = EntryStreams[i];
+        const QUIC_BATCHED_RECEIVE_ENTRY* Entry = &Entries[i];
+
+        if (Entry->Status == QUIC_STATUS_PENDING) {
+            if (Stream->Flags.ReceiveCallPending) {
+                //
+                // If the pending entry wasn't completed inline, then receive
+                // callbacks MUST be disabled still.
+                //
+                QUIC_TEL_ASSERTMSG_ARGS(
+                    !Stream->Flags.ReceiveEnabled,
+                    "App pended recv AND enabled additional recv callbacks",
+                    Connection->Registration->AppName,
+                    0, 0);
+                Stream->Flags.ReceiveEnabled = FALSE;
+            }
+            continue;
+        }
+
+        if (Entry->Status == QUIC_STATUS_CONTINUE) {
+            //
+            // The app has explicitly indicated it wants to continue to
+            // receive callbacks, even if all the data wasn't drained.
+            //
+            Stream->Flags.ReceiveEnabled = TRUE;
+        } else {
+            //
+            // All other failure status returns are ignored and shouldn't be
+            // used by the app.
+            //
+            QUIC_TEL_ASSERTMSG_ARGS(
+                QUIC_SUCCEEDED(Entry->Status),
+                "App failed recv callback",
+                Connection->Registration->AppName,
+                Entry->Status, 0);
+        }
+
+        if (QuicStreamReceiveComplete(Stream, Entry->BytesConsumed)) {
+            //
+            // More data is ready to deliver for this stream; use the
+            // single-stream flush loop for the remainder.
+            //
+            QuicStreamRecvFlush(Stream);
+        }
     }
 }
 
@@ -811,7 +1269,6 @@ QuicStreamReceiveComplete(
         BufferLength <= Stream->RecvPendingLength,
         "App overflowed read buffer!");
 
-    Stream->Flags.ReceiveCallPending = FALSE;
     QuicTraceLogStreamVerbose(
         ReceiveComplete,
         Stream,
@@ -819,26 +1276,41 @@ QuicStreamReceiveComplete(
         BufferLength);
 
     //
-    // Reclaim any buffer space comsumed by the app.
+    // Reclaim any buffer space comsumed by the app. This completes the
+    // oldest outstanding read; with overlapped receives more reads may
+    // still be pending, so the call pending flag only clears with the
+    // last one.
     //
-    if (Stream->RecvPendingLength == 0 ||
+    if (Stream->RecvBuffer.ReadPendingCount == 0 ||
         QuicRecvBufferDrain(&Stream->RecvBuffer, BufferLength)) {
         //
         // No more pending data to deliver.
         //
         Stream->Flags.ReceiveDataPending = FALSE;
     }
+    Stream->Flags.ReceiveCallPending =
+        Stream->RecvBuffer.ReadPendingCount != 0;
+    Stream->RecvPendingLength -= BufferLength;
 
     if (BufferLength != 0) {
         QuicStreamOnBytesDelivered(Stream, BufferLength);
     }
 
-    if (BufferLength == Stream->RecvPendingLength) {
-        //
-        // All data was drained from the callback, so additional callbacks can
-        // continue to be delivered.
-        //
-        Stream->Flags.ReceiveEnabled = TRUE;
+    if (!Stream->Flags.ReceiveCallPending) {
+        if (Stream->RecvPendingLength == 0) {
+            //
+            // All indicated data was drained, so additional callbacks can
+            // continue to be delivered.
+            //
+            Stream->Flags.ReceiveEnabled = TRUE;
+        } else {
+            //
+            // Some of the indicated data wasn't consumed. The receive buffer
+            // already rewound it, so it gets indicated again once the app
+            // re-enables receive callbacks.
+            //
+            Stream->RecvPendingLength = 0;
+        }
     }
 
     if (!Stream->Flags.ReceiveEnabled) {
@@ -862,7 +1334,8 @@ QuicStreamReceiveComplete(
         return TRUE;
     }
 
-    if (Stream->RecvBuffer.BaseOffset == Stream->RecvMaxLength) {
+    if (Stream->RecvBuffer.BaseOffset == Stream->RecvMaxLength &&
+        !Stream->Flags.RemoteCloseFin) {
         QUIC_DBG_ASSERT(!Stream->Flags.ReceiveDataPending);
         //
         // We have delivered all the payload that needs to be delivered. Deliver
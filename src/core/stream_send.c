@@ -35,12 +35,31 @@ Abstract:
 
 #include "precomp.h"
 
+//
+// Accumulates the client contexts of completed send requests so they can be
+// indicated to the app in a single batched event per drain, instead of one
+// callback per request.
+//
+typedef struct QUIC_SEND_COMPLETE_BATCH {
+    BOOLEAN Canceled;
+    uint32_t Count;
+    void* ClientContexts[QUIC_MAX_BATCHED_SEND_COMPLETE_COUNT];
+} QUIC_SEND_COMPLETE_BATCH;
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicStreamCompleteSendRequest(
     _In_ QUIC_STREAM* Stream,
     _In_ QUIC_SEND_REQUEST* SendRequest,
-    _In_ BOOLEAN Canceled
+    _In_ BOOLEAN Canceled,
+    _Inout_opt_ QUIC_SEND_COMPLETE_BATCH* Batch
+    );
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamIndicateSendCompleteBatch(
+    _In_ QUIC_STREAM* Stream,
+    _Inout_ QUIC_SEND_COMPLETE_BATCH* Batch
     );
 
 #if DEBUG
@@ -129,6 +148,9 @@ QuicStreamSendShutdown(
         }
 
         QUIC_CONN_VERIFY(Stream->Connection, ApiSendRequests == NULL);
+        QUIC_SEND_COMPLETE_BATCH Batch;
+        Batch.Canceled = TRUE;
+        Batch.Count = 0;
         while (ApiSendRequests != NULL) {
             //
             // These sends were queued by the app after queueing a graceful
@@ -136,8 +158,9 @@ QuicStreamSendShutdown(
             //
             QUIC_SEND_REQUEST* SendRequest = ApiSendRequests;
             ApiSendRequests = ApiSendRequests->Next;
-            QuicStreamCompleteSendRequest(Stream, SendRequest, TRUE);
+            QuicStreamCompleteSendRequest(Stream, SendRequest, TRUE, &Batch);
         }
+        QuicStreamIndicateSendCompleteBatch(Stream, &Batch);
 
         Stream->Flags.LocalCloseFin = TRUE;
 
@@ -147,25 +170,30 @@ QuicStreamSendShutdown(
         QuicSendSetStreamSendFlag(
             &Stream->Connection->Send,
             Stream,
-            QUIC_STREAM_SEND_FLAG_FIN);
+            QUIC_STREAM_SEND_FLAG_FIN,
+            FALSE);
 
     } else {
 
         //
         // Make sure to deliver all send request cancelled callbacks first.
         //
+        QUIC_SEND_COMPLETE_BATCH Batch;
+        Batch.Canceled = TRUE;
+        Batch.Count = 0;
         while (Stream->SendRequests) {
             QUIC_SEND_REQUEST* Req = Stream->SendRequests;
             Stream->SendRequests = Stream->SendRequests->Next;
-            QuicStreamCompleteSendRequest(Stream, Req, TRUE);
+            QuicStreamCompleteSendRequest(Stream, Req, TRUE, &Batch);
         }
         Stream->SendRequestsTail = &Stream->SendRequests;
 
         while (ApiSendRequests != NULL) {
             QUIC_SEND_REQUEST* SendRequest = ApiSendRequests;
             ApiSendRequests = ApiSendRequests->Next;
-            QuicStreamCompleteSendRequest(Stream, SendRequest, TRUE);
+            QuicStreamCompleteSendRequest(Stream, SendRequest, TRUE, &Batch);
         }
+        QuicStreamIndicateSendCompleteBatch(Stream, &Batch);
 
         if (Silent) {
             //
@@ -203,7 +231,8 @@ QuicStreamSendShutdown(
             QuicSendSetStreamSendFlag(
                 &Stream->Connection->Send,
                 Stream,
-                QUIC_STREAM_SEND_FLAG_SEND_ABORT);
+                QUIC_STREAM_SEND_FLAG_SEND_ABORT,
+                FALSE);
 
             //
             // Clear any outstanding send path frames.
@@ -277,6 +306,93 @@ QuicStreamHasPending0RttData(
          (Stream->SendFlags & QUIC_STREAM_SEND_FLAG_FIN));
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicStreamSendCancelUnsent(
+    _In_ QUIC_STREAM* Stream
+    )
+{
+    if (Stream->Flags.LocalCloseFin || Stream->Flags.LocalCloseReset) {
+        //
+        // The send direction is already closed; there is nothing left worth
+        // cancelling piecemeal.
+        //
+        return QUIC_STATUS_INVALID_STATE;
+    }
+
+    QuicDispatchLockAcquire(&Stream->ApiSendRequestLock);
+    QUIC_SEND_REQUEST* ApiSendRequests = Stream->ApiSendRequests;
+    Stream->ApiSendRequests = NULL;
+    QuicDispatchLockRelease(&Stream->ApiSendRequestLock);
+
+    //
+    // Find the first queued request that hasn't had any byte framed into a
+    // packet yet. Requests complete all-or-nothing, so one that straddles
+    // MaxSentLength has to stay queued in full; everything after it has never
+    // been on the wire and can be dropped, which simply shortens the stream.
+    //
+    QUIC_SEND_REQUEST** Tail = &Stream->SendRequests;
+    while (*Tail != NULL && (*Tail)->StreamOffset < Stream->MaxSentLength) {
+        Tail = &(*Tail)->Next;
+    }
+    QUIC_SEND_REQUEST* DroppedRequests = *Tail;
+    *Tail = NULL;
+    Stream->SendRequestsTail = Tail;
+
+    //
+    // NULL out any bookmark that points into the dropped chain, both so the
+    // copy/buffer paths don't chase freed requests and so the send buffer
+    // logic (invoked as each completion returns posted bytes) can't buffer a
+    // request that is about to be completed as canceled. A NULL bookmark just
+    // means the next lookup searches from the front of the queue.
+    //
+    for (QUIC_SEND_REQUEST* Req = DroppedRequests; Req != NULL; Req = Req->Next) {
+        if (Stream->SendBookmark == Req) {
+            Stream->SendBookmark = NULL;
+        }
+        if (Stream->SendBufferBookmark == Req) {
+            Stream->SendBufferBookmark = NULL;
+        }
+    }
+
+    if (DroppedRequests != NULL) {
+        Stream->QueuedSendOffset = DroppedRequests->StreamOffset;
+        if (Stream->Queued0Rtt > Stream->QueuedSendOffset) {
+            Stream->Queued0Rtt = Stream->QueuedSendOffset;
+        }
+    }
+
+    QUIC_SEND_COMPLETE_BATCH Batch;
+    Batch.Canceled = TRUE;
+    Batch.Count = 0;
+    while (DroppedRequests != NULL) {
+        QUIC_SEND_REQUEST* Req = DroppedRequests;
+        DroppedRequests = DroppedRequests->Next;
+        QuicStreamCompleteSendRequest(Stream, Req, TRUE, &Batch);
+    }
+    while (ApiSendRequests != NULL) {
+        //
+        // These sends never even made it onto the queue; they were posted
+        // after the data the app is now cancelling, so drop them too.
+        //
+        QUIC_SEND_REQUEST* Req = ApiSendRequests;
+        ApiSendRequests = ApiSendRequests->Next;
+        QuicStreamCompleteSendRequest(Stream, Req, TRUE, &Batch);
+    }
+    QuicStreamIndicateSendCompleteBatch(Stream, &Batch);
+
+    if (!QuicStreamHasPendingStreamData(Stream)) {
+        QuicSendClearStreamSendFlag(
+            &Stream->Connection->Send,
+            Stream,
+            QUIC_STREAM_SEND_FLAG_DATA);
+    }
+
+    QuicStreamSendDumpState(Stream);
+
+    return QUIC_STATUS_SUCCESS;
+}
+
 //
 // Returns TRUE if the stream can send a STREAM frame immediately. This
 // function does not include any congestion control state checks.
@@ -350,18 +466,49 @@ QuicStreamCanSendNow(
     return FALSE;
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamIndicateSendCompleteBatch(
+    _In_ QUIC_STREAM* Stream,
+    _Inout_ QUIC_SEND_COMPLETE_BATCH* Batch
+    )
+{
+    if (Batch->Count == 0) {
+        return;
+    }
+
+    QUIC_STREAM_EVENT Event;
+    Event.Type = QUIC_STREAM_EVENT_BATCHED_SEND_COMPLETE;
+    Event.BATCHED_SEND_COMPLETE.Canceled = Batch->Canceled;
+    Event.BATCHED_SEND_COMPLETE.ClientContextCount = Batch->Count;
+    Event.BATCHED_SEND_COMPLETE.ClientContexts = Batch->ClientContexts;
+
+    QuicTraceLogStreamVerbose(
+        IndicateBatchedSendComplete,
+        Stream,
+        "Indicating QUIC_STREAM_EVENT_BATCHED_SEND_COMPLETE [%u requests]",
+        Batch->Count);
+
+    (void)QuicStreamIndicateEvent(Stream, &Event);
+    Batch->Count = 0;
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicStreamCompleteSendRequest(
     _In_ QUIC_STREAM* Stream,
     _In_ QUIC_SEND_REQUEST* SendRequest,
-    _In_ BOOLEAN Canceled
+    _In_ BOOLEAN Canceled,
+    _Inout_opt_ QUIC_SEND_COMPLETE_BATCH* Batch
     )
 {
     QUIC_CONNECTION* Connection = Stream->Connection;
 
     if (Stream->SendBookmark == SendRequest) {
         Stream->SendBookmark = SendRequest->Next;
+        Stream->SendBookmarkIndex = 0;
+        Stream->SendBookmarkOffset =
+            SendRequest->StreamOffset + SendRequest->TotalLength;
     }
     if (Stream->SendBufferBookmark == SendRequest) {
         Stream->SendBufferBookmark = SendRequest->Next;
@@ -370,7 +517,20 @@ QuicStreamCompleteSendRequest(
             !(Stream->SendBufferBookmark->Flags & QUIC_SEND_FLAG_BUFFERED));
     }
 
-    if (!(SendRequest->Flags & QUIC_SEND_FLAG_BUFFERED)) {
+    if (!(SendRequest->Flags & QUIC_SEND_FLAG_BUFFERED) &&
+        Batch != NULL &&
+        Connection->State.BatchedSendCompleteEnabled) {
+        //
+        // Accumulate the completion so the whole drain is indicated to the
+        // app in a single callback.
+        //
+        QUIC_DBG_ASSERT(Batch->Canceled == Canceled);
+        if (Batch->Count == ARRAYSIZE(Batch->ClientContexts)) {
+            QuicStreamIndicateSendCompleteBatch(Stream, Batch);
+        }
+        Batch->ClientContexts[Batch->Count++] = SendRequest->ClientContext;
+
+    } else if (!(SendRequest->Flags & QUIC_SEND_FLAG_BUFFERED)) {
         QUIC_STREAM_EVENT Event;
         Event.Type = QUIC_STREAM_EVENT_SEND_COMPLETE;
         Event.SEND_COMPLETE.Canceled = Canceled;
@@ -399,6 +559,7 @@ QuicStreamCompleteSendRequest(
     }
 
     Stream->Connection->SendBuffer.PostedBytes -= SendRequest->TotalLength;
+    QuicSendBufferUpdateStall(&Stream->Connection->SendBuffer);
 
     if (Connection->State.UseSendBuffer) {
         QuicSendBufferFill(Connection);
@@ -493,6 +654,7 @@ QuicStreamSendFlush(
         }
 
         Stream->Connection->SendBuffer.PostedBytes += SendRequest->TotalLength;
+        QuicSendBufferUpdateStall(&Stream->Connection->SendBuffer);
 
         //
         // Queue up the send request.
@@ -518,6 +680,8 @@ QuicStreamSendFlush(
         //
         if (Stream->SendBookmark == NULL) {
             Stream->SendBookmark = SendRequest;
+            Stream->SendBookmarkIndex = 0;
+            Stream->SendBookmarkOffset = SendRequest->StreamOffset;
         }
         if (Stream->SendBufferBookmark == NULL) {
             //
@@ -553,7 +717,8 @@ QuicStreamSendFlush(
         QuicSendSetStreamSendFlag(
             &Stream->Connection->Send,
             Stream,
-            QUIC_STREAM_SEND_FLAG_DATA);
+            QUIC_STREAM_SEND_FLAG_DATA,
+            !!(SendRequest->Flags & QUIC_SEND_FLAG_DELAY_SEND));
 
         if (Stream->Connection->State.UseSendBuffer) {
             QuicSendBufferFill(Stream->Connection);
@@ -601,36 +766,43 @@ QuicStreamCopyFromSendRequests(
     }
 
     //
-    // Find the send request containing the first byte, using the bookmark if
-    // possible (if the caller is requesting bytes before the bookmark, e.g.
-    // for a retransmission, then we have to do a full search).
+    // Find the request buffer containing the first byte. In the common
+    // in-order case the cursor saved by the previous call already points at
+    // (or just before) it. Bytes before the cursor (e.g. a retransmission)
+    // require a full search from the front of the queue.
     //
+    uint32_t CurIndex; // Index of the current buffer.
+    uint64_t BufferOffset; // Stream offset of the current buffer's first byte.
     if (Stream->SendBookmark != NULL &&
-        Stream->SendBookmark->StreamOffset <= Offset) {
+        Stream->SendBookmarkOffset <= Offset) {
         Req = Stream->SendBookmark;
+        CurIndex = Stream->SendBookmarkIndex;
+        BufferOffset = Stream->SendBookmarkOffset;
     } else {
         Req = Stream->SendRequests;
+        while (Req && (Req->StreamOffset + Req->TotalLength <= Offset)) {
+            Req = Req->Next;
+        }
+        QUIC_DBG_ASSERT(Req);
+        CurIndex = 0;
+        BufferOffset = Req->StreamOffset;
     }
-    while (Req && (Req->StreamOffset + Req->TotalLength <= Offset)) {
-        Req = Req->Next;
+
+    while (BufferOffset + Req->Buffers[CurIndex].Length <= Offset) {
+        BufferOffset += Req->Buffers[CurIndex].Length;
+        if (++CurIndex == Req->BufferCount) {
+            Req = Req->Next;
+            QUIC_DBG_ASSERT(Req);
+            CurIndex = 0;
+        }
     }
 
-    QUIC_DBG_ASSERT(Req);
+    uint64_t CurOffset = Offset - BufferOffset; // Offset in the current buffer.
 
     //
     // Loop over request buffers until we've copied enough bytes.
     //
 
-    uint32_t CurIndex = 0; // Index of the current buffer.
-    uint64_t CurOffset = Offset - Req->StreamOffset; // Offset in the current buffer.
-
-    //
-    // Find the correct request buffer to start copying from.
-    //
-    while (CurOffset > Req->Buffers[CurIndex].Length) {
-        CurOffset -= Req->Buffers[CurIndex++].Length;
-    }
-
     for (;;) {
         QUIC_DBG_ASSERT(Req != NULL);
         QUIC_DBG_ASSERT(CurIndex < Req->BufferCount);
@@ -657,6 +829,7 @@ QuicStreamCopyFromSendRequests(
         // current request, move to the next request.
         //
         CurOffset = 0;
+        BufferOffset += Req->Buffers[CurIndex].Length;
         if (++CurIndex == Req->BufferCount) {
             QUIC_DBG_ASSERT(Req->Next != NULL);
             Req = Req->Next;
@@ -665,9 +838,11 @@ QuicStreamCopyFromSendRequests(
     }
 
     //
-    // Save the bookmark for later.
+    // Save the cursor for the next in-order call.
     //
     Stream->SendBookmark = Req;
+    Stream->SendBookmarkIndex = CurIndex;
+    Stream->SendBookmarkOffset = BufferOffset;
 
     return Copied;
 }
@@ -923,7 +1098,7 @@ QuicStreamWriteStreamFrames(
                     Stream, QUIC_FLOW_BLOCKED_STREAM_FLOW_CONTROL)) {
                 QuicSendSetStreamSendFlag(
                     &Stream->Connection->Send,
-                    Stream, QUIC_STREAM_SEND_FLAG_DATA_BLOCKED);
+                    Stream, QUIC_STREAM_SEND_FLAG_DATA_BLOCKED, FALSE);
             }
             ExitLoop = TRUE;
         }
@@ -1246,7 +1421,8 @@ Done:
             QuicSendSetStreamSendFlag(
                 &Stream->Connection->Send,
                 Stream,
-                AddSendFlags);
+                AddSendFlags,
+                FALSE);
 
         QuicStreamSendDumpState(Stream);
         QuicStreamValidateRecoveryState(Stream);
@@ -1336,6 +1512,9 @@ QuicStreamOnAck(
             // where UnAckedOffset has advanced, which means we complete send
             // requests in the order that they are queued.
             //
+            QUIC_SEND_COMPLETE_BATCH Batch;
+            Batch.Canceled = FALSE;
+            Batch.Count = 0;
             while (Stream->SendRequests) {
 
                 QUIC_SEND_REQUEST* Req = Stream->SendRequests;
@@ -1352,8 +1531,9 @@ QuicStreamOnAck(
                     Stream->SendRequestsTail = &Stream->SendRequests;
                 }
 
-                QuicStreamCompleteSendRequest(Stream, Req, FALSE);
+                QuicStreamCompleteSendRequest(Stream, Req, FALSE, &Batch);
             }
+            QuicStreamIndicateSendCompleteBatch(Stream, &Batch);
 
             if (Stream->NextSendOffset < Stream->UnAckedOffset) {
                 Stream->NextSendOffset = Stream->UnAckedOffset;
@@ -24,16 +24,18 @@ QuicStreamSetValidate(
         return; // No streams have been created.
     }
     QUIC_CONNECTION* Connection = QuicStreamSetGetConnection(StreamSet);
-    QUIC_HASHTABLE_ENUMERATOR Enumerator;
-    QUIC_HASHTABLE_ENTRY* Entry;
-    QuicHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
-    while ((Entry = QuicHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
-        const QUIC_STREAM* Stream = QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
+    QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+    const QUIC_STREAM* Stream;
+    QuicFlatHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
+    while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
         QUIC_DBG_ASSERT(Stream->Type == QUIC_HANDLE_TYPE_STREAM);
         QUIC_DBG_ASSERT(Stream->Connection == Connection);
+        QUIC_DBG_ASSERT(
+            (Stream->ID >> 2) >= QUIC_STREAM_SET_DIRECT_COUNT ||
+            StreamSet->DirectMap[Stream->ID & STREAM_ID_MASK][Stream->ID >> 2] == Stream);
         UNREFERENCED_PARAMETER(Stream);
     }
-    QuicHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
+    QuicFlatHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
 }
 #else
 #define QuicStreamSetValidate(StreamSet)
@@ -46,6 +48,10 @@ QuicStreamSetInitialize(
     )
 {
     QuicListInitializeHead(&StreamSet->ClosedStreams);
+    QuicListInitializeHead(&StreamSet->WaitingStreams);
+    QuicDispatchLockInitialize(&StreamSet->RecycledStreamsLock);
+    StreamSet->RecycledStreams.Next = NULL;
+    StreamSet->RecycledStreamCount = 0;
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -54,11 +60,66 @@ QuicStreamSetUninitialize(
     _Inout_ QUIC_STREAM_SET* StreamSet
     )
 {
+    //
+    // All streams have been freed by this point (they each hold a ref on the
+    // connection), so the only objects left are the recycled ones. Tear down
+    // the allocations that were preserved for reuse.
+    //
+    QUIC_SINGLE_LIST_ENTRY* Entry;
+    while ((Entry = QuicListPopEntry(&StreamSet->RecycledStreams)) != NULL) {
+        QUIC_STREAM* Stream = (QUIC_STREAM*)Entry;
+        QuicRecvBufferUninitialize(&Stream->RecvBuffer);
+        QuicRangeUninitialize(&Stream->SparseAckRanges);
+        QuicPoolFree(
+            &QuicStreamSetGetConnection(StreamSet)->Worker->StreamPool,
+            Stream);
+    }
+    QuicDispatchLockUninitialize(&StreamSet->RecycledStreamsLock);
     if (StreamSet->StreamTable != NULL) {
-        QuicHashtableUninitialize(StreamSet->StreamTable);
+        QuicFlatHashtableUninitialize(StreamSet->StreamTable);
     }
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicStreamSetRecycleStream(
+    _Inout_ QUIC_STREAM_SET* StreamSet,
+    _In_ QUIC_STREAM* Stream
+    )
+{
+    BOOLEAN Recycled = FALSE;
+    QuicDispatchLockAcquire(&StreamSet->RecycledStreamsLock);
+    if (StreamSet->RecycledStreamCount < QUIC_STREAM_RECYCLE_CACHE_SIZE) {
+        //
+        // The object is dead at this point, so its leading bytes can be
+        // repurposed as the list linkage (the same way pools do).
+        //
+        QuicListPushEntry(
+            &StreamSet->RecycledStreams, (QUIC_SINGLE_LIST_ENTRY*)Stream);
+        StreamSet->RecycledStreamCount++;
+        Recycled = TRUE;
+    }
+    QuicDispatchLockRelease(&StreamSet->RecycledStreamsLock);
+    return Recycled;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Ret_maybenull_
+QUIC_STREAM*
+QuicStreamSetGetRecycledStream(
+    _Inout_ QUIC_STREAM_SET* StreamSet
+    )
+{
+    QuicDispatchLockAcquire(&StreamSet->RecycledStreamsLock);
+    QUIC_SINGLE_LIST_ENTRY* Entry =
+        QuicListPopEntry(&StreamSet->RecycledStreams);
+    if (Entry != NULL) {
+        StreamSet->RecycledStreamCount--;
+    }
+    QuicDispatchLockRelease(&StreamSet->RecycledStreamsLock);
+    return (QUIC_STREAM*)Entry;
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicStreamSetTraceRundown(
@@ -69,14 +130,13 @@ QuicStreamSetTraceRundown(
         return; // No streams have been created yet.
     }
 
-    QUIC_HASHTABLE_ENUMERATOR Enumerator;
-    QUIC_HASHTABLE_ENTRY* Entry;
-    QuicHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
-    while ((Entry = QuicHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
-        QuicStreamTraceRundown(
-            QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry));
+    QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+    QUIC_STREAM* Stream;
+    QuicFlatHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
+    while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
+        QuicStreamTraceRundown(Stream);
     }
-    QuicHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
+    QuicFlatHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -91,7 +151,7 @@ QuicStreamSetInsertStream(
         //
         // Lazily initialize the hash table.
         //
-        if (!QuicHashtableInitialize(&StreamSet->StreamTable, QUIC_HASH_MIN_SIZE)) {
+        if (!QuicFlatHashtableInitialize(&StreamSet->StreamTable, QUIC_HASH_MIN_SIZE)) {
             QuicTraceEvent(
                 AllocFailure,
                 "Allocation of '%s' failed. (%llu bytes)",
@@ -100,11 +160,17 @@ QuicStreamSetInsertStream(
             return FALSE;
         }
     }
-    QuicHashtableInsert(
-        StreamSet->StreamTable,
-        &Stream->TableEntry,
-        (uint32_t)Stream->ID,
-        NULL);
+    if (!QuicFlatHashtableInsert(StreamSet->StreamTable, Stream, Stream->ID)) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "streamset hash table (resize)",
+            0);
+        return FALSE;
+    }
+    if ((Stream->ID >> 2) < QUIC_STREAM_SET_DIRECT_COUNT) {
+        StreamSet->DirectMap[Stream->ID & STREAM_ID_MASK][Stream->ID >> 2] = Stream;
+    }
     return TRUE;
 }
 
@@ -116,22 +182,26 @@ QuicStreamSetLookupStream(
     _In_ uint64_t ID
     )
 {
+    if ((ID >> 2) < QUIC_STREAM_SET_DIRECT_COUNT) {
+        //
+        // Small (dense) stream IDs are looked up directly. The slot is NULL
+        // if the stream doesn't exist.
+        //
+        return StreamSet->DirectMap[ID & STREAM_ID_MASK][ID >> 2];
+    }
+
     if (StreamSet->StreamTable == NULL) {
         return NULL; // No streams have been created yet.
     }
 
-    QUIC_HASHTABLE_LOOKUP_CONTEXT Context;
-    QUIC_HASHTABLE_ENTRY* Entry =
-        QuicHashtableLookup(StreamSet->StreamTable, (uint32_t)ID, &Context);
-    while (Entry != NULL) {
-        QUIC_STREAM* Stream =
-            QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
-        if (Stream->ID == ID) {
-            return Stream;
-        }
-        Entry = QuicHashtableLookupNext(StreamSet->StreamTable, &Context);
-    }
-    return NULL;
+    //
+    // The full stream ID is the signature, so a signature match is an exact
+    // match and the first hit (if any) is the stream.
+    //
+    QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT Context;
+    return
+        (QUIC_STREAM*)QuicFlatHashtableLookup(
+            StreamSet->StreamTable, ID, &Context);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -144,11 +214,10 @@ QuicStreamSetShutdown(
         return; // No streams have been created.
     }
 
-    QUIC_HASHTABLE_ENUMERATOR Enumerator;
-    QUIC_HASHTABLE_ENTRY* Entry;
-    QuicHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
-    while ((Entry = QuicHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
-        QUIC_STREAM* Stream = QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
+    QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+    QUIC_STREAM* Stream;
+    QuicFlatHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
+    while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
 
         QuicStreamShutdown(
             Stream,
@@ -157,7 +226,27 @@ QuicStreamSetShutdown(
             QUIC_STREAM_SHUTDOWN_SILENT,
             0);
     }
-    QuicHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
+    QuicFlatHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamSetHibernate(
+    _Inout_ QUIC_STREAM_SET* StreamSet,
+    _In_ uint32_t RecvBufferLength
+    )
+{
+    if (StreamSet->StreamTable == NULL) {
+        return; // No streams have been created.
+    }
+
+    QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+    QUIC_STREAM* Stream;
+    QuicFlatHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
+    while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
+        QuicRecvBufferShrink(&Stream->RecvBuffer, RecvBufferLength);
+    }
+    QuicFlatHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -170,7 +259,17 @@ QuicStreamSetReleaseStream(
     //
     // Remove the stream from the list of open streams.
     //
-    QuicHashtableRemove(StreamSet->StreamTable, &Stream->TableEntry, NULL);
+    QuicFlatHashtableRemove(StreamSet->StreamTable, Stream, Stream->ID);
+    if ((Stream->ID >> 2) < QUIC_STREAM_SET_DIRECT_COUNT) {
+        StreamSet->DirectMap[Stream->ID & STREAM_ID_MASK][Stream->ID >> 2] = NULL;
+    }
+    if (Stream->OutFlowBlockedReasons & QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL) {
+        //
+        // The stream was closed while still waiting for stream ID flow
+        // control, so it also needs to come off the waiting list.
+        //
+        QuicListEntryRemove(&Stream->WaitingForIdFlowControlLink);
+    }
     QuicListInsertTail(&StreamSet->ClosedStreams, &Stream->ClosedLink);
 
     uint8_t Flags = (uint8_t)(Stream->ID & STREAM_ID_MASK);
@@ -272,11 +371,10 @@ QuicStreamSetInitializeTransportParameters(
     }
 
     if (StreamSet->StreamTable != NULL) {
-        QUIC_HASHTABLE_ENUMERATOR Enumerator;
-        QUIC_HASHTABLE_ENTRY* Entry;
-        QuicHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
-        while ((Entry = QuicHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
-            QUIC_STREAM* Stream = QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
+        QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+        QUIC_STREAM* Stream;
+        QuicFlatHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
+        while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
 
             uint8_t FlowBlockedFlagsToRemove = 0;
 
@@ -286,6 +384,10 @@ QuicStreamSetInitializeTransportParameters(
                 &Stream->Connection->Streams.Types[StreamType];
             if (Info->MaxTotalStreamCount >= StreamCount) {
                 FlowBlockedFlagsToRemove |= QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL;
+                if (Stream->OutFlowBlockedReasons &
+                    QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL) {
+                    QuicListEntryRemove(&Stream->WaitingForIdFlowControlLink);
+                }
             }
 
             uint64_t NewMaxAllowedSendOffset =
@@ -307,7 +409,7 @@ QuicStreamSetInitializeTransportParameters(
                 MightBeUnblocked = TRUE;
             }
         }
-        QuicHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
+        QuicFlatHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
     }
 
     if (UpdateAvailableStreams) {
@@ -361,26 +463,28 @@ QuicStreamSetUpdateMaxStreams(
             BidirectionalStreams,
             MaxStreams);
 
+        //
+        // Only the streams blocked on stream ID flow control need to be
+        // looked at, so walk the waiting list instead of every open stream.
+        //
         BOOLEAN FlushSend = FALSE;
-        if (StreamSet->StreamTable != NULL) {
-
-            QUIC_HASHTABLE_ENUMERATOR Enumerator;
-            QUIC_HASHTABLE_ENTRY* Entry;
-            QuicHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
-            while ((Entry = QuicHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
-                QUIC_STREAM* Stream = QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
-
-                uint64_t Count = (Stream->ID >> 2) + 1;
-
-                if ((Stream->ID & STREAM_ID_MASK) == Mask &&
-                    Count > Info->MaxTotalStreamCount &&
-                    Count <= MaxStreams) {
-                    FlushSend = TRUE;
-                    QuicStreamRemoveOutFlowBlockedReason(
-                        Stream, QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL);
-                }
+        QUIC_LIST_ENTRY* Entry = StreamSet->WaitingStreams.Flink;
+        while (Entry != &StreamSet->WaitingStreams) {
+
+            QUIC_STREAM* Stream =
+                QUIC_CONTAINING_RECORD(
+                    Entry, QUIC_STREAM, WaitingForIdFlowControlLink);
+            Entry = Entry->Flink;
+
+            uint64_t Count = (Stream->ID >> 2) + 1;
+
+            if ((Stream->ID & STREAM_ID_MASK) == Mask &&
+                Count <= MaxStreams) {
+                FlushSend = TRUE;
+                QuicListEntryRemove(&Stream->WaitingForIdFlowControlLink);
+                QuicStreamRemoveOutFlowBlockedReason(
+                    Stream, QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL);
             }
-            QuicHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
         }
 
         Info->MaxTotalStreamCount = MaxStreams;
@@ -458,11 +562,10 @@ QuicStreamSetGetFlowControlSummary(
     *SendWindow = 0;
 
     if (StreamSet->StreamTable != NULL) {
-        QUIC_HASHTABLE_ENUMERATOR Enumerator;
-        QUIC_HASHTABLE_ENTRY* Entry;
-        QuicHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
-        while ((Entry = QuicHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
-            QUIC_STREAM* Stream = QUIC_CONTAINING_RECORD(Entry, QUIC_STREAM, TableEntry);
+        QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+        QUIC_STREAM* Stream;
+        QuicFlatHashtableEnumerateBegin(StreamSet->StreamTable, &Enumerator);
+        while ((Stream = (QUIC_STREAM*)QuicFlatHashtableEnumerateNext(StreamSet->StreamTable, &Enumerator)) != NULL) {
 
             if ((UINT64_MAX - *FcAvailable) >= (Stream->MaxAllowedSendOffset - Stream->NextSendOffset)) {
                 *FcAvailable += Stream->MaxAllowedSendOffset - Stream->NextSendOffset;
@@ -476,7 +579,7 @@ QuicStreamSetGetFlowControlSummary(
                 *SendWindow = UINT64_MAX;
             }
         }
-        QuicHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
+        QuicFlatHashtableEnumerateEnd(StreamSet->StreamTable, &Enumerator);
     }
 }
 
@@ -514,6 +617,8 @@ QuicStreamSetNewLocalStream(
         // after that.
         //
         Stream->OutFlowBlockedReasons |= QUIC_FLOW_BLOCKED_STREAM_ID_FLOW_CONTROL;
+        QuicListInsertTail(
+            &StreamSet->WaitingStreams, &Stream->WaitingForIdFlowControlLink);
     }
 
     Info->CurrentStreamCount++;
@@ -41,16 +41,41 @@ typedef struct QUIC_STREAM_SET {
     //
     QUIC_STREAM_TYPE_INFO Types[NUMBER_OF_STREAM_TYPES];
 
+    //
+    // A direct-mapped index of the first QUIC_STREAM_SET_DIRECT_COUNT streams
+    // of each type, so lookups for small (dense) stream IDs don't have to go
+    // through the hash table. A stream with a small enough ID is in its slot
+    // here if and only if it is in the hash table.
+    //
+    QUIC_STREAM* DirectMap[NUMBER_OF_STREAM_TYPES][QUIC_STREAM_SET_DIRECT_COUNT];
+
     //
     // The hash table of all active streams.
     //
-    QUIC_HASHTABLE* StreamTable;
+    QUIC_FLAT_HASHTABLE* StreamTable;
 
     //
     // The list of streams that are completely closed and need to be released.
     //
     QUIC_LIST_ENTRY ClosedStreams;
 
+    //
+    // The list of locally initiated streams that are blocked on stream ID
+    // flow control, so a MAX_STREAMS frame only has to visit the blocked
+    // streams instead of enumerating the whole stream table.
+    //
+    QUIC_LIST_ENTRY WaitingStreams;
+
+    //
+    // A small cache of freed stream objects, kept with their receive buffer
+    // and ACK range allocations intact so the next stream open can skip most
+    // of the initialization cost. Protected by RecycledStreamsLock because
+    // the final stream release can happen on an app thread.
+    //
+    QUIC_DISPATCH_LOCK RecycledStreamsLock;
+    QUIC_SINGLE_LIST_ENTRY RecycledStreams;
+    uint8_t RecycledStreamCount;
+
 } QUIC_STREAM_SET;
 
 //
@@ -89,6 +114,38 @@ QuicStreamSetShutdown(
     _Inout_ QUIC_STREAM_SET* StreamSet
     );
 
+//
+// Shrinks every stream's grown receive buffer back to the given allocation
+// size (where possible), as part of hibernating a long-idle connection.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicStreamSetHibernate(
+    _Inout_ QUIC_STREAM_SET* StreamSet,
+    _In_ uint32_t RecvBufferLength
+    );
+
+//
+// Offers a freed stream object to the recycle cache. Returns TRUE if the
+// cache took ownership of the object, FALSE if the caller must free it.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicStreamSetRecycleStream(
+    _Inout_ QUIC_STREAM_SET* StreamSet,
+    _In_ QUIC_STREAM* Stream
+    );
+
+//
+// Retrieves a previously recycled stream object, if any are cached.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+_Ret_maybenull_
+QUIC_STREAM*
+QuicStreamSetGetRecycledStream(
+    _Inout_ QUIC_STREAM_SET* StreamSet
+    );
+
 //
 // Called to inform the stream set that the stream is ready to be cleaned up.
 // The stream set queued the stream for later deletion.
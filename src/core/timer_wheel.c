@@ -24,8 +24,12 @@ Abstract:
         Slots - This is a very simple hash table of time slots. Each slot holds
         all connections with a next expiration time modulo the total slot count.
 
-        Slot Entry - Each slot is made up of a sorted, doubly-linked list of
-        connections.
+        Slot Entry - Each slot is made up of a sorted, intrusive skip list of
+        connections. Level 0 links every connection in the slot; each higher
+        level links a progressively sparser subset, so in-slot searches stay
+        logarithmic even when very large numbers of connections (e.g. an idle
+        timeout heavy workload where everything expires in the same second)
+        hash to the same slot.
 
         Next Expiration - Along with all the connections in the timer wheel, the
         timer wheel also explicitly keeps track of the next expiration time and
@@ -34,14 +38,19 @@ Abstract:
     With these parts, the timer wheel is able to support insertion, update and
     removal of any number of timers (and their associated connection).
 
+    The wheel is almost always driven by its owning worker thread, but when a
+    peer worker steals one of this worker's connections it may update the
+    wheel from its own thread, so all the external entry points serialize on
+    the wheel's lock.
+
     Insertion or update consists of getting the next expiration time from the
-    connection, calculating the correct slot and then doing an insert into the
-    slot's sorted list of connections. Additionally, the next expiration is
-    updated if the new timer is the soonest to expire.
+    connection, calculating the correct slot and then doing a sorted insert
+    into the slot's skip list. Additionally, the next expiration is updated if
+    the new timer is the soonest to expire.
 
-    Removal consists of removing the connection from the doubly-linked list and
-    updating the timer wheel's next expiration if this connection was currently
-    next to expire.
+    Removal consists of unlinking the connection at every skip list level it
+    participates in and updating the timer wheel's next expiration if this
+    connection was currently next to expire.
 
 --*/
 
@@ -63,28 +72,164 @@ Abstract:
 #define TIME_TO_SLOT_INDEX(TimerWheel, TimeUs) \
     ((US_TO_MS(TimeUs) / 1000) % TimerWheel->SlotCount)
 
+//
+// Returns the connection's list entry for the given skip list level.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_LIST_ENTRY*
+QuicTimerWheelConnectionLink(
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ uint32_t Level
+    )
+{
+    return
+        Level == 0 ?
+            &Connection->TimerLink :
+            &Connection->TimerSkipLinks[Level - 1];
+}
+
+//
+// Returns the connection containing the given list entry, which must be the
+// connection's link for the given skip list level.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_CONNECTION*
+QuicTimerWheelLinkToConnection(
+    _In_ QUIC_LIST_ENTRY* Entry,
+    _In_ uint32_t Level
+    )
+{
+    return
+        Level == 0 ?
+            QUIC_CONTAINING_RECORD(Entry, QUIC_CONNECTION, TimerLink) :
+            QUIC_CONTAINING_RECORD(
+                Entry - (Level - 1), QUIC_CONNECTION, TimerSkipLinks);
+}
+
+//
+// Picks a random height for a new skip list entry. Each level is promoted
+// with probability 1/4. Uses a simple xorshift PRNG (seeded from QuicRandom
+// at initialization) since cryptographic quality isn't needed here and this
+// runs for every timer insertion.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+uint8_t
+QuicTimerWheelRandomHeight(
+    _Inout_ QUIC_TIMER_WHEEL* TimerWheel
+    )
+{
+    uint32_t Random = TimerWheel->RandomState;
+    Random ^= Random << 13;
+    Random ^= Random >> 17;
+    Random ^= Random << 5;
+    TimerWheel->RandomState = Random;
+
+    uint8_t Height = 1;
+    while (Height < QUIC_TIMER_WHEEL_SKIP_LEVELS && (Random & 3) == 0) {
+        Height++;
+        Random >>= 2;
+    }
+    return Height;
+}
+
+//
+// Inserts the connection into the slot's skip list, sorted by expiration
+// time. Connections with equal expiration times are inserted after the
+// existing ones, preserving FIFO expiration order.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicTimerWheelSlotInsert(
+    _Inout_ QUIC_TIMER_WHEEL* TimerWheel,
+    _Inout_ QUIC_TIMER_WHEEL_SLOT* Slot,
+    _Inout_ QUIC_CONNECTION* Connection,
+    _In_ uint64_t ExpirationTime
+    )
+{
+    //
+    // Search from the sparsest level down, remembering the insertion point at
+    // each level. When dropping a level, the search continues from the
+    // predecessor found at the level above, so the total work is logarithmic
+    // in the slot's size.
+    //
+    QUIC_LIST_ENTRY* PrevLinks[QUIC_TIMER_WHEEL_SKIP_LEVELS];
+    QUIC_CONNECTION* PrevConnection = NULL; // NULL when still at the list head.
+    QUIC_LIST_ENTRY* Prev = &Slot->Levels[QUIC_TIMER_WHEEL_SKIP_LEVELS - 1];
+
+    for (int32_t Level = QUIC_TIMER_WHEEL_SKIP_LEVELS - 1; Level >= 0; --Level) {
+        while (Prev->Flink != &Slot->Levels[Level]) {
+            QUIC_CONNECTION* NextConnection =
+                QuicTimerWheelLinkToConnection(Prev->Flink, (uint32_t)Level);
+            if (QuicConnGetNextExpirationTime(NextConnection) > ExpirationTime) {
+                break;
+            }
+            Prev = Prev->Flink;
+            PrevConnection = NextConnection;
+        }
+        PrevLinks[Level] = Prev;
+        if (Level != 0) {
+            Prev =
+                PrevConnection == NULL ?
+                    &Slot->Levels[Level - 1] :
+                    QuicTimerWheelConnectionLink(
+                        PrevConnection, (uint32_t)(Level - 1));
+        }
+    }
+
+    Connection->TimerSkipHeight = QuicTimerWheelRandomHeight(TimerWheel);
+    for (uint32_t Level = 0; Level < Connection->TimerSkipHeight; ++Level) {
+        QuicListInsertHead(
+            PrevLinks[Level],
+            QuicTimerWheelConnectionLink(Connection, Level));
+    }
+}
+
+//
+// Unlinks the connection from its slot's skip list, at every level the
+// connection participates in.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicTimerWheelSlotRemove(
+    _Inout_ QUIC_CONNECTION* Connection
+    )
+{
+    for (uint32_t Level = 0; Level < Connection->TimerSkipHeight; ++Level) {
+        QuicListEntryRemove(QuicTimerWheelConnectionLink(Connection, Level));
+    }
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicTimerWheelInitialize(
     _Inout_ QUIC_TIMER_WHEEL* TimerWheel
     )
 {
+    QuicDispatchLockInitialize(&TimerWheel->Lock);
     TimerWheel->NextExpirationTime = UINT64_MAX;
     TimerWheel->ConnectionCount = 0;
     TimerWheel->NextConnection = NULL;
     TimerWheel->SlotCount = QUIC_TIMER_WHEEL_INITIAL_SLOT_COUNT;
     TimerWheel->Slots =
-        QUIC_ALLOC_NONPAGED(QUIC_TIMER_WHEEL_INITIAL_SLOT_COUNT * sizeof(QUIC_LIST_ENTRY));
+        QUIC_ALLOC_NONPAGED(QUIC_TIMER_WHEEL_INITIAL_SLOT_COUNT * sizeof(QUIC_TIMER_WHEEL_SLOT));
     if (TimerWheel->Slots == NULL) {
         QuicTraceEvent(
             AllocFailure,
             "Allocation of '%s' failed. (%llu bytes)", "timerwheel slots",
-            QUIC_TIMER_WHEEL_INITIAL_SLOT_COUNT * sizeof(QUIC_LIST_ENTRY));
+            QUIC_TIMER_WHEEL_INITIAL_SLOT_COUNT * sizeof(QUIC_TIMER_WHEEL_SLOT));
+        QuicDispatchLockUninitialize(&TimerWheel->Lock);
         return QUIC_STATUS_OUT_OF_MEMORY;
     }
 
     for (uint32_t i = 0; i < TimerWheel->SlotCount; ++i) {
-        QuicListInitializeHead(&TimerWheel->Slots[i]);
+        for (uint32_t j = 0; j < QUIC_TIMER_WHEEL_SKIP_LEVELS; ++j) {
+            QuicListInitializeHead(&TimerWheel->Slots[i].Levels[j]);
+        }
+    }
+
+    QuicRandom(sizeof(TimerWheel->RandomState), &TimerWheel->RandomState);
+    if (TimerWheel->RandomState == 0) {
+        TimerWheel->RandomState = 1; // xorshift state must be nonzero.
     }
 
     return QUIC_STATUS_SUCCESS;
@@ -97,7 +242,7 @@ QuicTimerWheelUninitialize(
     )
 {
     for (uint32_t i = 0; i < TimerWheel->SlotCount; ++i) {
-        QUIC_LIST_ENTRY* ListHead = &TimerWheel->Slots[i];
+        QUIC_LIST_ENTRY* ListHead = &TimerWheel->Slots[i].Levels[0];
         QUIC_LIST_ENTRY* Entry = ListHead->Flink;
         while (Entry != ListHead) {
             QUIC_CONNECTION* Connection =
@@ -108,13 +253,14 @@ QuicTimerWheelUninitialize(
                 "Still in timer wheel! Connection was likely leaked!");
             Entry = Entry->Blink;
         }
-        QUIC_TEL_ASSERT(QuicListIsEmpty(&TimerWheel->Slots[i]));
+        QUIC_TEL_ASSERT(QuicListIsEmpty(&TimerWheel->Slots[i].Levels[0]));
     }
     QUIC_TEL_ASSERT(TimerWheel->ConnectionCount == 0);
     QUIC_TEL_ASSERT(TimerWheel->NextConnection == NULL);
     QUIC_TEL_ASSERT(TimerWheel->NextExpirationTime == UINT64_MAX);
 
     QUIC_FREE(TimerWheel->Slots);
+    QuicDispatchLockUninitialize(&TimerWheel->Lock);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -131,13 +277,13 @@ QuicTimerWheelResize(
         return;
     }
 
-    QUIC_LIST_ENTRY* NewSlots =
-        QUIC_ALLOC_NONPAGED(NewSlotCount * sizeof(QUIC_LIST_ENTRY));
+    QUIC_TIMER_WHEEL_SLOT* NewSlots =
+        QUIC_ALLOC_NONPAGED(NewSlotCount * sizeof(QUIC_TIMER_WHEEL_SLOT));
     if (NewSlots == NULL) {
         QuicTraceEvent(
             AllocFailure,
             "Allocation of '%s' failed. (%llu bytes)", "timerwheel slots (realloc)",
-            NewSlotCount * sizeof(QUIC_LIST_ENTRY));
+            NewSlotCount * sizeof(QUIC_TIMER_WHEEL_SLOT));
         return;
     }
 
@@ -148,11 +294,13 @@ QuicTimerWheelResize(
         NewSlotCount);
 
     for (uint32_t i = 0; i < NewSlotCount; ++i) {
-        QuicListInitializeHead(&NewSlots[i]);
+        for (uint32_t j = 0; j < QUIC_TIMER_WHEEL_SKIP_LEVELS; ++j) {
+            QuicListInitializeHead(&NewSlots[i].Levels[j]);
+        }
     }
 
     uint32_t OldSlotCount = TimerWheel->SlotCount;
-    QUIC_LIST_ENTRY* OldSlots = TimerWheel->Slots;
+    QUIC_TIMER_WHEEL_SLOT* OldSlots = TimerWheel->Slots;
 
     TimerWheel->SlotCount = NewSlotCount;
     TimerWheel->Slots = NewSlots;
@@ -162,39 +310,20 @@ QuicTimerWheelResize(
         // Iterate through each old slot, remove all connections and add them
         // to the new slots.
         //
-        while (!QuicListIsEmpty(&OldSlots[i])) {
+        while (!QuicListIsEmpty(&OldSlots[i].Levels[0])) {
             QUIC_CONNECTION* Connection =
                 QUIC_CONTAINING_RECORD(
-                    QuicListRemoveHead(&OldSlots[i]),
+                    OldSlots[i].Levels[0].Flink,
                     QUIC_CONNECTION,
                     TimerLink);
+            QuicTimerWheelSlotRemove(Connection);
             uint64_t ExpirationTime = QuicConnGetNextExpirationTime(Connection);
             uint32_t SlotIndex = TIME_TO_SLOT_INDEX(TimerWheel, ExpirationTime);
-
-            //
-            // Insert the connection into the slot, in the correct order. We search
-            // the slot's list in reverse order, with the assumption that most new
-            // timers will on average be later than existing ones.
-            //
-            QUIC_LIST_ENTRY* ListHead = &TimerWheel->Slots[SlotIndex];
-            QUIC_LIST_ENTRY* Entry = ListHead->Blink;
-
-            while (Entry != ListHead) {
-                QUIC_CONNECTION* ConnectionEntry =
-                    QUIC_CONTAINING_RECORD(Entry, QUIC_CONNECTION, TimerLink);
-                uint64_t EntryExpirationTime = QuicConnGetNextExpirationTime(ConnectionEntry);
-
-                if (ExpirationTime > EntryExpirationTime) {
-                    break;
-                }
-
-                Entry = Entry->Blink;
-            }
-
-            //
-            // Insert after the current entry.
-            //
-            QuicListInsertHead(Entry, &Connection->TimerLink);
+            QuicTimerWheelSlotInsert(
+                TimerWheel,
+                &TimerWheel->Slots[SlotIndex],
+                Connection,
+                ExpirationTime);
         }
     }
 }
@@ -217,10 +346,10 @@ QuicTimerWheelUpdate(
     // expiration time.
     //
     for (uint32_t i = 0; i < TimerWheel->SlotCount; ++i) {
-        if (!QuicListIsEmpty(&TimerWheel->Slots[i])) {
+        if (!QuicListIsEmpty(&TimerWheel->Slots[i].Levels[0])) {
             QUIC_CONNECTION* ConnectionEntry =
                 QUIC_CONTAINING_RECORD(
-                    TimerWheel->Slots[i].Flink,
+                    TimerWheel->Slots[i].Levels[0].Flink,
                     QUIC_CONNECTION,
                     TimerLink);
             uint64_t EntryExpirationTime = QuicConnGetNextExpirationTime(ConnectionEntry);
@@ -253,17 +382,19 @@ QuicTimerWheelRemoveConnection(
     _Inout_ QUIC_CONNECTION* Connection
     )
 {
+    QuicDispatchLockAcquire(&TimerWheel->Lock);
+
     if (Connection->TimerLink.Flink != NULL) {
         //
-        // If the connection was in the timer wheel, remove its entry in the
-        // doubly-link list.
+        // If the connection was in the timer wheel, remove its entries from
+        // the slot's skip list.
         //
         QuicTraceLogVerbose(
             TimerWheelRemoveConnection,
             "[time][%p] Removing Connection %p.",
             TimerWheel,
             Connection);
-        QuicListEntryRemove(&Connection->TimerLink);
+        QuicTimerWheelSlotRemove(Connection);
         Connection->TimerLink.Flink = NULL;
         TimerWheel->ConnectionCount--;
 
@@ -271,6 +402,8 @@ QuicTimerWheelRemoveConnection(
             QuicTimerWheelUpdate(TimerWheel);
         }
     }
+
+    QuicDispatchLockRelease(&TimerWheel->Lock);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -282,11 +415,13 @@ QuicTimerWheelUpdateConnection(
 {
     uint64_t ExpirationTime = QuicConnGetNextExpirationTime(Connection);
 
+    QuicDispatchLockAcquire(&TimerWheel->Lock);
+
     if (Connection->TimerLink.Flink != NULL) {
         //
         // Connection is already in the timer wheel, so remove it first.
         //
-        QuicListEntryRemove(&Connection->TimerLink);
+        QuicTimerWheelSlotRemove(Connection);
 
         if (ExpirationTime == UINT64_MAX) {
             TimerWheel->ConnectionCount--;
@@ -323,29 +458,14 @@ QuicTimerWheelUpdateConnection(
         uint32_t SlotIndex = TIME_TO_SLOT_INDEX(TimerWheel, ExpirationTime);
 
         //
-        // Insert the connection into the slot, in the correct order. We search
-        // the slot's list in reverse order, with the assumption that most new
-        // timers will on average be later than existing ones.
+        // Insert the connection into the slot's skip list, in the correct
+        // order.
         //
-        QUIC_LIST_ENTRY* ListHead = &TimerWheel->Slots[SlotIndex];
-        QUIC_LIST_ENTRY* Entry = ListHead->Blink;
-
-        while (Entry != ListHead) {
-            QUIC_CONNECTION* ConnectionEntry =
-                QUIC_CONTAINING_RECORD(Entry, QUIC_CONNECTION, TimerLink);
-            uint64_t EntryExpirationTime = QuicConnGetNextExpirationTime(ConnectionEntry);
-
-            if (ExpirationTime > EntryExpirationTime) {
-                break;
-            }
-
-            Entry = Entry->Blink;
-        }
-
-        //
-        // Insert after the current entry.
-        //
-        QuicListInsertHead(Entry, &Connection->TimerLink);
+        QuicTimerWheelSlotInsert(
+            TimerWheel,
+            &TimerWheel->Slots[SlotIndex],
+            Connection,
+            ExpirationTime);
 
         QuicTraceLogVerbose(
             TimerWheelUpdateConnection,
@@ -378,6 +498,8 @@ QuicTimerWheelUpdateConnection(
             QuicTimerWheelResize(TimerWheel);
         }
     }
+
+    QuicDispatchLockRelease(&TimerWheel->Lock);
 }
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -387,6 +509,7 @@ QuicTimerWheelGetWaitTime(
     )
 {
     uint64_t Delay;
+    QuicDispatchLockAcquire(&TimerWheel->Lock);
     if (TimerWheel->NextExpirationTime != UINT64_MAX) {
         uint64_t TimeNow = QuicTimeUs64();
         if (TimerWheel->NextExpirationTime <= TimeNow) {
@@ -409,6 +532,7 @@ QuicTimerWheelGetWaitTime(
         //
         Delay = UINT64_MAX;
     }
+    QuicDispatchLockRelease(&TimerWheel->Lock);
     return Delay;
 }
 
@@ -424,8 +548,9 @@ QuicTimerWheelGetExpired(
     // Iterate through every slot to find all the connections that now have
     // expired timers.
     //
+    QuicDispatchLockAcquire(&TimerWheel->Lock);
     for (uint32_t i = 0; i < TimerWheel->SlotCount; ++i) {
-        QUIC_LIST_ENTRY* ListHead = &TimerWheel->Slots[i];
+        QUIC_LIST_ENTRY* ListHead = &TimerWheel->Slots[i].Levels[0];
         QUIC_LIST_ENTRY* Entry = ListHead->Flink;
         while (Entry != ListHead) {
             QUIC_CONNECTION* ConnectionEntry =
@@ -435,9 +560,10 @@ QuicTimerWheelGetExpired(
                 break;
             }
             Entry = Entry->Flink;
-            QuicListEntryRemove(&ConnectionEntry->TimerLink);
+            QuicTimerWheelSlotRemove(ConnectionEntry);
             QuicListInsertTail(OutputListHead, &ConnectionEntry->TimerLink);
             TimerWheel->ConnectionCount--;
         }
     }
+    QuicDispatchLockRelease(&TimerWheel->Lock);
 }
@@ -7,8 +7,35 @@
 
 typedef struct QUIC_CONNECTION QUIC_CONNECTION;
 
+//
+// The number of levels in each slot's skip list. With a promotion probability
+// of 1/4, eight levels keep in-slot searches logarithmic well past a million
+// connections per slot.
+//
+#define QUIC_TIMER_WHEEL_SKIP_LEVELS    8
+
+typedef struct QUIC_TIMER_WHEEL_SLOT {
+
+    //
+    // Level 0 links every connection in the slot, sorted by expiration time.
+    // Each higher level links a progressively sparser (sorted) subset of the
+    // connections, forming a skip list that keeps in-slot searches
+    // logarithmic even when many connections hash to the same slot.
+    //
+    QUIC_LIST_ENTRY Levels[QUIC_TIMER_WHEEL_SKIP_LEVELS];
+
+} QUIC_TIMER_WHEEL_SLOT;
+
 typedef struct QUIC_TIMER_WHEEL {
 
+    //
+    // Serializes access to the timer wheel. Normally only the owning worker
+    // thread touches the wheel, but a peer worker that has stolen one of this
+    // wheel's connections updates it cross-thread while draining that
+    // connection's operations.
+    //
+    QUIC_DISPATCH_LOCK Lock;
+
     //
     // The expiration time (in us) for the next timer in the timer wheel.
     //
@@ -32,7 +59,12 @@ typedef struct QUIC_TIMER_WHEEL {
     //
     // An array of slots in the timer wheel.
     //
-    QUIC_LIST_ENTRY* Slots;
+    QUIC_TIMER_WHEEL_SLOT* Slots;
+
+    //
+    // State for the PRNG used to pick skip list heights.
+    //
+    uint32_t RandomState;
 
 } QUIC_TIMER_WHEEL;
 
@@ -24,6 +24,8 @@ Abstract:
 #define QUIC_TP_FLAG_MAX_ACK_DELAY                          0x1000
 #define QUIC_TP_FLAG_ORIGINAL_CONNECTION_ID                 0x2000
 #define QUIC_TP_FLAG_ACTIVE_CONNECTION_ID_LIMIT             0x4000
+#define QUIC_TP_FLAG_MIN_ACK_DELAY                          0x8000
+#define QUIC_TP_FLAG_MAX_DATAGRAM_FRAME_SIZE                0x10000
 
 #define QUIC_TP_MAX_PACKET_SIZE_DEFAULT                     65527
 #define QUIC_TP_MAX_PACKET_SIZE_MIN                         1200
@@ -38,6 +40,8 @@ Abstract:
 #define QUIC_TP_ACTIVE_CONNECTION_ID_LIMIT_DEFAULT          2
 #define QUIC_TP_ACTIVE_CONNECTION_ID_LIMIT_MIN              2
 
+#define QUIC_TP_MIN_ACK_DELAY_MAX                           ((1 << 24) - 1) // us
+
 //
 // Max allowed value of a MAX_STREAMS frame or transport parameter.
 // Any larger value would allow a max stream ID that cannot be expressed
@@ -117,6 +121,21 @@ typedef struct QUIC_TRANSPORT_PARAMETERS {
     _Field_range_(QUIC_TP_ACTIVE_CONNECTION_ID_LIMIT_MIN, QUIC_VAR_INT_MAX)
     QUIC_VAR_INT ActiveConnectionIdLimit;
 
+    //
+    // Indicates the minimum amount of time in microseconds by which the
+    // endpoint can delay an acknowledgment. Presence of this parameter also
+    // indicates support for the ACK_FREQUENCY extension frame.
+    //
+    _Field_range_(0, QUIC_TP_MIN_ACK_DELAY_MAX)
+    QUIC_VAR_INT MinAckDelay;
+
+    //
+    // The maximum size of a DATAGRAM frame (including the frame type and
+    // length fields) the endpoint is willing to receive. Presence of this
+    // parameter indicates support for the unreliable datagram extension.
+    //
+    QUIC_VAR_INT MaxDatagramFrameSize;
+
     //
     // Server specific.
     //
@@ -1226,3 +1226,67 @@ TEST_P(ConnectionCloseFrameDecodeTest, DecodeConnectionCloseFrameFail) {
 }
 
 INSTANTIATE_TEST_SUITE_P(FrameTest, ConnectionCloseFrameDecodeTest, ::testing::ValuesIn(ConnectionCloseFrameParams::GenerateDecodeFailParams()));
+
+TEST(FrameTest, AckFrequencyFrameEncodeDecode)
+{
+    QUIC_ACK_FREQUENCY_EX Frame = {5, 10, 25000};
+    QUIC_ACK_FREQUENCY_EX DecodedFrame = {0, 0, 0};
+    uint8_t Buffer[12];
+    uint16_t BufferLength = (uint16_t)sizeof(Buffer);
+    uint16_t Offset = 0;
+
+    QuicZeroMemory(Buffer, sizeof(Buffer));
+    ASSERT_TRUE(QuicAckFrequencyFrameEncode(&Frame, &Offset, BufferLength, Buffer));
+    //
+    // The frame type (0xaf) is greater than 63, so it encodes as a two-byte
+    // var-int.
+    //
+    ASSERT_EQ(Buffer[0], 0x40);
+    ASSERT_EQ(Buffer[1], 0xaf);
+    Offset = 2;
+    ASSERT_TRUE(QuicAckFrequencyFrameDecode(BufferLength, Buffer, &Offset, &DecodedFrame));
+
+    ASSERT_EQ(Frame.SequenceNumber, DecodedFrame.SequenceNumber);
+    ASSERT_EQ(Frame.PacketTolerance, DecodedFrame.PacketTolerance);
+    ASSERT_EQ(Frame.UpdateMaxAckDelay, DecodedFrame.UpdateMaxAckDelay);
+}
+
+struct AckFrequencyFrameParams {
+    uint8_t Buffer[4];
+    uint16_t BufferLength = 4;
+
+    static auto GenerateDecodeFailParams() {
+        std::vector<AckFrequencyFrameParams> Params;
+        for (uint32_t i = 0; i < 3; ++i) {
+            AckFrequencyFrameParams Temp;
+            Temp.Buffer[0] = 0x40;
+            Temp.Buffer[1] = 0xaf; // QUIC_FRAME_ACK_FREQUENCY
+            switch (i) {
+            case 0: // Sequence number var-int truncated.
+                Temp.Buffer[2] = 0xC0;
+                Temp.Buffer[3] = 0;
+                break;
+            case 1: // Packet tolerance var-int truncated.
+                Temp.Buffer[2] = 1;
+                Temp.Buffer[3] = 0x40;
+                break;
+            case 2: // Update max ACK delay missing entirely.
+                Temp.Buffer[2] = 1;
+                Temp.Buffer[3] = 1;
+                break;
+            }
+            Params.push_back(Temp);
+        }
+        return Params;
+    }
+};
+
+struct AckFrequencyFrameTest : ::testing::TestWithParam<AckFrequencyFrameParams> {};
+
+TEST_P(AckFrequencyFrameTest, DecodeAckFrequencyFrameFail) {
+    QUIC_ACK_FREQUENCY_EX DecodedFrame;
+    uint16_t Offset = 2;
+    ASSERT_FALSE(QuicAckFrequencyFrameDecode(GetParam().BufferLength, GetParam().Buffer, &Offset, &DecodedFrame));
+}
+
+INSTANTIATE_TEST_SUITE_P(FrameTest, AckFrequencyFrameTest, ::testing::ValuesIn(AckFrequencyFrameParams::GenerateDecodeFailParams()));
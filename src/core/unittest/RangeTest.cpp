@@ -29,6 +29,12 @@ struct SmartRange {
         BOOLEAN rangeUpdated;
         return QuicRangeAddRange(&range, low, count, &rangeUpdated) != FALSE;
     }
+    bool TryAddRanges(const QUIC_SUBRANGE* subs, uint32_t count) {
+        return QuicRangeAddRanges(&range, subs, count) != FALSE;
+    }
+    bool IsInline() {
+        return range.SubRanges == range.PreAllocSubRanges;
+    }
     void Add(uint64_t value) {
         ASSERT_TRUE(TryAdd(value));
     #ifndef LOG_ONLY_FAILURES
@@ -451,6 +457,58 @@ TEST(RangeTest, AddLots)
     ASSERT_EQ(range.ValidCount(), (uint32_t)1);
 }
 
+TEST(RangeTest, InlineArray)
+{
+    SmartRange range;
+    ASSERT_TRUE(range.IsInline());
+    for (uint32_t i = 0; i < 100; i += 2) {
+        range.Add(i);
+    }
+    ASSERT_FALSE(range.IsInline());
+    for (uint32_t i = 0; i < 98; i += 2) {
+        range.Remove(i, 1);
+    }
+    ASSERT_EQ(range.ValidCount(), (uint32_t)1);
+    ASSERT_TRUE(range.IsInline());
+    ASSERT_EQ(range.Max(), 98ull);
+}
+
+TEST(RangeTest, AddRangesSeparate)
+{
+    SmartRange range;
+    range.Add(0, 5);
+    const QUIC_SUBRANGE Subs[] = { {10, 5}, {20, 5}, {30, 5} };
+    ASSERT_TRUE(range.TryAddRanges(Subs, ARRAYSIZE(Subs)));
+    ASSERT_EQ(range.ValidCount(), (uint32_t)4);
+    ASSERT_EQ(range.Min(), 0ull);
+    ASSERT_EQ(range.Max(), 34ull);
+}
+
+TEST(RangeTest, AddRangesMerge)
+{
+    SmartRange range;
+    range.Add(5, 10);
+    const QUIC_SUBRANGE Subs[] = { {0, 5}, {15, 5}, {30, 5} };
+    ASSERT_TRUE(range.TryAddRanges(Subs, ARRAYSIZE(Subs)));
+    ASSERT_EQ(range.ValidCount(), (uint32_t)2);
+    ASSERT_EQ(range.Min(), 0ull);
+    ASSERT_EQ(range.Max(), 34ull);
+}
+
+TEST(RangeTest, AddRangesLots)
+{
+    SmartRange range;
+    QUIC_SUBRANGE Subs[100];
+    for (uint32_t i = 0; i < ARRAYSIZE(Subs); i++) {
+        Subs[i].Low = i * 2;
+        Subs[i].Count = 1;
+    }
+    ASSERT_TRUE(range.TryAddRanges(Subs, ARRAYSIZE(Subs)));
+    ASSERT_EQ(range.ValidCount(), (uint32_t)100);
+    ASSERT_EQ(range.Min(), 0ull);
+    ASSERT_EQ(range.Max(), 198ull);
+}
+
 TEST(RangeTest, HitMax)
 {
     const uint32_t MaxCount = 16;
@@ -0,0 +1,258 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    Scaling benchmark for the per-connection data structures: ramps the
+    number of (synthetic) connections and reports per-connection memory,
+    timer wheel maintenance cost and local CID lookup latency
+    distributions. The connections are zeroed shells rather than real
+    handshaked connections, which keeps the benchmark self-contained and
+    lets it isolate the lookup table and timer wheel costs from the rest
+    of the stack.
+
+--*/
+
+#include "main.h"
+
+#include <algorithm>
+#include <vector>
+
+extern "C" void MsQuicCalculatePartitionMask(void);
+
+//
+// The connection counts each benchmark ramps through. The last step is
+// sized to stay CI-friendly; raise it to measure larger deployments.
+//
+const uint32_t ScaleBenchRampSteps[] = { 1024, 8192, 32768 };
+
+//
+// Operations are timed in batches because the clock is only microsecond
+// granular; each batch produces one per-operation latency sample.
+//
+const uint32_t ScaleBenchBatchSize = 256;
+const uint32_t ScaleBenchBatchCount = 64;
+
+struct ScaleBenchSamples {
+    std::vector<uint64_t> NsPerOp;
+    void Add(uint64_t BatchElapsedUs) {
+        NsPerOp.push_back(BatchElapsedUs * 1000 / ScaleBenchBatchSize);
+    }
+    uint64_t Percentile(double P) {
+        std::sort(NsPerOp.begin(), NsPerOp.end());
+        size_t Index = (size_t)((P / 100) * NsPerOp.size());
+        if (Index >= NsPerOp.size()) {
+            Index = NsPerOp.size() - 1;
+        }
+        return NsPerOp[Index];
+    }
+};
+
+struct ScaleBench : public ::testing::Test {
+
+    uint8_t PrevPartitionCount;
+    uint8_t PrevPartitionMask;
+    uint8_t PrevCidServerIdLength;
+    uint64_t RandomState;
+
+    void SetUp() override {
+        //
+        // The library itself isn't loaded for the core unit tests, so the
+        // partitioning globals the lookup table depends on are set up
+        // manually here and restored on tear down.
+        //
+        PrevPartitionCount = MsQuicLib.PartitionCount;
+        PrevPartitionMask = MsQuicLib.PartitionMask;
+        PrevCidServerIdLength = MsQuicLib.CidServerIdLength;
+        uint32_t ProcCount = QuicProcMaxCount();
+        MsQuicLib.PartitionCount =
+            ProcCount < UINT8_MAX ? (uint8_t)ProcCount : UINT8_MAX;
+        if (MsQuicLib.PartitionCount == 0) {
+            MsQuicLib.PartitionCount = 1;
+        }
+        MsQuicLib.CidServerIdLength = 0;
+        MsQuicCalculatePartitionMask();
+        RandomState = 0x853c49e6748fea9bULL;
+    }
+
+    void TearDown() override {
+        MsQuicLib.PartitionCount = PrevPartitionCount;
+        MsQuicLib.PartitionMask = PrevPartitionMask;
+        MsQuicLib.CidServerIdLength = PrevCidServerIdLength;
+    }
+
+    uint64_t Random() {
+        RandomState = RandomState * 6364136223846793005ULL + 1442695040888963407ULL;
+        return RandomState >> 33;
+    }
+
+    //
+    // Allocates a zeroed connection shell with a single base reference.
+    // The base reference is never released, so lookup result and lookup
+    // table references can come and go without the refcount hitting zero
+    // (which would try to run the real cleanup path).
+    //
+    QUIC_CONNECTION* ConnectionAlloc() {
+        QUIC_CONNECTION* Connection =
+            (QUIC_CONNECTION*)QUIC_ALLOC_NONPAGED(sizeof(QUIC_CONNECTION));
+        if (Connection != NULL) {
+            QuicZeroMemory(Connection, sizeof(QUIC_CONNECTION));
+            Connection->RefCount = 1;
+#if DEBUG
+            Connection->RefTypeCount[QUIC_CONN_REF_HANDLE_OWNER] = 1;
+#endif
+            for (uint32_t i = 0; i < QUIC_CONN_TIMER_COUNT; i++) {
+                Connection->Timers[i].ExpirationTime = UINT64_MAX;
+            }
+        }
+        return Connection;
+    }
+
+    void ConnectionFree(QUIC_CONNECTION* Connection) {
+        ASSERT_EQ(Connection->RefCount, 1);
+        QUIC_FREE(Connection);
+    }
+};
+
+TEST_F(ScaleBench, LocalCidLookup)
+{
+    const uint32_t MaxCount = ScaleBenchRampSteps[ARRAYSIZE(ScaleBenchRampSteps) - 1];
+
+    QUIC_LOOKUP Lookup;
+    QuicLookupInitialize(&Lookup);
+    ASSERT_TRUE(QuicLookupMaximizePartitioning(&Lookup));
+
+    std::vector<QUIC_CONNECTION*> Connections(MaxCount);
+    std::vector<QUIC_CID_HASH_ENTRY*> Cids(MaxCount);
+
+    printf(
+        "lookup: %u partitions, %u B/connection, %u B/CID entry\n",
+        MsQuicLib.PartitionCount,
+        (uint32_t)sizeof(QUIC_CONNECTION),
+        (uint32_t)(sizeof(QUIC_CID_HASH_ENTRY) + MSQUIC_CID_MIN_LENGTH));
+
+    uint32_t Inserted = 0;
+    for (uint32_t Step = 0; Step < ARRAYSIZE(ScaleBenchRampSteps); Step++) {
+
+        while (Inserted < ScaleBenchRampSteps[Step]) {
+            Connections[Inserted] = ConnectionAlloc();
+            ASSERT_NE(Connections[Inserted], nullptr);
+            //
+            // The first byte is the partition ID byte (the server ID length
+            // is zero); the rest makes the CID unique.
+            //
+            uint8_t Data[MSQUIC_CID_MIN_LENGTH] = {0};
+            for (uint32_t i = 0; i < sizeof(uint32_t); i++) {
+                Data[i] = (uint8_t)(Inserted >> (i * 8));
+            }
+            Cids[Inserted] =
+                QuicCidNewSource(
+                    Connections[Inserted], MSQUIC_CID_MIN_LENGTH, Data);
+            ASSERT_NE(Cids[Inserted], nullptr);
+            ASSERT_TRUE(QuicLookupAddLocalCid(&Lookup, Cids[Inserted], NULL));
+            Inserted++;
+        }
+
+        ScaleBenchSamples Samples;
+        for (uint32_t Batch = 0; Batch < ScaleBenchBatchCount; Batch++) {
+            uint64_t Start = QuicTimeUs64();
+            for (uint32_t i = 0; i < ScaleBenchBatchSize; i++) {
+                QUIC_CID_HASH_ENTRY* Cid = Cids[Random() % Inserted];
+                QUIC_CONNECTION* Connection =
+                    QuicLookupFindConnectionByLocalCid(
+                        &Lookup, Cid->CID.Data, Cid->CID.Length);
+                ASSERT_EQ(Connection, Cid->Connection);
+                QuicConnRelease(Connection, QUIC_CONN_REF_LOOKUP_RESULT);
+            }
+            Samples.Add(QuicTimeDiff64(Start, QuicTimeUs64()));
+        }
+
+        printf(
+            "lookup: %7u conns find ns/op p50=%llu p90=%llu p99=%llu max=%llu\n",
+            Inserted,
+            (unsigned long long)Samples.Percentile(50),
+            (unsigned long long)Samples.Percentile(90),
+            (unsigned long long)Samples.Percentile(99),
+            (unsigned long long)Samples.Percentile(100));
+    }
+
+    for (uint32_t i = 0; i < Inserted; i++) {
+        QuicLookupRemoveLocalCid(&Lookup, Cids[i]);
+        QUIC_FREE(Cids[i]);
+        ConnectionFree(Connections[i]);
+    }
+    QuicLookupUninitialize(&Lookup);
+}
+
+TEST_F(ScaleBench, TimerWheelMaintenance)
+{
+    const uint32_t MaxCount = ScaleBenchRampSteps[ARRAYSIZE(ScaleBenchRampSteps) - 1];
+
+    QUIC_TIMER_WHEEL TimerWheel;
+    TEST_QUIC_SUCCEEDED(QuicTimerWheelInitialize(&TimerWheel));
+
+    std::vector<QUIC_CONNECTION*> Connections(MaxCount);
+    const uint64_t Now = QuicTimeUs64();
+
+    uint32_t Inserted = 0;
+    for (uint32_t Step = 0; Step < ARRAYSIZE(ScaleBenchRampSteps); Step++) {
+
+        while (Inserted < ScaleBenchRampSteps[Step]) {
+            Connections[Inserted] = ConnectionAlloc();
+            ASSERT_NE(Connections[Inserted], nullptr);
+            //
+            // Roughly 90% of the connections are idle, with only a far-out
+            // timer (30 to 60 seconds), while the rest are active with a
+            // timer in the next second. This mirrors a server mostly full
+            // of parked connections.
+            //
+            if (Inserted % 10 != 0) {
+                Connections[Inserted]->Timers[0].ExpirationTime =
+                    Now + MS_TO_US(30000 + Random() % 30000);
+            } else {
+                Connections[Inserted]->Timers[0].ExpirationTime =
+                    Now + Random() % MS_TO_US(1000);
+            }
+            QuicTimerWheelUpdateConnection(&TimerWheel, Connections[Inserted]);
+            Inserted++;
+        }
+
+        //
+        // The maintenance workload is the hot path a worker thread runs:
+        // re-arm an active connection's next timer and recompute the wait
+        // time for the next wheel expiration.
+        //
+        ScaleBenchSamples Samples;
+        for (uint32_t Batch = 0; Batch < ScaleBenchBatchCount; Batch++) {
+            uint64_t Start = QuicTimeUs64();
+            for (uint32_t i = 0; i < ScaleBenchBatchSize; i++) {
+                QUIC_CONNECTION* Connection =
+                    Connections[(Random() % (Inserted / 10)) * 10];
+                Connection->Timers[0].ExpirationTime =
+                    Now + Random() % MS_TO_US(1000);
+                QuicTimerWheelUpdateConnection(&TimerWheel, Connection);
+                QuicTimerWheelGetWaitTime(&TimerWheel);
+            }
+            Samples.Add(QuicTimeDiff64(Start, QuicTimeUs64()));
+        }
+
+        printf(
+            "wheel:  %7u conns update ns/op p50=%llu p90=%llu p99=%llu max=%llu"
+            " (%u slots, %u slot B/conn)\n",
+            Inserted,
+            (unsigned long long)Samples.Percentile(50),
+            (unsigned long long)Samples.Percentile(90),
+            (unsigned long long)Samples.Percentile(99),
+            (unsigned long long)Samples.Percentile(100),
+            TimerWheel.SlotCount,
+            (uint32_t)(TimerWheel.SlotCount * sizeof(QUIC_TIMER_WHEEL_SLOT) / Inserted));
+    }
+
+    for (uint32_t i = 0; i < Inserted; i++) {
+        QuicTimerWheelRemoveConnection(&TimerWheel, Connections[i]);
+        ConnectionFree(Connections[i]);
+    }
+    QuicTimerWheelUninitialize(&TimerWheel);
+}
@@ -69,3 +69,56 @@ TEST(VarIntTest, RandomEncodeDecode)
         ASSERT_EQ(Value, Decoded);
     }
 }
+
+void ValidateDecodeFast(uint64_t Value)
+{
+    uint8_t Buffer[sizeof(uint64_t) * 2];
+    QuicZeroMemory(Buffer, sizeof(Buffer));
+    ASSERT_NE(QuicVarIntEncode(Value, Buffer), nullptr);
+
+    //
+    // With at least 8 readable bytes the fast decoder takes the single-load
+    // path; it must agree with the byte-wise decoder on value and offset.
+    //
+    uint64_t Decoded = 0;
+    uint64_t DecodedFast = 0;
+    uint16_t Offset = 0;
+    uint16_t OffsetFast = 0;
+    ASSERT_TRUE(QuicVarIntDecode((uint16_t)sizeof(Buffer), Buffer, &Offset, &Decoded));
+    ASSERT_TRUE(QuicVarIntDecodeFast((uint16_t)sizeof(Buffer), Buffer, &OffsetFast, &DecodedFast));
+    ASSERT_EQ(Value, Decoded);
+    ASSERT_EQ(Decoded, DecodedFast);
+    ASSERT_EQ(Offset, OffsetFast);
+
+    //
+    // An exactly sized buffer forces the fallback to the byte-wise decoder.
+    //
+    DecodedFast = 0;
+    OffsetFast = 0;
+    ASSERT_TRUE(QuicVarIntDecodeFast((uint16_t)QuicVarIntSize(Value), Buffer, &OffsetFast, &DecodedFast));
+    ASSERT_EQ(Value, DecodedFast);
+    ASSERT_EQ(Offset, OffsetFast);
+}
+
+TEST(VarIntTest, DecodeFastBoundaries)
+{
+    const uint64_t Boundaries[] = {
+        0, 1, 0x3F,                         // 1 byte
+        0x40, 0x3FFF,                       // 2 bytes
+        0x4000, 0x3FFFFFFF,                 // 4 bytes
+        0x40000000, 0x3FFFFFFFFFFFFFFFULL   // 8 bytes
+    };
+    for (uint64_t Value : Boundaries) {
+        ValidateDecodeFast(Value);
+    }
+}
+
+TEST(VarIntTest, RandomDecodeFast)
+{
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint64_t Value;
+        TEST_QUIC_SUCCEEDED(QuicRandom(sizeof(Value), &Value));
+        Value &= ~(3ULL << 62);
+        ValidateDecodeFast(Value);
+    }
+}
@@ -17,6 +17,12 @@ Abstract:
     Each connection is assigned to a single worker, and is queued whenever it
     has operations to be processed.
 
+    A worker that runs out of work of its own steals queued connections from
+    overloaded siblings in its pool and drains their operations on their
+    owner's behalf. Ownership of the connection does not move; the connection
+    is simply claimed (via the WorkerProcessing flag) by the stealing thread
+    for the duration of the drain, the same way the owner claims it.
+
 --*/
 
 #include "precomp.h"
@@ -31,7 +37,9 @@ QUIC_STATUS
 QuicWorkerInitialize(
     _In_opt_ const void* Owner,
     _In_ uint16_t ThreadFlags,
+    _In_ uint32_t IdleSpinUs,
     _In_ uint8_t IdealProcessor,
+    _In_ BOOLEAN ExplicitProcessor,
     _Inout_ QUIC_WORKER* Worker
     )
 {
@@ -46,6 +54,8 @@ QuicWorkerInitialize(
 
     Worker->Enabled = TRUE;
     Worker->IdealProcessor = IdealProcessor;
+    Worker->IdleSpinUs = IdleSpinUs;
+    QuicZeroMemory(&Worker->PerfEvents, sizeof(Worker->PerfEvents));
     QuicDispatchLockInitialize(&Worker->Lock);
     QuicEventInitialize(&Worker->Ready, FALSE, FALSE);
     QuicListInitializeHead(&Worker->Connections);
@@ -57,6 +67,19 @@ QuicWorkerInitialize(
     QuicPoolInitialize(FALSE, sizeof(QUIC_STATELESS_CONTEXT), &Worker->StatelessContextPool);
     QuicPoolInitialize(FALSE, sizeof(QUIC_OPERATION), &Worker->OperPool);
 
+    //
+    // The shared packet builder is just an optimization; if the allocation
+    // fails, flushes fall back to stack builders.
+    //
+    Worker->PacketBuilder = QUIC_ALLOC_NONPAGED(sizeof(QUIC_PACKET_BUILDER));
+    if (Worker->PacketBuilder != NULL) {
+        QuicZeroMemory(Worker->PacketBuilder, sizeof(QUIC_PACKET_BUILDER));
+    }
+    Worker->PacketBuilderInUse = FALSE;
+
+    Worker->RecvReleaseChain = NULL;
+    Worker->RecvReleaseChainTail = &Worker->RecvReleaseChain;
+
     Status = QuicTimerWheelInitialize(&Worker->TimerWheel);
     if (QUIC_FAILED(Status)) {
         goto Error;
@@ -70,6 +93,27 @@ QuicWorkerInitialize(
         Worker
     };
 
+    if (ExplicitProcessor) {
+        //
+        // The app picked this processor explicitly, so pin the worker there
+        // regardless of the global processor list or profile thread flags.
+        //
+        ThreadConfig.IdealProcessor = IdealProcessor;
+        ThreadConfig.Flags |=
+            QUIC_THREAD_FLAG_SET_IDEAL_PROC | QUIC_THREAD_FLAG_SET_AFFINITIZE;
+    } else if (MsQuicLib.ProcessorListLength != 0 && ThreadFlags != 0) {
+        //
+        // An explicit processor list replaces the default placement with a
+        // hard affinity, so the scheduler can't migrate the worker onto a
+        // housekeeping core. Workers whose profile asks for no placement at
+        // all (e.g. scavengers) are left floating.
+        //
+        ThreadConfig.IdealProcessor =
+            (uint8_t)QuicLibraryMapProcessor(IdealProcessor);
+        ThreadConfig.Flags |=
+            QUIC_THREAD_FLAG_SET_IDEAL_PROC | QUIC_THREAD_FLAG_SET_AFFINITIZE;
+    }
+
     Status = QuicThreadCreate(&ThreadConfig, &Worker->Thread);
     if (QUIC_FAILED(Status)) {
         QuicTraceEvent(
@@ -88,6 +132,10 @@ QuicWorkerInitialize(
 Error:
 
     if (QUIC_FAILED(Status)) {
+        if (Worker->PacketBuilder != NULL) {
+            QUIC_FREE(Worker->PacketBuilder);
+            Worker->PacketBuilder = NULL;
+        }
         QuicPoolUninitialize(&Worker->StreamPool);
         QuicPoolUninitialize(&Worker->SendRequestPool);
         QuicSentPacketPoolUninitialize(&Worker->SentPacketPool);
@@ -127,6 +175,13 @@ QuicWorkerUninitialize(
     QUIC_TEL_ASSERT(QuicListIsEmpty(&Worker->Connections));
     QUIC_TEL_ASSERT(QuicListIsEmpty(&Worker->Operations));
 
+    QUIC_TEL_ASSERT(!Worker->PacketBuilderInUse);
+    QUIC_TEL_ASSERT(Worker->RecvReleaseChain == NULL);
+    if (Worker->PacketBuilder != NULL) {
+        QUIC_FREE(Worker->PacketBuilder);
+        Worker->PacketBuilder = NULL;
+    }
+
     QuicPoolUninitialize(&Worker->StreamPool);
     QuicPoolUninitialize(&Worker->SendRequestPool);
     QuicSentPacketPoolUninitialize(&Worker->SentPacketPool);
@@ -151,7 +206,11 @@ QuicWorkerAssignConnection(
     )
 {
     QUIC_DBG_ASSERT(Connection->Worker != Worker);
+    if (Connection->Worker != NULL) {
+        InterlockedDecrement(&Connection->Worker->ConnectionCount);
+    }
     Connection->Worker = Worker;
+    InterlockedIncrement(&Worker->ConnectionCount);
     QuicTraceEvent(
         ConnAssignWorker,
         "[conn][%p] Assigned worker: %p",
@@ -189,6 +248,11 @@ QuicWorkerQueueConnection(
             "[conn][%p] Scheduling: %u",
             Connection,
             QUIC_SCHEDULE_QUEUED);
+        QuicPerfEventRingWrite(
+            &Worker->PerfEvents,
+            QUIC_PERF_EVENT_CONN_QUEUED,
+            (uint64_t)(uintptr_t)Connection,
+            0);
         QuicConnAddRef(Connection, QUIC_CONN_REF_WORKER);
         QuicListInsertTail(&Worker->Connections, &Connection->WorkerLink);
     } else {
@@ -197,6 +261,189 @@ QuicWorkerQueueConnection(
 
     Connection->HasQueuedWork = TRUE;
 
+    if (WakeWorkerThread && Connection->ApiBatchDepth != 0) {
+        //
+        // An API batch is open on the connection, so defer the wake to the
+        // batch commit; one signal then covers all the batched operations.
+        //
+        Connection->ApiBatchWakePending = TRUE;
+        WakeWorkerThread = FALSE;
+    }
+
+    QuicDispatchLockRelease(&Worker->Lock);
+
+    if (WakeWorkerThread) {
+        QuicEventSet(Worker->Ready);
+    }
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Ret_notnull_
+QUIC_PACKET_BUILDER*
+QuicWorkerGetPacketBuilder(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_PACKET_BUILDER* StackBuilder
+    )
+{
+    //
+    // The shared builder is single-threaded state: the InUse flag is only
+    // ever touched on the worker thread itself, so no synchronization is
+    // needed. Flushes running on any other thread (inline API sends) and
+    // reentrant flushes just use the caller's stack builder instead.
+    //
+    if (Worker->PacketBuilder != NULL &&
+        !Worker->PacketBuilderInUse &&
+        Worker->ThreadID == QuicCurThreadID()) {
+        Worker->PacketBuilderInUse = TRUE;
+        return Worker->PacketBuilder;
+    }
+    return StackBuilder;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicWorkerReleasePacketBuilder(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_PACKET_BUILDER* Builder
+    )
+{
+    if (Builder == Worker->PacketBuilder) {
+        QUIC_DBG_ASSERT(Worker->PacketBuilderInUse);
+        Worker->PacketBuilderInUse = FALSE;
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerQueueRecvRelease(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_RECV_DATAGRAM* DatagramChain
+    )
+{
+    if (Worker->ThreadID != QuicCurThreadID()) {
+        //
+        // Not a drain on the worker thread (e.g. a receive processed inline
+        // during connection cleanup), so there is no flush point coming;
+        // return the chain directly.
+        //
+        QuicDataPathBindingReturnRecvDatagrams(DatagramChain);
+        return;
+    }
+
+    QUIC_RECV_DATAGRAM** Tail = Worker->RecvReleaseChainTail;
+    *Tail = DatagramChain;
+    while (*Tail != NULL) {
+        Tail = &(*Tail)->Next;
+    }
+    Worker->RecvReleaseChainTail = Tail;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerFlushRecvRelease(
+    _In_ QUIC_WORKER* Worker
+    )
+{
+    if (Worker->RecvReleaseChain != NULL) {
+        QuicDataPathBindingReturnRecvDatagrams(Worker->RecvReleaseChain);
+        Worker->RecvReleaseChain = NULL;
+        Worker->RecvReleaseChainTail = &Worker->RecvReleaseChain;
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerApiBatchBegin(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    QuicDispatchLockAcquire(&Worker->Lock);
+    QUIC_DBG_ASSERT(Connection->ApiBatchDepth != UINT8_MAX);
+    Connection->ApiBatchDepth++;
+    QuicDispatchLockRelease(&Worker->Lock);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicWorkerApiBatchCommit(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    BOOLEAN WakeWorkerThread = FALSE;
+
+    QuicDispatchLockAcquire(&Worker->Lock);
+    if (Connection->ApiBatchDepth == 0) {
+        QuicDispatchLockRelease(&Worker->Lock);
+        return FALSE;
+    }
+    if (--Connection->ApiBatchDepth == 0 && Connection->ApiBatchWakePending) {
+        Connection->ApiBatchWakePending = FALSE;
+        WakeWorkerThread = TRUE;
+    }
+    QuicDispatchLockRelease(&Worker->Lock);
+
+    if (WakeWorkerThread) {
+        QuicEventSet(Worker->Ready);
+    }
+
+    return TRUE;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicWorkerTryClaimConnection(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    QUIC_DBG_ASSERT(Connection->Worker == Worker);
+
+    BOOLEAN Claimed = FALSE;
+    QuicDispatchLockAcquire(&Worker->Lock);
+    if (!Connection->WorkerProcessing &&
+        !Connection->HasQueuedWork &&
+        !Connection->State.UpdateWorker) {
+        Connection->WorkerProcessing = TRUE;
+        Claimed = TRUE;
+    }
+    QuicDispatchLockRelease(&Worker->Lock);
+
+    return Claimed;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerReleaseConnection(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    )
+{
+    BOOLEAN WakeWorkerThread = FALSE;
+
+    QuicDispatchLockAcquire(&Worker->Lock);
+
+    QUIC_DBG_ASSERT(Connection->WorkerProcessing);
+    Connection->WorkerProcessing = FALSE;
+
+    if (Connection->HasQueuedWork) {
+        //
+        // Operations were queued while the connection was claimed, so the
+        // connection takes a new queue reference (just like
+        // QuicWorkerQueueConnection).
+        //
+        WakeWorkerThread = QuicWorkerIsIdle(Worker);
+        Connection->Stats.Schedule.LastQueueTime = QuicTimeUs32();
+        QuicTraceEvent(
+            ConnScheduleState,
+            "[conn][%p] Scheduling: %u",
+            Connection,
+            QUIC_SCHEDULE_QUEUED);
+        QuicConnAddRef(Connection, QUIC_CONN_REF_WORKER);
+        QuicListInsertTail(&Worker->Connections, &Connection->WorkerLink);
+    }
+
     QuicDispatchLockRelease(&Worker->Lock);
 
     if (WakeWorkerThread) {
@@ -224,6 +471,11 @@ QuicWorkerMoveConnection(
             "[conn][%p] Scheduling: %u",
             Connection,
             QUIC_SCHEDULE_QUEUED);
+        QuicPerfEventRingWrite(
+            &Worker->PerfEvents,
+            QUIC_PERF_EVENT_CONN_QUEUED,
+            (uint64_t)(uintptr_t)Connection,
+            0);
         QuicConnAddRef(Connection, QUIC_CONN_REF_WORKER);
         QuicListInsertTail(&Worker->Connections, &Connection->WorkerLink);
     }
@@ -249,6 +501,11 @@ QuicWorkerQueueOperation(
         QuicLibraryTryAddRefBinding(Operation->STATELESS.Context->Binding)) {
         Operation->STATELESS.Context->HasBindingRef = TRUE;
         WakeWorkerThread = QuicWorkerIsIdle(Worker);
+        QuicPerfEventRingWrite(
+            &Worker->PerfEvents,
+            QUIC_PERF_EVENT_OPER_QUEUED,
+            0,
+            Operation->Type);
         QuicListInsertTail(&Worker->Operations, &Operation->Link);
         Worker->OperationCount++;
         Operation = NULL;
@@ -256,6 +513,7 @@ QuicWorkerQueueOperation(
     } else {
         WakeWorkerThread = FALSE;
         Worker->DroppedOperationCount++;
+        QuicPerfCounterIncrement(QUIC_PERF_COUNTER_OPER_DROPPED);
     }
 
     QuicDispatchLockRelease(&Worker->Lock);
@@ -282,6 +540,15 @@ QuicWorkerToggleActivityState(
     _In_ uint32_t Arg
     )
 {
+    uint64_t Now = QuicTimeUs64();
+    if (Worker->LastActivityChangeTimeUs != 0) {
+        if (Worker->IsActive) {
+            Worker->TotalBusyTimeUs += Now - Worker->LastActivityChangeTimeUs;
+        } else {
+            Worker->TotalIdleTimeUs += Now - Worker->LastActivityChangeTimeUs;
+        }
+    }
+    Worker->LastActivityChangeTimeUs = Now;
     Worker->IsActive = !Worker->IsActive;
     QuicTraceEvent(
         WorkerActivityStateUpdated,
@@ -299,6 +566,8 @@ QuicWorkerUpdateQueueDelay(
     )
 {
     Worker->AverageQueueDelay = (7 * Worker->AverageQueueDelay + TimeInQueueUs) / 8;
+    QuicPerfCounterSet(
+        QUIC_PERF_COUNTER_WORKER_QUEUE_DELAY_US, Worker->AverageQueueDelay);
     QuicTraceEvent(
         WorkerQueueDelayUpdated,
         "[wrkr][%p] QueueDelay = %u",
@@ -313,6 +582,7 @@ QuicWorkerResetQueueDelay(
     )
 {
     Worker->AverageQueueDelay = 0;
+    QuicPerfCounterSet(QUIC_PERF_COUNTER_WORKER_QUEUE_DELAY_US, 0);
     QuicTraceEvent(
         WorkerQueueDelayUpdated,
         "[wrkr][%p] QueueDelay = %u",
@@ -406,11 +676,57 @@ QuicWorkerProcessTimers(
         QUIC_CONNECTION* Connection =
             QUIC_CONTAINING_RECORD(Entry, QUIC_CONNECTION, TimerLink);
 
+        //
+        // Claim the connection so a stealing sibling can't drain its
+        // operations while its timers are serviced here. If it is already
+        // claimed (i.e. a sibling is currently draining it), put it back in
+        // the timer wheel; its still-expired timers will be collected again
+        // on the next loop iteration.
+        //
+        BOOLEAN WasQueued = FALSE;
+        QuicDispatchLockAcquire(&Worker->Lock);
+        if (Connection->WorkerProcessing) {
+            QuicDispatchLockRelease(&Worker->Lock);
+            QuicTimerWheelUpdateConnection(&Worker->TimerWheel, Connection);
+            continue;
+        }
+        Connection->WorkerProcessing = TRUE;
+        if (Connection->HasQueuedWork) {
+            //
+            // Take it off the queue while claimed so it can't be picked up
+            // (or stolen) concurrently. It is reinserted below.
+            //
+            QuicListEntryRemove(&Connection->WorkerLink);
+            WasQueued = TRUE;
+        }
+        QuicDispatchLockRelease(&Worker->Lock);
+
         Connection->WorkerThreadID = Worker->ThreadID;
         QuicSessionAttachSilo(Connection->Session);
         QuicConnTimerExpired(Connection, TimeNow);
         QuicSessionDetachSilo();
         Connection->WorkerThreadID = 0;
+
+        QuicDispatchLockAcquire(&Worker->Lock);
+        Connection->WorkerProcessing = FALSE;
+        if (Connection->HasQueuedWork) {
+            if (!WasQueued) {
+                //
+                // The timer processing produced new work, so the connection
+                // takes a new queue reference (just like
+                // QuicWorkerQueueConnection).
+                //
+                Connection->Stats.Schedule.LastQueueTime = QuicTimeUs32();
+                QuicTraceEvent(
+                    ConnScheduleState,
+                    "[conn][%p] Scheduling: %u",
+                    Connection,
+                    QUIC_SCHEDULE_QUEUED);
+                QuicConnAddRef(Connection, QUIC_CONN_REF_WORKER);
+            }
+            QuicListInsertTail(&Worker->Connections, &Connection->WorkerLink);
+        }
+        QuicDispatchLockRelease(&Worker->Lock);
     }
 }
 
@@ -418,7 +734,8 @@ _IRQL_requires_max_(PASSIVE_LEVEL)
 void
 QuicWorkerProcessConnection(
     _In_ QUIC_WORKER* Worker,
-    _In_ QUIC_CONNECTION* Connection
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_THREAD_ID ThreadID
     )
 {
     QuicTraceEvent(
@@ -429,17 +746,24 @@ QuicWorkerProcessConnection(
     QuicSessionAttachSilo(Connection->Session);
 
     if (Connection->Stats.Schedule.LastQueueTime != 0) {
-        QuicWorkerUpdateQueueDelay(
-            Worker,
+        uint32_t TimeInQueueUs =
             QuicTimeDiff32(
                 Connection->Stats.Schedule.LastQueueTime,
-                QuicTimeUs32()));
+                QuicTimeUs32());
+        QuicWorkerUpdateQueueDelay(Worker, TimeInQueueUs);
+        QuicPerfEventRingWrite(
+            &Worker->PerfEvents,
+            QUIC_PERF_EVENT_CONN_PROCESSED,
+            (uint64_t)(uintptr_t)Connection,
+            TimeInQueueUs);
     }
 
     //
-    // Set the thread ID so reentrant API calls will execute inline.
+    // Set the thread ID so reentrant API calls will execute inline. This is
+    // the ID of the thread actually draining the connection, which is a
+    // sibling worker's thread when the connection has been stolen.
     //
-    Connection->WorkerThreadID = Worker->ThreadID;
+    Connection->WorkerThreadID = ThreadID;
     Connection->Stats.Schedule.DrainCount++;
 
     if (Connection->State.UpdateWorker) {
@@ -473,10 +797,22 @@ QuicWorkerProcessConnection(
     //
     // Process some operations.
     //
+    uint64_t PrevOperationCount = Connection->Stats.Schedule.OperationCount;
     BOOLEAN StillHasWorkToDo =
         QuicConnDrainOperations(Connection) | Connection->State.UpdateWorker;
     Connection->WorkerThreadID = 0;
 
+    uint64_t DrainedOperations =
+        Connection->Stats.Schedule.OperationCount - PrevOperationCount;
+    uint32_t Bucket = 0;
+    while (DrainedOperations > 1 &&
+        Bucket < QUIC_WORKER_STATS_DRAIN_BUCKETS - 1) {
+        DrainedOperations >>= 1;
+        Bucket++;
+    }
+    Worker->DrainCount++;
+    Worker->DrainHistogram[Bucket]++;
+
     //
     // Determine whether the connection needs to be requeued.
     //
@@ -535,17 +871,127 @@ QuicWorkerProcessConnection(
     }
 }
 
+//
+// Attempts to steal a queued connection from an overloaded sibling worker in
+// the same pool. On success, returns the connection (claimed for processing)
+// and sets *Victim to its owning worker.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_CONNECTION*
+QuicWorkerStealConnection(
+    _In_ QUIC_WORKER* Worker,
+    _Out_ QUIC_WORKER** Victim
+    )
+{
+    QUIC_CONNECTION* Connection = NULL;
+    QUIC_WORKER_POOL* Pool = Worker->Pool;
+    *Victim = NULL;
+
+    if (Pool == NULL || Pool->WorkerCount == 1) {
+        return NULL;
+    }
+
+    for (uint8_t Offset = 1; Offset < Pool->WorkerCount; ++Offset) {
+        QUIC_WORKER* Target =
+            &Pool->Workers[(Worker->IdealProcessor + Offset) % Pool->WorkerCount];
+        if (Target == Worker || !QuicWorkerIsOverloaded(Target)) {
+            continue;
+        }
+
+        QuicDispatchLockAcquire(&Target->Lock);
+        if (Target->Enabled &&
+            !QuicListIsEmpty(&Target->Connections) &&
+            Target->Connections.Flink->Flink != &Target->Connections) {
+            //
+            // The victim has at least two queued connections; take the
+            // oldest and leave the rest, claiming it exactly the way
+            // QuicWorkerGetNextConnection does.
+            //
+            Connection =
+                QUIC_CONTAINING_RECORD(
+                    QuicListRemoveHead(&Target->Connections), QUIC_CONNECTION, WorkerLink);
+            QUIC_DBG_ASSERT(!Connection->WorkerProcessing);
+            QUIC_DBG_ASSERT(Connection->HasQueuedWork);
+            Connection->HasQueuedWork = FALSE;
+            Connection->WorkerProcessing = TRUE;
+        }
+        QuicDispatchLockRelease(&Target->Lock);
+
+        if (Connection != NULL) {
+            *Victim = Target;
+            break;
+        }
+    }
+
+    return Connection;
+}
+
+//
+// Warms a worker-owned pool from the worker thread itself. The thread runs
+// on (or near, depending on the registration's thread flags) its ideal
+// processor, so the backing memory is first-touched — and therefore placed
+// by the kernel — on that processor's NUMA node rather than on whatever node
+// initialized the worker pool.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static
+void
+QuicWorkerPrewarmPool(
+    _Inout_ QUIC_POOL* Pool,
+    _In_ uint32_t Count
+    )
+{
+    void* Entries[QUIC_MAX_WORKER_POOL_PREWARM];
+    uint32_t Allocated = 0;
+
+    QUIC_DBG_ASSERT(Count <= ARRAYSIZE(Entries));
+    for (uint32_t i = 0; i < Count; ++i) {
+        Entries[Allocated] = QuicPoolAlloc(Pool);
+        if (Entries[Allocated] == NULL) {
+            break;
+        }
+        Allocated++;
+    }
+    while (Allocated != 0) {
+        QuicPoolFree(Pool, Entries[--Allocated]);
+    }
+}
+
+//
+// Releases the worker pools' cached free entries back to the system. Called
+// from the worker thread when it runs out of work while the library is over
+// its buffer memory budget.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static
+void
+QuicWorkerTrimPools(
+    _Inout_ QUIC_WORKER* Worker
+    )
+{
+    QuicPoolTrim(&Worker->StreamPool);
+    QuicPoolTrim(&Worker->SendRequestPool);
+    QuicPoolTrim(&Worker->ApiContextPool);
+    QuicPoolTrim(&Worker->StatelessContextPool);
+    QuicPoolTrim(&Worker->OperPool);
+}
+
 QUIC_THREAD_CALLBACK(QuicWorkerThread, Context)
 {
     QUIC_WORKER* Worker = (QUIC_WORKER*)Context;
 
     Worker->ThreadID = QuicCurThreadID();
     Worker->IsActive = TRUE;
+    Worker->LastActivityChangeTimeUs = QuicTimeUs64();
     QuicTraceEvent(
         WorkerStart,
         "[wrkr][%p] Start",
         Worker);
 
+    QuicWorkerPrewarmPool(&Worker->OperPool, QUIC_MAX_WORKER_POOL_PREWARM);
+    QuicWorkerPrewarmPool(&Worker->StreamPool, QUIC_MAX_WORKER_POOL_PREWARM);
+    QuicWorkerPrewarmPool(&Worker->SendRequestPool, QUIC_MAX_WORKER_POOL_PREWARM);
+
     //
     // TODO - Review how often QuicTimeUs64() is called in the thread. Perhaps
     // we can get it down to once per loop, passing the value along.
@@ -562,17 +1008,29 @@ QUIC_THREAD_CALLBACK(QuicWorkerThread, Context)
 
         QUIC_CONNECTION* Connection = QuicWorkerGetNextConnection(Worker);
         if (Connection != NULL) {
-            QuicWorkerProcessConnection(Worker, Connection);
+            QuicWorkerProcessConnection(Worker, Connection, Worker->ThreadID);
         }
 
         QUIC_OPERATION* Operation = QuicWorkerGetNextOperation(Worker);
         if (Operation != NULL) {
+            QuicPerfEventRingWrite(
+                &Worker->PerfEvents,
+                QUIC_PERF_EVENT_OPER_PROCESSED,
+                0,
+                Operation->Type);
             QuicBindingProcessStatelessOperation(
                 Operation->Type,
                 Operation->STATELESS.Context);
             QuicOperationFree(Worker, Operation);
         }
 
+        //
+        // Hand every receive buffer consumed by the processing above back to
+        // the datapath in one call, instead of paying the return path once
+        // per datagram chain.
+        //
+        QuicWorkerFlushRecvRelease(Worker);
+
         //
         // Get the delay until the next timer expires. Check to see if any
         // timers have expired; if so, process them. If not, only wait for the
@@ -595,7 +1053,61 @@ QUIC_THREAD_CALLBACK(QuicWorkerThread, Context)
             //
             continue;
 
-        } else if (Delay != UINT64_MAX) {
+        } else {
+            //
+            // Out of local work. Before going to sleep, try to take a queued
+            // connection off an overloaded sibling and drain it on the
+            // sibling's behalf.
+            //
+            QUIC_WORKER* Victim;
+            Connection = QuicWorkerStealConnection(Worker, &Victim);
+            if (Connection != NULL) {
+                QuicWorkerProcessConnection(Victim, Connection, Worker->ThreadID);
+                continue;
+            }
+
+            //
+            // Briefly poll the queues before parking on the ready event, so
+            // that back-to-back datapath completions are picked up without
+            // paying an event wake and context switch per burst. Producers
+            // always queue their work before setting the ready event, so an
+            // unsynchronized peek here can only be stale, never wrong; any
+            // work the poll misses is caught by the event wait below.
+            //
+            if (Worker->IdleSpinUs != 0) {
+                uint64_t SpinEnd = QuicTimeUs64() + Worker->IdleSpinUs;
+                BOOLEAN WorkFound = FALSE;
+                do {
+                    if (!QuicListIsEmpty(&Worker->Connections) ||
+                        Worker->OperationCount != 0) {
+                        WorkFound = TRUE;
+                        break;
+                    }
+                } while (QuicTimeUs64() < SpinEnd);
+                if (WorkFound) {
+                    continue;
+                }
+            }
+
+            //
+            // Going idle; give memory back if the library is over its
+            // buffer memory budget.
+            //
+            if (QuicLibraryUnderMemoryPressure()) {
+                QuicWorkerTrimPools(Worker);
+            }
+
+            if (Delay == UINT64_MAX) {
+                //
+                // No active timers running, so just wait for the ready event.
+                //
+                QuicWorkerToggleActivityState(Worker, UINT32_MAX);
+                QuicWorkerResetQueueDelay(Worker);
+                QuicEventWaitForever(Worker->Ready);
+                QuicWorkerToggleActivityState(Worker, TRUE);
+                continue;
+            }
+
             //
             // Since we have no connections and no stateless operations to
             // process at the moment, we need to wait for the ready event or the
@@ -613,15 +1125,6 @@ QUIC_THREAD_CALLBACK(QuicWorkerThread, Context)
             if (!ReadySet) {
                 QuicWorkerProcessTimers(Worker);
             }
-
-        } else {
-            //
-            // No active timers running, so just wait for the ready event.
-            //
-            QuicWorkerToggleActivityState(Worker, UINT32_MAX);
-            QuicWorkerResetQueueDelay(Worker);
-            QuicEventWaitForever(Worker->Ready);
-            QuicWorkerToggleActivityState(Worker, TRUE);
         }
     }
 
@@ -632,6 +1135,8 @@ QUIC_THREAD_CALLBACK(QuicWorkerThread, Context)
     // in it's list by the time clean up started. So it needs to release any
     // remaining references on connections.
     //
+    QuicWorkerFlushRecvRelease(Worker);
+
     while (!QuicListIsEmpty(&Worker->Connections)) {
         QUIC_CONNECTION* Connection =
             QUIC_CONTAINING_RECORD(
@@ -672,7 +1177,9 @@ QUIC_STATUS
 QuicWorkerPoolInitialize(
     _In_opt_ const void* Owner,
     _In_ uint16_t ThreadFlags,
+    _In_ uint32_t IdleSpinUs,
     _In_ uint8_t WorkerCount,
+    _In_reads_opt_(WorkerCount) const uint8_t* ProcessorList,
     _Out_ QUIC_WORKER_POOL** NewWorkerPool
     )
 {
@@ -700,7 +1207,15 @@ QuicWorkerPoolInitialize(
     //
 
     for (uint8_t i = 0; i < WorkerCount; i++) {
-        Status = QuicWorkerInitialize(Owner, ThreadFlags, i, &WorkerPool->Workers[i]);
+        WorkerPool->Workers[i].Pool = WorkerPool;
+        Status =
+            QuicWorkerInitialize(
+                Owner,
+                ThreadFlags,
+                IdleSpinUs,
+                ProcessorList != NULL ? ProcessorList[i] : i,
+                ProcessorList != NULL,
+                &WorkerPool->Workers[i]);
         if (QUIC_FAILED(Status)) {
             for (uint8_t j = 0; j < i; j++) {
                 QuicWorkerUninitialize(&WorkerPool->Workers[j]);
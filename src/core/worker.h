@@ -5,11 +5,19 @@
 
 --*/
 
+typedef struct QUIC_WORKER_POOL QUIC_WORKER_POOL;
+
 //
 // A worker thread for draining queued operations on a connection.
 //
 typedef struct QUIC_CACHEALIGN QUIC_WORKER {
 
+    //
+    // The pool this worker belongs to, if any. Used to find sibling workers
+    // to steal work from when this worker runs out of its own.
+    //
+    QUIC_WORKER_POOL* Pool;
+
     //
     // TRUE if the worker is currently running.
     //
@@ -35,6 +43,13 @@ typedef struct QUIC_CACHEALIGN QUIC_WORKER {
     //
     uint32_t AverageQueueDelay;
 
+    //
+    // How long the worker busy-polls its queues before parking on the ready
+    // event (in us). Derived from the global setting and the owner's
+    // execution profile. Zero disables the spin phase.
+    //
+    uint32_t IdleSpinUs;
+
     //
     // Timers for the worker's connections.
     //
@@ -67,6 +82,25 @@ typedef struct QUIC_CACHEALIGN QUIC_WORKER {
     uint32_t OperationCount;
     uint64_t DroppedOperationCount;
 
+    //
+    // Load telemetry, snapshotted externally via the registration's worker
+    // stats parameter: the number of connections currently assigned to the
+    // worker, cumulative busy/idle time, and a histogram of how many
+    // operations each connection drain call processed.
+    //
+    long ConnectionCount;
+    uint64_t TotalBusyTimeUs;
+    uint64_t TotalIdleTimeUs;
+    uint64_t LastActivityChangeTimeUs;
+    uint64_t DrainCount;
+    uint64_t DrainHistogram[QUIC_WORKER_STATS_DRAIN_BUCKETS];
+
+    //
+    // Always-on ring buffer of binary performance events for the worker and
+    // its connections.
+    //
+    QUIC_PERF_EVENT_RING PerfEvents;
+
     QUIC_POOL StreamPool; // QUIC_STREAM
     QUIC_POOL SendRequestPool; // QUIC_SEND_REQUEST
     QUIC_SENT_PACKET_POOL SentPacketPool; // QUIC_SENT_PACKET_METADATA
@@ -74,12 +108,30 @@ typedef struct QUIC_CACHEALIGN QUIC_WORKER {
     QUIC_POOL StatelessContextPool; // QUIC_STATELESS_CONTEXT
     QUIC_POOL OperPool; // QUIC_OPERATION
 
+    //
+    // Packet builder scratch reused across the connection flushes in a drain,
+    // so consecutive flushes share warm buffers instead of each re-zeroing
+    // ~1KB of stack. Only handed out on the worker thread itself; flushes on
+    // other threads (e.g. inline API sends) fall back to a stack builder.
+    //
+    struct QUIC_PACKET_BUILDER* PacketBuilder;
+    BOOLEAN PacketBuilderInUse;
+
+    //
+    // Consumed receive datagrams collected across the connections processed
+    // in a drain, handed back to the datapath in a single call per worker
+    // loop iteration instead of once per chain. Only touched on the worker
+    // thread.
+    //
+    QUIC_RECV_DATAGRAM* RecvReleaseChain;
+    QUIC_RECV_DATAGRAM** RecvReleaseChainTail;
+
 } QUIC_WORKER;
 
 //
 // A set of workers.
 //
-typedef struct QUIC_WORKER_POOL {
+struct QUIC_WORKER_POOL {
 
     //
     // Number of workers in the pool.
@@ -97,7 +149,7 @@ typedef struct QUIC_WORKER_POOL {
     _Field_size_(WorkerCount)
     QUIC_WORKER Workers[0];
 
-} QUIC_WORKER_POOL;
+};
 
 //
 // Returns TRUE if the worker is currently overloaded and shouldn't take on more
@@ -114,14 +166,18 @@ QuicWorkerIsOverloaded(
 }
 
 //
-// Initializes the worker pool.
+// Initializes the worker pool. An optional processor list (one entry per
+// worker) hard-affinitizes each worker to the given processor instead of the
+// default index-based placement.
 //
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicWorkerPoolInitialize(
     _In_opt_ const void* Owner,
     _In_ uint16_t ThreadFlags,
+    _In_ uint32_t IdleSpinUs,
     _In_ uint8_t WorkerCount,
+    _In_reads_opt_(WorkerCount) const uint8_t* ProcessorList,
     _Out_ QUIC_WORKER_POOL** WorkerPool
     );
 
@@ -173,6 +229,111 @@ QuicWorkerQueueConnection(
     _In_ QUIC_CONNECTION* Connection
     );
 
+//
+// Hands out the worker's shared packet builder scratch when called on the
+// worker thread and it isn't already in use; otherwise returns the caller's
+// stack builder.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Ret_notnull_
+struct QUIC_PACKET_BUILDER*
+QuicWorkerGetPacketBuilder(
+    _In_ QUIC_WORKER* Worker,
+    _In_ struct QUIC_PACKET_BUILDER* StackBuilder
+    );
+
+//
+// Returns a packet builder acquired with QuicWorkerGetPacketBuilder.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicWorkerReleasePacketBuilder(
+    _In_ QUIC_WORKER* Worker,
+    _In_ struct QUIC_PACKET_BUILDER* Builder
+    );
+
+//
+// Queues a chain of consumed receive datagrams to be returned to the
+// datapath at the end of the worker's current loop iteration. If not called
+// on the worker thread, the chain is returned directly instead.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerQueueRecvRelease(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_RECV_DATAGRAM* DatagramChain
+    );
+
+//
+// Returns all the queued receive datagrams to the datapath in one call.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerFlushRecvRelease(
+    _In_ QUIC_WORKER* Worker
+    );
+
+//
+// Opens an API batch on the connection, deferring worker wakes for newly
+// queued operations until the matching commit.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerApiBatchBegin(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    );
+
+//
+// Commits an API batch on the connection, waking the worker thread if a wake
+// was deferred while the batch was open. Returns FALSE if no batch was open.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicWorkerApiBatchCommit(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    );
+
+//
+// Attempts to claim an idle connection for inline processing on the calling
+// (API) thread. Fails if the connection already has queued work, is being
+// processed, or is queued to move to a new worker. On success the caller owns
+// the connection's processing, exactly as the worker thread does, and must
+// release it with QuicWorkerReleaseConnection.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+BOOLEAN
+QuicWorkerTryClaimConnection(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    );
+
+//
+// Releases a connection claimed via QuicWorkerTryClaimConnection, queueing it
+// onto the worker if work accumulated while it was claimed.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicWorkerReleaseConnection(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection
+    );
+
+//
+// Drains a claimed connection's operation queue on the calling thread,
+// requeueing the connection (without a wake) if the drain leaves work behind.
+// The caller must have claimed the connection and hold a worker reference on
+// it, both of which are released before returning.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicWorkerProcessConnection(
+    _In_ QUIC_WORKER* Worker,
+    _In_ QUIC_CONNECTION* Connection,
+    _In_ QUIC_THREAD_ID ThreadID
+    );
+
 //
 // Queues the operation onto the worker, and kicks the worker thread if
 // necessary.
@@ -80,6 +80,31 @@ typedef enum QUIC_LOAD_BALANCING_MODE {
     QUIC_LOAD_BALANCING_SERVER_ID_IP            // Encodes IP address in Server ID
 } QUIC_LOAD_BALANCING_MODE;
 
+//
+// Library-wide performance counters, readable as a snapshot via
+// QUIC_PARAM_GLOBAL_PERF_COUNTERS.
+//
+typedef enum QUIC_PERFORMANCE_COUNTERS {
+    QUIC_PERF_COUNTER_CONN_CREATED,         // Total connections ever allocated.
+    QUIC_PERF_COUNTER_CONN_HANDSHAKE_FAIL,  // Total connections that failed during handshake.
+    QUIC_PERF_COUNTER_CONN_DESTROYED,       // Total connections ever freed.
+    QUIC_PERF_COUNTER_PKTS_SENT,            // Total QUIC packets sent.
+    QUIC_PERF_COUNTER_PKTS_RECV,            // Total UDP datagrams received.
+    QUIC_PERF_COUNTER_PKTS_ACK_ONLY_SENT,   // Total non-retransmittable (ACK-only) packets sent.
+    QUIC_PERF_COUNTER_PKTS_SUSPECTED_LOST,  // Total packets suspected lost.
+    QUIC_PERF_COUNTER_BYTES_SENT,           // Total QUIC packet bytes sent.
+    QUIC_PERF_COUNTER_BYTES_RECV,           // Total UDP payload bytes received.
+    QUIC_PERF_COUNTER_OPER_DROPPED,         // Total operations dropped by workers.
+    QUIC_PERF_COUNTER_WORKER_QUEUE_DELAY_US,// Worst average worker queue delay (microseconds).
+    QUIC_PERF_COUNTER_TLS_HANDSHAKE_TIME_US,// Total microseconds spent in TLS handshake calls.
+    QUIC_PERF_COUNTER_TLS_BYTES_ENCRYPTED,  // Total packet payload bytes encrypted.
+    QUIC_PERF_COUNTER_OPER_API_CALL_TIME_US,// Total microseconds spent processing app API calls.
+    QUIC_PERF_COUNTER_OPER_FLUSH_RECV_TIME_US,// Total microseconds spent processing received packets.
+    QUIC_PERF_COUNTER_OPER_FLUSH_SEND_TIME_US,// Total microseconds spent framing and sending packets.
+    QUIC_PERF_COUNTER_OPER_TIMER_TIME_US,   // Total microseconds spent processing expired timers.
+    QUIC_PERF_COUNTER_MAX
+} QUIC_PERFORMANCE_COUNTERS;
+
 typedef enum QUIC_SEC_CONFIG_FLAGS {
     QUIC_SEC_CONFIG_FLAG_NONE                   = 0x00000000,
     QUIC_SEC_CONFIG_FLAG_CERTIFICATE_HASH       = 0x00000001,
@@ -87,6 +112,7 @@ typedef enum QUIC_SEC_CONFIG_FLAGS {
     QUIC_SEC_CONFIG_FLAG_CERTIFICATE_CONTEXT    = 0x00000004,
     QUIC_SEC_CONFIG_FLAG_CERTIFICATE_FILE       = 0x00000008,
     QUIC_SEC_CONFIG_FLAG_ENABLE_OCSP            = 0x00000010,
+    QUIC_SEC_CONFIG_FLAG_PREFER_CHACHA20        = 0x00000020,   // Prefer ChaCha20-Poly1305 over AES-GCM.
     QUIC_SEC_CONFIG_FLAG_CERTIFICATE_NULL       = 0xF0000000    // Can't be used with anything else.
 } QUIC_SEC_CONFIG_FLAGS;
 
@@ -151,7 +177,9 @@ DEFINE_ENUM_FLAG_OPERATORS(QUIC_RECEIVE_FLAGS);
 typedef enum QUIC_SEND_FLAGS {
     QUIC_SEND_FLAG_NONE                     = 0x0000,
     QUIC_SEND_FLAG_ALLOW_0_RTT              = 0x0001,   // Allows the use of encrypting with 0-RTT key.
-    QUIC_SEND_FLAG_FIN                      = 0x0002    // Indicates the request is the one last sent on the stream.
+    QUIC_SEND_FLAG_FIN                      = 0x0002,   // Indicates the request is the one last sent on the stream.
+    QUIC_SEND_FLAG_NO_BUFFERING             = 0x0004,   // The app buffers are referenced (not copied) until the send completes.
+    QUIC_SEND_FLAG_DELAY_SEND               = 0x0008    // Indicates the send should be delayed because more will be queued soon.
 } QUIC_SEND_FLAGS;
 
 DEFINE_ENUM_FLAG_OPERATORS(QUIC_SEND_FLAGS);
@@ -160,6 +188,22 @@ DEFINE_ENUM_FLAG_OPERATORS(QUIC_SEND_FLAGS);
 typedef struct QUIC_REGISTRATION_CONFIG { // All fields may be NULL/zero.
     const char* AppName;
     QUIC_EXECUTION_PROFILE ExecutionProfile;
+    //
+    // Optional override of the number of worker threads (and thus connection
+    // partitions) the registration creates. Zero keeps the default of one
+    // worker per library partition. Lets a process on a large machine run a
+    // few well-placed workers instead of one per processor.
+    //
+    uint8_t WorkerCount;
+    //
+    // Optional explicit placement for the workers, one processor per worker.
+    // When supplied, each worker is hard-affinitized to its processor. If
+    // WorkerCount is zero, one worker is created per list entry; otherwise
+    // ProcessorCount must equal WorkerCount.
+    //
+    uint8_t ProcessorCount;
+    _Field_size_(ProcessorCount)
+    const uint8_t* ProcessorList;
 } QUIC_REGISTRATION_CONFIG;
 
 typedef struct QUIC_CERTIFICATE_HASH {
@@ -223,6 +267,9 @@ typedef struct QUIC_STATISTICS {
         uint64_t Start;
         uint64_t InitialFlightEnd;      // Processed all peer's Initial packets
         uint64_t HandshakeFlightEnd;    // Processed all peer's Handshake packets
+        uint64_t FirstPacketRecv;       // Datapath receive of the first packet (server only; 0 if unknown)
+        uint64_t HandshakeComplete;     // TLS reported the handshake complete
+        uint64_t ConnectedCallback;     // CONNECTED event returned from the app
     } Timing;
     struct {
         uint32_t ClientFlight1Bytes;    // Sum of TLS payloads
@@ -252,8 +299,24 @@ typedef struct QUIC_STATISTICS {
     struct {
         uint32_t KeyUpdateCount;
     } Misc;
+    struct {
+        uint32_t CongestionWindow;      // Current congestion window, in bytes.
+        uint32_t BytesInFlight;         // Bytes currently unacknowledged in the network.
+    } Congestion;
+    struct {
+        uint64_t PostedBytes;           // Bytes the app currently has posted for send.
+        uint64_t IdealBytes;            // Posted bytes needed to avoid limiting throughput.
+        uint64_t StallTimeUs;           // Total time PostedBytes has sat below IdealBytes.
+        uint64_t BufferedBytes;         // Posted bytes copied into internal send buffers.
+    } SendBuffer;
 } QUIC_STATISTICS;
 
+typedef struct QUIC_DELIVERY_RATE_INFO {
+    uint64_t DeliveryRate;              // Estimated delivery rate, in bytes per second.
+    uint32_t MinRtt;                    // In microseconds
+    uint8_t AppLimited;                 // Estimate was taken while starved for app data.
+} QUIC_DELIVERY_RATE_INFO;
+
 typedef struct QUIC_LISTENER_STATISTICS {
 
     uint64_t TotalAcceptedConnections;
@@ -318,6 +381,10 @@ typedef enum QUIC_PARAM_LEVEL {
 #define QUIC_PARAM_GLOBAL_RETRY_MEMORY_PERCENT          0   // uint16_t
 #define QUIC_PARAM_GLOBAL_SUPPORTED_VERSIONS            1   // uint32_t[] - network byte order
 #define QUIC_PARAM_GLOBAL_LOAD_BALACING_MODE            2   // uint16_t - QUIC_LOAD_BALANCING_MODE
+#define QUIC_PARAM_GLOBAL_PERF_COUNTERS                 3   // int64_t[] - Array size is QUIC_PERF_COUNTER_MAX
+#define QUIC_PARAM_GLOBAL_DATAPATH_FEATURES             4   // uint32_t - QUIC_DATAPATH_FEATURE_* flags
+#define QUIC_PARAM_GLOBAL_TLS_PROVIDER_NAME             5   // char[] - null terminated
+#define QUIC_PARAM_GLOBAL_PROCESSOR_LIST                6   // uint16_t[] - logical processor indices
 
 //
 // Parameters for QUIC_PARAM_LEVEL_REGISTRATION.
@@ -334,12 +401,14 @@ typedef enum QUIC_PARAM_LEVEL {
 #define QUIC_PARAM_SESSION_DISCONNECT_TIMEOUT           4   // uint32_t - milliseconds
 #define QUIC_PARAM_SESSION_MAX_BYTES_PER_KEY            5   // uint64_t - bytes
 #define QUIC_PARAM_SESSION_MIGRATION_ENABLED            6   // uint8_t (BOOLEAN)
+#define QUIC_PARAM_SESSION_SERVER_TICKET_CACHE_CAPACITY 7   // uint32_t - entries
 
 //
 // Parameters for QUIC_PARAM_LEVEL_LISTENER.
 //
 #define QUIC_PARAM_LISTENER_LOCAL_ADDRESS               0   // QUIC_ADDR
 #define QUIC_PARAM_LISTENER_STATS                       1   // QUIC_LISTENER_STATISTICS
+#define QUIC_PARAM_LISTENER_SERVER_NAME                 2   // char[] - Optional SNI filter. Set before start.
 
 //
 // Parameters for QUIC_PARAM_LEVEL_CONNECTION.
@@ -365,6 +434,14 @@ typedef enum QUIC_PARAM_LEVEL {
 #define QUIC_PARAM_CONN_IDEAL_PROCESSOR                 18  // uint8_t
 #define QUIC_PARAM_CONN_MAX_STREAM_IDS                  19  // uint64_t[4]
 #define QUIC_PARAM_CONN_STREAM_SCHEDULING_SCHEME        20  // QUIC_STREAM_SCHEDULING_SCHEME
+#define QUIC_PARAM_CONN_DATAGRAM_RECEIVE_ENABLED        21  // uint8_t (BOOLEAN)
+#define QUIC_PARAM_CONN_DATAGRAM_SEND_ENABLED           22  // uint8_t (BOOLEAN) - Get only
+#define QUIC_PARAM_CONN_INLINE_API_SEND                 23  // uint8_t (BOOLEAN)
+#define QUIC_PARAM_CONN_BATCHED_RECEIVE_ENABLED         24  // uint8_t (BOOLEAN)
+#define QUIC_PARAM_CONN_BATCHED_SEND_COMPLETE_ENABLED   25  // uint8_t (BOOLEAN)
+#define QUIC_PARAM_CONN_RACING_LOCAL_ADDRESS            26  // QUIC_ADDR
+#define QUIC_PARAM_CONN_DELIVERY_RATE                   27  // QUIC_DELIVERY_RATE_INFO - Get only
+#define QUIC_PARAM_CONN_MAX_STREAM_PACKET_PAYLOAD       28  // uint16_t - Get only - Max stream payload per packet
 
 #ifdef WIN32 // Windows certificate validation ignore flags.
 #define QUIC_CERTIFICATE_FLAG_IGNORE_REVOCATION                 0x00000080
@@ -392,6 +469,9 @@ typedef struct QUIC_SCHANNEL_CONTEXT_ATTRIBUTE_W {
 #define QUIC_PARAM_STREAM_ID                            0   // QUIC_UINT62
 #define QUIC_PARAM_STREAM_0RTT_LENGTH                   1   // uint64_t
 #define QUIC_PARAM_STREAM_IDEAL_SEND_BUFFER_SIZE        2   // uint64_t - bytes
+#define QUIC_PARAM_STREAM_PRIORITY                      3   // uint16_t - 0 (low) to 0xFFFF (high) - default 0x7FFF
+#define QUIC_PARAM_STREAM_QUEUED_SEND_BYTES             4   // uint64_t - bytes posted but not yet fully acknowledged - Get only
+#define QUIC_PARAM_STREAM_CANCEL_UNSENT                 5   // BOOLEAN (TRUE) - cancels queued sends not yet on the wire - Set only
 
 typedef
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -616,6 +696,17 @@ void
 // Connections
 //
 
+//
+// The states of an unreliable datagram send. Once a final state (acknowledged,
+// discarded or canceled) has been indicated, the app may free the buffers.
+//
+typedef enum QUIC_DATAGRAM_SEND_STATE {
+    QUIC_DATAGRAM_SEND_SENT,            // Sent and awaiting acknowledgment.
+    QUIC_DATAGRAM_SEND_ACKNOWLEDGED,    // Acknowledged by the peer.
+    QUIC_DATAGRAM_SEND_LOST_DISCARDED,  // Lost and not retransmitted.
+    QUIC_DATAGRAM_SEND_CANCELED         // Canceled before being sent.
+} QUIC_DATAGRAM_SEND_STATE;
+
 typedef enum QUIC_CONNECTION_EVENT_TYPE {
     QUIC_CONNECTION_EVENT_CONNECTED                         = 0,
     QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT   = 1,    // The transport started the shutdown process.
@@ -626,9 +717,35 @@ typedef enum QUIC_CONNECTION_EVENT_TYPE {
     QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED               = 6,
     QUIC_CONNECTION_EVENT_STREAMS_AVAILABLE                 = 7,
     QUIC_CONNECTION_EVENT_PEER_NEEDS_STREAMS                = 8,
-    QUIC_CONNECTION_EVENT_IDEAL_PROCESSOR_CHANGED           = 9
+    QUIC_CONNECTION_EVENT_IDEAL_PROCESSOR_CHANGED           = 9,
+    QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED            = 10,   // Datagram send capability changed.
+    QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED                 = 11,
+    QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED       = 12,
+    QUIC_CONNECTION_EVENT_BATCHED_RECEIVE                   = 13,   // Only indicated if batched receive enabled.
+    QUIC_CONNECTION_EVENT_PACKET_PAYLOAD_CHANGED            = 14    // Max stream payload per packet changed (PMTU update).
 } QUIC_CONNECTION_EVENT_TYPE;
 
+//
+// A single stream's receive data in a batched receive event. The semantics of
+// each entry match the stream QUIC_STREAM_EVENT_RECEIVE event: the app sets
+// BytesConsumed to the number of bytes it drained (defaulted to all of it)
+// and may set Status to QUIC_STATUS_PENDING or QUIC_STATUS_CONTINUE, with the
+// same meanings as the single-stream receive callback return value.
+//
+typedef struct QUIC_BATCHED_RECEIVE_ENTRY {
+    /* in */    HQUIC Stream;
+    /* in */    void* StreamContext;
+    /* in */    uint64_t AbsoluteOffset;
+    /* in */    uint64_t TotalBufferLength;
+    _Field_size_(BufferCount)
+    /* in */    const QUIC_BUFFER* Buffers;
+    _Field_range_(1, UINT32_MAX)
+    /* in */    uint32_t BufferCount;
+    /* in */    QUIC_RECEIVE_FLAGS Flags;
+    /* inout */ uint64_t BytesConsumed;
+    /* inout */ QUIC_STATUS Status;
+} QUIC_BATCHED_RECEIVE_ENTRY;
+
 typedef struct QUIC_CONNECTION_EVENT {
     QUIC_CONNECTION_EVENT_TYPE Type;
     union {
@@ -664,6 +781,25 @@ typedef struct QUIC_CONNECTION_EVENT {
         struct {
             uint8_t IdealProcessor;
         } IDEAL_PROCESSOR_CHANGED;
+        struct {
+            BOOLEAN SendEnabled;
+            uint16_t MaxSendLength;
+        } DATAGRAM_STATE_CHANGED;
+        struct {
+            const QUIC_BUFFER* Buffer;
+        } DATAGRAM_RECEIVED;
+        struct {
+            /* inout */ void* ClientContext;
+            QUIC_DATAGRAM_SEND_STATE State;
+        } DATAGRAM_SEND_STATE_CHANGED;
+        struct {
+            _Field_size_(EntryCount)
+            QUIC_BATCHED_RECEIVE_ENTRY* Entries;
+            uint32_t EntryCount;
+        } BATCHED_RECEIVE;
+        struct {
+            uint16_t MaxStreamPayloadSize;
+        } PACKET_PAYLOAD_CHANGED;
     };
 } QUIC_CONNECTION_EVENT;
 
@@ -734,6 +870,22 @@ QUIC_STATUS
     _In_ uint16_t ServerPort // Host byte order
     );
 
+//
+// Sends an unreliable datagram on the connection. Only allowed if the peer
+// advertised support via the max_datagram_frame_size transport parameter.
+//
+typedef
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+(QUIC_API * QUIC_DATAGRAM_SEND_FN)(
+    _In_ _Pre_defensive_ HQUIC Connection,
+    _In_reads_(BufferCount) _Pre_defensive_
+        const QUIC_BUFFER* const Buffers,
+    _In_ uint32_t BufferCount,
+    _In_ QUIC_SEND_FLAGS Flags,
+    _In_opt_ void* ClientSendContext
+    );
+
 //
 // Streams
 //
@@ -747,7 +899,8 @@ typedef enum QUIC_STREAM_EVENT_TYPE {
     QUIC_STREAM_EVENT_PEER_RECEIVE_ABORTED      = 5,
     QUIC_STREAM_EVENT_SEND_SHUTDOWN_COMPLETE    = 6,
     QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE         = 7,
-    QUIC_STREAM_EVENT_IDEAL_SEND_BUFFER_SIZE    = 8
+    QUIC_STREAM_EVENT_IDEAL_SEND_BUFFER_SIZE    = 8,
+    QUIC_STREAM_EVENT_BATCHED_SEND_COMPLETE     = 9     // Only indicated if batched send completions enabled.
 } QUIC_STREAM_EVENT_TYPE;
 
 typedef struct QUIC_STREAM_EVENT {
@@ -770,6 +923,13 @@ typedef struct QUIC_STREAM_EVENT {
             BOOLEAN Canceled;
             void* ClientContext;
         } SEND_COMPLETE;
+        struct {
+            BOOLEAN Canceled;
+            _Field_range_(1, UINT32_MAX)
+            uint32_t ClientContextCount;
+            _Field_size_(ClientContextCount)
+            void** ClientContexts;
+        } BATCHED_SEND_COMPLETE;
         struct {
             QUIC_UINT62 ErrorCode;
         } PEER_SEND_ABORTED;
@@ -884,6 +1044,76 @@ QUIC_STATUS
     _In_ BOOLEAN IsEnabled
     );
 
+//
+// Begins a batch of API calls against a connection. While a batch is open,
+// worker thread wakes for operations queued on the connection are deferred
+// to the matching commit, so a burst of N calls costs a single wake. Batches
+// may be nested; only the outermost commit wakes the worker.
+//
+typedef
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+(QUIC_API * QUIC_CONNECTION_BATCH_BEGIN_FN)(
+    _In_ _Pre_defensive_ HQUIC Connection
+    );
+
+//
+// Commits a batch of API calls previously opened with ConnectionBatchBegin,
+// waking the worker thread if any operations were queued while the batch was
+// open.
+//
+typedef
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+(QUIC_API * QUIC_CONNECTION_BATCH_COMMIT_FN)(
+    _In_ _Pre_defensive_ HQUIC Connection
+    );
+
+//
+// Gets a pooled client connection to the given server, or creates and starts
+// a new one. Connections participate in the session's pool only if they were
+// created through this API; each session pools independently, so the
+// effective pool key is (session ALPN, server name, server port). If an
+// established pooled connection matches, its handle is returned with *Reused
+// set to TRUE; the handle is borrowed and must NOT be passed to
+// ConnectionClose by the caller, and the Handler/Context from the call that
+// originally created the connection remain in effect. Otherwise a new
+// connection is opened with the given Handler/Context and started, *Reused is
+// set to FALSE and the caller owns the returned handle as if it came from
+// ConnectionOpen.
+//
+typedef
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+(QUIC_API * QUIC_CONNECTION_POOL_GET_FN)(
+    _In_ _Pre_defensive_ HQUIC Session,
+    _In_ _Pre_defensive_ QUIC_CONNECTION_CALLBACK_HANDLER Handler,
+    _In_opt_ void* Context,
+    _In_ QUIC_ADDRESS_FAMILY Family,
+    _In_z_ const char* ServerName,
+    _In_ uint16_t ServerPort, // Host byte order
+    _Out_opt_ BOOLEAN* Reused,
+    _Outptr_ _Pre_defensive_ HQUIC* Connection
+    );
+
+//
+// Starts a paced, graceful drain of all connections in the session. Shutdown
+// is queued for at most RatePerSecond connections per second (on a background
+// thread) rather than for every connection at once, so a large fleet can be
+// drained without the burst of CONNECTION_CLOSE sends and timer cleanup
+// starving still-active traffic. Only one drain may be started per session.
+// SessionClose ends any in-progress drain and then behaves as usual.
+//
+typedef
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+(QUIC_API * QUIC_SESSION_DRAIN_FN)(
+    _In_ _Pre_defensive_ HQUIC Session,
+    _In_ QUIC_CONNECTION_SHUTDOWN_FLAGS Flags,
+    _In_ _Pre_defensive_ QUIC_UINT62 ErrorCode, // Application defined error code
+    _In_ uint32_t RatePerSecond
+    );
+
 //
 // API Function Table.
 //
@@ -924,6 +1154,15 @@ typedef struct QUIC_API_TABLE {
     QUIC_STREAM_RECEIVE_COMPLETE_FN     StreamReceiveComplete;
     QUIC_STREAM_RECEIVE_SET_ENABLED_FN  StreamReceiveSetEnabled;
 
+    QUIC_DATAGRAM_SEND_FN               DatagramSend;
+
+    QUIC_CONNECTION_BATCH_BEGIN_FN      ConnectionBatchBegin;
+    QUIC_CONNECTION_BATCH_COMMIT_FN     ConnectionBatchCommit;
+
+    QUIC_CONNECTION_POOL_GET_FN         ConnectionPoolGet;
+
+    QUIC_SESSION_DRAIN_FN               SessionDrain;
+
 } QUIC_API_TABLE;
 
 //
@@ -166,7 +166,12 @@ typedef union QUIC_ADDR {
 
 #define INITCODE
 #define PAGEDX
-#define QUIC_CACHEALIGN
+
+//
+// Pads (and aligns) the annotated type or member out to its own cache line,
+// so unrelated state written from different processors does not false share.
+//
+#define QUIC_CACHEALIGN __attribute__((aligned(64)))
 
 #if defined(__cplusplus)
 extern "C" {
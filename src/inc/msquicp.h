@@ -30,6 +30,116 @@ extern "C" {
 // The different private parameters for QUIC_PARAM_LEVEL_GLOBAL.
 //
 #define QUIC_PARAM_GLOBAL_ENCRYPTION                    0x80000001  // uint8_t (BOOLEAN)
+#define QUIC_PARAM_GLOBAL_TOTAL_ALLOC_COUNT             0x80000002  // int64_t
+#define QUIC_PARAM_GLOBAL_PACKET_PROFILING              0x80000003  // uint8_t (BOOLEAN)
+
+//
+// The different private parameters for QUIC_PARAM_LEVEL_REGISTRATION.
+//
+
+typedef enum QUIC_PERF_EVENT_TYPE {
+    QUIC_PERF_EVENT_PACKET_SENT,
+    QUIC_PERF_EVENT_PACKET_ACKED,
+    QUIC_PERF_EVENT_PACKET_LOST,
+    QUIC_PERF_EVENT_OPER_QUEUED,
+    QUIC_PERF_EVENT_OPER_PROCESSED,
+    QUIC_PERF_EVENT_CONN_QUEUED,
+    QUIC_PERF_EVENT_CONN_PROCESSED,
+    QUIC_PERF_EVENT_RX_STAGES
+} QUIC_PERF_EVENT_TYPE;
+
+//
+// QUIC_PERF_EVENT_RX_STAGES events are only logged while the (global)
+// QUIC_PARAM_GLOBAL_PACKET_PROFILING parameter is enabled. Each one reports
+// the average receive cost per packet, in CPU cycles, over a window of
+// received packets, broken down by stage and packed into the event's Value:
+//
+//  bits  0-15: header parsing and validation
+//  bits 16-31: header protection removal, decryption and authentication
+//  bits 32-47: frame processing (including ACK frame processing)
+//  bits 48-63: ACK frame processing only
+//
+// Averages larger than 16 bits saturate to 0xFFFF.
+//
+
+//
+// A single, fixed-size binary performance event. The library logs these into
+// always-on, per-worker ring buffers, independent of the platform tracing
+// configuration, so live incidents can be diagnosed without redeploying.
+//
+typedef struct QUIC_PERF_EVENT {
+    //
+    // Monotonically increasing (per worker ring) number. Gaps between
+    // snapshots indicate events that were overwritten before they could be
+    // read.
+    //
+    int64_t Sequence;
+    //
+    // The time the event was logged, in microseconds.
+    //
+    uint64_t Timestamp;
+    //
+    // Identifies the object (e.g. connection) the event applies to. Zero if
+    // not applicable.
+    //
+    uint64_t Context;
+    //
+    // Event specific data: the packet number for the packet events, the
+    // operation type for the operation events and the queue delay (in
+    // microseconds) for QUIC_PERF_EVENT_CONN_PROCESSED.
+    //
+    uint64_t Value;
+    uint32_t Type; // QUIC_PERF_EVENT_TYPE
+    uint32_t Reserved;
+} QUIC_PERF_EVENT;
+
+#define QUIC_PARAM_REGISTRATION_PERF_EVENTS             0x80000001  // QUIC_PERF_EVENT[]
+
+//
+// The number of buckets in the operations-per-drain histogram.
+//
+#define QUIC_WORKER_STATS_DRAIN_BUCKETS 8
+
+//
+// Point-in-time snapshot of a single worker thread's load telemetry, used to
+// detect partition imbalance (hot workers) before it shows up in tail
+// latencies. Returned as an array with one entry per worker.
+//
+typedef struct QUIC_WORKER_STATS {
+    uint8_t IdealProcessor;
+    uint8_t IsActive;               // Currently processing (vs parked).
+    uint8_t Reserved[2];
+    uint32_t AverageQueueDelayUs;
+    uint32_t ConnectionCount;       // Connections currently assigned.
+    uint32_t QueuedOperationCount;  // Stateless operations currently queued.
+    uint64_t TotalBusyTimeUs;       // Total time spent processing work.
+    uint64_t TotalIdleTimeUs;       // Total time spent parked, waiting for work.
+    uint64_t DroppedOperationCount;
+    uint64_t DrainCount;            // Total connection drain calls.
+    //
+    // DrainHistogram[i] counts drain calls that processed [2^i, 2^(i+1))
+    // operations; the last bucket absorbs everything larger.
+    //
+    uint64_t DrainHistogram[QUIC_WORKER_STATS_DRAIN_BUCKETS];
+} QUIC_WORKER_STATS;
+
+#define QUIC_PARAM_REGISTRATION_WORKER_STATS            0x80000003  // QUIC_WORKER_STATS[]
+
+//
+// Flags for QUIC_PARAM_REGISTRATION_TRACE_CLASSES. Each flag enables one
+// class of informational/verbose trace events for the registration's
+// connections; warnings and errors are never gated. Connections capture the
+// mask when they are registered with a session, so changes apply to
+// connections created afterwards.
+//
+#define QUIC_TRACE_CLASS_DATAPATH                       0x00000001
+#define QUIC_TRACE_CLASS_CONGESTION                     0x00000002
+#define QUIC_TRACE_CLASS_LOSS                           0x00000004
+#define QUIC_TRACE_CLASS_CRYPTO                         0x00000008
+#define QUIC_TRACE_CLASS_API                            0x00000010
+#define QUIC_TRACE_CLASS_ALL                            0xFFFFFFFF
+
+#define QUIC_PARAM_REGISTRATION_TRACE_CLASSES           0x80000002  // uint32_t - QUIC_TRACE_CLASS flags
 
 //
 // The different private parameters for QUIC_PARAM_LEVEL_SESSION.
@@ -52,6 +162,19 @@ typedef struct QUIC_PRIVATE_TRANSPORT_PARAMETER {
 #define QUIC_PARAM_CONN_FORCE_CID_UPDATE                0x80000003  // No payload
 #define QUIC_PARAM_CONN_TEST_TRANSPORT_PARAMETER        0x80000004  // QUIC_PRIVATE_TRANSPORT_PARAMETER
 
+//
+// The different private parameters for QUIC_PARAM_LEVEL_STREAM.
+//
+
+//
+// App opt-in: in-order stream data may be indicated directly out of the
+// decrypted packet buffer, skipping the copy into the stream's receive
+// buffer. The indicated buffers are only valid for the duration of the
+// callback, so the app must consume the data synchronously and must not
+// return QUIC_STATUS_PENDING from those receive callbacks.
+//
+#define QUIC_PARAM_STREAM_INLINE_RECEIVES               0x80000001  // BOOLEAN
+
 #if defined(__cplusplus)
 }
 #endif
@@ -272,6 +272,29 @@ QuicEncrypt(
         uint8_t* Buffer
     );
 
+//
+// Encrypts a batch of packet buffers with the same key. Each buffer starts
+// with 'HeaderLengths[i]' bytes of header, used as the authenticated data,
+// immediately followed by 'PayloadLengths[i]' bytes of payload, which
+// includes the preallocated space for the overhead, just like QuicEncrypt.
+// The IVs are passed as a single contiguous buffer, QUIC_IV_LENGTH bytes per
+// packet. Implementations may pipeline the AEAD across the batch.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QuicEncryptBatch(
+    _In_ QUIC_KEY* Key,
+    _In_ uint8_t BatchSize,
+    _In_reads_bytes_(BatchSize * QUIC_IV_LENGTH)
+        const uint8_t* const Ivs,
+    _In_reads_(BatchSize)
+        const uint16_t* const HeaderLengths,
+    _In_reads_(BatchSize)
+        const uint16_t* const PayloadLengths,
+    _In_reads_(BatchSize)
+        uint8_t* const* const Buffers
+    );
+
 //
 // Decrypts buffer with the given key. 'BufferLength' is the full encrypted
 // payload length on input. On output, the length shrinks by
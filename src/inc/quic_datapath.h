@@ -57,6 +57,19 @@ extern "C" {
 //
 #define MAX_UDP_PAYLOAD_LENGTH (QUIC_MAX_MTU - QUIC_MIN_IPV4_HEADER_SIZE - QUIC_UDP_HEADER_SIZE)
 
+//
+// The maximum IP MTU supported on networks with jumbo frame support.
+// Datapaths that can send payloads this large advertise
+// QUIC_DATAPATH_FEATURE_JUMBO_SEND.
+//
+#define QUIC_MAX_JUMBO_MTU 9216
+
+//
+// The buffer size that must be allocated to fit the maximum jumbo frame UDP
+// payload.
+//
+#define MAX_JUMBO_UDP_PAYLOAD_LENGTH (QUIC_MAX_JUMBO_MTU - QUIC_MIN_IPV4_HEADER_SIZE - QUIC_UDP_HEADER_SIZE)
+
 //
 // Helper function for calculating the length of a UDP packet, for a given
 // MTU, on a dual-mode socket. It uses IPv4 header size since that is the
@@ -107,6 +120,22 @@ PacketSizeFromUdpPayloadSize(
 
 typedef struct QUIC_BUFFER QUIC_BUFFER;
 
+//
+// The ECN codepoints, as encoded in the two low bits of the IPv4 TOS or IPv6
+// Traffic Class field.
+//
+typedef enum QUIC_ECN_TYPE {
+    QUIC_ECN_NON_ECT = 0x0, // Not ECN-Capable Transport
+    QUIC_ECN_ECT_1   = 0x1, // ECN Capable Transport (1)
+    QUIC_ECN_ECT_0   = 0x2, // ECN Capable Transport (0)
+    QUIC_ECN_CE      = 0x3  // Congestion Encountered
+} QUIC_ECN_TYPE;
+
+//
+// Helper to extract the ECN codepoint from the Type of Service field.
+//
+#define QUIC_ECN_FROM_TOS(ToS) (QUIC_ECN_TYPE)((ToS) & 0x3)
+
 //
 // Declaration for the DataPath context structures.
 //
@@ -149,6 +178,15 @@ typedef struct QUIC_RECV_DATAGRAM {
     _Field_size_(BufferLength)
     uint8_t * Buffer;
 
+    //
+    // The time the datagram was received, in the QuicTimeUs64 time domain.
+    // When the platform supports receive timestamping this is the kernel's
+    // receive time, which excludes the wakeup and queue delay between the
+    // datagram arriving and the datapath dequeuing it; otherwise it is the
+    // time the datapath dequeued the datagram. Zero if unknown.
+    //
+    uint64_t RecvTimeUs;
+
     //
     // Length of the valid data in Buffer.
     //
@@ -159,6 +197,13 @@ typedef struct QUIC_RECV_DATAGRAM {
     //
     uint8_t PartitionIndex;
 
+    //
+    // The Type of Service (IPv4) or Traffic Class (IPv6) field of the IP
+    // header of the received datagram. The low two bits are the ECN
+    // codepoint.
+    //
+    uint8_t TypeOfService;
+
     //
     // Flags.
     //
@@ -256,9 +301,59 @@ QuicDataPathUninitialize(
     _In_ QUIC_DATAPATH* Datapath
     );
 
+//
+// Tells the datapath where the partition bits live in the connection IDs
+// MsQuic generates, so receive steering (where supported) can deliver each
+// datagram directly to the processor that owns the connection. The offset is
+// from the start of the UDP payload of a short header packet. An offset of
+// zero disables CID based steering.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetPartitionInfo(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ uint8_t CidPartitionByteOffset,
+    _In_ uint8_t CidPartitionMask
+    );
+
+//
+// Enables or disables deferred sends. When enabled, datapaths that perform
+// the socket syscall inline instead queue the batch to the datapath thread,
+// so the caller can start encrypting its next batch while the previous one
+// is written to the socket. Ignored by datapaths whose sends are already
+// asynchronous.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetDeferredSends(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ BOOLEAN Enabled
+    );
+
+//
+// Applies an explicit processor placement policy to the per-processor
+// datapath threads: thread N is re-affinitized (hard) to entry N of the
+// processor list, wrapping if the list is shorter than the thread count.
+// When busy polling is enabled, the threads additionally poll for work
+// instead of blocking in the kernel, trading a fully spent core for wake
+// latency; only sensible on isolated cores dedicated to packet processing.
+// A NULL list leaves the default one-thread-per-processor placement alone.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetProcessorConfig(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_reads_opt_(ProcessorListLength) const uint16_t* ProcessorList,
+    _In_ uint32_t ProcessorListLength,
+    _In_ BOOLEAN BusyPoll
+    );
+
 #define QUIC_DATAPATH_FEATURE_RECV_SIDE_SCALING     0x0001
 #define QUIC_DATAPATH_FEATURE_RECV_COALESCING       0x0002
 #define QUIC_DATAPATH_FEATURE_SEND_SEGMENTATION     0x0004
+#define QUIC_DATAPATH_FEATURE_JUMBO_SEND            0x0008
+#define QUIC_DATAPATH_FEATURE_SEND_ZERO_COPY        0x0010
+#define QUIC_DATAPATH_FEATURE_RIO                   0x0020
 
 //
 // Queries the currently supported features of the datapath.
@@ -352,7 +447,9 @@ QuicDataPathBindingGetRemoteAddress(
 
 //
 // Called to return a chain of datagrams received from the registered receive
-// callback.
+// callback. The chain may mix datagrams from different bindings, so a caller
+// can coalesce the returns for everything it drained on a processor into a
+// single call.
 //
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void
@@ -360,6 +457,56 @@ QuicDataPathBindingReturnRecvDatagrams(
     _In_opt_ QUIC_RECV_DATAGRAM* DatagramChain
     );
 
+//
+// Network condition emulation parameters, for testing. When enabled on a
+// datapath, every datagram received on the socket path has the configured
+// loss, delay, jitter, reordering and bandwidth cap applied before it is
+// indicated to the client, so congestion control, pacing and loss recovery
+// changes can be validated against (e.g.) a 100ms/1Gbps path entirely
+// in-process. The behavior is deterministic for a fixed seed and arrival
+// order.
+//
+typedef struct QUIC_DATAPATH_EMULATION_CONFIG {
+    //
+    // Fixed one-way propagation delay added to each datagram, and an extra
+    // uniformly distributed random delay in [0, JitterUs].
+    //
+    uint32_t DelayUs;
+    uint32_t JitterUs;
+    //
+    // Drop (respectively, deliver late) roughly one datagram in this many.
+    // Zero disables the behavior.
+    //
+    uint32_t LossDenominator;
+    uint32_t ReorderDenominator;
+    //
+    // Serialization rate cap for the emulated link. Zero means unlimited.
+    //
+    uint64_t BandwidthKbps;
+    //
+    // Seed for the deterministic pseudo-random generator.
+    //
+    uint32_t RandomSeed;
+    //
+    // When non-zero (host order), only datagrams received on a binding bound
+    // to this local port are shaped, which allows different conditions per
+    // direction between two in-process endpoints.
+    //
+    uint16_t LocalPort;
+} QUIC_DATAPATH_EMULATION_CONFIG;
+
+//
+// Enables (or, with a NULL config, disables) network condition emulation on
+// the datapath. Must be called while no datagrams are in flight. Not
+// supported by every platform or datapath backend.
+//
+_IRQL_requires_max_(PASSIVE_LEVEL)
+QUIC_STATUS
+QuicDataPathSetEmulation(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_opt_ const QUIC_DATAPATH_EMULATION_CONFIG* Config
+    );
+
 //
 // Allocates a new send context to be used to call QuicDataPathBindingSendTo. It
 // can be freed with QuicDataPathBindingFreeSendContext too.
@@ -382,6 +529,17 @@ QuicDataPathBindingFreeSendContext(
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
+//
+// Sets the ECN codepoint to mark every datagram in the send context with.
+// Defaults to QUIC_ECN_NON_ECT (i.e. no marking).
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicDataPathBindingSetEcnCodePoint(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext,
+    _In_ QUIC_ECN_TYPE EcnCodePoint
+    );
+
 //
 // Allocates a new UDP datagram buffer for sending.
 //
@@ -425,6 +583,26 @@ QuicDataPathBindingSendTo(
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
+//
+// Caches the preformatted, platform specific send headers (mapped remote
+// socket address and local address control message) for a single network
+// path. The contents are opaque to the caller, who just embeds the storage
+// in its per-path state, zeroes it to invalidate (i.e. whenever either
+// address changes) and passes it on every send for that path. The datapath
+// formats the headers on the first send and reuses them on the rest. The
+// caller must serialize sends that share a cache.
+//
+typedef struct QUIC_DATAPATH_SEND_CACHE {
+
+    BOOLEAN IsPrepared;
+
+    //
+    // Opaque, 8-byte aligned storage for the platform specific headers.
+    //
+    uint64_t Storage[12];
+
+} QUIC_DATAPATH_SEND_CACHE;
+
 //
 // Sends data to a remote host. Note, the buffer must remain valid for
 // the duration of the send operation.
@@ -435,6 +613,7 @@ QuicDataPathBindingSendFromTo(
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const QUIC_ADDR * LocalAddress,
     _In_ const QUIC_ADDR * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
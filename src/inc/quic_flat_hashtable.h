@@ -0,0 +1,206 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    An open-addressing variant of QUIC_HASHTABLE for hot lookup paths.
+
+    Where QUIC_HASHTABLE chains intrusive entries off its buckets, and thus
+    pays a dependent cache miss for every entry walked, this table stores
+    opaque entry pointers directly in flat arrays of 8-way buckets. Each
+    bucket's eight one-byte tags are packed into a single word, so a probe
+    compares all eight slots with one word-sized XOR and only dereferences
+    the entry array for slots whose tag matches. A successful lookup
+    typically touches one tag word and one entry pointer.
+
+    Unlike QUIC_HASHTABLE, entries are not intrusive: the caller inserts an
+    opaque pointer with a 64-bit signature and passes the same pointer and
+    signature to remove it. Duplicate signatures are supported; a lookup
+    returns each entry with a matching signature in turn via the lookup
+    context, and the caller disambiguates. Insertion may fail, because the
+    table resizes by reallocation when it fills up.
+
+    Like QUIC_HASHTABLE, locking is entirely the caller's responsibility.
+    Entries may be removed during an enumeration, but not inserted, as an
+    insertion may resize the table out from under the enumerator.
+
+Usage examples:
+
+    BOOLEAN
+    ExampleInsert(
+        QUIC_FLAT_HASHTABLE* Table,
+        PEXAMPLE_OBJECT Obj
+        )
+    {
+        return
+            QuicFlatHashtableInsert(
+                Table, Obj, ExampleAttribHash(Obj->Attrib));
+    }
+
+    void
+    ExampleRemove(
+        QUIC_FLAT_HASHTABLE* Table,
+        PEXAMPLE_OBJECT Obj
+        )
+    {
+        QuicFlatHashtableRemove(Table, Obj, ExampleAttribHash(Obj->Attrib));
+    }
+
+    PEXAMPLE_OBJECT
+    ExampleLookup(
+        QUIC_FLAT_HASHTABLE* Table,
+        EXAMPLE_OBJECT_ATTRIBUTE Attrib
+        )
+    {
+        QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT Context;
+        PEXAMPLE_OBJECT Obj =
+            QuicFlatHashtableLookup(
+                Table, ExampleAttribHash(Attrib), &Context);
+        while (Obj != NULL) {
+            if (Obj->Attrib == Attrib) {
+                return Obj;
+            }
+            Obj = QuicFlatHashtableLookupNext(Table, &Context);
+        }
+        return NULL;
+    }
+
+--*/
+
+#pragma once
+
+#ifndef QUIC_FLAT_HASHTABLE_
+#define QUIC_FLAT_HASHTABLE_
+
+#define QUIC_FLAT_HASH_ALLOCATED_HEADER 0x00000001
+
+//
+// The number of entry slots in each bucket. The slot tags of a bucket are
+// packed into one uint64_t so all eight can be probed with a single word
+// comparison.
+//
+#define QUIC_FLAT_HASH_BUCKET_SLOTS 8
+
+typedef struct QUIC_FLAT_HASHTABLE {
+
+    // Entries initialized at creation
+    uint32_t Flags;
+
+    // Entries used in bucket computation. Always a power of two.
+    uint32_t BucketCount;
+
+    // Counters
+    uint32_t NumEntries;
+    uint32_t NumTombstones;
+
+    //
+    // For internal use only. All three arrays live in the single allocation
+    // anchored at Tags. Tags holds one word of eight slot tags per bucket;
+    // Signatures and Entries hold the caller's signature and pointer for
+    // each slot, indexed by (Bucket * QUIC_FLAT_HASH_BUCKET_SLOTS + Slot).
+    //
+    uint64_t* Tags;
+    uint64_t* Signatures;
+    void** Entries;
+
+} QUIC_FLAT_HASHTABLE;
+
+typedef struct QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT {
+    //
+    // The signature being looked up, the bucket currently being probed, the
+    // tag matches not yet returned from that bucket, and the tag derived
+    // from the signature. Together these let QuicFlatHashtableLookupNext
+    // resume the probe where the previous lookup left off.
+    //
+    uint64_t Signature;
+    uint64_t Hits;
+    uint32_t Bucket;
+    uint8_t Tag;
+} QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT;
+
+typedef struct QUIC_FLAT_HASHTABLE_ENUMERATOR {
+    uint32_t Index; // Next slot to examine.
+} QUIC_FLAT_HASHTABLE_ENUMERATOR;
+
+_Must_inspect_result_
+_Success_(return != FALSE)
+BOOLEAN
+QuicFlatHashtableInitialize(
+    _Inout_ _When_(NULL == *HashTable, _At_(*HashTable, __drv_allocatesMem(Mem) _Post_notnull_))
+        QUIC_FLAT_HASHTABLE** HashTable,
+    _In_ uint32_t InitialSize
+    );
+
+inline
+_Must_inspect_result_
+_Success_(return != FALSE)
+BOOLEAN
+QuicFlatHashtableInitializeEx(
+    _Inout_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint32_t InitialSize
+    )
+{
+    return QuicFlatHashtableInitialize(&HashTable, InitialSize);
+}
+
+void
+QuicFlatHashtableUninitialize(
+    _In_
+    _When_((HashTable->Flags & QUIC_FLAT_HASH_ALLOCATED_HEADER), __drv_freesMem(Mem) _Post_invalid_)
+    _At_(HashTable->Tags, __drv_freesMem(Mem) _Post_invalid_)
+        QUIC_FLAT_HASHTABLE* HashTable
+    );
+
+_Must_inspect_result_
+_Success_(return != FALSE)
+BOOLEAN
+QuicFlatHashtableInsert(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ __drv_aliasesMem void* Entry,
+    _In_ uint64_t Signature
+    );
+
+void
+QuicFlatHashtableRemove(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ void* Entry,
+    _In_ uint64_t Signature
+    );
+
+_Must_inspect_result_
+void*
+QuicFlatHashtableLookup(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint64_t Signature,
+    _Out_ QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT* Context
+    );
+
+_Must_inspect_result_
+void*
+QuicFlatHashtableLookupNext(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Inout_ QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT* Context
+    );
+
+void
+QuicFlatHashtableEnumerateBegin(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Out_ QUIC_FLAT_HASHTABLE_ENUMERATOR* Enumerator
+    );
+
+_Must_inspect_result_
+void*
+QuicFlatHashtableEnumerateNext(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Inout_ QUIC_FLAT_HASHTABLE_ENUMERATOR* Enumerator
+    );
+
+void
+QuicFlatHashtableEnumerateEnd(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Inout_ QUIC_FLAT_HASHTABLE_ENUMERATOR* Enumerator
+    );
+
+#endif // QUIC_FLAT_HASHTABLE_
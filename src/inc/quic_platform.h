@@ -233,6 +233,7 @@ QuicListPopEntry(
 }
 
 #include "quic_hashtable.h"
+#include "quic_flat_hashtable.h"
 #include "quic_toeplitz.h"
 
 #endif // QUIC_PLATFORM_
@@ -169,6 +169,13 @@ void
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
+typedef
+void
+(*QUIC_DATAPATH_BINDING_SET_ECN_CODE_POINT)(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext,
+    _In_ QUIC_ECN_TYPE EcnCodePoint
+    );
+
 typedef
 QUIC_BUFFER*
 (*QUIC_DATAPATH_BINDING_ALLOC_SEND_BUFFER)(
@@ -203,6 +210,7 @@ QUIC_STATUS
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const QUIC_ADDR * LocalAddress,
     _In_ const QUIC_ADDR * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
@@ -258,6 +266,7 @@ typedef struct QUIC_PLATFORM_DISPATCH {
     QUIC_DATAPATH_BINDING_RETURN_RECV_BUFFER DatapathBindingReturnRecvPacket;
     QUIC_DATAPATH_BINDING_ALLOC_SEND_CONTEXT DatapathBindingAllocSendContext;
     QUIC_DATAPATH_BINDING_FREE_SEND_CONTEXT DatapathBindingFreeSendContext;
+    QUIC_DATAPATH_BINDING_SET_ECN_CODE_POINT DatapathBindingSetEcnCodePoint;
     QUIC_DATAPATH_BINDING_IS_SEND_CONTEXT_FULL DatapathBindingIsSendContextFull;
     QUIC_DATAPATH_BINDING_ALLOC_SEND_BUFFER DatapathBindingAllocSendBuffer;
     QUIC_DATAPATH_BINDING_FREE_SEND_BUFFER DatapathBindingFreeSendBuffer;
@@ -128,6 +128,27 @@ InterlockedDecrement(
     return __sync_sub_and_fetch(Addend, (long)1);
 }
 
+inline
+long
+InterlockedExchange(
+    _Inout_ _Interlocked_operand_ long volatile *Target,
+    _In_ long Value
+    )
+{
+    return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+inline
+long
+InterlockedCompareExchange(
+    _Inout_ _Interlocked_operand_ long volatile *Destination,
+    _In_ long ExChange,
+    _In_ long Comperand
+    )
+{
+    return __sync_val_compare_and_swap(Destination, Comperand, ExChange);
+}
+
 inline
 int64_t
 InterlockedExchangeAdd64(
@@ -176,6 +197,27 @@ InterlockedIncrement64(
     return __sync_add_and_fetch(Addend, (int64_t)1);
 }
 
+inline
+void*
+InterlockedExchangePointer(
+    _Inout_ _Interlocked_operand_ void* volatile *Target,
+    _In_opt_ void* Value
+    )
+{
+    return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+inline
+void*
+InterlockedCompareExchangePointer(
+    _Inout_ _Interlocked_operand_ void* volatile *Destination,
+    _In_opt_ void* ExChange,
+    _In_opt_ void* Comperand
+    )
+{
+    return __sync_val_compare_and_swap(Destination, Comperand, ExChange);
+}
+
 //
 // String utils.
 //
@@ -247,6 +289,37 @@ QuicPlatformLogAssert(
 
 extern uint64_t QuicTotalMemory;
 
+//
+// The total number of allocations made via QuicAlloc since the platform was
+// initialized. Useful for measuring the allocation cost of an operation.
+//
+extern int64_t QuicTotalAllocCount;
+
+//
+// Optional allocation site tracking. While enabled, QuicAlloc attributes each
+// allocation to its caller's return address in a small fixed-size table, so a
+// test asserting an allocation budget (e.g. per accepted connection) can
+// report which call sites are responsible when the budget is exceeded.
+//
+
+typedef struct QUIC_ALLOC_SITE {
+    void* Caller;       // Return address of the QuicAlloc call.
+    int64_t Count;      // Allocations attributed to the site.
+} QUIC_ALLOC_SITE;
+
+#define QUIC_ALLOC_SITE_TABLE_SIZE 256
+
+void
+QuicAllocSiteTrackingEnable(
+    _In_ BOOLEAN Enable
+    );
+
+uint32_t
+QuicAllocSiteTrackingSnapshot(
+    _Out_writes_to_(SitesCount, return) QUIC_ALLOC_SITE* Sites,
+    _In_ uint32_t SitesCount
+    );
+
 _Ret_maybenull_
 void*
 QuicAlloc(
@@ -266,23 +339,60 @@ QuicFree(
 // Represents a QUIC memory pool used for fixed sized allocations.
 //
 
+//
+// Number of entries cached in each per-processor magazine.
+//
+
+#define QUIC_POOL_MAGAZINE_CAPACITY 16
+
+//
+// A per-processor cache of free entries. A thread claims the magazine of the
+// processor it is currently running on with an interlocked flag; if the
+// magazine is busy (the thread migrated mid-operation, or another thread on
+// the same processor holds it) the operation falls through to the shared
+// depot. Padded to a cache line so magazines don't false share.
+//
+
+typedef struct QUIC_POOL_MAGAZINE {
+
+    //
+    // Claim flag. Nonzero while a thread is operating on this magazine.
+    //
+
+    long volatile Owned;
+
+    //
+    // Number of cached entries.
+    //
+
+    uint16_t Count;
+
+    //
+    // The cached entries.
+    //
+
+    void* Entries[QUIC_POOL_MAGAZINE_CAPACITY];
+
+} __attribute__((aligned(64))) QUIC_POOL_MAGAZINE;
+
 typedef struct QUIC_POOL {
 
     //
-    // List of free entries.
+    // Depot list of free entries, shared by all processors.
     //
 
     QUIC_SINGLE_LIST_ENTRY ListHead;
 
     //
-    // Number of free entries in the list.
+    // Number of free entries in the depot list.
     //
 
     uint16_t ListDepth;
 
     //
-    // Lock to synchronize access to the List.
-    // LINUX_TODO: Check how to make this lock free?
+    // Lock to synchronize access to the depot list. Only taken when a
+    // magazine is exhausted or full, so roughly once per
+    // QUIC_POOL_MAGAZINE_CAPACITY operations per processor.
     //
 
     pthread_mutex_t Lock;
@@ -299,6 +409,14 @@ typedef struct QUIC_POOL {
 
     uint32_t MemTag;
 
+    //
+    // Per-processor magazines, QuicProcMaxCount() of them. May be NULL if
+    // the allocation failed at initialization, in which case all operations
+    // go to the depot.
+    //
+
+    QUIC_POOL_MAGAZINE* Magazines;
+
 } QUIC_POOL;
 
 #define QUIC_POOL_MAXIMUM_DEPTH   256 // Copied from EX_MAXIMUM_LOOKASIDE_DEPTH_BASE
@@ -326,6 +444,16 @@ QuicPoolFree(
     _In_ void* Entry
     );
 
+//
+// Releases the pool's shared depot of cached free entries back to the
+// allocator. Used under memory pressure. The per-processor magazines are
+// left alone.
+//
+void
+QuicPoolTrim(
+    _Inout_ QUIC_POOL* Pool
+    );
+
 #define QuicZeroMemory(Destination, Length) memset((Destination), 0, (Length))
 #define QuicCopyMemory(Destination, Source, Length) memcpy((Destination), (Source), (Length))
 #define QuicMoveMemory(Destination, Source, Length) memmove((Destination), (Source), (Length))
@@ -335,6 +463,12 @@ QuicPoolFree(
 #define QuicByteSwapUint32(value) __builtin_bswap32((value))
 #define QuicByteSwapUint64(value) __builtin_bswap64((value))
 
+//
+// Hints to the processor that the memory at the address is about to be read,
+// so the load can start before the data is actually needed.
+//
+#define QuicPrefetchForRead(Address) __builtin_prefetch((Address), 0)
+
 //
 // Lock interfaces.
 //
@@ -544,6 +678,18 @@ QuicGetAbsoluteTime(
 #define QuicTimeMs32() (uint32_t)QuicTimeMs64()
 #define QuicTimeUs64ToPlat(x) (x)
 
+//
+// Raw CPU cycle counter for profiling short code sequences. Not synchronized
+// across cores, so only differences taken on the same thread are meaningful.
+// Falls back to the microsecond clock where no cheap cycle counter exists.
+//
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QuicCpuCycles() __rdtsc()
+#else
+#define QuicCpuCycles() QuicTimeUs64()
+#endif
+
 inline
 int64_t
 QuicTimeEpochMs64(
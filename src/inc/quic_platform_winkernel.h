@@ -255,10 +255,45 @@ QuicPlatformLogAssert(
 
 extern uint64_t QuicTotalMemory;
 
+//
+// The total number of pool allocations made since the platform was
+// initialized. Useful for measuring the allocation cost of an operation.
+//
+extern int64_t QuicTotalAllocCount;
+
+//
+// Allocation site tracking is not available in kernel mode, where the
+// allocation macros expand directly to pool calls and there is no common
+// function to hook. The stubs keep shared test code building; the snapshot
+// always reports zero sites.
+//
+
+typedef struct QUIC_ALLOC_SITE {
+    void* Caller;
+    int64_t Count;
+} QUIC_ALLOC_SITE;
+
+#define QUIC_ALLOC_SITE_TABLE_SIZE 256
+
+void
+QuicAllocSiteTrackingEnable(
+    _In_ BOOLEAN Enable
+    );
+
+uint32_t
+QuicAllocSiteTrackingSnapshot(
+    _Out_writes_to_(SitesCount, return) QUIC_ALLOC_SITE* Sites,
+    _In_ uint32_t SitesCount
+    );
+
 #define QUIC_POOL_TAG 'CIUQ'
 
-#define QUIC_ALLOC_PAGED(Size) ExAllocatePoolWithTag(PagedPool, Size, QUIC_POOL_TAG)
-#define QUIC_ALLOC_NONPAGED(Size) ExAllocatePoolWithTag(NonPagedPoolNx, Size, QUIC_POOL_TAG)
+#define QUIC_ALLOC_PAGED(Size) \
+    (InterlockedIncrement64(&QuicTotalAllocCount), \
+     ExAllocatePoolWithTag(PagedPool, Size, QUIC_POOL_TAG))
+#define QUIC_ALLOC_NONPAGED(Size) \
+    (InterlockedIncrement64(&QuicTotalAllocCount), \
+     ExAllocatePoolWithTag(NonPagedPoolNx, Size, QUIC_POOL_TAG))
 #define QUIC_FREE(Mem) ExFreePoolWithTag((void*)Mem, QUIC_POOL_TAG)
 
 typedef LOOKASIDE_LIST_EX QUIC_POOL;
@@ -277,6 +312,7 @@ typedef LOOKASIDE_LIST_EX QUIC_POOL;
 #define QuicPoolUninitialize(Pool) ExDeleteLookasideListEx(Pool)
 #define QuicPoolAlloc(Pool) ExAllocateFromLookasideListEx(Pool)
 #define QuicPoolFree(Pool, Entry) ExFreeToLookasideListEx(Pool, Entry)
+#define QuicPoolTrim(Pool) UNREFERENCED_PARAMETER(Pool) // Lookasides trim themselves.
 
 #define QuicZeroMemory RtlZeroMemory
 #define QuicCopyMemory RtlCopyMemory
@@ -287,6 +323,13 @@ typedef LOOKASIDE_LIST_EX QUIC_POOL;
 #define QuicByteSwapUint32 RtlUlongByteSwap
 #define QuicByteSwapUint64 RtlUlonglongByteSwap
 
+//
+// Hints to the processor that the memory at the address is about to be read,
+// so the load can start before the data is actually needed.
+//
+#define QuicPrefetchForRead(Address) \
+    PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, (Address))
+
 //
 // Locking Interfaces
 //
@@ -599,6 +642,17 @@ QuicTimeUs64ToPlat(
 #define QuicTimeMs64() US_TO_MS(QuicTimeUs64())
 #define QuicTimeMs32() (uint32_t)QuicTimeMs64()
 
+//
+// Raw CPU cycle counter for profiling short code sequences. Not synchronized
+// across cores, so only differences taken on the same thread are meaningful.
+// Falls back to the performance counter where no cheap cycle counter exists.
+//
+#if defined(_M_X64) || defined(_M_IX86)
+#define QuicCpuCycles() __rdtsc()
+#else
+#define QuicCpuCycles() QuicTimePlat()
+#endif
+
 #define UNIX_EPOCH_AS_FILE_TIME 0x19db1ded53e8000ll
 
 inline
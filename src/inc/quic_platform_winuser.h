@@ -236,6 +236,37 @@ QuicPlatformLogAssert(
 
 extern uint64_t QuicTotalMemory;
 
+//
+// The total number of allocations made via QuicAlloc since the platform was
+// initialized. Useful for measuring the allocation cost of an operation.
+//
+extern int64_t QuicTotalAllocCount;
+
+//
+// Optional allocation site tracking. While enabled, QuicAlloc attributes each
+// allocation to its caller's return address in a small fixed-size table, so a
+// test asserting an allocation budget (e.g. per accepted connection) can
+// report which call sites are responsible when the budget is exceeded.
+//
+
+typedef struct QUIC_ALLOC_SITE {
+    void* Caller;       // Return address of the QuicAlloc call.
+    int64_t Count;      // Allocations attributed to the site.
+} QUIC_ALLOC_SITE;
+
+#define QUIC_ALLOC_SITE_TABLE_SIZE 256
+
+void
+QuicAllocSiteTrackingEnable(
+    _In_ BOOLEAN Enable
+    );
+
+uint32_t
+QuicAllocSiteTrackingSnapshot(
+    _Out_writes_to_(SitesCount, return) QUIC_ALLOC_SITE* Sites,
+    _In_ uint32_t SitesCount
+    );
+
 _Ret_maybenull_
 _Post_writable_byte_size_(ByteCount)
 DECLSPEC_ALLOCATOR
@@ -342,6 +373,22 @@ QuicPoolFree(
 #endif
 }
 
+//
+// Releases the pool's cached free entries back to the allocator. Used under
+// memory pressure.
+//
+inline
+void
+QuicPoolTrim(
+    _Inout_ QUIC_POOL* Pool
+    )
+{
+    void* Entry;
+    while ((Entry = InterlockedPopEntrySList(&Pool->ListHead)) != NULL) {
+        QuicFree(Entry);
+    }
+}
+
 #define QuicZeroMemory RtlZeroMemory
 #define QuicCopyMemory RtlCopyMemory
 #define QuicMoveMemory RtlMoveMemory
@@ -351,6 +398,13 @@ QuicPoolFree(
 #define QuicByteSwapUint32 _byteswap_ulong
 #define QuicByteSwapUint64 _byteswap_uint64
 
+//
+// Hints to the processor that the memory at the address is about to be read,
+// so the load can start before the data is actually needed.
+//
+#define QuicPrefetchForRead(Address) \
+    PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, (Address))
+
 //
 // Locking Interfaces
 //
@@ -615,6 +669,17 @@ QuicTimeUs64ToPlat(
 #define QuicTimeMs64() US_TO_MS(QuicTimeUs64())
 #define QuicTimeMs32() (uint32_t)QuicTimeMs64()
 
+//
+// Raw CPU cycle counter for profiling short code sequences. Not synchronized
+// across cores, so only differences taken on the same thread are meaningful.
+// Falls back to the performance counter where no cheap cycle counter exists.
+//
+#if defined(_M_X64) || defined(_M_IX86)
+#define QuicCpuCycles() __rdtsc()
+#else
+#define QuicCpuCycles() QuicTimePlat()
+#endif
+
 #define UNIX_EPOCH_AS_FILE_TIME 0x19db1ded53e8000ll
 
 inline
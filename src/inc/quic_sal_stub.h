@@ -70,6 +70,10 @@
 #define _Field_size_bytes_opt_(...)
 #endif
 
+#ifndef _Field_size_opt_
+#define _Field_size_opt_(...)
+#endif
+
 #ifndef _In_reads_
 #define _In_reads_(...)
 #endif
@@ -138,6 +142,10 @@
 #define _Outptr_result_buffer_maybenull_(...)
 #endif
 
+#ifndef _Inout_updates_opt_
+#define _Inout_updates_opt_(...)
+#endif
+
 #ifndef _Inout_updates_bytes_
 #define _Inout_updates_bytes_(...)
 #endif
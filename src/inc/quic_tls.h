@@ -33,6 +33,22 @@ typedef struct QUIC_TLS QUIC_TLS;
 //
 extern uint16_t QuicTlsTPHeaderSize;
 
+//
+// The short name of the TLS provider compiled into this binary, readable via
+// QUIC_PARAM_GLOBAL_TLS_PROVIDER_NAME so deployments can tell apart binaries
+// built against different TLS stacks.
+//
+extern const char* const QuicTlsLibraryName;
+
+//
+// TRUE if QuicTlsProcessData accepts partially received TLS messages,
+// buffering them and hashing the transcript incrementally. When set, the
+// core hands CRYPTO data to TLS as it arrives instead of waiting for
+// complete messages, overlapping hash/HKDF work with the network wait for
+// the rest of the flight.
+//
+extern const BOOLEAN QuicTlsSupportsPartialInput;
+
 //
 // Callback for indicating process can be completed.
 //
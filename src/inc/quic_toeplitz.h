@@ -7,9 +7,6 @@
 
 #pragma once
 
-#define NIBBLES_PER_BYTE    2
-#define BITS_PER_NIBBLE     4
-
 //
 // The size (in bytes) of the input.
 
@@ -30,14 +27,15 @@
 #define QUIC_TOEPLITZ_KEY_SIZE              (QUIC_TOEPLITZ_INPUT_SIZE + QUIC_TOEPLITZ_OUPUT_SIZE)
 
 //
-// Fixed lookup table size.
+// Fixed lookup table size. One entry for every possible value of a hash input
+// byte.
 //
-#define QUIC_TOEPLITZ_LOOKUP_TABLE_SIZE     16
+#define QUIC_TOEPLITZ_LOOKUP_TABLE_SIZE     256
 
 //
-// Fixed number of lookup tables.
+// Fixed number of lookup tables. One for every hash input byte position.
 //
-#define QUIC_TOEPLITZ_LOOKUP_TABLE_COUNT    (QUIC_TOEPLITZ_INPUT_SIZE * NIBBLES_PER_BYTE)
+#define QUIC_TOEPLITZ_LOOKUP_TABLE_COUNT    QUIC_TOEPLITZ_INPUT_SIZE
 
 typedef struct QUIC_TOEPLITZ_LOOKUP_TABLE {
     uint32_t Table[QUIC_TOEPLITZ_LOOKUP_TABLE_SIZE];
@@ -92,7 +92,12 @@ typedef enum QUIC_TRACE_API_TYPE {
     QUIC_TRACE_API_STREAM_SHUTDOWN,
     QUIC_TRACE_API_STREAM_SEND,
     QUIC_TRACE_API_STREAM_RECEIVE_COMPLETE,
-    QUIC_TRACE_API_STREAM_RECEIVE_SET_ENABLED
+    QUIC_TRACE_API_STREAM_RECEIVE_SET_ENABLED,
+    QUIC_TRACE_API_DATAGRAM_SEND,
+    QUIC_TRACE_API_CONNECTION_BATCH_BEGIN,
+    QUIC_TRACE_API_CONNECTION_BATCH_COMMIT,
+    QUIC_TRACE_API_CONNECTION_POOL_GET,
+    QUIC_TRACE_API_SESSION_DRAIN
 } QUIC_TRACE_API_TYPE;
 
 typedef enum QUIC_TRACE_LEVEL {
@@ -119,6 +124,26 @@ QuicTraceRundown(
     void
     );
 
+//
+// Class-gated variants of the per-connection log macros. The class mask is
+// cached on the connection (from the registration's QUIC_TRACE_CLASS_* flags,
+// see msquicp.h), so the gate is a single branch on a word the packet paths
+// already have in cache. This allows individual classes (e.g. loss events) to
+// stay enabled in production while the chatty per-packet classes stay off.
+// Warnings and errors are never gated.
+//
+#define QuicTraceClassEnabled(Mask, Class) (((Mask) & (Class)) != 0)
+
+#define QuicTraceLogConnInfoClass(Class, Name, Ptr, Fmt, ...) \
+    if (QuicTraceClassEnabled((Ptr)->TraceClassMask, Class)) { \
+        QuicTraceLogConnInfo(Name, Ptr, Fmt, ##__VA_ARGS__); \
+    }
+
+#define QuicTraceLogConnVerboseClass(Class, Name, Ptr, Fmt, ...) \
+    if (QuicTraceClassEnabled((Ptr)->TraceClassMask, Class)) { \
+        QuicTraceLogConnVerbose(Name, Ptr, Fmt, ##__VA_ARGS__); \
+    }
+
 #ifdef QUIC_EVENTS_STUB
 
 #define QuicTraceEventEnabled(Name) FALSE
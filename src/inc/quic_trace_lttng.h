@@ -590,6 +590,20 @@ QUIC_TRACE_EVENT(ConnCubic,
         ctf_integer(uint32_t, arg5, arg5)
         ctf_integer(uint32_t, arg6, arg6))
 )
+QUIC_TRACE_EVENT(ConnBbr,
+    TP_ARGS(
+        const void*, Connection,
+        uint32_t, arg3,
+        uint64_t, arg4,
+        uint64_t, arg5,
+        uint32_t, arg6),
+    TP_FIELDS(
+        ctf_integer_hex(uint64_t, Connection, Connection)
+        ctf_integer(uint32_t, arg3, arg3)
+        ctf_integer(uint64_t, arg4, arg4)
+        ctf_integer(uint64_t, arg5, arg5)
+        ctf_integer(uint32_t, arg6, arg6))
+)
 QUIC_TRACE_EVENT(ConnCongestion,
     TP_ARGS(
         const void*, Connection),
@@ -146,3 +146,42 @@ QuicVarIntDecode(
     }
     return TRUE;
 }
+
+//
+// Branchless variant of QuicVarIntDecode for hot parsing paths. When at least
+// 8 bytes remain it loads them all at once and extracts the value with shifts
+// and masks, so the (unpredictable) encoded length doesn't cost a branch miss
+// per field. Near the end of the buffer it falls back to the bounds-checked
+// decoder above; that branch depends only on the remaining buffer length, so
+// it predicts well.
+//
+inline
+_Success_(return != FALSE)
+BOOLEAN
+QuicVarIntDecodeFast(
+    _In_ uint16_t BufferLength,
+    _In_reads_bytes_(BufferLength)
+        const uint8_t * const Buffer,
+    _Inout_
+    _Deref_in_range_(0, BufferLength)
+    _Deref_out_range_(0, BufferLength)
+        uint16_t* Offset,
+    _Out_ QUIC_VAR_INT* Value
+    )
+{
+    if (BufferLength < sizeof(uint64_t) + *Offset) {
+        return QuicVarIntDecode(BufferLength, Buffer, Offset, Value);
+    }
+    uint64_t v;
+    memcpy(&v, Buffer + *Offset, sizeof(uint64_t));
+    v = QuicByteSwapUint64(v);
+    //
+    // The top two bits of the first byte encode the length (1, 2, 4 or 8
+    // bytes). The value is the first 'Length' bytes of the big-endian load,
+    // minus those two bits, right-aligned.
+    //
+    uint16_t Length = (uint16_t)(1 << (v >> 62));
+    *Value = (v & 0x3fffffffffffffffULL) >> ((sizeof(uint64_t) - Length) * 8);
+    *Offset += Length;
+    return TRUE;
+}
@@ -39,12 +39,27 @@ Abstract:
 #define QUIC_VERSION_LATEST     QUIC_VERSION_DRAFT_27
 #define QUIC_VERSION_LATEST_H   QUIC_VERSION_DRAFT_27_H
 
+//
+// The number of wire versions the library supports. Deployments that run a
+// single version fleet-wide can build with QUIC_SINGLE_VERSION defined to
+// pin support to QUIC_VERSION_LATEST only, which folds the per-packet
+// version check down to a constant compare.
+//
+#ifdef QUIC_SINGLE_VERSION
+#define QUIC_SUPPORTED_VERSION_COUNT 1
+#else
+#define QUIC_SUPPORTED_VERSION_COUNT 2
+#endif
+
 inline
 BOOLEAN
 QuicIsVersionSupported(
     _In_ uint32_t Version // Network Byte Order
     )
 {
+#ifdef QUIC_SINGLE_VERSION
+    return Version == QUIC_VERSION_VER_NEG || Version == QUIC_VERSION_LATEST;
+#else
     switch (Version) {
     case QUIC_VERSION_VER_NEG:
     case QUIC_VERSION_DRAFT_27:
@@ -53,6 +68,7 @@ QuicIsVersionSupported(
     default:
         return FALSE;
     }
+#endif
 }
 
 inline
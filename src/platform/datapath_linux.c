@@ -17,25 +17,282 @@ Environment:
 #include "platform_internal.h"
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <inttypes.h>
 #include <linux/in6.h>
 #include <arpa/inet.h>
+#include <netinet/udp.h>
+#include <linux/filter.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef __has_include
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#if __has_include(<linux/if_xdp.h>) && __has_include(<linux/bpf.h>)
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <netinet/ip6.h>
+#include <net/if.h>
+#endif
+#endif
 #include "quic_platform_dispatch.h"
 
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+#ifndef IP_RECVERR
+#define IP_RECVERR 11
+#endif
+
+#ifndef IPV6_RECVERR
+#define IPV6_RECVERR 25
+#endif
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+
+//
+// The io_uring backend is compiled in when both the kernel UAPI header and
+// the syscall numbers are available at build time. Whether it actually gets
+// used is decided at QuicDataPathInitialize time by probing the running
+// kernel; the epoll path remains the fallback for older kernels.
+//
+#if defined(IORING_OP_POLL_ADD) && \
+    defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define QUIC_DATAPATH_URING 1
+#endif
+
+//
+// The AF_XDP receive backend is compiled in when the kernel UAPI headers and
+// the bpf syscall number are available at build time. Whether it actually
+// gets used is decided at QuicDataPathInitialize time: the path is strictly
+// opt-in through environment variables, and any setup failure leaves the
+// regular socket receive path in place.
+//
+#if defined(XDP_UMEM_REG) && defined(__NR_bpf)
+#define QUIC_DATAPATH_XDP 1
+#endif
+
+#ifdef QUIC_DATAPATH_XDP
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#endif // QUIC_DATAPATH_XDP
+
 QUIC_STATIC_ASSERT((SIZEOF_STRUCT_MEMBER(QUIC_BUFFER, Length) <= sizeof(size_t)), "(sizeof(QUIC_BUFFER.Length) == sizeof(size_t) must be TRUE.");
 QUIC_STATIC_ASSERT((SIZEOF_STRUCT_MEMBER(QUIC_BUFFER, Buffer) == sizeof(void*)), "(sizeof(QUIC_BUFFER.Buffer) == sizeof(void*) must be TRUE.");
 
 //
-// TODO: Support batching.
+// The maximum number of UDP datagrams that can be sent with one call, when
+// the kernel supports UDP segmentation (generic segmentation offload). The
+// kernel caps a single segmented send at 64 segments, so stay well under
+// that.
+//
+#define QUIC_MAX_BATCH_SEND 32
+
+//
+// The maximum number of UDP datagrams that can be received with a single
+// recvmmsg call.
+//
+#define QUIC_MAX_BATCH_RECEIVE 40
+
+//
+// The minimum number of payload bytes in a single sendmsg call before the
+// zero-copy transmit path (MSG_ZEROCOPY) is used. Below this, pinning the
+// pages and processing the completion notification costs more than the copy
+// it saves.
+//
+#define QUIC_SEND_ZERO_COPY_THRESHOLD 16384
+
+//
+// When the kernel supports UDP receive coalescing (generic receive offload),
+// each message can carry up to 64 KB worth of coalesced datagrams, so far
+// fewer messages are needed per recvmmsg call.
+//
+#define QUIC_MAX_BATCH_RECEIVE_COALESCED 4
+
+//
+// The size of the receive buffer posted for a single message when receive
+// coalescing is enabled. The kernel coalesces at most 64 KB per message.
+//
+#define QUIC_COALESCED_RECV_BUFFER_LENGTH 0xFFFF
+
+//
+// The size of the per processor slab that backs normal sized receive blocks:
+// one 2 MB huge page, so all the receive buffers a processor cycles through
+// share a single dTLB entry when huge pages are available. Being one
+// physically contiguous range also makes the slab directly registrable by a
+// registered-buffer backend (io_uring fixed buffers) later.
+//
+#define QUIC_RECV_SLAB_SIZE (2 * 1024 * 1024)
+
+//
+// Blocks are carved out of the slab at this alignment so two blocks never
+// share a cache line.
+//
+#define QUIC_RECV_SLAB_BLOCK_ALIGNMENT 64
+
+#ifdef QUIC_DATAPATH_URING
+
+//
+// The number of submission queue entries in each per-processor io_uring.
+//
+#define QUIC_URING_SQ_ENTRY_COUNT 256
+
+//
+// Completions whose user data matches this value carry no context pointer
+// (e.g. poll cancelations) and are ignored by the completion loop.
+//
+#define QUIC_URING_IGNORE_USER_DATA 1
+
+//
+// A minimal io_uring wrapper, driven directly through the io_uring syscalls
+// so no external library dependency is needed. Submissions are serialized
+// with a lock because sends can be issued from arbitrary threads, while
+// completions are only ever consumed by the owning worker thread.
+//
+typedef struct QUIC_URING {
+
+    int RingFd;
+    QUIC_LOCK SqLock;
+    uint32_t SqEntryCount;
+    uint32_t* SqHead;
+    uint32_t* SqTail;
+    uint32_t SqMask;
+    uint32_t* SqArray;
+    struct io_uring_sqe* Sqes;
+    uint32_t* CqHead;
+    uint32_t* CqTail;
+    uint32_t CqMask;
+    struct io_uring_cqe* Cqes;
+    void* SqRingPtr;
+    size_t SqRingSize;
+    void* CqRingPtr;
+    size_t CqRingSize;
+    size_t SqesSize;
+
+} QUIC_URING;
+
+#endif // QUIC_DATAPATH_URING
+
+#ifdef QUIC_DATAPATH_XDP
+
+//
+// The environment variables that opt a process into the AF_XDP receive
+// path: the NIC interface to bind the XDP sockets to, and the path of a
+// pinned BPF XSKMAP that the operator's XDP redirect program looks received
+// packets up in (keyed by receive queue id). Nothing is attached to the
+// interface by this code; loading and attaching the redirect program is the
+// operator's responsibility, which keeps CAP_BPF/CAP_NET_ADMIN program
+// loading out of the library.
+//
+#define QUIC_XDP_INTERFACE_ENV "MSQUIC_XDP_INTERFACE"
+#define QUIC_XDP_XSKMAP_ENV "MSQUIC_XDP_XSKMAP"
+
+//
+// The size of a single UMEM frame. Each frame carries one full packet,
+// link and network headers included, so this covers the largest normal
+// (non-jumbo) datagram plus headers.
+//
+#define QUIC_XDP_FRAME_SIZE 2048
+
+//
+// The number of UMEM frames per queue. The fill ring is sized to match so
+// returning a frame can never find the ring full.
+//
+#define QUIC_XDP_FRAME_COUNT 4096
+
+//
+// The number of descriptors in each receive ring.
+//
+#define QUIC_XDP_RX_RING_SIZE 2048
+
+typedef struct QUIC_XSK_QUEUE QUIC_XSK_QUEUE;
+
+#endif // QUIC_DATAPATH_XDP
+
+//
+// A slab of receive block memory carved out of a single (ideally huge page
+// backed) mapping, one per processor context. Keeping a processor's receive
+// blocks at fixed offsets in one contiguous range instead of scattered heap
+// allocations means the receive path touches far fewer TLB entries.
 //
-#define QUIC_MAX_BATCH_SEND 1
+typedef struct QUIC_DATAPATH_RECV_SLAB {
+
+    //
+    // The mapped slab memory, QUIC_RECV_SLAB_SIZE bytes. NULL when the
+    // mapping failed, in which case all receive blocks come from the pool.
+    //
+    uint8_t* Memory;
+
+    //
+    // The distance between consecutive blocks in the slab: the receive block
+    // length rounded up to QUIC_RECV_SLAB_BLOCK_ALIGNMENT.
+    //
+    uint32_t BlockStride;
+
+    //
+    // Serializes the free list, since blocks are returned from whichever
+    // thread the upper layer releases its datagrams on.
+    //
+    QUIC_DISPATCH_LOCK Lock;
+
+    //
+    // The free blocks, linked through their leading bytes.
+    //
+    QUIC_SINGLE_LIST_ENTRY FreeList;
+
+} QUIC_DATAPATH_RECV_SLAB;
 
 //
 // A receive block to receive a UDP packet over the sockets.
 //
 typedef struct QUIC_DATAPATH_RECV_BLOCK {
     //
-    // The pool owning this recv block.
+    // The slab this recv block was carved from, or NULL when it came from
+    // the overflow pool instead.
+    //
+    QUIC_DATAPATH_RECV_SLAB* OwningSlab;
+
+    //
+    // The pool owning this recv block, when it did not come from the slab.
     //
     QUIC_POOL* OwningPool;
 
@@ -50,6 +307,16 @@ typedef struct QUIC_DATAPATH_RECV_BLOCK {
     //
     QUIC_TUPLE Tuple;
 
+#ifdef QUIC_DATAPATH_XDP
+    //
+    // When the packet was received on an XDP socket, the owning queue and
+    // the UMEM frame the payload lives in. The frame is handed back to the
+    // queue's fill ring when the datagram is returned; Buffer goes unused.
+    //
+    QUIC_XSK_QUEUE* XskQueue;
+    uint64_t XskFrameAddr;
+#endif
+
     //
     // Buffer that actually stores the UDP payload.
     //
@@ -92,6 +359,34 @@ typedef struct QUIC_DATAPATH_SEND_CONTEXT {
     //
     BOOLEAN Pending;
 
+    //
+    // Bit N is set when Buffers[N] came from the jumbo send buffer pool
+    // instead of the normal one, so it is returned to the right pool.
+    //
+    uint32_t JumboBufferMask;
+
+    //
+    // The number of leading entries of Buffers still holding an allocation,
+    // carried over when the context is recycled so the next use skips the
+    // buffer pool. Always at least BufferCount.
+    //
+    size_t RetainedBufferCount;
+
+    //
+    // The ECN codepoint to mark every datagram in this context with.
+    //
+    uint8_t EcnCodePoint;
+
+    //
+    // The number of MSG_ZEROCOPY sendmsg calls issued for this context and
+    // the socket sequence number the kernel assigned to the last of them.
+    // While the count is nonzero the kernel may still be reading the send
+    // buffers, so the context cannot be freed until the completion
+    // notification covering ZeroCopyLastSeq arrives on the error queue.
+    //
+    uint32_t ZeroCopyCount;
+    uint32_t ZeroCopyLastSeq;
+
     //
     // The proc context owning this send context.
     //
@@ -137,42 +432,127 @@ typedef struct QUIC_SOCKET_CONTEXT {
     int CleanupFd;
 
     //
-    // Used to register different event FD with epoll.
+    // Used to register different event FD with epoll (or io_uring polls).
+    // QUIC_SOCK_EVENT_WRITE is only used by the io_uring backend, so write
+    // readiness polls can be canceled independently of the read poll.
     //
 #define QUIC_SOCK_EVENT_CLEANUP 0
 #define QUIC_SOCK_EVENT_SOCKET  1
-    uint8_t EventContexts[2];
+#define QUIC_SOCK_EVENT_WRITE   2
+//
+// QUIC_SOCK_EVENT_XSK is not an EventContexts index; it is the tag byte at
+// the start of a QUIC_XSK_QUEUE, so the worker can tell an XDP socket's
+// events apart from a socket context's.
+//
+#define QUIC_SOCK_EVENT_XSK     3
+//
+// QUIC_SOCK_EVENT_EMUL_TIMER is the tag byte for the per processor network
+// emulation timer, registered the same way.
+//
+#define QUIC_SOCK_EVENT_EMUL_TIMER 4
+    uint8_t EventContexts[3];
 
     //
     // Indicates if sends are waiting for the socket to be write ready.
     //
     BOOLEAN SendWaiting;
 
+#ifdef QUIC_DATAPATH_URING
+    //
+    // The number of io_uring poll operations currently outstanding for this
+    // socket context. The context cannot be cleaned up until it drops to
+    // zero.
+    //
+    long UringPollsOutstanding;
+
+    //
+    // Indicates the cleanup event has been processed and only outstanding
+    // poll completions are keeping the socket context alive.
+    //
+    BOOLEAN UringCleanupStarted;
+#endif
+
+    //
+    // The I/O vectors for receive datagrams.
+    //
+    struct iovec RecvIov[QUIC_MAX_BATCH_RECEIVE];
+
     //
-    // The I/O vector for receive datagrams.
+    // The control buffers used in RecvMsgHdr. A dual-mode socket can get
+    // both the IPv6 and the IPv4 pktinfo for the same datagram, so there
+    // must be room for both (plus the Traffic Class / TOS, the UDP_GRO
+    // segment size when receive coalescing is enabled, and the receive
+    // timestamp) or the kernel truncates the last one and it gets parsed as
+    // garbage.
     //
-    struct iovec RecvIov;
+    char RecvMsgControl[QUIC_MAX_BATCH_RECEIVE]
+        [CMSG_SPACE(sizeof(struct in6_pktinfo)) +
+         CMSG_SPACE(sizeof(struct in_pktinfo)) +
+         2 * CMSG_SPACE(sizeof(int)) +
+         CMSG_SPACE(sizeof(struct scm_timestamping))];
 
     //
-    // The control buffer used in RecvMsgHdr.
+    // The buffers used to receive msg headers on socket.
     //
-    char RecvMsgControl[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    struct mmsghdr RecvMsgHdr[QUIC_MAX_BATCH_RECEIVE];
 
     //
-    // The buffer used to receive msg headers on socket.
+    // The receive blocks currently being used for receives on this socket.
     //
-    struct msghdr RecvMsgHdr;
+    QUIC_DATAPATH_RECV_BLOCK* CurrentRecvBlocks[QUIC_MAX_BATCH_RECEIVE];
 
     //
-    // The receive block currently being used for receives on this socket.
+    // When receive coalescing is enabled, the receives land in this staging
+    // buffer (one QUIC_COALESCED_RECV_BUFFER_LENGTH slice per message) and
+    // are split into receive blocks by the segment size afterwards.
     //
-    QUIC_DATAPATH_RECV_BLOCK* CurrentRecvBlock;
+    uint8_t* CoalescedRecvBuffer;
 
     //
     // The head of list containg all pending sends on this socket.
     //
     QUIC_LIST_ENTRY PendingSendContextHead;
 
+    //
+    // Serializes SendWaiting and the pending send list. With deferred sends
+    // enabled, sending threads queue batches here while the datapath thread
+    // drains them; otherwise the list is only touched on EAGAIN.
+    //
+    QUIC_DISPATCH_LOCK PendingSendLock;
+
+    //
+    // Indicates zero-copy transmit (SO_ZEROCOPY) was successfully enabled on
+    // the socket.
+    //
+    BOOLEAN ZeroCopyEnabled;
+
+    //
+    // Serializes the zero-copy sequence number and in-flight list, since
+    // sends are issued from arbitrary threads while the completion
+    // notifications are drained by the owning worker thread.
+    //
+    QUIC_DISPATCH_LOCK ZeroCopyLock;
+
+    //
+    // The sequence number the kernel will assign to the next MSG_ZEROCOPY
+    // send on this socket.
+    //
+    uint32_t ZeroCopyNextSeq;
+
+    //
+    // The highest sequence number the kernel has completed. Only valid once
+    // ZeroCopyAnyAcked is set.
+    //
+    uint32_t ZeroCopyAckedSeq;
+    BOOLEAN ZeroCopyAnyAcked;
+
+    //
+    // Send contexts whose buffers the kernel may still be reading. They are
+    // freed as the zero-copy completion notifications arrive on the socket's
+    // error queue.
+    //
+    QUIC_LIST_ENTRY ZeroCopyInFlightHead;
+
 } QUIC_SOCKET_CONTEXT;
 
 //
@@ -220,6 +600,14 @@ typedef struct QUIC_DATAPATH_BINDING {
     //
     uint16_t Mtu;
 
+#ifdef QUIC_DATAPATH_XDP
+    //
+    // Entry in the datapath's list of bindings reachable from the XDP
+    // receive path. Only linked while the AF_XDP backend is in use.
+    //
+    QUIC_LIST_ENTRY XdpLink;
+#endif
+
     //
     // Set of socket contexts one per proc.
     //
@@ -257,22 +645,77 @@ typedef struct QUIC_DATAPATH_PROC_CONTEXT {
     //
     QUIC_THREAD EpollWaitThread;
 
+    //
+    // The ID of the epoll wait thread, recorded when it starts. Used to tell
+    // whether a send is already executing on the datapath thread, in which
+    // case deferring it would accomplish nothing.
+    //
+    QUIC_THREAD_ID ThreadId;
+
+#ifdef QUIC_DATAPATH_URING
+    //
+    // The io_uring instance for this proc context, when the io_uring backend
+    // is in use.
+    //
+    QUIC_URING Uring;
+#endif
+
+    //
+    // Slab of huge page backed receive blocks shared by all sockets on this
+    // core. Jumbo blocks are too large to carve economically and always come
+    // from the pool.
+    //
+    QUIC_DATAPATH_RECV_SLAB RecvSlab;
+
     //
     // Pool of receive packet contexts and buffers to be shared by all sockets
-    // on this core.
+    // on this core. Overflow for when the slab runs dry (or could not be
+    // mapped).
     //
     QUIC_POOL RecvBlockPool;
 
+    //
+    // Pool of jumbo sized receive packet contexts and buffers, used when a
+    // coalesced receive carries segments larger than the normal MTU allows.
+    //
+    QUIC_POOL JumboRecvBlockPool;
+
     //
     // Pool of send buffers to be shared by all sockets on this core.
     //
     QUIC_POOL SendBufferPool;
 
+    //
+    // Pool of jumbo sized send buffers, used for datagrams larger than the
+    // normal MTU allows (e.g. path MTU discovery probes).
+    //
+    QUIC_POOL JumboSendBufferPool;
+
     //
     // Pool of send contexts to be shared by all sockets on this core.
     //
     QUIC_POOL SendContextPool;
 
+    //
+    // The most recently completed send context, parked with its buffers
+    // still allocated so the next send on this processor skips the pools
+    // entirely. Exchanged atomically, since the worker and datapath threads
+    // can both run on this processor.
+    //
+    QUIC_DATAPATH_SEND_CONTEXT* RecycledSendContext;
+
+    //
+    // Network condition emulation state, all owned by this processor's
+    // worker thread. The tag byte is registered with epoll for the timer fd
+    // so the worker can recover this context from the event pointer. The
+    // queue holds delayed deliveries in time order.
+    //
+    uint8_t EmulTimerEventType;
+    int EmulTimerFd;
+    QUIC_LIST_ENTRY EmulQueue;
+    uint32_t EmulPrngState;
+    uint64_t EmulNextFreeTimeUs;
+
 } QUIC_DATAPATH_PROC_CONTEXT;
 
 //
@@ -287,10 +730,38 @@ typedef struct QUIC_DATAPATH {
 
     //
     // The max send batch size.
-    // TODO: See how send batching can be enabled.
     //
     uint8_t MaxSendBatchSize;
 
+    //
+    // The number of messages posted per recvmmsg call. Smaller when receive
+    // coalescing is enabled, since each message then holds many datagrams.
+    //
+    uint8_t RecvBatchCount;
+
+    //
+    // Set of supported features. See QUIC_DATAPATH_FEATURE_*.
+    //
+    uint32_t Features;
+
+    //
+    // Indicates the io_uring backend is in use instead of epoll.
+    //
+    BOOLEAN UseUring;
+
+    //
+    // Indicates sends from other threads are queued to the datapath thread
+    // instead of performed inline, so the sender can overlap preparing its
+    // next batch with the socket syscall.
+    //
+    BOOLEAN DeferredSends;
+
+    //
+    // Indicates the epoll worker threads poll for work with a zero timeout
+    // instead of blocking in the kernel.
+    //
+    BOOLEAN BusyPoll;
+
     //
     // A reference rundown on the datapath binding.
     //
@@ -316,6 +787,48 @@ typedef struct QUIC_DATAPATH {
     //
     uint32_t ProcCount;
 
+    //
+    // Offset (from the start of the UDP payload of a short header packet) and
+    // mask of the partition byte encoded in locally generated CIDs. Set by
+    // the library via QuicDataPathSetPartitionInfo. An offset of zero means
+    // CID based receive steering is not available.
+    //
+    uint8_t CidPartitionByteOffset;
+    uint8_t CidPartitionMask;
+
+    //
+    // Network condition emulation, enabled via QuicDataPathSetEmulation.
+    // Read on the receive path; only written while no traffic is flowing.
+    //
+    BOOLEAN EmulationEnabled;
+    QUIC_DATAPATH_EMULATION_CONFIG Emulation;
+
+#ifdef QUIC_DATAPATH_XDP
+    //
+    // Indicates the AF_XDP receive backend is in use. One XDP socket is
+    // bound per NIC receive queue, driven by the matching per processor
+    // context's worker.
+    //
+    BOOLEAN UseXdp;
+
+    //
+    // The pinned XSKMAP the operator's XDP program redirects through.
+    //
+    int XskMapFd;
+
+    //
+    // The per queue XDP sockets, one per processor context.
+    //
+    _Field_size_(ProcCount) QUIC_XSK_QUEUE** XskQueues;
+
+    //
+    // Bindings reachable from the XDP receive path, looked up by local UDP
+    // port for each received frame.
+    //
+    QUIC_DISPATCH_LOCK XdpBindingsLock;
+    QUIC_LIST_ENTRY XdpBindings;
+#endif
+
     //
     // The per proc datapath contexts.
     //
@@ -323,11 +836,95 @@ typedef struct QUIC_DATAPATH {
 
 } QUIC_DATAPATH;
 
+#ifdef QUIC_DATAPATH_XDP
+
+//
+// A single mmapped AF_XDP ring. The producer and consumer indices live in
+// the shared mapping; whichever side this process owns is read plainly and
+// published with a release store, mirroring the io_uring helpers above.
+//
+typedef struct QUIC_XSK_RING {
+
+    uint32_t* Producer;
+    uint32_t* Consumer;
+    void* Desc;
+    uint32_t Mask;
+    void* Map;
+    size_t MapSize;
+
+} QUIC_XSK_RING;
+
+//
+// The per NIC-queue XDP socket state: the UMEM frames the NIC writes
+// packets into, the receive ring the kernel produces descriptors on, and
+// the fill ring free frames are returned through.
+//
+typedef struct QUIC_XSK_QUEUE {
+
+    //
+    // Tag byte registered with epoll for this queue's socket. Always
+    // QUIC_SOCK_EVENT_XSK, and must remain the first field so the worker
+    // can recover the queue from the event pointer.
+    //
+    uint8_t EventType;
+
+    //
+    // The AF_XDP socket FD.
+    //
+    int XskFd;
+
+    //
+    // A pointer to the datapath and the processor context whose worker
+    // drives this queue.
+    //
+    QUIC_DATAPATH* Datapath;
+    QUIC_DATAPATH_PROC_CONTEXT* ProcContext;
+
+    //
+    // The NIC receive queue this socket is bound to.
+    //
+    uint32_t QueueId;
+
+    //
+    // The UMEM packet buffer area.
+    //
+    uint8_t* UmemArea;
+    size_t UmemSize;
+
+    //
+    // The receive and fill rings.
+    //
+    QUIC_XSK_RING Rx;
+    QUIC_XSK_RING Fill;
+
+    //
+    // Serializes fill ring producers, since frames are returned from
+    // whichever thread the upper layer releases its datagrams on.
+    //
+    QUIC_DISPATCH_LOCK FillLock;
+
+} QUIC_XSK_QUEUE;
+
+#endif // QUIC_DATAPATH_XDP
+
+QUIC_DATAPATH_RECV_BLOCK*
+QuicDataPathAllocRecvBlock(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ uint32_t ProcIndex,
+    _In_ BOOLEAN Jumbo
+    );
+
 QUIC_STATUS
 QuicDataPathBindingSend(
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const QUIC_ADDR* LocalAddress,
     _In_ const QUIC_ADDR* RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
+    );
+
+void
+QuicSendContextRelease(
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     );
 
@@ -336,19 +933,1086 @@ QuicDataPathWorkerThread(
     _In_ void* Context
     );
 
-QUIC_STATUS
-QuicProcessorContextInitialize(
-    _In_ QUIC_DATAPATH* Datapath,
-    _In_ uint32_t Index,
-    _Out_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
-    )
-{
-    QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
+void
+QuicSocketContextProcessSocketEvents(
+    _In_ QUIC_SOCKET_CONTEXT* SocketContext,
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ int Events
+    );
+
+#ifdef QUIC_DATAPATH_URING
+
+int
+QuicUringSetup(
+    _In_ uint32_t EntryCount,
+    _Inout_ struct io_uring_params* Params
+    )
+{
+    return (int)syscall(__NR_io_uring_setup, EntryCount, Params);
+}
+
+int
+QuicUringEnter(
+    _In_ int RingFd,
+    _In_ uint32_t ToSubmit,
+    _In_ uint32_t MinComplete,
+    _In_ uint32_t Flags
+    )
+{
+    return
+        (int)TEMP_FAILURE_RETRY(
+            syscall(
+                __NR_io_uring_enter,
+                RingFd,
+                ToSubmit,
+                MinComplete,
+                Flags,
+                NULL,
+                0));
+}
+
+void
+QuicUringUninitialize(
+    _Inout_ QUIC_URING* Ring
+    )
+{
+    if (Ring->Sqes != NULL) {
+        munmap(Ring->Sqes, Ring->SqesSize);
+    }
+    if (Ring->CqRingPtr != NULL && Ring->CqRingPtr != Ring->SqRingPtr) {
+        munmap(Ring->CqRingPtr, Ring->CqRingSize);
+    }
+    if (Ring->SqRingPtr != NULL) {
+        munmap(Ring->SqRingPtr, Ring->SqRingSize);
+    }
+    if (Ring->RingFd != INVALID_SOCKET_FD) {
+        close(Ring->RingFd);
+    }
+    QuicLockUninitialize(&Ring->SqLock);
+}
+
+QUIC_STATUS
+QuicUringInitialize(
+    _Out_ QUIC_URING* Ring
+    )
+{
+    QuicZeroMemory(Ring, sizeof(*Ring));
+    Ring->RingFd = INVALID_SOCKET_FD;
+    QuicLockInitialize(&Ring->SqLock);
+
+    struct io_uring_params Params = {0};
+    Ring->RingFd = QuicUringSetup(QUIC_URING_SQ_ENTRY_COUNT, &Params);
+    if (Ring->RingFd < 0) {
+        QUIC_STATUS Status = errno;
+        Ring->RingFd = INVALID_SOCKET_FD;
+        QuicLockUninitialize(&Ring->SqLock);
+        return Status;
+    }
+
+    Ring->SqRingSize = Params.sq_off.array + Params.sq_entries * sizeof(uint32_t);
+    Ring->CqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(struct io_uring_cqe);
+    if (Params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (Ring->CqRingSize > Ring->SqRingSize) {
+            Ring->SqRingSize = Ring->CqRingSize;
+        }
+        Ring->CqRingSize = Ring->SqRingSize;
+    }
+
+    Ring->SqRingPtr =
+        mmap(
+            NULL, Ring->SqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, Ring->RingFd, IORING_OFF_SQ_RING);
+    if (Ring->SqRingPtr == MAP_FAILED) {
+        Ring->SqRingPtr = NULL;
+        goto Error;
+    }
+
+    if (Params.features & IORING_FEAT_SINGLE_MMAP) {
+        Ring->CqRingPtr = Ring->SqRingPtr;
+    } else {
+        Ring->CqRingPtr =
+            mmap(
+                NULL, Ring->CqRingSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, Ring->RingFd, IORING_OFF_CQ_RING);
+        if (Ring->CqRingPtr == MAP_FAILED) {
+            Ring->CqRingPtr = NULL;
+            goto Error;
+        }
+    }
+
+    Ring->SqesSize = Params.sq_entries * sizeof(struct io_uring_sqe);
+    Ring->Sqes =
+        mmap(
+            NULL, Ring->SqesSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, Ring->RingFd, IORING_OFF_SQES);
+    if (Ring->Sqes == MAP_FAILED) {
+        Ring->Sqes = NULL;
+        goto Error;
+    }
+
+    Ring->SqEntryCount = Params.sq_entries;
+    Ring->SqHead = (uint32_t*)((uint8_t*)Ring->SqRingPtr + Params.sq_off.head);
+    Ring->SqTail = (uint32_t*)((uint8_t*)Ring->SqRingPtr + Params.sq_off.tail);
+    Ring->SqMask = *(uint32_t*)((uint8_t*)Ring->SqRingPtr + Params.sq_off.ring_mask);
+    Ring->SqArray = (uint32_t*)((uint8_t*)Ring->SqRingPtr + Params.sq_off.array);
+    Ring->CqHead = (uint32_t*)((uint8_t*)Ring->CqRingPtr + Params.cq_off.head);
+    Ring->CqTail = (uint32_t*)((uint8_t*)Ring->CqRingPtr + Params.cq_off.tail);
+    Ring->CqMask = *(uint32_t*)((uint8_t*)Ring->CqRingPtr + Params.cq_off.ring_mask);
+    Ring->Cqes = (struct io_uring_cqe*)((uint8_t*)Ring->CqRingPtr + Params.cq_off.cqes);
+
+    return QUIC_STATUS_SUCCESS;
+
+Error:
+
+    QuicUringUninitialize(Ring);
+    return QUIC_STATUS_OUT_OF_MEMORY;
+}
+
+//
+// Writes a single submission queue entry and hands it to the kernel.
+//
+QUIC_STATUS
+QuicUringSubmitSqe(
+    _In_ QUIC_URING* Ring,
+    _In_ const struct io_uring_sqe* Sqe
+    )
+{
+    QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
+
+    QuicLockAcquire(&Ring->SqLock);
+
+    uint32_t Tail = *Ring->SqTail;
+    uint32_t Head = __atomic_load_n(Ring->SqHead, __ATOMIC_ACQUIRE);
+    if (Tail - Head >= Ring->SqEntryCount) {
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        goto Exit;
+    }
+
+    uint32_t Index = Tail & Ring->SqMask;
+    Ring->Sqes[Index] = *Sqe;
+    Ring->SqArray[Index] = Index;
+    __atomic_store_n(Ring->SqTail, Tail + 1, __ATOMIC_RELEASE);
+
+    if (QuicUringEnter(Ring->RingFd, 1, 0, 0) < 0) {
+        Status = errno;
+    }
+
+Exit:
+
+    QuicLockRelease(&Ring->SqLock);
+    return Status;
+}
+
+QUIC_STATUS
+QuicUringSubmitPoll(
+    _In_ QUIC_URING* Ring,
+    _In_ int Fd,
+    _In_ uint16_t PollEvents,
+    _In_ void* UserData
+    )
+{
+    struct io_uring_sqe Sqe = {0};
+    Sqe.opcode = IORING_OP_POLL_ADD;
+    Sqe.fd = Fd;
+    Sqe.poll_events = PollEvents;
+    Sqe.user_data = (uint64_t)(uintptr_t)UserData;
+    return QuicUringSubmitSqe(Ring, &Sqe);
+}
+
+//
+// Cancels an outstanding poll by its user data. The kernel posts a
+// completion for the canceled poll (if it was still armed), plus one for the
+// cancelation itself, which is tagged to be ignored.
+//
+QUIC_STATUS
+QuicUringSubmitPollRemove(
+    _In_ QUIC_URING* Ring,
+    _In_ void* TargetUserData
+    )
+{
+    struct io_uring_sqe Sqe = {0};
+    Sqe.opcode = IORING_OP_POLL_REMOVE;
+    Sqe.fd = -1;
+    Sqe.addr = (uint64_t)(uintptr_t)TargetUserData;
+    Sqe.user_data = QUIC_URING_IGNORE_USER_DATA;
+    return QuicUringSubmitSqe(Ring, &Sqe);
+}
+
+BOOLEAN
+QuicUringPopCqe(
+    _In_ QUIC_URING* Ring,
+    _Out_ struct io_uring_cqe* Cqe
+    )
+{
+    uint32_t Head = *Ring->CqHead;
+    uint32_t Tail = __atomic_load_n(Ring->CqTail, __ATOMIC_ACQUIRE);
+    if (Head == Tail) {
+        return FALSE;
+    }
+    *Cqe = Ring->Cqes[Head & Ring->CqMask];
+    __atomic_store_n(Ring->CqHead, Head + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+//
+// Determines at runtime whether the kernel supports everything the io_uring
+// backend needs.
+//
+BOOLEAN
+QuicDataPathUringSupported(
+    void
+    )
+{
+    struct io_uring_params Params = {0};
+    int RingFd = QuicUringSetup(1, &Params);
+    if (RingFd < 0) {
+        return FALSE;
+    }
+    close(RingFd);
+    return TRUE;
+}
+
+#endif // QUIC_DATAPATH_URING
+
+void
+QuicDataPathQuerySockoptSupport(
+    _Inout_ QUIC_DATAPATH* Datapath
+    )
+{
+    int SocketFd =
+        socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (SocketFd == INVALID_SOCKET_FD) {
+        return;
+    }
+
+    //
+    // Test if the kernel supports setting the UDP segmentation size
+    // (UDP_SEGMENT, i.e. GSO) on a socket. If it does, a send context can
+    // carry a batch of equally-sized datagrams that are handed to the kernel
+    // in a single sendmsg call.
+    //
+    int SegmentSize = QUIC_MAX_MTU;
+    if (setsockopt(
+            SocketFd,
+            SOL_UDP,
+            UDP_SEGMENT,
+            (const void*)&SegmentSize,
+            sizeof(SegmentSize)) == 0) {
+        Datapath->Features |= QUIC_DATAPATH_FEATURE_SEND_SEGMENTATION;
+    }
+
+    //
+    // Test if the kernel supports UDP receive coalescing (UDP_GRO, i.e.
+    // GRO). If it does, the kernel hands back super-datagrams that hold a
+    // batch of equally-sized datagrams, with the segment size carried in a
+    // UDP_GRO control message.
+    //
+    int Enabled = TRUE;
+    if (setsockopt(
+            SocketFd,
+            SOL_UDP,
+            UDP_GRO,
+            (const void*)&Enabled,
+            sizeof(Enabled)) == 0) {
+        Datapath->Features |= QUIC_DATAPATH_FEATURE_RECV_COALESCING;
+    }
+
+    //
+    // Test if the kernel supports zero-copy transmit (SO_ZEROCOPY). If it
+    // does, large sends can hand their buffers to the kernel by reference,
+    // with completion notifications delivered on the socket error queue once
+    // the pages are no longer in use.
+    //
+    Enabled = TRUE;
+    if (setsockopt(
+            SocketFd,
+            SOL_SOCKET,
+            SO_ZEROCOPY,
+            (const void*)&Enabled,
+            sizeof(Enabled)) == 0) {
+        Datapath->Features |= QUIC_DATAPATH_FEATURE_SEND_ZERO_COPY;
+    }
+
+    close(SocketFd);
+}
+
+#ifdef QUIC_DATAPATH_XDP
+
+int
+QuicBpf(
+    _In_ int Cmd,
+    _Inout_ union bpf_attr* Attr,
+    _In_ unsigned int Size
+    )
+{
+    return (int)syscall(__NR_bpf, Cmd, Attr, Size);
+}
+
+//
+// Maps one of an XDP socket's rings into the process and resolves the
+// producer/consumer/descriptor pointers from the kernel-reported offsets.
+//
+QUIC_STATUS
+QuicXskRingMap(
+    _In_ int XskFd,
+    _In_ uint64_t PgOffset,
+    _In_ const struct xdp_ring_offset* Offsets,
+    _In_ uint32_t EntryCount,
+    _In_ uint32_t EntrySize,
+    _Out_ QUIC_XSK_RING* Ring
+    )
+{
+    Ring->MapSize = Offsets->desc + (size_t)EntryCount * EntrySize;
+    Ring->Map =
+        mmap(
+            NULL, Ring->MapSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, XskFd, PgOffset);
+    if (Ring->Map == MAP_FAILED) {
+        Ring->Map = NULL;
+        return errno;
+    }
+    Ring->Producer = (uint32_t*)((uint8_t*)Ring->Map + Offsets->producer);
+    Ring->Consumer = (uint32_t*)((uint8_t*)Ring->Map + Offsets->consumer);
+    Ring->Desc = (uint8_t*)Ring->Map + Offsets->desc;
+    Ring->Mask = EntryCount - 1;
+    return QUIC_STATUS_SUCCESS;
+}
+
+//
+// Hands a UMEM frame back to the queue's fill ring so the NIC can receive
+// into it again. The fill ring has an entry per frame, so it can never be
+// full here.
+//
+void
+QuicXskQueueReturnFrame(
+    _In_ QUIC_XSK_QUEUE* Queue,
+    _In_ uint64_t FrameAddr
+    )
+{
+    QuicDispatchLockAcquire(&Queue->FillLock);
+    uint32_t Tail = *Queue->Fill.Producer;
+    ((uint64_t*)Queue->Fill.Desc)[Tail & Queue->Fill.Mask] =
+        FrameAddr & ~((uint64_t)QUIC_XDP_FRAME_SIZE - 1);
+    __atomic_store_n(Queue->Fill.Producer, Tail + 1, __ATOMIC_RELEASE);
+    QuicDispatchLockRelease(&Queue->FillLock);
+}
+
+void
+QuicXskQueueUninitialize(
+    _In_ QUIC_XSK_QUEUE* Queue
+    )
+{
+    if (Queue->Rx.Map != NULL) {
+        munmap(Queue->Rx.Map, Queue->Rx.MapSize);
+    }
+    if (Queue->Fill.Map != NULL) {
+        munmap(Queue->Fill.Map, Queue->Fill.MapSize);
+    }
+    if (Queue->UmemArea != NULL) {
+        munmap(Queue->UmemArea, Queue->UmemSize);
+    }
+    if (Queue->XskFd != INVALID_SOCKET_FD) {
+        close(Queue->XskFd);
+    }
+    QuicDispatchLockUninitialize(&Queue->FillLock);
+    QUIC_FREE(Queue);
+}
+
+//
+// Creates an XDP socket bound to one NIC receive queue: registers the UMEM,
+// sizes and maps the rings, pre-fills the fill ring with every frame and
+// registers the socket with the owning processor's epoll. The socket only
+// starts seeing traffic once it is inserted into the redirect map, which
+// the caller does last.
+//
+QUIC_STATUS
+QuicXskQueueInitialize(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ uint32_t IfIndex,
+    _Outptr_ QUIC_XSK_QUEUE** NewQueue
+    )
+{
+    QUIC_STATUS Status;
+
+    QUIC_XSK_QUEUE* Queue = QUIC_ALLOC_NONPAGED(sizeof(QUIC_XSK_QUEUE));
+    if (Queue == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "QUIC_XSK_QUEUE",
+            sizeof(QUIC_XSK_QUEUE));
+        return QUIC_STATUS_OUT_OF_MEMORY;
+    }
+
+    QuicZeroMemory(Queue, sizeof(*Queue));
+    Queue->EventType = QUIC_SOCK_EVENT_XSK;
+    Queue->XskFd = INVALID_SOCKET_FD;
+    Queue->Datapath = Datapath;
+    Queue->ProcContext = ProcContext;
+    Queue->QueueId = ProcContext->Index;
+    QuicDispatchLockInitialize(&Queue->FillLock);
+
+    Queue->XskFd = socket(AF_XDP, SOCK_RAW, 0);
+    if (Queue->XskFd == INVALID_SOCKET_FD) {
+        Status = errno;
+        goto Error;
+    }
+
+    Queue->UmemSize = (size_t)QUIC_XDP_FRAME_COUNT * QUIC_XDP_FRAME_SIZE;
+    Queue->UmemArea =
+        mmap(
+            NULL, Queue->UmemSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (Queue->UmemArea == MAP_FAILED) {
+        Queue->UmemArea = NULL;
+        Status = errno;
+        goto Error;
+    }
+
+    struct xdp_umem_reg UmemReg = {
+        .addr = (uint64_t)(uintptr_t)Queue->UmemArea,
+        .len = Queue->UmemSize,
+        .chunk_size = QUIC_XDP_FRAME_SIZE,
+        .headroom = 0
+    };
+    if (setsockopt(
+            Queue->XskFd, SOL_XDP, XDP_UMEM_REG,
+            &UmemReg, sizeof(UmemReg)) != 0) {
+        Status = errno;
+        goto Error;
+    }
+
+    //
+    // The kernel requires both UMEM rings to be sized before bind, even
+    // though the completion ring is unused on a receive-only socket.
+    //
+    int RingSize = QUIC_XDP_FRAME_COUNT;
+    if (setsockopt(
+            Queue->XskFd, SOL_XDP, XDP_UMEM_FILL_RING,
+            &RingSize, sizeof(RingSize)) != 0 ||
+        setsockopt(
+            Queue->XskFd, SOL_XDP, XDP_UMEM_COMPLETION_RING,
+            &RingSize, sizeof(RingSize)) != 0) {
+        Status = errno;
+        goto Error;
+    }
+    RingSize = QUIC_XDP_RX_RING_SIZE;
+    if (setsockopt(
+            Queue->XskFd, SOL_XDP, XDP_RX_RING,
+            &RingSize, sizeof(RingSize)) != 0) {
+        Status = errno;
+        goto Error;
+    }
+
+    struct xdp_mmap_offsets Offsets;
+    socklen_t OptLen = sizeof(Offsets);
+    if (getsockopt(
+            Queue->XskFd, SOL_XDP, XDP_MMAP_OFFSETS,
+            &Offsets, &OptLen) != 0 ||
+        OptLen != sizeof(Offsets)) {
+        //
+        // A length mismatch means the running kernel's ring offset layout
+        // differs from the build-time one; treat it as unsupported.
+        //
+        Status = QUIC_STATUS_NOT_SUPPORTED;
+        goto Error;
+    }
+
+    Status =
+        QuicXskRingMap(
+            Queue->XskFd, XDP_UMEM_PGOFF_FILL_RING, &Offsets.fr,
+            QUIC_XDP_FRAME_COUNT, sizeof(uint64_t), &Queue->Fill);
+    if (QUIC_FAILED(Status)) {
+        goto Error;
+    }
+    Status =
+        QuicXskRingMap(
+            Queue->XskFd, XDP_PGOFF_RX_RING, &Offsets.rx,
+            QUIC_XDP_RX_RING_SIZE, sizeof(struct xdp_desc), &Queue->Rx);
+    if (QUIC_FAILED(Status)) {
+        goto Error;
+    }
+
+    //
+    // Give the NIC every frame up front.
+    //
+    uint32_t FillTail = *Queue->Fill.Producer;
+    for (uint32_t i = 0; i < QUIC_XDP_FRAME_COUNT; i++) {
+        ((uint64_t*)Queue->Fill.Desc)[(FillTail + i) & Queue->Fill.Mask] =
+            (uint64_t)i * QUIC_XDP_FRAME_SIZE;
+    }
+    __atomic_store_n(
+        Queue->Fill.Producer,
+        FillTail + QUIC_XDP_FRAME_COUNT,
+        __ATOMIC_RELEASE);
+
+    //
+    // Prefer the driver's zero-copy mode and fall back to copy mode, which
+    // every XDP capable kernel supports.
+    //
+    struct sockaddr_xdp Sxdp = {
+        .sxdp_family = AF_XDP,
+        .sxdp_flags = XDP_ZEROCOPY,
+        .sxdp_ifindex = IfIndex,
+        .sxdp_queue_id = Queue->QueueId
+    };
+    if (bind(Queue->XskFd, (struct sockaddr*)&Sxdp, sizeof(Sxdp)) != 0) {
+        Sxdp.sxdp_flags = XDP_COPY;
+        if (bind(Queue->XskFd, (struct sockaddr*)&Sxdp, sizeof(Sxdp)) != 0) {
+            Status = errno;
+            goto Error;
+        }
+    }
+
+    struct epoll_event EvtIn = {
+        .events = EPOLLIN,
+        .data = {
+            .ptr = &Queue->EventType
+        }
+    };
+    if (epoll_ctl(ProcContext->EpollFd, EPOLL_CTL_ADD, Queue->XskFd, &EvtIn) != 0) {
+        Status = errno;
+        goto Error;
+    }
+
+    *NewQueue = Queue;
+    return QUIC_STATUS_SUCCESS;
+
+Error:
+
+    QuicXskQueueUninitialize(Queue);
+    return Status;
+}
+
+//
+// Parses the link, network and transport headers of a received frame and
+// fills in the packet's address tuple. Anything that is not a plain
+// (unfragmented, no extension header) UDP packet is rejected; the redirect
+// program is not expected to send such packets here.
+//
+BOOLEAN
+QuicXskParseFrame(
+    _In_reads_(FrameLength) const uint8_t* Frame,
+    _In_ uint32_t FrameLength,
+    _Out_ QUIC_TUPLE* Tuple,
+    _Outptr_ const uint8_t** Payload,
+    _Out_ uint16_t* PayloadLength,
+    _Out_ uint8_t* TypeOfService
+    )
+{
+    if (FrameLength < sizeof(struct ethhdr)) {
+        return FALSE;
+    }
+    const struct ethhdr* Eth = (const struct ethhdr*)Frame;
+    const uint8_t* Network = Frame + sizeof(struct ethhdr);
+    uint32_t Remaining = FrameLength - sizeof(struct ethhdr);
+    const struct udphdr* Udp;
+
+    QuicZeroMemory(Tuple, sizeof(*Tuple));
+
+    if (Eth->h_proto == htons(ETH_P_IP)) {
+        if (Remaining < sizeof(struct iphdr)) {
+            return FALSE;
+        }
+        const struct iphdr* Ip = (const struct iphdr*)Network;
+        uint32_t HeaderLength = (uint32_t)Ip->ihl * 4;
+        if (HeaderLength < sizeof(struct iphdr) ||
+            Remaining < HeaderLength + sizeof(struct udphdr) ||
+            Ip->protocol != IPPROTO_UDP ||
+            (Ip->frag_off & htons(0x3FFF)) != 0) {
+            return FALSE;
+        }
+        Udp = (const struct udphdr*)(Network + HeaderLength);
+        Remaining -= HeaderLength + sizeof(struct udphdr);
+        *TypeOfService = Ip->tos;
+
+        Tuple->RemoteAddress.Ipv4.sin_family = AF_INET;
+        Tuple->RemoteAddress.Ipv4.sin_addr.s_addr = Ip->saddr;
+        Tuple->RemoteAddress.Ipv4.sin_port = Udp->source;
+        Tuple->LocalAddress.Ipv4.sin_family = AF_INET;
+        Tuple->LocalAddress.Ipv4.sin_addr.s_addr = Ip->daddr;
+        Tuple->LocalAddress.Ipv4.sin_port = Udp->dest;
+
+    } else if (Eth->h_proto == htons(ETH_P_IPV6)) {
+        if (Remaining < sizeof(struct ip6_hdr) + sizeof(struct udphdr)) {
+            return FALSE;
+        }
+        const struct ip6_hdr* Ip6 = (const struct ip6_hdr*)Network;
+        if (Ip6->ip6_nxt != IPPROTO_UDP) {
+            return FALSE;
+        }
+        Udp = (const struct udphdr*)(Network + sizeof(struct ip6_hdr));
+        Remaining -= sizeof(struct ip6_hdr) + sizeof(struct udphdr);
+        *TypeOfService =
+            (uint8_t)(ntohl(Ip6->ip6_flow) >> 20); // Traffic Class field.
+
+        Tuple->RemoteAddress.Ipv6.sin6_family = AF_INET6;
+        QuicCopyMemory(
+            &Tuple->RemoteAddress.Ipv6.sin6_addr, &Ip6->ip6_src,
+            sizeof(struct in6_addr));
+        Tuple->RemoteAddress.Ipv6.sin6_port = Udp->source;
+        Tuple->LocalAddress.Ipv6.sin6_family = AF_INET6;
+        QuicCopyMemory(
+            &Tuple->LocalAddress.Ipv6.sin6_addr, &Ip6->ip6_dst,
+            sizeof(struct in6_addr));
+        Tuple->LocalAddress.Ipv6.sin6_port = Udp->dest;
+
+    } else {
+        return FALSE;
+    }
+
+    uint16_t UdpLength = ntohs(Udp->len);
+    if (UdpLength < sizeof(struct udphdr) ||
+        (uint32_t)(UdpLength - sizeof(struct udphdr)) > Remaining) {
+        return FALSE;
+    }
+
+    *Payload = (const uint8_t*)(Udp + 1);
+    *PayloadLength = UdpLength - (uint16_t)sizeof(struct udphdr);
+    return TRUE;
+}
+
+//
+// Finds the binding a received frame belongs to, by local UDP port, taking
+// a rundown reference on it. A connected binding with a matching remote
+// address is preferred over a wildcard one. Removal from the list (in
+// QuicDataPathBindingDelete) happens under the same lock, so a returned
+// reference is always acquired before the binding starts running down.
+//
+QUIC_DATAPATH_BINDING*
+QuicXskFindAndRefBinding(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ const QUIC_TUPLE* Tuple
+    )
+{
+    QUIC_DATAPATH_BINDING* Found = NULL;
+    QuicDispatchLockAcquire(&Datapath->XdpBindingsLock);
+    for (QUIC_LIST_ENTRY* Entry = Datapath->XdpBindings.Flink;
+         Entry != &Datapath->XdpBindings;
+         Entry = Entry->Flink) {
+        QUIC_DATAPATH_BINDING* Binding =
+            QUIC_CONTAINING_RECORD(Entry, QUIC_DATAPATH_BINDING, XdpLink);
+        if (Binding->LocalAddress.Ipv6.sin6_port !=
+                Tuple->LocalAddress.Ipv6.sin6_port) {
+            continue;
+        }
+        if (Binding->Connected) {
+            if (QuicAddrCompare(&Binding->RemoteAddress, &Tuple->RemoteAddress)) {
+                Found = Binding;
+                break;
+            }
+        } else if (Found == NULL) {
+            Found = Binding;
+        }
+    }
+    if (Found != NULL) {
+        QuicRundownAcquire(&Found->Rundown);
+    }
+    QuicDispatchLockRelease(&Datapath->XdpBindingsLock);
+    return Found;
+}
+
+//
+// Drains the queue's receive ring, building per-binding datagram chains out
+// of UMEM-backed receive blocks and handing them to the upper layer. Frames
+// that cannot be delivered are returned to the fill ring immediately;
+// delivered frames come back through
+// QuicDataPathBindingReturnRecvDatagrams.
+//
+void
+QuicXskQueueProcessReceives(
+    _In_ QUIC_XSK_QUEUE* Queue
+    )
+{
+    QUIC_DATAPATH* Datapath = Queue->Datapath;
+    QUIC_DATAPATH_BINDING* Binding = NULL;
+    QUIC_RECV_DATAGRAM* DatagramChain = NULL;
+    QUIC_RECV_DATAGRAM** DatagramChainTail = &DatagramChain;
+
+    uint32_t Head = *Queue->Rx.Consumer;
+    uint32_t Tail = __atomic_load_n(Queue->Rx.Producer, __ATOMIC_ACQUIRE);
+
+    while (Head != Tail) {
+        const struct xdp_desc* Desc =
+            &((const struct xdp_desc*)Queue->Rx.Desc)[Head & Queue->Rx.Mask];
+        Head++;
+
+        const uint8_t* Frame = Queue->UmemArea + Desc->addr;
+        QUIC_TUPLE Tuple;
+        const uint8_t* Payload;
+        uint16_t PayloadLength;
+        uint8_t TypeOfService;
+
+        if (!QuicXskParseFrame(
+                Frame, Desc->len, &Tuple, &Payload, &PayloadLength,
+                &TypeOfService)) {
+            QuicXskQueueReturnFrame(Queue, Desc->addr);
+            continue;
+        }
+
+        if (Binding == NULL ||
+            Binding->LocalAddress.Ipv6.sin6_port !=
+                Tuple.LocalAddress.Ipv6.sin6_port ||
+            (Binding->Connected &&
+             !QuicAddrCompare(&Binding->RemoteAddress, &Tuple.RemoteAddress))) {
+            //
+            // The frame belongs to a different binding than the chain under
+            // construction. Flush the chain and switch.
+            //
+            if (DatagramChain != NULL) {
+                Datapath->RecvHandler(
+                    Binding, Binding->ClientContext, DatagramChain);
+                DatagramChain = NULL;
+                DatagramChainTail = &DatagramChain;
+            }
+            if (Binding != NULL) {
+                QuicRundownRelease(&Binding->Rundown);
+            }
+            Binding = QuicXskFindAndRefBinding(Datapath, &Tuple);
+            if (Binding == NULL) {
+                QuicXskQueueReturnFrame(Queue, Desc->addr);
+                continue;
+            }
+        }
+
+        QUIC_DATAPATH_RECV_BLOCK* RecvBlock =
+            QuicDataPathAllocRecvBlock(
+                Datapath, Queue->ProcContext->Index, FALSE);
+        if (RecvBlock == NULL) {
+            QuicXskQueueReturnFrame(Queue, Desc->addr);
+            continue;
+        }
+
+        RecvBlock->XskQueue = Queue;
+        RecvBlock->XskFrameAddr = Desc->addr;
+        RecvBlock->Tuple = Tuple;
+        RecvBlock->RecvPacket.Tuple = &RecvBlock->Tuple;
+        RecvBlock->RecvPacket.Buffer = (uint8_t*)Payload;
+        RecvBlock->RecvPacket.BufferLength = PayloadLength;
+        //
+        // XDP frames are pulled straight off the ring, so the dequeue time
+        // is close enough to the receive time to stamp directly.
+        //
+        RecvBlock->RecvPacket.RecvTimeUs = QuicTimeUs64();
+        RecvBlock->RecvPacket.PartitionIndex = Queue->ProcContext->Index;
+        RecvBlock->RecvPacket.TypeOfService = TypeOfService;
+
+        QuicTraceEvent(
+            DatapathRecv,
+            "[ udp][%p] Recv %u bytes (segment=%hu) Src=%!SOCKADDR! Dst=%!SOCKADDR!",
+            Binding,
+            (uint32_t)PayloadLength,
+            PayloadLength,
+            LOG_ADDR_LEN(Tuple.LocalAddress),
+            LOG_ADDR_LEN(Tuple.RemoteAddress),
+            (uint8_t*)&Tuple.LocalAddress,
+            (uint8_t*)&Tuple.RemoteAddress);
+
+        *DatagramChainTail = &RecvBlock->RecvPacket;
+        DatagramChainTail = &RecvBlock->RecvPacket.Next;
+    }
+
+    __atomic_store_n(Queue->Rx.Consumer, Head, __ATOMIC_RELEASE);
+
+    if (DatagramChain != NULL) {
+        Datapath->RecvHandler(Binding, Binding->ClientContext, DatagramChain);
+    }
+    if (Binding != NULL) {
+        QuicRundownRelease(&Binding->Rundown);
+    }
+}
+
+//
+// Attempts to bring up the AF_XDP receive path. It is strictly opt-in
+// through environment variables, and every failure is non-fatal: the
+// datapath simply keeps receiving through its sockets.
+//
+void
+QuicDataPathXdpInitialize(
+    _Inout_ QUIC_DATAPATH* Datapath
+    )
+{
+    const char* InterfaceName = getenv(QUIC_XDP_INTERFACE_ENV);
+    const char* XskMapPath = getenv(QUIC_XDP_XSKMAP_ENV);
+    if (InterfaceName == NULL || XskMapPath == NULL) {
+        return;
+    }
+
+    QUIC_STATUS Status;
+    uint32_t QueuesCreated = 0;
+    uint32_t MapEntriesInserted = 0;
+
+    uint32_t IfIndex = if_nametoindex(InterfaceName);
+    if (IfIndex == 0) {
+        Status = errno;
+        goto Error;
+    }
+
+    union bpf_attr ObjGet;
+    QuicZeroMemory(&ObjGet, sizeof(ObjGet));
+    ObjGet.pathname = (uint64_t)(uintptr_t)XskMapPath;
+    Datapath->XskMapFd = QuicBpf(BPF_OBJ_GET, &ObjGet, sizeof(ObjGet));
+    if (Datapath->XskMapFd < 0) {
+        Datapath->XskMapFd = INVALID_SOCKET_FD;
+        Status = errno;
+        goto Error;
+    }
+
+    Datapath->XskQueues =
+        QUIC_ALLOC_NONPAGED(Datapath->ProcCount * sizeof(QUIC_XSK_QUEUE*));
+    if (Datapath->XskQueues == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "XDP queue array",
+            Datapath->ProcCount * sizeof(QUIC_XSK_QUEUE*));
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        goto Error;
+    }
+    QuicZeroMemory(
+        Datapath->XskQueues, Datapath->ProcCount * sizeof(QUIC_XSK_QUEUE*));
+
+    //
+    // One XDP socket per processor, bound to the same-numbered NIC receive
+    // queue. This requires the NIC to be configured with (at least) one
+    // queue per processor; a bind failure (e.g. fewer queues) falls back.
+    //
+    for (uint32_t i = 0; i < Datapath->ProcCount; i++) {
+        Status =
+            QuicXskQueueInitialize(
+                Datapath,
+                &Datapath->ProcContexts[i],
+                IfIndex,
+                &Datapath->XskQueues[i]);
+        if (QUIC_FAILED(Status)) {
+            goto Error;
+        }
+        QueuesCreated++;
+    }
+
+    //
+    // Publish the sockets in the redirect map last, so no packets can reach
+    // a partially initialized set of queues.
+    //
+    for (uint32_t i = 0; i < Datapath->ProcCount; i++) {
+        union bpf_attr MapUpdate;
+        QuicZeroMemory(&MapUpdate, sizeof(MapUpdate));
+        MapUpdate.map_fd = Datapath->XskMapFd;
+        MapUpdate.key = (uint64_t)(uintptr_t)&Datapath->XskQueues[i]->QueueId;
+        MapUpdate.value = (uint64_t)(uintptr_t)&Datapath->XskQueues[i]->XskFd;
+        if (QuicBpf(BPF_MAP_UPDATE_ELEM, &MapUpdate, sizeof(MapUpdate)) != 0) {
+            Status = errno;
+            goto Error;
+        }
+        MapEntriesInserted++;
+    }
+
+    Datapath->UseXdp = TRUE;
+
+    QuicTraceLogInfo(
+        DatapathXdpEnabled,
+        "[ xdp][%p] AF_XDP receive path enabled on interface %s (%u queues)",
+        Datapath,
+        InterfaceName,
+        Datapath->ProcCount);
+
+    return;
+
+Error:
+
+    QuicTraceLogWarning(
+        DatapathXdpDisabled,
+        "[ xdp][%p] AF_XDP receive path disabled, 0x%x, falling back to sockets",
+        Datapath,
+        Status);
+
+    for (uint32_t i = 0; i < MapEntriesInserted; i++) {
+        union bpf_attr MapDelete;
+        QuicZeroMemory(&MapDelete, sizeof(MapDelete));
+        MapDelete.map_fd = Datapath->XskMapFd;
+        MapDelete.key = (uint64_t)(uintptr_t)&Datapath->XskQueues[i]->QueueId;
+        QuicBpf(BPF_MAP_DELETE_ELEM, &MapDelete, sizeof(MapDelete));
+    }
+    for (uint32_t i = 0; i < QueuesCreated; i++) {
+        QuicXskQueueUninitialize(Datapath->XskQueues[i]);
+    }
+    if (Datapath->XskQueues != NULL) {
+        QUIC_FREE(Datapath->XskQueues);
+        Datapath->XskQueues = NULL;
+    }
+    if (Datapath->XskMapFd != INVALID_SOCKET_FD) {
+        close(Datapath->XskMapFd);
+        Datapath->XskMapFd = INVALID_SOCKET_FD;
+    }
+}
+
+//
+// Tears the AF_XDP receive path down. Runs after the worker threads have
+// stopped and their epoll FDs are closed, so nothing references the queues
+// anymore.
+//
+void
+QuicDataPathXdpUninitialize(
+    _Inout_ QUIC_DATAPATH* Datapath
+    )
+{
+    if (!Datapath->UseXdp) {
+        return;
+    }
+    for (uint32_t i = 0; i < Datapath->ProcCount; i++) {
+        union bpf_attr MapDelete;
+        QuicZeroMemory(&MapDelete, sizeof(MapDelete));
+        MapDelete.map_fd = Datapath->XskMapFd;
+        MapDelete.key = (uint64_t)(uintptr_t)&Datapath->XskQueues[i]->QueueId;
+        QuicBpf(BPF_MAP_DELETE_ELEM, &MapDelete, sizeof(MapDelete));
+        QuicXskQueueUninitialize(Datapath->XskQueues[i]);
+    }
+    QUIC_FREE(Datapath->XskQueues);
+    Datapath->XskQueues = NULL;
+    close(Datapath->XskMapFd);
+    Datapath->XskMapFd = INVALID_SOCKET_FD;
+    Datapath->UseXdp = FALSE;
+}
+
+#endif // QUIC_DATAPATH_XDP
+
+//
+// Maps the receive slab for a processor context. The slab is purely an
+// optimization: any mapping failure leaves Memory NULL and the receive path
+// falls back entirely to the pool, so nothing here is fatal.
+//
+void
+QuicRecvSlabInitialize(
+    _In_ uint32_t BlockLength,
+    _Out_ QUIC_DATAPATH_RECV_SLAB* Slab
+    )
+{
+    QuicDispatchLockInitialize(&Slab->Lock);
+    Slab->FreeList.Next = NULL;
+    Slab->Memory = NULL;
+    Slab->BlockStride =
+        (BlockLength + QUIC_RECV_SLAB_BLOCK_ALIGNMENT - 1) &
+            ~(QUIC_RECV_SLAB_BLOCK_ALIGNMENT - 1);
+
+    void* Memory =
+        mmap(
+            NULL,
+            QUIC_RECV_SLAB_SIZE,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            -1,
+            0);
+    if (Memory == MAP_FAILED) {
+        //
+        // No explicit huge pages reserved (vm.nr_hugepages). Fall back to a
+        // normal mapping and ask for transparent huge pages, which backs the
+        // slab with a huge page whenever khugepaged can find one.
+        //
+        Memory =
+            mmap(
+                NULL,
+                QUIC_RECV_SLAB_SIZE,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS,
+                -1,
+                0);
+        if (Memory == MAP_FAILED) {
+            QuicTraceEvent(
+                LibraryErrorStatus,
+                "[ lib] ERROR, %u, %s.",
+                errno,
+                "recv slab mmap failed");
+            return;
+        }
+        madvise(Memory, QUIC_RECV_SLAB_SIZE, MADV_HUGEPAGE);
+    }
+
+    Slab->Memory = Memory;
+}
+
+//
+// Carves the slab into receive blocks and populates the free list. Called
+// from the processor's own (affinitized) worker thread so that the first
+// touch of every page places the slab on that processor's NUMA node, the
+// same reason QuicProcContextPrewarmPools warms the pools there.
+//
+void
+QuicRecvSlabCarve(
+    _Inout_ QUIC_DATAPATH_RECV_SLAB* Slab
+    )
+{
+    if (Slab->Memory == NULL) {
+        return;
+    }
+    const uint32_t BlockCount = QUIC_RECV_SLAB_SIZE / Slab->BlockStride;
+    QuicDispatchLockAcquire(&Slab->Lock);
+    //
+    // Pushed in reverse address order so blocks are handed out lowest
+    // address first.
+    //
+    for (uint32_t i = BlockCount; i != 0; i--) {
+        QuicListPushEntry(
+            &Slab->FreeList,
+            (QUIC_SINGLE_LIST_ENTRY*)
+                (Slab->Memory + (size_t)(i - 1) * Slab->BlockStride));
+    }
+    QuicDispatchLockRelease(&Slab->Lock);
+}
+
+QUIC_DATAPATH_RECV_BLOCK*
+QuicRecvSlabAlloc(
+    _Inout_ QUIC_DATAPATH_RECV_SLAB* Slab
+    )
+{
+    QuicDispatchLockAcquire(&Slab->Lock);
+    QUIC_SINGLE_LIST_ENTRY* Entry = QuicListPopEntry(&Slab->FreeList);
+    QuicDispatchLockRelease(&Slab->Lock);
+    return (QUIC_DATAPATH_RECV_BLOCK*)Entry;
+}
+
+void
+QuicRecvSlabFree(
+    _Inout_ QUIC_DATAPATH_RECV_SLAB* Slab,
+    _In_ QUIC_DATAPATH_RECV_BLOCK* RecvBlock
+    )
+{
+    QuicDispatchLockAcquire(&Slab->Lock);
+    QuicListPushEntry(&Slab->FreeList, (QUIC_SINGLE_LIST_ENTRY*)RecvBlock);
+    QuicDispatchLockRelease(&Slab->Lock);
+}
+
+//
+// Tears the slab down. All receive blocks must already have been returned;
+// runs only after the binding rundown completes.
+//
+void
+QuicRecvSlabUninitialize(
+    _Inout_ QUIC_DATAPATH_RECV_SLAB* Slab
+    )
+{
+    if (Slab->Memory != NULL) {
+        munmap(Slab->Memory, QUIC_RECV_SLAB_SIZE);
+        Slab->Memory = NULL;
+    }
+    QuicDispatchLockUninitialize(&Slab->Lock);
+}
+
+QUIC_STATUS
+QuicProcessorContextInitialize(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ uint32_t Index,
+    _Out_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
+    )
+{
+    QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
     int EpollFd = INVALID_SOCKET_FD;
     int EventFd = INVALID_SOCKET_FD;
+    int EmulTimerFd = INVALID_SOCKET_FD;
     int Ret = 0;
     uint32_t RecvPacketLength = 0;
     BOOLEAN EventFdAdded = FALSE;
+    BOOLEAN EmulTimerFdAdded = FALSE;
 
     QUIC_DBG_ASSERT(Datapath != NULL);
 
@@ -356,8 +2020,17 @@ QuicProcessorContextInitialize(
         sizeof(QUIC_DATAPATH_RECV_BLOCK) + Datapath->ClientRecvContextLength;
 
     ProcContext->Index = Index;
+    QuicRecvSlabInitialize(RecvPacketLength, &ProcContext->RecvSlab);
     QuicPoolInitialize(TRUE, RecvPacketLength, &ProcContext->RecvBlockPool);
+    QuicPoolInitialize(
+        TRUE,
+        RecvPacketLength + MAX_JUMBO_UDP_PAYLOAD_LENGTH,
+        &ProcContext->JumboRecvBlockPool);
     QuicPoolInitialize(TRUE, MAX_UDP_PAYLOAD_LENGTH, &ProcContext->SendBufferPool);
+    QuicPoolInitialize(
+        TRUE,
+        MAX_JUMBO_UDP_PAYLOAD_LENGTH,
+        &ProcContext->JumboSendBufferPool);
     QuicPoolInitialize(
         TRUE,
         sizeof(QUIC_DATAPATH_SEND_CONTEXT),
@@ -405,9 +2078,69 @@ QuicProcessorContextInitialize(
 
     EventFdAdded = TRUE;
 
+    EmulTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (EmulTimerFd == INVALID_SOCKET_FD) {
+        Status = errno;
+        QuicTraceEvent(
+            LibraryErrorStatus,
+            "[ lib] ERROR, %u, %s.",
+            Status,
+            "timerfd_create failed");
+        goto Exit;
+    }
+
+    ProcContext->EmulTimerEventType = QUIC_SOCK_EVENT_EMUL_TIMER;
+
+    struct epoll_event EmulTimerEpEvt = {
+        .events = EPOLLIN,
+        .data = {
+            .ptr = &ProcContext->EmulTimerEventType
+        }
+    };
+
+    Ret = epoll_ctl(EpollFd, EPOLL_CTL_ADD, EmulTimerFd, &EmulTimerEpEvt);
+    if (Ret != 0) {
+        Status = errno;
+        QuicTraceEvent(
+            LibraryErrorStatus,
+            "[ lib] ERROR, %u, %s.",
+            Status,
+            "epoll_ctl(EPOLL_CTL_ADD) failed");
+        goto Exit;
+    }
+
+    EmulTimerFdAdded = TRUE;
+    QuicListInitializeHead(&ProcContext->EmulQueue);
+
     ProcContext->Datapath = Datapath;
     ProcContext->EpollFd = EpollFd;
     ProcContext->EventFd = EventFd;
+    ProcContext->EmulTimerFd = EmulTimerFd;
+
+#ifdef QUIC_DATAPATH_URING
+    if (Datapath->UseUring) {
+        Status = QuicUringInitialize(&ProcContext->Uring);
+        if (QUIC_FAILED(Status)) {
+            QuicTraceEvent(
+                LibraryErrorStatus,
+                "[ lib] ERROR, %u, %s.",
+                Status,
+                "QuicUringInitialize failed");
+            goto Exit;
+        }
+
+        //
+        // The shutdown event is delivered through the ring instead of epoll.
+        // A NULL user data marks it, just like the NULL epoll context does on
+        // the epoll path.
+        //
+        Status = QuicUringSubmitPoll(&ProcContext->Uring, EventFd, POLLIN, NULL);
+        if (QUIC_FAILED(Status)) {
+            QuicUringUninitialize(&ProcContext->Uring);
+            goto Exit;
+        }
+    }
+#endif
 
     //
     // Starting the thread must be done after the rest of the ProcContext
@@ -415,9 +2148,14 @@ QuicProcessorContextInitialize(
     // ProcContext members.
     //
 
+    //
+    // The thread is affinitized to its processor so that the socket contexts
+    // it services (selected by the reuseport steering program by receiving
+    // CPU) are drained on the same core the NIC delivered the packets to.
+    //
     QUIC_THREAD_CONFIG ThreadConfig = {
-        0,
-        0,
+        QUIC_THREAD_FLAG_SET_AFFINITIZE,
+        (uint8_t)Index,
         NULL,
         QuicDataPathWorkerThread,
         ProcContext
@@ -436,6 +2174,12 @@ QuicProcessorContextInitialize(
 Exit:
 
     if (QUIC_FAILED(Status)) {
+        if (EmulTimerFdAdded) {
+            epoll_ctl(EpollFd, EPOLL_CTL_DEL, EmulTimerFd, NULL);
+        }
+        if (EmulTimerFd != INVALID_SOCKET_FD) {
+            close(EmulTimerFd);
+        }
         if (EventFdAdded) {
             epoll_ctl(EpollFd, EPOLL_CTL_DEL, EventFd, NULL);
         }
@@ -445,8 +2189,11 @@ Exit:
         if (EpollFd != INVALID_SOCKET_FD) {
             close(EpollFd);
         }
+        QuicRecvSlabUninitialize(&ProcContext->RecvSlab);
         QuicPoolUninitialize(&ProcContext->RecvBlockPool);
+        QuicPoolUninitialize(&ProcContext->JumboRecvBlockPool);
         QuicPoolUninitialize(&ProcContext->SendBufferPool);
+        QuicPoolUninitialize(&ProcContext->JumboSendBufferPool);
         QuicPoolUninitialize(&ProcContext->SendContextPool);
     }
 
@@ -463,12 +2210,28 @@ QuicProcessorContextUninitialize(
     QuicThreadWait(&ProcContext->EpollWaitThread);
     QuicThreadDelete(&ProcContext->EpollWaitThread);
 
+    epoll_ctl(ProcContext->EpollFd, EPOLL_CTL_DEL, ProcContext->EmulTimerFd, NULL);
+    close(ProcContext->EmulTimerFd);
+
     epoll_ctl(ProcContext->EpollFd, EPOLL_CTL_DEL, ProcContext->EventFd, NULL);
+#ifdef QUIC_DATAPATH_URING
+    if (ProcContext->Datapath->UseUring) {
+        QuicUringUninitialize(&ProcContext->Uring);
+    }
+#endif
     close(ProcContext->EventFd);
     close(ProcContext->EpollFd);
 
+    if (ProcContext->RecycledSendContext != NULL) {
+        QuicSendContextRelease(ProcContext->RecycledSendContext);
+        ProcContext->RecycledSendContext = NULL;
+    }
+
+    QuicRecvSlabUninitialize(&ProcContext->RecvSlab);
     QuicPoolUninitialize(&ProcContext->RecvBlockPool);
+    QuicPoolUninitialize(&ProcContext->JumboRecvBlockPool);
     QuicPoolUninitialize(&ProcContext->SendBufferPool);
+    QuicPoolUninitialize(&ProcContext->JumboSendBufferPool);
     QuicPoolUninitialize(&ProcContext->SendContextPool);
 }
 
@@ -516,8 +2279,38 @@ QuicDataPathInitialize(
     Datapath->UnreachHandler = UnreachableCallback;
     Datapath->ClientRecvContextLength = ClientRecvContextLength;
     Datapath->ProcCount = QuicProcMaxCount();
-    Datapath->MaxSendBatchSize = QUIC_MAX_BATCH_SEND;
     QuicRundownInitialize(&Datapath->BindingsRundown);
+#ifdef QUIC_DATAPATH_XDP
+    Datapath->XskMapFd = INVALID_SOCKET_FD;
+    QuicDispatchLockInitialize(&Datapath->XdpBindingsLock);
+    QuicListInitializeHead(&Datapath->XdpBindings);
+#endif
+
+    QuicDataPathQuerySockoptSupport(Datapath);
+
+#ifdef QUIC_DATAPATH_URING
+    Datapath->UseUring = QuicDataPathUringSupported();
+#endif
+
+    //
+    // With segmentation support the whole batch is handed off in a single
+    // sendmsg call; without it the batch is still submitted in a single
+    // sendmmsg call, one message per datagram.
+    //
+    Datapath->MaxSendBatchSize = QUIC_MAX_BATCH_SEND;
+
+    //
+    // Jumbo sized sends are always possible on Linux (the socket imposes no
+    // datagram size limit below 64 KB); whether they actually fit through
+    // the path is for the transport's MTU discovery to find out.
+    //
+    Datapath->Features |= QUIC_DATAPATH_FEATURE_JUMBO_SEND;
+
+    if (Datapath->Features & QUIC_DATAPATH_FEATURE_RECV_COALESCING) {
+        Datapath->RecvBatchCount = QUIC_MAX_BATCH_RECEIVE_COALESCED;
+    } else {
+        Datapath->RecvBatchCount = QUIC_MAX_BATCH_RECEIVE;
+    }
 
     //
     // Initialize the per processor contexts.
@@ -533,12 +2326,25 @@ QuicDataPathInitialize(
         }
     }
 
+#ifdef QUIC_DATAPATH_XDP
+    //
+    // The XDP sockets are driven through the per processor epolls, so the
+    // io_uring backend (which has no epoll loop) does not support them.
+    //
+    if (!Datapath->UseUring) {
+        QuicDataPathXdpInitialize(Datapath);
+    }
+#endif
+
     *NewDataPath = Datapath;
     Datapath = NULL;
 
 Exit:
 
     if (Datapath != NULL) {
+#ifdef QUIC_DATAPATH_XDP
+        QuicDispatchLockUninitialize(&Datapath->XdpBindingsLock);
+#endif
         QuicRundownUninitialize(&Datapath->BindingsRundown);
         QUIC_FREE(Datapath);
     }
@@ -566,6 +2372,11 @@ QuicDataPathUninitialize(
         QuicProcessorContextUninitialize(&Datapath->ProcContexts[i]);
     }
 
+#ifdef QUIC_DATAPATH_XDP
+    QuicDataPathXdpUninitialize(Datapath);
+    QuicDispatchLockUninitialize(&Datapath->XdpBindingsLock);
+#endif
+
     QuicRundownUninitialize(&Datapath->BindingsRundown);
     QUIC_FREE(Datapath);
 #endif
@@ -577,8 +2388,78 @@ QuicDataPathGetSupportedFeatures(
     _In_ QUIC_DATAPATH* Datapath
     )
 {
-    UNREFERENCED_PARAMETER(Datapath);
-    return 0;
+    return Datapath->Features;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetPartitionInfo(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ uint8_t CidPartitionByteOffset,
+    _In_ uint8_t CidPartitionMask
+    )
+{
+    Datapath->CidPartitionByteOffset = CidPartitionByteOffset;
+    Datapath->CidPartitionMask = CidPartitionMask;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetDeferredSends(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ BOOLEAN Enabled
+    )
+{
+    //
+    // The io_uring submission queue is only ever touched by its own worker
+    // thread, so cross thread deferral is only supported with epoll.
+    //
+    Datapath->DeferredSends = Enabled && !Datapath->UseUring;
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetProcessorConfig(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_reads_opt_(ProcessorListLength) const uint16_t* ProcessorList,
+    _In_ uint32_t ProcessorListLength,
+    _In_ BOOLEAN BusyPoll
+    )
+{
+    //
+    // The io_uring backend blocks in the ring for completions, so busy
+    // polling is only supported with epoll.
+    //
+    Datapath->BusyPoll = BusyPoll && !Datapath->UseUring;
+
+    for (uint32_t i = 0; i < Datapath->ProcCount; i++) {
+        QUIC_DATAPATH_PROC_CONTEXT* ProcContext = &Datapath->ProcContexts[i];
+
+        if (ProcessorList != NULL && ProcessorListLength != 0) {
+            cpu_set_t CpuSet;
+            CPU_ZERO(&CpuSet);
+            CPU_SET(ProcessorList[i % ProcessorListLength], &CpuSet);
+            if (pthread_setaffinity_np(
+                    ProcContext->EpollWaitThread,
+                    sizeof(CpuSet),
+                    &CpuSet) != 0) {
+                QuicTraceEvent(
+                    LibraryError,
+                    "[ lib] ERROR, %s.",
+                    "pthread_setaffinity_np failed");
+            }
+        }
+
+        if (Datapath->BusyPoll) {
+            //
+            // The worker may already be parked in epoll_wait with an
+            // infinite timeout. Poke its event fd so it goes back around the
+            // loop and picks up the zero timeout.
+            //
+            const eventfd_t Value = 1;
+            eventfd_write(ProcContext->EventFd, Value);
+        }
+    }
 }
 
 BOOLEAN
@@ -589,23 +2470,38 @@ QuicDataPathIsPaddingPreferred(
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     return PlatDispatch->DatapathIsPaddingPreferred(Datapath);
 #else
-    UNREFERENCED_PARAMETER(Datapath);
     //
-    // The windows implementation returns TRUE only if GSO is supported and
-    // this DAL implementation doesn't support GSO currently.
+    // Padding is only useful when segmentation is supported, because it
+    // keeps all the datagrams in a batch the same size.
     //
-    return FALSE;
+    return !!(Datapath->Features & QUIC_DATAPATH_FEATURE_SEND_SEGMENTATION);
 #endif
 }
 
 QUIC_DATAPATH_RECV_BLOCK*
 QuicDataPathAllocRecvBlock(
     _In_ QUIC_DATAPATH* Datapath,
-    _In_ uint32_t ProcIndex
+    _In_ uint32_t ProcIndex,
+    _In_ BOOLEAN Jumbo
     )
 {
-    QUIC_DATAPATH_RECV_BLOCK* RecvBlock =
-        QuicPoolAlloc(&Datapath->ProcContexts[ProcIndex].RecvBlockPool);
+    QUIC_DATAPATH_PROC_CONTEXT* ProcContext = &Datapath->ProcContexts[ProcIndex];
+    QUIC_DATAPATH_RECV_SLAB* Slab = NULL;
+    QUIC_POOL* Pool = NULL;
+    QUIC_DATAPATH_RECV_BLOCK* RecvBlock = NULL;
+
+    if (!Jumbo) {
+        Slab = &ProcContext->RecvSlab;
+        RecvBlock = QuicRecvSlabAlloc(Slab);
+    }
+    if (RecvBlock == NULL) {
+        Slab = NULL;
+        Pool =
+            Jumbo ?
+                &ProcContext->JumboRecvBlockPool :
+                &ProcContext->RecvBlockPool;
+        RecvBlock = QuicPoolAlloc(Pool);
+    }
     if (RecvBlock == NULL) {
         QuicTraceEvent(
             AllocFailure,
@@ -614,13 +2510,36 @@ QuicDataPathAllocRecvBlock(
             0);
     } else {
         QuicZeroMemory(RecvBlock, sizeof(*RecvBlock));
-        RecvBlock->OwningPool = &Datapath->ProcContexts[ProcIndex].RecvBlockPool;
-        RecvBlock->RecvPacket.Buffer = RecvBlock->Buffer;
+        RecvBlock->OwningSlab = Slab;
+        RecvBlock->OwningPool = Pool;
+        if (Jumbo) {
+            //
+            // A jumbo block's payload buffer is the extra space past the
+            // client's receive context, so the layout up to and including
+            // the client context matches a normal block.
+            //
+            RecvBlock->RecvPacket.Buffer =
+                (uint8_t*)(RecvBlock + 1) + Datapath->ClientRecvContextLength;
+        } else {
+            RecvBlock->RecvPacket.Buffer = RecvBlock->Buffer;
+        }
         RecvBlock->RecvPacket.Allocated = TRUE;
     }
     return RecvBlock;
 }
 
+void
+QuicDataPathFreeRecvBlock(
+    _In_ QUIC_DATAPATH_RECV_BLOCK* RecvBlock
+    )
+{
+    if (RecvBlock->OwningSlab != NULL) {
+        QuicRecvSlabFree(RecvBlock->OwningSlab, RecvBlock);
+    } else {
+        QuicPoolFree(RecvBlock->OwningPool, RecvBlock);
+    }
+}
+
 void
 QuicDataPathPopulateTargetAddress(
     _In_ QUIC_ADDRESS_FAMILY Family,
@@ -840,12 +2759,60 @@ QuicSocketContextInitialize(
     // apparent alternative.
     // TODO: Verify this.
     //
-    Option = IP_PMTUDISC_DO;
+    Option = IP_PMTUDISC_DO;
+    Result =
+        setsockopt(
+            SocketContext->SocketFd,
+            IPPROTO_IP,
+            IP_MTU_DISCOVER,
+            (const void*)&Option,
+            sizeof(Option));
+    if (Result == SOCKET_ERROR) {
+        Status = errno;
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            Binding,
+            Status,
+            "setsockopt(IP_MTU_DISCOVER) failed");
+        goto Exit;
+    }
+
+    Option = TRUE;
+    Result =
+        setsockopt(
+            SocketContext->SocketFd,
+            IPPROTO_IPV6,
+            IPV6_DONTFRAG,
+            (const void*)&Option,
+            sizeof(Option));
+    if (Result == SOCKET_ERROR) {
+        Status = errno;
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            Binding,
+            Status,
+            "setsockopt(IPV6_DONTFRAG) failed");
+        goto Exit;
+    }
+
+    //
+    // Set socket option to receive ancillary data about the incoming packets.
+    //
+
+    //
+    // Windows: setsockopt IPPROTO_IPV6 IPV6_PKTINFO TRUE.
+    // Android: Returns EINVAL. IPV6_PKTINFO option is not present in documentation.
+    // IPV6_RECVPKTINFO seems like is the alternative.
+    // TODO: Check if this works as expected?
+    //
+    Option = TRUE;
     Result =
         setsockopt(
             SocketContext->SocketFd,
-            IPPROTO_IP,
-            IP_MTU_DISCOVER,
+            IPPROTO_IPV6,
+            IPV6_RECVPKTINFO,
             (const void*)&Option,
             sizeof(Option));
     if (Result == SOCKET_ERROR) {
@@ -855,7 +2822,7 @@ QuicSocketContextInitialize(
             "[ udp][%p] ERROR, %u, %s.",
             Binding,
             Status,
-            "setsockopt(IP_MTU_DISCOVER) failed");
+            "setsockopt(IPV6_RECVPKTINFO) failed");
         goto Exit;
     }
 
@@ -863,8 +2830,8 @@ QuicSocketContextInitialize(
     Result =
         setsockopt(
             SocketContext->SocketFd,
-            IPPROTO_IPV6,
-            IPV6_DONTFRAG,
+            IPPROTO_IP,
+            IP_PKTINFO,
             (const void*)&Option,
             sizeof(Option));
     if (Result == SOCKET_ERROR) {
@@ -874,26 +2841,20 @@ QuicSocketContextInitialize(
             "[ udp][%p] ERROR, %u, %s.",
             Binding,
             Status,
-            "setsockopt(IPV6_DONTFRAG) failed");
+            "setsockopt(IP_PKTINFO) failed");
         goto Exit;
     }
 
     //
-    // Set socket option to receive ancillary data about the incoming packets.
-    //
-
-    //
-    // Windows: setsockopt IPPROTO_IPV6 IPV6_PKTINFO TRUE.
-    // Android: Returns EINVAL. IPV6_PKTINFO option is not present in documentation.
-    // IPV6_RECVPKTINFO seems like is the alternative.
-    // TODO: Check if this works as expected?
+    // Ask for the Traffic Class / Type of Service of received datagrams, so
+    // the ECN codepoint can be passed up to the QUIC layer.
     //
     Option = TRUE;
     Result =
         setsockopt(
             SocketContext->SocketFd,
             IPPROTO_IPV6,
-            IPV6_RECVPKTINFO,
+            IPV6_RECVTCLASS,
             (const void*)&Option,
             sizeof(Option));
     if (Result == SOCKET_ERROR) {
@@ -903,7 +2864,7 @@ QuicSocketContextInitialize(
             "[ udp][%p] ERROR, %u, %s.",
             Binding,
             Status,
-            "setsockopt(IPV6_RECVPKTINFO) failed");
+            "setsockopt(IPV6_RECVTCLASS) failed");
         goto Exit;
     }
 
@@ -912,7 +2873,7 @@ QuicSocketContextInitialize(
         setsockopt(
             SocketContext->SocketFd,
             IPPROTO_IP,
-            IP_PKTINFO,
+            IP_RECVTOS,
             (const void*)&Option,
             sizeof(Option));
     if (Result == SOCKET_ERROR) {
@@ -922,10 +2883,25 @@ QuicSocketContextInitialize(
             "[ udp][%p] ERROR, %u, %s.",
             Binding,
             Status,
-            "setsockopt(IP_PKTINFO) failed");
+            "setsockopt(IP_RECVTOS) failed");
         goto Exit;
     }
 
+    //
+    // Ask for kernel receive timestamps. The kernel's software timestamp is
+    // taken when the datagram enters the socket queue, so it excludes the
+    // epoll wakeup and queue delay that inflate userspace receive times
+    // under load. Best effort; on kernels without SO_TIMESTAMPING support
+    // the receive path just falls back to userspace receive times.
+    //
+    Option = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    (void)setsockopt(
+        SocketContext->SocketFd,
+        SOL_SOCKET,
+        SO_TIMESTAMPING,
+        (const void*)&Option,
+        sizeof(Option));
+
     //
     // The socket is shared by multiple QUIC endpoints, so increase the receive
     // buffer size.
@@ -971,6 +2947,100 @@ QuicSocketContextInitialize(
         goto Exit;
     }
 
+    //
+    // One socket is bound to the port per processor, and the kernel splits
+    // delivery across them. The reuseport steering program attached below
+    // then picks the socket by receiving CPU, so each datagram is handed to
+    // the socket context (and thus partition index) of the core the NIC's
+    // RSS hash delivered it to.
+    //
+    Option = TRUE;
+    Result =
+        setsockopt(
+            SocketContext->SocketFd,
+            SOL_SOCKET,
+            SO_REUSEPORT,
+            (const void*)&Option,
+            sizeof(Option));
+    if (Result == SOCKET_ERROR) {
+        Status = errno;
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            Binding,
+            Status,
+            "setsockopt(SO_REUSEPORT) failed");
+        goto Exit;
+    }
+
+    if (Binding->Datapath->Features & QUIC_DATAPATH_FEATURE_RECV_COALESCING) {
+        //
+        // Let the kernel coalesce consecutive datagrams of the same flow
+        // into super-datagrams, which get split back apart by the UDP_GRO
+        // segment size after the receive completes.
+        //
+        Option = TRUE;
+        Result =
+            setsockopt(
+                SocketContext->SocketFd,
+                SOL_UDP,
+                UDP_GRO,
+                (const void*)&Option,
+                sizeof(Option));
+        if (Result == SOCKET_ERROR) {
+            Status = errno;
+            QuicTraceEvent(
+                DatapathErrorStatus,
+                "[ udp][%p] ERROR, %u, %s.",
+                Binding,
+                Status,
+                "setsockopt(UDP_GRO) failed");
+            goto Exit;
+        }
+
+        SocketContext->CoalescedRecvBuffer =
+            QUIC_ALLOC_NONPAGED(
+                (size_t)Binding->Datapath->RecvBatchCount *
+                    QUIC_COALESCED_RECV_BUFFER_LENGTH);
+        if (SocketContext->CoalescedRecvBuffer == NULL) {
+            Status = QUIC_STATUS_OUT_OF_MEMORY;
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "CoalescedRecvBuffer",
+                (uint64_t)Binding->Datapath->RecvBatchCount *
+                    QUIC_COALESCED_RECV_BUFFER_LENGTH);
+            goto Exit;
+        }
+    }
+
+    if (Binding->Datapath->Features & QUIC_DATAPATH_FEATURE_SEND_ZERO_COPY) {
+        //
+        // Opt into zero-copy transmit. Sends above the size threshold then
+        // reference the send buffers directly instead of copying them into
+        // kernel memory. Failure is non-fatal; the copying send path still
+        // works.
+        //
+        Option = TRUE;
+        Result =
+            setsockopt(
+                SocketContext->SocketFd,
+                SOL_SOCKET,
+                SO_ZEROCOPY,
+                (const void*)&Option,
+                sizeof(Option));
+        if (Result == SOCKET_ERROR) {
+            QuicTraceEvent(
+                DatapathErrorStatus,
+                "[ udp][%p] ERROR, %u, %s.",
+                Binding,
+                errno,
+                "setsockopt(SO_ZEROCOPY) failed");
+        } else {
+            SocketContext->ZeroCopyEnabled = TRUE;
+        }
+    }
+
     Result =
         bind(
             SocketContext->SocketFd,
@@ -987,6 +3057,62 @@ QuicSocketContextInitialize(
         goto Exit;
     }
 
+    if (ProcContext->Index == 0 && Binding->Datapath->ProcCount > 1) {
+        //
+        // Attach a classic BPF program to the reuseport group that selects
+        // the socket a datagram is delivered to. The sockets join the group
+        // in processor order. Short header packets carry the partition byte
+        // MsQuic encodes in every CID it generates, so they are steered
+        // directly to the socket of the processor that owns the connection,
+        // matching the partitioned lookup table indexing. Long header
+        // packets (whose destination CID the peer picked) fall back to the
+        // CPU the datagram was received on, which is where the connection
+        // ends up homed anyway. The program is a property of the whole
+        // group, so it only needs to be attached once. On kernels without
+        // reuseport BPF support this fails benignly; delivery then falls
+        // back to the kernel's flow hash, which still keeps any single flow
+        // on one processor.
+        //
+        struct sock_filter CpuSteering[] = {
+            { BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+            { BPF_ALU | BPF_MOD | BPF_K, 0, 0, Binding->Datapath->ProcCount },
+            { BPF_RET | BPF_A, 0, 0, 0 }
+        };
+        struct sock_filter CidSteering[] = {
+            { BPF_LD | BPF_B | BPF_ABS, 0, 0, 0 },      // QUIC flags byte
+            { BPF_JMP | BPF_JSET | BPF_K, 3, 0, 0x80 }, // Long header? Steer by CPU.
+            { BPF_LD | BPF_B | BPF_ABS, 0, 0, Binding->Datapath->CidPartitionByteOffset },
+            { BPF_ALU | BPF_AND | BPF_K, 0, 0, Binding->Datapath->CidPartitionMask },
+            { BPF_JMP | BPF_JA, 0, 0, 1 },
+            { BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+            { BPF_ALU | BPF_MOD | BPF_K, 0, 0, Binding->Datapath->ProcCount },
+            { BPF_RET | BPF_A, 0, 0, 0 }
+        };
+        struct sock_fprog BpfConfig;
+        if (Binding->Datapath->CidPartitionByteOffset != 0) {
+            BpfConfig.len = ARRAYSIZE(CidSteering);
+            BpfConfig.filter = CidSteering;
+        } else {
+            BpfConfig.len = ARRAYSIZE(CpuSteering);
+            BpfConfig.filter = CpuSteering;
+        }
+        Result =
+            setsockopt(
+                SocketContext->SocketFd,
+                SOL_SOCKET,
+                SO_ATTACH_REUSEPORT_CBPF,
+                (const void*)&BpfConfig,
+                sizeof(BpfConfig));
+        if (Result == SOCKET_ERROR) {
+            QuicTraceEvent(
+                DatapathErrorStatus,
+                "[ udp][%p] ERROR, %u, %s.",
+                Binding,
+                errno,
+                "setsockopt(SO_ATTACH_REUSEPORT_CBPF) failed");
+        }
+    }
+
     if (RemoteAddress != NULL) {
         QuicZeroMemory(&MappedRemoteAddress, sizeof(MappedRemoteAddress));
         QuicConvertToMappedV6(RemoteAddress, &MappedRemoteAddress);
@@ -1040,6 +3166,10 @@ Exit:
     if (QUIC_FAILED(Status)) {
         close(SocketContext->SocketFd);
         SocketContext->SocketFd = INVALID_SOCKET_FD;
+        if (SocketContext->CoalescedRecvBuffer != NULL) {
+            QUIC_FREE(SocketContext->CoalescedRecvBuffer);
+            SocketContext->CoalescedRecvBuffer = NULL;
+        }
     }
 
     return Status;
@@ -1057,16 +3187,304 @@ QuicSocketContextUninitialize(
     eventfd_write(SocketContext->CleanupFd, Value);
 }
 
+//
+// A delivery the network emulator is holding back until its emulated arrival
+// time.
+//
+typedef struct QUIC_DATAPATH_EMUL_ENTRY {
+    QUIC_LIST_ENTRY Link;
+    QUIC_DATAPATH_BINDING* Binding;
+    QUIC_RECV_DATAGRAM* Datagram;
+    uint64_t DeliverTimeUs;
+} QUIC_DATAPATH_EMUL_ENTRY;
+
+//
+// A small xorshift generator, so loss and jitter are reproducible from the
+// configured seed regardless of platform RNG state.
+//
+uint32_t
+QuicDataPathEmulRandom(
+    _Inout_ uint32_t* State
+    )
+{
+    uint32_t Value = *State;
+    Value ^= Value << 13;
+    Value ^= Value >> 17;
+    Value ^= Value << 5;
+    *State = Value;
+    return Value;
+}
+
+//
+// Arms (or disarms) the processor's emulation timer for the head of the
+// delay queue.
+//
+void
+QuicDataPathEmulArmTimer(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
+    )
+{
+    struct itimerspec Timer = {0};
+    if (!QuicListIsEmpty(&ProcContext->EmulQueue)) {
+        QUIC_DATAPATH_EMUL_ENTRY* Entry =
+            QUIC_CONTAINING_RECORD(
+                ProcContext->EmulQueue.Flink, QUIC_DATAPATH_EMUL_ENTRY, Link);
+        uint64_t TimeNow = QuicTimeUs64();
+        uint64_t DeltaUs =
+            Entry->DeliverTimeUs > TimeNow ?
+                Entry->DeliverTimeUs - TimeNow : 1; // Zero would disarm.
+        Timer.it_value.tv_sec = DeltaUs / 1000000;
+        Timer.it_value.tv_nsec = (DeltaUs % 1000000) * 1000;
+    }
+    timerfd_settime(ProcContext->EmulTimerFd, 0, &Timer, NULL);
+}
+
+//
+// Delivers every queued datagram whose emulated arrival time has passed,
+// then re-arms the timer for whatever remains.
+//
+void
+QuicDataPathEmulProcessTimer(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
+    )
+{
+    uint64_t Value;
+    if (read(ProcContext->EmulTimerFd, &Value, sizeof(Value)) < 0) {
+        // Spurious wakeup; the timer will be re-armed below regardless.
+    }
+
+    uint64_t TimeNow = QuicTimeUs64();
+    while (!QuicListIsEmpty(&ProcContext->EmulQueue)) {
+        QUIC_DATAPATH_EMUL_ENTRY* Entry =
+            QUIC_CONTAINING_RECORD(
+                ProcContext->EmulQueue.Flink, QUIC_DATAPATH_EMUL_ENTRY, Link);
+        if (Entry->DeliverTimeUs > TimeNow) {
+            break;
+        }
+        QuicListEntryRemove(&Entry->Link);
+        if (Entry->Binding->Shutdown) {
+            QuicDataPathBindingReturnRecvDatagrams(Entry->Datagram);
+        } else {
+            //
+            // Restamp with the emulated delivery time so the artificial
+            // delay shows up in RTT measurements like a real link would.
+            //
+            Entry->Datagram->RecvTimeUs = TimeNow;
+            ProcContext->Datapath->RecvHandler(
+                Entry->Binding,
+                Entry->Binding->ClientContext,
+                Entry->Datagram);
+        }
+        QUIC_FREE(Entry);
+    }
+
+    QuicDataPathEmulArmTimer(ProcContext);
+}
+
+//
+// Returns any deliveries the emulator is still holding for the binding.
+// Called on the owning worker thread when a socket context is cleaned up,
+// since the binding goes away once every context completes.
+//
+void
+QuicDataPathEmulPurgeBinding(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ QUIC_DATAPATH_BINDING* Binding
+    )
+{
+    QUIC_LIST_ENTRY* Link = ProcContext->EmulQueue.Flink;
+    while (Link != &ProcContext->EmulQueue) {
+        QUIC_DATAPATH_EMUL_ENTRY* Entry =
+            QUIC_CONTAINING_RECORD(Link, QUIC_DATAPATH_EMUL_ENTRY, Link);
+        Link = Link->Flink;
+        if (Entry->Binding == Binding) {
+            QuicListEntryRemove(&Entry->Link);
+            QuicDataPathBindingReturnRecvDatagrams(Entry->Datagram);
+            QUIC_FREE(Entry);
+        }
+    }
+    QuicDataPathEmulArmTimer(ProcContext);
+}
+
+//
+// Runs a received datagram chain through the configured network conditions
+// and indicates the surviving datagrams to the client, each at its emulated
+// arrival time. Everything (queue, shaper, PRNG) belongs to this processor's
+// worker thread, so no locking is needed.
+//
+void
+QuicDataPathEmulDeliver(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ QUIC_DATAPATH_BINDING* Binding,
+    _In_ QUIC_RECV_DATAGRAM* DatagramChain
+    )
+{
+    QUIC_DATAPATH* Datapath = ProcContext->Datapath;
+    const QUIC_DATAPATH_EMULATION_CONFIG* Config = &Datapath->Emulation;
+
+    if (Config->LocalPort != 0 &&
+        Config->LocalPort != QuicAddrGetPort(&Binding->LocalAddress)) {
+        Datapath->RecvHandler(Binding, Binding->ClientContext, DatagramChain);
+        return;
+    }
+
+    QUIC_RECV_DATAGRAM* DropChain = NULL;
+    QUIC_RECV_DATAGRAM** DropChainTail = &DropChain;
+    uint64_t TimeNow = QuicTimeUs64();
+    BOOLEAN ArmTimer = FALSE;
+
+    QUIC_RECV_DATAGRAM* Datagram;
+    while ((Datagram = DatagramChain) != NULL) {
+        DatagramChain = DatagramChain->Next;
+        Datagram->Next = NULL;
+
+        if (Config->LossDenominator != 0 &&
+            QuicDataPathEmulRandom(&ProcContext->EmulPrngState) %
+                Config->LossDenominator == 0) {
+            *DropChainTail = Datagram;
+            DropChainTail = &Datagram->Next;
+            continue;
+        }
+
+        //
+        // The serialization time on the emulated link delays this datagram
+        // and everything behind it; propagation delay and jitter only delay
+        // this one.
+        //
+        if (Config->BandwidthKbps != 0) {
+            if (ProcContext->EmulNextFreeTimeUs < TimeNow) {
+                ProcContext->EmulNextFreeTimeUs = TimeNow;
+            }
+            ProcContext->EmulNextFreeTimeUs +=
+                (Datagram->BufferLength * 8000ull) / Config->BandwidthKbps;
+        }
+
+        uint64_t DeliverTimeUs =
+            (Config->BandwidthKbps != 0 ?
+                ProcContext->EmulNextFreeTimeUs : TimeNow) +
+            Config->DelayUs;
+        if (Config->JitterUs != 0) {
+            DeliverTimeUs +=
+                QuicDataPathEmulRandom(&ProcContext->EmulPrngState) %
+                    (Config->JitterUs + 1);
+        }
+        if (Config->ReorderDenominator != 0 &&
+            QuicDataPathEmulRandom(&ProcContext->EmulPrngState) %
+                Config->ReorderDenominator == 0) {
+            //
+            // Hold the datagram back long enough that datagrams behind it
+            // (at the same delay) arrive first.
+            //
+            DeliverTimeUs += Config->DelayUs / 4 + Config->JitterUs + 1000;
+        }
+
+        if (DeliverTimeUs <= TimeNow &&
+            QuicListIsEmpty(&ProcContext->EmulQueue)) {
+            //
+            // Nothing ahead of it and no delay to apply.
+            //
+            Datapath->RecvHandler(Binding, Binding->ClientContext, Datagram);
+            continue;
+        }
+
+        QUIC_DATAPATH_EMUL_ENTRY* Entry =
+            QUIC_ALLOC_NONPAGED(sizeof(QUIC_DATAPATH_EMUL_ENTRY));
+        if (Entry == NULL) {
+            //
+            // Deliver immediately rather than drop; an allocation failure
+            // shouldn't masquerade as emulated loss.
+            //
+            Datapath->RecvHandler(Binding, Binding->ClientContext, Datagram);
+            continue;
+        }
+        Entry->Binding = Binding;
+        Entry->Datagram = Datagram;
+        Entry->DeliverTimeUs = DeliverTimeUs;
+
+        //
+        // Insert in delivery time order, scanning from the tail since
+        // entries almost always arrive in order.
+        //
+        QUIC_LIST_ENTRY* Link = ProcContext->EmulQueue.Blink;
+        while (Link != &ProcContext->EmulQueue &&
+            QUIC_CONTAINING_RECORD(
+                Link, QUIC_DATAPATH_EMUL_ENTRY, Link)->DeliverTimeUs >
+                DeliverTimeUs) {
+            Link = Link->Blink;
+        }
+        Entry->Link.Flink = Link->Flink;
+        Entry->Link.Blink = Link;
+        Link->Flink->Blink = &Entry->Link;
+        Link->Flink = &Entry->Link;
+        //
+        // Sticky across the chain: any datagram that lands at the queue
+        // head needs the timer (re)armed, even if later datagrams in the
+        // same chain insert behind it.
+        //
+        ArmTimer |= (ProcContext->EmulQueue.Flink == &Entry->Link);
+    }
+
+    if (DropChain != NULL) {
+        QuicDataPathBindingReturnRecvDatagrams(DropChain);
+    }
+    if (ArmTimer) {
+        QuicDataPathEmulArmTimer(ProcContext);
+    }
+}
+
+QUIC_STATUS
+QuicDataPathSetEmulation(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_opt_ const QUIC_DATAPATH_EMULATION_CONFIG* Config
+    )
+{
+#ifdef QUIC_PLATFORM_DISPATCH_TABLE
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(Config);
+    return QUIC_STATUS_NOT_SUPPORTED;
+#else
+    if (Datapath->UseUring) {
+        //
+        // The io_uring worker loop doesn't poll the emulation timer.
+        //
+        return QUIC_STATUS_NOT_SUPPORTED;
+    }
+
+    if (Config == NULL) {
+        Datapath->EmulationEnabled = FALSE;
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    Datapath->Emulation = *Config;
+    for (uint32_t i = 0; i < Datapath->ProcCount; i++) {
+        //
+        // Give each processor's generator a distinct but seed-derived state.
+        // Xorshift sticks at zero, so avoid it.
+        //
+        uint32_t State = (Config->RandomSeed + 1) * (i + 0x9E3779B9u);
+        Datapath->ProcContexts[i].EmulPrngState = State != 0 ? State : 1;
+        Datapath->ProcContexts[i].EmulNextFreeTimeUs = 0;
+    }
+    Datapath->EmulationEnabled = TRUE;
+    return QUIC_STATUS_SUCCESS;
+#endif
+}
+
 void
 QuicSocketContextUninitializeComplete(
     _In_ QUIC_SOCKET_CONTEXT* SocketContext,
     _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
     )
 {
-    if (SocketContext->CurrentRecvBlock != NULL) {
-        QuicDataPathBindingReturnRecvDatagrams(&SocketContext->CurrentRecvBlock->RecvPacket);
+    for (uint32_t i = 0; i < QUIC_MAX_BATCH_RECEIVE; ++i) {
+        if (SocketContext->CurrentRecvBlocks[i] != NULL) {
+            QuicDataPathBindingReturnRecvDatagrams(
+                &SocketContext->CurrentRecvBlocks[i]->RecvPacket);
+        }
     }
 
+    QuicDataPathEmulPurgeBinding(ProcContext, SocketContext->Binding);
+
     while (!QuicListIsEmpty(&SocketContext->PendingSendContextHead)) {
         QuicDataPathBindingFreeSendContext(
             QUIC_CONTAINING_RECORD(
@@ -1075,6 +3493,25 @@ QuicSocketContextUninitializeComplete(
                 PendingSendLinkage));
     }
 
+    //
+    // The socket is going away, so any zero-copy completions still
+    // outstanding are dropped along with it.
+    //
+    while (!QuicListIsEmpty(&SocketContext->ZeroCopyInFlightHead)) {
+        QuicDataPathBindingFreeSendContext(
+            QUIC_CONTAINING_RECORD(
+                QuicListRemoveHead(&SocketContext->ZeroCopyInFlightHead),
+                QUIC_DATAPATH_SEND_CONTEXT,
+                PendingSendLinkage));
+    }
+    QuicDispatchLockUninitialize(&SocketContext->ZeroCopyLock);
+    QuicDispatchLockUninitialize(&SocketContext->PendingSendLock);
+
+    if (SocketContext->CoalescedRecvBuffer != NULL) {
+        QUIC_FREE(SocketContext->CoalescedRecvBuffer);
+        SocketContext->CoalescedRecvBuffer = NULL;
+    }
+
     epoll_ctl(ProcContext->EpollFd, EPOLL_CTL_DEL, SocketContext->SocketFd, NULL);
     epoll_ctl(ProcContext->EpollFd, EPOLL_CTL_DEL, SocketContext->CleanupFd, NULL);
     close(SocketContext->CleanupFd);
@@ -1088,35 +3525,59 @@ QuicSocketContextPrepareReceive(
     _In_ QUIC_SOCKET_CONTEXT* SocketContext
     )
 {
-    if (SocketContext->CurrentRecvBlock == NULL) {
-        SocketContext->CurrentRecvBlock =
-            QuicDataPathAllocRecvBlock(
-                SocketContext->Binding->Datapath,
-                QuicProcCurrentNumber());
-        if (SocketContext->CurrentRecvBlock == NULL) {
-            QuicTraceEvent(
-                AllocFailure,
-                "Allocation of '%s' failed. (%llu bytes)",
-                "QUIC_DATAPATH_RECV_BLOCK",
-                0);
-            return QUIC_STATUS_OUT_OF_MEMORY;
+    for (uint32_t i = 0;
+         i < SocketContext->Binding->Datapath->RecvBatchCount;
+         ++i) {
+        if (SocketContext->CurrentRecvBlocks[i] == NULL) {
+            SocketContext->CurrentRecvBlocks[i] =
+                QuicDataPathAllocRecvBlock(
+                    SocketContext->Binding->Datapath,
+                    QuicProcCurrentNumber(),
+                    FALSE);
+            if (SocketContext->CurrentRecvBlocks[i] == NULL) {
+                QuicTraceEvent(
+                    AllocFailure,
+                    "Allocation of '%s' failed. (%llu bytes)",
+                    "QUIC_DATAPATH_RECV_BLOCK",
+                    0);
+                return QUIC_STATUS_OUT_OF_MEMORY;
+            }
         }
-    }
 
-    SocketContext->RecvIov.iov_base = SocketContext->CurrentRecvBlock->RecvPacket.Buffer;
-    SocketContext->CurrentRecvBlock->RecvPacket.BufferLength = SocketContext->RecvIov.iov_len;
-    SocketContext->CurrentRecvBlock->RecvPacket.Tuple = (QUIC_TUPLE*)&SocketContext->CurrentRecvBlock->Tuple;
+        QUIC_DATAPATH_RECV_BLOCK* RecvBlock = SocketContext->CurrentRecvBlocks[i];
+
+        if (SocketContext->CoalescedRecvBuffer != NULL) {
+            //
+            // With receive coalescing the payload lands in the staging
+            // buffer and is split into receive blocks afterwards; the
+            // pre-allocated block just holds the first segment's headers.
+            //
+            SocketContext->RecvIov[i].iov_base =
+                SocketContext->CoalescedRecvBuffer +
+                    (size_t)i * QUIC_COALESCED_RECV_BUFFER_LENGTH;
+        } else {
+            SocketContext->RecvIov[i].iov_base = RecvBlock->RecvPacket.Buffer;
+        }
+        RecvBlock->RecvPacket.BufferLength = SocketContext->RecvIov[i].iov_len;
+        RecvBlock->RecvPacket.Tuple = (QUIC_TUPLE*)&RecvBlock->Tuple;
 
-    QuicZeroMemory(&SocketContext->RecvMsgHdr, sizeof(SocketContext->RecvMsgHdr));
-    QuicZeroMemory(&SocketContext->RecvMsgControl, sizeof(SocketContext->RecvMsgControl));
+        struct msghdr* MsgHdr = &SocketContext->RecvMsgHdr[i].msg_hdr;
 
-    SocketContext->RecvMsgHdr.msg_name = &SocketContext->CurrentRecvBlock->RecvPacket.Tuple->RemoteAddress;
-    SocketContext->RecvMsgHdr.msg_namelen = sizeof(SocketContext->CurrentRecvBlock->RecvPacket.Tuple->RemoteAddress);
-    SocketContext->RecvMsgHdr.msg_iov = &SocketContext->RecvIov;
-    SocketContext->RecvMsgHdr.msg_iovlen = 1;
-    SocketContext->RecvMsgHdr.msg_control = SocketContext->RecvMsgControl;
-    SocketContext->RecvMsgHdr.msg_controllen = sizeof(SocketContext->RecvMsgControl);
-    SocketContext->RecvMsgHdr.msg_flags = 0;
+        QuicZeroMemory(MsgHdr, sizeof(*MsgHdr));
+        QuicZeroMemory(
+            &SocketContext->RecvMsgControl[i],
+            sizeof(SocketContext->RecvMsgControl[i]));
+
+        MsgHdr->msg_name = &RecvBlock->RecvPacket.Tuple->RemoteAddress;
+        MsgHdr->msg_namelen = sizeof(RecvBlock->RecvPacket.Tuple->RemoteAddress);
+        MsgHdr->msg_iov = &SocketContext->RecvIov[i];
+        MsgHdr->msg_iovlen = 1;
+        MsgHdr->msg_control = SocketContext->RecvMsgControl[i];
+        MsgHdr->msg_controllen = sizeof(SocketContext->RecvMsgControl[i]);
+        MsgHdr->msg_flags = 0;
+
+        SocketContext->RecvMsgHdr[i].msg_len = 0;
+    }
 
     return QUIC_STATUS_SUCCESS;
 }
@@ -1124,7 +3585,7 @@ QuicSocketContextPrepareReceive(
 QUIC_STATUS
 QuicSocketContextStartReceive(
     _In_ QUIC_SOCKET_CONTEXT* SocketContext,
-    _In_ int EpollFd
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
     )
 {
     QUIC_STATUS Status = QuicSocketContextPrepareReceive(SocketContext);
@@ -1132,6 +3593,38 @@ QuicSocketContextStartReceive(
         goto Error;
     }
 
+#ifdef QUIC_DATAPATH_URING
+    if (SocketContext->Binding->Datapath->UseUring) {
+        //
+        // Arm one-shot polls for the cleanup event and the socket. They are
+        // re-armed by the completion loop as they fire.
+        //
+        Status =
+            QuicUringSubmitPoll(
+                &ProcContext->Uring,
+                SocketContext->CleanupFd,
+                POLLIN,
+                &SocketContext->EventContexts[QUIC_SOCK_EVENT_CLEANUP]);
+        if (QUIC_FAILED(Status)) {
+            goto Error;
+        }
+        InterlockedIncrement(&SocketContext->UringPollsOutstanding);
+
+        Status =
+            QuicUringSubmitPoll(
+                &ProcContext->Uring,
+                SocketContext->SocketFd,
+                POLLIN,
+                &SocketContext->EventContexts[QUIC_SOCK_EVENT_SOCKET]);
+        if (QUIC_FAILED(Status)) {
+            goto Error;
+        }
+        InterlockedIncrement(&SocketContext->UringPollsOutstanding);
+
+        goto Error;
+    }
+#endif
+
     struct epoll_event SockFdEpEvt = {
         .events = EPOLLIN | EPOLLET,
         .data = {
@@ -1141,7 +3634,7 @@ QuicSocketContextStartReceive(
 
     int Ret =
         epoll_ctl(
-            EpollFd,
+            ProcContext->EpollFd,
             EPOLL_CTL_ADD,
             SocketContext->SocketFd,
             &SockFdEpEvt);
@@ -1170,72 +3663,238 @@ void
 QuicSocketContextRecvComplete(
     _In_ QUIC_SOCKET_CONTEXT* SocketContext,
     _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
-    _In_ ssize_t BytesTransferred
+    _In_ unsigned int MessagesReceived
     )
 {
     QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
 
-    QUIC_DBG_ASSERT(SocketContext->CurrentRecvBlock != NULL);
-    QUIC_RECV_DATAGRAM* RecvPacket = &SocketContext->CurrentRecvBlock->RecvPacket;
-    SocketContext->CurrentRecvBlock = NULL;
-
-    BOOLEAN FoundLocalAddr = FALSE;
-    QUIC_ADDR* LocalAddr = &RecvPacket->Tuple->LocalAddress;
-    QUIC_ADDR* RemoteAddr = &RecvPacket->Tuple->RemoteAddress;
-    QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
-
-    struct cmsghdr *CMsg;
-    for (CMsg = CMSG_FIRSTHDR(&SocketContext->RecvMsgHdr);
-         CMsg != NULL;
-         CMsg = CMSG_NXTHDR(&SocketContext->RecvMsgHdr, CMsg)) {
-
-        if (CMsg->cmsg_level == IPPROTO_IPV6 &&
-            CMsg->cmsg_type == IPV6_PKTINFO) {
-            struct in6_pktinfo* PktInfo6 = (struct in6_pktinfo*) CMSG_DATA(CMsg);
-            LocalAddr->si_family = AF_INET6;
-            LocalAddr->Ipv6.sin6_addr = PktInfo6->ipi6_addr;
-            LocalAddr->Ipv6.sin6_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
-            QuicConvertFromMappedV6(LocalAddr, LocalAddr);
-
-            LocalAddr->Ipv6.sin6_scope_id = PktInfo6->ipi6_ifindex;
-            FoundLocalAddr = TRUE;
-            break;
+    QUIC_RECV_DATAGRAM* DatagramChain = NULL;
+    QUIC_RECV_DATAGRAM** DatagramChainTail = &DatagramChain;
+
+    //
+    // Anchors for converting the kernel's CLOCK_REALTIME receive timestamps
+    // into the QuicTimeUs64 time domain: the queue delay measured against
+    // the realtime clock is subtracted from the current QUIC time.
+    //
+    uint64_t AnchorQuicTimeUs = QuicTimeUs64();
+    struct timespec AnchorRealtime;
+    clock_gettime(CLOCK_REALTIME, &AnchorRealtime);
+
+    for (unsigned int MessageIndex = 0;
+         MessageIndex < MessagesReceived;
+         ++MessageIndex) {
+
+        QUIC_DBG_ASSERT(SocketContext->CurrentRecvBlocks[MessageIndex] != NULL);
+        QUIC_RECV_DATAGRAM* RecvPacket =
+            &SocketContext->CurrentRecvBlocks[MessageIndex]->RecvPacket;
+        SocketContext->CurrentRecvBlocks[MessageIndex] = NULL;
+
+        struct msghdr* MsgHdr =
+            &SocketContext->RecvMsgHdr[MessageIndex].msg_hdr;
+        ssize_t BytesTransferred =
+            SocketContext->RecvMsgHdr[MessageIndex].msg_len;
+
+        BOOLEAN FoundLocalAddr = FALSE;
+        uint32_t SegmentLength = 0;
+        uint8_t TypeOfService = 0;
+        struct timespec KernelRecvTime = {0, 0};
+        QUIC_ADDR* LocalAddr = &RecvPacket->Tuple->LocalAddress;
+        QUIC_ADDR* RemoteAddr = &RecvPacket->Tuple->RemoteAddress;
+        QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
+
+        struct cmsghdr *CMsg;
+        for (CMsg = CMSG_FIRSTHDR(MsgHdr);
+             CMsg != NULL;
+             CMsg = CMSG_NXTHDR(MsgHdr, CMsg)) {
+
+            if (CMsg->cmsg_level == IPPROTO_IPV6 &&
+                CMsg->cmsg_type == IPV6_PKTINFO) {
+                struct in6_pktinfo* PktInfo6 = (struct in6_pktinfo*) CMSG_DATA(CMsg);
+                LocalAddr->si_family = AF_INET6;
+                LocalAddr->Ipv6.sin6_addr = PktInfo6->ipi6_addr;
+                LocalAddr->Ipv6.sin6_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
+                QuicConvertFromMappedV6(LocalAddr, LocalAddr);
+
+                LocalAddr->Ipv6.sin6_scope_id = PktInfo6->ipi6_ifindex;
+                FoundLocalAddr = TRUE;
+
+            } else if (CMsg->cmsg_level == IPPROTO_IP &&
+                CMsg->cmsg_type == IP_PKTINFO) {
+                struct in_pktinfo* PktInfo = (struct in_pktinfo*)CMSG_DATA(CMsg);
+                LocalAddr->si_family = AF_INET;
+                LocalAddr->Ipv4.sin_addr = PktInfo->ipi_addr;
+                LocalAddr->Ipv4.sin_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
+                LocalAddr->Ipv6.sin6_scope_id = PktInfo->ipi_ifindex;
+                FoundLocalAddr = TRUE;
+
+            } else if (CMsg->cmsg_level == IPPROTO_IPV6 &&
+                CMsg->cmsg_type == IPV6_TCLASS) {
+                TypeOfService = (uint8_t)*(int*)CMSG_DATA(CMsg);
+
+            } else if (CMsg->cmsg_level == IPPROTO_IP &&
+                CMsg->cmsg_type == IP_TOS) {
+                TypeOfService = *(uint8_t*)CMSG_DATA(CMsg);
+
+            } else if (CMsg->cmsg_level == SOL_UDP &&
+                CMsg->cmsg_type == UDP_GRO) {
+                //
+                // The kernel coalesced several datagrams into this message.
+                // This carries the size of the individual datagrams.
+                //
+                SegmentLength = (uint32_t)*(int*)CMSG_DATA(CMsg);
+
+            } else if (CMsg->cmsg_level == SOL_SOCKET &&
+                CMsg->cmsg_type == SCM_TIMESTAMPING) {
+                //
+                // ts[0] is the kernel's software receive timestamp. The raw
+                // hardware timestamp (ts[2]) is in the NIC's PHC clock
+                // domain and is not usable here without PHC synchronization.
+                //
+                KernelRecvTime =
+                    ((struct scm_timestamping*)CMSG_DATA(CMsg))->ts[0];
+            }
         }
 
-        if (CMsg->cmsg_level == IPPROTO_IP && CMsg->cmsg_type == IP_PKTINFO) {
-            struct in_pktinfo* PktInfo = (struct in_pktinfo*)CMSG_DATA(CMsg);
-            LocalAddr->si_family = AF_INET;
-            LocalAddr->Ipv4.sin_addr = PktInfo->ipi_addr;
-            LocalAddr->Ipv4.sin_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
-            LocalAddr->Ipv6.sin6_scope_id = PktInfo->ipi_ifindex;
-            FoundLocalAddr = TRUE;
-            break;
+        QUIC_FRE_ASSERT(FoundLocalAddr);
+
+        //
+        // Convert the kernel receive timestamp (if present) into the QUIC
+        // time domain by subtracting the measured queue delay from the
+        // current time. Negative deltas (clock adjustments) fall back to the
+        // anchor time.
+        //
+        uint64_t RecvTimeUs = AnchorQuicTimeUs;
+        if (KernelRecvTime.tv_sec != 0) {
+            int64_t QueueDelayUs =
+                (int64_t)(AnchorRealtime.tv_sec - KernelRecvTime.tv_sec) *
+                    QUIC_MICROSEC_PER_SEC +
+                (AnchorRealtime.tv_nsec - KernelRecvTime.tv_nsec) / 1000;
+            if (QueueDelayUs > 0 && (uint64_t)QueueDelayUs < AnchorQuicTimeUs) {
+                RecvTimeUs = AnchorQuicTimeUs - (uint64_t)QueueDelayUs;
+            }
         }
-    }
 
-    QUIC_FRE_ASSERT(FoundLocalAddr);
+        if (SegmentLength == 0) {
+            SegmentLength = (uint32_t)BytesTransferred;
+        }
 
-    QuicTraceEvent(
-        DatapathRecv,
-        "[ udp][%p] Recv %u bytes (segment=%hu) Src=%!SOCKADDR! Dst=%!SOCKADDR!",
-        SocketContext->Binding,
-        (uint32_t)BytesTransferred,
-        (uint32_t)BytesTransferred,
-        LOG_ADDR_LEN(*LocalAddr),
-        LOG_ADDR_LEN(*RemoteAddr),
-        (uint8_t*)LocalAddr,
-        (uint8_t*)RemoteAddr);
-
-    QUIC_DBG_ASSERT(BytesTransferred <= RecvPacket->BufferLength);
-    RecvPacket->BufferLength = BytesTransferred;
-
-    RecvPacket->PartitionIndex = ProcContext->Index;
-
-    QUIC_DBG_ASSERT(SocketContext->Binding->Datapath->RecvHandler);
-    SocketContext->Binding->Datapath->RecvHandler(
-        SocketContext->Binding,
-        SocketContext->Binding->ClientContext,
-        RecvPacket);
+        QuicTraceEvent(
+            DatapathRecv,
+            "[ udp][%p] Recv %u bytes (segment=%hu) Src=%!SOCKADDR! Dst=%!SOCKADDR!",
+            SocketContext->Binding,
+            (uint32_t)BytesTransferred,
+            SegmentLength,
+            LOG_ADDR_LEN(*LocalAddr),
+            LOG_ADDR_LEN(*RemoteAddr),
+            (uint8_t*)LocalAddr,
+            (uint8_t*)RemoteAddr);
+
+        QUIC_DBG_ASSERT(BytesTransferred <= RecvPacket->BufferLength);
+
+        if (SocketContext->CoalescedRecvBuffer == NULL) {
+            RecvPacket->BufferLength = BytesTransferred;
+
+            RecvPacket->RecvTimeUs = RecvTimeUs;
+            RecvPacket->PartitionIndex = ProcContext->Index;
+            RecvPacket->TypeOfService = TypeOfService;
+
+            //
+            // Add the datagram to the chain to deliver to the upper layer in
+            // a single indication.
+            //
+            *DatagramChainTail = RecvPacket;
+            DatagramChainTail = &RecvPacket->Next;
+
+        } else {
+            //
+            // The payload is in the staging buffer and may hold several
+            // coalesced datagrams. Split it into per-datagram receive blocks
+            // by the segment size, reusing the pre-allocated block (which
+            // already holds the addresses) for the first segment.
+            //
+            QUIC_DATAPATH_RECV_BLOCK* RecvBlock =
+                QUIC_CONTAINING_RECORD(
+                    RecvPacket, QUIC_DATAPATH_RECV_BLOCK, RecvPacket);
+            QUIC_TUPLE Tuple = RecvBlock->Tuple;
+            const uint8_t* Payload =
+                SocketContext->CoalescedRecvBuffer +
+                    (size_t)MessageIndex * QUIC_COALESCED_RECV_BUFFER_LENGTH;
+            uint32_t Remaining = (uint32_t)BytesTransferred;
+
+            do {
+                uint32_t Length = min(SegmentLength, Remaining);
+                if (Length > MAX_JUMBO_UDP_PAYLOAD_LENGTH) {
+                    //
+                    // Larger than any valid QUIC datagram; drop the rest of
+                    // the message.
+                    //
+                    break;
+                }
+
+                if (RecvBlock != NULL && Length > MAX_UDP_PAYLOAD_LENGTH) {
+                    //
+                    // The pre-allocated block's buffer is too small for a
+                    // jumbo sized segment. Return it and allocate a jumbo
+                    // block instead.
+                    //
+                    QuicDataPathFreeRecvBlock(RecvBlock);
+                    RecvBlock = NULL;
+                }
+
+                if (RecvBlock == NULL) {
+                    RecvBlock =
+                        QuicDataPathAllocRecvBlock(
+                            SocketContext->Binding->Datapath,
+                            QuicProcCurrentNumber(),
+                            Length > MAX_UDP_PAYLOAD_LENGTH);
+                    if (RecvBlock == NULL) {
+                        QuicTraceEvent(
+                            AllocFailure,
+                            "Allocation of '%s' failed. (%llu bytes)",
+                            "QUIC_DATAPATH_RECV_BLOCK",
+                            0);
+                        break;
+                    }
+                    RecvBlock->Tuple = Tuple;
+                    RecvBlock->RecvPacket.Tuple = (QUIC_TUPLE*)&RecvBlock->Tuple;
+                }
+
+                QuicCopyMemory(RecvBlock->RecvPacket.Buffer, Payload, Length);
+                RecvBlock->RecvPacket.BufferLength = Length;
+                RecvBlock->RecvPacket.RecvTimeUs = RecvTimeUs;
+                RecvBlock->RecvPacket.PartitionIndex = ProcContext->Index;
+                RecvBlock->RecvPacket.TypeOfService = TypeOfService;
+
+                *DatagramChainTail = &RecvBlock->RecvPacket;
+                DatagramChainTail = &RecvBlock->RecvPacket.Next;
+                RecvBlock = NULL;
+
+                Payload += Length;
+                Remaining -= Length;
+            } while (Remaining != 0);
+
+            if (RecvBlock != NULL) {
+                //
+                // The pre-allocated block went unused (the whole message was
+                // dropped).
+                //
+                QuicDataPathFreeRecvBlock(RecvBlock);
+            }
+        }
+    }
+
+    if (DatagramChain != NULL) {
+        QUIC_DBG_ASSERT(SocketContext->Binding->Datapath->RecvHandler);
+        if (SocketContext->Binding->Datapath->EmulationEnabled) {
+            QuicDataPathEmulDeliver(
+                ProcContext, SocketContext->Binding, DatagramChain);
+        } else {
+            SocketContext->Binding->Datapath->RecvHandler(
+                SocketContext->Binding,
+                SocketContext->Binding->ClientContext,
+                DatagramChain);
+        }
+    }
 
     Status = QuicSocketContextPrepareReceive(SocketContext);
 
@@ -1255,8 +3914,34 @@ QuicSocketContextPendSend(
     _In_ const QUIC_ADDR* RemoteAddress
     )
 {
+    QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
+
+    QuicDispatchLockAcquire(&SocketContext->PendingSendLock);
+
     if (!SocketContext->SendWaiting) {
 
+#ifdef QUIC_DATAPATH_URING
+        if (SocketContext->Binding->Datapath->UseUring) {
+            Status =
+                QuicUringSubmitPoll(
+                    &ProcContext->Uring,
+                    SocketContext->SocketFd,
+                    POLLOUT,
+                    &SocketContext->EventContexts[QUIC_SOCK_EVENT_WRITE]);
+            if (QUIC_FAILED(Status)) {
+                QuicTraceEvent(
+                    DatapathErrorStatus,
+                    "[ udp][%p] ERROR, %u, %s.",
+                    SocketContext->Binding,
+                    Status,
+                    "QuicUringSubmitPoll(POLLOUT) failed");
+                goto Exit;
+            }
+            InterlockedIncrement(&SocketContext->UringPollsOutstanding);
+            goto ArmDone;
+        }
+#endif
+
         struct epoll_event SockFdEpEvt = {
             .events = EPOLLIN | EPOLLOUT | EPOLLET,
             .data = {
@@ -1271,51 +3956,61 @@ QuicSocketContextPendSend(
                 SocketContext->SocketFd,
                 &SockFdEpEvt);
         if (Ret != 0) {
+            Status = errno;
             QuicTraceEvent(
                 DatapathErrorStatus,
                 "[ udp][%p] ERROR, %u, %s.",
                 SocketContext->Binding,
-                errno,
+                Status,
                 "epoll_ctl failed");
-            return errno;
-        }
-
-        if (LocalAddress != NULL) {
-            QuicCopyMemory(
-                &SendContext->LocalAddress,
-                LocalAddress,
-                sizeof(*LocalAddress));
-            SendContext->Bind = TRUE;
+            goto Exit;
         }
 
-        QuicCopyMemory(
-            &SendContext->RemoteAddress,
-            RemoteAddress,
-            sizeof(*RemoteAddress));
-
+#ifdef QUIC_DATAPATH_URING
+ArmDone:
+#endif
         SocketContext->SendWaiting = TRUE;
     }
 
     if (SendContext->Pending) {
         //
         // This was a send that was already pending, so we need to add it back
-        // to the head of the queue.
+        // to the head of the queue. It already holds its addresses from when
+        // it was first pended.
         //
         QuicListInsertHead(
             &SocketContext->PendingSendContextHead,
             &SendContext->PendingSendLinkage);
     } else {
         //
-        // This is a new send that wasn't previously pended. Add it to the end
-        // of the queue.
+        // This is a new send that wasn't previously pended. Stash the
+        // addresses for the eventual retry and add it to the end of the
+        // queue.
         //
+        if (LocalAddress != NULL) {
+            QuicCopyMemory(
+                &SendContext->LocalAddress,
+                LocalAddress,
+                sizeof(*LocalAddress));
+            SendContext->Bind = TRUE;
+        }
+
+        QuicCopyMemory(
+            &SendContext->RemoteAddress,
+            RemoteAddress,
+            sizeof(*RemoteAddress));
+
         QuicListInsertTail(
             &SocketContext->PendingSendContextHead,
             &SendContext->PendingSendLinkage);
         SendContext->Pending = TRUE;
     }
 
-    return QUIC_STATUS_SUCCESS;
+Exit:
+
+    QuicDispatchLockRelease(&SocketContext->PendingSendLock);
+
+    return Status;
 }
 
 QUIC_STATUS
@@ -1326,8 +4021,21 @@ QuicSocketContextSendComplete(
 {
     QUIC_STATUS Status = QUIC_STATUS_SUCCESS;
 
+    QuicDispatchLockAcquire(&SocketContext->PendingSendLock);
+
     if (SocketContext->SendWaiting) {
 
+#ifdef QUIC_DATAPATH_URING
+        if (SocketContext->Binding->Datapath->UseUring) {
+            //
+            // The write readiness poll was one-shot, so there is nothing to
+            // deregister.
+            //
+            SocketContext->SendWaiting = FALSE;
+            goto Rearmed;
+        }
+#endif
+
         struct epoll_event SockFdEpEvt = {
             .events = EPOLLIN | EPOLLET,
             .data = {
@@ -1349,32 +4057,48 @@ QuicSocketContextSendComplete(
                 SocketContext->Binding,
                 Status,
                 "epoll_ctl failed");
+            QuicDispatchLockRelease(&SocketContext->PendingSendLock);
             goto Exit;
         }
 
         SocketContext->SendWaiting = FALSE;
     }
 
-    while (!QuicListIsEmpty(&SocketContext->PendingSendContextHead)) {
+#ifdef QUIC_DATAPATH_URING
+Rearmed:
+#endif
+
+    QuicDispatchLockRelease(&SocketContext->PendingSendLock);
+
+    //
+    // Drain the pending sends, popping each under the lock but sending
+    // outside it, since the send takes the lock itself if it has to pend
+    // again.
+    //
+    for (;;) {
+        QuicDispatchLockAcquire(&SocketContext->PendingSendLock);
+        if (SocketContext->SendWaiting ||
+            QuicListIsEmpty(&SocketContext->PendingSendContextHead)) {
+            QuicDispatchLockRelease(&SocketContext->PendingSendLock);
+            break;
+        }
         QUIC_DATAPATH_SEND_CONTEXT* SendContext =
             QUIC_CONTAINING_RECORD(
                 QuicListRemoveHead(&SocketContext->PendingSendContextHead),
                 QUIC_DATAPATH_SEND_CONTEXT,
                 PendingSendLinkage);
+        QuicDispatchLockRelease(&SocketContext->PendingSendLock);
 
         Status =
             QuicDataPathBindingSend(
                 SocketContext->Binding,
                 SendContext->Bind ? &SendContext->LocalAddress : NULL,
                 &SendContext->RemoteAddress,
+                NULL,
                 SendContext);
         if (QUIC_FAILED(Status)) {
             goto Exit;
         }
-
-        if (SocketContext->SendWaiting) {
-            break;
-        }
     }
 
 Exit:
@@ -1390,6 +4114,24 @@ QuicSocketContextProcessEvents(
     )
 {
     uint8_t EventType = *(uint8_t*)EventPtr;
+
+#ifdef QUIC_DATAPATH_XDP
+    if (EventType == QUIC_SOCK_EVENT_XSK) {
+        QuicXskQueueProcessReceives(
+            QUIC_CONTAINING_RECORD(
+                (uint8_t*)EventPtr, QUIC_XSK_QUEUE, EventType));
+        return;
+    }
+#endif
+
+    if (EventType == QUIC_SOCK_EVENT_EMUL_TIMER) {
+        QuicDataPathEmulProcessTimer(
+            QUIC_CONTAINING_RECORD(
+                (uint8_t*)EventPtr, QUIC_DATAPATH_PROC_CONTEXT,
+                EmulTimerEventType));
+        return;
+    }
+
     QUIC_SOCKET_CONTEXT* SocketContext =
         ((QUIC_SOCKET_CONTEXT*)( \
             (uint8_t*)(EventPtr) - \
@@ -1404,7 +4146,98 @@ QuicSocketContextProcessEvents(
 
     QUIC_DBG_ASSERT(EventType == QUIC_SOCK_EVENT_SOCKET);
 
+    QuicSocketContextProcessSocketEvents(SocketContext, ProcContext, Events);
+}
+
+//
+// Drains zero-copy completion notifications from the socket's error queue and
+// frees the send contexts whose buffers the kernel has finished reading.
+//
+void
+QuicSocketContextRecvZeroCopyCompletions(
+    _In_ QUIC_SOCKET_CONTEXT* SocketContext
+    )
+{
+    while (TRUE) {
+        char Control[CMSG_SPACE(sizeof(struct sock_extended_err))] = {0};
+        struct msghdr Msg = {
+            .msg_control = Control,
+            .msg_controllen = sizeof(Control)
+        };
+
+        if (recvmsg(SocketContext->SocketFd, &Msg, MSG_ERRQUEUE) < 0) {
+            break; // Nothing (more) queued.
+        }
+
+        for (struct cmsghdr* CMsg = CMSG_FIRSTHDR(&Msg);
+             CMsg != NULL;
+             CMsg = CMSG_NXTHDR(&Msg, CMsg)) {
+
+            if ((CMsg->cmsg_level != SOL_IP || CMsg->cmsg_type != IP_RECVERR) &&
+                (CMsg->cmsg_level != SOL_IPV6 || CMsg->cmsg_type != IPV6_RECVERR)) {
+                continue;
+            }
+
+            struct sock_extended_err* SockErr =
+                (struct sock_extended_err*)CMSG_DATA(CMsg);
+            if (SockErr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            //
+            // ee_info through ee_data is the inclusive range of zero-copy
+            // send sequence numbers whose buffers the kernel is done with.
+            // Notifications arrive in order, so every in-flight context at
+            // or below the top of the range can be released.
+            //
+            uint32_t AckedSeq = SockErr->ee_data;
+            QUIC_LIST_ENTRY FreeList;
+            QuicListInitializeHead(&FreeList);
+
+            QuicDispatchLockAcquire(&SocketContext->ZeroCopyLock);
+            SocketContext->ZeroCopyAckedSeq = AckedSeq;
+            SocketContext->ZeroCopyAnyAcked = TRUE;
+            QUIC_LIST_ENTRY* Entry = SocketContext->ZeroCopyInFlightHead.Flink;
+            while (Entry != &SocketContext->ZeroCopyInFlightHead) {
+                QUIC_DATAPATH_SEND_CONTEXT* SendContext =
+                    QUIC_CONTAINING_RECORD(
+                        Entry, QUIC_DATAPATH_SEND_CONTEXT, PendingSendLinkage);
+                Entry = Entry->Flink;
+                if ((int32_t)(AckedSeq - SendContext->ZeroCopyLastSeq) >= 0) {
+                    QuicListEntryRemove(&SendContext->PendingSendLinkage);
+                    QuicListInsertTail(&FreeList, &SendContext->PendingSendLinkage);
+                }
+            }
+            QuicDispatchLockRelease(&SocketContext->ZeroCopyLock);
+
+            while (!QuicListIsEmpty(&FreeList)) {
+                QuicDataPathBindingFreeSendContext(
+                    QUIC_CONTAINING_RECORD(
+                        QuicListRemoveHead(&FreeList),
+                        QUIC_DATAPATH_SEND_CONTEXT,
+                        PendingSendLinkage));
+            }
+        }
+    }
+}
+
+void
+QuicSocketContextProcessSocketEvents(
+    _In_ QUIC_SOCKET_CONTEXT* SocketContext,
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ int Events
+    )
+{
     if (EPOLLERR & Events) {
+        //
+        // Zero-copy send completions are delivered through the error queue,
+        // so an error event doesn't necessarily indicate a problem. Drain
+        // the completions first.
+        //
+        if (SocketContext->ZeroCopyEnabled) {
+            QuicSocketContextRecvZeroCopyCompletions(SocketContext);
+        }
+
         int ErrNum = 0;
         socklen_t OptLen = sizeof(ErrNum);
         ssize_t Ret =
@@ -1421,7 +4254,7 @@ QuicSocketContextProcessEvents(
                 SocketContext->Binding,
                 errno,
                 "getsockopt(SO_ERROR) failed");
-        } else {
+        } else if (ErrNum != 0) {
             QuicTraceEvent(
                 DatapathErrorStatus,
                 "[ udp][%p] ERROR, %u, %s.",
@@ -1446,13 +4279,15 @@ QuicSocketContextProcessEvents(
 
     if (EPOLLIN & Events) {
         while (TRUE) {
-            QUIC_DBG_ASSERT(SocketContext->CurrentRecvBlock != NULL);
+            QUIC_DBG_ASSERT(SocketContext->CurrentRecvBlocks[0] != NULL);
 
-            ssize_t Ret =
-                recvmsg(
+            int Ret =
+                recvmmsg(
                     SocketContext->SocketFd,
-                    &SocketContext->RecvMsgHdr,
-                    0);
+                    SocketContext->RecvMsgHdr,
+                    SocketContext->Binding->Datapath->RecvBatchCount,
+                    0,
+                    NULL);
             if (Ret < 0) {
                 if (errno != EAGAIN && errno != EWOULDBLOCK) {
                     QuicTraceEvent(
@@ -1460,11 +4295,12 @@ QuicSocketContextProcessEvents(
                         "[ udp][%p] ERROR, %u, %s.",
                         SocketContext->Binding,
                         errno,
-                        "recvmsg failed");
+                        "recvmmsg failed");
                 }
                 break;
             } else {
-                QuicSocketContextRecvComplete(SocketContext, ProcContext, Ret);
+                QuicSocketContextRecvComplete(
+                    SocketContext, ProcContext, (unsigned int)Ret);
             }
         }
     }
@@ -1474,6 +4310,144 @@ QuicSocketContextProcessEvents(
     }
 }
 
+#ifdef QUIC_DATAPATH_URING
+
+//
+// Called when the cleanup event poll completes. Releases the resources the
+// epoll path releases in QuicSocketContextUninitializeComplete and cancels
+// the remaining polls for the socket. The final teardown happens once the
+// last outstanding poll completion has drained.
+//
+void
+QuicSocketContextUringCleanupStart(
+    _In_ QUIC_SOCKET_CONTEXT* SocketContext,
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
+    )
+{
+    QUIC_DBG_ASSERT(!SocketContext->UringCleanupStarted);
+    SocketContext->UringCleanupStarted = TRUE;
+
+    for (uint32_t i = 0; i < QUIC_MAX_BATCH_RECEIVE; ++i) {
+        if (SocketContext->CurrentRecvBlocks[i] != NULL) {
+            QuicDataPathBindingReturnRecvDatagrams(
+                &SocketContext->CurrentRecvBlocks[i]->RecvPacket);
+            SocketContext->CurrentRecvBlocks[i] = NULL;
+        }
+    }
+
+    while (!QuicListIsEmpty(&SocketContext->PendingSendContextHead)) {
+        QuicDataPathBindingFreeSendContext(
+            QUIC_CONTAINING_RECORD(
+                QuicListRemoveHead(&SocketContext->PendingSendContextHead),
+                QUIC_DATAPATH_SEND_CONTEXT,
+                PendingSendLinkage));
+    }
+
+    //
+    // The socket is going away, so any zero-copy completions still
+    // outstanding are dropped along with it.
+    //
+    while (!QuicListIsEmpty(&SocketContext->ZeroCopyInFlightHead)) {
+        QuicDataPathBindingFreeSendContext(
+            QUIC_CONTAINING_RECORD(
+                QuicListRemoveHead(&SocketContext->ZeroCopyInFlightHead),
+                QUIC_DATAPATH_SEND_CONTEXT,
+                PendingSendLinkage));
+    }
+    QuicDispatchLockUninitialize(&SocketContext->ZeroCopyLock);
+    QuicDispatchLockUninitialize(&SocketContext->PendingSendLock);
+
+    if (SocketContext->CoalescedRecvBuffer != NULL) {
+        QUIC_FREE(SocketContext->CoalescedRecvBuffer);
+        SocketContext->CoalescedRecvBuffer = NULL;
+    }
+
+    QuicUringSubmitPollRemove(
+        &ProcContext->Uring,
+        &SocketContext->EventContexts[QUIC_SOCK_EVENT_SOCKET]);
+    QuicUringSubmitPollRemove(
+        &ProcContext->Uring,
+        &SocketContext->EventContexts[QUIC_SOCK_EVENT_WRITE]);
+}
+
+void
+QuicDataPathUringProcessCqe(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ const struct io_uring_cqe* Cqe
+    )
+{
+    void* EventPtr = (void*)(uintptr_t)Cqe->user_data;
+    uint8_t EventType = *(uint8_t*)EventPtr;
+    QUIC_SOCKET_CONTEXT* SocketContext =
+        ((QUIC_SOCKET_CONTEXT*)( \
+            (uint8_t*)(EventPtr) - \
+            (size_t)(&((QUIC_SOCKET_CONTEXT*)0)->EventContexts) -
+            EventType));
+
+    if (EventType == QUIC_SOCK_EVENT_CLEANUP) {
+        QUIC_DBG_ASSERT(SocketContext->Binding->Shutdown);
+        QuicSocketContextUringCleanupStart(SocketContext, ProcContext);
+    } else if (Cqe->res >= 0 && !SocketContext->Binding->Shutdown) {
+        QuicSocketContextProcessSocketEvents(
+            SocketContext, ProcContext, Cqe->res);
+        if (EventType == QUIC_SOCK_EVENT_SOCKET) {
+            //
+            // Polls are one-shot, so re-arm the read poll.
+            //
+            QUIC_FRE_ASSERT(
+                QUIC_SUCCEEDED(
+                    QuicUringSubmitPoll(
+                        &ProcContext->Uring,
+                        SocketContext->SocketFd,
+                        POLLIN,
+                        EventPtr)));
+            InterlockedIncrement(&SocketContext->UringPollsOutstanding);
+        }
+    }
+
+    if (InterlockedDecrement(&SocketContext->UringPollsOutstanding) == 0) {
+        //
+        // All polls (including any canceled ones) have drained, so it is now
+        // safe to tear the socket context down.
+        //
+        QUIC_DBG_ASSERT(SocketContext->UringCleanupStarted);
+        close(SocketContext->CleanupFd);
+        close(SocketContext->SocketFd);
+        QuicRundownRelease(&SocketContext->Binding->Rundown);
+    }
+}
+
+void
+QuicDataPathUringWorkerLoop(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
+    )
+{
+    QUIC_URING* Ring = &ProcContext->Uring;
+
+    while (!ProcContext->Datapath->Shutdown) {
+        int Ret = QuicUringEnter(Ring->RingFd, 0, 1, IORING_ENTER_GETEVENTS);
+        QUIC_FRE_ASSERT(Ret >= 0);
+
+        struct io_uring_cqe Cqe;
+        while (QuicUringPopCqe(Ring, &Cqe)) {
+            if (Cqe.user_data == 0) {
+                //
+                // The processor context is shutting down and the worker
+                // thread needs to clean up.
+                //
+                QUIC_DBG_ASSERT(ProcContext->Datapath->Shutdown);
+                break;
+            }
+            if (Cqe.user_data == QUIC_URING_IGNORE_USER_DATA) {
+                continue;
+            }
+            QuicDataPathUringProcessCqe(ProcContext, &Cqe);
+        }
+    }
+}
+
+#endif // QUIC_DATAPATH_URING
+
 //
 // Datapath binding interface.
 //
@@ -1533,9 +4507,16 @@ QuicDataPathBindingCreate(
     for (uint32_t i = 0; i < SocketCount; i++) {
         Binding->SocketContexts[i].Binding = Binding;
         Binding->SocketContexts[i].SocketFd = INVALID_SOCKET_FD;
-        Binding->SocketContexts[i].RecvIov.iov_len =
-            Binding->Mtu - QUIC_MIN_IPV4_HEADER_SIZE - QUIC_UDP_HEADER_SIZE;
+        for (uint32_t j = 0; j < Datapath->RecvBatchCount; j++) {
+            Binding->SocketContexts[i].RecvIov[j].iov_len =
+                (Datapath->Features & QUIC_DATAPATH_FEATURE_RECV_COALESCING) ?
+                    QUIC_COALESCED_RECV_BUFFER_LENGTH :
+                    Binding->Mtu - QUIC_MIN_IPV4_HEADER_SIZE - QUIC_UDP_HEADER_SIZE;
+        }
         QuicListInitializeHead(&Binding->SocketContexts[i].PendingSendContextHead);
+        QuicDispatchLockInitialize(&Binding->SocketContexts[i].PendingSendLock);
+        QuicDispatchLockInitialize(&Binding->SocketContexts[i].ZeroCopyLock);
+        QuicListInitializeHead(&Binding->SocketContexts[i].ZeroCopyInFlightHead);
         QuicRundownAcquire(&Binding->Rundown);
     }
 
@@ -1572,12 +4553,24 @@ QuicDataPathBindingCreate(
         Status =
             QuicSocketContextStartReceive(
                 &Binding->SocketContexts[i],
-                Datapath->ProcContexts[i].EpollFd);
+                &Datapath->ProcContexts[i]);
         if (QUIC_FAILED(Status)) {
             goto Exit;
         }
     }
 
+#ifdef QUIC_DATAPATH_XDP
+    if (Datapath->UseXdp) {
+        //
+        // Make the binding visible to the XDP receive path. Frames for it
+        // that arrive before this point are dropped by the port lookup.
+        //
+        QuicDispatchLockAcquire(&Datapath->XdpBindingsLock);
+        QuicListInsertTail(&Datapath->XdpBindings, &Binding->XdpLink);
+        QuicDispatchLockRelease(&Datapath->XdpBindingsLock);
+    }
+#endif
+
     Status = QUIC_STATUS_SUCCESS;
 
 Exit:
@@ -1618,6 +4611,20 @@ QuicDataPathBindingDelete(
     //
 
     Binding->Shutdown = TRUE;
+
+#ifdef QUIC_DATAPATH_XDP
+    if (Binding->Datapath->UseXdp) {
+        //
+        // Hide the binding from the XDP receive path. After this no new
+        // rundown references are taken by it, so the wait below also covers
+        // any delivery still in progress.
+        //
+        QuicDispatchLockAcquire(&Binding->Datapath->XdpBindingsLock);
+        QuicListEntryRemove(&Binding->XdpLink);
+        QuicDispatchLockRelease(&Binding->Datapath->XdpBindingsLock);
+    }
+#endif
+
     for (uint32_t i = 0; i < Binding->Datapath->ProcCount; ++i) {
         QuicSocketContextUninitialize(
             &Binding->SocketContexts[i],
@@ -1754,7 +4761,12 @@ QuicDataPathBindingReturnRecvDatagrams(
         DatagramChain = DatagramChain->Next;
         QUIC_DATAPATH_RECV_BLOCK* RecvBlock =
             QUIC_CONTAINING_RECORD(Datagram, QUIC_DATAPATH_RECV_BLOCK, RecvPacket);
-        QuicPoolFree(RecvBlock->OwningPool, RecvBlock);
+#ifdef QUIC_DATAPATH_XDP
+        if (RecvBlock->XskQueue != NULL) {
+            QuicXskQueueReturnFrame(RecvBlock->XskQueue, RecvBlock->XskFrameAddr);
+        }
+#endif
+        QuicDataPathFreeRecvBlock(RecvBlock);
     }
 #endif
 }
@@ -1776,8 +4788,19 @@ QuicDataPathBindingAllocSendContext(
 
     QUIC_DATAPATH_PROC_CONTEXT* ProcContext =
         &Binding->Datapath->ProcContexts[QuicProcCurrentNumber()];
+
+    //
+    // Grab the parked context from the last completed send first. It was
+    // reset when it was parked and still holds its buffer allocations.
+    //
     QUIC_DATAPATH_SEND_CONTEXT* SendContext =
-        QuicPoolAlloc(&ProcContext->SendContextPool);
+        InterlockedExchangePointer(
+            (void* volatile*)&ProcContext->RecycledSendContext, NULL);
+    if (SendContext != NULL) {
+        goto Exit;
+    }
+
+    SendContext = QuicPoolAlloc(&ProcContext->SendContextPool);
     if (SendContext == NULL) {
         QuicTraceEvent(
             AllocFailure,
@@ -1804,15 +4827,67 @@ QuicDataPathBindingFreeSendContext(
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     PlatDispatch->DatapathBindingFreeSendContext(SendContext);
 #else
-    size_t i = 0;
-    for (i = 0; i < SendContext->BufferCount; ++i) {
+    QUIC_DATAPATH_PROC_CONTEXT* Owner = SendContext->Owner;
+
+    //
+    // Park the context, buffers and all, for the next send on this
+    // processor, so a paced bulk flow reaches steady state with zero pool
+    // operations per send. Only when the free happens on the owning
+    // processor, so a context never parks on a remote slot.
+    //
+    if (Owner == &Owner->Datapath->ProcContexts[QuicProcCurrentNumber()]) {
+        SendContext->Bind = FALSE;
+        SendContext->Pending = FALSE;
+        SendContext->EcnCodePoint = 0;
+        SendContext->ZeroCopyCount = 0;
+        SendContext->ZeroCopyLastSeq = 0;
+        SendContext->BufferCount = 0;
+        SendContext->CurrentIndex = 0;
+        if (InterlockedCompareExchangePointer(
+                (void* volatile*)&Owner->RecycledSendContext,
+                SendContext,
+                NULL) == NULL) {
+            return;
+        }
+    }
+
+    QuicSendContextRelease(SendContext);
+#endif
+}
+
+//
+// Returns a send context and any buffers it still holds to their pools.
+//
+void
+QuicSendContextRelease(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
+    )
+{
+    for (size_t i = 0; i < SendContext->RetainedBufferCount; ++i) {
+        if (SendContext->Buffers[i].Buffer == NULL) {
+            continue; // Hole left by a failed buffer allocation.
+        }
         QuicPoolFree(
-            &SendContext->Owner->SendBufferPool,
+            (SendContext->JumboBufferMask & (1u << i)) ?
+                &SendContext->Owner->JumboSendBufferPool :
+                &SendContext->Owner->SendBufferPool,
             SendContext->Buffers[i].Buffer);
         SendContext->Buffers[i].Buffer = NULL;
     }
 
     QuicPoolFree(&SendContext->Owner->SendContextPool, SendContext);
+}
+
+void
+QuicDataPathBindingSetEcnCodePoint(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext,
+    _In_ QUIC_ECN_TYPE EcnCodePoint
+    )
+{
+#ifdef QUIC_PLATFORM_DISPATCH_TABLE
+    PlatDispatch->DatapathBindingSetEcnCodePoint(SendContext, EcnCodePoint);
+#else
+    SendContext->EcnCodePoint = (uint8_t)EcnCodePoint;
 #endif
 }
 
@@ -1831,7 +4906,7 @@ QuicDataPathBindingAllocSendDatagram(
     QUIC_BUFFER* Buffer = NULL;
 
     QUIC_DBG_ASSERT(SendContext != NULL);
-    QUIC_DBG_ASSERT(MaxBufferLength <= QUIC_MAX_MTU - QUIC_MIN_IPV4_HEADER_SIZE - QUIC_UDP_HEADER_SIZE);
+    QUIC_DBG_ASSERT(MaxBufferLength <= MAX_JUMBO_UDP_PAYLOAD_LENGTH);
 
     if (SendContext->BufferCount ==
             SendContext->Owner->Datapath->MaxSendBatchSize) {
@@ -1843,16 +4918,49 @@ QuicDataPathBindingAllocSendDatagram(
     }
 
     Buffer = &SendContext->Buffers[SendContext->BufferCount];
-    QuicZeroMemory(Buffer, sizeof(*Buffer));
 
-    Buffer->Buffer = QuicPoolAlloc(&SendContext->Owner->SendBufferPool);
+    const BOOLEAN Jumbo = MaxBufferLength > MAX_UDP_PAYLOAD_LENGTH;
+
+    if (SendContext->BufferCount < SendContext->RetainedBufferCount &&
+        Buffer->Buffer != NULL) {
+        //
+        // This entry still holds the allocation from the context's previous
+        // use. Reuse it if it came from the right pool; otherwise return it
+        // and allocate fresh below.
+        //
+        if (!!(SendContext->JumboBufferMask & (1u << SendContext->BufferCount)) !=
+            Jumbo) {
+            QuicPoolFree(
+                Jumbo ?
+                    &SendContext->Owner->SendBufferPool :
+                    &SendContext->Owner->JumboSendBufferPool,
+                Buffer->Buffer);
+            Buffer->Buffer = NULL;
+        }
+    } else {
+        Buffer->Buffer = NULL;
+    }
+
     if (Buffer->Buffer == NULL) {
-        QuicTraceEvent(
-            AllocFailure,
-            "Allocation of '%s' failed. (%llu bytes)",
-            "Send Buffer",
-            0);
-        goto Exit;
+        Buffer->Buffer =
+            QuicPoolAlloc(
+                Jumbo ?
+                    &SendContext->Owner->JumboSendBufferPool :
+                    &SendContext->Owner->SendBufferPool);
+        if (Buffer->Buffer == NULL) {
+            QuicTraceEvent(
+                AllocFailure,
+                "Allocation of '%s' failed. (%llu bytes)",
+                "Send Buffer",
+                0);
+            goto Exit;
+        }
+    }
+
+    if (Jumbo) {
+        SendContext->JumboBufferMask |= 1u << SendContext->BufferCount;
+    } else {
+        SendContext->JumboBufferMask &= ~(1u << SendContext->BufferCount);
     }
 
     Buffer->Length = MaxBufferLength;
@@ -1861,6 +4969,9 @@ QuicDataPathBindingAllocSendDatagram(
     SendContext->Iovs[SendContext->BufferCount].iov_len = Buffer->Length;
 
     ++SendContext->BufferCount;
+    if (SendContext->BufferCount > SendContext->RetainedBufferCount) {
+        SendContext->RetainedBufferCount = SendContext->BufferCount;
+    }
 
 Exit:
 
@@ -1877,20 +4988,133 @@ QuicDataPathBindingFreeSendDatagram(
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     PlatDispatch->DatapathBindingFreeSendBuffer(SendContext, Datagram);
 #else
-    QuicPoolFree(&SendContext->Owner->SendBufferPool, Datagram->Buffer);
-    Datagram->Buffer == NULL;
-
     QUIC_DBG_ASSERT(Datagram == &SendContext->Buffers[SendContext->BufferCount - 1]);
+    UNREFERENCED_PARAMETER(Datagram);
 
+    //
+    // The allocation stays behind (still covered by RetainedBufferCount), so
+    // it can be reused by the context's next datagram or returned to its
+    // pool when the context is released.
+    //
     --SendContext->BufferCount;
 #endif
 }
 
+//
+// The platform specific contents of QUIC_DATAPATH_SEND_CACHE: the remote
+// address already mapped to the dual-stack format plus the preformatted
+// pktinfo control message for the local address.
+//
+typedef struct QUIC_DATAPATH_SEND_CACHE_LINUX {
+    QUIC_ADDR MappedRemoteAddress;
+    size_t ControlLength;
+    char ControlBuffer[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+} QUIC_DATAPATH_SEND_CACHE_LINUX;
+
+static_assert(
+    sizeof(QUIC_DATAPATH_SEND_CACHE_LINUX) <=
+        sizeof(((QUIC_DATAPATH_SEND_CACHE*)0)->Storage),
+    "QUIC_DATAPATH_SEND_CACHE storage too small");
+
+//
+// Formats the pktinfo control message for the given local address into the
+// control buffer and returns the length used.
+//
+size_t
+QuicDataPathFormatPktInfo(
+    _In_ const QUIC_ADDR* LocalAddress,
+    _Out_writes_bytes_(ControlBufferLength) char* ControlBuffer,
+    _In_ size_t ControlBufferLength
+    )
+{
+    struct msghdr ControlMhdr = {
+        .msg_control = ControlBuffer,
+        .msg_controllen = ControlBufferLength
+    };
+    struct cmsghdr* CMsg = CMSG_FIRSTHDR(&ControlMhdr);
+    if (LocalAddress->si_family == AF_INET) {
+        CMsg->cmsg_level = IPPROTO_IP;
+        CMsg->cmsg_type = IP_PKTINFO;
+        CMsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+
+        struct in_pktinfo* PktInfo = (struct in_pktinfo*) CMSG_DATA(CMsg);
+        // TODO: Use Ipv4 instead of Ipv6.
+        PktInfo->ipi_ifindex = LocalAddress->Ipv6.sin6_scope_id;
+        PktInfo->ipi_addr = LocalAddress->Ipv4.sin_addr;
+
+        return CMSG_SPACE(sizeof(struct in_pktinfo));
+    } else {
+        CMsg->cmsg_level = IPPROTO_IPV6;
+        CMsg->cmsg_type = IPV6_PKTINFO;
+        CMsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+
+        struct in6_pktinfo* PktInfo6 = (struct in6_pktinfo*) CMSG_DATA(CMsg);
+        PktInfo6->ipi6_ifindex = LocalAddress->Ipv6.sin6_scope_id;
+        PktInfo6->ipi6_addr = LocalAddress->Ipv6.sin6_addr;
+
+        return CMSG_SPACE(sizeof(struct in6_pktinfo));
+    }
+}
+
+//
+// Formats the Traffic Class / TOS control message carrying the ECN codepoint
+// into the control buffer and returns the length used. The level is picked
+// by the destination's (original, unmapped) address family, since that is
+// the IP version the kernel will put on the wire.
+//
+size_t
+QuicDataPathFormatTos(
+    _In_ const QUIC_ADDR* RemoteAddress,
+    _In_ uint8_t EcnCodePoint,
+    _Out_writes_bytes_(ControlBufferLength) char* ControlBuffer,
+    _In_ size_t ControlBufferLength
+    )
+{
+    struct msghdr ControlMhdr = {
+        .msg_control = ControlBuffer,
+        .msg_controllen = ControlBufferLength
+    };
+    struct cmsghdr* CMsg = CMSG_FIRSTHDR(&ControlMhdr);
+    if (RemoteAddress->si_family == AF_INET) {
+        CMsg->cmsg_level = IPPROTO_IP;
+        CMsg->cmsg_type = IP_TOS;
+    } else {
+        CMsg->cmsg_level = IPPROTO_IPV6;
+        CMsg->cmsg_type = IPV6_TCLASS;
+    }
+    CMsg->cmsg_len = CMSG_LEN(sizeof(int));
+    *(int*)CMSG_DATA(CMsg) = EcnCodePoint;
+    return CMSG_SPACE(sizeof(int));
+}
+
+//
+// UDP segmentation requires every datagram in the batch, except possibly the
+// last one, to be the same size, since the kernel splits the payload at fixed
+// segment boundaries.
+//
+BOOLEAN
+QuicSendContextCanUseSegmentation(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext,
+    _In_ size_t StartIndex
+    )
+{
+    for (size_t i = StartIndex + 1; i + 1 < SendContext->BufferCount; ++i) {
+        if (SendContext->Buffers[i].Length !=
+            SendContext->Buffers[StartIndex].Length) {
+            return FALSE;
+        }
+    }
+    return
+        SendContext->Buffers[SendContext->BufferCount - 1].Length <=
+        SendContext->Buffers[StartIndex].Length;
+}
+
 QUIC_STATUS
 QuicDataPathBindingSend(
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const QUIC_ADDR* LocalAddress,
     _In_ const QUIC_ADDR* RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     )
 {
@@ -1898,53 +5122,175 @@ QuicDataPathBindingSend(
     QUIC_SOCKET_CONTEXT* SocketContext = NULL;
     QUIC_DATAPATH_PROC_CONTEXT* ProcContext = NULL;
     ssize_t SentByteCount = 0;
-    size_t i = 0;
-    socklen_t RemoteAddrLen = 0;
     QUIC_ADDR MappedRemoteAddress = {0};
     struct cmsghdr *CMsg = NULL;
-    struct in_pktinfo *PktInfo = NULL;
-    struct in6_pktinfo *PktInfo6 = NULL;
     BOOLEAN SendPending = FALSE;
 
     static_assert(CMSG_SPACE(sizeof(struct in6_pktinfo)) >= CMSG_SPACE(sizeof(struct in_pktinfo)), "sizeof(struct in6_pktinfo) >= sizeof(struct in_pktinfo) failed");
-    char ControlBuffer[CMSG_SPACE(sizeof(struct in6_pktinfo))] = {0};
+    char ControlBuffer[
+        CMSG_SPACE(sizeof(struct in6_pktinfo)) +
+        CMSG_SPACE(sizeof(int)) +
+        CMSG_SPACE(sizeof(uint16_t))] = {0};
 
     QUIC_DBG_ASSERT(Binding != NULL && RemoteAddress != NULL && SendContext != NULL);
 
     SocketContext = &Binding->SocketContexts[QuicProcCurrentNumber()];
     ProcContext = &Binding->Datapath->ProcContexts[QuicProcCurrentNumber()];
 
-    RemoteAddrLen =
-        (AF_INET == RemoteAddress->si_family) ?
-            sizeof(RemoteAddress->Ipv4) : sizeof(RemoteAddress->Ipv6);
+    //
+    // With deferred sends enabled, hand the batch to the datapath thread
+    // instead of performing the syscall inline, so the caller can go on to
+    // prepare (e.g. encrypt) its next batch while this one is written to the
+    // socket. Sends already executing on the datapath thread, including
+    // pended sends being retried, still go inline. If the hand off fails,
+    // fall through and send inline.
+    //
+    if (Binding->Datapath->DeferredSends &&
+        !SendContext->Pending &&
+        QuicCurThreadID() != ProcContext->ThreadId) {
+        Status =
+            QuicSocketContextPendSend(
+                SocketContext,
+                SendContext,
+                ProcContext,
+                LocalAddress,
+                RemoteAddress);
+        if (QUIC_SUCCEEDED(Status)) {
+            SendPending = TRUE;
+            goto Exit;
+        }
+    }
 
-    if (LocalAddress == NULL) {
-        QUIC_DBG_ASSERT(Binding->RemoteAddress.Ipv4.sin_port != 0);
+    //
+    // Map V4 address to dual-stack socket format and format the pktinfo
+    // control message for the local address, or reuse the preformatted
+    // copies if the caller's send cache already holds them.
+    //
+    QUIC_DATAPATH_SEND_CACHE_LINUX* Cache = NULL;
+    const QUIC_ADDR* RemoteSockAddr;
+    if (SendCache != NULL) {
+        Cache = (QUIC_DATAPATH_SEND_CACHE_LINUX*)SendCache->Storage;
+        if (!SendCache->IsPrepared) {
+            QuicConvertToMappedV6(RemoteAddress, &Cache->MappedRemoteAddress);
+            Cache->ControlLength =
+                LocalAddress == NULL ?
+                    0 :
+                    QuicDataPathFormatPktInfo(
+                        LocalAddress,
+                        Cache->ControlBuffer,
+                        sizeof(Cache->ControlBuffer));
+            SendCache->IsPrepared = TRUE;
+        }
+        RemoteSockAddr = &Cache->MappedRemoteAddress;
+    } else {
+        QuicConvertToMappedV6(RemoteAddress, &MappedRemoteAddress);
+        RemoteSockAddr = &MappedRemoteAddress;
+    }
 
-        for (i = SendContext->CurrentIndex;
-            i < SendContext->BufferCount;
-            ++i, SendContext->CurrentIndex++) {
+    //
+    // If the kernel supports UDP segmentation, the entire batch of datagrams
+    // is handed off with a single sendmsg call, with the segment size carried
+    // in a UDP_SEGMENT control message. Otherwise the batch is submitted as
+    // one sendmmsg call with a message per datagram.
+    //
+    BOOLEAN UseSegmentation =
+        (Binding->Datapath->Features & QUIC_DATAPATH_FEATURE_SEND_SEGMENTATION) &&
+        SendContext->BufferCount - SendContext->CurrentIndex > 1 &&
+        QuicSendContextCanUseSegmentation(SendContext, SendContext->CurrentIndex);
 
-            QuicTraceEvent(
-                DatapathSendTo,
-                "[ udp][%p] Send %u bytes in %hhu buffers (segment=%hu) Dst=%!SOCKADDR!",
-                Binding,
-                SendContext->Buffers[i].Length,
-                1,
-                SendContext->Buffers[i].Length,
-                LOG_ADDR_LEN(*RemoteAddress),
-                (uint8_t*)RemoteAddress);
+    //
+    // Without segmentation support, the remaining datagrams are still
+    // submitted in a single sendmmsg call, one message per datagram. All the
+    // messages share the same (remote address and pktinfo) headers.
+    //
+    if (!UseSegmentation &&
+        SendContext->BufferCount - SendContext->CurrentIndex > 1) {
 
-            SentByteCount =
-                sendto(
-                    SocketContext->SocketFd,
-                    SendContext->Buffers[i].Buffer,
+        struct mmsghdr Mhdrs[QUIC_MAX_BATCH_SEND];
+
+        size_t ControlLength = 0;
+        const char* Control = NULL;
+        if (Cache != NULL && SendContext->EcnCodePoint == 0) {
+            Control = Cache->ControlBuffer;
+            ControlLength = Cache->ControlLength;
+        } else {
+            if (Cache != NULL) {
+                QuicCopyMemory(
+                    ControlBuffer,
+                    Cache->ControlBuffer,
+                    Cache->ControlLength);
+                ControlLength = Cache->ControlLength;
+            } else if (LocalAddress != NULL) {
+                ControlLength =
+                    QuicDataPathFormatPktInfo(
+                        LocalAddress,
+                        ControlBuffer,
+                        sizeof(ControlBuffer));
+            }
+            if (SendContext->EcnCodePoint != 0) {
+                ControlLength +=
+                    QuicDataPathFormatTos(
+                        RemoteAddress,
+                        SendContext->EcnCodePoint,
+                        ControlBuffer + ControlLength,
+                        sizeof(ControlBuffer) - ControlLength);
+            }
+            Control = ControlBuffer;
+        }
+
+        while (SendContext->CurrentIndex < SendContext->BufferCount) {
+
+            size_t i = SendContext->CurrentIndex;
+            unsigned int SendCount =
+                (unsigned int)(SendContext->BufferCount - i);
+            uint32_t TotalSize = 0;
+            for (size_t j = 0; j < SendCount; ++j) {
+                SendContext->Iovs[i + j].iov_base =
+                    SendContext->Buffers[i + j].Buffer;
+                SendContext->Iovs[i + j].iov_len =
+                    SendContext->Buffers[i + j].Length;
+                TotalSize += SendContext->Buffers[i + j].Length;
+
+                QuicZeroMemory(&Mhdrs[j], sizeof(Mhdrs[j]));
+                Mhdrs[j].msg_hdr.msg_name = (void*)RemoteSockAddr;
+                Mhdrs[j].msg_hdr.msg_namelen = sizeof(*RemoteSockAddr);
+                Mhdrs[j].msg_hdr.msg_iov = SendContext->Iovs + i + j;
+                Mhdrs[j].msg_hdr.msg_iovlen = 1;
+                if (ControlLength != 0) {
+                    Mhdrs[j].msg_hdr.msg_control = (void*)Control;
+                    Mhdrs[j].msg_hdr.msg_controllen = ControlLength;
+                }
+            }
+
+            if (LocalAddress == NULL) {
+                QUIC_DBG_ASSERT(Binding->RemoteAddress.Ipv4.sin_port != 0);
+                QuicTraceEvent(
+                    DatapathSendTo,
+                    "[ udp][%p] Send %u bytes in %hhu buffers (segment=%hu) Dst=%!SOCKADDR!",
+                    Binding,
+                    TotalSize,
+                    (uint8_t)SendCount,
                     SendContext->Buffers[i].Length,
-                    0,
-                    (struct sockaddr *)RemoteAddress,
-                    RemoteAddrLen);
+                    LOG_ADDR_LEN(*RemoteAddress),
+                    (uint8_t*)RemoteAddress);
+            } else {
+                QuicTraceEvent(
+                    DatapathSendFromTo,
+                    "[ udp][%p] Send %u bytes in %hhu buffers (segment=%hu) Dst=%!SOCKADDR!, Src=%!SOCKADDR!",
+                    Binding,
+                    TotalSize,
+                    (uint8_t)SendCount,
+                    SendContext->Buffers[i].Length,
+                    LOG_ADDR_LEN(*RemoteAddress),
+                    LOG_ADDR_LEN(*LocalAddress),
+                    (uint8_t*)RemoteAddress,
+                    (uint8_t*)LocalAddress);
+            }
 
-            if (SentByteCount < 0) {
+            int SentCount =
+                sendmmsg(SocketContext->SocketFd, Mhdrs, SendCount, 0);
+
+            if (SentCount < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     Status =
                         QuicSocketContextPendSend(
@@ -1960,95 +5306,150 @@ QuicDataPathBindingSend(
                     SendPending = TRUE;
                     goto Exit;
                 } else {
-                    //
-                    // Completed with error.
-                    //
-
                     Status = errno;
                     QuicTraceEvent(
                         DatapathErrorStatus,
                         "[ udp][%p] ERROR, %u, %s.",
                         SocketContext->Binding,
                         Status,
-                        "sendto failed");
+                        "sendmmsg failed");
                     goto Exit;
                 }
-            } else {
-                //
-                // Completed synchronously.
-                //
-                QuicTraceLogVerbose(
-                    DatapathSendToCompleted,
-                    "[ udp][%p] sendto succeeded, bytes transferred %d",
-                    SocketContext->Binding,
-                    SentByteCount);
             }
+
+            SentByteCount = 0;
+            for (int j = 0; j < SentCount; ++j) {
+                SentByteCount += Mhdrs[j].msg_len;
+            }
+            QuicTraceLogVerbose(
+                DatapathSendMsgCompleted,
+                "[ udp][%p] sendmsg succeeded, bytes transferred %d",
+                SocketContext->Binding,
+                SentByteCount);
+
+            //
+            // sendmmsg may send fewer messages than requested; loop until
+            // the whole batch has been handed to the kernel.
+            //
+            SendContext->CurrentIndex += SentCount;
         }
-    } else {
 
+        Status = QUIC_STATUS_SUCCESS;
+        goto Exit;
+    }
+
+    while (SendContext->CurrentIndex < SendContext->BufferCount) {
+
+        size_t i = SendContext->CurrentIndex;
+        size_t SendCount =
+            UseSegmentation ? SendContext->BufferCount - i : 1;
         uint32_t TotalSize = 0;
-        for (i = 0; i < SendContext->BufferCount; ++i) {
-            SendContext->Iovs[i].iov_base = SendContext->Buffers[i].Buffer;
-            SendContext->Iovs[i].iov_len = SendContext->Buffers[i].Length;
-            TotalSize += SendContext->Buffers[i].Length;
+        for (size_t j = i; j < i + SendCount; ++j) {
+            SendContext->Iovs[j].iov_base = SendContext->Buffers[j].Buffer;
+            SendContext->Iovs[j].iov_len = SendContext->Buffers[j].Length;
+            TotalSize += SendContext->Buffers[j].Length;
         }
 
-        QuicTraceEvent(
-            DatapathSendFromTo,
-            "[ udp][%p] Send %u bytes in %hhu buffers (segment=%hu) Dst=%!SOCKADDR!, Src=%!SOCKADDR!",
-            Binding,
-            TotalSize,
-            SendContext->BufferCount,
-            SendContext->Buffers[0].Length,
-            LOG_ADDR_LEN(*RemoteAddress),
-            LOG_ADDR_LEN(*LocalAddress),
-            (uint8_t*)RemoteAddress,
-            (uint8_t*)LocalAddress);
-
-        //
-        // Map V4 address to dual-stack socket format.
-        //
-        QuicConvertToMappedV6(RemoteAddress, &MappedRemoteAddress);
+        if (LocalAddress == NULL) {
+            QUIC_DBG_ASSERT(Binding->RemoteAddress.Ipv4.sin_port != 0);
+            QuicTraceEvent(
+                DatapathSendTo,
+                "[ udp][%p] Send %u bytes in %hhu buffers (segment=%hu) Dst=%!SOCKADDR!",
+                Binding,
+                TotalSize,
+                (uint8_t)SendCount,
+                SendContext->Buffers[i].Length,
+                LOG_ADDR_LEN(*RemoteAddress),
+                (uint8_t*)RemoteAddress);
+        } else {
+            QuicTraceEvent(
+                DatapathSendFromTo,
+                "[ udp][%p] Send %u bytes in %hhu buffers (segment=%hu) Dst=%!SOCKADDR!, Src=%!SOCKADDR!",
+                Binding,
+                TotalSize,
+                (uint8_t)SendCount,
+                SendContext->Buffers[i].Length,
+                LOG_ADDR_LEN(*RemoteAddress),
+                LOG_ADDR_LEN(*LocalAddress),
+                (uint8_t*)RemoteAddress,
+                (uint8_t*)LocalAddress);
+        }
 
         struct msghdr Mhdr = {
-            .msg_name = &MappedRemoteAddress,
-            .msg_namelen = sizeof(MappedRemoteAddress),
-            .msg_iov = SendContext->Iovs,
-            .msg_iovlen = SendContext->BufferCount,
+            .msg_name = (void*)RemoteSockAddr,
+            .msg_namelen = sizeof(*RemoteSockAddr),
+            .msg_iov = SendContext->Iovs + i,
+            .msg_iovlen = SendCount,
             .msg_flags = 0
         };
 
-        // TODO: Avoid allocating both.
+        size_t ControlLength = 0;
+        if (LocalAddress != NULL) {
+            if (Cache != NULL) {
+                QuicCopyMemory(
+                    ControlBuffer,
+                    Cache->ControlBuffer,
+                    Cache->ControlLength);
+                ControlLength = Cache->ControlLength;
+            } else {
+                ControlLength =
+                    QuicDataPathFormatPktInfo(
+                        LocalAddress,
+                        ControlBuffer,
+                        sizeof(ControlBuffer));
+            }
+        }
+        if (SendContext->EcnCodePoint != 0) {
+            ControlLength +=
+                QuicDataPathFormatTos(
+                    RemoteAddress,
+                    SendContext->EcnCodePoint,
+                    ControlBuffer + ControlLength,
+                    sizeof(ControlBuffer) - ControlLength);
+        }
+        if (SendCount > 1) {
+            ControlLength += CMSG_SPACE(sizeof(uint16_t));
+        }
 
-        if (LocalAddress->si_family == AF_INET) {
+        if (ControlLength != 0) {
             Mhdr.msg_control = ControlBuffer;
-            Mhdr.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
+            Mhdr.msg_controllen = ControlLength;
 
-            CMsg = CMSG_FIRSTHDR(&Mhdr);
-            CMsg->cmsg_level = IPPROTO_IP;
-            CMsg->cmsg_type = IP_PKTINFO;
-            CMsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+            if (SendCount > 1) {
+                CMsg = CMSG_FIRSTHDR(&Mhdr);
+                if (LocalAddress != NULL) {
+                    CMsg = CMSG_NXTHDR(&Mhdr, CMsg);
+                }
+                if (SendContext->EcnCodePoint != 0) {
+                    CMsg = CMSG_NXTHDR(&Mhdr, CMsg);
+                }
+                QUIC_DBG_ASSERT(CMsg != NULL);
+                CMsg->cmsg_level = SOL_UDP;
+                CMsg->cmsg_type = UDP_SEGMENT;
+                CMsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                *(uint16_t*)CMSG_DATA(CMsg) =
+                    (uint16_t)SendContext->Buffers[i].Length;
+            }
+        }
 
-            PktInfo = (struct in_pktinfo*) CMSG_DATA(CMsg);
-            // TODO: Use Ipv4 instead of Ipv6.
-            PktInfo->ipi_ifindex = LocalAddress->Ipv6.sin6_scope_id;
-            PktInfo->ipi_addr = LocalAddress->Ipv4.sin_addr;
+        //
+        // Use the zero-copy transmit path for large sends on sockets that
+        // opted in. The lock is held across the call so the sequence number
+        // recorded for the context matches the one the kernel assigns.
+        //
+        if (SocketContext->ZeroCopyEnabled &&
+            TotalSize >= QUIC_SEND_ZERO_COPY_THRESHOLD) {
+            QuicDispatchLockAcquire(&SocketContext->ZeroCopyLock);
+            SentByteCount = sendmsg(SocketContext->SocketFd, &Mhdr, MSG_ZEROCOPY);
+            if (SentByteCount >= 0) {
+                SendContext->ZeroCopyLastSeq = SocketContext->ZeroCopyNextSeq++;
+                SendContext->ZeroCopyCount++;
+            }
+            QuicDispatchLockRelease(&SocketContext->ZeroCopyLock);
         } else {
-            Mhdr.msg_control = ControlBuffer;
-            Mhdr.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
-
-            CMsg = CMSG_FIRSTHDR(&Mhdr);
-            CMsg->cmsg_level = IPPROTO_IPV6;
-            CMsg->cmsg_type = IPV6_PKTINFO;
-            CMsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
-
-            PktInfo6 = (struct in6_pktinfo*) CMSG_DATA(CMsg);
-            PktInfo6->ipi6_ifindex = LocalAddress->Ipv6.sin6_scope_id;
-            PktInfo6->ipi6_addr = LocalAddress->Ipv6.sin6_addr;
+            SentByteCount = sendmsg(SocketContext->SocketFd, &Mhdr, 0);
         }
 
-        SentByteCount = sendmsg(SocketContext->SocketFd, &Mhdr, 0);
-
         if (SentByteCount < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 Status =
@@ -2065,6 +5466,10 @@ QuicDataPathBindingSend(
                 SendPending = TRUE;
                 goto Exit;
             } else {
+                //
+                // Completed with error.
+                //
+
                 Status = errno;
                 QuicTraceEvent(
                     DatapathErrorStatus,
@@ -2084,6 +5489,8 @@ QuicDataPathBindingSend(
                 SocketContext->Binding,
                 SentByteCount);
         }
+
+        SendContext->CurrentIndex += SendCount;
     }
 
     Status = QUIC_STATUS_SUCCESS;
@@ -2091,7 +5498,30 @@ QuicDataPathBindingSend(
 Exit:
 
     if (!SendPending) {
-        QuicDataPathBindingFreeSendContext(SendContext);
+        if (SendContext->ZeroCopyCount != 0) {
+            //
+            // The kernel may still be reading the send buffers. Park the
+            // context on the in-flight list until the zero-copy completion
+            // notifications arrive on the socket's error queue, unless the
+            // completions already beat us here.
+            //
+            QuicDispatchLockAcquire(&SocketContext->ZeroCopyLock);
+            BOOLEAN AlreadyCompleted =
+                SocketContext->ZeroCopyAnyAcked &&
+                (int32_t)(SocketContext->ZeroCopyAckedSeq -
+                    SendContext->ZeroCopyLastSeq) >= 0;
+            if (!AlreadyCompleted) {
+                QuicListInsertTail(
+                    &SocketContext->ZeroCopyInFlightHead,
+                    &SendContext->PendingSendLinkage);
+            }
+            QuicDispatchLockRelease(&SocketContext->ZeroCopyLock);
+            if (AlreadyCompleted) {
+                QuicDataPathBindingFreeSendContext(SendContext);
+            }
+        } else {
+            QuicDataPathBindingFreeSendContext(SendContext);
+        }
     }
 
     return Status;
@@ -2122,6 +5552,7 @@ QuicDataPathBindingSendTo(
             Binding,
             NULL,
             RemoteAddress,
+            NULL,
             SendContext);
 #endif
 }
@@ -2131,6 +5562,7 @@ QuicDataPathBindingSendFromTo(
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const QUIC_ADDR * LocalAddress,
     _In_ const QUIC_ADDR * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     )
 {
@@ -2140,6 +5572,7 @@ QuicDataPathBindingSendFromTo(
             Binding,
             LocalAddress,
             RemoteAddress,
+            SendCache,
             SendContext);
 #else
     QUIC_DBG_ASSERT(
@@ -2154,6 +5587,7 @@ QuicDataPathBindingSendFromTo(
             Binding,
             LocalAddress,
             RemoteAddress,
+            SendCache,
             SendContext);
 #endif
 }
@@ -2171,6 +5605,63 @@ QuicDataPathBindingGetLocalMtu(
 #endif
 }
 
+void
+QuicProcContextPrewarmPools(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext
+    )
+{
+    //
+    // The worker thread is affinitized to its processor, so allocations made
+    // on it are first-touched (and therefore placed by the kernel) on the
+    // NUMA node that owns that processor. Warming the pools from the thread
+    // itself keeps the per-processor receive and send memory node-local on
+    // multi-socket machines, instead of wherever the thread that initialized
+    // the datapath happened to be running.
+    //
+    void* Entries[QUIC_MAX_BATCH_RECEIVE];
+    uint32_t Count = 0;
+
+    QuicRecvSlabCarve(&ProcContext->RecvSlab);
+
+    //
+    // The pool is warmed directly (not through QuicDataPathAllocRecvBlock,
+    // which would be satisfied by the slab) since it still serves as the
+    // overflow path when the slab runs dry.
+    //
+    for (uint32_t i = 0; i < QUIC_MAX_BATCH_RECEIVE; ++i) {
+        void* RecvBlock = QuicPoolAlloc(&ProcContext->RecvBlockPool);
+        if (RecvBlock == NULL) {
+            break;
+        }
+        Entries[Count++] = RecvBlock;
+    }
+    while (Count != 0) {
+        QuicPoolFree(&ProcContext->RecvBlockPool, Entries[--Count]);
+    }
+
+    for (uint32_t i = 0; i < QUIC_MAX_BATCH_SEND; ++i) {
+        void* SendBuffer = QuicPoolAlloc(&ProcContext->SendBufferPool);
+        if (SendBuffer == NULL) {
+            break;
+        }
+        Entries[Count++] = SendBuffer;
+    }
+    while (Count != 0) {
+        QuicPoolFree(&ProcContext->SendBufferPool, Entries[--Count]);
+    }
+
+    for (uint32_t i = 0; i < QUIC_MAX_BATCH_SEND; ++i) {
+        void* SendContext = QuicPoolAlloc(&ProcContext->SendContextPool);
+        if (SendContext == NULL) {
+            break;
+        }
+        Entries[Count++] = SendContext;
+    }
+    while (Count != 0) {
+        QuicPoolFree(&ProcContext->SendContextPool, Entries[--Count]);
+    }
+}
+
 void*
 QuicDataPathWorkerThread(
     _In_ void* Context
@@ -2179,6 +5670,17 @@ QuicDataPathWorkerThread(
     QUIC_DATAPATH_PROC_CONTEXT* ProcContext = (QUIC_DATAPATH_PROC_CONTEXT*)Context;
     QUIC_DBG_ASSERT(ProcContext != NULL && ProcContext->Datapath != NULL);
 
+    ProcContext->ThreadId = QuicCurThreadID();
+
+    QuicProcContextPrewarmPools(ProcContext);
+
+#ifdef QUIC_DATAPATH_URING
+    if (ProcContext->Datapath->UseUring) {
+        QuicDataPathUringWorkerLoop(ProcContext);
+        return NO_ERROR;
+    }
+#endif
+
     const size_t EpollEventCtMax = 16; // TODO: Experiment.
     struct epoll_event EpollEvents[EpollEventCtMax];
 
@@ -2189,16 +5691,25 @@ QuicDataPathWorkerThread(
                     ProcContext->EpollFd,
                     EpollEvents,
                     EpollEventCtMax,
-                    -1));
+                    ProcContext->Datapath->BusyPoll ? 0 : -1));
 
         QUIC_FRE_ASSERT(ReadyEventCount >= 0);
         for (int i = 0; i < ReadyEventCount; i++) {
             if (EpollEvents[i].data.ptr == NULL) {
+                if (!ProcContext->Datapath->Shutdown) {
+                    //
+                    // Not a shutdown, just a poke to pick up a config change
+                    // (e.g. busy polling turning on). Drain the event fd so
+                    // it stops being signaled and move on.
+                    //
+                    eventfd_t Value;
+                    eventfd_read(ProcContext->EventFd, &Value);
+                    continue;
+                }
                 //
                 // The processor context is shutting down and the worker thread
                 // needs to clean up.
                 //
-                QUIC_DBG_ASSERT(ProcContext->Datapath->Shutdown);
                 break;
             }
 
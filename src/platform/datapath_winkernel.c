@@ -975,6 +975,55 @@ QuicDataPathGetSupportedFeatures(
     return Datapath->Features;
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetPartitionInfo(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ uint8_t CidPartitionByteOffset,
+    _In_ uint8_t CidPartitionMask
+    )
+{
+    //
+    // CID based receive steering is not implemented on this platform.
+    //
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(CidPartitionByteOffset);
+    UNREFERENCED_PARAMETER(CidPartitionMask);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetDeferredSends(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ BOOLEAN Enabled
+    )
+{
+    //
+    // Sends on this platform are already asynchronous, so there is nothing
+    // to defer.
+    //
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(Enabled);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetProcessorConfig(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_reads_opt_(ProcessorListLength) const uint16_t* ProcessorList,
+    _In_ uint32_t ProcessorListLength,
+    _In_ BOOLEAN BusyPoll
+    )
+{
+    //
+    // Explicit processor placement is not implemented on this platform.
+    //
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(ProcessorList);
+    UNREFERENCED_PARAMETER(ProcessorListLength);
+    UNREFERENCED_PARAMETER(BusyPoll);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicDataPathIsPaddingPreferred(
@@ -2117,7 +2166,13 @@ QuicDataPathSocketReceive(
 
             QUIC_DBG_ASSERT(Datagram != NULL);
             Datagram->Next = NULL;
+            //
+            // No kernel receive timestamp is plumbed through WSK, so stamp
+            // the datagram with the indication processing time.
+            //
+            Datagram->RecvTimeUs = QuicTimeUs64();
             Datagram->PartitionIndex = (uint8_t)QuicProcCurrentNumber();
+            Datagram->TypeOfService = 0;
             Datagram->Allocated = TRUE;
             Datagram->QueuedOnConnection = FALSE;
 
@@ -2206,7 +2261,7 @@ QuicDataPathBindingReturnRecvDatagrams(
     _In_opt_ QUIC_RECV_DATAGRAM* DatagramChain
     )
 {
-    QUIC_UDP_SOCKET_CONTEXT* SocketContext = NULL;
+    QUIC_UDP_SOCKET_CONTEXT* ReleaseSocketContext = NULL;
     PWSK_DATAGRAM_INDICATION DataIndications = NULL;
     PWSK_DATAGRAM_INDICATION* DataIndicationTail = &DataIndications;
 
@@ -2225,8 +2280,6 @@ QuicDataPathBindingReturnRecvDatagrams(
         QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* InternalContext =
             InternalBufferContext->RecvContext;
 
-        QUIC_DBG_ASSERT(SocketContext == NULL || SocketContext == InternalContext->SocketContext);
-        SocketContext = InternalContext->SocketContext;
         Datagram->Allocated = FALSE;
 
         if (BatchedInternalContext == InternalContext) {
@@ -2237,9 +2290,23 @@ QuicDataPathBindingReturnRecvDatagrams(
                     (PLONG)&BatchedInternalContext->ReferenceCount,
                     -BatchedBufferCount) == 0) {
                 //
-                // Clean up the data indication.
+                // Clean up the data indication. The chain may span sockets
+                // (callers are allowed to coalesce returns for everything
+                // received on the processor), so whenever the owning socket
+                // changes, flush the previous socket's pending indications
+                // with one WskRelease call and start a new chain.
                 //
                 QUIC_DBG_ASSERT(BatchedInternalContext->DataIndication->Next == NULL);
+                if (ReleaseSocketContext != BatchedInternalContext->SocketContext) {
+                    if (DataIndications != NULL) {
+                        PWSK_PROVIDER_DATAGRAM_DISPATCH Dispatch =
+                            (PWSK_PROVIDER_DATAGRAM_DISPATCH)(ReleaseSocketContext->Socket->Dispatch);
+                        Dispatch->WskRelease(ReleaseSocketContext->Socket, DataIndications);
+                        DataIndications = NULL;
+                        DataIndicationTail = &DataIndications;
+                    }
+                    ReleaseSocketContext = BatchedInternalContext->SocketContext;
+                }
                 *DataIndicationTail = BatchedInternalContext->DataIndication;
                 DataIndicationTail = &BatchedInternalContext->DataIndication->Next;
 
@@ -2259,6 +2326,16 @@ QuicDataPathBindingReturnRecvDatagrams(
         // Clean up the data indication.
         //
         QUIC_DBG_ASSERT(BatchedInternalContext->DataIndication->Next == NULL);
+        if (ReleaseSocketContext != BatchedInternalContext->SocketContext) {
+            if (DataIndications != NULL) {
+                PWSK_PROVIDER_DATAGRAM_DISPATCH Dispatch =
+                    (PWSK_PROVIDER_DATAGRAM_DISPATCH)(ReleaseSocketContext->Socket->Dispatch);
+                Dispatch->WskRelease(ReleaseSocketContext->Socket, DataIndications);
+                DataIndications = NULL;
+                DataIndicationTail = &DataIndications;
+            }
+            ReleaseSocketContext = BatchedInternalContext->SocketContext;
+        }
         *DataIndicationTail = BatchedInternalContext->DataIndication;
         DataIndicationTail = &BatchedInternalContext->DataIndication->Next;
 
@@ -2267,11 +2344,11 @@ QuicDataPathBindingReturnRecvDatagrams(
 
     if (DataIndications != NULL) {
         //
-        // Return the datagram indications back to Wsk.
+        // Return the last socket's datagram indications back to Wsk.
         //
         PWSK_PROVIDER_DATAGRAM_DISPATCH Dispatch =
-            (PWSK_PROVIDER_DATAGRAM_DISPATCH)(SocketContext->Socket->Dispatch);
-        Dispatch->WskRelease(SocketContext->Socket, DataIndications);
+            (PWSK_PROVIDER_DATAGRAM_DISPATCH)(ReleaseSocketContext->Socket->Dispatch);
+        Dispatch->WskRelease(ReleaseSocketContext->Socket, DataIndications);
     }
 }
 
@@ -2333,6 +2410,21 @@ QuicDataPathBindingFreeSendContext(
     QuicPoolFree(&ProcContext->SendContextPool, SendContext);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicDataPathBindingSetEcnCodePoint(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext,
+    _In_ QUIC_ECN_TYPE EcnCodePoint
+    )
+{
+    //
+    // WSK does not expose a per-send control message for the Type of
+    // Service, so the codepoint is not applied on this datapath yet.
+    //
+    UNREFERENCED_PARAMETER(SendContext);
+    UNREFERENCED_PARAMETER(EcnCodePoint);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 static
 BOOLEAN
@@ -2786,6 +2878,7 @@ QuicDataPathBindingSendFromTo(
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const SOCKADDR_INET * LocalAddress,
     _In_ const SOCKADDR_INET * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     )
 {
@@ -2793,6 +2886,8 @@ QuicDataPathBindingSendFromTo(
     QUIC_UDP_SOCKET_CONTEXT* SocketContext;
     PDWORD SegmentSize;
 
+    UNREFERENCED_PARAMETER(SendCache);
+
     QUIC_DBG_ASSERT(
         Binding != NULL && LocalAddress != NULL &&
         RemoteAddress != NULL && SendContext != NULL);
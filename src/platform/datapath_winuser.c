@@ -73,6 +73,23 @@ QuicFuzzerRecvMsg(
 //
 #define URO_MAX_DATAGRAMS_PER_INDICATION    64
 
+//
+// The number of receives kept posted on each registered I/O (RIO) request
+// queue, and the number of completions dequeued from the completion ring in
+// a single batch.
+//
+#define QUIC_RIO_RECV_COUNT                 256
+#define QUIC_RIO_BATCH_SIZE                 64
+
+//
+// The size of the RIO control buffer appended to each registered receive
+// slot, covering the largest set of control messages a receive produces.
+//
+#define QUIC_RIO_CONTROL_LENGTH \
+    (RIO_CMSG_BASE_SIZE + \
+     WSA_CMSG_SPACE(sizeof(IN6_PKTINFO)) + \
+     WSA_CMSG_SPACE(sizeof(DWORD)))
+
 static_assert(
     sizeof(QUIC_BUFFER) == sizeof(WSABUF),
     "WSABUF is assumed to be interchangeable for QUIC_BUFFER");
@@ -93,6 +110,7 @@ static_assert(
 
 typedef struct QUIC_UDP_SOCKET_CONTEXT QUIC_UDP_SOCKET_CONTEXT;
 typedef struct QUIC_DATAPATH_PROC_CONTEXT QUIC_DATAPATH_PROC_CONTEXT;
+typedef struct QUIC_RIO_SLAB QUIC_RIO_SLAB;
 
 //
 // Internal receive context.
@@ -109,6 +127,13 @@ typedef struct QUIC_DATAPATH_INTERNAL_RECV_CONTEXT {
     //
     ULONG ReferenceCount;
 
+    //
+    // The registered buffer slab the context lives in, when it was received
+    // through RIO; NULL for pool allocated contexts. Determines how the
+    // context is released once all datagram references are returned.
+    //
+    QUIC_RIO_SLAB* RioSlab;
+
     //
     // Contains the 4 tuple.
     //
@@ -128,6 +153,106 @@ typedef struct QUIC_DATAPATH_INTERNAL_RECV_BUFFER_CONTEXT {
 
 } QUIC_DATAPATH_INTERNAL_RECV_BUFFER_CONTEXT;
 
+//
+// The number of receives kept posted on each non-RIO socket, so that a
+// microburst doesn't have to drain through a single pended WSARecvMsg.
+//
+#ifndef QUIC_RECV_IO_DEPTH
+#define QUIC_RECV_IO_DEPTH 4
+#endif
+
+//
+// The state for one posted (overlapped) WSARecvMsg call.
+//
+typedef struct QUIC_DATAPATH_PENDED_RECV {
+
+    OVERLAPPED Overlapped;
+    WSABUF WsaBuf;
+    WSAMSG WsaMsgHdr;
+    char WsaMsgControlBuf[
+        WSA_CMSG_SPACE(sizeof(IN6_PKTINFO)) +
+        WSA_CMSG_SPACE(sizeof(DWORD))];
+
+    //
+    // The receive buffer the call is posted with. Kept across failed
+    // completions so the buffer is reused by the repost.
+    //
+    QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext;
+
+} QUIC_DATAPATH_PENDED_RECV;
+
+//
+// A pre-registered slab of receive slots for one RIO socket. Each slot has
+// the same layout as a pool allocated receive context (internal context,
+// datagram contexts, payload), followed by a RIO control buffer. The slab
+// is reference counted separately from the socket so that datagrams still
+// held by the client when the socket shuts down stay valid until returned.
+//
+typedef struct QUIC_RIO_SLAB {
+
+    //
+    // The registered buffer covering Memory.
+    //
+    RIO_BUFFERID BufferId;
+
+    //
+    // The slab allocation itself.
+    //
+    CHAR* Memory;
+
+    //
+    // Parent datapath, for the slot geometry and RIO dispatch table.
+    //
+    QUIC_DATAPATH* Datapath;
+
+    //
+    // The IO completion port of the owning processor, used to wake its
+    // completion thread when the request queue runs dry.
+    //
+    HANDLE Iocp;
+
+    //
+    // The Overlapped structure for wake completions. Queued with a NULL
+    // completion key so the completion thread can tell it apart from socket
+    // IO.
+    //
+    OVERLAPPED WakeOverlapped;
+
+    //
+    // Serializes the free list, the counts below and all request queue
+    // postings.
+    //
+    QUIC_DISPATCH_LOCK Lock;
+
+    //
+    // Slots ready to be posted on the request queue again.
+    //
+    QUIC_LIST_ENTRY FreeList;
+
+    //
+    // The number of receives currently posted on the request queue.
+    //
+    ULONG PostedCount;
+
+    //
+    // The number of slots currently delivered to (and not yet returned by)
+    // the client.
+    //
+    ULONG DeliveredCount;
+
+    //
+    // Indicates a wake completion is queued and not yet processed.
+    //
+    BOOLEAN WakeQueued;
+
+    //
+    // The owning socket context, or NULL once the socket has shut down. No
+    // new postings or wakes happen once cleared.
+    //
+    QUIC_UDP_SOCKET_CONTEXT* SocketContext;
+
+} QUIC_RIO_SLAB;
+
 //
 // Send context.
 //
@@ -153,6 +278,11 @@ typedef struct QUIC_DATAPATH_SEND_CONTEXT {
     //
     UINT16 SegmentSize;
 
+    //
+    // The ECN codepoint to mark every datagram in this context with.
+    //
+    UINT8 EcnCodePoint;
+
     //
     // The current number of WsaBuffers used.
     //
@@ -191,17 +321,29 @@ typedef struct QUIC_UDP_SOCKET_CONTEXT {
     QUIC_RUNDOWN_REF UpcallRundown;
 
     //
-    // The set of parameters/state passed to WsaRecvMsg for the IP stack to
-    // populate to indicate the result of the receive.
+    // The receive buffer capacity (only 'len' is used; each posted receive
+    // carries its own WSABUF) and the ring of posted receives.
     //
 
     WSABUF RecvWsaBuf;
-    char RecvWsaMsgControlBuf[
-        WSA_CMSG_SPACE(sizeof(IN6_PKTINFO)) +
-        WSA_CMSG_SPACE(sizeof(DWORD))];
-    WSAMSG RecvWsaMsgHdr;
-    QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* CurrentRecvContext;
-    OVERLAPPED RecvOverlapped;
+    QUIC_DATAPATH_PENDED_RECV PendedRecvs[QUIC_RECV_IO_DEPTH];
+
+    //
+    // Posted (with a UINT32_MAX byte count) to signal the completion thread
+    // to run the socket context clean up.
+    //
+    OVERLAPPED ShutdownOverlapped;
+
+    //
+    // The registered I/O state for the socket, when the RIO receive path is
+    // in use: the request and completion queues, the registered receive
+    // slab and the Overlapped structure the completion queue notifies
+    // through.
+    //
+    RIO_RQ RioRq;
+    RIO_CQ RioCq;
+    QUIC_RIO_SLAB* RioSlab;
+    OVERLAPPED RioNotifyOverlapped;
 
 } QUIC_UDP_SOCKET_CONTEXT;
 
@@ -342,6 +484,20 @@ typedef struct QUIC_DATAPATH {
     //
     LPFN_WSARECVMSG WSARecvMsg;
 
+    //
+    // The registered I/O extension function table, valid when
+    // QUIC_DATAPATH_FEATURE_RIO is advertised.
+    //
+    RIO_EXTENSION_FUNCTION_TABLE RioDispatch;
+
+    //
+    // The layout of a RIO receive slot: the offset of the control buffer
+    // (the slot matches a pool allocated receive context up to this point)
+    // and the full slot stride.
+    //
+    uint32_t RioControlOffset;
+    uint32_t RioSlotSize;
+
     //
     // Rundown for waiting on binding cleanup.
     //
@@ -422,6 +578,17 @@ QuicDataPathWorkerThread(
     _In_ void* Context
     );
 
+QUIC_STATUS
+QuicDataPathRioStartReceives(
+    _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
+    _In_ HANDLE CompletionPort
+    );
+
+void
+QuicDataPathRioFreeSlab(
+    _In_ QUIC_RIO_SLAB* Slab
+    );
+
 void
 QuicDataPathQueryRssScalabilityInfo(
     _Inout_ QUIC_DATAPATH* Datapath
@@ -542,6 +709,62 @@ Error:
     }
 }
 
+void
+QuicDataPathQueryRioSupport(
+    _Inout_ QUIC_DATAPATH* Datapath
+    )
+{
+    //
+    // Test if the OS supports registered I/O by querying the extension
+    // function table. If it does, receives are posted against
+    // pre-registered buffer slabs and completions are dequeued in batches
+    // from the completion ring, instead of one overlapped completion per
+    // datagram.
+    //
+    SOCKET UdpSocket =
+        WSASocketW(
+            AF_INET6,
+            SOCK_DGRAM,
+            IPPROTO_UDP,
+            NULL,
+            0,
+            WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO);
+    if (UdpSocket == INVALID_SOCKET) {
+        int WsaError = WSAGetLastError();
+        QuicTraceLogWarning(
+            DatapathOpenRioSocketFailed,
+            "[ udp] RIO helper socket failed to open, 0x%x",
+            WsaError);
+        return;
+    }
+
+    GUID MultipleRioGuid = WSAID_MULTIPLE_RIO;
+    DWORD BytesReturned;
+    Datapath->RioDispatch.cbSize = sizeof(Datapath->RioDispatch);
+    int Result =
+        WSAIoctl(
+            UdpSocket,
+            SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER_TABLE,
+            &MultipleRioGuid,
+            sizeof(MultipleRioGuid),
+            &Datapath->RioDispatch,
+            sizeof(Datapath->RioDispatch),
+            &BytesReturned,
+            NULL,
+            NULL);
+    if (Result != NO_ERROR) {
+        int WsaError = WSAGetLastError();
+        QuicTraceLogWarning(
+            DatapathQueryRioDispatchFailed,
+            "[ udp] Query for RIO extension functions failed, 0x%x",
+            WsaError);
+    } else {
+        Datapath->Features |= QUIC_DATAPATH_FEATURE_RIO;
+    }
+
+    closesocket(UdpSocket);
+}
+
 _IRQL_requires_max_(PASSIVE_LEVEL)
 QUIC_STATUS
 QuicDataPathInitialize(
@@ -605,6 +828,12 @@ QuicDataPathInitialize(
 
     QuicDataPathQueryRssScalabilityInfo(Datapath);
     QuicDataPathQuerySockoptSupport(Datapath);
+#ifndef QUIC_FUZZER
+    //
+    // The fuzzer hooks WSARecvMsg/WSASendMsg, which RIO would bypass.
+    //
+    QuicDataPathQueryRioSupport(Datapath);
+#endif
 
     if (Datapath->Features & QUIC_DATAPATH_FEATURE_SEND_SEGMENTATION) {
         //
@@ -638,6 +867,16 @@ QuicDataPathInitialize(
             ((Datapath->Features & QUIC_DATAPATH_FEATURE_RECV_COALESCING) ?
                 MAX_URO_PAYLOAD_LENGTH : MAX_UDP_PAYLOAD_LENGTH);
 
+    if (Datapath->Features & QUIC_DATAPATH_FEATURE_RIO) {
+        //
+        // A RIO receive slot matches the pool allocated layout, with the
+        // RIO control buffer appended past the payload.
+        //
+        Datapath->RioControlOffset = ALIGN_UP(RecvDatagramLength, PVOID);
+        Datapath->RioSlotSize =
+            ALIGN_UP(Datapath->RioControlOffset + QUIC_RIO_CONTROL_LENGTH, PVOID);
+    }
+
     for (uint32_t i = 0; i < Datapath->ProcCount; i++) {
 
         //
@@ -824,6 +1063,55 @@ QuicDataPathGetSupportedFeatures(
     return Datapath->Features;
 }
 
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetPartitionInfo(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ uint8_t CidPartitionByteOffset,
+    _In_ uint8_t CidPartitionMask
+    )
+{
+    //
+    // CID based receive steering is not implemented on this platform.
+    //
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(CidPartitionByteOffset);
+    UNREFERENCED_PARAMETER(CidPartitionMask);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetDeferredSends(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_ BOOLEAN Enabled
+    )
+{
+    //
+    // Sends on this platform are already asynchronous, so there is nothing
+    // to defer.
+    //
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(Enabled);
+}
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void
+QuicDataPathSetProcessorConfig(
+    _In_ QUIC_DATAPATH* Datapath,
+    _In_reads_opt_(ProcessorListLength) const uint16_t* ProcessorList,
+    _In_ uint32_t ProcessorListLength,
+    _In_ BOOLEAN BusyPoll
+    )
+{
+    //
+    // Explicit processor placement is not implemented on this platform.
+    //
+    UNREFERENCED_PARAMETER(Datapath);
+    UNREFERENCED_PARAMETER(ProcessorList);
+    UNREFERENCED_PARAMETER(ProcessorListLength);
+    UNREFERENCED_PARAMETER(BusyPoll);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 BOOLEAN
 QuicDataPathIsPaddingPreferred(
@@ -1026,6 +1314,8 @@ QuicDataPathBindingCreate(
     for (uint32_t i = 0; i < SocketCount; i++) {
         Binding->SocketContexts[i].Binding = Binding;
         Binding->SocketContexts[i].Socket = INVALID_SOCKET;
+        Binding->SocketContexts[i].RioRq = RIO_INVALID_RQ;
+        Binding->SocketContexts[i].RioCq = RIO_INVALID_CQ;
         Binding->SocketContexts[i].RecvWsaBuf.len =
             (Datapath->Features & QUIC_DATAPATH_FEATURE_RECV_COALESCING) ?
                 MAX_URO_PAYLOAD_LENGTH :
@@ -1045,7 +1335,9 @@ QuicDataPathBindingCreate(
                 IPPROTO_UDP,
                 NULL,
                 0,
-                WSA_FLAG_OVERLAPPED);
+                WSA_FLAG_OVERLAPPED |
+                ((Datapath->Features & QUIC_DATAPATH_FEATURE_RIO) ?
+                    WSA_FLAG_REGISTERED_IO : 0));
         if (SocketContext->Socket == INVALID_SOCKET) {
             int WsaError = WSAGetLastError();
             QuicTraceEvent(
@@ -1531,7 +1823,7 @@ QUIC_DISABLED_BY_FUZZER_END;
                         Binding->Datapath->ProcContexts[Processor].IOCP,
                         UINT32_MAX,
                         (ULONG_PTR)SocketContext,
-                        &SocketContext->RecvOverlapped);
+                        &SocketContext->ShutdownOverlapped);
                 }
             } else {
                 for (uint32_t i = 0; i < SocketCount; i++) {
@@ -1595,7 +1887,7 @@ QUIC_DISABLED_BY_FUZZER_END;
             Datapath->ProcContexts[Processor].IOCP,
             UINT32_MAX,
             (ULONG_PTR)SocketContext,
-            &SocketContext->RecvOverlapped);
+            &SocketContext->ShutdownOverlapped);
 
     } else {
         for (uint32_t i = 0; i < Datapath->ProcCount; ++i) {
@@ -1619,7 +1911,7 @@ QUIC_DISABLED_BY_FUZZER_END;
                 Datapath->ProcContexts[Processor].IOCP,
                 UINT32_MAX,
                 (ULONG_PTR)SocketContext,
-                &SocketContext->RecvOverlapped);
+                &SocketContext->ShutdownOverlapped);
         }
     }
 
@@ -1634,11 +1926,41 @@ QuicDataPathSocketContextShutdown(
     _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext
     )
 {
-    if (SocketContext->CurrentRecvContext != NULL) {
-        QuicPoolFree(
-            SocketContext->CurrentRecvContext->OwningPool,
-            SocketContext->CurrentRecvContext);
-        SocketContext->CurrentRecvContext = NULL;
+    for (uint32_t i = 0; i < QUIC_RECV_IO_DEPTH; ++i) {
+        QUIC_DATAPATH_PENDED_RECV* PendedRecv = &SocketContext->PendedRecvs[i];
+        if (PendedRecv->RecvContext != NULL) {
+            QuicPoolFree(
+                PendedRecv->RecvContext->OwningPool,
+                PendedRecv->RecvContext);
+            PendedRecv->RecvContext = NULL;
+        }
+    }
+
+    if (SocketContext->RioSlab != NULL) {
+        QUIC_RIO_SLAB* Slab = SocketContext->RioSlab;
+        QUIC_DATAPATH* Datapath = SocketContext->Binding->Datapath;
+
+        //
+        // The socket has already been closed, so no more RIO completions can
+        // arrive. Detach the slab from the socket; it is freed once the
+        // client has returned every delivered datagram.
+        //
+        Datapath->RioDispatch.RIOCloseCompletionQueue(SocketContext->RioCq);
+        SocketContext->RioCq = RIO_INVALID_CQ;
+        SocketContext->RioRq = RIO_INVALID_RQ;
+        Datapath->RioDispatch.RIODeregisterBuffer(Slab->BufferId);
+        Slab->BufferId = RIO_INVALID_BUFFERID;
+
+        QuicDispatchLockAcquire(&Slab->Lock);
+        Slab->SocketContext = NULL;
+        BOOLEAN FreeSlab =
+            Slab->DeliveredCount == 0 && !Slab->WakeQueued;
+        QuicDispatchLockRelease(&Slab->Lock);
+
+        SocketContext->RioSlab = NULL;
+        if (FreeSlab) {
+            QuicDataPathRioFreeSlab(Slab);
+        }
     }
 
     QuicRundownUninitialize(&SocketContext->UpcallRundown);
@@ -1702,6 +2024,7 @@ QuicDataPathBindingAllocRecvContext(
         RecvContext->OwningPool =
             &Datapath->ProcContexts[ProcIndex].RecvDatagramPool;
         RecvContext->ReferenceCount = 0;
+        RecvContext->RioSlab = NULL;
     }
 
     return RecvContext;
@@ -1710,12 +2033,10 @@ QuicDataPathBindingAllocRecvContext(
 void
 QuicDataPathBindingHandleUnreachableError(
     _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
+    _Inout_ PSOCKADDR_INET RemoteAddr,
     _In_ ULONG ErrorCode
     )
 {
-    PSOCKADDR_INET RemoteAddr =
-        &SocketContext->CurrentRecvContext->Tuple.RemoteAddress;
-
     QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
 
 #if 0 // TODO - Change to ETW event
@@ -1747,9 +2068,10 @@ QuicDataPathBindingHandleUnreachableError(
 }
 
 QUIC_STATUS
-QuicDataPathBindingStartReceive(
+QuicDataPathBindingStartReceiveSlot(
     _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
-    _In_ HANDLE CompletionPort
+    _In_ HANDLE CompletionPort,
+    _Inout_ QUIC_DATAPATH_PENDED_RECV* PendedRecv
     )
 {
     QUIC_STATUS Status;
@@ -1760,54 +2082,58 @@ QuicDataPathBindingStartReceive(
     //
     // Get a receive buffer we can pass to WinSock.
     //
-    if (SocketContext->CurrentRecvContext == NULL) {
-        SocketContext->CurrentRecvContext =
+    if (PendedRecv->RecvContext == NULL) {
+        PendedRecv->RecvContext =
             QuicDataPathBindingAllocRecvContext(
                 Datapath,
                 (UINT16)GetCurrentProcessorNumber());
 
-        if (SocketContext->CurrentRecvContext == NULL) {
+        if (PendedRecv->RecvContext == NULL) {
             Status = QUIC_STATUS_OUT_OF_MEMORY;
             goto Error;
         }
     }
 
     RtlZeroMemory(
-        &SocketContext->RecvOverlapped,
-        sizeof(SocketContext->RecvOverlapped));
+        &PendedRecv->Overlapped,
+        sizeof(PendedRecv->Overlapped));
 
-    SocketContext->RecvWsaBuf.buf =
-        ((CHAR*)SocketContext->CurrentRecvContext) + Datapath->RecvPayloadOffset;
+    PendedRecv->WsaBuf.buf =
+        ((CHAR*)PendedRecv->RecvContext) + Datapath->RecvPayloadOffset;
+    PendedRecv->WsaBuf.len = SocketContext->RecvWsaBuf.len;
 
     RtlZeroMemory(
-        &SocketContext->RecvWsaMsgHdr,
-        sizeof(SocketContext->RecvWsaMsgHdr));
+        &PendedRecv->WsaMsgHdr,
+        sizeof(PendedRecv->WsaMsgHdr));
 
-    SocketContext->RecvWsaMsgHdr.name =
-        (PSOCKADDR)&SocketContext->CurrentRecvContext->Tuple.RemoteAddress;
-    SocketContext->RecvWsaMsgHdr.namelen =
-        sizeof(SocketContext->CurrentRecvContext->Tuple.RemoteAddress);
+    PendedRecv->WsaMsgHdr.name =
+        (PSOCKADDR)&PendedRecv->RecvContext->Tuple.RemoteAddress;
+    PendedRecv->WsaMsgHdr.namelen =
+        sizeof(PendedRecv->RecvContext->Tuple.RemoteAddress);
 
-    SocketContext->RecvWsaMsgHdr.lpBuffers = &SocketContext->RecvWsaBuf;
-    SocketContext->RecvWsaMsgHdr.dwBufferCount = 1;
+    PendedRecv->WsaMsgHdr.lpBuffers = &PendedRecv->WsaBuf;
+    PendedRecv->WsaMsgHdr.dwBufferCount = 1;
 
-    SocketContext->RecvWsaMsgHdr.Control.buf = SocketContext->RecvWsaMsgControlBuf;
-    SocketContext->RecvWsaMsgHdr.Control.len = sizeof(SocketContext->RecvWsaMsgControlBuf);
+    PendedRecv->WsaMsgHdr.Control.buf = PendedRecv->WsaMsgControlBuf;
+    PendedRecv->WsaMsgHdr.Control.len = sizeof(PendedRecv->WsaMsgControlBuf);
 
 Retry_recv:
 
     Result =
         SocketContext->Binding->Datapath->WSARecvMsg(
             SocketContext->Socket,
-            &SocketContext->RecvWsaMsgHdr,
+            &PendedRecv->WsaMsgHdr,
             &BytesRecv,
-            &SocketContext->RecvOverlapped,
+            &PendedRecv->Overlapped,
             NULL);
     if (Result == SOCKET_ERROR) {
         int WsaError = WSAGetLastError();
         if (WsaError != WSA_IO_PENDING) {
             if (WsaError == WSAECONNRESET) {
-                QuicDataPathBindingHandleUnreachableError(SocketContext, (ULONG)WsaError);
+                QuicDataPathBindingHandleUnreachableError(
+                    SocketContext,
+                    &PendedRecv->RecvContext->Tuple.RemoteAddress,
+                    (ULONG)WsaError);
                 goto Retry_recv;
             } else {
                 QuicTraceEvent(
@@ -1828,7 +2154,7 @@ Retry_recv:
                 CompletionPort,
                 BytesRecv,
                 (ULONG_PTR)SocketContext,
-                &SocketContext->RecvOverlapped)) {
+                &PendedRecv->Overlapped)) {
             DWORD LastError = GetLastError();
             QuicTraceEvent(
                 DatapathErrorStatus,
@@ -1848,214 +2174,295 @@ Error:
     return Status;
 }
 
-void
-QuicDataPathRecvComplete(
-    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+QUIC_STATUS
+QuicDataPathBindingStartReceive(
     _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
-    _In_ ULONG IoResult,
-    _In_ UINT16 NumberOfBytesTransferred
+    _In_ HANDLE CompletionPort
     )
 {
+    QUIC_DATAPATH* Datapath = SocketContext->Binding->Datapath;
+
+    if (Datapath->Features & QUIC_DATAPATH_FEATURE_RIO) {
+        if (SocketContext->RioSlab == NULL) {
+            return QuicDataPathRioStartReceives(SocketContext, CompletionPort);
+        }
+        //
+        // RIO receives are reposted from the completion path directly.
+        //
+        return QUIC_STATUS_SUCCESS;
+    }
+
     //
-    // Copy the current receive buffer locally. On error cases, we leave the
-    // buffer set as the current receive buffer because we are only using it
-    // inline. Otherwise, we remove it as the current because we are giving
-    // it to the client.
+    // Post the full ring of receives. Each one is reposted individually
+    // from its completion, so this only runs when the socket starts up.
     //
-    QUIC_DBG_ASSERT(SocketContext->CurrentRecvContext != NULL);
-    QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext = SocketContext->CurrentRecvContext;
-    if (IoResult == NO_ERROR) {
-        SocketContext->CurrentRecvContext = NULL;
+    for (uint32_t i = 0; i < QUIC_RECV_IO_DEPTH; ++i) {
+        QUIC_STATUS Status =
+            QuicDataPathBindingStartReceiveSlot(
+                SocketContext,
+                CompletionPort,
+                &SocketContext->PendedRecvs[i]);
+        if (QUIC_FAILED(Status)) {
+            return Status;
+        }
     }
 
+    return QUIC_STATUS_SUCCESS;
+}
+
+//
+// Parses the control messages of a completed receive, splits the payload
+// into individual datagrams and indicates the chain to the upper layer.
+// Returns TRUE if ownership of the receive context was handed off
+// (references were taken), or FALSE if the receive was dropped and the
+// context can be reused.
+//
+BOOLEAN
+QuicDataPathDeliverRecv(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
+    _In_ QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext,
+    _In_ PWSAMSG WsaMsgHdr,
+    _In_ UINT16 NumberOfBytesTransferred
+    )
+{
     PSOCKADDR_INET RemoteAddr = &RecvContext->Tuple.RemoteAddress;
     PSOCKADDR_INET LocalAddr = &RecvContext->Tuple.LocalAddress;
 
-    if (IoResult == WSAENOTSOCK || IoResult == WSA_OPERATION_ABORTED) {
+    QUIC_RECV_DATAGRAM* DatagramChain = NULL;
+    QUIC_RECV_DATAGRAM** DatagramChainTail = &DatagramChain;
+
+    QUIC_DATAPATH* Datapath = SocketContext->Binding->Datapath;
+    QUIC_RECV_DATAGRAM* Datagram;
+    PUCHAR RecvPayload = ((PUCHAR)RecvContext) + Datapath->RecvPayloadOffset;
+
+    BOOLEAN FoundLocalAddr = FALSE;
+    UINT16 MessageLength = NumberOfBytesTransferred;
+    ULONG MessageCount = 0;
+    BOOLEAN IsCoalesced = FALSE;
+
+    for (WSACMSGHDR *CMsg = WSA_CMSG_FIRSTHDR(WsaMsgHdr);
+        CMsg != NULL;
+        CMsg = WSA_CMSG_NXTHDR(WsaMsgHdr, CMsg)) {
+
+        if (CMsg->cmsg_level == IPPROTO_IPV6 && CMsg->cmsg_type == IPV6_PKTINFO) {
+            PIN6_PKTINFO PktInfo6 = (PIN6_PKTINFO)WSA_CMSG_DATA(CMsg);
+            LocalAddr->si_family = AF_INET6;
+            LocalAddr->Ipv6.sin6_addr = PktInfo6->ipi6_addr;
+            LocalAddr->Ipv6.sin6_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
+            QuicConvertFromMappedV6(LocalAddr, LocalAddr);
+
+            LocalAddr->Ipv6.sin6_scope_id = PktInfo6->ipi6_ifindex;
+            FoundLocalAddr = TRUE;
+        } else if (CMsg->cmsg_level == IPPROTO_IP && CMsg->cmsg_type == IP_PKTINFO) {
+            PIN_PKTINFO PktInfo = (PIN_PKTINFO)WSA_CMSG_DATA(CMsg);
+            LocalAddr->si_family = AF_INET;
+            LocalAddr->Ipv4.sin_addr = PktInfo->ipi_addr;
+            LocalAddr->Ipv4.sin_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
+            LocalAddr->Ipv6.sin6_scope_id = PktInfo->ipi_ifindex;
+            FoundLocalAddr = TRUE;
+#ifdef UDP_RECV_MAX_COALESCED_SIZE
+        } else if (CMsg->cmsg_level == IPPROTO_UDP && CMsg->cmsg_type == UDP_COALESCED_INFO) {
+            QUIC_DBG_ASSERT(*(PDWORD)WSA_CMSG_DATA(CMsg) <= MAX_URO_PAYLOAD_LENGTH);
+            MessageLength = (UINT16)*(PDWORD)WSA_CMSG_DATA(CMsg);
+            IsCoalesced = TRUE;
+#endif
+        }
+    }
+
+    if (!FoundLocalAddr) {
         //
-        // Error from shutdown, silently ignore. Return immediately so the
-        // receive doesn't get reposted.
+        // The underlying data path does not guarantee ancillary data for
+        // enabled socket options when the system is under memory pressure.
         //
-        return;
-
-    } else if (IsUnreachableErrorCode(IoResult)) {
+        QuicTraceLogWarning(
+            DatapathMissingInfo,
+            "[ udp][%p] WSARecvMsg completion is missing IP_PKTINFO",
+            SocketContext->Binding);
+        return FALSE;
+    }
 
-        QuicDataPathBindingHandleUnreachableError(SocketContext, IoResult);
+    if (NumberOfBytesTransferred == 0) {
+        QuicTraceLogWarning(
+            DatapathRecvEmpty,
+            "[ udp][%p] Dropping datagram with empty payload.",
+            SocketContext->Binding);
+        return FALSE;
+    }
 
-    } else if (IoResult == ERROR_MORE_DATA ||
-        (IoResult == NO_ERROR && SocketContext->RecvWsaBuf.len < NumberOfBytesTransferred)) {
+    QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
 
-        QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
+    QuicTraceEvent(
+        DatapathRecv,
+        "[ udp][%p] Recv %u bytes (segment=%hu) Src=%!SOCKADDR! Dst=%!SOCKADDR!",
+        SocketContext->Binding,
+        NumberOfBytesTransferred,
+        MessageLength,
+        LOG_ADDR_LEN(*LocalAddr),
+        LOG_ADDR_LEN(*RemoteAddr),
+        (UINT8*)LocalAddr,
+        (UINT8*)RemoteAddr);
 
-#if 0 // TODO - Change to ETW event
-        if (RemoteAddr->si_family == AF_INET) {
-            QuicTraceLogVerbose(
-                DatapathTooLarge,
-                "[ udp][%p] Received larger than expected datagram from %!IPV4ADDR!:%d",
-                SocketContext->Binding,
-                &RemoteAddr->Ipv4.sin_addr,
-                ntohs(RemoteAddr->Ipv4.sin_port));
-        }
-        else {
-            QuicTraceLogVerbose(
-                DatapathTooLargeV6,
-                "[ udp][%p] Received larger than expected datagram from [%!IPV6ADDR!]:%d",
-                SocketContext->Binding,
-                &RemoteAddr->Ipv6.sin6_addr,
-                ntohs(RemoteAddr->Ipv6.sin6_port));
-        }
-#endif
+    QUIC_DBG_ASSERT(NumberOfBytesTransferred <= SocketContext->RecvWsaBuf.len);
 
-        //
-        // TODO - Indicate to Core library.
-        //
+    //
+    // No kernel receive timestamp is available here, so stamp the datagrams
+    // with the completion processing time.
+    //
+    uint64_t RecvTimeUs = QuicTimeUs64();
 
-    } else if (IoResult == QUIC_STATUS_SUCCESS) {
+    Datagram = (QUIC_RECV_DATAGRAM*)(RecvContext + 1);
 
-        QUIC_RECV_DATAGRAM* DatagramChain = NULL;
-        QUIC_RECV_DATAGRAM** DatagramChainTail = &DatagramChain;
+    for ( ;
+        NumberOfBytesTransferred != 0;
+        NumberOfBytesTransferred -= MessageLength) {
 
-        QUIC_DATAPATH* Datapath = SocketContext->Binding->Datapath;
-        QUIC_RECV_DATAGRAM* Datagram;
-        PUCHAR RecvPayload = ((PUCHAR)RecvContext) + Datapath->RecvPayloadOffset;
-
-        BOOLEAN FoundLocalAddr = FALSE;
-        UINT16 MessageLength = NumberOfBytesTransferred;
-        ULONG MessageCount = 0;
-        BOOLEAN IsCoalesced = FALSE;
-
-        for (WSACMSGHDR *CMsg = WSA_CMSG_FIRSTHDR(&SocketContext->RecvWsaMsgHdr);
-            CMsg != NULL;
-            CMsg = WSA_CMSG_NXTHDR(&SocketContext->RecvWsaMsgHdr, CMsg)) {
-
-            if (CMsg->cmsg_level == IPPROTO_IPV6 && CMsg->cmsg_type == IPV6_PKTINFO) {
-                PIN6_PKTINFO PktInfo6 = (PIN6_PKTINFO)WSA_CMSG_DATA(CMsg);
-                LocalAddr->si_family = AF_INET6;
-                LocalAddr->Ipv6.sin6_addr = PktInfo6->ipi6_addr;
-                LocalAddr->Ipv6.sin6_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
-                QuicConvertFromMappedV6(LocalAddr, LocalAddr);
-
-                LocalAddr->Ipv6.sin6_scope_id = PktInfo6->ipi6_ifindex;
-                FoundLocalAddr = TRUE;
-            } else if (CMsg->cmsg_level == IPPROTO_IP && CMsg->cmsg_type == IP_PKTINFO) {
-                PIN_PKTINFO PktInfo = (PIN_PKTINFO)WSA_CMSG_DATA(CMsg);
-                LocalAddr->si_family = AF_INET;
-                LocalAddr->Ipv4.sin_addr = PktInfo->ipi_addr;
-                LocalAddr->Ipv4.sin_port = SocketContext->Binding->LocalAddress.Ipv6.sin6_port;
-                LocalAddr->Ipv6.sin6_scope_id = PktInfo->ipi_ifindex;
-                FoundLocalAddr = TRUE;
-#ifdef UDP_RECV_MAX_COALESCED_SIZE
-            } else if (CMsg->cmsg_level == IPPROTO_UDP && CMsg->cmsg_type == UDP_COALESCED_INFO) {
-                QUIC_DBG_ASSERT(*(PDWORD)WSA_CMSG_DATA(CMsg) <= MAX_URO_PAYLOAD_LENGTH);
-                MessageLength = (UINT16)*(PDWORD)WSA_CMSG_DATA(CMsg);
-                IsCoalesced = TRUE;
-#endif
-            }
-        }
+        QUIC_DATAPATH_INTERNAL_RECV_BUFFER_CONTEXT* InternalDatagramContext =
+            QuicDataPathDatagramToInternalDatagramContext(Datagram);
+        InternalDatagramContext->RecvContext = RecvContext;
 
-        if (!FoundLocalAddr) {
+        if (MessageLength > NumberOfBytesTransferred) {
             //
-            // The underlying data path does not guarantee ancillary data for
-            // enabled socket options when the system is under memory pressure.
+            // The last message is smaller than all the rest.
             //
-            QuicTraceLogWarning(
-                DatapathMissingInfo,
-                "[ udp][%p] WSARecvMsg completion is missing IP_PKTINFO",
-                SocketContext->Binding);
-            goto Drop;
+            MessageLength = NumberOfBytesTransferred;
         }
 
-        if (NumberOfBytesTransferred == 0) {
-            QuicTraceLogWarning(
-                DatapathRecvEmpty,
-                "[ udp][%p] Dropping datagram with empty payload.",
+        Datagram->Next = NULL;
+        Datagram->Buffer = RecvPayload;
+        Datagram->BufferLength = MessageLength;
+        Datagram->Tuple = &RecvContext->Tuple;
+        Datagram->RecvTimeUs = RecvTimeUs;
+        Datagram->PartitionIndex = (uint8_t)ProcContext->Index;
+        Datagram->TypeOfService = 0;
+        Datagram->Allocated = TRUE;
+        Datagram->QueuedOnConnection = FALSE;
+
+        RecvPayload += MessageLength;
+
+        //
+        // Add the datagram to the end of the current chain.
+        //
+        *DatagramChainTail = Datagram;
+        DatagramChainTail = &Datagram->Next;
+        RecvContext->ReferenceCount++;
+
+        Datagram = (QUIC_RECV_DATAGRAM*)
+            (((PUCHAR)Datagram) +
+                SocketContext->Binding->Datapath->DatagramStride);
+
+        if (IsCoalesced && ++MessageCount == URO_MAX_DATAGRAMS_PER_INDICATION) {
+            QuicTraceLogWarning(
+                DatapathUroPreallocExceeded,
+                "[ udp][%p] Exceeded URO preallocation capacity.",
                 SocketContext->Binding);
-            goto Drop;
+            break;
         }
+    }
 
-        QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
+    QUIC_DBG_ASSERT(SocketContext->Binding->Datapath->RecvHandler);
+    QUIC_DBG_ASSERT(DatagramChain);
 
-        QuicTraceEvent(
-            DatapathRecv,
-            "[ udp][%p] Recv %u bytes (segment=%hu) Src=%!SOCKADDR! Dst=%!SOCKADDR!",
-            SocketContext->Binding,
-            NumberOfBytesTransferred,
-            MessageLength,
-            LOG_ADDR_LEN(*LocalAddr),
-            LOG_ADDR_LEN(*RemoteAddr),
-            (UINT8*)LocalAddr,
-            (UINT8*)RemoteAddr);
+#ifdef QUIC_FUZZER
+    if (MsQuicFuzzerContext.RecvCallback) {
+        QUIC_RECV_DATAGRAM *_DatagramIter = DatagramChain;
 
-        QUIC_DBG_ASSERT(NumberOfBytesTransferred <= SocketContext->RecvWsaBuf.len);
+        while (_DatagramIter) {
+            MsQuicFuzzerContext.RecvCallback(
+                MsQuicFuzzerContext.CallbackContext,
+                _DatagramIter->Buffer,
+                _DatagramIter->BufferLength);
+            _DatagramIter = _DatagramIter->Next;
+        }
+    }
+#endif
 
-        Datagram = (QUIC_RECV_DATAGRAM*)(RecvContext + 1);
+    SocketContext->Binding->Datapath->RecvHandler(
+        SocketContext->Binding,
+        SocketContext->Binding->ClientContext,
+        DatagramChain);
 
-        for ( ;
-            NumberOfBytesTransferred != 0;
-            NumberOfBytesTransferred -= MessageLength) {
+    return TRUE;
+}
 
-            QUIC_DATAPATH_INTERNAL_RECV_BUFFER_CONTEXT* InternalDatagramContext =
-                QuicDataPathDatagramToInternalDatagramContext(Datagram);
-            InternalDatagramContext->RecvContext = RecvContext;
+void
+QuicDataPathRecvComplete(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
+    _Inout_ QUIC_DATAPATH_PENDED_RECV* PendedRecv,
+    _In_ ULONG IoResult,
+    _In_ UINT16 NumberOfBytesTransferred
+    )
+{
+    //
+    // Copy the posted receive buffer locally. On error cases, we leave the
+    // buffer attached to the slot because we are only using it inline.
+    // Otherwise, we detach it because we are giving it to the client.
+    //
+    QUIC_DBG_ASSERT(PendedRecv->RecvContext != NULL);
+    QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext = PendedRecv->RecvContext;
+    if (IoResult == NO_ERROR) {
+        PendedRecv->RecvContext = NULL;
+    }
 
-            if (MessageLength > NumberOfBytesTransferred) {
-                //
-                // The last message is smaller than all the rest.
-                //
-                MessageLength = NumberOfBytesTransferred;
-            }
+    PSOCKADDR_INET RemoteAddr = &RecvContext->Tuple.RemoteAddress;
 
-            Datagram->Next = NULL;
-            Datagram->Buffer = RecvPayload;
-            Datagram->BufferLength = MessageLength;
-            Datagram->Tuple = &RecvContext->Tuple;
-            Datagram->PartitionIndex = (uint8_t)ProcContext->Index;
-            Datagram->Allocated = TRUE;
-            Datagram->QueuedOnConnection = FALSE;
+    if (IoResult == WSAENOTSOCK || IoResult == WSA_OPERATION_ABORTED) {
+        //
+        // Error from shutdown, silently ignore. Return immediately so the
+        // receive doesn't get reposted.
+        //
+        return;
 
-            RecvPayload += MessageLength;
+    } else if (IsUnreachableErrorCode(IoResult)) {
 
-            //
-            // Add the datagram to the end of the current chain.
-            //
-            *DatagramChainTail = Datagram;
-            DatagramChainTail = &Datagram->Next;
-            RecvContext->ReferenceCount++;
-
-            Datagram = (QUIC_RECV_DATAGRAM*)
-                (((PUCHAR)Datagram) +
-                    SocketContext->Binding->Datapath->DatagramStride);
-
-            if (IsCoalesced && ++MessageCount == URO_MAX_DATAGRAMS_PER_INDICATION) {
-                QuicTraceLogWarning(
-                    DatapathUroPreallocExceeded,
-                    "[ udp][%p] Exceeded URO preallocation capacity.",
-                    SocketContext->Binding);
-                break;
-            }
-        }
+        QuicDataPathBindingHandleUnreachableError(
+            SocketContext, &RecvContext->Tuple.RemoteAddress, IoResult);
 
-        QUIC_DBG_ASSERT(SocketContext->Binding->Datapath->RecvHandler);
-        QUIC_DBG_ASSERT(DatagramChain);
+    } else if (IoResult == ERROR_MORE_DATA ||
+        (IoResult == NO_ERROR && SocketContext->RecvWsaBuf.len < NumberOfBytesTransferred)) {
 
-#ifdef QUIC_FUZZER
-        if (MsQuicFuzzerContext.RecvCallback) {
-            QUIC_RECV_DATAGRAM *_DatagramIter = DatagramChain;
-
-            while (_DatagramIter) {
-                MsQuicFuzzerContext.RecvCallback(
-                    MsQuicFuzzerContext.CallbackContext,
-                    _DatagramIter->Buffer,
-                    _DatagramIter->BufferLength);
-                _DatagramIter = _DatagramIter->Next;
-            }
+        QuicConvertFromMappedV6(RemoteAddr, RemoteAddr);
+
+#if 0 // TODO - Change to ETW event
+        if (RemoteAddr->si_family == AF_INET) {
+            QuicTraceLogVerbose(
+                DatapathTooLarge,
+                "[ udp][%p] Received larger than expected datagram from %!IPV4ADDR!:%d",
+                SocketContext->Binding,
+                &RemoteAddr->Ipv4.sin_addr,
+                ntohs(RemoteAddr->Ipv4.sin_port));
+        }
+        else {
+            QuicTraceLogVerbose(
+                DatapathTooLargeV6,
+                "[ udp][%p] Received larger than expected datagram from [%!IPV6ADDR!]:%d",
+                SocketContext->Binding,
+                &RemoteAddr->Ipv6.sin6_addr,
+                ntohs(RemoteAddr->Ipv6.sin6_port));
         }
 #endif
 
-        SocketContext->Binding->Datapath->RecvHandler(
-            SocketContext->Binding,
-            SocketContext->Binding->ClientContext,
-            DatagramChain);
+        //
+        // TODO - Indicate to Core library.
+        //
+
+    } else if (IoResult == QUIC_STATUS_SUCCESS) {
+
+        QUIC_DBG_ASSERT(NumberOfBytesTransferred <= SocketContext->RecvWsaBuf.len);
+
+        if (!QuicDataPathDeliverRecv(
+                ProcContext,
+                SocketContext,
+                RecvContext,
+                &PendedRecv->WsaMsgHdr,
+                NumberOfBytesTransferred)) {
+            //
+            // The receive was dropped. Keep the context attached to the slot
+            // so the buffer is reused by the repost.
+            //
+            PendedRecv->RecvContext = RecvContext;
+        }
 
     } else {
         QuicTraceEvent(
@@ -2066,11 +2473,439 @@ QuicDataPathRecvComplete(
             "WSARecvMsg completion");
     }
 
-Drop:
     //
-    // Try to start a new receive.
+    // Try to repost this slot's receive.
+    //
+    (void)QuicDataPathBindingStartReceiveSlot(
+        SocketContext, ProcContext->IOCP, PendedRecv);
+}
+
+void
+QuicDataPathRioFreeSlab(
+    _In_ QUIC_RIO_SLAB* Slab
+    )
+{
+    QuicDispatchLockUninitialize(&Slab->Lock);
+    QUIC_FREE(Slab->Memory);
+    QUIC_FREE(Slab);
+}
+
+void
+QuicDataPathRioReleaseRecvContext(
+    _In_ QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext
+    )
+{
+    QUIC_RIO_SLAB* Slab = RecvContext->RioSlab;
+    BOOLEAN Wake = FALSE;
+
+    QuicDispatchLockAcquire(&Slab->Lock);
+    QuicListInsertTail(&Slab->FreeList, (QUIC_LIST_ENTRY*)RecvContext);
+    Slab->DeliveredCount--;
+    if (Slab->SocketContext != NULL &&
+        Slab->PostedCount == 0 &&
+        !Slab->WakeQueued) {
+        //
+        // The request queue ran dry while every slot was held by the client.
+        // Wake the completion thread so it can repost receives.
+        //
+        Slab->WakeQueued = TRUE;
+        Wake = TRUE;
+    }
+    BOOLEAN FreeSlab =
+        Slab->SocketContext == NULL &&
+        Slab->DeliveredCount == 0 &&
+        !Slab->WakeQueued;
+    QuicDispatchLockRelease(&Slab->Lock);
+
+    if (Wake &&
+        !PostQueuedCompletionStatus(Slab->Iocp, 0, 0, &Slab->WakeOverlapped)) {
+        QuicDispatchLockAcquire(&Slab->Lock);
+        Slab->WakeQueued = FALSE;
+        FreeSlab =
+            Slab->SocketContext == NULL && Slab->DeliveredCount == 0;
+        QuicDispatchLockRelease(&Slab->Lock);
+    }
+
+    if (FreeSlab) {
+        QuicDataPathRioFreeSlab(Slab);
+    }
+}
+
+void
+QuicDataPathRioPostReceives(
+    _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext
+    )
+{
+    QUIC_RIO_SLAB* Slab = SocketContext->RioSlab;
+    QUIC_DATAPATH* Datapath = Slab->Datapath;
+
+    QuicDispatchLockAcquire(&Slab->Lock);
+
+    while (!QuicListIsEmpty(&Slab->FreeList)) {
+
+        QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext =
+            (QUIC_DATAPATH_INTERNAL_RECV_CONTEXT*)
+                QuicListRemoveHead(&Slab->FreeList);
+        ULONG SlotOffset = (ULONG)((CHAR*)RecvContext - Slab->Memory);
+
+        RIO_BUF Data;
+        Data.BufferId = Slab->BufferId;
+        Data.Offset = SlotOffset + Datapath->RecvPayloadOffset;
+        Data.Length = SocketContext->RecvWsaBuf.len;
+
+        RIO_BUF RemoteAddr;
+        RemoteAddr.BufferId = Slab->BufferId;
+        RemoteAddr.Offset =
+            SlotOffset +
+            FIELD_OFFSET(QUIC_DATAPATH_INTERNAL_RECV_CONTEXT, Tuple.RemoteAddress);
+        RemoteAddr.Length = sizeof(SOCKADDR_INET);
+
+        RIO_BUF Control;
+        Control.BufferId = Slab->BufferId;
+        Control.Offset = SlotOffset + Datapath->RioControlOffset;
+        Control.Length = QUIC_RIO_CONTROL_LENGTH;
+
+        //
+        // The descriptors are copied by RIOReceiveEx, so they can live on
+        // the stack.
+        //
+        if (!Datapath->RioDispatch.RIOReceiveEx(
+                SocketContext->RioRq,
+                &Data,
+                1,
+                NULL,
+                &RemoteAddr,
+                &Control,
+                NULL,
+                0,
+                RecvContext)) {
+            QuicTraceEvent(
+                DatapathErrorStatus,
+                "[ udp][%p] ERROR, %u, %s.",
+                SocketContext->Binding,
+                WSAGetLastError(),
+                "RIOReceiveEx");
+            QuicListInsertHead(&Slab->FreeList, (QUIC_LIST_ENTRY*)RecvContext);
+            break;
+        }
+
+        Slab->PostedCount++;
+    }
+
+    QuicDispatchLockRelease(&Slab->Lock);
+}
+
+QUIC_STATUS
+QuicDataPathRioStartReceives(
+    _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext,
+    _In_ HANDLE CompletionPort
+    )
+{
+    QUIC_STATUS Status;
+    QUIC_DATAPATH* Datapath = SocketContext->Binding->Datapath;
+    RIO_NOTIFICATION_COMPLETION NotificationCompletion;
+    SIZE_T SlabMemoryLength =
+        (SIZE_T)QUIC_RIO_RECV_COUNT * Datapath->RioSlotSize;
+    int NotifyResult;
+
+    QUIC_RIO_SLAB* Slab = (QUIC_RIO_SLAB*)QUIC_ALLOC_PAGED(sizeof(QUIC_RIO_SLAB));
+    if (Slab == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "QUIC_RIO_SLAB",
+            sizeof(QUIC_RIO_SLAB));
+        return QUIC_STATUS_OUT_OF_MEMORY;
+    }
+
+    RtlZeroMemory(Slab, sizeof(QUIC_RIO_SLAB));
+    Slab->BufferId = RIO_INVALID_BUFFERID;
+    Slab->Datapath = Datapath;
+    Slab->Iocp = CompletionPort;
+    QuicDispatchLockInitialize(&Slab->Lock);
+    QuicListInitializeHead(&Slab->FreeList);
+
+    Slab->Memory = (CHAR*)QUIC_ALLOC_NONPAGED(SlabMemoryLength);
+    if (Slab->Memory == NULL) {
+        QuicTraceEvent(
+            AllocFailure,
+            "Allocation of '%s' failed. (%llu bytes)",
+            "RIO receive slab",
+            SlabMemoryLength);
+        Status = QUIC_STATUS_OUT_OF_MEMORY;
+        goto Error;
+    }
+
+    Slab->BufferId =
+        Datapath->RioDispatch.RIORegisterBuffer(
+            Slab->Memory,
+            (DWORD)SlabMemoryLength);
+    if (Slab->BufferId == RIO_INVALID_BUFFERID) {
+        int WsaError = WSAGetLastError();
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            SocketContext->Binding,
+            WsaError,
+            "RIORegisterBuffer");
+        Status = HRESULT_FROM_WIN32(WsaError);
+        goto Error;
+    }
+
+    NotificationCompletion.Type = RIO_IOCP_COMPLETION;
+    NotificationCompletion.Iocp.IocpHandle = CompletionPort;
+    NotificationCompletion.Iocp.CompletionKey = (void*)SocketContext;
+    NotificationCompletion.Iocp.Overlapped = &SocketContext->RioNotifyOverlapped;
+
+    SocketContext->RioCq =
+        Datapath->RioDispatch.RIOCreateCompletionQueue(
+            QUIC_RIO_RECV_COUNT,
+            &NotificationCompletion);
+    if (SocketContext->RioCq == RIO_INVALID_CQ) {
+        int WsaError = WSAGetLastError();
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            SocketContext->Binding,
+            WsaError,
+            "RIOCreateCompletionQueue");
+        Status = HRESULT_FROM_WIN32(WsaError);
+        goto Error;
+    }
+
+    SocketContext->RioRq =
+        Datapath->RioDispatch.RIOCreateRequestQueue(
+            SocketContext->Socket,
+            QUIC_RIO_RECV_COUNT,
+            1,
+            1,      // Sends stay on WSASendMsg; minimal send queue.
+            1,
+            SocketContext->RioCq,
+            SocketContext->RioCq,
+            SocketContext);
+    if (SocketContext->RioRq == RIO_INVALID_RQ) {
+        int WsaError = WSAGetLastError();
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            SocketContext->Binding,
+            WsaError,
+            "RIOCreateRequestQueue");
+        Status = HRESULT_FROM_WIN32(WsaError);
+        goto Error;
+    }
+
+    for (uint32_t i = 0; i < QUIC_RIO_RECV_COUNT; i++) {
+        QuicListInsertTail(
+            &Slab->FreeList,
+            (QUIC_LIST_ENTRY*)(Slab->Memory + (SIZE_T)i * Datapath->RioSlotSize));
+    }
+
+    Slab->SocketContext = SocketContext;
+    SocketContext->RioSlab = Slab;
+
+    //
+    // Arm the notification before posting, so the first completion is
+    // guaranteed to surface on the completion port.
     //
-    (void)QuicDataPathBindingStartReceive(SocketContext, ProcContext->IOCP);
+    NotifyResult = Datapath->RioDispatch.RIONotify(SocketContext->RioCq);
+    if (NotifyResult != ERROR_SUCCESS) {
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            SocketContext->Binding,
+            NotifyResult,
+            "RIONotify");
+        Status = HRESULT_FROM_WIN32(NotifyResult);
+        SocketContext->RioSlab = NULL;
+        Slab->SocketContext = NULL;
+        goto Error;
+    }
+
+    QuicDataPathRioPostReceives(SocketContext);
+    if (Slab->PostedCount == 0) {
+        Status = QUIC_STATUS_INTERNAL_ERROR;
+        SocketContext->RioSlab = NULL;
+        Slab->SocketContext = NULL;
+        goto Error;
+    }
+
+    return QUIC_STATUS_SUCCESS;
+
+Error:
+
+    if (SocketContext->RioCq != RIO_INVALID_CQ) {
+        Datapath->RioDispatch.RIOCloseCompletionQueue(SocketContext->RioCq);
+        SocketContext->RioCq = RIO_INVALID_CQ;
+        SocketContext->RioRq = RIO_INVALID_RQ;
+    }
+    if (Slab->BufferId != RIO_INVALID_BUFFERID) {
+        Datapath->RioDispatch.RIODeregisterBuffer(Slab->BufferId);
+    }
+    if (Slab->Memory != NULL) {
+        QUIC_FREE(Slab->Memory);
+    }
+    QuicDispatchLockUninitialize(&Slab->Lock);
+    QUIC_FREE(Slab);
+
+    return Status;
+}
+
+void
+QuicDataPathRioRecvComplete(
+    _In_ QUIC_DATAPATH_PROC_CONTEXT* ProcContext,
+    _In_ QUIC_UDP_SOCKET_CONTEXT* SocketContext
+    )
+{
+    QUIC_RIO_SLAB* Slab = SocketContext->RioSlab;
+    QUIC_DATAPATH* Datapath = Slab->Datapath;
+    RIORESULT Results[QUIC_RIO_BATCH_SIZE];
+    int NotifyResult;
+
+    while (TRUE) {
+
+        ULONG ResultCount =
+            Datapath->RioDispatch.RIODequeueCompletion(
+                SocketContext->RioCq,
+                Results,
+                QUIC_RIO_BATCH_SIZE);
+        if (ResultCount == 0) {
+            break;
+        }
+        if (ResultCount == RIO_CORRUPT_CQ) {
+            QuicTraceEvent(
+                DatapathErrorStatus,
+                "[ udp][%p] ERROR, %u, %s.",
+                SocketContext->Binding,
+                RIO_CORRUPT_CQ,
+                "RIODequeueCompletion");
+            return;
+        }
+
+        QuicDispatchLockAcquire(&Slab->Lock);
+        Slab->PostedCount -= ResultCount;
+        QuicDispatchLockRelease(&Slab->Lock);
+
+        for (ULONG i = 0; i < ResultCount; i++) {
+
+            QUIC_DATAPATH_INTERNAL_RECV_CONTEXT* RecvContext =
+                (QUIC_DATAPATH_INTERNAL_RECV_CONTEXT*)(ULONG_PTR)
+                    Results[i].RequestContext;
+            ULONG IoResult = Results[i].Status;
+            BOOLEAN Delivered = FALSE;
+
+            RecvContext->OwningPool = NULL;
+            RecvContext->ReferenceCount = 0;
+            RecvContext->RioSlab = Slab;
+
+            if (IoResult == WSAENOTSOCK || IoResult == WSA_OPERATION_ABORTED) {
+                //
+                // Error from shutdown, silently ignore and recycle the slot.
+                //
+
+            } else if (IsUnreachableErrorCode(IoResult)) {
+                //
+                // RIO does not fill in the remote address buffer for failed
+                // receives, so reconstruct it from the connected binding.
+                //
+                QuicConvertToMappedV6(
+                    &SocketContext->Binding->RemoteAddress,
+                    &RecvContext->Tuple.RemoteAddress);
+                QuicDataPathBindingHandleUnreachableError(
+                    SocketContext, &RecvContext->Tuple.RemoteAddress, IoResult);
+
+            } else if (IoResult == NO_ERROR) {
+
+                QUIC_DBG_ASSERT(
+                    Results[i].BytesTransferred <= SocketContext->RecvWsaBuf.len);
+
+                RIO_CMSG_BUFFER* RioCmsg =
+                    (RIO_CMSG_BUFFER*)
+                        ((CHAR*)RecvContext + Datapath->RioControlOffset);
+
+                WSAMSG WsaMsgHdr;
+                RtlZeroMemory(&WsaMsgHdr, sizeof(WsaMsgHdr));
+                WsaMsgHdr.Control.buf = (CHAR*)RioCmsg + RIO_CMSG_BASE_SIZE;
+                if (RioCmsg->TotalLength >= RIO_CMSG_BASE_SIZE) {
+                    WsaMsgHdr.Control.len =
+                        RioCmsg->TotalLength - RIO_CMSG_BASE_SIZE;
+                }
+
+                Delivered =
+                    QuicDataPathDeliverRecv(
+                        ProcContext,
+                        SocketContext,
+                        RecvContext,
+                        &WsaMsgHdr,
+                        (UINT16)Results[i].BytesTransferred);
+
+            } else {
+                QuicTraceEvent(
+                    DatapathErrorStatus,
+                    "[ udp][%p] ERROR, %u, %s.",
+                    SocketContext->Binding,
+                    IoResult,
+                    "RIO receive completion");
+            }
+
+            QuicDispatchLockAcquire(&Slab->Lock);
+            if (Delivered) {
+                Slab->DeliveredCount++;
+            } else {
+                QuicListInsertTail(&Slab->FreeList, (QUIC_LIST_ENTRY*)RecvContext);
+            }
+            QuicDispatchLockRelease(&Slab->Lock);
+        }
+    }
+
+    QuicDataPathRioPostReceives(SocketContext);
+
+    NotifyResult = Datapath->RioDispatch.RIONotify(SocketContext->RioCq);
+    if (NotifyResult != ERROR_SUCCESS) {
+        QuicTraceEvent(
+            DatapathErrorStatus,
+            "[ udp][%p] ERROR, %u, %s.",
+            SocketContext->Binding,
+            NotifyResult,
+            "RIONotify");
+    }
+}
+
+void
+QuicDataPathRioWakeComplete(
+    _In_ QUIC_RIO_SLAB* Slab
+    )
+{
+    QuicDispatchLockAcquire(&Slab->Lock);
+    Slab->WakeQueued = FALSE;
+    QUIC_UDP_SOCKET_CONTEXT* SocketContext = Slab->SocketContext;
+    BOOLEAN FreeSlab =
+        SocketContext == NULL && Slab->DeliveredCount == 0;
+    QuicDispatchLockRelease(&Slab->Lock);
+
+    if (SocketContext != NULL) {
+        //
+        // The socket context's shutdown runs on this same completion thread,
+        // so it cannot go away underneath us here.
+        //
+        QuicDataPathRioPostReceives(SocketContext);
+        //
+        // The completion path re-arms the notification even when the queue
+        // is empty, so it may still be armed here.
+        //
+        int NotifyResult =
+            Slab->Datapath->RioDispatch.RIONotify(SocketContext->RioCq);
+        if (NotifyResult != ERROR_SUCCESS && NotifyResult != WSAEALREADY) {
+            QuicTraceEvent(
+                DatapathErrorStatus,
+                "[ udp][%p] ERROR, %u, %s.",
+                SocketContext->Binding,
+                NotifyResult,
+                "RIONotify");
+        }
+    } else if (FreeSlab) {
+        QuicDataPathRioFreeSlab(Slab);
+    }
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -2102,9 +2937,13 @@ QuicDataPathBindingReturnRecvDatagrams(
                 //
                 // Clean up the data indication.
                 //
-                QuicPoolFree(
-                    BatchedInternalContext->OwningPool,
-                    BatchedInternalContext);
+                if (BatchedInternalContext->RioSlab != NULL) {
+                    QuicDataPathRioReleaseRecvContext(BatchedInternalContext);
+                } else {
+                    QuicPoolFree(
+                        BatchedInternalContext->OwningPool,
+                        BatchedInternalContext);
+                }
             }
 
             BatchedInternalContext = InternalContext;
@@ -2119,9 +2958,13 @@ QuicDataPathBindingReturnRecvDatagrams(
         //
         // Clean up the data indication.
         //
-        QuicPoolFree(
-            BatchedInternalContext->OwningPool,
-            BatchedInternalContext);
+        if (BatchedInternalContext->RioSlab != NULL) {
+            QuicDataPathRioReleaseRecvContext(BatchedInternalContext);
+        } else {
+            QuicPoolFree(
+                BatchedInternalContext->OwningPool,
+                BatchedInternalContext);
+        }
     }
 }
 
@@ -2148,6 +2991,7 @@ QuicDataPathBindingAllocSendContext(
                 ? MaxPacketSize : 0;
         SendContext->TotalSize = 0;
         SendContext->WsaBufferCount = 0;
+        SendContext->EcnCodePoint = 0;
         SendContext->ClientBuffer.len = 0;
         SendContext->ClientBuffer.buf = NULL;
     }
@@ -2173,6 +3017,20 @@ QuicDataPathBindingFreeSendContext(
     QuicPoolFree(&ProcContext->SendContextPool, SendContext);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+QuicDataPathBindingSetEcnCodePoint(
+    _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext,
+    _In_ QUIC_ECN_TYPE EcnCodePoint
+    )
+{
+    //
+    // TODO - Plumb the codepoint into an IP_ECN/IPV6_ECN control message on
+    // the WSASendMsg (and RIO) paths.
+    //
+    SendContext->EcnCodePoint = (UINT8)EcnCodePoint;
+}
+
 static
 BOOLEAN
 QuicSendContextCanAllocSendSegment(
@@ -2407,6 +3265,61 @@ QuicSendContextComplete(
     QuicDataPathBindingFreeSendContext(SendContext);
 }
 
+//
+// The platform specific contents of QUIC_DATAPATH_SEND_CACHE: the remote
+// address already mapped to the dual-stack format plus the preformatted
+// pktinfo control message for the local address.
+//
+typedef struct QUIC_DATAPATH_SEND_CACHE_WIN {
+    SOCKADDR_INET MappedRemoteAddress;
+    ULONG ControlLength;
+    char ControlBuffer[WSA_CMSG_SPACE(sizeof(IN6_PKTINFO))];
+} QUIC_DATAPATH_SEND_CACHE_WIN;
+
+static_assert(
+    sizeof(QUIC_DATAPATH_SEND_CACHE_WIN) <=
+        sizeof(((QUIC_DATAPATH_SEND_CACHE*)0)->Storage),
+    "QUIC_DATAPATH_SEND_CACHE storage too small");
+
+//
+// Formats the pktinfo control message for the given local address into the
+// control buffer and returns the length used.
+//
+ULONG
+QuicDataPathFormatPktInfo(
+    _In_ const SOCKADDR_INET* LocalAddress,
+    _Out_writes_bytes_(ControlBufferLength) PCHAR ControlBuffer,
+    _In_ ULONG ControlBufferLength
+    )
+{
+    WSAMSG ControlMhdr = { 0 };
+    ControlMhdr.Control.buf = ControlBuffer;
+    ControlMhdr.Control.len = ControlBufferLength;
+
+    PWSACMSGHDR CMsg = WSA_CMSG_FIRSTHDR(&ControlMhdr);
+    if (LocalAddress->si_family == AF_INET) {
+        CMsg->cmsg_level = IPPROTO_IP;
+        CMsg->cmsg_type = IP_PKTINFO;
+        CMsg->cmsg_len = WSA_CMSG_LEN(sizeof(IN_PKTINFO));
+
+        PIN_PKTINFO PktInfo = (PIN_PKTINFO)WSA_CMSG_DATA(CMsg);
+        PktInfo->ipi_ifindex = LocalAddress->Ipv6.sin6_scope_id;
+        PktInfo->ipi_addr = LocalAddress->Ipv4.sin_addr;
+
+        return WSA_CMSG_SPACE(sizeof(IN_PKTINFO));
+    } else {
+        CMsg->cmsg_level = IPPROTO_IPV6;
+        CMsg->cmsg_type = IPV6_PKTINFO;
+        CMsg->cmsg_len = WSA_CMSG_LEN(sizeof(IN6_PKTINFO));
+
+        PIN6_PKTINFO PktInfo6 = (PIN6_PKTINFO)WSA_CMSG_DATA(CMsg);
+        PktInfo6->ipi6_ifindex = LocalAddress->Ipv6.sin6_scope_id;
+        PktInfo6->ipi6_addr = LocalAddress->Ipv6.sin6_addr;
+
+        return WSA_CMSG_SPACE(sizeof(IN6_PKTINFO));
+    }
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QuicDataPathBindingSendTo(
@@ -2527,6 +3440,7 @@ QuicDataPathBindingSendFromTo(
     _In_ QUIC_DATAPATH_BINDING* Binding,
     _In_ const SOCKADDR_INET * LocalAddress,
     _In_ const SOCKADDR_INET * RemoteAddress,
+    _Inout_opt_ QUIC_DATAPATH_SEND_CACHE* SendCache,
     _In_ QUIC_DATAPATH_SEND_CONTEXT* SendContext
     )
 {
@@ -2566,52 +3480,57 @@ QuicDataPathBindingSendFromTo(
         (UINT8*)LocalAddress);
 
     //
-    // Map V4 address to dual-stack socket format.
+    // Map V4 address to dual-stack socket format and format the pktinfo
+    // control message for the local address, or reuse the preformatted
+    // copies if the caller's send cache already holds them.
     //
+    QUIC_DATAPATH_SEND_CACHE_WIN* Cache = NULL;
+    const SOCKADDR_INET* RemoteSockAddr;
     SOCKADDR_INET MappedRemoteAddress = { 0 };
-    QuicConvertToMappedV6(RemoteAddress, &MappedRemoteAddress);
+    if (SendCache != NULL) {
+        Cache = (QUIC_DATAPATH_SEND_CACHE_WIN*)SendCache->Storage;
+        if (!SendCache->IsPrepared) {
+            QuicConvertToMappedV6(RemoteAddress, &Cache->MappedRemoteAddress);
+            Cache->ControlLength =
+                QuicDataPathFormatPktInfo(
+                    LocalAddress,
+                    Cache->ControlBuffer,
+                    sizeof(Cache->ControlBuffer));
+            SendCache->IsPrepared = TRUE;
+        }
+        RemoteSockAddr = &Cache->MappedRemoteAddress;
+    } else {
+        QuicConvertToMappedV6(RemoteAddress, &MappedRemoteAddress);
+        RemoteSockAddr = &MappedRemoteAddress;
+    }
 
     WSAMSG WSAMhdr;
     WSAMhdr.dwFlags = 0;
-    WSAMhdr.name = (LPSOCKADDR)&MappedRemoteAddress;
-    WSAMhdr.namelen = sizeof(MappedRemoteAddress);
+    WSAMhdr.name = (LPSOCKADDR)RemoteSockAddr;
+    WSAMhdr.namelen = sizeof(*RemoteSockAddr);
     WSAMhdr.lpBuffers = SendContext->WsaBuffers;
     WSAMhdr.dwBufferCount = SendContext->WsaBufferCount;
 
-    PWSACMSGHDR CMsg;
     BYTE CtrlBuf[WSA_CMSG_SPACE(sizeof(IN6_PKTINFO)) + WSA_CMSG_SPACE(sizeof(*SegmentSize))];
     WSAMhdr.Control.buf = (PCHAR)CtrlBuf;
 
-    if (LocalAddress->si_family == AF_INET) {
-        WSAMhdr.Control.len = WSA_CMSG_SPACE(sizeof(IN_PKTINFO));
-
-        CMsg = WSA_CMSG_FIRSTHDR(&WSAMhdr);
-        CMsg->cmsg_level = IPPROTO_IP;
-        CMsg->cmsg_type = IP_PKTINFO;
-        CMsg->cmsg_len = WSA_CMSG_LEN(sizeof(IN_PKTINFO));
-
-        PIN_PKTINFO PktInfo = (PIN_PKTINFO)WSA_CMSG_DATA(CMsg);
-        PktInfo->ipi_ifindex = LocalAddress->Ipv6.sin6_scope_id;
-        PktInfo->ipi_addr = LocalAddress->Ipv4.sin_addr;
-
+    if (Cache != NULL) {
+        RtlCopyMemory(CtrlBuf, Cache->ControlBuffer, Cache->ControlLength);
+        WSAMhdr.Control.len = Cache->ControlLength;
     } else {
-        WSAMhdr.Control.len = WSA_CMSG_SPACE(sizeof(IN6_PKTINFO));
-
-        CMsg = WSA_CMSG_FIRSTHDR(&WSAMhdr);
-        CMsg->cmsg_level = IPPROTO_IPV6;
-        CMsg->cmsg_type = IPV6_PKTINFO;
-        CMsg->cmsg_len = WSA_CMSG_LEN(sizeof(IN6_PKTINFO));
-
-        PIN6_PKTINFO PktInfo6 = (PIN6_PKTINFO)WSA_CMSG_DATA(CMsg);
-        PktInfo6->ipi6_ifindex = LocalAddress->Ipv6.sin6_scope_id;
-        PktInfo6->ipi6_addr = LocalAddress->Ipv6.sin6_addr;
+        WSAMhdr.Control.len =
+            QuicDataPathFormatPktInfo(
+                LocalAddress,
+                (PCHAR)CtrlBuf,
+                sizeof(CtrlBuf));
     }
 
 #ifdef UDP_SEND_MSG_SIZE
     if (SendContext->SegmentSize > 0) {
         WSAMhdr.Control.len += WSA_CMSG_SPACE(sizeof(*SegmentSize));
 
-        CMsg = WSA_CMSG_NXTHDR(&WSAMhdr, CMsg);
+        PWSACMSGHDR CMsg =
+            WSA_CMSG_NXTHDR(&WSAMhdr, WSA_CMSG_FIRSTHDR(&WSAMhdr));
         QUIC_DBG_ASSERT(CMsg != NULL);
         CMsg->cmsg_level = IPPROTO_UDP;
         CMsg->cmsg_type = UDP_SEND_MSG_SIZE;
@@ -2701,23 +3620,38 @@ QuicDataPathWorkerThread(
         }
 
         QUIC_DBG_ASSERT(Overlapped != NULL);
-        QUIC_DBG_ASSERT(SocketContext != NULL);
+
+        if (SocketContext == NULL) {
+            //
+            // Wake completion for a RIO slab whose request queue ran dry
+            // while the client held all the receive slots.
+            //
+            QuicDataPathRioWakeComplete(
+                CONTAINING_RECORD(Overlapped, QUIC_RIO_SLAB, WakeOverlapped));
+            continue;
+        }
 
         IoResult = Result ? NO_ERROR : GetLastError();
 
         //
-        // Overlapped either points to the send or receive OVERLAPPED for this
+        // Overlapped either points to the shutdown, one of the posted
+        // receives, the RIO notification or a send OVERLAPPED for this
         // socket.
         //
-        if (Overlapped == &SocketContext->RecvOverlapped) {
+        if (Overlapped == &SocketContext->ShutdownOverlapped) {
 
-            if (NumberOfBytesTransferred == UINT32_MAX) {
-                //
-                // The socket context is being shutdown. Run the clean up logic.
-                //
-                QuicDataPathSocketContextShutdown(SocketContext);
+            //
+            // The socket context is being shutdown. Run the clean up logic.
+            //
+            QUIC_DBG_ASSERT(NumberOfBytesTransferred == UINT32_MAX);
+            QuicDataPathSocketContextShutdown(SocketContext);
+
+        } else if (
+            Overlapped >= &SocketContext->PendedRecvs[0].Overlapped &&
+            Overlapped <=
+                &SocketContext->PendedRecvs[QUIC_RECV_IO_DEPTH - 1].Overlapped) {
 
-            } else if (QuicRundownAcquire(&SocketContext->UpcallRundown)) {
+            if (QuicRundownAcquire(&SocketContext->UpcallRundown)) {
                 //
                 // We only allow for receiving UINT16 worth of bytes at a time,
                 // which should be plenty for an IPv4 or IPv6 UDP datagram.
@@ -2729,17 +3663,30 @@ QuicDataPathWorkerThread(
                 }
 
                 //
-                // Handle the receive indication and queue a new receive.
+                // Handle the receive indication and repost the receive.
                 //
                 QuicDataPathRecvComplete(
                     ProcContext,
                     SocketContext,
+                    CONTAINING_RECORD(
+                        Overlapped, QUIC_DATAPATH_PENDED_RECV, Overlapped),
                     IoResult,
                     (UINT16)NumberOfBytesTransferred);
 
                 QuicRundownRelease(&SocketContext->UpcallRundown);
             }
 
+        } else if (Overlapped == &SocketContext->RioNotifyOverlapped) {
+
+            if (QuicRundownAcquire(&SocketContext->UpcallRundown)) {
+                //
+                // Drain the RIO completion ring, repost the free slots and
+                // re-arm the notification.
+                //
+                QuicDataPathRioRecvComplete(ProcContext, SocketContext);
+                QuicRundownRelease(&SocketContext->UpcallRundown);
+            }
+
         } else {
 
             QUIC_DATAPATH_SEND_CONTEXT* SendContext =
@@ -0,0 +1,537 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    This file contains code for the open-addressing hash table variant. See
+    quic_flat_hashtable.h for the API contract.
+
+Notes:
+
+    The table is an array of 8-way buckets. Each bucket owns eight entry
+    slots, and a one-byte tag per slot records whether the slot is empty, a
+    tombstone left by a removal, or occupied; an occupied slot's tag holds
+    seven bits derived from the entry's signature. The eight tags of a
+    bucket are packed into a single uint64_t, so a probe can compare a
+    candidate tag against all eight slots with one XOR and a zero-byte scan,
+    and only consults the (much larger) signature and entry arrays for the
+    slots whose tag matched. Wider vectorized probes were considered, but
+    this code also runs in kernel mode where vector instructions are off
+    limits, and the word-at-a-time scan needs nothing beyond plain C.
+
+    Collisions are resolved by probing buckets linearly from the bucket the
+    signature hashes to. A probe sequence ends at the first bucket that
+    contains an empty slot, so removals may not always free a slot outright:
+    if the removed entry's bucket is full, the slot becomes a tombstone that
+    keeps later probe sequences intact. Insertions reuse the first tombstone
+    encountered, and a resize (which rehashes into a fresh allocation) clears
+    all tombstones.
+
+    The table is grown before the combined count of entries and tombstones
+    can exceed 7/8ths of the slots, which bounds probe lengths and
+    guarantees every probe sequence terminates at an empty slot.
+
+    Because callers are free to use structured values (stream IDs, port
+    numbers) as signatures, the signature is run through a 64-bit finalizing
+    mixer and the bucket index and tag are taken from opposite ends of the
+    mixed value. The caller's original signature is what is stored and
+    compared for candidate slots.
+
+--*/
+
+#include "platform_internal.h"
+
+//
+// Slot tag values. Occupied slots always have the top tag bit set, so these
+// two reserved values can never collide with a real tag.
+//
+#define FLAT_HASH_TAG_EMPTY     0x00
+#define FLAT_HASH_TAG_TOMBSTONE 0x01
+
+//
+// Broadcast masks for the word-at-a-time tag scans.
+//
+#define FLAT_HASH_LOW_BYTES  0x0101010101010101ULL
+#define FLAT_HASH_HIGH_BITS  0x8080808080808080ULL
+
+QUIC_STATIC_ASSERT(
+    (QUIC_HASH_MIN_SIZE % QUIC_FLAT_HASH_BUCKET_SLOTS) == 0,
+    "Minimum table size must be a whole number of buckets!");
+
+//
+// Mixes all bits of the caller's signature into the bits the table actually
+// consumes (the low-order bucket index and the high-order tag). This is the
+// standard 64-bit finalizing mixer, so sequential signatures spread across
+// the table instead of marching through neighboring buckets.
+//
+static
+uint64_t
+QuicFlatHashMixSignature(
+    _In_ uint64_t Signature
+    )
+{
+    Signature ^= Signature >> 33;
+    Signature *= 0xff51afd7ed558ccdULL;
+    Signature ^= Signature >> 33;
+    Signature *= 0xc4ceb9fe1a85ec53ULL;
+    Signature ^= Signature >> 33;
+    return Signature;
+}
+
+//
+// Returns a word with the high bit set in every byte of TagWord that equals
+// Tag, and zero bits everywhere else. The zero-byte scan is exact: a byte of
+// (TagWord ^ broadcast(Tag)) is zero if and only if the tags are equal.
+//
+static
+uint64_t
+QuicFlatHashMatchTag(
+    _In_ uint64_t TagWord,
+    _In_ uint8_t Tag
+    )
+{
+    uint64_t Diff = TagWord ^ ((uint64_t)Tag * FLAT_HASH_LOW_BYTES);
+    return (Diff - FLAT_HASH_LOW_BYTES) & ~Diff & FLAT_HASH_HIGH_BITS;
+}
+
+//
+// Returns the slot index of the lowest set match bit in a (nonzero) result
+// of QuicFlatHashMatchTag.
+//
+static
+uint32_t
+QuicFlatHashLowestSlot(
+    _In_ uint64_t Hits
+    )
+{
+    uint32_t Slot = 0;
+    QUIC_DBG_ASSERT(Hits != 0);
+    while ((Hits & 0x80) == 0) {
+        Hits >>= 8;
+        Slot++;
+    }
+    return Slot;
+}
+
+static
+uint8_t
+QuicFlatHashGetTag(
+    _In_ const QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint32_t Bucket,
+    _In_ uint32_t Slot
+    )
+{
+    return (uint8_t)(HashTable->Tags[Bucket] >> (Slot * 8));
+}
+
+static
+void
+QuicFlatHashSetTag(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint32_t Bucket,
+    _In_ uint32_t Slot,
+    _In_ uint8_t Tag
+    )
+{
+    HashTable->Tags[Bucket] =
+        (HashTable->Tags[Bucket] & ~(0xFFULL << (Slot * 8))) |
+        ((uint64_t)Tag << (Slot * 8));
+}
+
+//
+// The table is resized once entries plus tombstones would exceed this many
+// of the slots, so at least one eighth of the slots are always empty.
+//
+static
+uint32_t
+QuicFlatHashMaxLoad(
+    _In_ uint32_t BucketCount
+    )
+{
+    return BucketCount * QUIC_FLAT_HASH_BUCKET_SLOTS -
+           BucketCount * QUIC_FLAT_HASH_BUCKET_SLOTS / 8;
+}
+
+//
+// Allocates the tag, signature and entry arrays for BucketCount buckets as a
+// single block anchored at Tags, and points the table at them. Only the tags
+// need zeroing; the signature and entry slots are meaningless until their
+// tag says otherwise.
+//
+_Must_inspect_result_
+_Success_(return != FALSE)
+static
+BOOLEAN
+QuicFlatHashtableAllocateArrays(
+    _Inout_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint32_t BucketCount
+    )
+{
+    uint32_t SlotCount = BucketCount * QUIC_FLAT_HASH_BUCKET_SLOTS;
+    size_t TagsSize = BucketCount * sizeof(uint64_t);
+    size_t SignaturesSize = SlotCount * sizeof(uint64_t);
+
+    uint8_t* Block =
+        QUIC_ALLOC_NONPAGED(
+            TagsSize + SignaturesSize + SlotCount * sizeof(void*));
+    if (Block == NULL) {
+        return FALSE;
+    }
+
+    HashTable->BucketCount = BucketCount;
+    HashTable->Tags = (uint64_t*)Block;
+    HashTable->Signatures = (uint64_t*)(Block + TagsSize);
+    HashTable->Entries = (void**)(Block + TagsSize + SignaturesSize);
+    QuicZeroMemory(HashTable->Tags, TagsSize);
+
+    return TRUE;
+}
+
+//
+// Finds the slot a new entry should occupy: the first tombstone encountered
+// along the probe sequence, or failing that, the first empty slot in the
+// bucket that terminates the sequence. Reusing a tombstone is safe because
+// lookups probe straight past tombstones and only stop at empty slots.
+//
+static
+void
+QuicFlatHashtableFindInsertionSlot(
+    _In_ const QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint64_t MixedSignature,
+    _Out_ uint32_t* InsertBucket,
+    _Out_ uint32_t* InsertSlot
+    )
+{
+    uint32_t Bucket = (uint32_t)MixedSignature & (HashTable->BucketCount - 1);
+    BOOLEAN Found = FALSE;
+
+    for (;;) {
+        uint64_t TagWord = HashTable->Tags[Bucket];
+
+        if (!Found) {
+            uint64_t Tombstones =
+                QuicFlatHashMatchTag(TagWord, FLAT_HASH_TAG_TOMBSTONE);
+            if (Tombstones != 0) {
+                *InsertBucket = Bucket;
+                *InsertSlot = QuicFlatHashLowestSlot(Tombstones);
+                Found = TRUE;
+            }
+        }
+
+        uint64_t Empties = QuicFlatHashMatchTag(TagWord, FLAT_HASH_TAG_EMPTY);
+        if (Empties != 0) {
+            if (!Found) {
+                *InsertBucket = Bucket;
+                *InsertSlot = QuicFlatHashLowestSlot(Empties);
+            }
+            return;
+        }
+
+        Bucket = (Bucket + 1) & (HashTable->BucketCount - 1);
+    }
+}
+
+//
+// Rehashes every entry into a fresh set of arrays with NewBucketCount
+// buckets, dropping all tombstones in the process.
+//
+_Must_inspect_result_
+_Success_(return != FALSE)
+static
+BOOLEAN
+QuicFlatHashtableRehash(
+    _Inout_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint32_t NewBucketCount
+    )
+{
+    QUIC_FLAT_HASHTABLE NewTable = *HashTable;
+    if (!QuicFlatHashtableAllocateArrays(&NewTable, NewBucketCount)) {
+        return FALSE;
+    }
+
+    for (uint32_t Index = 0;
+         Index < HashTable->BucketCount * QUIC_FLAT_HASH_BUCKET_SLOTS;
+         Index++) {
+
+        uint32_t Bucket = Index / QUIC_FLAT_HASH_BUCKET_SLOTS;
+        uint32_t Slot = Index % QUIC_FLAT_HASH_BUCKET_SLOTS;
+        if ((QuicFlatHashGetTag(HashTable, Bucket, Slot) & 0x80) == 0) {
+            continue; // Empty or tombstone.
+        }
+
+        uint64_t MixedSignature =
+            QuicFlatHashMixSignature(HashTable->Signatures[Index]);
+        uint32_t NewBucket, NewSlot;
+        QuicFlatHashtableFindInsertionSlot(
+            &NewTable, MixedSignature, &NewBucket, &NewSlot);
+        QuicFlatHashSetTag(
+            &NewTable, NewBucket, NewSlot,
+            (uint8_t)(MixedSignature >> 56) | 0x80);
+
+        uint32_t NewIndex = NewBucket * QUIC_FLAT_HASH_BUCKET_SLOTS + NewSlot;
+        NewTable.Signatures[NewIndex] = HashTable->Signatures[Index];
+        NewTable.Entries[NewIndex] = HashTable->Entries[Index];
+    }
+
+    QUIC_FREE(HashTable->Tags);
+    HashTable->BucketCount = NewTable.BucketCount;
+    HashTable->Tags = NewTable.Tags;
+    HashTable->Signatures = NewTable.Signatures;
+    HashTable->Entries = NewTable.Entries;
+    HashTable->NumTombstones = 0;
+
+    return TRUE;
+}
+
+_Must_inspect_result_
+_Success_(return != FALSE)
+BOOLEAN
+QuicFlatHashtableInitialize(
+    _Inout_ _When_(NULL == *HashTable, _At_(*HashTable, __drv_allocatesMem(Mem) _Post_notnull_))
+        QUIC_FLAT_HASHTABLE** HashTable,
+    _In_ uint32_t InitialSize
+    )
+{
+    QUIC_FLAT_HASHTABLE* Table = *HashTable;
+    uint32_t LocalFlags = 0;
+
+    QUIC_DBG_ASSERT(InitialSize >= QUIC_FLAT_HASH_BUCKET_SLOTS);
+    QUIC_DBG_ASSERT((InitialSize & (InitialSize - 1)) == 0);
+
+    if (Table == NULL) {
+        Table = QUIC_ALLOC_NONPAGED(sizeof(QUIC_FLAT_HASHTABLE));
+        if (Table == NULL) {
+            return FALSE;
+        }
+        LocalFlags = QUIC_FLAT_HASH_ALLOCATED_HEADER;
+    }
+
+    QuicZeroMemory(Table, sizeof(QUIC_FLAT_HASHTABLE));
+    Table->Flags = LocalFlags;
+
+    if (!QuicFlatHashtableAllocateArrays(
+            Table, InitialSize / QUIC_FLAT_HASH_BUCKET_SLOTS)) {
+        if (LocalFlags & QUIC_FLAT_HASH_ALLOCATED_HEADER) {
+            QUIC_FREE(Table);
+        }
+        return FALSE;
+    }
+
+    *HashTable = Table;
+    return TRUE;
+}
+
+void
+QuicFlatHashtableUninitialize(
+    _In_
+    _When_((HashTable->Flags & QUIC_FLAT_HASH_ALLOCATED_HEADER), __drv_freesMem(Mem) _Post_invalid_)
+    _At_(HashTable->Tags, __drv_freesMem(Mem) _Post_invalid_)
+        QUIC_FLAT_HASHTABLE* HashTable
+    )
+{
+    QUIC_DBG_ASSERT(HashTable->NumEntries == 0);
+
+    QUIC_FREE(HashTable->Tags);
+
+    if (HashTable->Flags & QUIC_FLAT_HASH_ALLOCATED_HEADER) {
+        QUIC_FREE(HashTable);
+    }
+}
+
+_Must_inspect_result_
+_Success_(return != FALSE)
+BOOLEAN
+QuicFlatHashtableInsert(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ __drv_aliasesMem void* Entry,
+    _In_ uint64_t Signature
+    )
+{
+    QUIC_DBG_ASSERT(Entry != NULL);
+
+    if (HashTable->NumEntries + HashTable->NumTombstones + 1 >
+        QuicFlatHashMaxLoad(HashTable->BucketCount)) {
+        //
+        // Double the table if it is genuinely filling up; rehash at the same
+        // size if tombstones are what crowded it out.
+        //
+        uint32_t NewBucketCount =
+            HashTable->NumEntries >=
+                HashTable->BucketCount * QUIC_FLAT_HASH_BUCKET_SLOTS / 2 ?
+                HashTable->BucketCount * 2 : HashTable->BucketCount;
+        if (!QuicFlatHashtableRehash(HashTable, NewBucketCount)) {
+            return FALSE;
+        }
+    }
+
+    uint64_t MixedSignature = QuicFlatHashMixSignature(Signature);
+    uint32_t Bucket, Slot;
+    QuicFlatHashtableFindInsertionSlot(
+        HashTable, MixedSignature, &Bucket, &Slot);
+
+    if (QuicFlatHashGetTag(HashTable, Bucket, Slot) == FLAT_HASH_TAG_TOMBSTONE) {
+        HashTable->NumTombstones--;
+    }
+    QuicFlatHashSetTag(
+        HashTable, Bucket, Slot, (uint8_t)(MixedSignature >> 56) | 0x80);
+
+    uint32_t Index = Bucket * QUIC_FLAT_HASH_BUCKET_SLOTS + Slot;
+    HashTable->Signatures[Index] = Signature;
+    HashTable->Entries[Index] = Entry;
+    HashTable->NumEntries++;
+
+    return TRUE;
+}
+
+void
+QuicFlatHashtableRemove(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ void* Entry,
+    _In_ uint64_t Signature
+    )
+{
+    QUIC_DBG_ASSERT(HashTable->NumEntries > 0);
+
+    uint64_t MixedSignature = QuicFlatHashMixSignature(Signature);
+    uint8_t Tag = (uint8_t)(MixedSignature >> 56) | 0x80;
+    uint32_t Bucket = (uint32_t)MixedSignature & (HashTable->BucketCount - 1);
+
+    for (;;) {
+        uint64_t TagWord = HashTable->Tags[Bucket];
+        uint64_t Hits = QuicFlatHashMatchTag(TagWord, Tag);
+
+        while (Hits != 0) {
+            uint32_t Slot = QuicFlatHashLowestSlot(Hits);
+            Hits &= Hits - 1;
+
+            uint32_t Index = Bucket * QUIC_FLAT_HASH_BUCKET_SLOTS + Slot;
+            if (HashTable->Entries[Index] != Entry) {
+                continue;
+            }
+            QUIC_DBG_ASSERT(HashTable->Signatures[Index] == Signature);
+
+            //
+            // If the bucket still has an empty slot then probe sequences
+            // already end here, and the slot can be freed outright;
+            // otherwise it must become a tombstone so that entries pushed
+            // into later buckets remain reachable.
+            //
+            if (QuicFlatHashMatchTag(TagWord, FLAT_HASH_TAG_EMPTY) != 0) {
+                QuicFlatHashSetTag(
+                    HashTable, Bucket, Slot, FLAT_HASH_TAG_EMPTY);
+            } else {
+                QuicFlatHashSetTag(
+                    HashTable, Bucket, Slot, FLAT_HASH_TAG_TOMBSTONE);
+                HashTable->NumTombstones++;
+            }
+            HashTable->Entries[Index] = NULL;
+            HashTable->Signatures[Index] = 0;
+            HashTable->NumEntries--;
+            return;
+        }
+
+        //
+        // The entry must be present; reaching the end of its probe sequence
+        // means the caller's entry/signature pair was never inserted.
+        //
+        QUIC_DBG_ASSERT(
+            QuicFlatHashMatchTag(TagWord, FLAT_HASH_TAG_EMPTY) == 0);
+
+        Bucket = (Bucket + 1) & (HashTable->BucketCount - 1);
+    }
+}
+
+_Must_inspect_result_
+void*
+QuicFlatHashtableLookup(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint64_t Signature,
+    _Out_ QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT* Context
+    )
+{
+    uint64_t MixedSignature = QuicFlatHashMixSignature(Signature);
+
+    Context->Signature = Signature;
+    Context->Tag = (uint8_t)(MixedSignature >> 56) | 0x80;
+    Context->Bucket = (uint32_t)MixedSignature & (HashTable->BucketCount - 1);
+    Context->Hits =
+        QuicFlatHashMatchTag(HashTable->Tags[Context->Bucket], Context->Tag);
+
+    return QuicFlatHashtableLookupNext(HashTable, Context);
+}
+
+_Must_inspect_result_
+void*
+QuicFlatHashtableLookupNext(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Inout_ QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT* Context
+    )
+{
+    for (;;) {
+        while (Context->Hits != 0) {
+            uint32_t Slot = QuicFlatHashLowestSlot(Context->Hits);
+            Context->Hits &= Context->Hits - 1;
+
+            uint32_t Index =
+                Context->Bucket * QUIC_FLAT_HASH_BUCKET_SLOTS + Slot;
+            if (HashTable->Signatures[Index] == Context->Signature) {
+                return HashTable->Entries[Index];
+            }
+        }
+
+        if (QuicFlatHashMatchTag(
+                HashTable->Tags[Context->Bucket], FLAT_HASH_TAG_EMPTY) != 0) {
+            return NULL; // The probe sequence ends at an empty slot.
+        }
+
+        Context->Bucket =
+            (Context->Bucket + 1) & (HashTable->BucketCount - 1);
+        Context->Hits =
+            QuicFlatHashMatchTag(
+                HashTable->Tags[Context->Bucket], Context->Tag);
+    }
+}
+
+void
+QuicFlatHashtableEnumerateBegin(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Out_ QUIC_FLAT_HASHTABLE_ENUMERATOR* Enumerator
+    )
+{
+    UNREFERENCED_PARAMETER(HashTable);
+    Enumerator->Index = 0;
+}
+
+_Must_inspect_result_
+void*
+QuicFlatHashtableEnumerateNext(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Inout_ QUIC_FLAT_HASHTABLE_ENUMERATOR* Enumerator
+    )
+{
+    uint32_t SlotCount = HashTable->BucketCount * QUIC_FLAT_HASH_BUCKET_SLOTS;
+
+    while (Enumerator->Index < SlotCount) {
+        uint32_t Index = Enumerator->Index++;
+        if (QuicFlatHashGetTag(
+                HashTable,
+                Index / QUIC_FLAT_HASH_BUCKET_SLOTS,
+                Index % QUIC_FLAT_HASH_BUCKET_SLOTS) & 0x80) {
+            return HashTable->Entries[Index];
+        }
+    }
+
+    return NULL;
+}
+
+void
+QuicFlatHashtableEnumerateEnd(
+    _In_ QUIC_FLAT_HASHTABLE* HashTable,
+    _Inout_ QUIC_FLAT_HASHTABLE_ENUMERATOR* Enumerator
+    )
+{
+    UNREFERENCED_PARAMETER(HashTable);
+    UNREFERENCED_PARAMETER(Enumerator);
+}
@@ -88,6 +88,19 @@ InterlockedDecrement(
     _Inout_ _Interlocked_operand_ long volatile *Addend
     );
 
+long
+InterlockedExchange(
+    _Inout_ _Interlocked_operand_ long volatile *Target,
+    _In_ long Value
+    );
+
+long
+InterlockedCompareExchange(
+    _Inout_ _Interlocked_operand_ long volatile *Destination,
+    _In_ long ExChange,
+    _In_ long Comperand
+    );
+
 int64_t
 InterlockedExchangeAdd64(
     _Inout_ _Interlocked_operand_ int64_t volatile *Addend,
@@ -116,6 +129,19 @@ InterlockedIncrement64(
     _Inout_ _Interlocked_operand_ int64_t volatile *Addend
     );
 
+void*
+InterlockedExchangePointer(
+    _Inout_ _Interlocked_operand_ void* volatile *Target,
+    _In_opt_ void* Value
+    );
+
+void*
+InterlockedCompareExchangePointer(
+    _Inout_ _Interlocked_operand_ void* volatile *Destination,
+    _In_opt_ void* ExChange,
+    _In_opt_ void* Comperand
+    );
+
 _Must_inspect_result_
 _Success_(return != 0)
 BOOLEAN
@@ -130,6 +156,14 @@ QuicHashSimple(
     _In_reads_(Length) const uint8_t* Buffer
     );
 
+_Must_inspect_result_
+_Success_(return != 0)
+BOOLEAN
+QuicFlatHashtableInitializeEx(
+    _Inout_ QUIC_FLAT_HASHTABLE* HashTable,
+    _In_ uint32_t InitialSize
+    );
+
 uint16_t
 QuicHashLength(
     QUIC_HASH_TYPE Type
@@ -23,9 +23,21 @@ Environment:
 #include <fcntl.h>
 #include <syslog.h>
 #include <arpa/inet.h>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
 #include "quic_trace.h"
 #include "quic_platform_dispatch.h"
 
+#if defined(__x86_64__)
+static
+void
+QuicTscClockInitialize(
+    void
+    );
+#endif
+
 #define QUIC_MAX_LOG_MSG_LEN        1024 // Bytes
 
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
@@ -35,6 +47,10 @@ int RandomFd; // Used for reading random numbers.
 #endif
 
 uint64_t QuicTotalMemory;
+int64_t QuicTotalAllocCount;
+
+BOOLEAN QuicAllocSiteTrackingEnabled = FALSE;
+QUIC_ALLOC_SITE QuicAllocSiteTable[QUIC_ALLOC_SITE_TABLE_SIZE];
 
 __attribute__((noinline))
 void
@@ -87,6 +103,10 @@ QuicPlatformInitialize(
 
     QuicTotalMemory = 0x40000000; // TODO - Hard coded at 1 GB. Query real value.
 
+#if defined(__x86_64__)
+    QuicTscClockInitialize();
+#endif
+
     return QUIC_STATUS_SUCCESS;
 }
 
@@ -100,11 +120,78 @@ QuicPlatformUninitialize(
 #endif
 }
 
+static
+void
+QuicAllocSiteTrackingRecord(
+    _In_ void* Caller
+    )
+{
+    //
+    // Open-addressed table keyed by the caller's return address. Slots are
+    // claimed with a compare-exchange and never released, so counts stay
+    // attached to their site until tracking is re-enabled (which resets the
+    // table). If the table fills up the allocation still counts toward
+    // QuicTotalAllocCount; only its attribution is lost.
+    //
+    uint32_t Index =
+        (uint32_t)(((uintptr_t)Caller >> 4) * 2654435761u) %
+            QUIC_ALLOC_SITE_TABLE_SIZE;
+    for (uint32_t Probes = 0; Probes < QUIC_ALLOC_SITE_TABLE_SIZE; Probes++) {
+        QUIC_ALLOC_SITE* Site = &QuicAllocSiteTable[Index];
+        void* Existing = Site->Caller;
+        if (Existing == NULL) {
+            Existing =
+                InterlockedCompareExchangePointer(
+                    (void* volatile *)&Site->Caller, Caller, NULL);
+            if (Existing == NULL) {
+                Existing = Caller; // Claimed the slot.
+            }
+        }
+        if (Existing == Caller) {
+            InterlockedIncrement64(&Site->Count);
+            return;
+        }
+        Index = (Index + 1) % QUIC_ALLOC_SITE_TABLE_SIZE;
+    }
+}
+
+void
+QuicAllocSiteTrackingEnable(
+    _In_ BOOLEAN Enable
+    )
+{
+    if (Enable) {
+        QuicZeroMemory(QuicAllocSiteTable, sizeof(QuicAllocSiteTable));
+    }
+    QuicAllocSiteTrackingEnabled = Enable;
+}
+
+uint32_t
+QuicAllocSiteTrackingSnapshot(
+    _Out_writes_to_(SitesCount, return) QUIC_ALLOC_SITE* Sites,
+    _In_ uint32_t SitesCount
+    )
+{
+    uint32_t Count = 0;
+    for (uint32_t i = 0;
+         i < QUIC_ALLOC_SITE_TABLE_SIZE && Count < SitesCount;
+         i++) {
+        if (QuicAllocSiteTable[i].Caller != NULL) {
+            Sites[Count++] = QuicAllocSiteTable[i];
+        }
+    }
+    return Count;
+}
+
 void*
 QuicAlloc(
     _In_ size_t ByteCount
     )
 {
+    InterlockedIncrement64(&QuicTotalAllocCount);
+    if (QuicAllocSiteTrackingEnabled) {
+        QuicAllocSiteTrackingRecord(__builtin_return_address(0));
+    }
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     return PlatDispatch->Alloc(ByteCount);
 #else
@@ -136,6 +223,15 @@ QuicPoolInitialize(
 #else
     UNREFERENCED_PARAMETER(IsPaged);
     Pool->Size = Size;
+    Pool->ListHead.Next = NULL;
+    Pool->ListDepth = 0;
+    QUIC_FRE_ASSERT(pthread_mutex_init(&Pool->Lock, NULL) == 0);
+    Pool->Magazines =
+        QUIC_ALLOC_NONPAGED(QuicProcMaxCount() * sizeof(QUIC_POOL_MAGAZINE));
+    if (Pool->Magazines != NULL) {
+        QuicZeroMemory(
+            Pool->Magazines, QuicProcMaxCount() * sizeof(QUIC_POOL_MAGAZINE));
+    }
 #endif
 }
 
@@ -147,10 +243,58 @@ QuicPoolUninitialize(
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     PlatDispatch->PoolUninitialize(Pool);
 #else
-    UNREFERENCED_PARAMETER(Pool);
+    if (Pool->Magazines != NULL) {
+        for (uint32_t Proc = 0; Proc < QuicProcMaxCount(); Proc++) {
+            QUIC_POOL_MAGAZINE* Magazine = &Pool->Magazines[Proc];
+            while (Magazine->Count != 0) {
+                QuicFree(Magazine->Entries[--Magazine->Count]);
+            }
+        }
+        QUIC_FREE(Pool->Magazines);
+        Pool->Magazines = NULL;
+    }
+    while (Pool->ListHead.Next != NULL) {
+        QUIC_SINGLE_LIST_ENTRY* Entry = QuicListPopEntry(&Pool->ListHead);
+        QuicFree(Entry);
+    }
+    QUIC_FRE_ASSERT(pthread_mutex_destroy(&Pool->Lock) == 0);
 #endif
 }
 
+#ifndef QUIC_PLATFORM_DISPATCH_TABLE
+
+//
+// Tries to claim the magazine of the current processor. Returns NULL if it is
+// already claimed by another thread (or by this thread on a different
+// processor), in which case the caller falls through to the shared depot.
+//
+static
+QUIC_POOL_MAGAZINE*
+QuicPoolMagazineAcquire(
+    _In_ QUIC_POOL* Pool
+    )
+{
+    if (Pool->Magazines == NULL) {
+        return NULL;
+    }
+    QUIC_POOL_MAGAZINE* Magazine = &Pool->Magazines[QuicProcCurrentNumber()];
+    if (__sync_lock_test_and_set(&Magazine->Owned, 1) != 0) {
+        return NULL;
+    }
+    return Magazine;
+}
+
+static
+void
+QuicPoolMagazineRelease(
+    _In_ QUIC_POOL_MAGAZINE* Magazine
+    )
+{
+    __sync_lock_release(&Magazine->Owned);
+}
+
+#endif // QUIC_PLATFORM_DISPATCH_TABLE
+
 void*
 QuicPoolAlloc(
     _Inout_ QUIC_POOL* Pool
@@ -159,7 +303,40 @@ QuicPoolAlloc(
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     return PlatDispatch->PoolAlloc(Pool);
 #else
-    void*Entry = QuicAlloc(Pool->Size);
+    void* Entry = NULL;
+
+    QUIC_POOL_MAGAZINE* Magazine = QuicPoolMagazineAcquire(Pool);
+    if (Magazine != NULL) {
+        if (Magazine->Count == 0) {
+            //
+            // Refill the magazine (half full, so back to back alloc/free
+            // patterns don't thrash the depot lock) while we still own it.
+            //
+            pthread_mutex_lock(&Pool->Lock);
+            while (Magazine->Count < QUIC_POOL_MAGAZINE_CAPACITY / 2 &&
+                   Pool->ListHead.Next != NULL) {
+                Magazine->Entries[Magazine->Count++] =
+                    QuicListPopEntry(&Pool->ListHead);
+                Pool->ListDepth--;
+            }
+            pthread_mutex_unlock(&Pool->Lock);
+        }
+        if (Magazine->Count != 0) {
+            Entry = Magazine->Entries[--Magazine->Count];
+        }
+        QuicPoolMagazineRelease(Magazine);
+    } else {
+        pthread_mutex_lock(&Pool->Lock);
+        if (Pool->ListHead.Next != NULL) {
+            Entry = QuicListPopEntry(&Pool->ListHead);
+            Pool->ListDepth--;
+        }
+        pthread_mutex_unlock(&Pool->Lock);
+    }
+
+    if (Entry == NULL) {
+        Entry = QuicAlloc(Pool->Size);
+    }
 
     if (Entry != NULL) {
         QuicZeroMemory(Entry, Pool->Size);
@@ -178,8 +355,63 @@ QuicPoolFree(
 #ifdef QUIC_PLATFORM_DISPATCH_TABLE
     PlatDispatch->PoolFree(Pool, Entry);
 #else
+    QUIC_POOL_MAGAZINE* Magazine = QuicPoolMagazineAcquire(Pool);
+    if (Magazine != NULL) {
+        if (Magazine->Count == QUIC_POOL_MAGAZINE_CAPACITY) {
+            //
+            // Flush half the magazine to the depot while we still own it.
+            //
+            pthread_mutex_lock(&Pool->Lock);
+            while (Magazine->Count > QUIC_POOL_MAGAZINE_CAPACITY / 2 &&
+                   Pool->ListDepth < QUIC_POOL_MAXIMUM_DEPTH) {
+                QuicListPushEntry(
+                    &Pool->ListHead,
+                    (QUIC_SINGLE_LIST_ENTRY*)Magazine->Entries[--Magazine->Count]);
+                Pool->ListDepth++;
+            }
+            pthread_mutex_unlock(&Pool->Lock);
+        }
+        if (Magazine->Count < QUIC_POOL_MAGAZINE_CAPACITY) {
+            Magazine->Entries[Magazine->Count++] = Entry;
+            Entry = NULL;
+        }
+        QuicPoolMagazineRelease(Magazine);
+    } else {
+        pthread_mutex_lock(&Pool->Lock);
+        if (Pool->ListDepth < QUIC_POOL_MAXIMUM_DEPTH) {
+            QuicListPushEntry(
+                &Pool->ListHead, (QUIC_SINGLE_LIST_ENTRY*)Entry);
+            Pool->ListDepth++;
+            Entry = NULL;
+        }
+        pthread_mutex_unlock(&Pool->Lock);
+    }
+
+    if (Entry != NULL) {
+        QuicFree(Entry);
+    }
+#endif
+}
+
+void
+QuicPoolTrim(
+    _Inout_ QUIC_POOL* Pool
+    )
+{
+#ifdef QUIC_PLATFORM_DISPATCH_TABLE
     UNREFERENCED_PARAMETER(Pool);
-    QuicFree(Entry);
+#else
+    pthread_mutex_lock(&Pool->Lock);
+    QUIC_SINGLE_LIST_ENTRY* Entries = Pool->ListHead.Next;
+    Pool->ListHead.Next = NULL;
+    Pool->ListDepth = 0;
+    pthread_mutex_unlock(&Pool->Lock);
+
+    while (Entries != NULL) {
+        QUIC_SINGLE_LIST_ENTRY* Entry = Entries;
+        Entries = Entries->Next;
+        QuicFree(Entry);
+    }
 #endif
 }
 
@@ -477,8 +709,9 @@ QuicGetTimerResolution(
     return QuicTimespecToUs(&Res);
 }
 
+static
 uint64_t
-QuicTimeUs64(
+QuicClockUs64(
     void
     )
 {
@@ -489,6 +722,203 @@ QuicTimeUs64(
     return QuicTimespecToUs(&CurrTime);
 }
 
+#if defined(__x86_64__)
+
+//
+// Calibrated TSC time source. QuicTimeUs64 is called several times per
+// packet (send timestamps, RTT samples, timer wheel updates), and even the
+// vDSO clock_gettime path costs tens of nanoseconds per call. When the
+// processor advertises an invariant TSC, time is instead computed as
+//
+//     BaseUs + (rdtsc() - BaseTsc) * MultUsPerTsc >> 32
+//
+// which is a handful of cycles. The anchor (BaseTsc, BaseUs) and the 32.32
+// fixed-point frequency are recalibrated against CLOCK_MONOTONIC roughly
+// once a second; each recalibration measures the frequency over the whole
+// interval since initialization, so the estimate only gets better with
+// time, and the new anchor never steps backwards from what the old
+// parameters would have reported. The parameters are published under a
+// sequence counter so readers always see a consistent triple. Without an
+// invariant TSC, QuicTimeUs64 falls back to clock_gettime.
+//
+#define QUIC_TSC_RESYNC_INTERVAL_US (1 * QUIC_MICROSEC_PER_SEC)
+
+static struct {
+
+    BOOLEAN Enabled;
+
+    //
+    // Sequence counter protecting the calibration parameters. Odd while an
+    // update is in flight.
+    //
+    volatile uint32_t Version;
+
+    uint64_t BaseTsc;
+    uint64_t BaseUs;
+    uint64_t MultUsPerTsc; // Microseconds per TSC tick, in 32.32 fixed point.
+
+    //
+    // TSC ticks between recalibrations, and the initial sample pair every
+    // frequency estimate is measured against.
+    //
+    uint64_t ResyncIntervalTsc;
+    uint64_t InitTsc;
+    uint64_t InitUs;
+
+    pthread_mutex_t ResyncLock;
+
+} QuicTscClock = { .ResyncLock = PTHREAD_MUTEX_INITIALIZER };
+
+static
+void
+QuicTscClockPublish(
+    _In_ uint64_t BaseTsc,
+    _In_ uint64_t BaseUs,
+    _In_ uint64_t MultUsPerTsc
+    )
+{
+    __atomic_store_n(
+        &QuicTscClock.Version, QuicTscClock.Version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    QuicTscClock.BaseTsc = BaseTsc;
+    QuicTscClock.BaseUs = BaseUs;
+    QuicTscClock.MultUsPerTsc = MultUsPerTsc;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(
+        &QuicTscClock.Version, QuicTscClock.Version + 1, __ATOMIC_RELEASE);
+}
+
+static
+void
+QuicTscClockResync(
+    void
+    )
+{
+    if (pthread_mutex_trylock(&QuicTscClock.ResyncLock) != 0) {
+        return; // Another thread is already resynchronizing.
+    }
+
+    uint64_t ClockUs = QuicClockUs64();
+    uint64_t Tsc = __rdtsc();
+
+    //
+    // Re-measure the frequency over the entire interval since
+    // initialization, so the relative error shrinks as the baseline grows.
+    //
+    uint64_t MultUsPerTsc =
+        (uint64_t)(
+            (((unsigned __int128)(ClockUs - QuicTscClock.InitUs)) << 32) /
+            (Tsc - QuicTscClock.InitTsc));
+
+    //
+    // Anchor the new parameters at whichever is further along: the wall
+    // clock, or what the outgoing parameters would have reported for this
+    // TSC value. This keeps the time source monotonic across
+    // recalibrations even if the old frequency estimate ran slightly fast.
+    //
+    uint64_t ProjectedUs =
+        QuicTscClock.BaseUs +
+        (uint64_t)(
+            ((unsigned __int128)(Tsc - QuicTscClock.BaseTsc) *
+             QuicTscClock.MultUsPerTsc) >> 32);
+    if (ProjectedUs > ClockUs) {
+        ClockUs = ProjectedUs;
+    }
+
+    QuicTscClockPublish(Tsc, ClockUs, MultUsPerTsc);
+
+    pthread_mutex_unlock(&QuicTscClock.ResyncLock);
+}
+
+static
+void
+QuicTscClockInitialize(
+    void
+    )
+{
+    if (QuicTscClock.Enabled) {
+        return; // Already calibrated by a previous initialization.
+    }
+
+    uint32_t Eax, Ebx, Ecx, Edx;
+    if (__get_cpuid(0x80000007, &Eax, &Ebx, &Ecx, &Edx) == 0 ||
+        (Edx & (1 << 8)) == 0) {
+        return; // No invariant TSC. Stay on clock_gettime.
+    }
+
+    uint64_t InitUs = QuicClockUs64();
+    uint64_t InitTsc = __rdtsc();
+
+    //
+    // Let the clocks run briefly for the initial frequency estimate. A
+    // couple of milliseconds bounds the estimate's error well under 0.1%,
+    // and every resynchronization afterwards refines it against the
+    // ever-growing baseline anchored here.
+    //
+    QuicSleep(2);
+
+    uint64_t BaseUs = QuicClockUs64();
+    uint64_t BaseTsc = __rdtsc();
+    if (BaseTsc <= InitTsc || BaseUs <= InitUs) {
+        return; // The TSC isn't usable as a clock after all.
+    }
+
+    uint64_t MultUsPerTsc =
+        (uint64_t)(
+            (((unsigned __int128)(BaseUs - InitUs)) << 32) /
+            (BaseTsc - InitTsc));
+
+    QuicTscClock.InitTsc = InitTsc;
+    QuicTscClock.InitUs = InitUs;
+    QuicTscClock.BaseTsc = BaseTsc;
+    QuicTscClock.BaseUs = BaseUs;
+    QuicTscClock.MultUsPerTsc = MultUsPerTsc;
+    QuicTscClock.ResyncIntervalTsc =
+        (uint64_t)(
+            ((unsigned __int128)QUIC_TSC_RESYNC_INTERVAL_US << 32) /
+            MultUsPerTsc);
+    QuicTscClock.Enabled = TRUE;
+}
+
+#endif // defined(__x86_64__)
+
+uint64_t
+QuicTimeUs64(
+    void
+    )
+{
+#if defined(__x86_64__)
+    if (QuicTscClock.Enabled) {
+
+        uint32_t Version;
+        uint64_t BaseTsc, BaseUs, MultUsPerTsc;
+        do {
+            Version = __atomic_load_n(&QuicTscClock.Version, __ATOMIC_ACQUIRE);
+            BaseTsc = QuicTscClock.BaseTsc;
+            BaseUs = QuicTscClock.BaseUs;
+            MultUsPerTsc = QuicTscClock.MultUsPerTsc;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while (
+            (Version & 1) != 0 ||
+            __atomic_load_n(&QuicTscClock.Version, __ATOMIC_ACQUIRE) != Version);
+
+        uint64_t Tsc = __rdtsc();
+        if (Tsc < BaseTsc) {
+            Tsc = BaseTsc; // Small cross-core TSC offsets must not underflow.
+        }
+
+        if (Tsc - BaseTsc >= QuicTscClock.ResyncIntervalTsc) {
+            QuicTscClockResync();
+        }
+
+        return
+            BaseUs +
+            (uint64_t)(((unsigned __int128)(Tsc - BaseTsc) * MultUsPerTsc) >> 32);
+    }
+#endif
+    return QuicClockUs64();
+}
+
 void
 QuicGetAbsoluteTime(
     _In_ unsigned long DeltaMs,
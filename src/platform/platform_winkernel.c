@@ -55,8 +55,32 @@ typedef struct _SYSTEM_BASIC_INFORMATION {
 
 uint64_t QuicPlatformPerfFreq;
 uint64_t QuicTotalMemory;
+int64_t QuicTotalAllocCount;
 QUIC_PLATFORM QuicPlatform = { NULL, NULL };
 
+//
+// Allocation site tracking stubs. See quic_platform_winkernel.h.
+//
+
+void
+QuicAllocSiteTrackingEnable(
+    _In_ BOOLEAN Enable
+    )
+{
+    UNREFERENCED_PARAMETER(Enable);
+}
+
+uint32_t
+QuicAllocSiteTrackingSnapshot(
+    _Out_writes_to_(SitesCount, return) QUIC_ALLOC_SITE* Sites,
+    _In_ uint32_t SitesCount
+    )
+{
+    UNREFERENCED_PARAMETER(Sites);
+    UNREFERENCED_PARAMETER(SitesCount);
+    return 0;
+}
+
 INITCODE
 _IRQL_requires_max_(PASSIVE_LEVEL)
 void
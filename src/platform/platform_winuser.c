@@ -14,9 +14,13 @@ Environment:
 --*/
 
 #include "platform_internal.h"
+#include <intrin.h> // For _ReturnAddress.
 
 uint64_t QuicPlatformPerfFreq;
 uint64_t QuicTotalMemory;
+int64_t QuicTotalAllocCount;
+BOOLEAN QuicAllocSiteTrackingEnabled = FALSE;
+QUIC_ALLOC_SITE QuicAllocSiteTable[QUIC_ALLOC_SITE_TABLE_SIZE];
 QUIC_PLATFORM QuicPlatform = { NULL };
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
@@ -176,6 +180,69 @@ QuicRandom(
 
 #endif
 
+static
+void
+QuicAllocSiteTrackingRecord(
+    _In_ void* Caller
+    )
+{
+    //
+    // Open-addressed table keyed by the caller's return address. Slots are
+    // claimed with a compare-exchange and never released, so counts stay
+    // attached to their site until tracking is re-enabled (which resets the
+    // table). If the table fills up the allocation still counts toward
+    // QuicTotalAllocCount; only its attribution is lost.
+    //
+    uint32_t Index =
+        (uint32_t)(((uintptr_t)Caller >> 4) * 2654435761u) %
+            QUIC_ALLOC_SITE_TABLE_SIZE;
+    for (uint32_t Probes = 0; Probes < QUIC_ALLOC_SITE_TABLE_SIZE; Probes++) {
+        QUIC_ALLOC_SITE* Site = &QuicAllocSiteTable[Index];
+        void* Existing = Site->Caller;
+        if (Existing == NULL) {
+            Existing =
+                InterlockedCompareExchangePointer(
+                    (void* volatile *)&Site->Caller, Caller, NULL);
+            if (Existing == NULL) {
+                Existing = Caller; // Claimed the slot.
+            }
+        }
+        if (Existing == Caller) {
+            InterlockedIncrement64(&Site->Count);
+            return;
+        }
+        Index = (Index + 1) % QUIC_ALLOC_SITE_TABLE_SIZE;
+    }
+}
+
+void
+QuicAllocSiteTrackingEnable(
+    _In_ BOOLEAN Enable
+    )
+{
+    if (Enable) {
+        QuicZeroMemory(QuicAllocSiteTable, sizeof(QuicAllocSiteTable));
+    }
+    QuicAllocSiteTrackingEnabled = Enable;
+}
+
+uint32_t
+QuicAllocSiteTrackingSnapshot(
+    _Out_writes_to_(SitesCount, return) QUIC_ALLOC_SITE* Sites,
+    _In_ uint32_t SitesCount
+    )
+{
+    uint32_t Count = 0;
+    for (uint32_t i = 0;
+         i < QUIC_ALLOC_SITE_TABLE_SIZE && Count < SitesCount;
+         i++) {
+        if (QuicAllocSiteTable[i].Caller != NULL) {
+            Sites[Count++] = QuicAllocSiteTable[i];
+        }
+    }
+    return Count;
+}
+
 _Ret_maybenull_
 _Post_writable_byte_size_(ByteCount)
 DECLSPEC_ALLOCATOR
@@ -185,6 +252,10 @@ QuicAlloc(
     )
 {
     QUIC_DBG_ASSERT(QuicPlatform.Heap);
+    InterlockedIncrement64(&QuicTotalAllocCount);
+    if (QuicAllocSiteTrackingEnabled) {
+        QuicAllocSiteTrackingRecord(_ReturnAddress());
+    }
     return HeapAlloc(QuicPlatform.Heap, 0, ByteCount);
 }
 
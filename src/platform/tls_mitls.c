@@ -17,6 +17,8 @@ Abstract:
 #include <mitlsffi.h>
 
 uint16_t QuicTlsTPHeaderSize = 0;
+const char* const QuicTlsLibraryName = "miTLS";
+const BOOLEAN QuicTlsSupportsPartialInput = FALSE;
 
 #define QUIC_SUPPORTED_CIPHER_SUITES        "TLS_AES_128_GCM_SHA256"
 #define QUIC_SERVER_SIGNATURE_ALGORITHMS    "ECDSA+SHA256:ECDSA+SHA384:ECDSA+SHA512:RSAPSS+SHA256:RSAPSS+SHA384:RSAPSS+SHA512"
@@ -334,6 +336,19 @@ typedef struct QUIC_TLS {
     QUIC_TLS_PROCESS_COMPLETE_CALLBACK_HANDLER ProcessCompleteCallback;
     QUIC_TLS_RECEIVE_TP_CALLBACK_HANDLER ReceiveTPCallback;
 
+    //
+    // State for handshake processing run on the offload pool instead of the
+    // connection's worker. OffloadQueued is protected by the offload pool's
+    // lock; the cached result is consumed by the next call to
+    // QuicTlsProcessDataComplete.
+    //
+    QUIC_LIST_ENTRY OffloadLink;
+    QUIC_TLS_RESULT_FLAGS PendingResultFlags;
+    uint32_t PendingConsumedBytes;
+    BOOLEAN OffloadQueued;
+    BOOLEAN OffloadProcessed;
+    QUIC_EVENT OffloadDoneEvent;
+
     //
     // miTLS Config.
     //
@@ -361,6 +376,58 @@ typedef struct QUIC_TLS {
 
 } QUIC_TLS;
 
+//
+// The maximum number of threads in the handshake offload pool.
+//
+#define QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT 4
+
+//
+// The dedicated thread pool that handshake processing is offloaded to.
+// Certificate chain validation runs inside the miTLS processing call and can
+// block for tens of milliseconds on revocation (CAPI/OCSP) lookups, which
+// would otherwise stall every connection on the worker.
+//
+typedef struct QUIC_TLS_OFFLOAD_POOL {
+
+    //
+    // Indicates the pool started successfully and offload may be used.
+    //
+    BOOLEAN Enabled;
+
+    //
+    // Indicates the pool threads should exit.
+    //
+    BOOLEAN Shutdown;
+
+    //
+    // Protects the work item list and each context's OffloadQueued flag.
+    //
+    QUIC_DISPATCH_LOCK Lock;
+
+    //
+    // List of QUIC_TLS contexts (by OffloadLink) with processing to do.
+    //
+    QUIC_LIST_ENTRY WorkItems;
+
+    //
+    // Auto-reset event used to wake a pool thread when work is queued.
+    //
+    QUIC_EVENT WakeEvent;
+
+    uint32_t ThreadCount;
+    QUIC_THREAD Threads[QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT];
+
+} QUIC_TLS_OFFLOAD_POOL;
+
+static QUIC_TLS_OFFLOAD_POOL QuicTlsOffloadPool;
+
+static
+QUIC_TLS_RESULT_FLAGS
+QuicTlsProcessDataSync(
+    _In_ QUIC_TLS* TlsContext,
+    _Out_ uint32_t * BufferConsumed
+    );
+
 //
 // Callback from mitls for logging purposes.
 //
@@ -377,6 +444,66 @@ MiTlsTraceCallback(
         Msg);
 }
 
+//
+// Thread callback for the handshake offload pool. Drains queued contexts,
+// runs the (possibly blocking) miTLS processing on them and delivers the
+// result back to the connection's worker via the process complete callback.
+//
+
+QUIC_THREAD_CALLBACK(QuicTlsOffloadWorker, Context)
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    while (TRUE) {
+
+        QuicEventWaitForever(QuicTlsOffloadPool.WakeEvent);
+
+        if (QuicTlsOffloadPool.Shutdown) {
+            //
+            // The wake event is auto-reset, so cascade it to wake the next
+            // pool thread for shutdown too.
+            //
+            QuicEventSet(QuicTlsOffloadPool.WakeEvent);
+            break;
+        }
+
+        while (TRUE) {
+
+            QUIC_TLS* TlsContext = NULL;
+            QuicDispatchLockAcquire(&QuicTlsOffloadPool.Lock);
+            if (!QuicListIsEmpty(&QuicTlsOffloadPool.WorkItems)) {
+                TlsContext =
+                    QUIC_CONTAINING_RECORD(
+                        QuicListRemoveHead(&QuicTlsOffloadPool.WorkItems),
+                        QUIC_TLS,
+                        OffloadLink);
+                TlsContext->OffloadQueued = FALSE;
+            }
+            QuicDispatchLockRelease(&QuicTlsOffloadPool.Lock);
+
+            if (TlsContext == NULL) {
+                break;
+            }
+
+            uint32_t ConsumedBytes = 0;
+            TlsContext->PendingResultFlags =
+                QuicTlsProcessDataSync(TlsContext, &ConsumedBytes);
+            TlsContext->PendingConsumedBytes = ConsumedBytes;
+            TlsContext->OffloadProcessed = TRUE;
+
+            TlsContext->ProcessCompleteCallback(TlsContext->Connection);
+
+            //
+            // The done event must be set last; QuicTlsUninitialize waits on
+            // it to know this thread is finished with the context.
+            //
+            QuicEventSet(TlsContext->OffloadDoneEvent);
+        }
+    }
+
+    QUIC_THREAD_RETURN(QUIC_STATUS_SUCCESS);
+}
+
 QUIC_STATUS
 QuicTlsLibraryInitialize(
     void
@@ -422,6 +549,46 @@ QuicTlsLibraryInitialize(
         goto Error;
     }
 
+    //
+    // Start the handshake offload pool. Failure is non-fatal; handshake
+    // processing falls back to running inline on the connection workers.
+    //
+
+    QuicTlsOffloadPool.Enabled = FALSE;
+    QuicTlsOffloadPool.Shutdown = FALSE;
+    QuicTlsOffloadPool.ThreadCount = 0;
+    QuicDispatchLockInitialize(&QuicTlsOffloadPool.Lock);
+    QuicListInitializeHead(&QuicTlsOffloadPool.WorkItems);
+    QuicEventInitialize(&QuicTlsOffloadPool.WakeEvent, FALSE, FALSE);
+
+    uint32_t TargetThreadCount = QuicProcActiveCount();
+    if (TargetThreadCount > QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT) {
+        TargetThreadCount = QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT;
+    }
+
+    for (uint32_t i = 0; i < TargetThreadCount; ++i) {
+        QUIC_THREAD_CONFIG ThreadConfig = {
+            0,
+            0,
+            "quic_tls_offload",
+            QuicTlsOffloadWorker,
+            NULL
+        };
+        if (QUIC_FAILED(
+                QuicThreadCreate(
+                    &ThreadConfig,
+                    &QuicTlsOffloadPool.Threads[QuicTlsOffloadPool.ThreadCount]))) {
+            QuicTraceEvent(
+                LibraryError,
+                "[ lib] ERROR, %s.",
+                "Create TLS offload thread");
+            break;
+        }
+        QuicTlsOffloadPool.ThreadCount++;
+    }
+
+    QuicTlsOffloadPool.Enabled = QuicTlsOffloadPool.ThreadCount != 0;
+
     Status = QUIC_STATUS_SUCCESS;
 
 Error:
@@ -434,6 +601,20 @@ QuicTlsLibraryUninitialize(
     void
     )
 {
+    if (QuicTlsOffloadPool.ThreadCount != 0) {
+        QuicTlsOffloadPool.Enabled = FALSE;
+        QuicTlsOffloadPool.Shutdown = TRUE;
+        QuicEventSet(QuicTlsOffloadPool.WakeEvent);
+        for (uint32_t i = 0; i < QuicTlsOffloadPool.ThreadCount; ++i) {
+            QuicThreadWait(&QuicTlsOffloadPool.Threads[i]);
+            QuicThreadDelete(&QuicTlsOffloadPool.Threads[i]);
+        }
+        QuicTlsOffloadPool.ThreadCount = 0;
+    }
+
+    QuicEventUninitialize(QuicTlsOffloadPool.WakeEvent);
+    QuicDispatchLockUninitialize(&QuicTlsOffloadPool.Lock);
+
     QuicTraceLogVerbose(
         miTlsUninitialize,
         "[ tls] Cleaning up miTLS library");
@@ -952,6 +1133,7 @@ QuicTlsInitialize(
     TlsContext->Connection = Config->Connection;
     TlsContext->ProcessCompleteCallback = Config->ProcessCompleteCallback;
     TlsContext->ReceiveTPCallback = Config->ReceiveTPCallback;
+    QuicEventInitialize(&TlsContext->OffloadDoneEvent, TRUE, TRUE);
 
     TlsContext->Extensions[0].ext_type = TLS_EXTENSION_TYPE_APPLICATION_LAYER_PROTOCOL_NEGOTIATION;
     TlsContext->Extensions[0].ext_data_len = sizeof(uint16_t) + Config->AlpnBufferLength;
@@ -1080,6 +1262,7 @@ Error:
         if (TlsContext->SNI) {
             QUIC_FREE(TlsContext->SNI);
         }
+        QuicEventUninitialize(TlsContext->OffloadDoneEvent);
         QuicTlsSessionRelease(TlsContext->TlsSession);
         QUIC_FREE(TlsContext);
     }
@@ -1097,6 +1280,24 @@ QuicTlsUninitialize(
 {
     if (TlsContext != NULL) {
 
+        //
+        // Cancel any outstanding offloaded handshake processing, or wait for
+        // it to complete if a pool thread has already picked it up.
+        //
+        if (QuicTlsOffloadPool.Enabled) {
+            QuicDispatchLockAcquire(&QuicTlsOffloadPool.Lock);
+            BOOLEAN StillQueued = TlsContext->OffloadQueued;
+            if (StillQueued) {
+                QuicListEntryRemove(&TlsContext->OffloadLink);
+                TlsContext->OffloadQueued = FALSE;
+            }
+            QuicDispatchLockRelease(&QuicTlsOffloadPool.Lock);
+            if (!StillQueued) {
+                QuicEventWaitForever(TlsContext->OffloadDoneEvent);
+            }
+        }
+        QuicEventUninitialize(TlsContext->OffloadDoneEvent);
+
         FFI_mitls_quic_free(TlsContext->miTlsState);
 
         if (TlsContext->Ticket != NULL) {
@@ -1208,12 +1409,33 @@ QuicTlsProcessData(
         //
         TlsContext->BufferLength = *BufferLength;
 
-        //
-        // Indicate that we will return pending, but just immediately invoke
-        // the completed callback.
-        //
         ResultFlags = QUIC_TLS_RESULT_PENDING;
-        TlsContext->ProcessCompleteCallback(TlsContext->Connection);
+
+        if (QuicTlsOffloadPool.Enabled && !State->HandshakeComplete) {
+            //
+            // Queue the processing on the offload pool so blocking work
+            // (certificate chain validation in particular) doesn't stall the
+            // other connections on this worker. The pool thread caches the
+            // result and invokes the process complete callback.
+            //
+            QuicEventReset(TlsContext->OffloadDoneEvent);
+
+            QuicDispatchLockAcquire(&QuicTlsOffloadPool.Lock);
+            TlsContext->OffloadQueued = TRUE;
+            QuicListInsertTail(
+                &QuicTlsOffloadPool.WorkItems, &TlsContext->OffloadLink);
+            QuicDispatchLockRelease(&QuicTlsOffloadPool.Lock);
+
+            QuicEventSet(QuicTlsOffloadPool.WakeEvent);
+
+        } else {
+            //
+            // Indicate that we will return pending, but just immediately
+            // invoke the completed callback; the processing then runs inline
+            // in QuicTlsProcessDataComplete.
+            //
+            TlsContext->ProcessCompleteCallback(TlsContext->Connection);
+        }
 
     } else {
 
@@ -1236,6 +1458,25 @@ QuicTlsProcessDataComplete(
     _In_ QUIC_TLS* TlsContext,
     _Out_ uint32_t * BufferConsumed
     )
+{
+    if (TlsContext->OffloadProcessed) {
+        //
+        // The processing already ran on the offload pool; just hand back the
+        // cached result.
+        //
+        TlsContext->OffloadProcessed = FALSE;
+        *BufferConsumed = TlsContext->PendingConsumedBytes;
+        return TlsContext->PendingResultFlags;
+    }
+    return QuicTlsProcessDataSync(TlsContext, BufferConsumed);
+}
+
+static
+QUIC_TLS_RESULT_FLAGS
+QuicTlsProcessDataSync(
+    _In_ QUIC_TLS* TlsContext,
+    _Out_ uint32_t * BufferConsumed
+    )
 {
     QUIC_TLS_RESULT_FLAGS ResultFlags = 0;
     QUIC_TLS_PROCESS_STATE* State = TlsContext->State;
@@ -2801,6 +3042,37 @@ QuicEncrypt(
     return QUIC_STATUS_SUCCESS;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QuicEncryptBatch(
+    _In_ QUIC_KEY* Key,
+    _In_ uint8_t BatchSize,
+    _In_reads_bytes_(BatchSize * QUIC_IV_LENGTH)
+        const uint8_t* const Ivs,
+    _In_reads_(BatchSize)
+        const uint16_t* const HeaderLengths,
+    _In_reads_(BatchSize)
+        const uint16_t* const PayloadLengths,
+    _In_reads_(BatchSize)
+        uint8_t* const* const Buffers
+    )
+{
+    for (uint8_t i = 0; i < BatchSize; ++i) {
+        QUIC_STATUS Status =
+            QuicEncrypt(
+                Key,
+                Ivs + i * QUIC_IV_LENGTH,
+                HeaderLengths[i],
+                Buffers[i],
+                PayloadLengths[i],
+                Buffers[i] + HeaderLengths[i]);
+        if (QUIC_FAILED(Status)) {
+            return Status;
+        }
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 #pragma prefast(suppress: __WARNING_6262, "miTLS won't be shipped in product.")
@@ -18,6 +18,8 @@ Abstract:
 #include "openssl/pem.h"
 
 uint16_t QuicTlsTPHeaderSize = 0;
+const char* const QuicTlsLibraryName = "OpenSSL";
+const BOOLEAN QuicTlsSupportsPartialInput = TRUE; // SSL_provide_quic_data buffers fragments.
 
 //
 // TLS session object.
@@ -108,8 +110,72 @@ typedef struct QUIC_TLS {
     QUIC_CONNECTION* Connection;
     QUIC_TLS_RECEIVE_TP_CALLBACK_HANDLER ReceiveTPCallback;
 
+    //
+    // Completion callback invoked when offloaded handshake processing
+    // finishes, plus the pending call state while an offloaded call is
+    // outstanding. OffloadQueued is protected by the offload pool's lock.
+    //
+    QUIC_TLS_PROCESS_COMPLETE_CALLBACK_HANDLER ProcessCompleteCallback;
+    QUIC_LIST_ENTRY OffloadLink;
+    const uint8_t* PendingBuffer;
+    uint32_t PendingBufferLength;
+    QUIC_TLS_RESULT_FLAGS PendingResultFlags;
+    BOOLEAN OffloadQueued;
+    QUIC_EVENT OffloadDoneEvent;
+
 } QUIC_TLS;
 
+//
+// The maximum number of threads in the handshake offload pool.
+//
+
+#define QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT 4
+
+//
+// The dedicated thread pool that CPU-heavy handshake processing (certificate
+// chain validation, signature operations) is offloaded to, so a multi-
+// millisecond handshake doesn't stall every other connection on a worker.
+//
+
+typedef struct QUIC_TLS_OFFLOAD_POOL {
+
+    //
+    // Indicates the pool started successfully and offload may be used.
+    //
+
+    BOOLEAN Enabled;
+
+    //
+    // Indicates the pool threads should exit.
+    //
+
+    BOOLEAN Shutdown;
+
+    //
+    // Protects the work item list and each context's OffloadQueued flag.
+    //
+
+    QUIC_DISPATCH_LOCK Lock;
+
+    //
+    // List of QUIC_TLS contexts (by OffloadLink) with processing to do.
+    //
+
+    QUIC_LIST_ENTRY WorkItems;
+
+    //
+    // Auto-reset event used to wake a pool thread when work is queued.
+    //
+
+    QUIC_EVENT WakeEvent;
+
+    uint32_t ThreadCount;
+    QUIC_THREAD Threads[QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT];
+
+} QUIC_TLS_OFFLOAD_POOL;
+
+static QUIC_TLS_OFFLOAD_POOL QuicTlsOffloadPool;
+
 //
 // Represents a packet payload protection key.
 //
@@ -174,6 +240,15 @@ typedef struct QUIC_HP_KEY {
 
 #define QUIC_TLS_DEFAULT_SSL_CIPHERS    "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256"
 
+//
+// Cipher list with ChaCha20-Poly1305 first, used when the sec config asks to
+// prefer it (e.g. for targets without AES hardware acceleration). Since the
+// server context sets SSL_OP_CIPHER_SERVER_PREFERENCE, the server's order
+// decides the negotiated suite.
+//
+
+#define QUIC_TLS_CHACHA20_FIRST_SSL_CIPHERS "TLS_CHACHA20_POLY1305_SHA256:TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384"
+
 //
 // Default list of curves for ECDHE ciphers.
 //
@@ -381,10 +456,11 @@ QuicTlsDecrypt(
 static
 BOOLEAN
 QuicTlsHeaderMask(
-    _Out_writes_bytes_(5) uint8_t *OutputBuffer,
+    _Out_writes_bytes_(16 * BatchSize) uint8_t *OutputBuffer,
     _In_reads_bytes_(keylen) const uint8_t *Key,
     _In_ size_t keylen,
-    _In_reads_bytes_(16) const uint8_t *Sample,
+    _In_reads_bytes_(16 * BatchSize) const uint8_t *Sample,
+    _In_ uint8_t BatchSize,
     _In_ const EVP_CIPHER *Aead
     );
 
@@ -394,6 +470,78 @@ QuicTlsSecConfigDelete(
     _In_ QUIC_SEC_CONFIG* SecurityConfig
     );
 
+static
+QUIC_TLS_RESULT_FLAGS
+QuicTlsProcessDataSync(
+    _In_ QUIC_TLS* TlsContext,
+    _In_reads_bytes_(*BufferLength) const uint8_t* Buffer,
+    _Inout_ uint32_t* BufferLength,
+    _Inout_ QUIC_TLS_PROCESS_STATE* State
+    );
+
+//
+// Thread callback for the handshake offload pool. Drains queued contexts,
+// runs the (expensive) handshake processing on them and delivers the result
+// back to the connection's worker via the process complete callback.
+//
+
+QUIC_THREAD_CALLBACK(QuicTlsOffloadWorker, Context)
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    while (TRUE) {
+
+        QuicEventWaitForever(QuicTlsOffloadPool.WakeEvent);
+
+        if (QuicTlsOffloadPool.Shutdown) {
+            //
+            // The wake event is auto-reset, so cascade it to wake the next
+            // pool thread for shutdown too.
+            //
+            QuicEventSet(QuicTlsOffloadPool.WakeEvent);
+            break;
+        }
+
+        while (TRUE) {
+
+            QUIC_TLS* TlsContext = NULL;
+            QuicDispatchLockAcquire(&QuicTlsOffloadPool.Lock);
+            if (!QuicListIsEmpty(&QuicTlsOffloadPool.WorkItems)) {
+                TlsContext =
+                    QUIC_CONTAINING_RECORD(
+                        QuicListRemoveHead(&QuicTlsOffloadPool.WorkItems),
+                        QUIC_TLS,
+                        OffloadLink);
+                TlsContext->OffloadQueued = FALSE;
+            }
+            QuicDispatchLockRelease(&QuicTlsOffloadPool.Lock);
+
+            if (TlsContext == NULL) {
+                break;
+            }
+
+            uint32_t BufferLength = TlsContext->PendingBufferLength;
+            TlsContext->PendingResultFlags =
+                QuicTlsProcessDataSync(
+                    TlsContext,
+                    TlsContext->PendingBuffer,
+                    &BufferLength,
+                    TlsContext->State);
+            TlsContext->PendingBufferLength = BufferLength;
+
+            TlsContext->ProcessCompleteCallback(TlsContext->Connection);
+
+            //
+            // The done event must be set last; QuicTlsUninitialize waits on
+            // it to know this thread is finished with the context.
+            //
+            QuicEventSet(TlsContext->OffloadDoneEvent);
+        }
+    }
+
+    QUIC_THREAD_RETURN(QUIC_STATUS_SUCCESS);
+}
+
 QUIC_STATUS
 QuicTlsLibraryInitialize(
     void
@@ -418,6 +566,46 @@ QuicTlsLibraryInitialize(
     // LINUX_TODO:Add Check for openssl library QUIC support.
     //
 
+    //
+    // Start the handshake offload pool. Failure is non-fatal; handshake
+    // processing falls back to running inline on the connection workers.
+    //
+
+    QuicTlsOffloadPool.Enabled = FALSE;
+    QuicTlsOffloadPool.Shutdown = FALSE;
+    QuicTlsOffloadPool.ThreadCount = 0;
+    QuicDispatchLockInitialize(&QuicTlsOffloadPool.Lock);
+    QuicListInitializeHead(&QuicTlsOffloadPool.WorkItems);
+    QuicEventInitialize(&QuicTlsOffloadPool.WakeEvent, FALSE, FALSE);
+
+    uint32_t TargetThreadCount = QuicProcActiveCount();
+    if (TargetThreadCount > QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT) {
+        TargetThreadCount = QUIC_TLS_OFFLOAD_MAX_THREAD_COUNT;
+    }
+
+    for (uint32_t i = 0; i < TargetThreadCount; ++i) {
+        QUIC_THREAD_CONFIG ThreadConfig = {
+            0,
+            0,
+            "quic_tls_offload",
+            QuicTlsOffloadWorker,
+            NULL
+        };
+        if (QUIC_FAILED(
+                QuicThreadCreate(
+                    &ThreadConfig,
+                    &QuicTlsOffloadPool.Threads[QuicTlsOffloadPool.ThreadCount]))) {
+            QuicTraceEvent(
+                LibraryError,
+                "[ lib] ERROR, %s.",
+                "Create TLS offload thread");
+            break;
+        }
+        QuicTlsOffloadPool.ThreadCount++;
+    }
+
+    QuicTlsOffloadPool.Enabled = QuicTlsOffloadPool.ThreadCount != 0;
+
     return QUIC_STATUS_SUCCESS;
 }
 
@@ -426,6 +614,19 @@ QuicTlsLibraryUninitialize(
     void
     )
 {
+    if (QuicTlsOffloadPool.ThreadCount != 0) {
+        QuicTlsOffloadPool.Enabled = FALSE;
+        QuicTlsOffloadPool.Shutdown = TRUE;
+        QuicEventSet(QuicTlsOffloadPool.WakeEvent);
+        for (uint32_t i = 0; i < QuicTlsOffloadPool.ThreadCount; ++i) {
+            QuicThreadWait(&QuicTlsOffloadPool.Threads[i]);
+            QuicThreadDelete(&QuicTlsOffloadPool.Threads[i]);
+        }
+        QuicTlsOffloadPool.ThreadCount = 0;
+    }
+
+    QuicEventUninitialize(QuicTlsOffloadPool.WakeEvent);
+    QuicDispatchLockUninitialize(&QuicTlsOffloadPool.Lock);
 }
 
 static
@@ -687,7 +888,8 @@ QuicTlsServerSecConfigCreate(
     // We only allow PEM formatted cert files.
     //
 
-    if (Flags != QUIC_SEC_CONFIG_FLAG_CERTIFICATE_FILE) {
+    if ((Flags & ~QUIC_SEC_CONFIG_FLAG_PREFER_CHACHA20) !=
+            QUIC_SEC_CONFIG_FLAG_CERTIFICATE_FILE) {
         QuicTraceEvent(
             LibraryErrorStatus,
             "[ lib] ERROR, %u, %s.",
@@ -769,7 +971,9 @@ QuicTlsServerSecConfigCreate(
     Ret =
         SSL_CTX_set_ciphersuites(
             SecurityConfig->SSLCtx,
-            QUIC_TLS_DEFAULT_SSL_CIPHERS);
+            (Flags & QUIC_SEC_CONFIG_FLAG_PREFER_CHACHA20) ?
+                QUIC_TLS_CHACHA20_FIRST_SSL_CIPHERS :
+                QUIC_TLS_DEFAULT_SSL_CIPHERS);
     if (Ret != 1) {
         QuicTraceEvent(
             LibraryErrorStatus,
@@ -1169,6 +1373,8 @@ QuicTlsInitialize(
     TlsContext->AlpnBufferLength = Config->AlpnBufferLength;
     TlsContext->AlpnBuffer = Config->AlpnBuffer;
     TlsContext->ReceiveTPCallback = Config->ReceiveTPCallback;
+    TlsContext->ProcessCompleteCallback = Config->ProcessCompleteCallback;
+    QuicEventInitialize(&TlsContext->OffloadDoneEvent, TRUE, TRUE);
 
     QuicTraceLogConnVerbose(
         OpenSslContextCreated,
@@ -1271,6 +1477,24 @@ QuicTlsUninitialize(
             TlsContext->Connection,
             "Cleaning up");
 
+        //
+        // Cancel any outstanding offloaded handshake processing, or wait for
+        // it to complete if a pool thread has already picked it up.
+        //
+        if (QuicTlsOffloadPool.Enabled) {
+            QuicDispatchLockAcquire(&QuicTlsOffloadPool.Lock);
+            BOOLEAN StillQueued = TlsContext->OffloadQueued;
+            if (StillQueued) {
+                QuicListEntryRemove(&TlsContext->OffloadLink);
+                TlsContext->OffloadQueued = FALSE;
+            }
+            QuicDispatchLockRelease(&QuicTlsOffloadPool.Lock);
+            if (!StillQueued) {
+                QuicEventWaitForever(TlsContext->OffloadDoneEvent);
+            }
+        }
+        QuicEventUninitialize(TlsContext->OffloadDoneEvent);
+
         if (TlsContext->SecConfig != NULL) {
             QuicTlsSecConfigRelease(TlsContext->SecConfig);
             TlsContext->SecConfig = NULL;
@@ -1358,8 +1582,9 @@ QuicTlsGetSecConfig(
     return QuicTlsSecConfigAddRef(TlsContext->SecConfig);
 }
 
+static
 QUIC_TLS_RESULT_FLAGS
-QuicTlsProcessData(
+QuicTlsProcessDataSync(
     _In_ QUIC_TLS* TlsContext,
     _In_reads_bytes_(*BufferLength) const uint8_t* Buffer,
     _Inout_ uint32_t* BufferLength,
@@ -1522,15 +1747,59 @@ Exit:
     return TlsContext->ResultFlags;
 }
 
+QUIC_TLS_RESULT_FLAGS
+QuicTlsProcessData(
+    _In_ QUIC_TLS* TlsContext,
+    _In_reads_bytes_(*BufferLength) const uint8_t* Buffer,
+    _Inout_ uint32_t* BufferLength,
+    _Inout_ QUIC_TLS_PROCESS_STATE* State
+    )
+{
+    QUIC_DBG_ASSERT(Buffer != NULL || *BufferLength == 0);
+
+    if (QuicTlsOffloadPool.Enabled &&
+        !State->HandshakeComplete &&
+        Buffer != NULL &&
+        TlsContext->ProcessCompleteCallback != NULL) {
+        //
+        // Offload the CPU-heavy handshake processing to the dedicated pool
+        // so it doesn't block the other connections on this worker. The
+        // result is delivered back through the process complete callback and
+        // QuicTlsProcessDataComplete, the same pattern the SChannel backend
+        // uses for its async calls. Client initial processing (NULL buffer)
+        // must stay synchronous; the core doesn't support pending there.
+        // Post-handshake data is cheap and also stays synchronous.
+        //
+        TlsContext->State = State;
+        TlsContext->PendingBuffer = Buffer;
+        TlsContext->PendingBufferLength = *BufferLength;
+        TlsContext->PendingResultFlags = 0;
+        QuicEventReset(TlsContext->OffloadDoneEvent);
+
+        QuicDispatchLockAcquire(&QuicTlsOffloadPool.Lock);
+        TlsContext->OffloadQueued = TRUE;
+        QuicListInsertTail(
+            &QuicTlsOffloadPool.WorkItems, &TlsContext->OffloadLink);
+        QuicDispatchLockRelease(&QuicTlsOffloadPool.Lock);
+
+        QuicEventSet(QuicTlsOffloadPool.WakeEvent);
+
+        return QUIC_TLS_RESULT_PENDING;
+    }
+
+    return QuicTlsProcessDataSync(TlsContext, Buffer, BufferLength, State);
+}
+
 QUIC_TLS_RESULT_FLAGS
 QuicTlsProcessDataComplete(
     _In_ QUIC_TLS* TlsContext,
     _Out_ uint32_t * BufferConsumed
     )
 {
-    UNREFERENCED_PARAMETER(TlsContext);
-    UNREFERENCED_PARAMETER(BufferConsumed);
-    return QUIC_TLS_RESULT_ERROR;
+    *BufferConsumed = TlsContext->PendingBufferLength;
+    TlsContext->PendingBuffer = NULL;
+    TlsContext->PendingBufferLength = 0;
+    return TlsContext->PendingResultFlags;
 }
 
 QUIC_STATUS
@@ -1598,6 +1867,27 @@ QuicPacketKeyCreateInitial(
     uint8_t InitialSecret[QUIC_HASH_SHA256_SIZE] = {0};
     uint8_t Secret[QUIC_HASH_SHA256_SIZE] = {0};
 
+    //
+    // The extract step only depends on the salt and CID, so compute it once
+    // up front and share the result between the read and write derivations.
+    //
+    if ((ReadKey != NULL || WriteKey != NULL) &&
+        !QuicTlsHkdfExtract(
+            InitialSecret,
+            sizeof(InitialSecret),
+            CID,
+            CIDLength,
+            Salt,
+            QUIC_VERSION_SALT_LENGTH,
+            EVP_sha256())) {
+        QuicTraceEvent(
+            LibraryError,
+            "[ lib] ERROR, %s.",
+            "QuicTlsHkdfExtract failed");
+        Status = QUIC_STATUS_TLS_ERROR;
+        goto Exit;
+    }
+
     if (WriteKey != NULL) {
         Status = QuicAllocatePacketKey(QUIC_PACKET_KEY_INITIAL, TRUE, &TempWriteKey);
         if (QUIC_FAILED(Status)) {
@@ -1607,22 +1897,6 @@ QuicPacketKeyCreateInitial(
         TempWriteKey->PacketKey->Aead = EVP_aes_128_gcm();
         TempWriteKey->HeaderKey->Aead = EVP_aes_128_ctr();
 
-        if (!QuicTlsHkdfExtract(
-                InitialSecret,
-                sizeof(InitialSecret),
-                CID,
-                CIDLength,
-                Salt,
-                QUIC_VERSION_SALT_LENGTH,
-                EVP_sha256())) {
-            QuicTraceEvent(
-                LibraryError,
-                "[ lib] ERROR, %s.",
-                "QuicTlsHkdfExtract failed");
-            Status = QUIC_STATUS_TLS_ERROR;
-            goto Exit;
-        }
-
         if (IsServer) {
             if (!QuicTlsDeriveServerInitialSecret(
                     Secret,
@@ -1709,22 +1983,6 @@ QuicPacketKeyCreateInitial(
         TempReadKey->PacketKey->Aead = EVP_aes_128_gcm();
         TempReadKey->HeaderKey->Aead = EVP_aes_128_ctr();
 
-        if (!QuicTlsHkdfExtract(
-                InitialSecret,
-                sizeof(InitialSecret),
-                CID,
-                CIDLength,
-                Salt,
-                QUIC_VERSION_SALT_LENGTH,
-                EVP_sha256())) {
-            QuicTraceEvent(
-                LibraryError,
-                "[ lib] ERROR, %s.",
-                "QuicTlsHkdfExtract failed");
-            Status = QUIC_STATUS_TLS_ERROR;
-            goto Exit;
-        }
-
         if (IsServer) {
             if (!QuicTlsDeriveClientInitialSecret(
                     Secret,
@@ -2007,6 +2265,37 @@ QuicEncrypt(
     return (Ret < 0) ? QUIC_STATUS_TLS_ERROR : QUIC_STATUS_SUCCESS;
 }
 
+QUIC_STATUS
+QuicEncryptBatch(
+    _In_ QUIC_KEY* Key,
+    _In_ uint8_t BatchSize,
+    _In_reads_bytes_(BatchSize * QUIC_IV_LENGTH) const uint8_t* const Ivs,
+    _In_reads_(BatchSize) const uint16_t* const HeaderLengths,
+    _In_reads_(BatchSize) const uint16_t* const PayloadLengths,
+    _In_reads_(BatchSize) uint8_t* const* const Buffers
+    )
+{
+    //
+    // TODO - Use the EVP pipeline interface (EVP_CTRL_SET_PIPELINE_*) when a
+    // pipeline-capable AES-GCM provider is available, so the AES-NI rounds of
+    // the packets in the batch can execute in parallel.
+    //
+    for (uint8_t i = 0; i < BatchSize; ++i) {
+        QUIC_STATUS Status =
+            QuicEncrypt(
+                Key,
+                Ivs + i * QUIC_IV_LENGTH,
+                HeaderLengths[i],
+                Buffers[i],
+                PayloadLengths[i],
+                Buffers[i] + HeaderLengths[i]);
+        if (QUIC_FAILED(Status)) {
+            return Status;
+        }
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
 QUIC_STATUS
 QuicDecrypt(
     _In_ QUIC_KEY* Key,
@@ -2065,7 +2354,14 @@ QuicHpKeyCreate(
         Key->Aead = EVP_aes_256_ctr();
         break;
     case QUIC_AEAD_CHACHA20_POLY1305:
-        Key->Aead = EVP_chacha20_poly1305();
+        //
+        // Header protection uses the raw ChaCha20 stream cipher, not the
+        // AEAD construction. OpenSSL's 16 byte ChaCha20 IV layout (4 byte
+        // counter followed by a 12 byte nonce) matches the QUIC header
+        // protection sample layout exactly, so the generic mask routine
+        // works unmodified.
+        //
+        Key->Aead = EVP_chacha20();
         break;
     default:
         Status = QUIC_STATUS_NOT_SUPPORTED;
@@ -2104,15 +2400,14 @@ QuicHpComputeMask(
     _Out_writes_bytes_(QUIC_HP_SAMPLE_LENGTH * BatchSize) uint8_t* Mask
     )
 {
-    for (uint8_t i = 0; i < BatchSize; i++) {
-        if (!QuicTlsHeaderMask(
-                Mask + i * QUIC_HP_SAMPLE_LENGTH,
-                Key->Buffer,
-                Key->BufferLen,
-                Cipher + i * QUIC_HP_SAMPLE_LENGTH,
-                Key->Aead)) {
-            return QUIC_STATUS_TLS_ERROR;
-        }
+    if (!QuicTlsHeaderMask(
+            Mask,
+            Key->Buffer,
+            Key->BufferLen,
+            Cipher,
+            BatchSize,
+            Key->Aead)) {
+        return QUIC_STATUS_TLS_ERROR;
     }
 
     return QUIC_STATUS_SUCCESS;
@@ -3209,17 +3504,17 @@ Exit:
 static
 BOOLEAN
 QuicTlsHeaderMask(
-    _Out_writes_bytes_(5) uint8_t *OutputBuffer,
+    _Out_writes_bytes_(16 * BatchSize) uint8_t *OutputBuffer,
     _In_reads_bytes_(keylen) const uint8_t *Key,
     _In_ size_t KeyLen,
-    _In_reads_bytes_(16) const uint8_t *Cipher,
+    _In_reads_bytes_(16 * BatchSize) const uint8_t *Cipher,
+    _In_ uint8_t BatchSize,
     _In_ const EVP_CIPHER *Aead
     )
 {
     UNREFERENCED_PARAMETER(KeyLen);
     BOOLEAN Ret = FALSE;
     uint8_t Temp[16] = {0};
-    int OutputLen = 0;
     int Len = 0;
     static const uint8_t PLAINTEXT[] = "\x00\x00\x00\x00\x00";
 
@@ -3232,7 +3527,12 @@ QuicTlsHeaderMask(
         goto Exit;
     }
 
-    if (EVP_EncryptInit_ex(CipherCtx, Aead, NULL, Key, Cipher) != 1) {
+    //
+    // Set up the cipher and expand the key once; only the per-sample IV is
+    // reset inside the loop. This is what makes batched mask computation
+    // cheap: one key schedule and one context cover the whole batch.
+    //
+    if (EVP_EncryptInit_ex(CipherCtx, Aead, NULL, Key, NULL) != 1) {
         QuicTraceEvent(
             LibraryError,
             "[ lib] ERROR, %s.",
@@ -3240,27 +3540,38 @@ QuicTlsHeaderMask(
         goto Exit;
     }
 
-    if (EVP_EncryptUpdate(CipherCtx, Temp, &Len, PLAINTEXT, sizeof(PLAINTEXT) - 1) != 1) {
-        QuicTraceEvent(
-            LibraryError,
-            "[ lib] ERROR, %s.",
-            "EVP_EncryptUpdate failed");
-        goto Exit;
-    }
+    for (uint8_t i = 0; i < BatchSize; ++i) {
 
-    QUIC_FRE_ASSERT(Len == 5);
-    OutputLen += Len;
+        if (EVP_EncryptInit_ex(CipherCtx, NULL, NULL, NULL, Cipher + i * 16) != 1) {
+            QuicTraceEvent(
+                LibraryError,
+                "[ lib] ERROR, %s.",
+                "EVP_EncryptInit_ex (IV) failed");
+            goto Exit;
+        }
 
-    if (EVP_EncryptFinal_ex(CipherCtx, Temp + OutputLen, &Len) != 1) {
-        QuicTraceEvent(
-            LibraryError,
-            "[ lib] ERROR, %s.",
-            "EVP_EncryptFinal_ex failed");
-        goto Exit;
+        if (EVP_EncryptUpdate(CipherCtx, Temp, &Len, PLAINTEXT, sizeof(PLAINTEXT) - 1) != 1) {
+            QuicTraceEvent(
+                LibraryError,
+                "[ lib] ERROR, %s.",
+                "EVP_EncryptUpdate failed");
+            goto Exit;
+        }
+
+        QUIC_FRE_ASSERT(Len == 5);
+        QuicCopyMemory(OutputBuffer + i * 16, Temp, Len);
+
+        if (EVP_EncryptFinal_ex(CipherCtx, Temp, &Len) != 1) {
+            QuicTraceEvent(
+                LibraryError,
+                "[ lib] ERROR, %s.",
+                "EVP_EncryptFinal_ex failed");
+            goto Exit;
+        }
+
+        QUIC_FRE_ASSERT(Len == 0);
     }
 
-    QUIC_FRE_ASSERT(Len == 0);
-    QuicCopyMemory(OutputBuffer, Temp, OutputLen);
     Ret = TRUE;
 
 Exit:
@@ -212,6 +212,8 @@ typedef struct _SecPkgContext_SessionInfo
 #endif
 
 uint16_t QuicTlsTPHeaderSize = FIELD_OFFSET(SEND_GENERIC_TLS_EXTENSION, Buffer);
+const char* const QuicTlsLibraryName = "Schannel";
+const BOOLEAN QuicTlsSupportsPartialInput = FALSE; // Partial messages come back as SECBUFFER_MISSING.
 
 #define SecTrafficSecret_ClientEarlyData (SecTrafficSecret_Server + 1) // Hack to have my layer support 0-RTT
 
@@ -3002,6 +3004,37 @@ QuicEncrypt(
     return NtStatusToQuicStatus(Status);
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QuicEncryptBatch(
+    _In_ QUIC_KEY* Key,
+    _In_ uint8_t BatchSize,
+    _In_reads_bytes_(BatchSize * QUIC_IV_LENGTH)
+        const uint8_t* const Ivs,
+    _In_reads_(BatchSize)
+        const uint16_t* const HeaderLengths,
+    _In_reads_(BatchSize)
+        const uint16_t* const PayloadLengths,
+    _In_reads_(BatchSize)
+        uint8_t* const* const Buffers
+    )
+{
+    for (uint8_t i = 0; i < BatchSize; ++i) {
+        QUIC_STATUS Status =
+            QuicEncrypt(
+                Key,
+                Ivs + i * QUIC_IV_LENGTH,
+                HeaderLengths[i],
+                Buffers[i],
+                PayloadLengths[i],
+                Buffers[i] + HeaderLengths[i]);
+        if (QUIC_FAILED(Status)) {
+            return Status;
+        }
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QuicDecrypt(
@@ -12,6 +12,8 @@ Abstract:
 #include "platform_internal.h"
 
 uint16_t QuicTlsTPHeaderSize = 0;
+const char* const QuicTlsLibraryName = "Stub";
+const BOOLEAN QuicTlsSupportsPartialInput = FALSE;
 
 #define TLS1_PROTOCOL_VERSION 0x0301
 #define TLS_MESSAGE_HEADER_LENGTH 4
@@ -648,7 +650,7 @@ QuicTlsServerProcess(
             case TlsExt_ServerName: {
                 const QUIC_TLS_SNI_EXT* SNI = (QUIC_TLS_SNI_EXT*)ExtList;
                 uint16_t NameLength = TlsReadUint16(SNI->NameLength);
-                if (SNI->NameLength != 0) {
+                if (NameLength != 0) {
                     TlsContext->SNI = QUIC_ALLOC_PAGED(NameLength + 1);
                     memcpy((char*)TlsContext->SNI, SNI->Name, NameLength);
                     ((char*)TlsContext->SNI)[NameLength] = 0;
@@ -1430,6 +1432,37 @@ QuicEncrypt(
     return QUIC_STATUS_SUCCESS;
 }
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+QUIC_STATUS
+QuicEncryptBatch(
+    _In_ QUIC_KEY* Key,
+    _In_ uint8_t BatchSize,
+    _In_reads_bytes_(BatchSize * QUIC_IV_LENGTH)
+        const uint8_t* const Ivs,
+    _In_reads_(BatchSize)
+        const uint16_t* const HeaderLengths,
+    _In_reads_(BatchSize)
+        const uint16_t* const PayloadLengths,
+    _In_reads_(BatchSize)
+        uint8_t* const* const Buffers
+    )
+{
+    for (uint8_t i = 0; i < BatchSize; ++i) {
+        QUIC_STATUS Status =
+            QuicEncrypt(
+                Key,
+                Ivs + i * QUIC_IV_LENGTH,
+                HeaderLengths[i],
+                Buffers[i],
+                PayloadLengths[i],
+                Buffers[i] + HeaderLengths[i]);
+        if (QUIC_FAILED(Status)) {
+            return Status;
+        }
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 QUIC_STATUS
 QuicDecrypt(
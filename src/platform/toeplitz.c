@@ -34,10 +34,16 @@ Notes:
     The typical implementation requires the hash input to be processed one bit
     at a time, which is too slow for a software implementation.
 
-    We have speeded the implementation by processing the hash input four bits
-    at a time. This requires us to maintain a lookup table of 16 32-bit entries
-    for each nibble of the hash input. 
-    
+    We have speeded the implementation by processing the hash input a whole
+    byte at a time. This requires us to maintain a lookup table of 256 32-bit
+    entries for each byte position of the hash input. The tables total ~38 KB,
+    but there is a single instance for the library's lifetime and the hot
+    rows stay cached, so the trade is worthwhile for half the lookups of the
+    earlier per-nibble tables. A carryless-multiply implementation would avoid
+    the tables entirely, but the hash also runs in kernel mode where vector
+    instructions are off limits, so the table walk stays the portable common
+    path.
+
     This implementation assumes that the output of the hash is always 32-bit.
     It also assumes that the caller will pass in a array of bytes to hash, and
     the number of bits in the hash input will always be a multiple of 8 -- that
@@ -50,90 +56,69 @@ Notes:
 
 //
 // Initializes the state required for a Toeplitz hash computation. We
-// maintain per-nibble lookup tables, and we initialize them here.
+// maintain per-byte lookup tables, and we initialize them here.
 //
 void
 QuicToeplitzHashInitialize(
     _Inout_ QUIC_TOEPLITZ_HASH* Toeplitz
     )
 {
-    uint32_t BaseShift, StartByteOfKey;
     uint32_t Word1, Word2;
-    uint32_t Signature1, Signature2, Signature3, Signature4;
+    uint32_t Signatures[8];
 
     //
-    // Our table based strategy works as follows. For each nibble of the
-    // hash input, there is a table of 16 32-bit values. This table can
+    // Our table based strategy works as follows. For each byte of the
+    // hash input, there is a table of 256 32-bit values. This table can
     // directly be looked up to find out what value needs to be XORed
-    // into the result based on the value of the nibble. Therefore, a
-    // 4 byte hash input will have 8 nibbles, and each of the nibbles
-    // has a separate lookup table. This lookup table is looked up 
-    // based on the nibble value, the contents are XORed into the result
-    // and we then move to the next nibble of the input, and the next
-    // table.
+    // into the result based on the value of the byte. We look the table
+    // up based on the byte value, XOR the contents into the result and
+    // then move to the next byte of the input, and the next table.
     //
 
     //
     // Initialize the Toeplitz->LookupTables.
     //
     for (uint32_t i = 0; i < QUIC_TOEPLITZ_LOOKUP_TABLE_COUNT; i++) {
-        // 
+        //
         // First construct the 32-bit word that is obtained after
-        // shifting the key left by i*4 bits. That goes into Word1
+        // shifting the key left by i*8 bits. That goes into Word1.
         //
-        StartByteOfKey = i / NIBBLES_PER_BYTE;
-
-        Word1 = (Toeplitz->HashKey[StartByteOfKey] << 24) +
-                (Toeplitz->HashKey[StartByteOfKey + 1] << 16) +
-                (Toeplitz->HashKey[StartByteOfKey + 2] << 8) +
-                 Toeplitz->HashKey[StartByteOfKey + 3];
+        Word1 = (Toeplitz->HashKey[i] << 24) +
+                (Toeplitz->HashKey[i + 1] << 16) +
+                (Toeplitz->HashKey[i + 2] << 8) +
+                 Toeplitz->HashKey[i + 3];
 
         //
         // However, we'll need the byte that succeeds Word1, because as we
         // shift Word1 left, we need to bring in bits from the successor byte.
         // The successor byte goes in Word2.
         //
-        Word2 = Toeplitz->HashKey[StartByteOfKey + 4];
-
-        BaseShift = (i % NIBBLES_PER_BYTE) * BITS_PER_NIBBLE;
+        Word2 = Toeplitz->HashKey[i + 4];
 
         //
-        // Signature1 represents the value that needs to be XORed into
-        // the result if the LSB of the nibble is 1. Similarly, for
-        // the other Signature values.
+        // Signatures[0] represents the value that needs to be XORed into
+        // the result if the MSB of the input byte is 1, Signatures[7] the
+        // value for the LSB.
         //
-        Signature1 = (Word1 << BaseShift) | (Word2 >> (8 * sizeof(uint8_t) - BaseShift));
-        BaseShift ++;
-        Signature2 = (Word1 << BaseShift) | (Word2 >> (8 * sizeof(uint8_t) - BaseShift));
-        BaseShift ++;
-        Signature3 = (Word1 << BaseShift) | (Word2 >> (8 * sizeof(uint8_t) - BaseShift));
-        BaseShift ++;
-        Signature4 = (Word1 << BaseShift) | (Word2 >> (8 * sizeof(uint8_t) - BaseShift));
+        for (uint32_t Bit = 0; Bit < 8; Bit++) {
+            Signatures[Bit] =
+                (Word1 << Bit) | (Word2 >> (8 * sizeof(uint8_t) - Bit));
+        }
 
         for (uint32_t j = 0; j < QUIC_TOEPLITZ_LOOKUP_TABLE_SIZE; j++) {
 
             Toeplitz->LookupTableArray[i].Table[j] = 0;
-            if (j & 0x1) {
-                Toeplitz->LookupTableArray[i].Table[j] ^= Signature4;
-            }
-
-            if (j & 0x2) {
-                Toeplitz->LookupTableArray[i].Table[j] ^= Signature3;
-            }
-
-            if (j & 0x4) {
-                Toeplitz->LookupTableArray[i].Table[j] ^= Signature2;
-            }
-
-            if (j & 0x8) {
-                Toeplitz->LookupTableArray[i].Table[j] ^= Signature1;
+            for (uint32_t Bit = 0; Bit < 8; Bit++) {
+                if (j & (0x80u >> Bit)) {
+                    Toeplitz->LookupTableArray[i].Table[j] ^= Signatures[Bit];
+                }
             }
         }
     }
 }
 
 //
-// Computes the hash by processing the input four-bits at a time. It is assumed
+// Computes the hash by processing the input a byte at a time. It is assumed
 // that the hash input is a whole number of bytes (no partial byte-processing
 // needs to be done at the end).
 //
@@ -147,19 +132,16 @@ QuicToeplitzHashCompute(
     )
 {
     //
-    // BaseOffset is the first lookup table to be accessed.
+    // HashInputOffset is the first lookup table to be accessed.
     //
-    uint32_t BaseOffset = HashInputOffset * NIBBLES_PER_BYTE;
     uint32_t Result = 0;
 
     QUIC_DBG_ASSERT(
-        (BaseOffset + HashInputLength * NIBBLES_PER_BYTE) <= QUIC_TOEPLITZ_LOOKUP_TABLE_COUNT);
+        (HashInputOffset + HashInputLength) <= QUIC_TOEPLITZ_LOOKUP_TABLE_COUNT);
 
     for (uint32_t i = 0; i < HashInputLength; i++) {
-        Result ^= Toeplitz->LookupTableArray[BaseOffset].Table[(HashInput[i] >> 4) & 0xf];
-        BaseOffset++;
-        Result ^= Toeplitz->LookupTableArray[BaseOffset].Table[HashInput[i] & 0xf];
-        BaseOffset++;
+        Result ^=
+            Toeplitz->LookupTableArray[HashInputOffset + i].Table[HashInput[i]];
     }
 
     return Result;
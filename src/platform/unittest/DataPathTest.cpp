@@ -199,6 +199,7 @@ protected:
                         binding,
                         &recvBuffer->Tuple->LocalAddress,
                         &recvBuffer->Tuple->RemoteAddress,
+                        nullptr,
                         ServerSendContext
                     ));
 
@@ -0,0 +1,199 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    Unit test for the open-addressing (flat) hash table.
+
+--*/
+
+#include "main.h"
+
+struct FlatHashtableTest : public ::testing::Test
+{
+    QUIC_FLAT_HASHTABLE* Table {nullptr};
+
+    void SetUp() override {
+        ASSERT_TRUE(QuicFlatHashtableInitialize(&Table, QUIC_HASH_MIN_SIZE));
+    }
+
+    void TearDown() override {
+        if (Table != nullptr) {
+            QuicFlatHashtableUninitialize(Table);
+        }
+    }
+
+    //
+    // Walks all entries matching the signature and returns how many there
+    // are, optionally checking that a specific entry is among them.
+    //
+    uint32_t CountMatches(uint64_t Signature, void* ExpectedEntry = nullptr) {
+        uint32_t Count = 0;
+        bool Found = false;
+        QUIC_FLAT_HASHTABLE_LOOKUP_CONTEXT Context;
+        void* Entry = QuicFlatHashtableLookup(Table, Signature, &Context);
+        while (Entry != nullptr) {
+            Count++;
+            if (Entry == ExpectedEntry) {
+                Found = true;
+            }
+            Entry = QuicFlatHashtableLookupNext(Table, &Context);
+        }
+        EXPECT_TRUE(ExpectedEntry == nullptr || Found);
+        return Count;
+    }
+};
+
+TEST_F(FlatHashtableTest, InsertLookupRemove)
+{
+    uint32_t Values[4];
+
+    for (uint32_t i = 0; i < ARRAYSIZE(Values); i++) {
+        ASSERT_TRUE(QuicFlatHashtableInsert(Table, &Values[i], 0x1000 + i));
+    }
+    ASSERT_EQ(Table->NumEntries, ARRAYSIZE(Values));
+
+    for (uint32_t i = 0; i < ARRAYSIZE(Values); i++) {
+        ASSERT_EQ(CountMatches(0x1000 + i, &Values[i]), 1u);
+    }
+    ASSERT_EQ(CountMatches(0x2000), 0u);
+
+    for (uint32_t i = 0; i < ARRAYSIZE(Values); i++) {
+        QuicFlatHashtableRemove(Table, &Values[i], 0x1000 + i);
+        ASSERT_EQ(CountMatches(0x1000 + i), 0u);
+    }
+    ASSERT_EQ(Table->NumEntries, 0u);
+}
+
+TEST_F(FlatHashtableTest, DuplicateSignatures)
+{
+    const uint64_t Signature = 42;
+    uint32_t Values[3];
+
+    for (uint32_t i = 0; i < ARRAYSIZE(Values); i++) {
+        ASSERT_TRUE(QuicFlatHashtableInsert(Table, &Values[i], Signature));
+    }
+
+    //
+    // Every entry sharing the signature must be returned exactly once.
+    //
+    ASSERT_EQ(CountMatches(Signature, &Values[0]), ARRAYSIZE(Values));
+    ASSERT_EQ(CountMatches(Signature, &Values[1]), ARRAYSIZE(Values));
+    ASSERT_EQ(CountMatches(Signature, &Values[2]), ARRAYSIZE(Values));
+
+    QuicFlatHashtableRemove(Table, &Values[1], Signature);
+    ASSERT_EQ(CountMatches(Signature, &Values[0]), 2u);
+    ASSERT_EQ(CountMatches(Signature, &Values[2]), 2u);
+
+    QuicFlatHashtableRemove(Table, &Values[0], Signature);
+    QuicFlatHashtableRemove(Table, &Values[2], Signature);
+    ASSERT_EQ(CountMatches(Signature), 0u);
+}
+
+TEST_F(FlatHashtableTest, CollisionOverflowAndTombstones)
+{
+    //
+    // Three buckets worth of identical signatures forces the probe sequence
+    // past full buckets into their neighbors.
+    //
+    const uint64_t Signature = 0xabcdef;
+    const uint32_t Count = QUIC_FLAT_HASH_BUCKET_SLOTS * 3;
+    uint32_t Values[Count];
+
+    for (uint32_t i = 0; i < Count; i++) {
+        ASSERT_TRUE(QuicFlatHashtableInsert(Table, &Values[i], Signature));
+    }
+    ASSERT_EQ(CountMatches(Signature, &Values[Count - 1]), Count);
+
+    //
+    // Removing from full buckets must leave tombstones that keep the probe
+    // sequences of the surviving entries intact.
+    //
+    for (uint32_t i = 0; i < Count; i++) {
+        QuicFlatHashtableRemove(Table, &Values[i], Signature);
+        ASSERT_EQ(CountMatches(Signature), Count - i - 1);
+    }
+    ASSERT_EQ(Table->NumEntries, 0u);
+    ASSERT_NE(Table->NumTombstones, 0u);
+
+    //
+    // Reinsertion reuses the tombstoned slots.
+    //
+    const uint32_t Tombstones = Table->NumTombstones;
+    for (uint32_t i = 0; i < Count; i++) {
+        ASSERT_TRUE(QuicFlatHashtableInsert(Table, &Values[i], Signature));
+    }
+    ASSERT_EQ(CountMatches(Signature, &Values[0]), Count);
+    ASSERT_LT(Table->NumTombstones, Tombstones);
+}
+
+TEST_F(FlatHashtableTest, Growth)
+{
+    const uint32_t Count = 1000;
+    std::vector<uint32_t> Values(Count);
+    const uint32_t InitialBucketCount = Table->BucketCount;
+
+    //
+    // Sequential signatures, which the table's internal mixer is expected
+    // to spread across the buckets.
+    //
+    for (uint32_t i = 0; i < Count; i++) {
+        ASSERT_TRUE(QuicFlatHashtableInsert(Table, &Values[i], i));
+    }
+    ASSERT_EQ(Table->NumEntries, Count);
+    ASSERT_GT(Table->BucketCount, InitialBucketCount);
+
+    //
+    // Every entry must survive the rehashes.
+    //
+    for (uint32_t i = 0; i < Count; i++) {
+        ASSERT_EQ(CountMatches(i, &Values[i]), 1u);
+    }
+
+    for (uint32_t i = 0; i < Count; i++) {
+        QuicFlatHashtableRemove(Table, &Values[i], i);
+    }
+    ASSERT_EQ(Table->NumEntries, 0u);
+    ASSERT_EQ(CountMatches(0), 0u);
+}
+
+TEST_F(FlatHashtableTest, Enumeration)
+{
+    const uint32_t Count = 100;
+    std::vector<uint32_t> Values(Count);
+
+    for (uint32_t i = 0; i < Count; i++) {
+        ASSERT_TRUE(QuicFlatHashtableInsert(Table, &Values[i], i));
+    }
+
+    //
+    // Enumeration returns every entry exactly once, in no particular order.
+    //
+    std::vector<bool> Seen(Count, false);
+    QUIC_FLAT_HASHTABLE_ENUMERATOR Enumerator;
+    QuicFlatHashtableEnumerateBegin(Table, &Enumerator);
+    void* Entry;
+    while ((Entry = QuicFlatHashtableEnumerateNext(Table, &Enumerator)) != nullptr) {
+        auto Index = (uint32_t)((uint32_t*)Entry - Values.data());
+        ASSERT_LT(Index, Count);
+        ASSERT_FALSE(Seen[Index]);
+        Seen[Index] = true;
+    }
+    QuicFlatHashtableEnumerateEnd(Table, &Enumerator);
+    for (uint32_t i = 0; i < Count; i++) {
+        ASSERT_TRUE(Seen[i]);
+    }
+
+    //
+    // Entries may be removed while an enumeration is in progress.
+    //
+    QuicFlatHashtableEnumerateBegin(Table, &Enumerator);
+    while ((Entry = QuicFlatHashtableEnumerateNext(Table, &Enumerator)) != nullptr) {
+        auto Index = (uint32_t)((uint32_t*)Entry - Values.data());
+        QuicFlatHashtableRemove(Table, Entry, Index);
+    }
+    QuicFlatHashtableEnumerateEnd(Table, &Enumerator);
+    ASSERT_EQ(Table->NumEntries, 0u);
+}
@@ -80,6 +80,11 @@ QuicTestVersionNegotiation(
     _In_ int Family
     );
 
+void
+QuicTestHandshakeAllocCount(
+    _In_ int Family
+    );
+
 //
 // Negative Handshake Tests
 //
@@ -518,4 +523,8 @@ typedef struct {
 #define IOCTL_QUIC_RUN_START_LISTENER_MULTI_ALPN \
     QUIC_CTL_CODE(38, METHOD_BUFFERED, FILE_WRITE_DATA)
 
-#define QUIC_MAX_IOCTL_FUNC_CODE 38
+#define IOCTL_QUIC_RUN_HANDSHAKE_ALLOC_COUNT \
+    QUIC_CTL_CODE(39, METHOD_BUFFERED, FILE_WRITE_DATA)
+    // int - Family
+
+#define QUIC_MAX_IOCTL_FUNC_CODE 39
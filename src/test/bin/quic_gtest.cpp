@@ -395,6 +395,15 @@ TEST_P(WithFamilyArgs, VersionNegotiation) {
     }
 }
 
+TEST_P(WithFamilyArgs, HandshakeAllocCount) {
+    TestLoggerT<ParamType> Logger("QuicTestHandshakeAllocCount", GetParam());
+    if (TestingKernelMode) {
+        ASSERT_TRUE(DriverClient.Run(IOCTL_QUIC_RUN_HANDSHAKE_ALLOC_COUNT, GetParam().Family));
+    } else {
+        QuicTestHandshakeAllocCount(GetParam().Family);
+    }
+}
+
 TEST_P(WithFamilyArgs, Rebind) {
     TestLoggerT<ParamType> Logger("QuicTestConnect-Rebind", GetParam());
     if (TestingKernelMode) {
@@ -546,7 +546,8 @@ size_t QUIC_IOCTL_BUFFER_SIZES[] =
     0,
     sizeof(QUIC_RUN_DRILL_INITIAL_PACKET_CID_PARAMS),
     sizeof(INT32),
-    0
+    0,
+    sizeof(INT32)
 };
 
 static_assert(
@@ -909,6 +910,11 @@ QuicTestCtlEvtIoDeviceControl(
         QuicTestCtlRun(QuicTestStartListenerMultiAlpns());
         break;
 
+    case IOCTL_QUIC_RUN_HANDSHAKE_ALLOC_COUNT:
+        QUIC_FRE_ASSERT(Params != nullptr);
+        QuicTestCtlRun(QuicTestHandshakeAllocCount(Params->Family));
+        break;
+
     default:
         Status = STATUS_NOT_IMPLEMENTED;
         break;
@@ -1336,6 +1336,120 @@ QuicTestConnectUnreachable(
     }
 }
 
+//
+// Disables allocation site tracking on every exit path, including the early
+// returns the TEST_* macros take on failure.
+//
+struct AllocTrackingScope {
+    AllocTrackingScope() { QuicAllocSiteTrackingEnable(TRUE); }
+    ~AllocTrackingScope() { QuicAllocSiteTrackingEnable(FALSE); }
+};
+
+void
+QuicTestHandshakeAllocCount(
+    _In_ int Family
+    )
+{
+    //
+    // Ceiling on allocations per client-plus-accepted-connection handshake
+    // (including teardown), measured after a warmup handshake has primed the
+    // library's pools. Raising this number needs justification; it exists to
+    // keep accept-path allocations from silently regressing.
+    //
+    const int64_t AllocBudgetPerHandshake = 128;
+    const uint32_t HandshakeCount = 8;
+
+    MsQuicSession Session;
+    TEST_TRUE(Session.IsValid());
+    TEST_QUIC_SUCCEEDED(Session.SetIdleTimeout(10000));
+
+    {
+        TestListener Listener(Session.Handle, ListenerAcceptConnection);
+        TEST_TRUE(Listener.IsValid());
+
+        QUIC_ADDRESS_FAMILY QuicAddrFamily = (Family == 4) ? AF_INET : AF_INET6;
+        QuicAddr ServerLocalAddr(QuicAddrFamily);
+        TEST_QUIC_SUCCEEDED(Listener.Start(&ServerLocalAddr.SockAddr));
+        TEST_QUIC_SUCCEEDED(Listener.GetLocalAddr(ServerLocalAddr));
+
+        AllocTrackingScope TrackingScope;
+        int64_t StartAllocCount = 0;
+
+        for (uint32_t Iteration = 0; Iteration <= HandshakeCount; ++Iteration) {
+            if (Iteration == 1) {
+                //
+                // The first handshake warmed the pools and lookup tables;
+                // the budget applies to the steady-state accepts after it.
+                //
+                QuicAllocSiteTrackingEnable(TRUE); // Resets the site table.
+                StartAllocCount = QuicTotalAllocCount;
+            }
+
+            UniquePtr<TestConnection> Server;
+            ServerAcceptContext ServerAcceptCtx((TestConnection**)&Server);
+            Listener.Context = &ServerAcceptCtx;
+
+            {
+                TestConnection Client(
+                    Session.Handle,
+                    ConnectionDoNothingCallback,
+                    false);
+                TEST_TRUE(Client.IsValid());
+
+                #if QUIC_TEST_DISABLE_DNS
+                QuicAddr RemoteAddr(QuicAddrFamily, true);
+                TEST_QUIC_SUCCEEDED(Client.SetRemoteAddr(RemoteAddr));
+                #endif
+
+                TEST_QUIC_SUCCEEDED(
+                    Client.Start(
+                        QuicAddrFamily,
+                        QUIC_LOCALHOST_FOR_AF(QuicAddrFamily),
+                        QuicAddrGetPort(&ServerLocalAddr.SockAddr)));
+
+                if (!Client.WaitForConnectionComplete()) {
+                    return;
+                }
+                TEST_TRUE(Client.GetIsConnected());
+
+                TEST_NOT_EQUAL(nullptr, Server);
+                if (!Server->WaitForConnectionComplete()) {
+                    return;
+                }
+                TEST_TRUE(Server->GetIsConnected());
+
+                Client.Shutdown(
+                    QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, QUIC_TEST_NO_ERROR);
+                if (!Client.WaitForShutdownComplete()) {
+                    return;
+                }
+            }
+        }
+
+        const int64_t AllocCount = QuicTotalAllocCount - StartAllocCount;
+        if (AllocCount > AllocBudgetPerHandshake * HandshakeCount) {
+            QUIC_ALLOC_SITE Sites[QUIC_ALLOC_SITE_TABLE_SIZE];
+            uint32_t SiteCount =
+                QuicAllocSiteTrackingSnapshot(
+                    Sites, QUIC_ALLOC_SITE_TABLE_SIZE);
+            for (uint32_t i = 0; i < SiteCount; ++i) {
+                QuicTraceLogError(
+                    TestHandshakeAllocSite,
+                    "[test] Alloc site %p hit %llu times",
+                    Sites[i].Caller,
+                    (unsigned long long)Sites[i].Count);
+            }
+            TEST_FAILURE(
+                "%llu allocations over %u handshakes exceeds the budget of "
+                "%llu (%u sites reported via tracing)",
+                (unsigned long long)AllocCount,
+                HandshakeCount,
+                (unsigned long long)(AllocBudgetPerHandshake * HandshakeCount),
+                SiteCount);
+        }
+    }
+}
+
 void
 QuicTestVersionNegotiation(
     _In_ int Family
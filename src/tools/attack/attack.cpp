@@ -26,6 +26,12 @@
 
 #define ATTACK_PORT_DEFAULT 443
 
+#define ATTACK_BENCHMARK_RATE_DEFAULT 10000
+
+#define ATTACK_BENCHMARK_STEPS_DEFAULT 6
+
+#define ATTACK_BENCHMARK_STEP_MS_DEFAULT 5000
+
 void
 PrintUsage()
 {
@@ -33,7 +39,8 @@ PrintUsage()
 
     printf("Usage:\n");
     printf("  quicattack.exe -list\n\n");
-    printf("  quicattack.exe -type:<number> -ip:<ip_address_and_port> [-alpn:<protocol_name>] [-sni:<host_name>] [-timeout:<ms>] [-threads:<count>]\n\n");
+    printf("  quicattack.exe -type:<number> -ip:<ip_address_and_port> [-alpn:<protocol_name>] [-sni:<host_name>] [-timeout:<ms>] [-threads:<count>]\n");
+    printf("                 [-rate:<pps>] [-steps:<count>] [-stepms:<ms>]\n\n");
 }
 
 void
@@ -45,6 +52,11 @@ PrintUsageList()
     printf("#2 - Random UDP full length UDP packets.\n");
     printf("#3 - Random QUIC Initial packets.\n");
     printf("#4 - Valid QUIC initial packets.\n");
+    printf("#5 - DoS-resilience benchmark: steps the rate of #3 packets up from\n");
+    printf("     -rate (doubling each of -steps steps of -stepms each), reporting\n");
+    printf("     the server's stateless response rate and a good-client handshake\n");
+    printf("     latency probe at every step. Pair with the server's -stats output\n");
+    printf("     to track memory growth during the run.\n");
 }
 
 struct StrBuffer
@@ -67,6 +79,19 @@ struct StrBuffer
     ~StrBuffer() { delete [] Data; }
 };
 
+//
+// Wire-visible totals for the benchmark mode: packets we put on the wire and
+// the server's (stateless) responses that came back.
+//
+struct BenchmarkCounters
+{
+    int64_t PacketsSent;
+    int64_t ResponsesReceived;
+    int64_t ResponseBytesReceived;
+};
+
+BenchmarkCounters BenchCounters;
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Function_class_(QUIC_DATAPATH_RECEIVE_CALLBACK)
 void
@@ -76,6 +101,13 @@ UdpRecvCallback(
     _In_ QUIC_RECV_DATAGRAM* RecvBufferChain
     )
 {
+    for (QUIC_RECV_DATAGRAM* Datagram = RecvBufferChain;
+        Datagram != nullptr;
+        Datagram = Datagram->Next) {
+        InterlockedIncrement64(&BenchCounters.ResponsesReceived);
+        InterlockedExchangeAdd64(
+            &BenchCounters.ResponseBytesReceived, Datagram->BufferLength);
+    }
     QuicDataPathBindingReturnRecvDatagrams(RecvBufferChain);
 }
 
@@ -90,6 +122,35 @@ UdpUnreachCallback(
 {
 }
 
+//
+// Fills the buffer with random bytes under a well-formed long header, so the
+// datagram parses as a QUIC Initial with a never-before-seen CID.
+//
+void
+WriteRandomInitial(
+    _Out_writes_bytes_(Length) uint8_t* Buffer,
+    _In_ uint16_t Length,
+    _Inout_ uint64_t* ConnectionId
+    )
+{
+    QuicRandom(Length, Buffer);
+
+    QUIC_LONG_HEADER_V1* Header = (QUIC_LONG_HEADER_V1*)Buffer;
+    Header->IsLongHeader = 1;
+    Header->Type = QUIC_INITIAL;
+    Header->FixedBit = 1;
+    Header->Reserved = 0;
+    Header->Version = QUIC_VERSION_LATEST;
+    Header->DestCidLength = 8;
+    (*ConnectionId)++;
+    QuicCopyMemory(Header->DestCid, ConnectionId, sizeof(*ConnectionId));
+    Header->DestCid[8] = 8;
+    Header->DestCid[17] = 0;
+    QuicVarIntEncode(
+        Length - (MIN_LONG_HEADER_LENGTH_V1 + 19),
+        Header->DestCid + 18);
+}
+
 void
 RunAttackRandom(
     QUIC_DATAPATH_BINDING* Binding,
@@ -122,24 +183,10 @@ RunAttackRandom(
                 return;
             }
 
-            QuicRandom(Length, SendBuffer->Buffer);
-
             if (ValidQuic) {
-                QUIC_LONG_HEADER_V1* Header =
-                    (QUIC_LONG_HEADER_V1*)SendBuffer->Buffer;
-                Header->IsLongHeader = 1;
-                Header->Type = QUIC_INITIAL;
-                Header->FixedBit = 1;
-                Header->Reserved = 0;
-                Header->Version = QUIC_VERSION_LATEST;
-                Header->DestCidLength = 8;
-                ConnectionId++;
-                QuicCopyMemory(Header->DestCid, &ConnectionId, sizeof(ConnectionId));
-                Header->DestCid[8] = 8;
-                Header->DestCid[17] = 0;
-                QuicVarIntEncode(
-                    Length - (MIN_LONG_HEADER_LENGTH_V1 + 19),
-                    Header->DestCid + 18);
+                WriteRandomInitial(SendBuffer->Buffer, Length, &ConnectionId);
+            } else {
+                QuicRandom(Length, SendBuffer->Buffer);
             }
 
             ++PacketCount;
@@ -288,6 +335,327 @@ RunAttackValidInitial(
         PacketCount, (PacketCount * 1000) / QuicTimeDiff64(TimeStart, TimeEnd));
 }
 
+struct BENCHMARK_SEND_CONTEXT {
+    QUIC_DATAPATH_BINDING* Binding;
+    const QUIC_ADDR* ServerAddress;
+    uint64_t RatePps;
+    uint64_t DurationMs;
+};
+
+//
+// Sends random QUIC Initial packets paced to the requested rate for the
+// requested duration.
+//
+QUIC_THREAD_CALLBACK(RunBenchmarkSendThread, _Context)
+{
+    const BENCHMARK_SEND_CONTEXT* Context = (BENCHMARK_SEND_CONTEXT*)_Context;
+
+    uint64_t ConnectionId = 0;
+    QuicRandom(sizeof(ConnectionId), &ConnectionId);
+
+    uint64_t PacketCount = 0;
+    uint64_t TimeStartUs = QuicTimeUs64();
+    while (US_TO_MS(QuicTimeDiff64(TimeStartUs, QuicTimeUs64())) <
+            Context->DurationMs) {
+
+        QUIC_DATAPATH_SEND_CONTEXT* SendContext =
+            QuicDataPathBindingAllocSendContext(
+                Context->Binding, QUIC_MIN_INITIAL_LENGTH);
+        if (SendContext == nullptr) {
+            printf("QuicDataPathBindingAllocSendContext failed\n");
+            break;
+        }
+
+        while (!QuicDataPathBindingIsSendContextFull(SendContext)) {
+            QUIC_BUFFER* SendBuffer =
+                QuicDataPathBindingAllocSendDatagram(
+                    SendContext, QUIC_MIN_INITIAL_LENGTH);
+            if (SendBuffer == nullptr) {
+                printf("QuicDataPathBindingAllocSendDatagram failed\n");
+                QuicDataPathBindingFreeSendContext(SendContext);
+                goto Done;
+            }
+
+            WriteRandomInitial(
+                SendBuffer->Buffer, QUIC_MIN_INITIAL_LENGTH, &ConnectionId);
+            ++PacketCount;
+        }
+
+        if (QUIC_FAILED(
+                QuicDataPathBindingSendTo(
+                    Context->Binding,
+                    Context->ServerAddress,
+                    SendContext))) {
+            break;
+        }
+
+        //
+        // Pace to the step's target rate: if we are ahead of where the rate
+        // says we should be, sleep off the difference.
+        //
+        uint64_t TargetElapsedUs = (PacketCount * 1000000) / Context->RatePps;
+        uint64_t ElapsedUs = QuicTimeDiff64(TimeStartUs, QuicTimeUs64());
+        if (TargetElapsedUs > ElapsedUs + 1000) {
+            QuicSleep((uint32_t)US_TO_MS(TargetElapsedUs - ElapsedUs));
+        }
+    }
+
+Done:
+
+    InterlockedExchangeAdd64(&BenchCounters.PacketsSent, PacketCount);
+    QUIC_THREAD_RETURN(QUIC_STATUS_SUCCESS);
+}
+
+const QUIC_API_TABLE* MsQuic;
+
+struct PROBE_CONTEXT {
+    QUIC_EVENT Complete;
+    bool Connected;
+    uint64_t StartTimeUs;
+    uint64_t ConnectedTimeUs;
+};
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_Function_class_(QUIC_CONNECTION_CALLBACK)
+QUIC_STATUS
+QUIC_API
+ProbeConnectionHandler(
+    _In_ HQUIC Connection,
+    _In_opt_ void* Context,
+    _Inout_ QUIC_CONNECTION_EVENT* Event
+    )
+{
+    PROBE_CONTEXT* Probe = (PROBE_CONTEXT*)Context;
+    switch (Event->Type) {
+    case QUIC_CONNECTION_EVENT_CONNECTED:
+        Probe->ConnectedTimeUs = QuicTimeUs64();
+        Probe->Connected = true;
+        MsQuic->ConnectionShutdown(Connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+        break;
+    case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+        MsQuic->ConnectionClose(Connection);
+        QuicEventSet(Probe->Complete);
+        break;
+    case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
+        return QUIC_STATUS_NOT_SUPPORTED;
+    default:
+        break;
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
+//
+// Runs a single well-behaved client handshake against the server and returns
+// the time it took to connect, or false if it didn't complete in TimeoutMs.
+//
+bool
+RunHandshakeProbe(
+    _In_ HQUIC Registration,
+    _In_z_ const char* Alpn,
+    _In_z_ const char* ServerName,
+    _In_ const QUIC_ADDR* ServerAddress,
+    _In_ uint64_t TimeoutMs,
+    _Out_ uint64_t* LatencyUs
+    )
+{
+    *LatencyUs = 0;
+
+    QUIC_BUFFER AlpnBuffer;
+    AlpnBuffer.Buffer = (uint8_t*)Alpn;
+    AlpnBuffer.Length = (uint32_t)strlen(Alpn);
+
+    HQUIC Session = nullptr;
+    if (QUIC_FAILED(
+            MsQuic->SessionOpen(Registration, &AlpnBuffer, 1, nullptr, &Session))) {
+        printf("Probe SessionOpen failed\n");
+        return false;
+    }
+
+    PROBE_CONTEXT Probe;
+    QuicEventInitialize(&Probe.Complete, FALSE, FALSE);
+    Probe.Connected = false;
+    Probe.StartTimeUs = QuicTimeUs64();
+    Probe.ConnectedTimeUs = 0;
+
+    HQUIC Connection = nullptr;
+    if (QUIC_FAILED(
+            MsQuic->ConnectionOpen(
+                Session, ProbeConnectionHandler, &Probe, &Connection))) {
+        printf("Probe ConnectionOpen failed\n");
+        MsQuic->SessionClose(Session);
+        QuicEventUninitialize(Probe.Complete);
+        return false;
+    }
+
+    //
+    // The idle timeout bounds the probe: a handshake the server can't service
+    // times out and completes the probe as a failure.
+    //
+    (void)MsQuic->SetParam(
+        Connection, QUIC_PARAM_LEVEL_CONNECTION, QUIC_PARAM_CONN_IDLE_TIMEOUT,
+        sizeof(TimeoutMs), &TimeoutMs);
+    (void)MsQuic->SetParam(
+        Connection, QUIC_PARAM_LEVEL_CONNECTION, QUIC_PARAM_CONN_REMOTE_ADDRESS,
+        sizeof(*ServerAddress), ServerAddress);
+
+    if (QUIC_FAILED(
+            MsQuic->ConnectionStart(
+                Connection,
+                QuicAddrGetFamily(ServerAddress),
+                ServerName,
+                QuicAddrGetPort(ServerAddress)))) {
+        printf("Probe ConnectionStart failed\n");
+        MsQuic->ConnectionClose(Connection);
+        MsQuic->SessionClose(Session);
+        QuicEventUninitialize(Probe.Complete);
+        return false;
+    }
+
+    QuicEventWaitForever(Probe.Complete);
+    MsQuic->SessionClose(Session);
+    QuicEventUninitialize(Probe.Complete);
+
+    if (!Probe.Connected) {
+        return false;
+    }
+    *LatencyUs = QuicTimeDiff64(Probe.StartTimeUs, Probe.ConnectedTimeUs);
+    return true;
+}
+
+//
+// Steps the Initial flood rate up, measuring at each step how well the
+// server's stateless responses track the offered load and what a
+// well-behaved client's handshake latency looks like in the meantime.
+//
+void
+RunBenchmark(
+    QUIC_DATAPATH_BINDING* Binding,
+    const QUIC_ADDR* ServerAddress,
+    _In_z_ const char* Alpn,
+    _In_opt_z_ const char* ServerName,
+    uint32_t ThreadCount,
+    uint64_t StartRatePps,
+    uint32_t Steps,
+    uint64_t StepMs
+    )
+{
+    if (ServerName == nullptr) {
+        ServerName = "localhost";
+    }
+
+    HQUIC Registration = nullptr;
+    if (QUIC_FAILED(MsQuicOpen(&MsQuic))) {
+        printf("MsQuicOpen failed\n");
+        return;
+    }
+    const QUIC_REGISTRATION_CONFIG RegConfig =
+        { "quicattack", QUIC_EXECUTION_PROFILE_LOW_LATENCY };
+    if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
+        printf("RegistrationOpen failed\n");
+        MsQuicClose(MsQuic);
+        return;
+    }
+
+    //
+    // Unloaded handshake latency baseline before any attack traffic.
+    //
+    uint64_t BaselineUs = 0;
+    bool BaselineOk =
+        RunHandshakeProbe(
+            Registration, Alpn, ServerName, ServerAddress, StepMs, &BaselineUs);
+    if (BaselineOk) {
+        printf("Baseline handshake: %llu.%03llu ms\n\n",
+            BaselineUs / 1000, BaselineUs % 1000);
+    } else {
+        printf("Baseline handshake FAILED; continuing anyway.\n\n");
+    }
+
+    printf("%12s %12s %12s %7s %14s\n",
+        "Target(pps)", "Sent(pps)", "Resp(pps)", "Resp%", "Handshake(ms)");
+
+    uint64_t DegradedRatePps = 0;
+    uint64_t RatePps = StartRatePps;
+    for (uint32_t Step = 0; Step < Steps; ++Step, RatePps *= 2) {
+
+        BenchCounters.PacketsSent = 0;
+        BenchCounters.ResponsesReceived = 0;
+        BenchCounters.ResponseBytesReceived = 0;
+
+        BENCHMARK_SEND_CONTEXT SendContext = {
+            Binding, ServerAddress, RatePps / ThreadCount, StepMs
+        };
+        if (SendContext.RatePps == 0) {
+            SendContext.RatePps = 1;
+        }
+
+        QUIC_THREAD* Threads =
+            (QUIC_THREAD*)QUIC_ALLOC_PAGED(ThreadCount * sizeof(QUIC_THREAD));
+        uint64_t StepStartUs = QuicTimeUs64();
+        for (uint32_t i = 0; i < ThreadCount; ++i) {
+            QUIC_THREAD_CONFIG ThreadConfig = {
+                0, 0, "BenchmarkRunner", RunBenchmarkSendThread, &SendContext
+            };
+            QuicThreadCreate(&ThreadConfig, &Threads[i]);
+        }
+
+        //
+        // Probe a good-client handshake in the middle of the step, while the
+        // flood is running.
+        //
+        QuicSleep((uint32_t)(StepMs / 4));
+        uint64_t LatencyUs = 0;
+        bool ProbeOk =
+            RunHandshakeProbe(
+                Registration, Alpn, ServerName, ServerAddress, StepMs / 2,
+                &LatencyUs);
+
+        for (uint32_t i = 0; i < ThreadCount; ++i) {
+            QuicThreadWait(&Threads[i]);
+            QuicThreadDelete(&Threads[i]);
+        }
+        QUIC_FREE(Threads);
+        uint64_t StepElapsedUs = QuicTimeDiff64(StepStartUs, QuicTimeUs64());
+
+        uint64_t SentPps =
+            (BenchCounters.PacketsSent * 1000000) / StepElapsedUs;
+        uint64_t RespPps =
+            (BenchCounters.ResponsesReceived * 1000000) / StepElapsedUs;
+        uint64_t RespRatio =
+            BenchCounters.PacketsSent == 0 ?
+                0 :
+                (BenchCounters.ResponsesReceived * 100) /
+                    BenchCounters.PacketsSent;
+
+        char Handshake[32];
+        if (ProbeOk) {
+            snprintf(Handshake, sizeof(Handshake), "%llu.%03llu",
+                LatencyUs / 1000, LatencyUs % 1000);
+        } else {
+            snprintf(Handshake, sizeof(Handshake), "FAILED");
+        }
+        printf("%12llu %12llu %12llu %6llu%% %14s\n",
+            RatePps, SentPps, RespPps, RespRatio, Handshake);
+
+        if (DegradedRatePps == 0 && (RespRatio < 80 || !ProbeOk)) {
+            DegradedRatePps = SentPps;
+        }
+
+        //
+        // Give the server a moment to quiesce between steps.
+        //
+        QuicSleep(500);
+    }
+
+    if (DegradedRatePps != 0) {
+        printf("\nDegradation threshold: ~%llu pps sustained.\n", DegradedRatePps);
+    } else {
+        printf("\nNo degradation observed up to %llu pps.\n", RatePps / 2);
+    }
+
+    MsQuic->RegistrationClose(Registration);
+    MsQuicClose(MsQuic);
+}
+
 struct ATTACK_THREAD_CONTEXT {
     QUIC_DATAPATH_BINDING* Binding;
     uint32_t Type;
@@ -326,7 +694,10 @@ RunAttack(
     const QUIC_ADDR* ServerAddress,
     _In_z_ const char* Alpn,
     _In_opt_z_ const char* ServerName,
-    uint64_t TimeoutMs
+    uint64_t TimeoutMs,
+    uint64_t RatePps,
+    uint32_t Steps,
+    uint64_t StepMs
     )
 {
     QUIC_STATUS Status;
@@ -356,7 +727,11 @@ RunAttack(
         goto Error;
     }
 
-    {
+    if (Type == 5) {
+        RunBenchmark(
+            Binding, ServerAddress, Alpn, ServerName, ThreadCount,
+            RatePps, Steps, StepMs);
+    } else {
         ATTACK_THREAD_CONTEXT ThreadContext = {
             Binding, Type, ServerAddress, Alpn, ServerName, TimeoutMs
         };
@@ -415,7 +790,7 @@ main(
             goto Error;
         }
 
-        if (Type < 1 || Type > 4) {
+        if (Type < 1 || Type > 5) {
             printf("Invalid -type:'%d' specified!\n", Type);
             goto Error;
         }
@@ -432,6 +807,15 @@ main(
         uint32_t ThreadCount = ATTACK_THREADS_DEFAULT;
         (void)TryGetValue(argc, argv, "threads", &ThreadCount);
 
+        uint64_t RatePps = ATTACK_BENCHMARK_RATE_DEFAULT;
+        (void)TryGetValue(argc, argv, "rate", &RatePps);
+
+        uint32_t Steps = ATTACK_BENCHMARK_STEPS_DEFAULT;
+        (void)TryGetValue(argc, argv, "steps", &Steps);
+
+        uint64_t StepMs = ATTACK_BENCHMARK_STEP_MS_DEFAULT;
+        (void)TryGetValue(argc, argv, "stepms", &StepMs);
+
         QUIC_ADDR TargetAddress = {0};
         if (!ConvertArgToAddress(IpAddress, ATTACK_PORT_DEFAULT, &TargetAddress)) {
             printf("Invalid -ip:'%s' specified! Must be IPv4 or IPv6 address and port.\n", IpAddress);
@@ -443,7 +827,9 @@ main(
             goto Error;
         }
 
-        RunAttack(ThreadCount, Type, &TargetAddress, Alpn, ServerName, TimeoutMs);
+        RunAttack(
+            ThreadCount, Type, &TargetAddress, Alpn, ServerName, TimeoutMs,
+            RatePps, Steps, StepMs);
         ErrorCode = 0;
     }
 
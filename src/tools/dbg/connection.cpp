@@ -214,18 +214,29 @@ EXT_COMMAND(
     Dml("\tOutstanding Packets  ");
 
     auto Loss = Conn.GetLossDetection();
-    auto SendPackets = Loss.GetSendPackets();
+    auto SentPacketsRing = Loss.GetSentPacketsRing();
+    auto SentPacketsSize = Loss.SentPacketsSize();
 
-    if (SendPackets == 0) {
+    if (SentPacketsRing == 0 || Loss.SentPacketsCount() == 0) {
         Dml("NONE\n");
     } else {
-        while (SendPackets && !CheckControlC()) {
-            auto Packet = SentPacketMetadata(SendPackets);
+        auto LargestSent = Loss.LargestSentPacketNumber();
+        for (ULONG64 PacketNumber = Loss.LowestTrackedPacketNumber();
+             PacketNumber <= LargestSent && !CheckControlC();
+             PacketNumber++) {
+            ULONG64 PacketAddr;
+            if (!ReadPointerAtAddr(
+                    SentPacketsRing +
+                    (PacketNumber & (SentPacketsSize - 1)) * g_ExtInstance.m_PtrSize,
+                    &PacketAddr) ||
+                PacketAddr == 0) {
+                continue;
+            }
+            auto Packet = SentPacketMetadata(PacketAddr);
             Dml("<link cmd=\"!quicpacket 0x%I64X\">%I64u</link>\n"
                 "\t                     ",
                 Packet.Addr,
                 Packet.PacketNumber());
-            SendPackets = Packet.Next();
         }
         Dml("\n");
     }
@@ -37,6 +37,8 @@ typedef union QUIC_STREAM_FLAGS {
 
         BOOLEAN SendOpen                : 1;    // Send a STREAM frame immediately on start.
         BOOLEAN SendOpenAcked           : 1;    // A STREAM frame has been acknowledged.
+        BOOLEAN SendDelayed             : 1;    // The app wants to delay the send flush, as
+                                                // more data is expected to be queued soon.
 
         BOOLEAN LocalNotAllowed         : 1;    // Peer's unidirectional stream.
         BOOLEAN LocalCloseFin           : 1;    // Locally closed (graceful).
@@ -176,6 +178,24 @@ typedef union QUIC_CONNECTION_STATE {
         //
         BOOLEAN TestTransportParameterSet : 1;
 
+        //
+        // Indicates the connection is using the round robin stream scheduling
+        // scheme.
+        //
+        BOOLEAN UseRoundRobinStreamScheduling : 1;
+
+        //
+        // Indicates stream sends may execute inline on the API thread when
+        // the connection is idle and uncontended.
+        //
+        BOOLEAN InlineApiSend : 1;
+
+        //
+        // Indicates stream receive data is delivered in batched
+        // connection-level events instead of per-stream events.
+        //
+        BOOLEAN BatchedReceiveEnabled : 1;
+
 #ifdef QuicVerifierEnabledByAddr
         //
         // The calling app is being verified (app or driver verifier).
@@ -882,10 +902,26 @@ struct LossDetection : Struct {
         return ReadType<UINT32>("RttVariance"); // Microseconds
     }
 
-    ULONG64 GetSendPackets() {
+    ULONG64 GetSentPacketsRing() {
         return ReadPointer("SentPackets");
     }
 
+    UINT32 SentPacketsSize() {
+        return ReadType<UINT32>("SentPacketsSize");
+    }
+
+    UINT32 SentPacketsCount() {
+        return ReadType<UINT32>("SentPacketsCount");
+    }
+
+    ULONG64 LowestTrackedPacketNumber() {
+        return ReadType<ULONG64>("LowestTrackedPacketNumber");
+    }
+
+    ULONG64 LargestSentPacketNumber() {
+        return ReadType<ULONG64>("LargestSentPacketNumber");
+    }
+
     ULONG64 GetLostPackets() {
         return ReadPointer("LostPackets");
     }
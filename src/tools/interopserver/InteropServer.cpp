@@ -11,10 +11,17 @@ Abstract:
 
 #include "InteropServer.h"
 
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
 const QUIC_API_TABLE* MsQuic;
 QUIC_SEC_CONFIG* SecurityConfig;
 const char* RootFolderPath;
 const char* UploadFolderPath;
+HttpStaticCache* StaticCache;
+
+const char Http11ResponseHeaders[] = "HTTP/1.1 200 OK\r\nConnection: Close\r\n\r\n";
 
 const QUIC_BUFFER SupportedALPNs[] = {
     { sizeof("hq-27") - 1, (uint8_t*)"hq-27" },
@@ -31,7 +38,7 @@ PrintUsage()
            " [-thumbprint:<cert_thumbprint>] [-name:<cert_name>]"
            " [-file:<cert_filepath> AND -key:<cert_key_filepath>]"
            " [-port:<####> (def:%u)]  [-retry:<0/1> (def:%u)]"
-           " [-upload:<path>]\n\n",
+           " [-upload:<path>] [-cache:<0/1>] [-stats:<interval_ms>]\n\n",
            DEFAULT_QUIC_HTTP_SERVER_PORT, DEFAULT_QUIC_HTTP_SERVER_RETRY);
 
     printf("Examples:\n");
@@ -39,6 +46,64 @@ PrintUsage()
     printf("  interopserver.exe -listen:* -retry:1 -thumbprint:175342733b39d81c997817296c9b691172ca6b6e -root:c:\\temp\n");
 }
 
+//
+// Periodically prints the library's global performance counters (as deltas
+// over the interval) along with the current outstanding allocation count, so
+// load and memory growth can be watched while the server is driven externally
+// (e.g. by quicattack's DoS-resilience benchmark).
+//
+
+struct StatsPrinter {
+    QUIC_THREAD Thread;
+    QUIC_EVENT StopEvent;
+    uint32_t IntervalMs;
+};
+
+StatsPrinter StatsContext;
+
+QUIC_THREAD_CALLBACK(StatsPrinterThread, _Context)
+{
+    StatsPrinter* Context = (StatsPrinter*)_Context;
+
+    int64_t Last[QUIC_PERF_COUNTER_MAX] = { 0 };
+    while (!QuicEventWaitWithTimeout(Context->StopEvent, Context->IntervalMs)) {
+
+        int64_t Counters[QUIC_PERF_COUNTER_MAX] = { 0 };
+        uint32_t BufferLength = sizeof(Counters);
+        if (QUIC_FAILED(
+            MsQuic->GetParam(
+                nullptr,
+                QUIC_PARAM_LEVEL_GLOBAL,
+                QUIC_PARAM_GLOBAL_PERF_COUNTERS,
+                &BufferLength,
+                Counters))) {
+            continue;
+        }
+
+        int64_t AllocCount = 0;
+        BufferLength = sizeof(AllocCount);
+        (void)MsQuic->GetParam(
+            nullptr,
+            QUIC_PARAM_LEVEL_GLOBAL,
+            QUIC_PARAM_GLOBAL_TOTAL_ALLOC_COUNT,
+            &BufferLength,
+            &AllocCount);
+
+        printf("STATS: conn+%lld/-%lld hsfail+%lld pkts rx+%lld tx+%lld dropped+%lld allocs=%lld\n",
+            (long long)(Counters[QUIC_PERF_COUNTER_CONN_CREATED] - Last[QUIC_PERF_COUNTER_CONN_CREATED]),
+            (long long)(Counters[QUIC_PERF_COUNTER_CONN_DESTROYED] - Last[QUIC_PERF_COUNTER_CONN_DESTROYED]),
+            (long long)(Counters[QUIC_PERF_COUNTER_CONN_HANDSHAKE_FAIL] - Last[QUIC_PERF_COUNTER_CONN_HANDSHAKE_FAIL]),
+            (long long)(Counters[QUIC_PERF_COUNTER_PKTS_RECV] - Last[QUIC_PERF_COUNTER_PKTS_RECV]),
+            (long long)(Counters[QUIC_PERF_COUNTER_PKTS_SENT] - Last[QUIC_PERF_COUNTER_PKTS_SENT]),
+            (long long)(Counters[QUIC_PERF_COUNTER_OPER_DROPPED] - Last[QUIC_PERF_COUNTER_OPER_DROPPED]),
+            (long long)AllocCount);
+
+        memcpy(Last, Counters, sizeof(Last));
+    }
+
+    QUIC_THREAD_RETURN(QUIC_STATUS_SUCCESS);
+}
+
 int
 QUIC_MAIN_EXPORT
 main(
@@ -70,6 +135,8 @@ main(
         printf("Enabling forced RETRY on server.\n");
     }
     TryGetValue(argc, argv, "upload", &UploadFolderPath);
+    uint32_t StatsIntervalMs = 0;
+    TryGetValue(argc, argv, "stats", &StatsIntervalMs);
 
     //
     // Required parameters.
@@ -86,6 +153,21 @@ main(
         return -1;
     }
 
+    BOOLEAN Cache = FALSE;
+    TryGetValue(argc, argv, "cache", &Cache);
+    if (Cache) {
+        //
+        // Preload the content directory into preframed in-memory buffers, so
+        // requests are served straight from memory instead of benchmarking
+        // the filesystem.
+        //
+        StaticCache = new HttpStaticCache;
+        if (!StaticCache->Load(RootFolderPath)) {
+            printf("Failed to cache any files from '%s'!\n", RootFolderPath);
+            return -1;
+        }
+    }
+
     const char* CertThumbprint = nullptr;
     const char* CertName = nullptr;
     const char* CertFile = nullptr;
@@ -114,12 +196,33 @@ main(
         return -1;
     }
 
+    bool StatsRunning = false;
+    if (StatsIntervalMs != 0) {
+        StatsContext.IntervalMs = StatsIntervalMs;
+        QuicEventInitialize(&StatsContext.StopEvent, FALSE, FALSE);
+        QUIC_THREAD_CONFIG ThreadConfig = {
+            0, 0, "StatsPrinter", StatsPrinterThread, &StatsContext
+        };
+        StatsRunning = QUIC_SUCCEEDED(QuicThreadCreate(&ThreadConfig, &StatsContext.Thread));
+        if (!StatsRunning) {
+            QuicEventUninitialize(StatsContext.StopEvent);
+            printf("Failed to start the stats printer!\n");
+        }
+    }
+
     {
         HttpSession Session(Registration, SupportedALPNs, ARRAYSIZE(SupportedALPNs), &ListenAddr);
         printf("Press Enter to exit.\n\n");
         getchar();
     }
 
+    if (StatsRunning) {
+        QuicEventSet(StatsContext.StopEvent);
+        QuicThreadWait(&StatsContext.Thread);
+        QuicThreadDelete(&StatsContext.Thread);
+        QuicEventUninitialize(StatsContext.StopEvent);
+    }
+
     MsQuic->SecConfigDelete(SecurityConfig);
     MsQuic->RegistrationClose(Registration);
     MsQuicClose(MsQuic);
@@ -127,6 +230,124 @@ main(
     return 0;
 }
 
+//
+// HttpStaticCache
+//
+
+void
+HttpStaticCache::AddFile(const char* RootPath, const char* FileName)
+{
+    char FullFilePath[256];
+    if (snprintf(FullFilePath, sizeof(FullFilePath), "%s/%s", RootPath, FileName) < 0) {
+        return;
+    }
+
+    FILE* File = fopen(FullFilePath, "rb");
+    if (File == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    _fseeki64(File, 0, SEEK_END);
+    int64_t FileSize = _ftelli64(File);
+    _fseeki64(File, 0, SEEK_SET);
+#else
+    fseeko(File, 0, SEEK_END);
+    int64_t FileSize = ftello(File);
+    fseeko(File, 0, SEEK_SET);
+#endif
+    if (FileSize < 0) {
+        fclose(File);
+        return;
+    }
+
+    uint8_t* Data = nullptr;
+    if (FileSize != 0) {
+        Data = (uint8_t*)malloc((size_t)FileSize);
+        if (Data == nullptr ||
+            fread(Data, 1, (size_t)FileSize, File) != (size_t)FileSize) {
+            free(Data); // Includes directories, which fail the read.
+            fclose(File);
+            return;
+        }
+    }
+    fclose(File);
+
+    //
+    // Preframe the content: one leading buffer for the HTTP/1.1 response
+    // header, then one buffer per CACHE_CHUNK_SIZE sized chunk.
+    //
+    uint32_t ChunkCount =
+        (uint32_t)((FileSize + CACHE_CHUNK_SIZE - 1) / CACHE_CHUNK_SIZE);
+    QUIC_BUFFER* Buffers = new QUIC_BUFFER[1 + ChunkCount];
+    Buffers[0].Length = sizeof(Http11ResponseHeaders);
+    Buffers[0].Buffer = (uint8_t*)Http11ResponseHeaders;
+    uint64_t Offset = 0;
+    for (uint32_t i = 0; i < ChunkCount; ++i) {
+        uint64_t Remaining = (uint64_t)FileSize - Offset;
+        Buffers[1 + i].Length =
+            Remaining < CACHE_CHUNK_SIZE ? (uint32_t)Remaining : CACHE_CHUNK_SIZE;
+        Buffers[1 + i].Buffer = Data + Offset;
+        Offset += Buffers[1 + i].Length;
+    }
+
+    char* Path = (char*)malloc(strlen(FileName) + 2);
+    if (Path == nullptr) {
+        delete [] Buffers;
+        free(Data);
+        return;
+    }
+    Path[0] = '/';
+    strcpy(Path + 1, FileName);
+
+    HttpStaticFile* Entry = new HttpStaticFile;
+    Entry->Path = Path;
+    Entry->Data = Data;
+    Entry->Length = (uint64_t)FileSize;
+    Entry->BufferCount = 1 + ChunkCount;
+    Entry->Buffers = Buffers;
+    Entry->Next = Files;
+    Files = Entry;
+
+    printf("Cached '%s' (%llu bytes, %u chunks)\n",
+        Path, (unsigned long long)FileSize, ChunkCount);
+}
+
+bool
+HttpStaticCache::Load(const char* RootPath)
+{
+#ifdef _WIN32
+    char SearchPath[256];
+    if (snprintf(SearchPath, sizeof(SearchPath), "%s\\*", RootPath) < 0) {
+        return false;
+    }
+    WIN32_FIND_DATAA FindData;
+    HANDLE FindHandle = FindFirstFileA(SearchPath, &FindData);
+    if (FindHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if (!(FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            AddFile(RootPath, FindData.cFileName);
+        }
+    } while (FindNextFileA(FindHandle, &FindData));
+    FindClose(FindHandle);
+#else
+    DIR* Dir = opendir(RootPath);
+    if (Dir == nullptr) {
+        return false;
+    }
+    struct dirent* Entry;
+    while ((Entry = readdir(Dir)) != nullptr) {
+        if (Entry->d_name[0] != '.') {
+            AddFile(RootPath, Entry->d_name);
+        }
+    }
+    closedir(Dir);
+#endif
+    return Files != nullptr;
+}
+
 //
 // HttpRequest
 //
@@ -196,11 +417,45 @@ HttpRequest::Process()
     }
 
     printf("[%s] GET '%s'\n", GetRemoteAddr(MsQuic, QuicStream).Address, PathStart);
-    File = fopen(FullFilePath, "rb"); // In case of failure, SendData still works.
+
+    if (StaticCache != nullptr) {
+        const HttpStaticFile* CachedFile = StaticCache->Find(PathStart);
+        if (CachedFile != nullptr) {
+            SendCachedData(CachedFile);
+            return;
+        }
+        //
+        // Not preloaded; fall through so SendData sends the failure response.
+        //
+    } else {
+        File = fopen(FullFilePath, "rb"); // In case of failure, SendData still works.
+    }
 
     SendData();
 }
 
+void
+HttpRequest::SendCachedData(const HttpStaticFile* CachedFile)
+{
+    //
+    // The whole response (and the FIN) is queued with a single send that
+    // references the preframed cached buffers; nothing is read or copied per
+    // request.
+    //
+    Shutdown = true;
+    if (QUIC_FAILED(
+        MsQuic->StreamSend(
+            QuicStream,
+            WriteHttp11Header ? CachedFile->Buffers : CachedFile->Buffers + 1,
+            WriteHttp11Header ? CachedFile->BufferCount : CachedFile->BufferCount - 1,
+            QUIC_SEND_FLAG_FIN,
+            this))) {
+        printf("[%s] Send failed\n", GetRemoteAddr(MsQuic, QuicStream).Address);
+        Abort();
+    }
+    WriteHttp11Header = false;
+}
+
 void
 HttpRequest::SendData()
 {
@@ -212,7 +467,6 @@ HttpRequest::SendData()
 
     if (File) {
         if (WriteHttp11Header) {
-            const char Http11ResponseHeaders[] = "HTTP/1.1 200 OK\r\nConnection: Close\r\n\r\n";
             Buffer.Write(Http11ResponseHeaders, sizeof(Http11ResponseHeaders));
             WriteHttp11Header = false;
         }
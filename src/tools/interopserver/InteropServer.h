@@ -12,6 +12,9 @@
 extern const QUIC_API_TABLE* MsQuic;
 extern QUIC_SEC_CONFIG* SecurityConfig;
 
+struct HttpStaticCache;
+extern HttpStaticCache* StaticCache;
+
 //
 // The default port used for connecting with QuicHttpServer.
 //
@@ -32,6 +35,13 @@ extern QUIC_SEC_CONFIG* SecurityConfig;
 //
 #define IO_SIZE 64 * 1024
 
+//
+// Chunk size for the preframed cached content; roughly one full packet's
+// worth of stream payload on a typical 1500 byte MTU path, so each cached
+// QUIC_BUFFER maps onto about one packet on the wire.
+//
+#define CACHE_CHUNK_SIZE 1400
+
 //
 // Exits if there is a failure.
 //
@@ -63,6 +73,40 @@ struct HttpSendBuffer {
     }
 };
 
+//
+// A file preloaded into memory and preframed into CACHE_CHUNK_SIZE sized
+// QUIC_BUFFER chunks, so requests are served by a single StreamSend call
+// referencing the cached memory directly. Buffers[0] holds the HTTP/1.1
+// response header; HTTP 0.9 requests send from Buffers[1] onwards.
+//
+struct HttpStaticFile {
+    HttpStaticFile* Next;
+    const char* Path; // Request path, e.g. "/index.html".
+    uint8_t* Data;
+    uint64_t Length;
+    uint32_t BufferCount;
+    QUIC_BUFFER* Buffers;
+};
+
+//
+// The set of preloaded files, built once at startup (enabled with '-cache')
+// and immutable (so requiring no synchronization) from then on.
+//
+struct HttpStaticCache {
+    HttpStaticFile* Files = nullptr;
+    bool Load(const char* RootPath);
+    const HttpStaticFile* Find(const char* Path) const {
+        for (auto File = Files; File != nullptr; File = File->Next) {
+            if (strcmp(File->Path, Path) == 0) {
+                return File;
+            }
+        }
+        return nullptr;
+    }
+private:
+    void AddFile(const char* RootPath, const char* FileName);
+};
+
 struct HttpConnection;
 
 struct HttpRequest {
@@ -85,6 +129,7 @@ private:
     }
     void Process();
     void SendData();
+    void SendCachedData(const HttpStaticFile* CachedFile);
     bool ReceiveUniDiData(
         _In_ const QUIC_BUFFER* Buffers,
         _In_ uint32_t BufferCount
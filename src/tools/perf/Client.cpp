@@ -0,0 +1,680 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    QUIC performance benchmark client implementation. Supports three modes:
+
+    Throughput - Every connection opens the configured number of streams, each
+    sending one request and waiting for the complete response. Reports the
+    aggregate transfer rate once everything completes.
+
+    RPS - Every connection keeps the configured number of requests outstanding
+    for the configured duration, restarting each request as it completes.
+    Reports the request rate and latency percentiles.
+
+    HPS - Keeps the configured number of connection attempts outstanding for
+    the configured duration, immediately shutting each connection down once
+    the handshake completes. Reports the handshake rate.
+
+--*/
+
+#include "QuicPerf.h"
+
+struct PerfTracker {
+
+    long RefCount;
+
+    uint64_t BytesReceived;
+
+    uint64_t StartTime;
+    uint64_t CompleteTime;
+
+    QUIC_EVENT Done;
+
+    PerfTracker() :
+        RefCount(1), BytesReceived(0), StartTime(0), CompleteTime(0) {
+        QuicEventInitialize(&Done, FALSE, FALSE);
+    }
+
+    ~PerfTracker() {
+        QuicEventUninitialize(Done);
+    }
+
+    void
+    Start() {
+        StartTime = QuicTimeUs64();
+    }
+
+    bool
+    Wait(
+        uint32_t Milliseconds
+        ) {
+        if (InterlockedDecrement(&RefCount) == 0) {
+            CompleteTime = QuicTimeUs64();
+            return true;
+        } else {
+            return !QuicEventWaitWithTimeout(Done, Milliseconds);
+        }
+    }
+
+    void
+    AddItem() {
+        InterlockedIncrement(&RefCount);
+    }
+
+    void
+    CompleteItem(
+        uint64_t Received
+        ) {
+        InterlockedExchangeAdd64((int64_t*)&BytesReceived, (int64_t)Received);
+        if (InterlockedDecrement(&RefCount) == 0) {
+            CompleteTime = QuicTimeUs64();
+            QuicEventSet(Done);
+        }
+    }
+};
+
+//
+// Set while the rate based (RPS/HPS) measurement window is open.
+//
+static volatile long PerfRunning = 0;
+
+//
+// Counters and latency samples for the rate based modes.
+//
+static int64_t RequestsCompleted = 0;
+static int64_t HandshakesCompleted = 0;
+static uint32_t* LatencySamples = nullptr;
+static long LatencySampleCount = 0;
+
+struct PerfClientConnection;
+
+struct PerfClientStream {
+
+    PerfClientConnection* Connection;
+    HQUIC QuicStream;
+
+    uint64_t StartTime;
+    uint64_t BytesReceived;
+
+    //
+    // Request send state. The header holds the (little endian) response
+    // length the server should send back.
+    //
+    uint8_t Header[PERF_REQUEST_HEADER_SIZE];
+    bool HeaderQueued;
+    uint64_t SendRemaining;
+    uint32_t OutstandingSends;
+
+    //
+    // The QUIC_BUFFERs passed to StreamSend must stay valid until the send
+    // completes, so each outstanding send owns one of these slots. A slot
+    // with a zero Length is free.
+    //
+    QUIC_BUFFER SendBuffers[PERF_MAX_OUTSTANDING_IO];
+
+    PerfClientStream(
+        _In_ PerfClientConnection* Connection
+        ) : Connection(Connection), QuicStream(nullptr), StartTime(0),
+            BytesReceived(0), HeaderQueued(false),
+            SendRemaining(PerfConfig.Client.RequestSize), OutstandingSends(0) {
+        memset(SendBuffers, 0, sizeof(SendBuffers));
+        uint64_t ResponseSize = PerfConfig.Client.ResponseSize;
+        for (uint32_t i = 0; i < PERF_REQUEST_HEADER_SIZE; ++i) {
+            Header[i] = (uint8_t)(ResponseSize >> (i * 8));
+        }
+    }
+
+    ~PerfClientStream() {
+        if (QuicStream != nullptr) {
+            MsQuic->StreamClose(QuicStream);
+        }
+    }
+
+    bool Start(HQUIC QuicConnection) {
+        if (QUIC_FAILED(
+            MsQuic->StreamOpen(
+                QuicConnection,
+                QUIC_STREAM_OPEN_FLAG_NONE,
+                QuicCallbackHandler,
+                this,
+                &QuicStream))) {
+            printf("MsQuic->StreamOpen failed!\n");
+            return false;
+        }
+        StartTime = QuicTimeUs64();
+        if (QUIC_FAILED(
+            MsQuic->StreamStart(
+                QuicStream,
+                QUIC_STREAM_START_FLAG_NONE))) {
+            printf("MsQuic->StreamStart failed!\n");
+            return false;
+        }
+        QueueSends();
+        return true;
+    }
+
+    void
+    QueueSends() {
+        while ((!HeaderQueued || SendRemaining != 0) &&
+               OutstandingSends < PERF_MAX_OUTSTANDING_IO) {
+            QUIC_BUFFER* Buffer = SendBuffers;
+            while (Buffer->Length != 0) {
+                ++Buffer;
+            }
+            if (!HeaderQueued) {
+                Buffer->Buffer = Header;
+                Buffer->Length = PERF_REQUEST_HEADER_SIZE;
+                HeaderQueued = true;
+            } else {
+                Buffer->Buffer = PerfPayloadBuffer;
+                Buffer->Length =
+                    SendRemaining < PERF_IO_SIZE ?
+                        (uint32_t)SendRemaining : PERF_IO_SIZE;
+                SendRemaining -= Buffer->Length;
+            }
+
+            QUIC_SEND_FLAGS Flags =
+                SendRemaining == 0 ? QUIC_SEND_FLAG_FIN : QUIC_SEND_FLAG_NONE;
+
+            OutstandingSends++;
+            if (QUIC_FAILED(
+                MsQuic->StreamSend(QuicStream, Buffer, 1, Flags, Buffer))) {
+                Buffer->Length = 0;
+                OutstandingSends--;
+                MsQuic->StreamShutdown(
+                    QuicStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+                break;
+            }
+        }
+    }
+
+    void
+    OnResponseComplete() {
+        if (PerfConfig.Client.Mode == PerfModeRps) {
+            InterlockedIncrement64(&RequestsCompleted);
+            uint64_t Latency = QuicTimeUs64() - StartTime;
+            long Index = InterlockedIncrement(&LatencySampleCount) - 1;
+            if (Index < PERF_MAX_LATENCY_SAMPLES) {
+                LatencySamples[Index] =
+                    Latency > UINT32_MAX ? UINT32_MAX : (uint32_t)Latency;
+            }
+        }
+    }
+
+    void
+    ProcessEvent(
+        _Inout_ QUIC_STREAM_EVENT* Event
+        );
+
+    static
+    QUIC_STATUS
+    QUIC_API
+    QuicCallbackHandler(
+        _In_ HQUIC /* Stream */,
+        _In_opt_ void* Context,
+        _Inout_ QUIC_STREAM_EVENT* Event
+        ) {
+        PerfClientStream *pThis = (PerfClientStream*)Context;
+        pThis->ProcessEvent(Event);
+        return QUIC_STATUS_SUCCESS;
+    }
+};
+
+struct PerfClientConnection {
+
+    PerfTracker* Tracker;
+    HQUIC QuicConnection;
+
+    uint32_t ActiveStreams;
+    uint64_t BytesReceived;
+
+    PerfClientConnection(
+        _In_ PerfTracker* Tracker
+        ) : Tracker(Tracker), QuicConnection(nullptr), ActiveStreams(0),
+            BytesReceived(0) {
+        if (QUIC_FAILED(
+            MsQuic->ConnectionOpen(
+                Session,
+                QuicCallbackHandler,
+                this,
+                &QuicConnection))) {
+            printf("Failed to open connection!\n");
+        }
+    }
+
+    ~PerfClientConnection() {
+        if (QuicConnection != nullptr) {
+            MsQuic->ConnectionClose(QuicConnection);
+        }
+    }
+
+    static HQUIC Session;
+
+    bool Initialize() {
+        if (QuicConnection == nullptr) {
+            return false;
+        }
+
+        if (QUIC_FAILED(
+            MsQuic->SetParam(
+                QuicConnection,
+                QUIC_PARAM_LEVEL_CONNECTION,
+                QUIC_PARAM_CONN_IDLE_TIMEOUT,
+                sizeof(uint64_t),
+                &PerfConfig.IdleTimeout))) {
+            printf("Failed to set the idle timeout!\n");
+            return false;
+        }
+
+        uint32_t SecFlags = QUIC_CERTIFICATE_FLAG_DISABLE_CERT_VALIDATION;
+        if (QUIC_FAILED(
+            MsQuic->SetParam(
+                QuicConnection,
+                QUIC_PARAM_LEVEL_CONNECTION,
+                QUIC_PARAM_CONN_CERT_VALIDATION_FLAGS,
+                sizeof(SecFlags),
+                &SecFlags))) {
+            printf("Failed to set the cert validation flags!\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Connect() {
+        if (QuicAddrGetFamily(&PerfConfig.LocalIpAddr) != AF_UNSPEC) {
+            MsQuic->SetParam(
+                QuicConnection,
+                QUIC_PARAM_LEVEL_CONNECTION,
+                QUIC_PARAM_CONN_LOCAL_ADDRESS,
+                sizeof(PerfConfig.LocalIpAddr),
+                &PerfConfig.LocalIpAddr);
+        }
+
+        if (PerfConfig.Client.UseExplicitRemoteAddr) {
+            MsQuic->SetParam(
+                QuicConnection,
+                QUIC_PARAM_LEVEL_CONNECTION,
+                QUIC_PARAM_CONN_REMOTE_ADDRESS,
+                sizeof(PerfConfig.Client.RemoteIpAddr),
+                &PerfConfig.Client.RemoteIpAddr);
+        }
+
+        Tracker->AddItem();
+        if (QUIC_FAILED(
+            MsQuic->ConnectionStart(
+                QuicConnection,
+                QuicAddrGetFamily(&PerfConfig.Client.RemoteIpAddr),
+                PerfConfig.Client.Target,
+                QuicAddrGetPort(&PerfConfig.Client.RemoteIpAddr)))) {
+            Tracker->CompleteItem(0);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool
+    StartStream() {
+        auto Stream = new PerfClientStream(this);
+        if (!Stream->Start(QuicConnection)) {
+            delete Stream;
+            return false;
+        }
+        ActiveStreams++;
+        return true;
+    }
+
+    void
+    OnStreamShutdownComplete(
+        _In_ PerfClientStream* Stream
+        ) {
+        ActiveStreams--;
+        BytesReceived += Stream->BytesReceived;
+
+        if (PerfConfig.Client.Mode == PerfModeRps && PerfRunning) {
+            //
+            // Keep the request pipeline full for the rest of the measurement
+            // window.
+            //
+            StartStream();
+        }
+
+        if (ActiveStreams == 0) {
+            MsQuic->ConnectionShutdown(
+                QuicConnection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+        }
+    }
+
+    void
+    ProcessEvent(
+        _Inout_ QUIC_CONNECTION_EVENT* Event
+        ) {
+        switch (Event->Type) {
+        case QUIC_CONNECTION_EVENT_CONNECTED:
+            if (PerfConfig.Client.Mode == PerfModeHps) {
+                InterlockedIncrement64(&HandshakesCompleted);
+                MsQuic->ConnectionShutdown(
+                    QuicConnection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            } else {
+                for (uint32_t i = 0; i < PerfConfig.Client.StreamCount; i++) {
+                    if (!StartStream()) {
+                        break;
+                    }
+                }
+            }
+            break;
+
+        case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
+            if (Event->SHUTDOWN_INITIATED_BY_TRANSPORT.Status != QUIC_STATUS_SUCCESS) {
+                printf("Connection shutdown by transport: %s (0x%x).\n",
+                    QuicStatusToString(Event->SHUTDOWN_INITIATED_BY_TRANSPORT.Status),
+                    Event->SHUTDOWN_INITIATED_BY_TRANSPORT.Status);
+            }
+            break;
+
+        case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+            if (PerfConfig.Client.Mode == PerfModeHps && PerfRunning) {
+                //
+                // Keep the handshake pipeline full for the rest of the
+                // measurement window.
+                //
+                auto Connection = new PerfClientConnection(Tracker);
+                if (!Connection->Initialize() || !Connection->Connect()) {
+                    delete Connection;
+                }
+            }
+            Tracker->CompleteItem(BytesReceived);
+            delete this;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    static
+    QUIC_STATUS
+    QUIC_API
+    QuicCallbackHandler(
+        _In_ HQUIC /* Connection */,
+        _In_opt_ void* Context,
+        _Inout_ QUIC_CONNECTION_EVENT* Event
+        ) {
+        PerfClientConnection *pThis = (PerfClientConnection*)Context;
+        pThis->ProcessEvent(Event);
+        return QUIC_STATUS_SUCCESS;
+    }
+};
+
+HQUIC PerfClientConnection::Session = nullptr;
+
+void
+PerfClientStream::ProcessEvent(
+    _Inout_ QUIC_STREAM_EVENT* Event
+    ) {
+    switch (Event->Type) {
+    case QUIC_STREAM_EVENT_RECEIVE:
+        BytesReceived += Event->RECEIVE.TotalBufferLength;
+        break;
+    case QUIC_STREAM_EVENT_SEND_COMPLETE:
+        ((QUIC_BUFFER*)Event->SEND_COMPLETE.ClientContext)->Length = 0;
+        OutstandingSends--;
+        QueueSends();
+        break;
+    case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
+        //
+        // The full response has arrived.
+        //
+        OnResponseComplete();
+        break;
+    case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
+    case QUIC_STREAM_EVENT_PEER_RECEIVE_ABORTED:
+        MsQuic->StreamShutdown(
+            QuicStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+        break;
+    case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+        Connection->OnStreamShutdownComplete(this);
+        delete this;
+        break;
+    default:
+        break;
+    }
+}
+
+static
+int
+LatencySampleCompare(
+    const void* A,
+    const void* B
+    ) {
+    uint32_t ValueA = *(const uint32_t*)A;
+    uint32_t ValueB = *(const uint32_t*)B;
+    return ValueA < ValueB ? -1 : (ValueA > ValueB ? 1 : 0);
+}
+
+static
+void
+PrintLatencyPercentiles() {
+    long Count = LatencySampleCount;
+    if (Count > PERF_MAX_LATENCY_SAMPLES) {
+        Count = PERF_MAX_LATENCY_SAMPLES;
+    }
+    if (Count == 0) {
+        return;
+    }
+
+    qsort(LatencySamples, Count, sizeof(uint32_t), LatencySampleCompare);
+
+    const double Percentiles[] = { 50, 90, 99, 99.9 };
+    printf("Latency (us): min=%u", LatencySamples[0]);
+    for (uint32_t i = 0; i < ARRAYSIZE(Percentiles); i++) {
+        long Index = (long)((Percentiles[i] / 100) * Count);
+        if (Index >= Count) {
+            Index = Count - 1;
+        }
+        printf(" %g%%=%u", Percentiles[i], LatencySamples[Index]);
+    }
+    printf(" max=%u (%ld samples)\n", LatencySamples[Count - 1], Count);
+}
+
+//
+// Enables or disables the library's receive stage profiling.
+//
+static
+void
+SetPacketProfiling(bool Enabled) {
+    uint8_t Value = Enabled ? TRUE : FALSE;
+    if (QUIC_FAILED(
+        MsQuic->SetParam(
+            nullptr,
+            QUIC_PARAM_LEVEL_GLOBAL,
+            QUIC_PARAM_GLOBAL_PACKET_PROFILING,
+            sizeof(Value),
+            &Value))) {
+        printf("Failed to set packet stage profiling!\n");
+    }
+}
+
+//
+// Snapshots the registration's perf event rings and prints the average
+// receive cost per packet, in CPU cycles, broken down by stage.
+//
+static
+void
+PrintPacketProfile() {
+    uint32_t BufferLength = 0;
+    if (MsQuic->GetParam(
+            Registration,
+            QUIC_PARAM_LEVEL_REGISTRATION,
+            QUIC_PARAM_REGISTRATION_PERF_EVENTS,
+            &BufferLength,
+            nullptr) != QUIC_STATUS_BUFFER_TOO_SMALL) {
+        return;
+    }
+
+    auto Events = (QUIC_PERF_EVENT*)new uint8_t[BufferLength];
+    if (QUIC_FAILED(
+        MsQuic->GetParam(
+            Registration,
+            QUIC_PARAM_LEVEL_REGISTRATION,
+            QUIC_PARAM_REGISTRATION_PERF_EVENTS,
+            &BufferLength,
+            Events))) {
+        delete[] (uint8_t*)Events;
+        return;
+    }
+
+    uint64_t Parse = 0, Crypto = 0, Frames = 0, Ack = 0;
+    uint32_t Windows = 0;
+    uint32_t EventCount = BufferLength / sizeof(QUIC_PERF_EVENT);
+    for (uint32_t i = 0; i < EventCount; i++) {
+        if (Events[i].Type != QUIC_PERF_EVENT_RX_STAGES) {
+            continue;
+        }
+        Parse += Events[i].Value & 0xFFFF;
+        Crypto += (Events[i].Value >> 16) & 0xFFFF;
+        Frames += (Events[i].Value >> 32) & 0xFFFF;
+        Ack += Events[i].Value >> 48;
+        Windows++;
+    }
+
+    if (Windows != 0) {
+        //
+        // The frame stage includes the ACK processing reported separately.
+        //
+        printf("RX cycles/packet: parse=%llu crypto=%llu frames=%llu (ack=%llu) over %u sample windows\n",
+            (unsigned long long)(Parse / Windows),
+            (unsigned long long)(Crypto / Windows),
+            (unsigned long long)(Frames / Windows),
+            (unsigned long long)(Ack / Windows),
+            Windows);
+    } else {
+        printf("RX cycles/packet: no samples recorded.\n");
+    }
+
+    delete[] (uint8_t*)Events;
+}
+
+void QuicPerfClientRun()
+{
+    PerfTracker Tracker;
+    bool RateMode = PerfConfig.Client.Mode != PerfModeThroughput;
+
+    if (PerfConfig.Client.Mode == PerfModeRps) {
+        LatencySamples = new uint32_t[PERF_MAX_LATENCY_SAMPLES];
+    }
+
+    {
+        QuicSession Session;
+        if (QUIC_FAILED(
+            MsQuic->SessionOpen(
+                Registration,
+                &PerfConfig.ALPN,
+                1,
+                NULL,
+                &Session.Handle))) {
+            printf("MsQuic->SessionOpen failed!\n");
+            return;
+        }
+        PerfClientConnection::Session = Session.Handle;
+
+        auto Connections = new PerfClientConnection*[PerfConfig.Client.ConnectionCount];
+        for (uint32_t i = 0; i < PerfConfig.Client.ConnectionCount; i++) {
+            Connections[i] = new PerfClientConnection(&Tracker);
+            if (!Connections[i]->Initialize()) {
+                delete Connections[i];
+                delete[] Connections;
+                return;
+            }
+        }
+
+        PerfRunning = 1;
+        Tracker.Start();
+
+        if (PerfConfig.Client.PacketProfile) {
+            SetPacketProfiling(true);
+        }
+
+        PERF_CPU_STATE CpuStart;
+        PerfCpuSnapshot(&CpuStart);
+
+        //
+        // Start connecting to the remote server.
+        //
+        for (uint32_t i = 0; i < PerfConfig.Client.ConnectionCount; i++) {
+            if (!Connections[i]->Connect()) {
+                delete Connections[i];
+            }
+        }
+
+        delete[] Connections;
+
+        if (RateMode) {
+            //
+            // Let the configured measurement window elapse, then tear
+            // everything down.
+            //
+            QuicSleep(PerfConfig.Client.Duration * 1000);
+            PerfRunning = 0;
+            Session.Cancel();
+            Tracker.Wait(PERF_DEFAULT_WAIT_TIMEOUT);
+        } else {
+            if (Tracker.Wait(PERF_DEFAULT_WAIT_TIMEOUT)) {
+                Session.Cancel();
+            }
+            PerfRunning = 0;
+        }
+
+        PERF_CPU_STATE CpuEnd;
+        PerfCpuSnapshot(&CpuEnd);
+
+        uint64_t ElapsedMicroseconds = Tracker.CompleteTime - Tracker.StartTime;
+        if (ElapsedMicroseconds == 0) {
+            ElapsedMicroseconds = 1;
+        }
+
+        switch (PerfConfig.Client.Mode) {
+        case PerfModeThroughput: {
+            uint32_t RecvRate =
+                (uint32_t)((Tracker.BytesReceived * 1000 * 1000 * 8) /
+                           (1000 * ElapsedMicroseconds));
+            printf("Received %llu bytes in %u.%u ms @ %u kbps.\n",
+                (unsigned long long)Tracker.BytesReceived,
+                (uint32_t)(ElapsedMicroseconds / 1000),
+                (uint32_t)(ElapsedMicroseconds % 1000),
+                RecvRate);
+            break;
+        }
+        case PerfModeRps:
+            printf("Completed %lld requests in %u seconds (%llu RPS).\n",
+                (long long)RequestsCompleted,
+                PerfConfig.Client.Duration,
+                (unsigned long long)
+                    ((RequestsCompleted * 1000 * 1000) / ElapsedMicroseconds));
+            PrintLatencyPercentiles();
+            break;
+        case PerfModeHps:
+            printf("Completed %lld handshakes in %u seconds (%llu HPS).\n",
+                (long long)HandshakesCompleted,
+                PerfConfig.Client.Duration,
+                (unsigned long long)
+                    ((HandshakesCompleted * 1000 * 1000) / ElapsedMicroseconds));
+            break;
+        }
+
+        PerfCpuPrintUsage(&CpuStart, &CpuEnd);
+
+        if (PerfConfig.Client.PacketProfile) {
+            PrintPacketProfile();
+            SetPacketProfiling(false);
+        }
+    }
+
+    delete[] LatencySamples;
+    LatencySamples = nullptr;
+}
@@ -0,0 +1,408 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    QUIC performance benchmark tool. Supports modes for bulk throughput,
+    requests per second (with latency percentiles), and handshakes per
+    second; and attributes per-core CPU usage to each run.
+
+--*/
+
+#include "QuicPerf.h"
+
+const QUIC_API_TABLE* MsQuic;
+HQUIC Registration;
+QUIC_SEC_CONFIG* SecurityConfig;
+QUIC_PERF_CONFIG PerfConfig;
+uint8_t* PerfPayloadBuffer;
+
+extern "C" void QuicTraceRundown(void) { }
+
+void
+PrintUsage()
+{
+    printf("quicperf is a performance benchmark tool for the QUIC networking protocol.\n");
+
+    printf("\n  quicperf.exe [options]\n");
+
+    printf("\nServer options:\n");
+    printf(
+        "  -listen:<addr or *>         The local IP address to listen on, or * for all IP addresses.\n"
+        "  -thumbprint:<cert_hash>     The hash or thumbprint of the certificate to use.\n"
+        "  -cert_store:<store name>    The certificate store to search for the thumbprint in.\n"
+        "  -machine_cert:<0/1>         Use the machine, or current user's, certificate store. (def:0)\n"
+        "  -peer_bidi:<####>           The number of bidirectional streams the peer may open. (def:%u)\n",
+        PERF_DEFAULT_PEER_BIDI_STREAM_COUNT);
+
+    printf("\nClient options:\n");
+    printf(
+        "  -target:<hostname>          The remote hostname or IP address to connect to.\n"
+        "  -ip:<0/4/6>                 A hint for the resolving the hostname to an IP address. (def:0)\n"
+        "  -remote:<addr>              A remote IP address to connect to.\n"
+        "  -bind:<addr>                A local IP address to bind to.\n"
+        "  -mode:<tput/rps/hps>        The benchmark mode to run. (def:tput)\n"
+        "  -connections:<####>         The number of connections to use. (def:%u)\n"
+        "  -streams:<####>             The number of parallel requests per connection. (def:%u)\n"
+        "  -request:<####>             The payload bytes to upload per request. (def:0)\n"
+        "  -response:<####>            The bytes to download per request. (tput def:%u, others:0)\n"
+        "  -duration:<####>            The run duration in seconds for rps/hps modes. (def:%u)\n"
+        "  -pktprofile:<0/1>           Report average receive cycles per packet by stage. (def:0)\n",
+        PERF_DEFAULT_CONNECTION_COUNT,
+        PERF_DEFAULT_STREAM_COUNT,
+        PERF_DEFAULT_TPUT_RESPONSE_SIZE,
+        PERF_DEFAULT_DURATION);
+
+    printf("\nCommon options:\n");
+    printf(
+        "  -alpn:<str>                 The ALPN to use. (def:%s)\n"
+        "  -port:<####>                The UDP port of the server. (def:%u)\n"
+        "  -idle:<####>                Idle timeout for connections. (def:%u ms)\n",
+        PERF_DEFAULT_ALPN,
+        PERF_DEFAULT_PORT,
+        PERF_DEFAULT_IDLE_TIMEOUT);
+
+    printf("\nExamples:\n");
+    printf("  quicperf.exe -listen:*\n");
+    printf("  quicperf.exe -target:localhost -mode:tput -response:1000000000\n");
+    printf("  quicperf.exe -target:localhost -mode:rps -connections:8 -streams:100 -response:4096\n");
+    printf("  quicperf.exe -target:localhost -mode:hps -connections:16 -duration:30\n");
+}
+
+#if _WIN32
+
+void
+PerfCpuSnapshot(
+    _Out_ PERF_CPU_STATE* State
+    )
+{
+    FILETIME IdleTime, KernelTime, UserTime;
+    State->Valid = GetSystemTimes(&IdleTime, &KernelTime, &UserTime) != 0;
+    State->IdleTime = ((uint64_t)IdleTime.dwHighDateTime << 32) | IdleTime.dwLowDateTime;
+    State->KernelTime = ((uint64_t)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime;
+    State->UserTime = ((uint64_t)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime;
+}
+
+void
+PerfCpuPrintUsage(
+    _In_ const PERF_CPU_STATE* Start,
+    _In_ const PERF_CPU_STATE* End
+    )
+{
+    if (!Start->Valid || !End->Valid) {
+        return;
+    }
+
+    //
+    // Only aggregate usage is available here. KernelTime includes IdleTime.
+    //
+    uint64_t Total =
+        (End->KernelTime - Start->KernelTime) +
+        (End->UserTime - Start->UserTime);
+    uint64_t Idle = End->IdleTime - Start->IdleTime;
+    if (Total == 0) {
+        return;
+    }
+
+    printf("CPU usage (all cores): %u.%u%%\n",
+        (uint32_t)(((Total - Idle) * 100) / Total),
+        (uint32_t)((((Total - Idle) * 1000) / Total) % 10));
+}
+
+#else // _WIN32
+
+void
+PerfCpuSnapshot(
+    _Out_ PERF_CPU_STATE* State
+    )
+{
+    State->Valid = false;
+    State->CoreCount = 0;
+
+    FILE* File = fopen("/proc/stat", "r");
+    if (File == nullptr) {
+        return;
+    }
+
+    char Line[512];
+    while (State->CoreCount < ARRAYSIZE(State->Cores) &&
+        fgets(Line, sizeof(Line), File) != nullptr) {
+
+        unsigned int Core;
+        unsigned long long User, Nice, System, Idle, IoWait, Irq, SoftIrq, Steal;
+        if (sscanf(
+                Line,
+                "cpu%u %llu %llu %llu %llu %llu %llu %llu %llu",
+                &Core, &User, &Nice, &System, &Idle, &IoWait, &Irq, &SoftIrq,
+                &Steal) != 9) {
+            continue; // Skips the aggregate "cpu" line and non-cpu lines.
+        }
+
+        uint64_t Busy = User + Nice + System + Irq + SoftIrq + Steal;
+        State->Cores[State->CoreCount].Busy = Busy;
+        State->Cores[State->CoreCount].Total = Busy + Idle + IoWait;
+        State->CoreCount++;
+    }
+
+    fclose(File);
+    State->Valid = State->CoreCount != 0;
+}
+
+void
+PerfCpuPrintUsage(
+    _In_ const PERF_CPU_STATE* Start,
+    _In_ const PERF_CPU_STATE* End
+    )
+{
+    if (!Start->Valid || !End->Valid || Start->CoreCount != End->CoreCount) {
+        return;
+    }
+
+    uint64_t TotalBusy = 0, TotalTime = 0;
+    printf("CPU usage:");
+    for (uint32_t i = 0; i < End->CoreCount; i++) {
+        uint64_t Busy = End->Cores[i].Busy - Start->Cores[i].Busy;
+        uint64_t Total = End->Cores[i].Total - Start->Cores[i].Total;
+        TotalBusy += Busy;
+        TotalTime += Total;
+        if (Total != 0) {
+            printf(" core[%u]=%u.%u%%",
+                i,
+                (uint32_t)((Busy * 100) / Total),
+                (uint32_t)(((Busy * 1000) / Total) % 10));
+        }
+    }
+    if (TotalTime != 0) {
+        printf(" all=%u.%u%%",
+            (uint32_t)((TotalBusy * 100) / TotalTime),
+            (uint32_t)(((TotalBusy * 1000) / TotalTime) % 10));
+    }
+    printf("\n");
+}
+
+#endif // _WIN32
+
+void
+ParseCommonCommands(
+    _In_ int argc,
+    _In_reads_(argc) _Null_terminated_ char* argv[]
+    )
+{
+    const char* alpn = PERF_DEFAULT_ALPN;
+    TryGetValue(argc, argv, "alpn", &alpn);
+    PerfConfig.ALPN.Buffer = (uint8_t*)alpn;
+    PerfConfig.ALPN.Length = (uint32_t)strlen(alpn);
+
+    uint16_t port = PERF_DEFAULT_PORT;
+    TryGetValue(argc, argv, "port", &port);
+    if (PerfConfig.ServerMode) {
+        QuicAddrSetPort(&PerfConfig.LocalIpAddr, port);
+    } else {
+        QuicAddrSetPort(&PerfConfig.Client.RemoteIpAddr, port);
+    }
+
+    uint64_t idleTimeout = PERF_DEFAULT_IDLE_TIMEOUT;
+    TryGetValue(argc, argv, "idle", &idleTimeout);
+    PerfConfig.IdleTimeout = idleTimeout;
+
+    PerfPayloadBuffer = new uint8_t[PERF_IO_SIZE];
+    memset(PerfPayloadBuffer, 'P', PERF_IO_SIZE);
+}
+
+void
+ParseServerCommand(
+    _In_ int argc,
+    _In_reads_(argc) _Null_terminated_ char* argv[]
+    )
+{
+    PerfConfig.ServerMode = true;
+
+    const char* localAddress;
+    TryGetValue(argc, argv, "listen", &localAddress);
+    if (!ConvertArgToAddress(localAddress, 0, &PerfConfig.LocalIpAddr)) {
+        printf("Failed to decode IP address: '%s'!\nMust be *, a IPv4 or a IPv6 address.\n", localAddress);
+        return;
+    }
+
+    uint16_t peerBidiStreams = PERF_DEFAULT_PEER_BIDI_STREAM_COUNT;
+    TryGetValue(argc, argv, "peer_bidi", &peerBidiStreams);
+    PerfConfig.PeerBidirStreamCount = peerBidiStreams;
+
+#if _WIN32
+    const char* certThumbprint;
+    if (!TryGetValue(argc, argv, "thumbprint", &certThumbprint)) {
+        printf("Must specify -thumbprint: for server mode.\n");
+        return;
+    }
+    const char* certStoreName;
+    if (!TryGetValue(argc, argv, "cert_store", &certStoreName)) {
+        SecurityConfig = GetSecConfigForThumbprint(MsQuic, Registration, certThumbprint);
+        if (SecurityConfig == nullptr) {
+            printf("Failed to create security configuration for thumbprint:'%s'.\n", certThumbprint);
+            return;
+        }
+    } else {
+        uint32_t machineCert = 0;
+        TryGetValue(argc, argv, "machine_cert", &machineCert);
+        QUIC_CERTIFICATE_HASH_STORE_FLAGS flags =
+            machineCert ? QUIC_CERTIFICATE_HASH_STORE_FLAG_MACHINE_STORE : QUIC_CERTIFICATE_HASH_STORE_FLAG_NONE;
+
+        SecurityConfig = GetSecConfigForThumbprintAndStore(MsQuic, Registration, flags, certThumbprint, certStoreName);
+        if (SecurityConfig == nullptr) {
+            printf(
+                "Failed to create security configuration for thumbprint:'%s' and store: '%s'.\n",
+                certThumbprint,
+                certStoreName);
+            return;
+        }
+    }
+#else
+    // TODO - Support getting sec config on Linux.
+    printf("Loading sec config on Linux unsupported right now.\n");
+    return;
+#endif
+
+    ParseCommonCommands(argc, argv);
+    QuicPerfServerRun();
+
+    MsQuic->SecConfigDelete(SecurityConfig);
+}
+
+void
+ParseClientCommand(
+    _In_ int argc,
+    _In_reads_(argc) _Null_terminated_ char* argv[]
+    )
+{
+    PerfConfig.ServerMode = false;
+
+    TryGetValue(argc, argv, "target", &PerfConfig.Client.Target);
+
+    uint16_t ip;
+    if (TryGetValue(argc, argv, "ip", &ip)) {
+        switch (ip) {
+        case 4: PerfConfig.Client.RemoteIpAddr.si_family = AF_INET; break;
+        case 6: PerfConfig.Client.RemoteIpAddr.si_family = AF_INET6; break;
+        }
+    }
+
+    const char* remoteAddress;
+    if (TryGetValue(argc, argv, "remote", &remoteAddress)) {
+        PerfConfig.Client.UseExplicitRemoteAddr = true;
+        if (!ConvertArgToAddress(remoteAddress, 0, &PerfConfig.Client.RemoteIpAddr)) {
+            printf("Failed to decode IP address: '%s'!\nMust be *, a IPv4 or a IPv6 address.\n", remoteAddress);
+            return;
+        }
+    }
+
+    const char* localAddress;
+    if (TryGetValue(argc, argv, "bind", &localAddress)) {
+        if (!ConvertArgToAddress(localAddress, 0, &PerfConfig.LocalIpAddr)) {
+            printf("Failed to decode IP address: '%s'!\nMust be *, a IPv4 or a IPv6 address.\n", localAddress);
+            return;
+        }
+    }
+
+    PerfConfig.Client.Mode = PerfModeThroughput;
+    const char* mode;
+    if (TryGetValue(argc, argv, "mode", &mode)) {
+        if (strcmp(mode, "tput") == 0) {
+            PerfConfig.Client.Mode = PerfModeThroughput;
+        } else if (strcmp(mode, "rps") == 0) {
+            PerfConfig.Client.Mode = PerfModeRps;
+        } else if (strcmp(mode, "hps") == 0) {
+            PerfConfig.Client.Mode = PerfModeHps;
+        } else {
+            printf("Invalid mode: '%s'!\nMust be tput, rps or hps.\n", mode);
+            return;
+        }
+    }
+
+    uint32_t connections = PERF_DEFAULT_CONNECTION_COUNT;
+    TryGetValue(argc, argv, "connections", &connections);
+    PerfConfig.Client.ConnectionCount = connections;
+
+    uint32_t streams = PERF_DEFAULT_STREAM_COUNT;
+    TryGetValue(argc, argv, "streams", &streams);
+    PerfConfig.Client.StreamCount = streams;
+
+    uint64_t requestSize = 0;
+    TryGetValue(argc, argv, "request", &requestSize);
+    PerfConfig.Client.RequestSize = requestSize;
+
+    uint64_t responseSize =
+        PerfConfig.Client.Mode == PerfModeThroughput ?
+            PERF_DEFAULT_TPUT_RESPONSE_SIZE : 0;
+    TryGetValue(argc, argv, "response", &responseSize);
+    PerfConfig.Client.ResponseSize = responseSize;
+
+    uint32_t duration = PERF_DEFAULT_DURATION;
+    TryGetValue(argc, argv, "duration", &duration);
+    if (duration == 0) {
+        duration = PERF_DEFAULT_DURATION;
+    }
+    PerfConfig.Client.Duration = duration;
+
+    uint32_t pktProfile = 0;
+    TryGetValue(argc, argv, "pktprofile", &pktProfile);
+    PerfConfig.Client.PacketProfile = pktProfile != 0;
+
+    ParseCommonCommands(argc, argv);
+    QuicPerfClientRun();
+}
+
+int
+QUIC_MAIN_EXPORT
+main(
+    _In_ int argc,
+    _In_reads_(argc) _Null_terminated_ char* argv[]
+    )
+{
+    int ErrorCode = -1;
+    QUIC_REGISTRATION_CONFIG RegConfig = { "quicperf", QUIC_EXECUTION_PROFILE_TYPE_MAX_THROUGHPUT };
+
+    QuicPlatformSystemLoad();
+    QuicPlatformInitialize();
+
+    if (argc < 2) {
+        PrintUsage();
+        goto Error;
+    }
+
+    if (QUIC_FAILED(MsQuicOpen(&MsQuic))) {
+        printf("MsQuicOpen failed!\n");
+        goto Error;
+    }
+
+    if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
+        printf("RegistrationOpen failed!\n");
+        MsQuicClose(MsQuic);
+        goto Error;
+    }
+
+    //
+    // Parse input to see if we are a client or server.
+    //
+    if (GetValue(argc, argv, "listen")) {
+        ParseServerCommand(argc, argv);
+    } else if (GetValue(argc, argv, "target")) {
+        ParseClientCommand(argc, argv);
+    } else {
+        printf("Invalid usage!\n\n");
+        PrintUsage();
+    }
+
+    ErrorCode = 0;
+    delete [] PerfPayloadBuffer;
+    MsQuic->RegistrationClose(Registration);
+    MsQuicClose(MsQuic);
+
+Error:
+
+    QuicPlatformUninitialize();
+    QuicPlatformSystemUnload();
+
+    return ErrorCode;
+}
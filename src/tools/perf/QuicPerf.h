@@ -0,0 +1,189 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    QUIC performance benchmark tool declarations.
+
+--*/
+
+#pragma once
+
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <msquichelper.h>
+#include <msquicp.h>
+
+//
+// QUIC API Function Table.
+//
+extern const QUIC_API_TABLE* MsQuic;
+
+//
+// Registration context.
+//
+extern HQUIC Registration;
+
+//
+// Security configuration for server.
+//
+extern QUIC_SEC_CONFIG* SecurityConfig;
+
+//
+// The protocol name used for QuicPerf.
+//
+#define PERF_DEFAULT_ALPN "perf"
+
+//
+// The default port used for connecting with QuicPerf.
+//
+#define PERF_DEFAULT_PORT 4433
+
+//
+// The default client connection and parallel stream counts.
+//
+#define PERF_DEFAULT_CONNECTION_COUNT 1
+#define PERF_DEFAULT_STREAM_COUNT 1
+
+//
+// The default run duration (in seconds) for the rate based (RPS/HPS) modes.
+//
+#define PERF_DEFAULT_DURATION 10
+
+//
+// The default response size for the throughput mode.
+//
+#define PERF_DEFAULT_TPUT_RESPONSE_SIZE 0x6400000 // 100 MB
+
+//
+// The idle timeout (in milliseconds) used.
+//
+#define PERF_DEFAULT_IDLE_TIMEOUT (10 * 1000)
+
+//
+// The maximum amount of time (in milliseconds) the client will wait for the
+// throughput mode run to complete.
+//
+#define PERF_DEFAULT_WAIT_TIMEOUT (60 * 60 * 1000)
+
+//
+// The size of a single send IO and the number kept outstanding per stream.
+//
+#define PERF_IO_SIZE 0x10000
+#define PERF_MAX_OUTSTANDING_IO 8
+
+//
+// Every request stream starts with a header holding the (little endian)
+// length of the response the peer should send back.
+//
+#define PERF_REQUEST_HEADER_SIZE sizeof(uint64_t)
+
+//
+// The maximum number of latency measurements recorded in RPS mode. Requests
+// beyond this simply aren't sampled.
+//
+#define PERF_MAX_LATENCY_SAMPLES (1 << 20)
+
+//
+// The default number of streams the server allows the peer to open.
+//
+#define PERF_DEFAULT_PEER_BIDI_STREAM_COUNT 16384
+
+enum PerfMode {
+    PerfModeThroughput, // Bulk data transfer rate.
+    PerfModeRps,        // Requests per second, with latency percentiles.
+    PerfModeHps         // Handshakes (connections) per second.
+};
+
+typedef struct QUIC_PERF_CONFIG {
+
+    bool ServerMode : 1;
+
+    QUIC_BUFFER ALPN;
+    QUIC_ADDR LocalIpAddr;
+
+    uint64_t IdleTimeout;           // Milliseconds
+    uint16_t PeerBidirStreamCount;  // Max simultaneous (server)
+
+    struct {
+        PerfMode Mode;
+        const char* Target;         // SNI
+        QUIC_ADDR RemoteIpAddr;
+        bool UseExplicitRemoteAddr : 1;
+        uint32_t ConnectionCount;
+        uint32_t StreamCount;       // Parallel requests per connection.
+        uint64_t RequestSize;       // Payload bytes sent past the header.
+        uint64_t ResponseSize;      // Bytes requested from the server.
+        uint32_t Duration;          // Seconds (RPS/HPS modes).
+        bool PacketProfile : 1;     // Report receive cost per packet stage.
+    } Client;
+
+} QUIC_PERF_CONFIG;
+
+extern QUIC_PERF_CONFIG PerfConfig;
+
+//
+// Shared buffer of junk bytes used as the payload for every send.
+//
+extern uint8_t* PerfPayloadBuffer;
+
+//
+// A snapshot of per-core CPU usage, for attributing processing cost to the
+// benchmark run.
+//
+typedef struct PERF_CPU_STATE {
+    bool Valid;
+#if _WIN32
+    //
+    // Only aggregate times are available via GetSystemTimes.
+    //
+    uint64_t IdleTime;
+    uint64_t KernelTime;
+    uint64_t UserTime;
+#else
+    uint32_t CoreCount;
+    struct {
+        uint64_t Busy;
+        uint64_t Total;
+    } Cores[256];
+#endif
+} PERF_CPU_STATE;
+
+//
+// Captures the current (system wide) CPU usage counters.
+//
+void
+PerfCpuSnapshot(
+    _Out_ PERF_CPU_STATE* State
+    );
+
+//
+// Prints the per-core CPU usage between the two snapshots.
+//
+void
+PerfCpuPrintUsage(
+    _In_ const PERF_CPU_STATE* Start,
+    _In_ const PERF_CPU_STATE* End
+    );
+
+struct QuicSession
+{
+    HQUIC Handle;
+    QuicSession() : Handle(nullptr) {}
+    ~QuicSession() { if (Handle != nullptr) { MsQuic->SessionClose(Handle); } }
+    void Cancel() {
+        MsQuic->SessionShutdown(Handle, QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT, 0);
+    }
+};
+
+//
+// Starts the server at the local address and waits until a key is pressed.
+//
+void QuicPerfServerRun();
+
+//
+// Runs the configured client benchmark mode against the remote host.
+//
+void QuicPerfClientRun();
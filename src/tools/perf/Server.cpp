@@ -0,0 +1,337 @@
+/*++
+
+    Copyright (c) Microsoft Corporation.
+    Licensed under the MIT License.
+
+Abstract:
+
+    QUIC performance benchmark server implementation. Accepts every incoming
+    connection and stream, drains the request payload, and sends back the
+    number of bytes indicated by the request header.
+
+--*/
+
+#include "QuicPerf.h"
+
+struct PerfServerStream {
+
+    HQUIC QuicStream;
+    bool Unidirectional;
+
+    //
+    // The response length header, accumulated from the front of the request
+    // (it may arrive split across receive indications).
+    //
+    uint8_t Header[PERF_REQUEST_HEADER_SIZE];
+    uint32_t HeaderLength;
+
+    //
+    // Number of response bytes left to queue and number of sends currently
+    // outstanding.
+    //
+    uint64_t SendRemaining;
+    uint32_t OutstandingSends;
+
+    //
+    // The QUIC_BUFFERs passed to StreamSend must stay valid until the send
+    // completes, so each outstanding send owns one of these slots. A slot
+    // with a zero Length is free.
+    //
+    QUIC_BUFFER SendBuffers[PERF_MAX_OUTSTANDING_IO];
+
+    PerfServerStream(
+        _In_ HQUIC Stream,
+        _In_ bool Unidirectional
+        ) : QuicStream(Stream), Unidirectional(Unidirectional),
+            HeaderLength(0), SendRemaining(0), OutstandingSends(0) {
+        memset(SendBuffers, 0, sizeof(SendBuffers));
+        MsQuic->SetCallbackHandler(Stream, (void*)QuicCallbackHandler, this);
+    }
+
+    ~PerfServerStream() {
+        MsQuic->StreamClose(QuicStream);
+    }
+
+    void
+    OnReceive(
+        _In_ const QUIC_STREAM_EVENT* Event
+        ) {
+        //
+        // Everything past the header is just drained.
+        //
+        for (uint32_t i = 0;
+            HeaderLength < PERF_REQUEST_HEADER_SIZE &&
+                i < Event->RECEIVE.BufferCount;
+            ++i) {
+            uint32_t Copy = Event->RECEIVE.Buffers[i].Length;
+            if (Copy > PERF_REQUEST_HEADER_SIZE - HeaderLength) {
+                Copy = PERF_REQUEST_HEADER_SIZE - HeaderLength;
+            }
+            memcpy(
+                Header + HeaderLength,
+                Event->RECEIVE.Buffers[i].Buffer,
+                Copy);
+            HeaderLength += Copy;
+        }
+    }
+
+    void
+    StartResponse() {
+        if (Unidirectional) {
+            //
+            // Nothing to send back on; just clean up.
+            //
+            MsQuic->StreamShutdown(
+                QuicStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, 0);
+            return;
+        }
+
+        uint64_t ResponseSize = 0;
+        if (HeaderLength == PERF_REQUEST_HEADER_SIZE) {
+            for (uint32_t i = 0; i < PERF_REQUEST_HEADER_SIZE; ++i) {
+                ResponseSize |= (uint64_t)Header[i] << (i * 8);
+            }
+        }
+
+        SendRemaining = ResponseSize;
+        if (SendRemaining == 0) {
+            MsQuic->StreamShutdown(
+                QuicStream, QUIC_STREAM_SHUTDOWN_FLAG_GRACEFUL, 0);
+        } else {
+            QueueSends();
+        }
+    }
+
+    void
+    QueueSends() {
+        //
+        // All sends reference the same shared payload buffer, so a free slot
+        // is any SendBuffers entry with a zero Length.
+        //
+        while (SendRemaining != 0 && OutstandingSends < PERF_MAX_OUTSTANDING_IO) {
+            QUIC_BUFFER* Buffer = SendBuffers;
+            while (Buffer->Length != 0) {
+                ++Buffer;
+            }
+            Buffer->Buffer = PerfPayloadBuffer;
+            Buffer->Length =
+                SendRemaining < PERF_IO_SIZE ?
+                    (uint32_t)SendRemaining : PERF_IO_SIZE;
+            SendRemaining -= Buffer->Length;
+
+            QUIC_SEND_FLAGS Flags =
+                SendRemaining == 0 ? QUIC_SEND_FLAG_FIN : QUIC_SEND_FLAG_NONE;
+
+            OutstandingSends++;
+            if (QUIC_FAILED(
+                MsQuic->StreamSend(QuicStream, Buffer, 1, Flags, Buffer))) {
+                Buffer->Length = 0;
+                OutstandingSends--;
+                MsQuic->StreamShutdown(
+                    QuicStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+                break;
+            }
+        }
+    }
+
+    void
+    ProcessEvent(
+        _Inout_ QUIC_STREAM_EVENT* Event
+        ) {
+        switch (Event->Type) {
+        case QUIC_STREAM_EVENT_RECEIVE:
+            OnReceive(Event);
+            break;
+        case QUIC_STREAM_EVENT_SEND_COMPLETE:
+            ((QUIC_BUFFER*)Event->SEND_COMPLETE.ClientContext)->Length = 0;
+            OutstandingSends--;
+            QueueSends();
+            break;
+        case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
+            StartResponse();
+            break;
+        case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
+        case QUIC_STREAM_EVENT_PEER_RECEIVE_ABORTED:
+            MsQuic->StreamShutdown(
+                QuicStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+            break;
+        case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+            delete this;
+            break;
+        default:
+            break;
+        }
+    }
+
+    static
+    QUIC_STATUS
+    QUIC_API
+    QuicCallbackHandler(
+        _In_ HQUIC /* Stream */,
+        _In_opt_ void* Context,
+        _Inout_ QUIC_STREAM_EVENT* Event
+        ) {
+        PerfServerStream *pThis = (PerfServerStream*)Context;
+        pThis->ProcessEvent(Event);
+        return QUIC_STATUS_SUCCESS;
+    }
+};
+
+struct PerfServerConnection {
+
+    HQUIC QuicConnection;
+
+    PerfServerConnection(
+        _In_ HQUIC Connection
+        ) : QuicConnection(Connection) {
+        MsQuic->SetCallbackHandler(Connection, (void*)QuicCallbackHandler, this);
+    }
+
+    ~PerfServerConnection() {
+        MsQuic->ConnectionClose(QuicConnection);
+    }
+
+    void
+    ProcessEvent(
+        _Inout_ QUIC_CONNECTION_EVENT* Event
+        ) {
+        switch (Event->Type) {
+        case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
+            new PerfServerStream(
+                Event->PEER_STREAM_STARTED.Stream,
+                (Event->PEER_STREAM_STARTED.Flags & QUIC_STREAM_OPEN_FLAG_UNIDIRECTIONAL) != 0);
+            break;
+        case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+            delete this;
+            break;
+        default:
+            break;
+        }
+    }
+
+    static
+    QUIC_STATUS
+    QUIC_API
+    QuicCallbackHandler(
+        _In_ HQUIC /* Connection */,
+        _In_opt_ void* Context,
+        _Inout_ QUIC_CONNECTION_EVENT* Event
+        ) {
+        PerfServerConnection *pThis = (PerfServerConnection*)Context;
+        pThis->ProcessEvent(Event);
+        return QUIC_STATUS_SUCCESS;
+    }
+};
+
+struct PerfServer {
+
+    HQUIC QuicListener;
+
+    PerfServer() : QuicListener(nullptr) { }
+
+    ~PerfServer() {
+        if (QuicListener) {
+            MsQuic->ListenerClose(QuicListener);
+        }
+    }
+
+    bool Start(HQUIC Session) {
+        if (QUIC_FAILED(
+            MsQuic->ListenerOpen(
+                Session,
+                QuicCallbackHandler,
+                this,
+                &QuicListener))) {
+            printf("MsQuic->ListenerOpen failed!\n");
+            return false;
+        }
+        if (QUIC_FAILED(
+            MsQuic->ListenerStart(
+                QuicListener,
+                &PerfConfig.LocalIpAddr))) {
+            printf("MsQuic->ListenerStart failed!\n");
+            return false;
+        }
+        return true;
+    }
+
+    void
+    ProcessEvent(
+        _Inout_ QUIC_LISTENER_EVENT* Event
+        ) {
+        switch (Event->Type) {
+        case QUIC_LISTENER_EVENT_NEW_CONNECTION:
+            Event->NEW_CONNECTION.SecurityConfig = SecurityConfig;
+            new PerfServerConnection(Event->NEW_CONNECTION.Connection);
+            break;
+        }
+    }
+
+    static
+    QUIC_STATUS
+    QUIC_API
+    QuicCallbackHandler(
+        _In_ HQUIC /* Listener */,
+        _In_opt_ void* Context,
+        _In_ QUIC_LISTENER_EVENT* Event
+        ) {
+        PerfServer *pThis = (PerfServer*)Context;
+        pThis->ProcessEvent(Event);
+        return QUIC_STATUS_SUCCESS;
+    }
+};
+
+void QuicPerfServerRun()
+{
+    QuicSession Session;
+    if (QUIC_FAILED(
+        MsQuic->SessionOpen(
+            Registration,
+            &PerfConfig.ALPN,
+            1,
+            NULL,
+            &Session.Handle))) {
+        printf("MsQuic->SessionOpen failed!\n");
+        return;
+    }
+    if (QUIC_FAILED(
+        MsQuic->SetParam(
+            Session.Handle,
+            QUIC_PARAM_LEVEL_SESSION,
+            QUIC_PARAM_SESSION_PEER_BIDI_STREAM_COUNT,
+            sizeof(uint16_t),
+            &PerfConfig.PeerBidirStreamCount))) {
+        printf("MsQuic->SetParam (SESSION_PEER_BIDI_STREAM_COUNT) failed!\n");
+        return;
+    }
+    if (QUIC_FAILED(
+        MsQuic->SetParam(
+            Session.Handle,
+            QUIC_PARAM_LEVEL_SESSION,
+            QUIC_PARAM_SESSION_IDLE_TIMEOUT,
+            sizeof(uint64_t),
+            &PerfConfig.IdleTimeout))) {
+        printf("MsQuic->SetParam (SESSION_IDLE_TIMEOUT) failed!\n");
+        return;
+    }
+
+    {
+        PerfServer Server;
+        if (!Server.Start(Session.Handle)) {
+            printf("Failed to start the listener!\n");
+            return;
+        }
+
+        PERF_CPU_STATE CpuStart;
+        PerfCpuSnapshot(&CpuStart);
+
+        printf("Press Enter to exit.\n\n");
+        getchar();
+
+        PERF_CPU_STATE CpuEnd;
+        PerfCpuSnapshot(&CpuEnd);
+        PerfCpuPrintUsage(&CpuStart, &CpuEnd);
+    }
+
+    Session.Cancel();
+}
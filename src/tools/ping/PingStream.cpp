@@ -66,7 +66,12 @@ PingStream::PingStream(
     ) :
     Connection(connection), QuicStream(nullptr),
     Mode(mode), Aborted(false),
-    BytesSent(0), BytesCompleted(0), BytesReceived(0) {
+    BytesSent(0), BytesCompleted(0), BytesReceived(0),
+    EchoSamples(nullptr), EchoSampleCapacity(0), EchoSampleHead(0),
+    EchoSampleCount(0), Latency(nullptr), WarmupEndTime(0) {
+    if (Mode == BidiSendMode) {
+        Latency = new LatencyHistogram();
+    }
 }
 
 //
@@ -79,7 +84,9 @@ PingStream::PingStream(
     ) :
     Connection(connection), QuicStream(stream),
     Mode(mode), Aborted(false),
-    BytesSent(0), BytesCompleted(0), BytesReceived(0) {
+    BytesSent(0), BytesCompleted(0), BytesReceived(0),
+    EchoSamples(nullptr), EchoSampleCapacity(0), EchoSampleHead(0),
+    EchoSampleCount(0), Latency(nullptr), WarmupEndTime(0) {
     StartTime = QuicTimeUs64();
     MsQuic->SetCallbackHandler(QuicStream, (void*)QuicCallbackHandler, this);
 
@@ -90,12 +97,15 @@ PingStream::~PingStream() {
     if (QuicStream) {
         MsQuic->StreamClose(QuicStream);
     }
+    delete [] EchoSamples;
+    delete Latency;
 }
 
 bool
 PingStream::Start(
     ) {
     StartTime = QuicTimeUs64();
+    WarmupEndTime = StartTime + MS_TO_US((uint64_t)PingConfig.Client.WarmupMs);
     QUIC_STREAM_OPEN_FLAGS OpenFlags = QUIC_STREAM_OPEN_FLAG_NONE;
     if (Mode == UniSendMode) {
         OpenFlags = QUIC_STREAM_OPEN_FLAG_UNIDIRECTIONAL;
@@ -114,7 +124,7 @@ PingStream::QueueSendRequest(
     PingSendRequest* SendRequest
     )
 {
-    return
+    bool Success =
         QUIC_SUCCEEDED(
         MsQuic->StreamSend(
             QuicStream,
@@ -122,6 +132,54 @@ PingStream::QueueSendRequest(
             1,
             SendRequest->Flags,
             SendRequest));
+    if (Success && Mode == BidiSendMode) {
+        TrackEchoSend();
+    }
+    return Success;
+}
+
+//
+// Records the end offset and timestamp of a just-queued send so the echo
+// latency can be measured when the peer's echo catches up to that offset.
+//
+void
+PingStream::TrackEchoSend(
+    ) {
+    if (EchoSampleCount == EchoSampleCapacity) {
+        uint32_t NewCapacity = EchoSampleCapacity == 0 ? 256 : EchoSampleCapacity * 2;
+        auto NewSamples = new EchoSample[NewCapacity];
+        for (uint32_t i = 0; i < EchoSampleCount; i++) {
+            NewSamples[i] = EchoSamples[(EchoSampleHead + i) % EchoSampleCapacity];
+        }
+        delete [] EchoSamples;
+        EchoSamples = NewSamples;
+        EchoSampleCapacity = NewCapacity;
+        EchoSampleHead = 0;
+    }
+    EchoSample* Sample =
+        &EchoSamples[(EchoSampleHead + EchoSampleCount) % EchoSampleCapacity];
+    Sample->EndOffset = BytesSent;
+    Sample->SendTime = QuicTimeUs64();
+    EchoSampleCount++;
+}
+
+//
+// Completes any recorded sends that the echoed bytes have now fully covered,
+// adding their round-trip times to the histogram. Samples that complete
+// during the warmup period are discarded.
+//
+void
+PingStream::TrackEchoReceive(
+    ) {
+    uint64_t Now = QuicTimeUs64();
+    while (EchoSampleCount != 0 &&
+           EchoSamples[EchoSampleHead].EndOffset <= BytesReceived) {
+        if (Now >= WarmupEndTime) {
+            Latency->Add(QuicTimeDiff64(EchoSamples[EchoSampleHead].SendTime, Now));
+        }
+        EchoSampleHead = (EchoSampleHead + 1) % EchoSampleCapacity;
+        EchoSampleCount--;
+    }
 }
 
 bool
@@ -154,6 +212,9 @@ PingStream::ProcessEvent(
     switch (Event->Type) {
     case QUIC_STREAM_EVENT_RECEIVE:
         BytesReceived += Event->RECEIVE.TotalBufferLength;
+        if (Mode == BidiSendMode) {
+            TrackEchoReceive();
+        }
         if (Mode == BidiEchoMode) {
             for (uint32_t i = 0; i < Event->RECEIVE.BufferCount; ++i) {
                 const QUIC_BUFFER* Buffer = &Event->RECEIVE.Buffers[i];
@@ -262,6 +323,18 @@ PingStream::ProcessEvent(
                 (uint32_t)(ElapsedMicroseconds % 1000));
         }
 
+        if (Latency != nullptr && Latency->Count != 0) {
+            printf("[%p][%llu] LatencyUs count=%llu p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu warmup=%ums\n",
+                Connection->QuicConnection, GetStreamID(MsQuic, QuicStream),
+                Latency->Count,
+                Latency->Percentile(50),
+                Latency->Percentile(90),
+                Latency->Percentile(99),
+                Latency->Percentile(99.9),
+                Latency->Max,
+                PingConfig.Client.WarmupMs);
+        }
+
         Connection->OnPingStreamShutdownComplete(this);
 
         delete this;
@@ -22,6 +22,64 @@ enum PingStreamMode {
     BidiEchoMode
 };
 
+//
+// HDR-style latency histogram. Values are bucketed into power-of-two ranges
+// subdivided into 64 linear sub-buckets, giving roughly 1.5% relative value
+// resolution with a fixed memory footprint.
+//
+struct LatencyHistogram {
+
+    static const uint32_t BucketCount = 128 + 31 * 64;
+
+    uint64_t Count;
+    uint64_t Max;
+    uint32_t Buckets[BucketCount];
+
+    LatencyHistogram() : Count(0), Max(0) {
+        memset(Buckets, 0, sizeof(Buckets));
+    }
+
+    void Add(uint64_t Value) {
+        Count++;
+        if (Value > Max) {
+            Max = Value;
+        }
+        uint32_t Shift = 0;
+        while ((Value >> Shift) >= 128) {
+            Shift++;
+        }
+        uint32_t Bucket =
+            Shift == 0 ?
+                (uint32_t)Value :
+                128 + (Shift - 1) * 64 + (uint32_t)((Value >> Shift) - 64);
+        Buckets[Bucket]++;
+    }
+
+    //
+    // Returns the upper edge of the bucket containing the given percentile
+    // (0 < Percentile <= 100).
+    //
+    uint64_t Percentile(double Percentile) const {
+        uint64_t Target = (uint64_t)((Percentile / 100) * Count + 0.5);
+        if (Target == 0) {
+            Target = 1;
+        }
+        uint64_t Cumulative = 0;
+        for (uint32_t i = 0; i < BucketCount; i++) {
+            Cumulative += Buckets[i];
+            if (Cumulative >= Target) {
+                if (i < 128) {
+                    return i;
+                }
+                uint32_t Shift = 1 + (i - 128) / 64;
+                uint64_t Base = 64 + (i - 128) % 64;
+                return ((Base + 1) << Shift) - 1;
+            }
+        }
+        return Max;
+    }
+};
+
 struct PingConnection;
 struct PingSendRequest;
 
@@ -39,6 +97,23 @@ struct PingStream {
     uint64_t BytesCompleted;
     uint64_t BytesReceived;
 
+    //
+    // Echo latency tracking (BidiSendMode only). Each successfully queued
+    // send records its end offset and timestamp; when the echoed bytes catch
+    // up to that offset, the elapsed time is added to the histogram. Samples
+    // taken before the warmup period ends are excluded.
+    //
+    struct EchoSample {
+        uint64_t EndOffset;
+        uint64_t SendTime;
+    };
+    EchoSample* EchoSamples;
+    uint32_t EchoSampleCapacity;
+    uint32_t EchoSampleHead;
+    uint32_t EchoSampleCount;
+    LatencyHistogram* Latency;
+    uint64_t WarmupEndTime;
+
     //
     // Constructor for creating a new stream.
     //
@@ -74,6 +149,12 @@ private:
         PingSendRequest* SendRequest
         );
 
+    void
+    TrackEchoSend();
+
+    void
+    TrackEchoReceive();
+
     bool
     StartSend();
 
@@ -42,7 +42,8 @@ PrintUsage()
         "  -ver:<initial version>      The initial QUIC version number to use.\n"
         "  -resume:<bytes>             Resumption bytes for 0-RTT.\n"
         "  -connections:<####>         The number of connections to create. (def:%u)\n"
-        "  -wait:<####>                The time the app waits for completion. (def:%u ms)\n",
+        "  -wait:<####>                The time the app waits for completion. (def:%u ms)\n"
+        "  -warmup:<####>              The time excluded from echo latency stats. (def:0 ms)\n",
         DEFAULT_CLIENT_CONNECTION_COUNT,
         DEFAULT_WAIT_TIMEOUT);
 
@@ -300,6 +301,10 @@ ParseClientCommand(
     TryGetValue(argc, argv, "wait", &waitTimeout);
     PingConfig.Client.WaitTimeout = waitTimeout;
 
+    uint32_t warmup = 0;
+    TryGetValue(argc, argv, "warmup", &warmup);
+    PingConfig.Client.WarmupMs = warmup;
+
     ParseCommonCommands(argc, argv);
     QuicPingClientRun();
 }
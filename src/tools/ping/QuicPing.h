@@ -132,6 +132,7 @@ typedef struct QUIC_PING_CONFIG {
         const char* ResumeToken;
         uint32_t ConnectionCount;
         uint32_t WaitTimeout;       // Milliseconds
+        uint32_t WarmupMs;          // Echo latency samples before this are excluded
     } Client;
 
 } QUIC_PING_CONFIG;
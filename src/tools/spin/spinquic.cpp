@@ -200,6 +200,8 @@ static struct {
     const char* AlpnPrefix;
     std::vector<uint16_t> Ports;
     const char* ServerName;
+    uint32_t ChurnRate;
+    uint64_t ChurnCount;
 } Settings;
 
 extern "C" void QuicTraceRundown(void) { }
@@ -359,6 +361,190 @@ void SpinQuicSetRandomConnectionParam(HQUIC Connection)
     }
 }
 
+//
+// Churn mode. Instead of fuzzing API ordering, drives a fixed
+// open/handshake/close cycle against the in-process server at a configurable
+// rate and reports handshake latency percentiles and allocations per
+// handshake. Handshakes run sequentially on a schedule derived purely from
+// the seed and rate, so a given seed always produces the same API call
+// sequence and the numbers can be used to bisect connection-setup
+// regressions.
+//
+
+struct ChurnConnection {
+    HQUIC Connection = nullptr;
+    QUIC_EVENT Connected; // Set on connected or transport shutdown.
+    QUIC_EVENT ShutdownComplete;
+    bool HandshakeSucceeded = false;
+};
+
+QUIC_STATUS QUIC_API SpinQuicChurnHandleConnectionEvent(HQUIC /* Connection */, void* Context, QUIC_CONNECTION_EVENT* Event)
+{
+    auto ctx = (ChurnConnection*)Context;
+    switch (Event->Type) {
+    case QUIC_CONNECTION_EVENT_CONNECTED:
+        ctx->HandshakeSucceeded = true;
+        QuicEventSet(ctx->Connected);
+        break;
+    case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
+        QuicEventSet(ctx->Connected); // Handshake failed; unblock the churn loop.
+        break;
+    case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+        QuicEventSet(ctx->ShutdownComplete);
+        break;
+    default:
+        break;
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
+QUIC_STATUS QUIC_API SpinQuicChurnServerHandleConnectionEvent(HQUIC Connection, void* /* Context */, QUIC_CONNECTION_EVENT* Event)
+{
+    if (Event->Type == QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE) {
+        MsQuic->ConnectionClose(Connection);
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
+QUIC_STATUS QUIC_API SpinQuicChurnServerHandleListenerEvent(HQUIC /* Listener */, void* /* Context */, QUIC_LISTENER_EVENT* Event)
+{
+    if (Event->Type == QUIC_LISTENER_EVENT_NEW_CONNECTION) {
+        Event->NEW_CONNECTION.SecurityConfig = GlobalSecurityConfig;
+        MsQuic->SetCallbackHandler(Event->NEW_CONNECTION.Connection, (void*)SpinQuicChurnServerHandleConnectionEvent, nullptr);
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
+int64_t GetTotalAllocCount()
+{
+    int64_t Count = 0;
+    uint32_t Size = sizeof(Count);
+    MsQuic->GetParam(nullptr, QUIC_PARAM_LEVEL_GLOBAL, QUIC_PARAM_GLOBAL_TOTAL_ALLOC_COUNT, &Size, &Count);
+    return Count;
+}
+
+void Churn()
+{
+    //
+    // Server setup. One listener on the first session and port is enough,
+    // since the churn loop always targets them.
+    //
+
+    auto SelfSignedCertParams = QuicPlatGetSelfSignedCert(QUIC_SELF_SIGN_CERT_USER);
+    if (!SelfSignedCertParams) {
+        exit(1);
+    }
+
+    QUIC_EVENT Event;
+    QuicEventInitialize(&Event, FALSE, FALSE);
+    EXIT_ON_FAILURE(
+        MsQuic->SecConfigCreate(
+            Registration,
+            (QUIC_SEC_CONFIG_FLAGS)SelfSignedCertParams->Flags,
+            SelfSignedCertParams->Certificate,
+            SelfSignedCertParams->Principal,
+            &Event,
+            SpinQuicGetSecConfigComplete));
+    QuicEventWaitForever(Event);
+    QuicEventUninitialize(Event);
+    if (!GlobalSecurityConfig) exit(1);
+
+    HQUIC Listener;
+    EXIT_ON_FAILURE(MsQuic->ListenerOpen(Sessions[0], SpinQuicChurnServerHandleListenerEvent, nullptr, &Listener));
+
+    QUIC_ADDR sockAddr = { 0 };
+    QuicAddrSetFamily(&sockAddr, AF_INET);
+    QuicAddrSetPort(&sockAddr, Settings.Ports[0]);
+    EXIT_ON_FAILURE(MsQuic->ListenerStart(Listener, &sockAddr));
+
+    //
+    // Run. Handshake N is started exactly N/rate seconds into the run (or as
+    // soon as handshake N-1 finished, if that is later).
+    //
+
+    std::vector<uint64_t> Latencies;
+    uint64_t Completed = 0;
+    uint64_t Failed = 0;
+    int64_t StartAllocCount = GetTotalAllocCount();
+    uint64_t ChurnStartTimeUs = QuicTimeUs64();
+
+    while (Completed + Failed < Settings.ChurnCount &&
+        QuicTimeDiff64(StartTimeMs, QuicTimeMs64()) < Settings.RunTimeMs) {
+
+        uint64_t DueTimeUs =
+            ChurnStartTimeUs +
+            ((Completed + Failed) * 1000000ull) / Settings.ChurnRate;
+        uint64_t NowUs = QuicTimeUs64();
+        if (NowUs < DueTimeUs) {
+            QuicSleep((uint32_t)US_TO_MS(DueTimeUs - NowUs) + 1);
+        }
+
+        ChurnConnection Conn;
+        QuicEventInitialize(&Conn.Connected, FALSE, FALSE);
+        QuicEventInitialize(&Conn.ShutdownComplete, FALSE, FALSE);
+
+        uint64_t HandshakeStartTimeUs = QuicTimeUs64();
+        QUIC_STATUS Status = MsQuic->ConnectionOpen(Sessions[0], SpinQuicChurnHandleConnectionEvent, &Conn, &Conn.Connection);
+        if (QUIC_SUCCEEDED(Status)) {
+            Status = MsQuic->ConnectionStart(Conn.Connection, AF_INET, Settings.ServerName, Settings.Ports[0]);
+        }
+
+        if (QUIC_SUCCEEDED(Status)) {
+            QuicEventWaitForever(Conn.Connected); // The watchdog catches hangs.
+            if (Conn.HandshakeSucceeded) {
+                Latencies.push_back(QuicTimeDiff64(HandshakeStartTimeUs, QuicTimeUs64()));
+                Completed++;
+            } else {
+                Failed++;
+            }
+            MsQuic->ConnectionShutdown(Conn.Connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            QuicEventWaitForever(Conn.ShutdownComplete);
+        } else {
+            Failed++;
+        }
+
+        if (Conn.Connection != nullptr) {
+            MsQuic->ConnectionClose(Conn.Connection);
+        }
+        QuicEventUninitialize(Conn.Connected);
+        QuicEventUninitialize(Conn.ShutdownComplete);
+    }
+
+    uint64_t ElapsedUs = QuicTimeDiff64(ChurnStartTimeUs, QuicTimeUs64());
+    int64_t AllocCount = GetTotalAllocCount() - StartAllocCount;
+
+    //
+    // Clean up.
+    //
+
+    MsQuic->ListenerClose(Listener);
+    MsQuic->SecConfigDelete(GlobalSecurityConfig);
+    QuicPlatFreeSelfSignedCert(SelfSignedCertParams);
+
+    //
+    // Report. The allocation count covers both sides of the handshake, since
+    // the server runs in-process.
+    //
+
+    printf("Churn: %llu handshakes (%llu failed) in %llu ms (%.1f HPS)\n",
+        (unsigned long long)Completed,
+        (unsigned long long)Failed,
+        (unsigned long long)US_TO_MS(ElapsedUs),
+        ElapsedUs == 0 ? 0.0 : ((Completed + Failed) * 1000000.0) / ElapsedUs);
+    if (!Latencies.empty()) {
+        std::sort(Latencies.begin(), Latencies.end());
+        printf("Handshake latency (us): p50=%llu p90=%llu p99=%llu max=%llu\n",
+            (unsigned long long)Latencies[(Latencies.size() - 1) * 50 / 100],
+            (unsigned long long)Latencies[(Latencies.size() - 1) * 90 / 100],
+            (unsigned long long)Latencies[(Latencies.size() - 1) * 99 / 100],
+            (unsigned long long)Latencies.back());
+    }
+    if (Completed + Failed > 0) {
+        printf("Allocations per handshake: %llu\n",
+            (unsigned long long)(AllocCount / (int64_t)(Completed + Failed)));
+    }
+}
+
 void Spin(LockableVector<HQUIC>& Connections, bool IsServer)
 {
     uint64_t OpCount = 0;
@@ -616,11 +802,13 @@ QUIC_THREAD_CALLBACK(ClientSpin, Context)
 
 void PrintHelpText(void)
 {
-    printf("Usage: spinquic.exe [client/server/both] [options]\n" \
+    printf("Usage: spinquic.exe [client/server/both/churn] [options]\n" \
           "\n" \
           "  -alpn:<alpn>         default: 'spin'\n" \
+          "  -count:<count>       default: UINT64_MAX (churn mode: handshakes to drive)\n" \
           "  -dstport:<port>      default: 9999\n" \
           "  -max_ops:<count>     default: UINT64_MAX\n"
+          "  -rate:<hps>          default: 100 (churn mode: handshakes per second)\n" \
           "  -seed:<seed>         default: 6\n" \
           "  -sessions:<count>    default: 4\n" \
           "  -target:<ip>         default: '127.0.0.1'\n" \
@@ -639,6 +827,7 @@ main(int argc, char **argv)
 
     bool RunServer = false;
     bool RunClient = false;
+    bool RunChurn = false;
 
     if (strcmp(argv[1], "server") == 0) {
         RunServer = true;
@@ -647,8 +836,10 @@ main(int argc, char **argv)
     } else if (strcmp(argv[1], "both") == 0) {
         RunServer = true;
         RunClient = true;
+    } else if (strcmp(argv[1], "churn") == 0) {
+        RunChurn = true;
     } else {
-        printf("Must specify one of the following as the first argument: 'server' 'client' 'both'\n\n");
+        printf("Must specify one of the following as the first argument: 'server' 'client' 'both' 'churn'\n\n");
         PrintHelpText();
     }
 
@@ -662,10 +853,23 @@ main(int argc, char **argv)
     Settings.Ports = std::vector<uint16_t>({9998, 9999});
     Settings.AlpnPrefix = "spin";
     Settings.MaxOperationCount = UINT64_MAX;
+    Settings.ChurnRate = 100;
+    Settings.ChurnCount = UINT64_MAX;
 
     TryGetValue(argc, argv, "timeout", &Settings.RunTimeMs);
     TryGetValue(argc, argv, "max_ops", &Settings.MaxOperationCount);
 
+    if (RunChurn) {
+        TryGetValue(argc, argv, "rate", &Settings.ChurnRate);
+        TryGetValue(argc, argv, "count", &Settings.ChurnCount);
+        TryGetValue(argc, argv, "alpn", &Settings.AlpnPrefix);
+        TryGetValue(argc, argv, "sessions", &SessionCount);
+        if (Settings.ChurnRate == 0) {
+            printf("Churn rate must be greater than zero.\n\n");
+            PrintHelpText();
+        }
+    }
+
     if (RunClient) {
         uint16_t dstPort = 0;
         if (TryGetValue(argc, argv, "dstport", &dstPort)) {
@@ -719,6 +923,10 @@ main(int argc, char **argv)
 
     StartTimeMs = QuicTimeMs64();
 
+    if (RunChurn) {
+        Churn();
+    }
+
     //
     // Start worker threads
     //